@@ -43,6 +43,9 @@ AC_DEFUN([CYGNAL_PATHS],
 
 AC_CHECK_HEADERS(poll.h sys/epoll.h)
 
+dnl eventfd lets the queues wake up a sleeping thread without a mutex
+AC_CHECK_HEADERS(sys/eventfd.h)
+
 dnl AC_CHECK_HEADERS(sys/sendfile)
 AC_TRY_COMPILE([#include <sys/sendfile.h>], [
     sendfile(0, 0, 0, 0); ],
@@ -64,8 +64,10 @@ CRcInitFile::CRcInitFile()
       _testing(false),
       _threading(false),
       _fdthread(100),
+      _shards(0),
       _netdebug(false),
       _admin(false),
+      _metrics(true),
       _certfile("server.pem"),
       _certdir("/etc/pki/tls")
 {
@@ -215,6 +217,7 @@ CRcInitFile::parseFile(const std::string& filespec)
             bool threads;
 	    bool netdebug;
 	    bool admin;
+	    bool metrics;
             uint32_t num;
 
             // Get the standard options inherited froom Gnash's config file
@@ -228,6 +231,8 @@ CRcInitFile::parseFile(const std::string& filespec)
             // Get the options specific to Cygnal's config file.
             else if ( extractSetting(admin, "admin", variable, value) )
                 setAdminFlag(admin);
+            else if ( extractSetting(metrics, "metrics", variable, value) )
+                setMetricsFlag(metrics);
             else if ( extractSetting(netdebug, "netdebug", variable, value) )
                 setNetDebugFlag(netdebug);
             else if ( extractSetting(test, "testing", variable, value) )
@@ -236,6 +241,8 @@ CRcInitFile::parseFile(const std::string& filespec)
                 setThreadingFlag(threads);
 	    else if (extractNumber(num, "fdThread", variable, value) )
 		setFDThread(num);
+	    else if (extractNumber(num, "shards", variable, value) )
+		setShards(num);
             else if (extractNumber(num, "portOffset", variable, value) )
 		setPortOffset(num);
 
@@ -271,8 +278,11 @@ CRcInitFile::dump(std::ostream& os) const
     os << "\tPort Offset: " << _port_offset << endl;
     os << "\tThreading support: "
          << ((_threading)?"enabled":"disabled") << endl;
+    os << "\tShards: " << _shards << endl;
     os << "\tSpecial Testing output for Gnash: "
          << ((_testing)?"enabled":"disabled") << endl;
+    os << "\tLive metrics: "
+         << ((_metrics)?"enabled":"disabled") << endl;
 
 //    RcInitFile::dump();
 }
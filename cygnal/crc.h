@@ -73,6 +73,11 @@ public:
     /// \brief Set the number of file descriptors per thread.
     void setFDThread(int x) { _fdthread = x; };
 
+    /// \brief Get the number of shards to run, 0 if sharding is disabled.
+    size_t getShards() const { return _shards; };
+    /// \brief Set the number of shards to run.
+    void setShards(size_t x) { _shards = x; };
+
     /// \brief Get the special testing output option.
     bool getTestingFlag() { return _testing; };
     /// \brief Set the special testing output option.
@@ -93,6 +98,11 @@ public:
     /// \brief Set the  flag for whether to enable the administration thread.
     void setAdminFlag(bool x) { _admin = x; }
 
+    /// \brief Get the flag for whether to serve the live counters.
+    bool getMetricsFlag() const { return _metrics; }
+    /// \brief Set the flag for whether to serve the live counters.
+    void setMetricsFlag(bool x) { _metrics = x; }
+
     void setDocumentRoot(const std::string &x) { _wwwroot = x; }
     std::string getDocumentRoot() { return _wwwroot; }
     
@@ -166,6 +176,14 @@ public:
     ///		also disabled, as all the file descriptors are watched
     ///		by one one thread as an aid to debugging.
     size_t _fdthread;
+
+    /// \var _shards
+    ///		The number of shards to run. Each shard listens on the
+    ///		same ports, and owns all the connections it accepts, so
+    ///		they don't share any state except by explicit messages.
+    ///		This is 0 when sharding is disabled, which is the
+    ///		default.
+    size_t _shards;
     
     /// \var _netdebug
     ///	Toggles very verbose debugging info from the network Network
@@ -177,6 +195,11 @@ public:
     ///		not, also to reduce complecity when debugging.
     bool _admin;
 
+    /// \var _metrics
+    ///		This toggles whether the live counters are served as
+    ///		/metrics to clients on the same host.
+    bool _metrics;
+
     /// \var _certfile
     ///		This is the name of the server certificate file
     std::string _certfile;
@@ -66,6 +66,8 @@ extern "C"{
 #include "limits.h"
 #include "netstats.h"
 #include "statistics.h"
+#include "metrics.h"
+#include "shard.h"
 //#include "stream.h"
 #include "gmemory.h"
 #include "diskstream.h"
@@ -109,6 +111,8 @@ static void hup_handler(int sig);
 void connection_handler(Network::thread_params_t *args);
 void event_handler(Network::thread_params_t *args);
 void admin_handler(Network::thread_params_t *args);
+void shard_handler(Shard *shard, std::string hostname);
+void shard_handshake(Shard *shard, int fd, short port);
 
 // Toggles very verbose debugging info from the network Network class
 static bool netdebug = false;
@@ -198,6 +202,7 @@ usage()
 	<< _("  -a,  --admin         Enable the administration thread") << endl
 	<< _("  -r,  --root          Document root for all files") << endl
 	<< _("  -m,  --machine       Hostname for this machine") << endl
+	<< _("  -S,  --shards        Number of shards sharing each port") << endl
 	<< endl;
 }
 
@@ -428,7 +433,8 @@ main(int argc, char *argv[])
             { 'r', "root",          Arg_parser::yes },
             { 'o', "only-port",     Arg_parser::yes },
             { 's', "singlethreaded", Arg_parser::no },
-            { 'm', "machine",       Arg_parser::yes }
+            { 'm', "machine",       Arg_parser::yes },
+            { 'S', "shards",        Arg_parser::yes }
         };
     
     Arg_parser parser(argc, argv, opts);
@@ -502,6 +508,9 @@ main(int argc, char *argv[])
 	  case 'm':
 	      hostname = parser.argument(i);
 	      break;
+	  case 'S':
+	      crcfile.setShards(parser.argument<int>(i));
+	      break;
 	  default:
 	      log_error(_("Extraneous argument: %s"), parser.argument(i).c_str());
         }
@@ -532,9 +541,11 @@ main(int argc, char *argv[])
     // at port 1111 and dump statistics to the terminal for tuning
     // purposes.
     if (admin) {
-	Network::thread_params_t admin_data;
+	// The thread outlives this block.
+	static Network::thread_params_t admin_data;
 	admin_data.port = gnash::ADMIN_PORT;
 	std::thread admin_thread(std::bind(&admin_handler, &admin_data));
+	admin_thread.detach();
     }
 
 //    Cvm cvm;
@@ -549,6 +560,20 @@ main(int argc, char *argv[])
 	crcfile.setThreadingFlag(false);
     }
 
+    // In sharded mode every shard listens on all the ports, so it
+    // replaces the connection handlers below.
+    if (crcfile.getShards() > 0) {
+	Shard::create(crcfile.getShards());
+	for (size_t i = 0; i < Shard::count(); i++) {
+	    std::thread shard_thread(std::bind(&shard_handler, Shard::get(i),
+					       hostname));
+	    shard_thread.detach();
+	}
+	alldone.wait(lk);
+	log_network(_("Cygnal done..."));
+	return(0);
+    }
+
     // Incomming connection handler for port 80, HTTP and
     // RTMPT. As port 80 requires root access, cygnal supports a
     // "port offset" for debugging and development of the
@@ -565,6 +590,7 @@ main(int argc, char *argv[])
         http_data->hostname = hostname;
 	if (crcfile.getThreadingFlag()) {
 	    std::thread http_thread(std::bind(&connection_handler, http_data));
+	    http_thread.detach();
 	} else {
 	    connection_handler(http_data);
 	}
@@ -583,6 +609,7 @@ main(int argc, char *argv[])
         rtmp_data->hostname = hostname;
 	if (crcfile.getThreadingFlag()) {
 	    std::thread rtmp_thread(std::bind(&connection_handler, rtmp_data));
+	    rtmp_thread.detach();
 	} else {
 	    connection_handler(rtmp_data);
 	}
@@ -696,6 +723,9 @@ admin_handler(Network::thread_params_t *args)
 		      results.clear();
 		  }
 #endif
+		  if (crcfile.getMetricsFlag()) {
+		      net.writeNet(Metrics::getDefaultInstance().format());
+		  }
 #if 0
 		  response << handlers.size() << " handlers are currently active.";
  		  for (hit = handlers.begin(); hit != handlers.end(); hit++) {
@@ -759,6 +789,38 @@ admin_handler(Network::thread_params_t *args)
 // connection, it reads the first packet to get the resource name, and
 // then starts the event handler thread if it's a newly requested
 // resource, otherwise it loads a copy of the cached resource.
+// Set up the Handler for a new RTMP application, and load the plugin
+// for it.
+//
+// @return false if there isn't a plugin for the application.
+static bool
+init_rtmp_handler(Handler &hand, const URL &url, RTMPServer *rtmp)
+{
+    hand.setNetConnection(rtmp->getNetConnection());
+    std::vector<std::shared_ptr<Cygnal::peer_t> >::iterator it;
+    std::vector<std::shared_ptr<Cygnal::peer_t> > active = cyg.getActive();
+    for (it = active.begin(); it < active.end(); ++it) {
+	Cygnal::peer_t *peer = (*it).get();
+	hand.addRemote(peer->fd);
+    }
+
+    string cgiroot;
+    char *env = std::getenv("CYGNAL_PLUGINS");
+    if (env != 0) {
+	cgiroot = env;
+    }
+    if (crcfile.getCgiRoot().size() > 0) {
+	cgiroot += ":" + crcfile.getCgiRoot();
+	log_network(_("Cygnal Plugin paths are: %s"), cgiroot);
+    } else {
+	cgiroot = PLUGINSDIR;
+    }
+    hand.scanDir(cgiroot);
+    std::shared_ptr<Handler::cygnal_init_t> init = hand.initModule(url.path());
+
+    return init.get() != 0;
+}
+
 void
 connection_handler(Network::thread_params_t *args)
 {
@@ -833,6 +895,7 @@ connection_handler(Network::thread_params_t *args)
 	    log_network(_("*** New %s network connection for thread ID #%d, fd #%d ***"),
 			proto_str[args->protocol], tid, args->netfd);
 	}
+	Metrics::getDefaultInstance().setProtocol(args->netfd, args->protocol);
 
 	//
 	// Setup HTTP handler
@@ -889,6 +952,7 @@ connection_handler(Network::thread_params_t *args)
 		std::bind(event_handler, hargs);
 		if (crcfile.getThreadingFlag() == true) {
 		    std::thread event_thread(std::bind(&event_handler, hargs));
+		    event_thread.detach();
 		} else {
 		    event_handler(hargs);
 		    // We're done, close this network connection
@@ -925,40 +989,19 @@ connection_handler(Network::thread_params_t *args)
 		hand.reset(new Handler);
 		cyg.addHandler(key, hand);
 		rargs->entry = rtmp;
-		hand->setNetConnection(rtmp->getNetConnection());
-		std::vector<std::shared_ptr<Cygnal::peer_t> >::iterator it;
-		std::vector<std::shared_ptr<Cygnal::peer_t> > active = cyg.getActive();
-		for (it = active.begin(); it < active.end(); ++it) {
-		    Cygnal::peer_t *peer = (*it).get();
-		    hand->addRemote(peer->fd);
-		}
 		hand->addClient(args->netfd, Network::RTMP);
 		rargs->handler = reinterpret_cast<void *>(hand.get());
 		args->filespec = key;
 		args->entry = rtmp;
 		
-		string cgiroot;
-		char *env = std::getenv("CYGNAL_PLUGINS");
-		if (env != 0) {
-		    cgiroot = env;
-		}
-		if (crcfile.getCgiRoot().size() > 0) {
-		    cgiroot += ":" + crcfile.getCgiRoot();
-		    log_network(_("Cygnal Plugin paths are: %s"), cgiroot);
-		} else {
-		    cgiroot = PLUGINSDIR;
-		}
-		hand->scanDir(cgiroot);
-		std::shared_ptr<Handler::cygnal_init_t> init =
-		    hand->initModule(url.path());
-		
 		// this is where the real work gets done.
-		if (init) {
+		if (init_rtmp_handler(*hand, url, rtmp)) {
 		    // If in multi-threaded mode (the default), start a thread
 		    // with a connection_handler for each port we're interested
 		    // in. Each port of course has a different protocol.
 		    if (crcfile.getThreadingFlag() == true) {
 			std::thread event_thread(std::bind(&event_handler, args));
+			event_thread.detach();
 		    } else {
 			event_handler(args);
 			// We're done, close this network connection
@@ -988,6 +1031,37 @@ connection_handler(Network::thread_params_t *args)
     
 } // end of connection_handler
 
+// Send the next chunk of the file being streamed to a client, if there
+// is one.
+//
+// @return false if the connection should be closed.
+static bool
+play_stream(Handler *hand, int fd)
+{
+    std::shared_ptr<DiskStream> ds = hand->getDiskStream(fd);
+    if (!ds || (ds->getState() != DiskStream::PLAY)) {
+	return true;
+    }
+    //ds->dump();
+    // Only play the next chunk of the file.
+//log_network("Sending following chunk of %s", ds->getFilespec());
+    if (!ds->play(fd, false)) {
+	// something went wrong, the stream failed
+	return false;
+    }
+    if (ds->getState() == DiskStream::CLOSED) {
+	// A persistent connection goes on to any requests
+	// that were pipelined behind this one.
+	if (hand->getProtocol(fd) == Network::HTTP) {
+	    std::shared_ptr<HTTPServer> &http = hand->getHTTPHandler(fd);
+	    return http->keepAlive() && http->processRequests(hand, fd);
+	}
+	return false;
+    }
+
+    return true;
+}
+
 void
 event_handler(Network::thread_params_t *args)
 {
@@ -1014,6 +1088,14 @@ event_handler(Network::thread_params_t *args)
     FD_SET(args->netfd, &hits);
 
     tids.increment();
+
+    // Report this thread's CPU time and lag, and give the slot back
+    // however the loop ends.
+    Metrics &metrics = Metrics::getDefaultInstance();
+    struct ThreadSlot {
+	~ThreadSlot() { Metrics::getDefaultInstance().removeThread(id); }
+	int id;
+    } slot = { metrics.addThread("event") };
     
     // We need to calculate the highest numbered file descriptor
     // for select. We may want to do this elsewhere, as it could
@@ -1032,6 +1114,9 @@ event_handler(Network::thread_params_t *args)
     }
 
     do {
+	// Everything up to the next wait is time a client with new
+	// data would have to wait for.
+	const std::uint64_t wakeup = Metrics::now();
 	
 	// If we have active disk streams, send those packets first.
 	// 0 is a reserved stream, so we start with 1, as the reserved
@@ -1050,25 +1135,14 @@ event_handler(Network::thread_params_t *args)
 //      	cache.dump();
 #endif
 	//hand->dump();
-	std::shared_ptr<DiskStream> ds;
-	for (int i=1; i <= hand->getActiveDiskStreams(); i++) {
-	    ds = hand->getDiskStream(i);
-	    if (ds) {
-   		//ds->dump();
-		// Only play the next chunk of the file.
-//log_network("Sending following chunk of %s", ds->getFilespec());
-		if (ds->play(i, false)) {
-		    if (ds->getState() == DiskStream::CLOSED) {
-			net.closeNet(args->netfd);
-			hand->removeClient(args->netfd);
-			done = true;
-		    }
-		} else {
-		    // something went wrong, the stream failed
-		    net.closeNet(args->netfd);
-		    hand->removeClient(args->netfd);
-		    done = true;
-		}
+	// The disk streams are indexed by the client's file descriptor.
+	std::vector<int> clients = hand->getClients();
+	for (size_t i = 0; i < clients.size(); i++) {
+	    int fd = clients[i];
+	    if (!play_stream(hand, fd)) {
+		net.closeNet(fd);
+		hand->removeClient(fd);
+		done = true;
 	    }
 	}
     
@@ -1088,7 +1162,12 @@ event_handler(Network::thread_params_t *args)
 		      largs.netfd = i;
 		      // largs.filespec = fullpath;
 		      std::shared_ptr<HTTPServer> &http = hand->getHTTPHandler(i);
-		      if (!http->http_handler(hand, args->netfd, args->buffer)) {
+		      bool persistent = http->http_handler(hand, args->netfd, args->buffer);
+		      // The first request is only handled once, after that
+		      // the data is read from the network.
+		      delete args->buffer;
+		      args->buffer = 0;
+		      if (!persistent) {
 			  log_network(_("Done with HTTP connection for fd #%d, CGI %s"), i, args->filespec);
 			  net.closeNet(args->netfd);
 			  hand->removeClient(args->netfd);
@@ -1153,6 +1232,8 @@ event_handler(Network::thread_params_t *args)
 	// Wait for something from one of the file descriptors. This timeout
 	// is the time between sending packets to the client when there is
 	// no client input, which effects the streaming speed of big files.
+	metrics.loopLag(slot.id, Metrics::now() - wakeup);
+	metrics.sampleThread(slot.id);
 	net.setTimeout(5);
 	hits = net.waitForNetData(hand->getClients());
 	if (FD_ISSET(0, &hits)) {
@@ -1176,6 +1257,251 @@ event_handler(Network::thread_params_t *args)
 	
 } // end of event_handler
 
+// Each shard listens on the same ports as the others, and handles all
+// the connections it accepts itself, in one thread, so none of its
+// state needs locking. The only way to reach the clients of another
+// shard is to send it a message.
+void
+shard_handler(Shard *shard, std::string hostname)
+{
+    GNASH_REPORT_FUNCTION;
+
+    shard->enter();
+    Metrics &metrics = Metrics::getDefaultInstance();
+    int slot = metrics.addThread("shard");
+
+    // The state of one of this shard's connections.
+    struct client_t {
+	std::shared_ptr<Handler>	hand;
+	std::shared_ptr<RTMPServer>	rtmp;
+	Network::thread_params_t	args;
+    };
+    std::map<int, client_t> clients;
+
+    // Start a server on each port, sharing it with the other shards.
+    Network http_net, rtmp_net, net;
+    std::map<int, Network *> listeners;
+    if ((only_port == 0) || (only_port == gnash::HTTP_PORT)) {
+	http_net.setReusePort(true);
+	int fd = http_net.createServer(hostname, port_offset + gnash::HTTP_PORT);
+	if (fd > 0) {
+	    listeners[fd] = &http_net;
+	}
+    }
+    if ((only_port == 0) || (only_port == gnash::RTMP_PORT)) {
+	rtmp_net.setReusePort(true);
+	int fd = rtmp_net.createServer(hostname, port_offset + gnash::RTMP_PORT);
+	if (fd > 0) {
+	    listeners[fd] = &rtmp_net;
+	}
+    }
+    if (listeners.empty()) {
+	log_error(_("Shard #%d couldn't listen on any ports"), shard->getIndex());
+	metrics.removeThread(slot);
+	return;
+    }
+    log_network(_("Starting shard #%d"), shard->getIndex());
+
+    std::vector<struct pollfd> fds;
+    bool done = false;
+    do {
+	fds.clear();
+	struct pollfd pfd;
+	pfd.revents = 0;
+	pfd.events = POLLIN;
+	pfd.fd = shard->getWakeupFd();
+	fds.push_back(pfd);
+	std::map<int, Network *>::iterator lit;
+	for (lit = listeners.begin(); lit != listeners.end(); ++lit) {
+	    pfd.fd = lit->first;
+	    fds.push_back(pfd);
+	}
+	// A client with a file still to send is waiting for the
+	// socket to have room for more.
+	std::map<int, client_t>::iterator cit;
+	for (cit = clients.begin(); cit != clients.end(); ++cit) {
+	    pfd.fd = cit->first;
+	    pfd.events = POLLIN;
+	    std::shared_ptr<DiskStream> ds = cit->second.hand->getDiskStream(cit->first);
+	    if (ds && (ds->getState() == DiskStream::PLAY)) {
+		pfd.events |= POLLOUT;
+	    }
+	    fds.push_back(pfd);
+	}
+
+	int ret = poll(&fds[0], fds.size(), -1);
+	const std::uint64_t wakeup = Metrics::now();
+	if (ret < 0) {
+	    if (errno == EINTR) {
+		continue;
+	    }
+	    log_error(_("Shard #%d can't poll: %s"), shard->getIndex(),
+		      strerror(errno));
+	    done = true;
+	}
+
+	for (size_t i = 0; (ret > 0) && (i < fds.size()); i++) {
+	    const int fd = fds[i].fd;
+	    const short revents = fds[i].revents;
+	    if (revents == 0) {
+		continue;
+	    }
+
+	    // Messages from the other shards for our clients, and RTMP
+	    // connections that are done with their handshake.
+	    if (fd == shard->getWakeupFd()) {
+		Shard::message_t msg;
+		while (shard->receive(msg)) {
+		    std::shared_ptr<Handler> hand = shard->findHandler(msg.key);
+		    if (hand) {
+			rtmp_deliver(hand.get(), msg);
+		    }
+		}
+		Shard::connection_t conn;
+		while (shard->takeConnection(conn)) {
+		    // RTMP connections share the Handler for the
+		    // application, as long as they're on this shard.
+		    client_t client;
+		    client.args.tid = shard->getIndex();
+		    client.args.netfd = conn.fd;
+		    client.args.port = conn.port;
+		    client.args.buffer = 0;
+		    client.args.protocol = Network::RTMP;
+		    client.rtmp = conn.rtmp;
+		    URL url(conn.tcurl);
+		    string key = url.hostname() + url.path();
+		    client.hand = shard->findHandler(key);
+		    if (!client.hand) {
+			log_network(_("Creating new %s Handler for: %s on shard #%d"),
+				    proto_str[Network::RTMP], key, shard->getIndex());
+			client.hand.reset(new Handler);
+			if (!init_rtmp_handler(*client.hand, url, client.rtmp.get())) {
+			    log_error(_("Couldn't load plugin for %s"), key);
+			    net.closeNet(conn.fd);
+			    continue;
+			}
+			shard->addHandler(key, client.hand);
+		    }
+		    client.hand->addClient(conn.fd, Network::RTMP);
+		    client.args.filespec = key;
+		    client.args.entry = client.rtmp.get();
+		    client.args.handler = client.hand.get();
+		    metrics.setProtocol(conn.fd, client.args.protocol);
+		    log_network(_("*** New %s network connection for shard #%d, fd #%d ***"),
+				proto_str[client.args.protocol], shard->getIndex(), conn.fd);
+		    clients[conn.fd] = client;
+		}
+		continue;
+	    }
+
+	    // A new connection.
+	    lit = listeners.find(fd);
+	    if (lit != listeners.end()) {
+		if (netdebug) {
+		    lit->second->toggleDebug(true);
+		}
+		int newfd = lit->second->newConnection(true, fd);
+		if (newfd <= 0) {
+		    continue;
+		}
+		if (lit->second != &http_net) {
+		    // The handshake waits for the client to send it, so
+		    // it's done in a thread of its own, which hands the
+		    // connection back to us when it's done.
+		    std::thread handshake_thread(std::bind(&shard_handshake,
+				shard, newfd, lit->second->getPort()));
+		    handshake_thread.detach();
+		    continue;
+		}
+		// Every HTTP connection has a Handler of its own.
+		client_t client;
+		client.args.tid = shard->getIndex();
+		client.args.netfd = newfd;
+		client.args.port = lit->second->getPort();
+		client.args.buffer = 0;
+		client.args.entry = 0;
+		client.args.protocol = Network::HTTP;
+		client.hand.reset(new Handler);
+		client.hand->addClient(newfd, Network::HTTP);
+		client.args.handler = client.hand.get();
+		metrics.setProtocol(newfd, client.args.protocol);
+		log_network(_("*** New %s network connection for shard #%d, fd #%d ***"),
+			    proto_str[client.args.protocol], shard->getIndex(), newfd);
+		clients[newfd] = client;
+		continue;
+	    }
+
+	    // Data from, or room to send more to, one of our clients.
+	    cit = clients.find(fd);
+	    if (cit == clients.end()) {
+		continue;
+	    }
+	    client_t &client = cit->second;
+	    Handler *hand = client.hand.get();
+	    bool keep = true;
+	    if (revents & POLLOUT) {
+		keep = play_stream(hand, fd);
+	    }
+	    if (keep && (revents & (POLLIN | POLLHUP | POLLERR))) {
+		if (client.args.protocol == Network::HTTP) {
+		    keep = hand->getHTTPHandler(fd)->http_handler(hand, fd, 0);
+		} else if (!rtmp_handler(&client.args)) {
+		    // The RTMP handler has already closed it.
+		    hand->removeClient(fd);
+		    if (hand->getClients().empty()) {
+			shard->removeHandler(client.args.filespec);
+		    }
+		    clients.erase(cit);
+		    continue;
+		}
+	    }
+	    if (!keep) {
+		log_network(_("Done with %s connection for fd #%d"),
+			    proto_str[client.args.protocol], fd);
+		net.closeNet(fd);
+		hand->removeClient(fd);
+		if ((client.args.protocol == Network::RTMP)
+		    && hand->getClients().empty()) {
+		    shard->removeHandler(client.args.filespec);
+		}
+		clients.erase(cit);
+	    }
+	}
+
+	metrics.loopLag(slot, Metrics::now() - wakeup);
+	metrics.sampleThread(slot);
+    } while (!done);
+
+    metrics.removeThread(slot);
+
+    // All threads should wake up now.
+    alldone.notify_all();
+
+} // end of shard_handler
+
+// The RTMP handshake of a connection accepted by a shard. This runs in
+// a thread of its own, as it waits for the client, and would stall all
+// the shard's other connections if the shard did it.
+void
+shard_handshake(Shard *shard, int fd, short port)
+{
+    GNASH_REPORT_FUNCTION;
+
+    Shard::connection_t conn;
+    conn.fd = fd;
+    conn.port = port;
+    conn.rtmp.reset(new RTMPServer);
+    std::shared_ptr<cygnal::Element> tcurl =
+	conn.rtmp->processClientHandShake(fd);
+    if (!tcurl) {
+	Network net;
+	net.closeNet(fd);
+	return;
+    }
+    conn.tcurl = tcurl->to_string();
+    shard->handOff(conn);
+} // end of shard_handshake
+
 // local Variables:
 // mode: C++
 // indent-tabs-mode: nil
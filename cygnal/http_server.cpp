@@ -54,6 +54,8 @@
 #include "http_server.h"
 #include "proc.h"
 #include "cache.h"
+#include "metrics.h"
+#include "shard.h"
 
 // Not POSIX, so best not rely on it if possible.
 #ifndef PATH_MAX
@@ -70,7 +72,6 @@ namespace cygnal
 
 // The rcfile is loaded and parsed here:
 static CRcInitFile& crcfile = CRcInitFile::getDefaultInstance();
-static Cache& cache = Cache::getDefaultInstance();
 // static Proc& cgis = Proc::getDefaultInstance();
 
 HTTPServer::HTTPServer() 
@@ -142,7 +143,7 @@ HTTPServer::processClientRequest(Handler *hand, int fd, cygnal::Buffer *buf)
     string url = _docroot + _filespec;
     
     // See if the file is in the cache and already opened.
-    std::shared_ptr<DiskStream> filestream(cache.findFile(_filespec));
+    std::shared_ptr<DiskStream> filestream(Shard::cache().findFile(_filespec));
     if (filestream) {
 	log_debug("FIXME: found filestream %s in cache!", _filespec);
 	filestream->dump();
@@ -184,16 +185,13 @@ HTTPServer::processGetRequest(Handler *hand, int fd, cygnal::Buffer *buf)
     
 //    cerr << "YYYYYYY: " << (char *)buf->reference() << endl;
 //    cerr << hexify(buf->reference(), buf->allocated(), false) << endl;
-    
-    if (buf == nullptr) {
-     //	log_debug("Queue empty, net connection dropped for fd #%d", getFileFd());
-	log_debug("Queue empty, net connection dropped for fd #%d", fd);
-//	cygnal::Buffer buf;
-	return _buf;
+
+    // Pipelined requests have already been through the parser, so
+    // there's only a header to process for the first one.
+    if (buf) {
+	clearHeader();
+	processHeaderFields(buf);
     }
-    
-    clearHeader();
-    processHeaderFields(buf);
 
     _docroot = crcfile.getDocumentRoot();
     
@@ -203,7 +201,8 @@ HTTPServer::processGetRequest(Handler *hand, int fd, cygnal::Buffer *buf)
     if (ds) {
 	_diskstream = ds;
     }
-    if (!_diskstream) {
+    // A persistent connection may ask for a different file each time.
+    if (!_diskstream || (_diskstream->getFilespec() != url)) {
 	_diskstream.reset(new DiskStream);
 	log_network(_("New filestream %s"), _filespec);
     } else {
@@ -211,17 +210,56 @@ HTTPServer::processGetRequest(Handler *hand, int fd, cygnal::Buffer *buf)
     }
     
     // Oopen the file and read the first chunk into memory
-    if (_diskstream->open(url)) {
-	formatErrorResponse(HTTPServer::NOT_FOUND);
-    } else {
-	// Get the file size for the HTTPServer header
-	if (_diskstream->getFileType() == DiskStream::FILETYPE_NONE) {
-	    formatErrorResponse(HTTPServer::NOT_FOUND);
-	} else {
-	    // cache.addPath(_filespec, filestream->getFilespec());
-	    // cache.addFile(_filespec, filestream);
-	}
+    if (!_diskstream->open(url)
+	|| (_diskstream->getFileType() == DiskStream::FILETYPE_NONE)) {
+	_diskstream.reset();
+	hand->setDiskStream(fd, _diskstream);
+	cygnal::Buffer &reply = formatErrorResponse(HTTPServer::NOT_FOUND);
+	writeNet(fd, reply);
+	return reply;
+    }
+
+    size_t filesize = _diskstream->getFileSize();
+    size_t length = filesize;
+    http_status_e code = HTTPServer::OK;
+
+    // A Range is only used from a parsed request, and lets a player
+    // seek in a progressive download without starting over.
+    size_t first = 0;
+    size_t last = 0;
+    HTTPParser::token_t range;
+    if (_parser.getStatus() == HTTPParser::COMPLETE) {
+	range = _parser.getField("range");
+    }
+    switch (HTTPParser::parseRange(range, filesize, first, last)) {
+      case HTTPParser::RANGE_OK:
+	  code = HTTPServer::PARTIAL_CONTENT;
+	  length = last - first + 1;
+	  setRange(first, last, filesize);
+	  break;
+      case HTTPParser::RANGE_UNSATISFIABLE:
+      {
+	  setRange(0, 0, filesize);
+	  _diskstream->close();
+	  _diskstream.reset();
+	  hand->setDiskStream(fd, _diskstream);
+	  cygnal::Buffer &reply = formatHeader(DiskStream::FILETYPE_NONE, 0,
+					 HTTPServer::REQUESTED_RANGE_NOT_SATISFIABLE);
+	  writeNet(fd, reply);
+	  return reply;
+      }
+      case HTTPParser::RANGE_NONE:
+      default:
+	  // Video is sent a page at a time as the player wants it, so
+	  // send it as chunks to the clients that understand them.
+	  if ((_diskstream->getFileType() == DiskStream::FILETYPE_FLV)
+	      && ((_version.major > 1)
+		  || ((_version.major == 1) && (_version.minor >= 1)))) {
+	      setChunked(true);
+	  }
+	  break;
     }
+
     // Closing the file closes the disk file, but leaves data resident
     // in memory for future access to this file. If we've been opened,
     // the next operation is to start writing the file next time
@@ -230,17 +268,19 @@ HTTPServer::processGetRequest(Handler *hand, int fd, cygnal::Buffer *buf)
 	_diskstream->close();
     }
     _diskstream->setState(DiskStream::PLAY);
+    if (code == HTTPServer::PARTIAL_CONTENT) {
+	_diskstream->setRange(first, last);
+    }
+    _diskstream->setChunked(isChunked());
 // 	cache.addFile(_filespec, _diskstream);
 
     // Create the reply message
 //     _close = true; Force sending the close connection in the header
     cygnal::Buffer &reply = formatHeader(_diskstream->getFileType(),
-				      _diskstream->getFileSize(),
-				      HTTPServer::OK);
+				      length, code);
 
     writeNet(fd, reply);
 
-    size_t filesize = _diskstream->getFileSize();
     // size_t bytes_read = 0;
     // int ret;
     // size_t page = 0;
@@ -276,45 +316,63 @@ HTTPServer::processPostRequest(int fd, cygnal::Buffer * /* bufFIXME */)
 //    cerr << "QUE1 = " << _que.size() << endl;
 
     std::shared_ptr<cygnal::Buffer> buf;
+    std::shared_ptr<cygnal::Buffer> content;
+    string type;
+
+    if (_parser.getStatus() == HTTPParser::COMPLETE) {
+	// The parser has already waited for the whole body, and taken
+	// off any chunked encoding, so just join the pieces together.
+	content.reset(new cygnal::Buffer(_parser.getContentLength()));
+	for (size_t i = 0; i < _parser.getBodyParts(); i++) {
+	    HTTPParser::token_t part = _parser.getBodyPart(i);
+	    content->append(reinterpret_cast<std::uint8_t *>(const_cast<char *>(part.data)),
+			    part.size);
+	}
+	type = _parser.getField("content-type").str();
+	std::transform(type.begin(), type.end(), type.begin(), 
+		       (int(*)(int)) tolower);
+	buf = content;
+    } else {
+	if (_que.size() == 0) {
+	    return buf;
+	}
     
-    if (_que.size() == 0) {
-	return buf;
-    }
-    
-    buf = _que.pop();
-    if (buf == nullptr) {
-	log_debug("Queue empty, net connection dropped for fd #%d",
-		  getFileFd());
-	return buf;
-    }
+	buf = _que.pop();
+	if (buf == nullptr) {
+	    log_debug("Queue empty, net connection dropped for fd #%d",
+		      getFileFd());
+	    return buf;
+	}
 //    cerr << __FUNCTION__ << buf->allocated() << " : " << hexify(buf->reference(), buf->allocated(), true) << endl;
     
-    clearHeader();
-    std::uint8_t *data = processHeaderFields(buf.get());
-    size_t length = strtol(getField("content-length").c_str(), nullptr, 0);
-    std::shared_ptr<cygnal::Buffer> content(new cygnal::Buffer(length));
-    int ret = 0;
-    if (buf->allocated() - (data - buf->reference()) ) {
-//	cerr << "Don't need to read more data: have " << buf->allocated() << " bytes" << endl;
-	content->copy(data, length);
-	ret = length;
-    } else {	
-//	cerr << "Need to read more data, only have "  << buf->allocated() << " bytes" << endl;
-	ret = readNet(fd, *content, 2);
-	if (ret < 0) {
-	    log_error(_("couldn't read data!"));
-	}
-	data = content->reference();
-    }    
+	clearHeader();
+	std::uint8_t *data = processHeaderFields(buf.get());
+	size_t length = strtol(getField("content-length").c_str(), nullptr, 0);
+	content.reset(new cygnal::Buffer(length));
+	int ret = 0;
+	if (buf->allocated() - (data - buf->reference()) ) {
+//	    cerr << "Don't need to read more data: have " << buf->allocated() << " bytes" << endl;
+	    content->copy(data, length);
+	    ret = length;
+	} else {	
+//	    cerr << "Need to read more data, only have "  << buf->allocated() << " bytes" << endl;
+	    ret = readNet(fd, *content, 2);
+	    if (ret < 0) {
+		log_error(_("couldn't read data!"));
+	    }
+	    data = content->reference();
+	}    
+	type = getField("content-type");
+    }
     
-    if (getField("content-type") == "application/x-www-form-urlencoded") {
+    if (type == "application/x-www-form-urlencoded") {
 	log_debug("Got file data in POST");
 	string url = _docroot + _filespec;
 	DiskStream ds(url, *content);
 	ds.writeToDisk();
 //    ds.close();
 	// oh boy, we got ourselves some encoded AMF objects instead of a boring file.
-    } else if (getField("content-type") == "application/x-amf") {
+    } else if (type == "application/x-amf") {
 	log_debug("Got AMF data in POST");
 #if 0
 	amf::AMF amf;
@@ -327,8 +385,7 @@ HTTPServer::processPostRequest(int fd, cygnal::Buffer * /* bufFIXME */)
     // Send the reply
 
     // NOTE: this is a "special" path we trap until we have real CGI support
-    if ((getField("content-type") == "application/x-amf")
-	&& (getField("content-type") == "application/x-amf")) {
+    if (type == "application/x-amf") {
 #ifdef USE_CGIBIN
 	if (_filespec == "/echo/gateway") {
 	}
@@ -357,7 +414,8 @@ HTTPServer::processPostRequest(int fd, cygnal::Buffer * /* bufFIXME */)
  	}
 #endif
     } else {
-	cygnal::Buffer &reply = formatHeader(_filetype, _filesize, HTTPServer::OK);
+	// There's no body in the reply, whatever the size of the request.
+	cygnal::Buffer &reply = formatHeader(_filetype, 0, HTTPServer::OK);
 	writeNet(fd, reply);
     }
 
@@ -404,12 +462,24 @@ HTTPServer::processOptionsRequest(int /* fd */, cygnal::Buffer */* buf */)
     return buf;
 }
 
+// A HEAD request gets the same header as a GET request, without the file.
 std::shared_ptr<cygnal::Buffer>
-HTTPServer::processHeadRequest(int /* fd */, cygnal::Buffer */* buf */)
+HTTPServer::processHeadRequest(int fd, cygnal::Buffer */* buf */)
 {
 //    GNASH_REPORT_FUNCTION;
     std::shared_ptr<cygnal::Buffer> buf;
-    log_unimpl(_("HEAD request"));
+
+    _docroot = crcfile.getDocumentRoot();
+    string url = _docroot + _filespec;
+
+    DiskStream ds;
+    if (!ds.open(url) || (ds.getFileType() == DiskStream::FILETYPE_NONE)) {
+	formatHeader(DiskStream::FILETYPE_HTML, 0, HTTPServer::NOT_FOUND);
+    } else {
+	formatHeader(ds.getFileType(), ds.getFileSize(), HTTPServer::OK);
+	ds.close();
+    }
+    writeNet(fd, _buffer);
     
     return buf;
 }
@@ -429,34 +499,52 @@ HTTPServer::formatErrorResponse(http_status_e code)
 {
 //    GNASH_REPORT_FUNCTION;
 
+    string title, message;
+    switch (code) {
+      case BAD_REQUEST:
+	  title = "Bad Request";
+	  message = "Your browser sent a request that this server could not understand.";
+	  break;
+      case REQUEST_ENTITY_TOO_LARGE:
+	  title = "Request Entity Too Large";
+	  message = "The request header was too large for this server.";
+	  break;
+      case NOT_IMPLEMENTED:
+	  title = "Method Not Implemented";
+	  message = "The request method is not supported by this server.";
+	  break;
+      case NOT_FOUND:
+      default:
+	  title = "Not Found";
+	  message = "The requested URL " + _filespec + " was not found on this server.";
+	  break;
+    }
+
     char num[12];
-    // First build the message body, so we know how to set Content-Length
-    _buffer += "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n";
-    _buffer += "<html><head>\r\n";
-    _buffer += "<title>";
     sprintf(num, "%d", code);
-    _buffer += num;
-    _buffer += " Not Found</title>\r\n";
-    _buffer += "</head><body>\r\n";
-    _buffer += "<h1>Not Found</h1>\r\n";
-    _buffer += "<p>The requested URL ";
-    _buffer += _filespec;
-    _buffer += " was not found on this server.</p>\r\n";
-    _buffer += "<hr>\r\n";
-    _buffer += "<address>Cygnal (GNU/Linux) Server at ";
-    _buffer += getField("host");
-    _buffer += " </address>\r\n";
-    _buffer += "</body></html>\r\n";
-
-    // First build the header
-    formatDate();
-    formatServer();
-    formatContentLength(_filesize);
-    formatConnection("close");
-    formatContentType(_filetype);
 
-    // All HTTPServer messages are followed by a blank line.
-    terminateHeader();
+    // First build the message body, so we know how to set Content-Length
+    string body = "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n";
+    body += "<html><head>\r\n";
+    body += "<title>";
+    body += num;
+    body += " " + title + "</title>\r\n";
+    body += "</head><body>\r\n";
+    body += "<h1>" + title + "</h1>\r\n";
+    body += "<p>" + message + "</p>\r\n";
+    body += "<hr>\r\n";
+    body += "<address>Cygnal (GNU/Linux) Server at ";
+    if (_parser.getStatus() == HTTPParser::COMPLETE) {
+	body += _parser.getField("host").str();
+    } else {
+	body += getField("host");
+    }
+    body += " </address>\r\n";
+    body += "</body></html>\r\n";
+
+    // Then the header, and the body after it.
+    formatHeader(DiskStream::FILETYPE_HTML, body.size(), code);
+    appendBytes(_buffer, body.data(), body.size());
 
     return _buffer;
 }
@@ -1018,53 +1106,24 @@ HTTPServer::http_handler(Handler *hand, int netfd, cygnal::Buffer *buf)
 #endif
 
     if (buf) {
-	log_network(_("FIXME: Existing data in packet!"));
+	// The first request was read when the connection was accepted.
+	appendBytes(_inbuf, buf->reference(), buf->allocated());
     } else {
-	log_network(_("FIXME: No existing data in packet!"));
 	// See if we have any messages waiting
-	if (recvMsg(netfd) == 0) {
+	if ((recvMsg(netfd) == 0) && (_que.size() == 0)) {
 	    log_debug("Net HTTP server failed to read from fd #%d...", netfd);
 	    return false;
 	}
-    }
-    
-    // Process incoming messages
-    HTTP::http_method_e cmd = processClientRequest(hand, netfd, buf);    
-    if (cmd != HTTP::HTTP_GET) {
-	log_debug("No active DiskStreams for fd #%d: %s...", netfd,
-		  _filespec);
-    } else {
-	if (_diskstream) {
-	    log_debug("Found active DiskStream! for fd #%d: %s", netfd,
-		      _filespec);
-	    hand->setDiskStream(netfd, _diskstream);
- 	    cache.addFile(_filespec, _diskstream);
-// Send the first chunk of the file to the client.
-	    // log_network("Sending first chunk of %s", _filespec);
-	    _diskstream->play(netfd, false);
+	while (_que.size()) {
+	    std::shared_ptr<cygnal::Buffer> chunk = _que.pop();
+	    if (chunk) {
+		appendBytes(_inbuf, chunk->reference(), chunk->allocated());
+	    }
 	}
     }
     
-//	www->dump();
-    if ((getField("content-type") == "application/x-amf")
-	&& (getField("content-type") == "application/x-amf")
-	&& (getFilespec() == "/echo/gateway")) {
-	cerr << "GOT A GATEWAY REQUEST" << endl;
-    }
-    
-#if 0
-    string response = cache.findResponse(filestream->getFilespec());
-    if (response.empty()) {
-	cerr << "FIXME no cache hit for: " << www.getFilespec() << endl;
-//	    www.clearHeader();
-// 	    cygnal::Buffer &ss = www.formatHeader(filestream->getFileSize(), HTTP::LIFE_IS_GOOD);
-// 	    www.writeNet(args->netfd, (std::uint8_t *)www.getHeader().c_str(), www.getHeader().size());
-// 	    cache.addResponse(www.getFilespec(), www.getHeader());
-    } else {
-	cerr << "FIXME cache hit on: " << www.getFilespec() << endl;
-	www.writeNet(args->netfd, (std::uint8_t *)response.c_str(), response.size());
-    }	
-#endif
+    // Process incoming messages, which may be several pipelined requests.
+    bool persistent = processRequests(hand, netfd);
     
     // Unless the Keep-Alive flag is set, this isn't a persisant network
     // connection.
@@ -1081,9 +1140,156 @@ HTTPServer::http_handler(Handler *hand, int netfd, cygnal::Buffer *buf)
 				  ((end.tv_nsec - start.tv_nsec)/1e9))));
 #endif
     
-    return keepAlive();
+    return persistent;
     
 } // end of http_handler
+
+bool
+HTTPServer::processRequests(Handler *hand, int fd)
+{
+//    GNASH_REPORT_FUNCTION;
+
+    while (_inbuf.allocated()) {
+	// The rest of the file has to go out before the next response.
+	if (_diskstream && (_diskstream->getState() == DiskStream::PLAY)) {
+	    return true;
+	}
+
+	HTTPParser::parse_status_e status =
+	    _parser.parse(_inbuf.reference(), _inbuf.allocated());
+	if (status == HTTPParser::NEED_MORE) {
+	    return true;
+	}
+	if (status != HTTPParser::COMPLETE) {
+	    // There's no telling where the next request would start, so
+	    // answer this one and drop the connection.
+	    log_network(_("Bad HTTP request on fd #%d"), fd);
+	    _version.major = 1;
+	    _version.minor = 1;
+	    _close = true;
+	    cygnal::Buffer &reply = formatErrorResponse(
+		(status == HTTPParser::TOO_LARGE)
+		? HTTPServer::REQUEST_ENTITY_TOO_LARGE : HTTPServer::BAD_REQUEST);
+	    writeNet(fd, reply);
+	    _inbuf.setSeekPointer(_inbuf.reference());
+	    _parser.reset();
+	    return false;
+	}
+
+	processRequest(hand, fd);
+
+	// Drop this request, leaving any that were pipelined after it.
+	size_t used = _parser.getMessageSize();
+	size_t left = _inbuf.allocated() - used;
+	std::memmove(_inbuf.reference(), _inbuf.reference() + used, left);
+	_inbuf.setSeekPointer(_inbuf.reference() + left);
+	_parser.reset();
+
+	if (!keepAlive()) {
+	    // Anything after this request is ignored, but the connection
+	    // stays open until the file has been sent.
+	    _inbuf.setSeekPointer(_inbuf.reference());
+	    return (_diskstream && (_diskstream->getState() == DiskStream::PLAY));
+	}
+    }
+
+    return true;
+}
+
+// Answer a request for the live counters from a client on this host.
+// Anyone else just gets whatever the document root has for the path,
+// which is normally a 404.
+bool
+HTTPServer::processMetricsRequest(int fd)
+{
+//    GNASH_REPORT_FUNCTION;
+
+    if (!crcfile.getMetricsFlag() || (_parser.getPath().str() != "/metrics")) {
+	return false;
+    }
+
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    if (getpeername(fd, reinterpret_cast<struct sockaddr *>(&addr), &len) < 0) {
+	return false;
+    }
+    if (addr.ss_family == AF_INET) {
+	const struct sockaddr_in *sin =
+	    reinterpret_cast<const struct sockaddr_in *>(&addr);
+	if ((ntohl(sin->sin_addr.s_addr) >> 24) != 127) {
+	    return false;
+	}
+    } else if (addr.ss_family == AF_INET6) {
+	const struct sockaddr_in6 *sin6 =
+	    reinterpret_cast<const struct sockaddr_in6 *>(&addr);
+	// An IPv4 client of an IPv6 socket has a mapped address, which
+	// is on this host if the IPv4 address is in 127/8.
+	const std::uint8_t *bytes = sin6->sin6_addr.s6_addr;
+	if (!IN6_IS_ADDR_LOOPBACK(&sin6->sin6_addr)
+	    && !(IN6_IS_ADDR_V4MAPPED(&sin6->sin6_addr) && (bytes[12] == 127))) {
+	    return false;
+	}
+    } else if (addr.ss_family != AF_UNIX) {
+	return false;
+    }
+
+    string body = Metrics::getDefaultInstance().format();
+    formatHeader(DiskStream::FILETYPE_TEXT, body.size(), HTTPServer::OK);
+    appendBytes(_buffer, body.data(), body.size());
+    writeNet(fd, _buffer);
+
+    return true;
+}
+
+HTTP::http_method_e
+HTTPServer::processRequest(Handler *hand, int fd)
+{
+//    GNASH_REPORT_FUNCTION;
+
+    clearHeader();
+    setChunked(false);
+    setRange(0, 0, 0);
+    
+    _cmd = extractRequest(_parser);
+    Metrics::getDefaultInstance().httpRequest(_cmd);
+    if ((_cmd == HTTP::HTTP_GET) && processMetricsRequest(fd)) {
+	return _cmd;
+    }
+
+    switch (_cmd) {
+      case HTTP::HTTP_GET:
+	  processGetRequest(hand, fd, 0);
+	  if (_diskstream) {
+	      log_debug("Found active DiskStream! for fd #%d: %s", fd,
+			_filespec);
+	      hand->setDiskStream(fd, _diskstream);
+	      Shard::cache().addFile(_filespec, _diskstream);
+	      // Send the first chunk of the file to the client, the rest
+	      // is sent from the event loop.
+	      if (!_diskstream->play(fd, false)) {
+		  keepAlive(false);
+	      }
+	  }
+	  break;
+      case HTTP::HTTP_POST:
+	  processPostRequest(fd, 0);
+	  break;
+      case HTTP::HTTP_HEAD:
+	  processHeadRequest(fd, 0);
+	  break;
+      default:
+      {
+	  // Every request has to be answered, or the ones pipelined
+	  // after it would never be.
+	  log_unimpl(_("HTTP %s request"), _parser.getMethod().str());
+	  cygnal::Buffer &reply = formatErrorResponse(HTTPServer::NOT_IMPLEMENTED);
+	  writeNet(fd, reply);
+	  break;
+      }
+    }
+
+    return _cmd;
+}
     
 } // end of gnash namespace
 
@@ -94,12 +94,34 @@ public:
 #endif
 
     bool http_handler(Handler *hand, int netfd, cygnal::Buffer *buf);
+
+    /// \brief Answer each complete request waiting in the input buffer.
+    ///		Pipelined requests are answered in order, stopping at
+    ///		a partial request, or when a file has started streaming,
+    ///		as the rest of the file has to go out before the next
+    ///		response. Call this again once the stream is finished.
+    ///
+    /// @param hand The Handler for this connection.
+    ///
+    /// @param fd The file descriptor of the network connection.
+    ///
+    /// @return True if the connection should stay open, false if not.
+    bool processRequests(Handler *hand, int fd);
     std::shared_ptr<gnash::DiskStream> getDiskStream() { return _diskstream; };
 
     void dump();    
 private:
+    // Answer the request that _parser has just parsed.
+    http_method_e processRequest(Handler *hand, int fd);
+    // Send the live counters, if this is a local request for them.
+    bool processMetricsRequest(int fd);
+
     cygnal::Buffer _buf;
     std::shared_ptr<gnash::DiskStream> _diskstream;
+    // The data received but not yet processed, which may hold
+    // several pipelined requests, or part of one.
+    cygnal::Buffer _inbuf;
+    gnash::HTTPParser _parser;
 };
 
 } // end of gnash namespace
@@ -22,6 +22,7 @@
 
 #include <cstdint>
 #include <iostream>
+#include <algorithm>
 #include <boost/random/uniform_int.hpp>
 #include <boost/random/mersenne_twister.hpp>
 
@@ -676,6 +677,7 @@ Buffer::resize(size_t size)
     // we don't havce to copy any data.
     if (_seekptr == _data.get()) {
 	_data.reset(new std::uint8_t[size]);
+	_seekptr = _data.get();
 	_nbytes= size;
 	return *this;
     }
@@ -781,6 +783,19 @@ Buffer::corrupt(int factor)
     return errors;
 }
 
+void
+appendBytes(Buffer &buf, const void *data, size_t nbytes)
+{
+//    GNASH_REPORT_FUNCTION;
+    if (buf.spaceLeft() < nbytes) {
+	// Grow geometrically, so encoding a large message one value at
+	// a time doesn't copy the data over and over.
+	buf.resize(std::max(buf.size() * 2, buf.allocated() + nbytes));
+    }
+    std::uint8_t *ptr = const_cast<std::uint8_t *>(static_cast<const std::uint8_t *>(data));
+    buf.append(ptr, nbytes);
+}
+
 } // end of amf namespace
 
 // local Variables:
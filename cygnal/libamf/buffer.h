@@ -442,6 +442,17 @@ inline std::ostream& operator << (std::ostream& os, const Buffer& buf)
 	return os;
 }
 
+/// \brief Append raw bytes, growing the Buffer if it's full.
+///	This is what lets a gnash::amf::StreamWriter encode straight
+///	into a Buffer.
+///
+/// @param buf The Buffer to append to.
+///
+/// @param data A pointer to the raw bytes to append.
+///
+/// @param nbytes The number of bytes to append.
+DSOEXPORT void appendBytes(Buffer &buf, const void *data, size_t nbytes);
+
 } // end of namespace cygnal
 
 #endif // end of __BUFFER_H__
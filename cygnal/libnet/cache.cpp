@@ -33,6 +33,7 @@
 #include "cache.h"
 #include "log.h"
 #include "diskstream.h"
+#include "metrics.h"
 
 using std::string;
 using std::map;
@@ -106,15 +107,19 @@ Cache::findPath(const std::string &name)
 {
 //    GNASH_REPORT_FUNCTION;
     std::lock_guard<std::mutex> lock(cache_mutex);
+    map<string, string>::iterator it = _pathnames.find(name);
+    const bool hit = (it != _pathnames.end());
+    Metrics::getDefaultInstance().cacheLookup(Metrics::CACHE_PATH, hit);
 #ifdef USE_STATS_CACHE
     clock_gettime (CLOCK_REALTIME, &_last_access);
     _pathname_lookups++;
-    map<string, string>::iterator it;
-    it = _pathnames.find(name);
-    if (it != _pathnames.end()) {
+    if (hit) {
         _pathname_hits++;
     }
 #endif
+    if (hit) {
+        return it->second;
+    }
     return _pathnames[name];
 }
 
@@ -123,15 +128,19 @@ Cache::findResponse(const std::string &name)
 {
 //    GNASH_REPORT_FUNCTION;
     std::lock_guard<std::mutex> lock(cache_mutex);
+    map<string, string>::iterator it = _responses.find(name);
+    const bool hit = (it != _responses.end());
+    Metrics::getDefaultInstance().cacheLookup(Metrics::CACHE_RESPONSE, hit);
 #ifdef USE_STATS_CACHE
     clock_gettime (CLOCK_REALTIME, &_last_access);
     _response_lookups++;
-    map<string, string>::const_iterator it;
-    it = _responses.find(name);
-    if (it != _responses.end()) {
+    if (hit) {
         _response_hits++;
     }
 #endif
+    if (hit) {
+        return it->second;
+    }
     return _responses[name];
 }
 
@@ -142,15 +151,19 @@ Cache::findFile(const std::string &name)
 
     log_network(_("Trying to find %s in the cache."), name);
     std::lock_guard<std::mutex> lock(cache_mutex);
+    map<string, std::shared_ptr<DiskStream> >::iterator it = _files.find(name);
+    const bool hit = (it != _files.end());
+    Metrics::getDefaultInstance().cacheLookup(Metrics::CACHE_FILE, hit);
 #ifdef USE_STATS_CACHE
     clock_gettime (CLOCK_REALTIME, &_last_access);
     _file_lookups++;
-    map<string, std::shared_ptr<DiskStream> >::const_iterator it;
-    it = _files.find(name);
-    if (it != _files.end()) {
+    if (hit) {
         _file_hits++;
     }
 #endif
+    if (hit) {
+        return it->second;
+    }
     return _files[name];
 }
 
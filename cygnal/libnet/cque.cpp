@@ -23,6 +23,8 @@
 #include <string>
 #include <vector>
 #include <deque>
+#include <iterator>
+#include <thread>
 
 #include "cque.h"
 #include "log.h"
@@ -34,71 +36,139 @@ using std::deque;
 namespace gnash
 {
 
+// How many times push() retries a full ring before spilling
+static const int CQUE_PUSH_RETRIES = 1024;
+
 CQue::CQue()
+    : CQue("default")
 {
 //    GNASH_REPORT_FUNCTION;
+}
+
+CQue::CQue(const std::string &str, que_mode_e mode, size_t capacity)
+    : _name(str),
+      _mode(mode),
+      _spilled(false),
+      _pushing(0)
+{
+//    GNASH_REPORT_FUNCTION;
+    if (_mode == SPSC) {
+        _spsc.reset(new SPSCQueue<std::shared_ptr<cygnal::Buffer> >(capacity));
+    } else {
+        _mpmc.reset(new MPMCQueue<std::shared_ptr<cygnal::Buffer> >(capacity));
+    }
 #ifdef USE_STATS_QUEUE
     _stats.totalbytes = 0;
     _stats.totalin = 0;
     _stats.totalout = 0;
     clock_gettime (CLOCK_REALTIME, &_stats.start);
 #endif
-    _name = "default";
 }
 
 CQue::~CQue()
 {
 //    GNASH_REPORT_FUNCTION;
-//    clear();
-    que_t::iterator it;
-    std::lock_guard<std::mutex> lock(_mutex);
-//     for (it = _que.begin(); it != _que.end(); it++) {
-// 	std::shared_ptr<cygnal::Buffer> ptr = *(it);
-// 	if (ptr->size()) {	// FIXME: we probably want to delete ptr anyway,
-// 	    delete ptr;		// but if we do, this will core dump.
-// 	}
-//     }
 }
 
-// Wait for a condition variable to trigger
+// Wait for the other thread to notify us
 void
 CQue::wait()
 {
 //    GNASH_REPORT_FUNCTION;
-    std::unique_lock<std::mutex> lk(_cond_mutex);
-#ifndef _WIN32
-    _cond.wait(lk);
-    log_unimpl(_("CQue::wait(win32)"));
-#endif
+    _event.wait();
 //    log_debug("wait mutex released for \"%s\"", _name);
 }
 
-// Notify a condition variable to trigger
+// Wake up the thread waiting on this que
 void
 CQue::notify()
 {
 //    GNASH_REPORT_FUNCTION;
-#ifndef _WIN32
-    _cond.notify_one();
-    log_unimpl(_("CQue::notify(win32)"));
-#endif
+    _event.notify();
 //    log_debug("wait mutex triggered for \"%s\"", _name);
 }
 
+bool
+CQue::ringPush(std::shared_ptr<cygnal::Buffer> &data)
+{
+    // Only moved from when there was room
+    return (_spsc) ? _spsc->push(std::move(data)) : _mpmc->push(std::move(data));
+}
+
+bool
+CQue::ringPop(std::shared_ptr<cygnal::Buffer> &data)
+{
+    return (_spsc) ? _spsc->pop(data) : _mpmc->pop(data);
+}
+
+void
+CQue::spill()
+{
+//    GNASH_REPORT_FUNCTION;
+    // Stop producers from using the ring before emptying it, otherwise
+    // a new buffer could end up ahead of the ones we move. A producer
+    // that saw _spilled still clear may be about to push, so wait for
+    // it to finish first.
+    _spilled.store(true);
+    while (_pushing.load()) {
+        std::this_thread::yield();
+    }
+    que_t ring;
+    std::shared_ptr<cygnal::Buffer> buf;
+    while (ringPop(buf)) {
+        ring.push_back(std::move(buf));
+    }
+    _que.insert(_que.begin(), std::make_move_iterator(ring.begin()),
+                std::make_move_iterator(ring.end()));
+}
+
 size_t
 CQue::size()
 {
 //    GNASH_REPORT_FUNCTION;
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _que.size();
+    size_t total = (_spsc) ? _spsc->size() : _mpmc->size();
+    if (_spilled.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        total += _que.size();
+    }
+    return total;
 }
 
 bool
 CQue::push(std::shared_ptr<cygnal::Buffer> data)
 {
 //     GNASH_REPORT_FUNCTION;
+    // If the ring is only briefly full, give the consumer a chance to
+    // catch up, as once we spill everything goes through the lock
+    // until the overflow que has drained.
+    for (int tries = 0; tries < CQUE_PUSH_RETRIES; ++tries) {
+        // This pairs with spill(), which sets _spilled and then waits
+        // for _pushing to drop to zero.
+        _pushing.fetch_add(1);
+        if (_spilled.load()) {
+            _pushing.fetch_sub(1);
+            break;
+        }
+#ifdef USE_STATS_QUEUE
+        const size_t nbytes = data->size();
+#endif
+        const bool pushed = ringPush(data);
+        _pushing.fetch_sub(1);
+        if (pushed) {
+#ifdef USE_STATS_QUEUE
+            _stats.totalbytes += nbytes;
+            _stats.totalin++;
+#endif
+            return true;
+        }
+        std::this_thread::yield();
+    }
+
+    // The ring is full, or older buffers are already waiting in the
+    // overflow que, so this one has to go behind them.
     std::lock_guard<std::mutex> lock(_mutex);
     _que.push_back(data);
+    _spilled.store(true, std::memory_order_release);
 #ifdef USE_STATS_QUEUE
     _stats.totalbytes += data->size();
     _stats.totalin++;
@@ -123,13 +193,26 @@ CQue::pop()
 {
 //    GNASH_REPORT_FUNCTION;
     std::shared_ptr<cygnal::Buffer> buf;
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (_que.size()) {
-        buf = _que.front();
-        _que.pop_front();
+    if (ringPop(buf)) {
 #ifdef USE_STATS_QUEUE
 	_stats.totalout++;
 #endif
+        return buf;
+    }
+    if (_spilled.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_que.size()) {
+            buf = std::move(_que.front());
+            _que.pop_front();
+#ifdef USE_STATS_QUEUE
+            _stats.totalout++;
+#endif
+        }
+        // Once the overflow que drains, producers can go back to
+        // using the ring.
+        if (_que.empty()) {
+            _spilled.store(false, std::memory_order_release);
+        }
     }
     return buf;
 }
@@ -139,11 +222,32 @@ std::shared_ptr<cygnal::Buffer>
 CQue::peek()
 {
 //    GNASH_REPORT_FUNCTION;
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (_que.size()) {
-        return _que.front();
+    std::shared_ptr<cygnal::Buffer> buf;
+    if (_mpmc) {
+        // Another consumer could recycle the head of the ring while it
+        // is copied, so look at it in the overflow que instead. The
+        // buffers are moved there, so the only copy is the one returned,
+        // but pushes and pops take the lock until the overflow que has
+        // drained again.
+        std::lock_guard<std::mutex> lock(_mutex);
+        spill();
+        if (_que.size()) {
+            buf = _que.front();
+        } else {
+            _spilled.store(false, std::memory_order_release);
+        }
+        return buf;
+    }
+    if (_spsc->peek(buf)) {
+        return buf;
+    }
+    if (_spilled.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_que.size()) {
+            return _que.front();
+        }
     }
-    return std::shared_ptr<cygnal::Buffer>();
+    return buf;
 }
 
 // Return the size of the queues
@@ -152,7 +256,9 @@ CQue::clear()
 {
 //    GNASH_REPORT_FUNCTION;
     std::lock_guard<std::mutex> lock(_mutex);
+    spill();
     _que.clear();
+    _spilled.store(false, std::memory_order_release);
 }
 
 // Remove a range of elements
@@ -161,9 +267,10 @@ CQue::remove(std::shared_ptr<cygnal::Buffer> begin, std::shared_ptr<cygnal::Buff
 {
     GNASH_REPORT_FUNCTION;
     deque<std::shared_ptr<cygnal::Buffer> >::iterator it;
-    deque<std::shared_ptr<cygnal::Buffer> >::iterator start;
-    deque<std::shared_ptr<cygnal::Buffer> >::iterator stop;
     std::lock_guard<std::mutex> lock(_mutex);
+    spill();
+    deque<std::shared_ptr<cygnal::Buffer> >::iterator start = _que.end();
+    deque<std::shared_ptr<cygnal::Buffer> >::iterator stop = _que.end();
     std::shared_ptr<cygnal::Buffer> ptr;
     for (it = _que.begin(); it != _que.end(); ++it) {
 	ptr = *(it);
@@ -175,7 +282,12 @@ CQue::remove(std::shared_ptr<cygnal::Buffer> begin, std::shared_ptr<cygnal::Buff
 	    break;
 	}
     }
-    _que.erase(start, stop);
+    if (start != _que.end()) {
+        _que.erase(start, stop);
+    }
+    if (_que.empty()) {
+        _spilled.store(false, std::memory_order_release);
+    }
 }
 
 // Remove an element
@@ -185,6 +297,7 @@ CQue::remove(std::shared_ptr<cygnal::Buffer> element)
     GNASH_REPORT_FUNCTION;
     deque<std::shared_ptr<cygnal::Buffer> >::iterator it;
     std::lock_guard<std::mutex> lock(_mutex);
+    spill();
     for (it = _que.begin(); it != _que.end(); ) {
 	std::shared_ptr<cygnal::Buffer> ptr = *(it);
 	if (ptr->reference() == element->reference()) {
@@ -193,6 +306,21 @@ CQue::remove(std::shared_ptr<cygnal::Buffer> element)
 	    ++it;
 	}
     }
+    if (_que.empty()) {
+        _spilled.store(false, std::memory_order_release);
+    }
+}
+
+std::shared_ptr<cygnal::Buffer>
+CQue::operator[] (int index)
+{
+//    GNASH_REPORT_FUNCTION;
+    std::lock_guard<std::mutex> lock(_mutex);
+    spill();
+    if ((index < 0) || (static_cast<size_t>(index) >= _que.size())) {
+        return std::shared_ptr<cygnal::Buffer>();
+    }
+    return _que[index];
 }
 
 // Merge sucessive buffers into one single larger buffer. This is for some
@@ -202,13 +330,16 @@ CQue::merge()
 {
 //     GNASH_REPORT_FUNCTION;
     
-    return merge(_que.front());
+    return merge(peek());
 }
 
 std::shared_ptr<cygnal::Buffer>
 CQue::merge(std::shared_ptr<cygnal::Buffer> start)
 {
 //     GNASH_REPORT_FUNCTION;
+    std::lock_guard<std::mutex> lock(_mutex);
+    spill();
+
     // Find iterator to first element to merge
     que_t::iterator from = std::find(_que.begin(), _que.end(), start); 
     if (from == _que.end()) {
@@ -250,6 +381,9 @@ CQue::merge(std::shared_ptr<cygnal::Buffer> start)
 
     // Finally erase all merged elements, and replace with the composite one
     _que.erase(from, to);
+    if (_que.empty()) {
+        _spilled.store(false, std::memory_order_release);
+    }
     //que_t::iterator nextIter = _que.erase(from, to);
 //    _que.insert(nextIter, newbuf.get()); FIXME:
 
@@ -263,6 +397,7 @@ CQue::dump()
 //    GNASH_REPORT_FUNCTION;
     deque<std::shared_ptr<cygnal::Buffer> >::iterator it;
     std::lock_guard<std::mutex> lock(_mutex);
+    spill();
     std::cerr << std::endl << "CQue \"" << _name << "\" has "<< _que.size()
               << " buffers." << std::endl;
     for (it = _que.begin(); it != _que.end(); ++it) {
@@ -22,38 +22,61 @@
 #include <string>
 #include <cstdint>
 #include <mutex>
-#include <condition_variable>
+#include <atomic>
 #include <deque>
+#include <memory>
 
 #include "getclocktime.hpp"
 #include "buffer.h"
 #include "network.h"
+#include "lfqueue.h"
 #include "dsodefs.h" //For DSOEXPORT.
 
 // _definst_ is the default instance name
 namespace gnash
 {
 
+// The number of buffers that fit in the lock-free ring before pushes
+// spill over into the locked overflow queue.
+const size_t CQUE_DEFAULT_CAPACITY = 64;
+
+/// \class CQue
+///     The queue of packets passed between the network and protocol
+///     threads. Pushing and popping go through a lock-free ring buffer,
+///     and only fall back to a mutex when the ring is full, or after
+///     one of the slow operations that need random access (remove,
+///     merge, operator[], dump) has moved the contents to the overflow
+///     queue.
 class CQue {
 public:
     typedef std::deque<std::shared_ptr<cygnal::Buffer> > que_t;
+    /// Which threads may use the queue at the same time.
+    typedef enum {
+        SPSC,			// one producer and one consumer thread
+        MPMC			// any number of both
+    } que_mode_e;
 #ifdef USE_STATS_QUEUE
     typedef struct {
 	struct timespec start;
-	int		totalbytes;
-	int		totalin;
-	int		totalout;
+	// Updated by the lock-free push and pop, so these are atomic
+	std::atomic<int> totalbytes;
+	std::atomic<int> totalin;
+	std::atomic<int> totalout;
     } que_stats_t;
 #endif
     CQue();
-    CQue(const std::string &str) { _name = str; };
+    CQue(const std::string &str, que_mode_e mode = MPMC,
+	 size_t capacity = CQUE_DEFAULT_CAPACITY);
     ~CQue();
     // Push data onto the que
     bool push(std::uint8_t *data, int nbytes);
     bool push(std::shared_ptr<cygnal::Buffer> data);
     // Pop the first date element off the que
     std::shared_ptr<cygnal::Buffer> DSOEXPORT pop();
-    // Peek at the first date element witjhout removing it from the que
+    // Peek at the first date element witjhout removing it from the que.
+    // For an MPMC que this takes the lock, like the operations below,
+    // and moves the ring into the overflow que, so until that drains
+    // pushes and pops take the lock too.
     std::shared_ptr<cygnal::Buffer> DSOEXPORT peek();
     // Get the number of elements in the que
     size_t DSOEXPORT size();
@@ -63,6 +86,9 @@ public:
     void notify();
     // Empty the que of all data. 
     void clear();
+    // The remaining operations need random access, so they take the lock
+    // and move the ring into the overflow que first. For an SPSC que
+    // they may only be called from the consumer thread.
     // Remove a range of elements
     void remove(std::shared_ptr<cygnal::Buffer> begin, std::shared_ptr<cygnal::Buffer> end);
 //     // Remove an element
@@ -73,7 +99,7 @@ public:
     std::shared_ptr<cygnal::Buffer> DSOEXPORT merge(std::shared_ptr<cygnal::Buffer> begin);
     std::shared_ptr<cygnal::Buffer> DSOEXPORT merge();
 
-    std::shared_ptr<cygnal::Buffer> operator[] (int index) { return _que[index]; };
+    std::shared_ptr<cygnal::Buffer> operator[] (int index);
     
     // Dump the data to the terminal
     void dump();
@@ -82,18 +108,34 @@ public:
 #endif
     void setName(const std::string &str) { _name = str; }
     const std::string &getName() { return _name; }
+    que_mode_e getMode() const { return _mode; }
+    // Get the descriptor that becomes readable on notify(), for poll()
+    int getFileDescriptor() const { return _event.getFileDescriptor(); }
 private:
+    bool ringPush(std::shared_ptr<cygnal::Buffer> &data);
+    bool ringPop(std::shared_ptr<cygnal::Buffer> &data);
+    // Move everything in the ring to the front of the overflow queue,
+    // so it can be searched and edited. The caller must hold _mutex.
+    void spill();
+
     // an optional name for the queue, only used for debugging messages to make them unique
     std::string			_name;
-    // The queue itself
+    que_mode_e			_mode;
+    // The lock-free ring, only one of these is allocated
+    std::unique_ptr<SPSCQueue<std::shared_ptr<cygnal::Buffer> > > _spsc;
+    std::unique_ptr<MPMCQueue<std::shared_ptr<cygnal::Buffer> > > _mpmc;
+    // The overflow queue. Everything in here is newer than what is in
+    // the ring, so while it isn't empty all pushes have to go here too.
     que_t			_que;
+    std::atomic<bool>		_spilled;
+    // The number of producers between checking _spilled and pushing
+    // onto the ring. spill() waits for them, so nothing lands in the
+    // ring behind what it moved.
+    std::atomic<int>		_pushing;
 
-    // A condition variable used to signal the other thread when the que has data
-    std::condition_variable	_cond;
-    // This is the mutex used by the condition variable. It needs to be separate from the
-    // one used to lock access to the que.
-    std::mutex			_cond_mutex;
-    // This is the mutex that controls access to the que.
+    // Used to signal the other thread when the que has data
+    QueueEvent			_event;
+    // This is the mutex that controls access to the overflow que.
     std::mutex			_mutex;
 #ifdef USE_STATS_QUEUE
     que_stats_t			_stats;
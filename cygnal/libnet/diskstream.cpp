@@ -90,7 +90,9 @@ DiskStream::DiskStream()
       _max_memload(0),
       _filesize(0),
       _pagesize(0),
-      _offset(0)
+      _offset(0),
+      _endoffset(0),
+      _chunked(false)
 {
 //    GNASH_REPORT_FUNCTION;
     /// \brief get the pagesize and cache the value
@@ -130,7 +132,9 @@ DiskStream::DiskStream(const string &str)
       _max_memload(0),
       _filesize(0),
       _pagesize(0),
-      _offset(0)
+      _offset(0),
+      _endoffset(0),
+      _chunked(false)
 {
 //    GNASH_REPORT_FUNCTION;
     /// \brief get the pagesize and cache the value
@@ -170,7 +174,9 @@ DiskStream::DiskStream(const string &str, std::uint8_t *data, size_t size)
       _dataptr(nullptr),
       _max_memload(0),
       _pagesize(0),
-      _offset(0)
+      _offset(0),
+      _endoffset(0),
+      _chunked(false)
 {
 //    GNASH_REPORT_FUNCTION;
     
@@ -218,7 +224,9 @@ DiskStream::DiskStream(const string &str, cygnal::Buffer &buf)
       _dataptr(nullptr),
       _max_memload(0),
       _pagesize(0),
-      _offset(0)
+      _offset(0),
+      _endoffset(0),
+      _chunked(false)
 {
 //    GNASH_REPORT_FUNCTION;
     
@@ -267,7 +275,9 @@ DiskStream::DiskStream(const string &str, int netfd)
       _max_memload(0),
       _filesize(0),
       _pagesize(0),
-      _offset(0)
+      _offset(0),
+      _endoffset(0),
+      _chunked(false)
 {
 //    GNASH_REPORT_FUNCTION;
     /// \brief get the pagesize and cache the value
@@ -358,6 +368,8 @@ DiskStream::close()
     _filefd = 0;
     _netfd = 0;
     _offset = 0;
+    _endoffset = 0;
+    _chunked = false;
     _seekptr = _dataptr + _pagesize;
     _state = CLOSED;
 
@@ -744,39 +756,25 @@ DiskStream::play(int netfd, bool flag)
 	      // continue;
           case PLAY:
 	  {
-	      size_t ret;
-	      Network net;
-	      if ((_filesize - _offset) < _pagesize) {
-#ifdef HAVE_SENDFILE_XX
-		  ret = sendfile(netfd, _filefd, &_offset, _filesize - _offset);
-#else
-		  ret = net.writeNet(netfd, (_dataptr + _offset), (_filesize - _offset));
-		  if (ret != (_filesize - _offset)) {
-		      log_error(_("In %s(%d): couldn't write %d bytes to net fd #%d! %s"),
-				__FUNCTION__, __LINE__, (_filesize - _offset),
-				netfd, strerror(errno));
-		  }
-#endif
+	      // Stop at the end of the requested range, if there is one.
+	      const size_t end = _endoffset ? _endoffset : _filesize;
+	      size_t bytes = end - _offset;
+	      const bool last = (bytes <= _pagesize);
+	      if (!last) {
+		  bytes = _pagesize;
+	      }
+	      if (!writePage(netfd, bytes, last)) {
+		  close();
+		  return false;
+	      }
+	      if (last) {
 		  log_network(_("Done playing file %s, size was: %d"),
 			      _filespec, _filesize);
+		  // this also resets to the beginning of the file
  		  close();
 		  done = true;
-		  // reset to the beginning of the file
-		  _offset = 0;
 	      } else {
-		  //log_network("\tPlaying part of file %s, offset is: %d out of %d bytes.", _filespec, _offset, _filesize);
-#ifdef HAVE_SENDFILE_XX
-		  ret = sendfile(netfd, _filefd, &_offset, _pagesize);
-#else
-		  ret = net.writeNet(netfd, (_dataptr + _offset), _pagesize);
-		  if (ret != _pagesize) {
-		      log_error(_("In %s(%d): couldn't write %d of bytes of data to net fd #%d! Got %d, %s"),
-				__FUNCTION__, __LINE__, _pagesize, netfd,
-				ret, strerror(errno));
-		      return false;
-		  }
-		  _offset += _pagesize;
-#endif
+		  _offset += bytes;
 	      }
 	      switch (errno) {
 		case EINVAL:
@@ -830,6 +828,48 @@ DiskStream::play(int netfd, bool flag)
     return true;
 }
 
+bool
+DiskStream::writePage(int netfd, size_t bytes, bool last)
+{
+//    GNASH_REPORT_FUNCTION;
+    Network net;
+    int ret;
+
+    if (!_chunked) {
+	ret = net.writeNet(netfd, (_dataptr + _offset), bytes);
+	if (ret != static_cast<int>(bytes)) {
+	    log_error(_("In %s(%d): couldn't write %d bytes to net fd #%d! Got %d, %s"),
+		      __FUNCTION__, __LINE__, bytes, netfd, ret, strerror(errno));
+	    return false;
+	}
+	return true;
+    }
+
+    // Each page is one chunk, which is the size in hex, then the
+    // data. An empty chunk marks the end of the body. This is all
+    // built up first so it goes out in one write.
+    cygnal::Buffer buf(bytes + 32);
+    if (bytes) {
+	char num[20];
+	snprintf(num, sizeof(num), "%zx\r\n", bytes);
+	buf += num;
+	buf.append(_dataptr + _offset, bytes);
+	buf += "\r\n";
+    }
+    if (last) {
+	buf += "0\r\n\r\n";
+    }
+    ret = net.writeNet(netfd, buf.reference(), buf.allocated());
+    if (ret != static_cast<int>(buf.allocated())) {
+	log_error(_("In %s(%d): couldn't write %d bytes to net fd #%d! Got %d, %s"),
+		  __FUNCTION__, __LINE__, buf.allocated(), netfd, ret,
+		  strerror(errno));
+	return false;
+    }
+
+    return true;
+}
+
 /// \brief Stream a preview of the file.
 ///	A preview is a series of video frames from
 ///	the video file. Each video frame is taken by sampling
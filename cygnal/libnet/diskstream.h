@@ -122,6 +122,20 @@ public:
     bool play();
     bool play(bool flag);
     bool play(int netfd, bool flag);
+
+    /// \brief Only stream part of the file, for an HTTP Range request.
+    ///		This must be called after the stream is ready to play,
+    ///		and is forgotten when the stream is closed.
+    ///
+    /// @param first The offset of the first byte to stream.
+    ///
+    /// @param last The offset of the last byte to stream.
+    void setRange(size_t first, size_t last)
+	{ _offset = first; _endoffset = last + 1; };
+
+    /// \brief Stream each page as an HTTP chunk, ending with an
+    ///		empty chunk. This is forgotten when the stream is closed.
+    void setChunked(bool flag) { _chunked = flag; };
     
     /// \brief Stream a preview of the file.
     ///		A preview is a series of video frames from
@@ -328,6 +342,26 @@ private:
     ///		page.
     off_t	_offset;
 
+    /// \var DiskStream::_endoffset
+    ///		The offset within the file after the last byte to
+    ///		stream, or 0 to stream to the end of the file.
+    off_t	_endoffset;
+
+    /// \var DiskStream::_chunked
+    ///		True if each page is sent with HTTP chunked encoding.
+    bool	_chunked;
+
+    /// \brief Write one page, or the last part of one.
+    ///
+    /// @param netfd The file descriptor of the network connection.
+    ///
+    /// @param bytes The number of bytes to write from _offset.
+    ///
+    /// @param last True if this is the end of the stream.
+    ///
+    /// @return True if all the data was written, false if not.
+    bool writePage(int netfd, size_t bytes, bool last);
+
     /// \brief An internal routine used to extract the type of file.
     ///
     /// @param filespec An optional filename to extract the type from.
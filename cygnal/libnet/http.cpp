@@ -77,14 +77,19 @@ static const int readsize = 1024;
 static Cache& cache = Cache::getDefaultInstance();
 
 HTTP::HTTP() 
-    : _filetype(DiskStream::FILETYPE_HTML),
+    : _que("http", CQue::SPSC),
+      _filetype(DiskStream::FILETYPE_HTML),
       _filesize(0),
       _keepalive(false),
 //       _handler(0),
       _clientid(0),
       _index(0),
       _max_requests(0),
-      _close(false)
+      _close(false),
+      _chunked(false),
+      _range_first(0),
+      _range_last(0),
+      _range_total(0)
 {
 //    GNASH_REPORT_FUNCTION;
 //    struct status_codes *status = new struct status_codes;
@@ -939,7 +944,20 @@ HTTP::formatHeader(DiskStream::filetype_e type, size_t size, http_status_e code)
     formatServer();
     formatLastModified();
     formatAcceptRanges("bytes");
-    formatContentLength(size);
+    // A chunked body has no length, the last chunk marks the end.
+    if (_chunked) {
+	formatTransferEncoding("chunked");
+    } else {
+	formatContentLength(size);
+    }
+    if (code == PARTIAL_CONTENT) {
+	formatContentRange(_range_first, _range_last, _range_total);
+    } else if (code == REQUESTED_RANGE_NOT_SATISFIABLE) {
+	_buffer += "Content-Range: bytes */";
+	sprintf(num, "%zu", _range_total);
+	_buffer += num;
+	_buffer += "\r\n";
+    }
 
     // Apache closes the connection on GET requests, so we do the same.
     // This is a bit silly, because if we close after every GET request,
@@ -947,6 +965,14 @@ HTTP::formatHeader(DiskStream::filetype_e type, size_t size, http_status_e code)
     if (_close) {
 	formatConnection("close");
 	_keepalive = false;
+    } else if ((_version.major == 1) && (_version.minor == 0)) {
+	// HTTP 1.0 connections close unless we say otherwise.
+	if (_keepalive) {
+	    formatConnection("Keep-Alive");
+	}
+    } else if (!_keepalive && (_version.major >= 1)) {
+	// and HTTP 1.1 ones stay open unless we say otherwise.
+	formatConnection("close");
     }
     formatContentType(type);
 
@@ -1034,6 +1060,17 @@ HTTP::formatContentLength(std::uint32_t filesize)
     return _buffer;
 }
 
+cygnal::Buffer &
+HTTP::formatContentRange(size_t first, size_t last, size_t total)
+{
+//    GNASH_REPORT_FUNCTION;
+    char num[72];
+    sprintf(num, "Content-Range: bytes %zu-%zu/%zu\r\n", first, last, total);
+    _buffer += num;
+
+    return _buffer;
+}
+
 cygnal::Buffer &
 HTTP::formatContentType()
 {
@@ -1311,6 +1348,44 @@ HTTP::extractCommand(std::uint8_t *data)
     return cmd;
 }
 
+HTTP::http_method_e
+HTTP::extractRequest(const HTTPParser &parser)
+{
+    // GNASH_REPORT_FUNCTION;
+
+    HTTPParser::token_t method = parser.getMethod();
+    HTTP::http_method_e cmd = HTTP::HTTP_NONE;
+
+    // Methods are case sensitive, unlike the header fields.
+    if ((method.size == 3) && (memcmp(method.data, "GET", 3) == 0)) {
+        cmd = HTTP::HTTP_GET;
+    } else if ((method.size == 4) && (memcmp(method.data, "POST", 4) == 0)) {
+        cmd = HTTP::HTTP_POST;
+    } else if ((method.size == 4) && (memcmp(method.data, "HEAD", 4) == 0)) {
+        cmd = HTTP::HTTP_HEAD;
+    } else if ((method.size == 7) && (memcmp(method.data, "CONNECT", 7) == 0)) {
+        cmd = HTTP::HTTP_CONNECT;
+    } else if ((method.size == 5) && (memcmp(method.data, "TRACE", 5) == 0)) {
+        cmd = HTTP::HTTP_TRACE;
+    } else if ((method.size == 3) && (memcmp(method.data, "PUT", 3) == 0)) {
+        cmd = HTTP::HTTP_PUT;
+    } else if ((method.size == 7) && (memcmp(method.data, "OPTIONS", 7) == 0)) {
+        cmd = HTTP::HTTP_OPTIONS;
+    } else if ((method.size == 6) && (memcmp(method.data, "DELETE", 6) == 0)) {
+        cmd = HTTP::HTTP_DELETE;
+    }
+
+    _cmd = cmd;
+    _filespec = parser.getPath().str();
+    _params = parser.getQuery().str();
+    _version.major = parser.getMajorVersion();
+    _version.minor = parser.getMinorVersion();
+    _keepalive = parser.keepAlive();
+    _filesize = parser.getContentLength();
+
+    return cmd;
+}
+
 /// \brief Send a message to the other end of the network connection.
 ///`	Sends the contents of the _header and _body private data to
 ///	the already opened network connection.
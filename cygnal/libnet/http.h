@@ -36,6 +36,7 @@
 #include "network.h"
 #include "buffer.h"
 #include "diskstream.h"
+#include "http_parser.h"
 
 namespace gnash
 {
@@ -144,6 +145,15 @@ public:
     // in _fields. The address returned is the address where the Content data
     // starts, and is "Content-Length" bytes long, of "Content-Type" data.
     std::uint8_t *processHeaderFields(cygnal::Buffer *buf);
+
+    /// \brief Take the request line and the fields we care about from
+    ///		a request that has been parsed by an HTTPParser, without
+    ///		copying every field into _fields.
+    ///
+    /// @param parser An HTTPParser holding a complete request.
+    ///
+    /// @return The request method.
+    http_method_e extractRequest(const HTTPParser &parser);
     
     // Get the field for header 'name' that was stored by processHeaderFields()
     std::string &getField(const std::string &name) { return _fields[name]; };
@@ -229,6 +239,9 @@ public:
  	{return formatCommon("Accept-Encoding: " + data); };
     cygnal::Buffer &formatTE(const std::string &data)
  	{return formatCommon("TE: " + data); };
+    cygnal::Buffer &formatTransferEncoding(const std::string &data)
+ 	{return formatCommon("Transfer-Encoding: " + data); };
+    cygnal::Buffer &formatContentRange(size_t first, size_t last, size_t total);
     // All HTTP messages are terminated with a blank line
     void terminateHeader() { _buffer += "\r\n"; };    
     
@@ -280,6 +293,17 @@ public:
     // These accessors are used mostly just for debugging.
     bool keepAlive() { return _keepalive; }
     void keepAlive(bool x) { _keepalive = x; };
+
+    /// \brief Send the next response body with chunked transfer
+    ///		encoding instead of a Content-Length.
+    void setChunked(bool x) { _chunked = x; };
+    bool isChunked() { return _chunked; };
+
+    /// \brief Set the byte range for the next Partial Content response.
+    ///		A Requested Range Not Satisfiable response only uses
+    ///		the total.
+    void setRange(size_t first, size_t last, size_t total)
+	{ _range_first = first; _range_last = last; _range_total = total; };
     
     int getMaxRequests() { return _max_requests; }
     int getFileSize() { return _filesize; }
@@ -338,6 +362,12 @@ protected:
     std::string		_docroot;
 
     bool		_close;
+
+    // How the next response body is sent
+    bool		_chunked;
+    size_t		_range_first;
+    size_t		_range_last;
+    size_t		_range_total;
 };  
 
 // This is the thread for all incoming HTTP connections for the server
@@ -0,0 +1,455 @@
+// http_parser.cpp:  Incremental HTTP request parser for Cygnal, for Gnash.
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <cstring>
+#include <strings.h>
+
+#include "http_parser.h"
+
+namespace gnash
+{
+
+namespace {
+
+// The most bytes a chunk size line may use, including extensions.
+const size_t MAX_CHUNK_LINE = 1024;
+
+inline bool
+isSpace(char c)
+{
+    return (c == ' ') || (c == '\t');
+}
+
+// Parse an unsigned number, advancing the pointer past it.
+//
+// @return false if there were no digits, or the number overflowed.
+bool
+parseNumber(const char *&ptr, const char *end, size_t &num, int base)
+{
+    const char *start = ptr;
+    num = 0;
+    while (ptr < end) {
+	int digit;
+	const char c = *ptr;
+	if ((c >= '0') && (c <= '9')) {
+	    digit = c - '0';
+	} else if ((base == 16) && (c >= 'a') && (c <= 'f')) {
+	    digit = c - 'a' + 10;
+	} else if ((base == 16) && (c >= 'A') && (c <= 'F')) {
+	    digit = c - 'A' + 10;
+	} else {
+	    break;
+	}
+	if (num > (static_cast<size_t>(-1) - digit) / base) {
+	    return false;
+	}
+	num = (num * base) + digit;
+	++ptr;
+    }
+    return ptr != start;
+}
+
+// Find the next '\n' at or after pos.
+//
+// @return The offset of the '\n', or size if there isn't one.
+inline size_t
+findNewline(const char *data, size_t pos, size_t size)
+{
+    const void *nl = std::memchr(data + pos, '\n', size - pos);
+    return nl ? static_cast<const char *>(nl) - data : size;
+}
+
+} // anonymous namespace
+
+bool
+HTTPParser::token_t::equals(const char *str) const
+{
+    return (std::strlen(str) == size) && !strncasecmp(data, str, size);
+}
+
+bool
+HTTPParser::token_t::hasItem(const char *str) const
+{
+    const size_t len = std::strlen(str);
+    const char *ptr = data;
+    const char *end = data + size;
+    while (ptr < end) {
+	const char *comma = static_cast<const char *>(std::memchr(ptr, ',', end - ptr));
+	const char *stop = comma ? comma : end;
+	while ((ptr < stop) && isSpace(*ptr)) {
+	    ++ptr;
+	}
+	const char *last = stop;
+	while ((last > ptr) && isSpace(*(last - 1))) {
+	    --last;
+	}
+	if ((static_cast<size_t>(last - ptr) == len) && !strncasecmp(ptr, str, len)) {
+	    return true;
+	}
+	ptr = stop + 1;
+    }
+    return false;
+}
+
+HTTPParser::HTTPParser()
+{
+//    GNASH_REPORT_FUNCTION;
+    _fields.reserve(16);
+    reset();
+}
+
+void
+HTTPParser::reset()
+{
+//    GNASH_REPORT_FUNCTION;
+    _status = NEED_MORE;
+    _data = 0;
+    _size = 0;
+    _begin = 0;
+    _scanned = 0;
+    _header_size = 0;
+    _message_size = 0;
+    _method = _path = _query = span_t();
+    _major = 0;
+    _minor = 0;
+    // clear() keeps the storage, so a persistent connection doesn't
+    // reallocate these for each request.
+    _fields.clear();
+    _chunked = false;
+    _content_length = 0;
+    _chunk_pos = 0;
+    _last_chunk = false;
+    _body.clear();
+}
+
+HTTPParser::parse_status_e
+HTTPParser::parse(const std::uint8_t *data, size_t size)
+{
+//    GNASH_REPORT_FUNCTION;
+    _data = reinterpret_cast<const char *>(data);
+    _size = size;
+
+    if (_status != NEED_MORE) {
+	return _status;
+    }
+
+    if (!_header_size) {
+	// Servers should ignore blank lines before the request line.
+	if (_scanned == _begin) {
+	    while ((_begin < size) && ((_data[_begin] == '\r') || (_data[_begin] == '\n'))) {
+		++_begin;
+	    }
+	    _scanned = _begin;
+	}
+	// Look for the blank line at the end of the header block,
+	// starting from where we got to last time.
+	size_t pos = _scanned;
+	size_t end = 0;
+	while ((pos = findNewline(_data, pos, size)) < size) {
+	    if ((pos >= _begin + 3) && !std::memcmp(_data + pos - 3, "\r\n\r\n", 4)) {
+		end = pos + 1;
+		break;
+	    }
+	    ++pos;
+	}
+	if (!end) {
+	    // Back up a little, as the end marker may have been split.
+	    _scanned = (size > _begin + 3) ? size - 3 : _begin;
+	    if (size - _begin > MAX_HEADER_SIZE) {
+		_status = TOO_LARGE;
+	    }
+	    return _status;
+	}
+	if (end - _begin > MAX_HEADER_SIZE) {
+	    _status = TOO_LARGE;
+	    return _status;
+	}
+	_header_size = end;
+	_status = parseHeader(end);
+	if (_status != NEED_MORE) {
+	    return _status;
+	}
+    }
+
+    _status = parseBody();
+    return _status;
+}
+
+HTTPParser::parse_status_e
+HTTPParser::parseHeader(size_t end)
+{
+//    GNASH_REPORT_FUNCTION;
+
+    // The request line is the method, the URL and the version,
+    // separated by single spaces.
+    size_t eol = findNewline(_data, _begin, end) - 1;
+    const char *ptr = _data + _begin;
+    const char *stop = _data + eol;
+    const char *sp = static_cast<const char *>(std::memchr(ptr, ' ', stop - ptr));
+    if (!sp || (sp == ptr)) {
+	return BAD_REQUEST;
+    }
+    _method = span_t(ptr - _data, sp - ptr);
+
+    ptr = sp + 1;
+    sp = static_cast<const char *>(std::memchr(ptr, ' ', stop - ptr));
+    if (!sp || (sp == ptr)) {
+	return BAD_REQUEST;
+    }
+    const char *query = static_cast<const char *>(std::memchr(ptr, '?', sp - ptr));
+    if (query) {
+	_path = span_t(ptr - _data, query - ptr);
+	_query = span_t(query + 1 - _data, sp - query - 1);
+    } else {
+	_path = span_t(ptr - _data, sp - ptr);
+    }
+
+    ptr = sp + 1;
+    if ((stop - ptr != 8) || std::memcmp(ptr, "HTTP/", 5)
+	|| (ptr[5] < '0') || (ptr[5] > '9') || (ptr[6] != '.')
+	|| (ptr[7] < '0') || (ptr[7] > '9')) {
+	return BAD_REQUEST;
+    }
+    _major = ptr[5] - '0';
+    _minor = ptr[7] - '0';
+
+    // Then each header field is a name, a colon, and a value with
+    // optional white space around it.
+    size_t pos = eol + 2;
+    while (pos < end - 2) {
+	eol = findNewline(_data, pos, end);
+	if ((eol == pos) || (_data[eol - 1] != '\r')) {
+	    return BAD_REQUEST;
+	}
+	--eol;
+	ptr = _data + pos;
+	stop = _data + eol;
+	// Folded lines are obsolete, and a way to smuggle requests.
+	if (isSpace(*ptr)) {
+	    return BAD_REQUEST;
+	}
+	const char *colon = static_cast<const char *>(std::memchr(ptr, ':', stop - ptr));
+	if (!colon || (colon == ptr) || isSpace(*(colon - 1))) {
+	    return BAD_REQUEST;
+	}
+	if (_fields.size() >= MAX_FIELDS) {
+	    return TOO_LARGE;
+	}
+	field_t field;
+	field.name = span_t(pos, colon - ptr);
+	const char *value = colon + 1;
+	while ((value < stop) && isSpace(*value)) {
+	    ++value;
+	}
+	while ((stop > value) && isSpace(*(stop - 1))) {
+	    --stop;
+	}
+	field.value = span_t(value - _data, stop - value);
+	_fields.push_back(field);
+	pos = eol + 2;
+    }
+
+    // Chunked encoding wins if the client sent a length as well.
+    token_t te = getField("transfer-encoding");
+    if (!te.empty()) {
+	if (!te.hasItem("chunked")) {
+	    return BAD_REQUEST;
+	}
+	_chunked = true;
+	_chunk_pos = _header_size;
+    } else {
+	token_t length = getField("content-length");
+	if (!length.empty()) {
+	    const char *num = length.data;
+	    if (!parseNumber(num, length.data + length.size, _content_length, 10)
+		|| (num != length.data + length.size)) {
+		return BAD_REQUEST;
+	    }
+	}
+    }
+
+    return NEED_MORE;
+}
+
+HTTPParser::parse_status_e
+HTTPParser::parseBody()
+{
+//    GNASH_REPORT_FUNCTION;
+    if (_chunked) {
+	return parseChunks();
+    }
+
+    if (_size - _header_size < _content_length) {
+	return NEED_MORE;
+    }
+    if (_content_length) {
+	_body.push_back(span_t(_header_size, _content_length));
+    }
+    _message_size = _header_size + _content_length;
+
+    return COMPLETE;
+}
+
+HTTPParser::parse_status_e
+HTTPParser::parseChunks()
+{
+//    GNASH_REPORT_FUNCTION;
+
+    // Each chunk is its size in hex on a line of its own, optionally
+    // followed by extensions we ignore, then the data and a CRLF. A
+    // chunk with a size of zero ends the body.
+    while (!_last_chunk) {
+	const size_t eol = findNewline(_data, _chunk_pos, _size);
+	if (eol == _size) {
+	    return (_size - _chunk_pos > MAX_CHUNK_LINE) ? BAD_REQUEST : NEED_MORE;
+	}
+	const char *ptr = _data + _chunk_pos;
+	size_t length;
+	if (!parseNumber(ptr, _data + eol, length, 16)
+	    || ((*ptr != ';') && (*ptr != '\r') && !isSpace(*ptr))) {
+	    return BAD_REQUEST;
+	}
+	if (length == 0) {
+	    _last_chunk = true;
+	    _chunk_pos = eol + 1;
+	    break;
+	}
+	const size_t start = eol + 1;
+	if ((_size - start < 2) || (_size - start - 2 < length)) {
+	    return NEED_MORE;
+	}
+	if ((_data[start + length] != '\r') || (_data[start + length + 1] != '\n')) {
+	    return BAD_REQUEST;
+	}
+	_body.push_back(span_t(start, length));
+	_content_length += length;
+	_chunk_pos = start + length + 2;
+    }
+
+    // Skip any trailer fields, up to the final blank line.
+    for (;;) {
+	const size_t eol = findNewline(_data, _chunk_pos, _size);
+	if (eol == _size) {
+	    return (_size - _chunk_pos > MAX_HEADER_SIZE) ? TOO_LARGE : NEED_MORE;
+	}
+	if ((eol == _chunk_pos) || ((eol == _chunk_pos + 1) && (_data[_chunk_pos] == '\r'))) {
+	    _message_size = eol + 1;
+	    return COMPLETE;
+	}
+	_chunk_pos = eol + 1;
+    }
+}
+
+HTTPParser::token_t
+HTTPParser::getField(const char *name) const
+{
+//    GNASH_REPORT_FUNCTION;
+    // There are few enough fields that a linear search beats building
+    // a map for each request.
+    for (size_t i = 0; i < _fields.size(); ++i) {
+	if (token(_fields[i].name).equals(name)) {
+	    return token(_fields[i].value);
+	}
+    }
+    return token_t();
+}
+
+bool
+HTTPParser::keepAlive() const
+{
+//    GNASH_REPORT_FUNCTION;
+    token_t connection = getField("connection");
+    if ((_major > 1) || ((_major == 1) && (_minor >= 1))) {
+	return !connection.hasItem("close");
+    }
+    return connection.hasItem("keep-alive");
+}
+
+HTTPParser::range_status_e
+HTTPParser::parseRange(const token_t &value, size_t filesize,
+		       size_t &first, size_t &last)
+{
+//    GNASH_REPORT_FUNCTION;
+    static const char unit[] = "bytes=";
+    const size_t unitlen = sizeof(unit) - 1;
+
+    if ((value.size <= unitlen) || strncasecmp(value.data, unit, unitlen)) {
+	return RANGE_NONE;
+    }
+    const char *ptr = value.data + unitlen;
+    const char *end = value.data + value.size;
+    if (std::memchr(ptr, ',', end - ptr)) {
+	return RANGE_NONE;
+    }
+    while ((ptr < end) && isSpace(*ptr)) {
+	++ptr;
+    }
+    if (ptr == end) {
+	return RANGE_NONE;
+    }
+
+    if (*ptr == '-') {
+	// A suffix range is the last N bytes of the file.
+	size_t count;
+	++ptr;
+	if (!parseNumber(ptr, end, count, 10) || (ptr != end)) {
+	    return RANGE_NONE;
+	}
+	if ((count == 0) || (filesize == 0)) {
+	    return RANGE_UNSATISFIABLE;
+	}
+	first = (count >= filesize) ? 0 : filesize - count;
+	last = filesize - 1;
+	return RANGE_OK;
+    }
+
+    size_t start;
+    if (!parseNumber(ptr, end, start, 10) || (ptr == end) || (*ptr != '-')) {
+	return RANGE_NONE;
+    }
+    ++ptr;
+    size_t stop = filesize ? filesize - 1 : 0;
+    if (ptr != end) {
+	if (!parseNumber(ptr, end, stop, 10) || (ptr != end)) {
+	    return RANGE_NONE;
+	}
+	if (stop < start) {
+	    return RANGE_NONE;
+	}
+    }
+    if (start >= filesize) {
+	return RANGE_UNSATISFIABLE;
+    }
+    first = start;
+    last = (stop >= filesize) ? filesize - 1 : stop;
+
+    return RANGE_OK;
+}
+
+} // end of gnash namespace
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: t
+// End:
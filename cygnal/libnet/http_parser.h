@@ -0,0 +1,222 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#ifndef GNASH_LIBNET_HTTP_PARSER_H
+#define GNASH_LIBNET_HTTP_PARSER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "dsodefs.h" //For DSOEXPORT.
+
+namespace gnash
+{
+
+/// \class HTTPParser
+///	An incremental parser for HTTP/1.x requests. The request is
+///	parsed in place, so the method, URL and header fields are
+///	only references into the caller's buffer, and nothing is
+///	copied or allocated per field. Data can be fed in as it
+///	arrives from the network; the parser remembers how far it got,
+///	so each byte is only scanned once. As all positions are stored
+///	as offsets, the buffer may be grown or moved between calls.
+///
+///	Once a request is complete, getMessageSize() is the number of
+///	bytes it used, so any pipelined requests that follow it in the
+///	same buffer can be parsed after calling reset().
+class DSOEXPORT HTTPParser
+{
+public:
+    typedef enum {
+	NEED_MORE,		// the request isn't all here yet
+	COMPLETE,		// the request and any body are all here
+	BAD_REQUEST,		// the request is malformed
+	TOO_LARGE		// the header block is too big
+    } parse_status_e;
+
+    typedef enum {
+	RANGE_NONE,		// no usable Range, send the whole file
+	RANGE_OK,		// send the bytes from first to last
+	RANGE_UNSATISFIABLE	// the range is outside of the file
+    } range_status_e;
+
+    /// \struct HTTPParser::token_t
+    ///		A string inside the buffer being parsed. This is only
+    ///		valid until the buffer is changed.
+    struct token_t {
+	token_t() : data(0), size(0) { }
+	token_t(const char *d, size_t s) : data(d), size(s) { }
+	std::string str() const { return size ? std::string(data, size) : std::string(); }
+	bool empty() const { return size == 0; }
+	/// Compare ignoring case, as header names and most values
+	/// are case insensitive.
+	bool equals(const char *str) const;
+	/// Look for a comma separated item, ignoring case, such as
+	/// "close" in a Connection field.
+	bool hasItem(const char *str) const;
+	const char *data;
+	size_t      size;
+    };
+
+    /// The most header bytes accepted before the request is rejected.
+    static const size_t MAX_HEADER_SIZE = 16384;
+    /// The most header fields accepted before the request is rejected.
+    static const size_t MAX_FIELDS = 64;
+
+    HTTPParser();
+
+    /// \brief Forget the current request, to start on the next one.
+    void reset();
+
+    /// \brief Parse as much of a request as has been received.
+    ///
+    /// @param data A pointer to the start of the request. This must
+    ///		be the same request each time, with any new data
+    ///		appended, but it doesn't have to be the same address.
+    ///
+    /// @param size The number of bytes received so far.
+    ///
+    /// @return The state of the request.
+    parse_status_e parse(const std::uint8_t *data, size_t size);
+
+    parse_status_e getStatus() const { return _status; }
+
+    /// \brief Get the request method, like "GET".
+    token_t getMethod() const { return token(_method); }
+
+    /// \brief Get the path part of the request URL.
+    token_t getPath() const { return token(_path); }
+
+    /// \brief Get the query part of the request URL, without the '?'.
+    token_t getQuery() const { return token(_query); }
+
+    int getMajorVersion() const { return _major; }
+    int getMinorVersion() const { return _minor; }
+
+    /// \brief Get the value of a header field.
+    ///
+    /// @param name The field name, in any case.
+    ///
+    /// @return The value, which is empty if the field isn't present.
+    token_t getField(const char *name) const;
+
+    size_t getFieldCount() const { return _fields.size(); }
+    token_t getFieldName(size_t index) const { return token(_fields[index].name); }
+    token_t getFieldValue(size_t index) const { return token(_fields[index].value); }
+
+    /// \brief Whether the connection stays open after this request.
+    ///		HTTP/1.1 connections are persistent unless the client
+    ///		says "Connection: close", HTTP/1.0 ones only if it
+    ///		says "Connection: Keep-Alive".
+    bool keepAlive() const;
+
+    /// \brief Whether the request body used chunked transfer encoding.
+    bool isChunked() const { return _chunked; }
+
+    /// \brief Get the length of the request body, after removing
+    ///		any chunked encoding.
+    size_t getContentLength() const { return _content_length; }
+
+    /// \brief Get the number of pieces the body is in. This is 1
+    ///		for a body sent with a Content-Length, and the number
+    ///		of chunks for a chunked one.
+    size_t getBodyParts() const { return _body.size(); }
+    token_t getBodyPart(size_t index) const { return token(_body[index]); }
+
+    /// \brief Get the number of bytes used by the header block.
+    size_t getHeaderSize() const { return _header_size; }
+
+    /// \brief Get the number of bytes used by the whole request,
+    ///		which is where the next pipelined request starts.
+    size_t getMessageSize() const { return _message_size; }
+
+    /// \brief Parse the value of a Range field.
+    ///		Only a single byte range is supported. A client asking
+    ///		for several ranges gets the whole file instead, which
+    ///		RFC 2616 allows.
+    ///
+    /// @param value The value of the Range field.
+    ///
+    /// @param filesize The size of the file being sent.
+    ///
+    /// @param first Set to the first byte to send.
+    ///
+    /// @param last Set to the last byte to send, which is inclusive.
+    ///
+    /// @return Whether to send part of the file, all of it, or an error.
+    static range_status_e parseRange(const token_t &value, size_t filesize,
+				     size_t &first, size_t &last);
+
+private:
+    struct span_t {
+	span_t() : offset(0), size(0) { }
+	span_t(size_t o, size_t s) : offset(o), size(s) { }
+	size_t offset;
+	size_t size;
+    };
+    struct field_t {
+	span_t name;
+	span_t value;
+    };
+
+    token_t token(const span_t &span) const {
+	return token_t(_data + span.offset, span.size);
+    }
+
+    parse_status_e parseHeader(size_t end);
+    parse_status_e parseBody();
+    parse_status_e parseChunks();
+
+    parse_status_e	_status;
+    const char		*_data;
+    size_t		_size;
+
+    /// Where the request line starts, after any blank lines.
+    size_t		_begin;
+    /// How far we've looked for the end of the header block.
+    size_t		_scanned;
+    size_t		_header_size;
+    size_t		_message_size;
+
+    span_t		_method;
+    span_t		_path;
+    span_t		_query;
+    int			_major;
+    int			_minor;
+    std::vector<field_t> _fields;
+
+    bool		_chunked;
+    size_t		_content_length;
+    /// Where the next chunk size line starts, for chunked bodies.
+    size_t		_chunk_pos;
+    bool		_last_chunk;
+    std::vector<span_t>	_body;
+};
+
+} // end of gnash namespace
+
+// end of GNASH_LIBNET_HTTP_PARSER_H
+#endif
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: t
+// End:
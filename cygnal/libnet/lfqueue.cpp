@@ -0,0 +1,137 @@
+//
+//   Copyright (C) 2008, 2009, 2010, 2011, 2012 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <chrono>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#ifdef HAVE_SYS_EVENTFD_H
+# include <sys/eventfd.h>
+# include <poll.h>
+# include <unistd.h>
+#endif
+
+#include "lfqueue.h"
+#include "log.h"
+
+namespace gnash
+{
+
+QueueEvent::QueueEvent()
+    : _fd(-1),
+      _pending(false)
+{
+//    GNASH_REPORT_FUNCTION;
+#ifdef HAVE_SYS_EVENTFD_H
+    _fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (_fd < 0) {
+        log_error(_("Couldn't create eventfd, using a condition variable: %s"),
+                  std::strerror(errno));
+    }
+#endif
+}
+
+QueueEvent::~QueueEvent()
+{
+//    GNASH_REPORT_FUNCTION;
+#ifdef HAVE_SYS_EVENTFD_H
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+#endif
+}
+
+void
+QueueEvent::notify()
+{
+//    GNASH_REPORT_FUNCTION;
+#ifdef HAVE_SYS_EVENTFD_H
+    if (_fd >= 0) {
+        const std::uint64_t one = 1;
+        while (::write(_fd, &one, sizeof(one)) < 0 && errno == EINTR) {
+        }
+        return;
+    }
+#endif
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending = true;
+    }
+    _cond.notify_one();
+}
+
+void
+QueueEvent::wait()
+{
+//    GNASH_REPORT_FUNCTION;
+#ifdef HAVE_SYS_EVENTFD_H
+    if (_fd >= 0) {
+        // Another waiter may win the race for the counter after poll()
+        // returns, in which case we just go back to sleep.
+        while (!wait(-1)) {
+        }
+        return;
+    }
+#endif
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cond.wait(lock, [this] { return _pending; });
+    _pending = false;
+}
+
+bool
+QueueEvent::wait(int milliseconds)
+{
+//    GNASH_REPORT_FUNCTION;
+#ifdef HAVE_SYS_EVENTFD_H
+    if (_fd >= 0) {
+        struct pollfd pfd;
+        pfd.fd = _fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ret;
+        while ((ret = ::poll(&pfd, 1, milliseconds)) < 0 && errno == EINTR) {
+        }
+        if (ret <= 0) {
+            return false;
+        }
+        // Reading resets the counter, so several notifications that
+        // arrive before we wake up only cost a single wakeup.
+        std::uint64_t count;
+        return (::read(_fd, &count, sizeof(count)) == sizeof(count));
+    }
+#endif
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_cond.wait_for(lock, std::chrono::milliseconds(milliseconds),
+                        [this] { return _pending; })) {
+        return false;
+    }
+    _pending = false;
+    return true;
+}
+
+} // end of gnash namespace
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
@@ -0,0 +1,338 @@
+//
+//   Copyright (C) 2008, 2009, 2010, 2011, 2012 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#ifndef __LFQUEUE_H__
+#define __LFQUEUE_H__
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+#include "dsodefs.h" //For DSOEXPORT.
+
+namespace gnash
+{
+
+/// Size of a cache line, used to keep the producer and consumer
+/// indexes from sharing one.
+static const size_t LFQUEUE_CACHELINE = 64;
+
+/// Round up to the next power of two, which the ring buffers need
+/// so an index can be turned into a slot with a mask.
+inline size_t
+lfqueue_capacity(size_t size)
+{
+    size_t cap = 2;
+    while (cap < size) {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+/// \class SPSCQueue
+///     A bounded lock-free ring buffer for exactly one producer thread
+///     and one consumer thread. This is what the per-connection in and
+///     out queues use, as each of them is only ever written by the
+///     network reader and read by the protocol handler (or the other
+///     way around).
+template <typename T>
+class SPSCQueue {
+public:
+    explicit SPSCQueue(size_t size)
+        : _slots(lfqueue_capacity(size)),
+          _mask(_slots.size() - 1),
+          _head(0),
+          _tail(0)
+        { }
+
+    /// Push an item on the tail of the queue.
+    ///
+    /// @return false if the queue is full.
+    bool push(const T &item) { return emplace(item); }
+
+    /// Move an item on the tail of the queue. The item is left alone
+    /// if the queue is full.
+    bool push(T &&item) { return emplace(std::move(item)); }
+
+    template <typename U>
+    bool emplace(U &&item) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) > _mask) {
+            return false;
+        }
+        _slots[tail & _mask] = std::forward<U>(item);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Pop the item at the head of the queue.
+    ///
+    /// @return false if the queue is empty.
+    bool pop(T &item) {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(_slots[head & _mask]);
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Copy the item at the head of the queue without removing it.
+    /// Only the consumer thread may call this.
+    bool peek(T &item) const {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _slots[head & _mask];
+        return true;
+    }
+
+    /// The number of items in the queue. This is only a snapshot when
+    /// the other side is active.
+    size_t size() const {
+        return _tail.load(std::memory_order_acquire)
+            - _head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return _slots.size(); }
+
+private:
+    std::vector<T>      _slots;
+    const size_t        _mask;
+    // Written by the consumer only.
+    alignas(LFQUEUE_CACHELINE) std::atomic<size_t> _head;
+    // Written by the producer only.
+    alignas(LFQUEUE_CACHELINE) std::atomic<size_t> _tail;
+};
+
+/// \class MPMCQueue
+///     A bounded lock-free ring buffer for any number of producers and
+///     consumers. Each slot carries a sequence number that tells the
+///     threads racing for it whether it is ready to be written or
+///     read, so a push or pop costs one compare-and-swap when
+///     uncontended. This is used for the shared work queues.
+template <typename T>
+class MPMCQueue {
+public:
+    explicit MPMCQueue(size_t size)
+        : _slots(lfqueue_capacity(size)),
+          _mask(_slots.size() - 1),
+          _head(0),
+          _tail(0)
+        {
+            for (size_t i = 0; i < _slots.size(); ++i) {
+                _slots[i].seq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+    /// Push an item on the tail of the queue.
+    ///
+    /// @return false if the queue is full.
+    bool push(const T &item) { return emplace(item); }
+
+    /// Move an item on the tail of the queue. The item is left alone
+    /// if the queue is full.
+    bool push(T &&item) { return emplace(std::move(item)); }
+
+    template <typename U>
+    bool emplace(U &&item) {
+        size_t pos = _tail.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;) {
+            slot = &_slots[pos & _mask];
+            const size_t seq = slot->seq.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq)
+                - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (_tail.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->data = std::forward<U>(item);
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Pop the item at the head of the queue.
+    ///
+    /// @return false if the queue is empty.
+    bool pop(T &item) {
+        size_t pos = _head.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;) {
+            slot = &_slots[pos & _mask];
+            const size_t seq = slot->seq.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq)
+                - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (_head.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _head.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(slot->data);
+        slot->seq.store(pos + _mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Copy the item at the head of the queue without removing it.
+    /// This is only safe when there is a single consumer, as another
+    /// consumer could otherwise recycle the slot while it is copied.
+    bool peek(T &item) const {
+        const size_t pos = _head.load(std::memory_order_relaxed);
+        const Slot &slot = _slots[pos & _mask];
+        if (slot.seq.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        item = slot.data;
+        return true;
+    }
+
+    /// The number of items in the queue. This is only a snapshot when
+    /// other threads are active.
+    size_t size() const {
+        const size_t tail = _tail.load(std::memory_order_acquire);
+        const size_t head = _head.load(std::memory_order_acquire);
+        return (tail > head) ? tail - head : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return _slots.size(); }
+
+private:
+    struct Slot {
+        Slot() : seq(0) { }
+        std::atomic<size_t> seq;
+        T                   data;
+    };
+    std::vector<Slot>   _slots;
+    const size_t        _mask;
+    alignas(LFQUEUE_CACHELINE) std::atomic<size_t> _head;
+    alignas(LFQUEUE_CACHELINE) std::atomic<size_t> _tail;
+};
+
+/// \class QueueEvent
+///     A wakeup event for threads blocked on an empty queue. On Linux
+///     this is an eventfd, so a notification that arrives before the
+///     consumer goes to sleep is never lost, and the descriptor can
+///     also be added to a poll() set alongside the sockets. Elsewhere
+///     it falls back to a condition variable with a pending flag.
+class DSOEXPORT QueueEvent {
+public:
+    QueueEvent();
+    ~QueueEvent();
+
+    /// Wake up one waiting thread, or the next one to wait.
+    void notify();
+
+    /// Block until notified. Consumes the notification.
+    void wait();
+
+    /// Block until notified, or until the timeout expires.
+    ///
+    /// @param milliseconds The maximum time to wait.
+    ///
+    /// @return true if notified, false on timeout.
+    bool wait(int milliseconds);
+
+    /// Get the file descriptor for poll(), or -1 if there is none.
+    int getFileDescriptor() const { return _fd; }
+
+private:
+    int                         _fd;
+    std::mutex                  _mutex;
+    std::condition_variable     _cond;
+    bool                        _pending;
+};
+
+/// \class BlockingQueue
+///     Adapt one of the lock-free queues so a consumer can sleep while
+///     it is empty. Producers only make a system call when a consumer
+///     has announced that it is about to sleep, so the uncontended
+///     path stays lock-free.
+template <typename Q, typename T>
+class BlockingQueue {
+public:
+    explicit BlockingQueue(size_t size)
+        : _queue(size),
+          _waiters(0)
+        { }
+
+    bool push(const T &item) {
+        if (!_queue.push(item)) {
+            return false;
+        }
+        // Pairs with the increment of _waiters in pop_wait(), so
+        // either we see the waiter or it sees the item.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_waiters.load(std::memory_order_relaxed)) {
+            _event.notify();
+        }
+        return true;
+    }
+
+    bool pop(T &item) { return _queue.pop(item); }
+
+    /// Pop an item, sleeping until one arrives.
+    void pop_wait(T &item) {
+        while (!_queue.pop(item)) {
+            _waiters.fetch_add(1, std::memory_order_seq_cst);
+            if (_queue.pop(item)) {
+                _waiters.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+            _event.wait();
+            _waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    size_t size() const { return _queue.size(); }
+    bool empty() const { return _queue.empty(); }
+    QueueEvent &event() { return _event; }
+
+private:
+    Q                   _queue;
+    std::atomic<int>    _waiters;
+    QueueEvent          _event;
+};
+
+} // end of gnash namespace
+
+#endif // end of __LFQUEUE_H__
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
@@ -0,0 +1,475 @@
+// metrics.cpp:  Live performance counters for Cygnal, for Gnash.
+//
+//   Copyright (C) 2008, 2009, 2010, 2011, 2012 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <sstream>
+#include <cstring>
+#include <ctime>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "metrics.h"
+
+namespace gnash
+{
+
+namespace {
+
+// These are in the same order as Network::protocols_supported_e.
+const char *protocol_names[] = {
+    "none", "http", "https", "rtmp", "rtmpt", "rtmpts", "rtmpe", "rtmps", "dtn"
+};
+
+// These are in the same order as HTTP::http_method_e.
+const char *method_names[] = {
+    "none", "options", "get", "head", "post", "put", "delete", "trace",
+    "connect"
+};
+
+const char *cache_names[] = { "path", "response", "file" };
+
+const char *
+rtmpTypeName(int type)
+{
+    switch (type) {
+      case 0x01: return "chunk_size";
+      case 0x02: return "abort";
+      case 0x03: return "bytes_read";
+      case 0x04: return "user";
+      case 0x05: return "window_size";
+      case 0x06: return "set_bandwidth";
+      case 0x07: return "route";
+      case 0x08: return "audio";
+      case 0x09: return "video";
+      case 0x0a: return "shared_obj";
+      case 0x0f: return "amf3_notify";
+      case 0x10: return "amf3_shared_obj";
+      case 0x11: return "amf3_invoke";
+      case 0x12: return "notify";
+      case 0x14: return "invoke";
+      case 0x16: return "flv_data";
+      default:   return 0;
+    }
+}
+
+template <typename T, size_t N>
+const char *
+lookup(const char *(&names)[N], T index)
+{
+    if ((index < 0) || (static_cast<size_t>(index) >= N)) {
+	return "unknown";
+    }
+    return names[index];
+}
+
+void
+formatHistogram(std::ostream &os, const char *name,
+		const Metrics::Histogram &hist)
+{
+    os << "# TYPE " << name << " histogram\n";
+    std::uint64_t total = 0;
+    for (int i = 0; i < Metrics::Histogram::BUCKETS; i++) {
+	total += hist.bucket(i);
+	os << name << "_bucket{le=\"" << Metrics::Histogram::limit(i) / 1e6
+	   << "\"} " << total << "\n";
+    }
+    total += hist.bucket(Metrics::Histogram::BUCKETS);
+    os << name << "_bucket{le=\"+Inf\"} " << total << "\n";
+    os << name << "_sum " << hist.sum() / 1e6 << "\n";
+    os << name << "_count " << hist.count() << "\n";
+}
+
+} // anonymous namespace
+
+Metrics::Histogram::Histogram()
+    : _count(0), _sum(0)
+{
+    for (int i = 0; i <= BUCKETS; i++) {
+	_buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void
+Metrics::Histogram::add(std::uint64_t usec)
+{
+    // The bucket is the number of bits needed for the value, so a
+    // sample of up to 2^n microseconds lands in bucket n.
+    int index = 0;
+    for (std::uint64_t limit = 1; (limit < usec) && (index < BUCKETS);
+	 limit <<= 1) {
+	index++;
+    }
+    _buckets[index].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(usec, std::memory_order_relaxed);
+}
+
+Metrics::Metrics()
+    : _start(now())
+{
+//    GNASH_REPORT_FUNCTION;
+    _bytes_in.value.store(0);
+    _bytes_out.value.store(0);
+    _accepted.value.store(0);
+    _closed.value.store(0);
+    for (int i = 0; i < HTTP_METHODS; i++) {
+	_http_requests[i].store(0);
+    }
+    for (int i = 0; i < RTMP_TYPES; i++) {
+	_rtmp_messages[i].store(0);
+    }
+    for (int i = 0; i < CACHE_TYPES; i++) {
+	_cache_lookups[i].store(0);
+	_cache_hits[i].store(0);
+    }
+    for (int i = 0; i < MAX_CONNECTIONS; i++) {
+	connection_t &conn = _connections[i];
+	conn.open.store(false);
+	conn.protocol.store(0);
+	conn.start.store(0);
+	conn.bytes_in.store(0);
+	conn.bytes_out.store(0);
+	conn.messages.store(0);
+	conn.queue_depth.store(0);
+    }
+    for (int i = 0; i < MAX_THREADS; i++) {
+	thread_t &thread = _threads[i];
+	thread.used.store(false);
+	thread.ready.store(false);
+	thread.name[0] = 0;
+	thread.cpu.store(0);
+	thread.lag_max.store(0);
+    }
+}
+
+Metrics &
+Metrics::getDefaultInstance()
+{
+//    GNASH_REPORT_FUNCTION;
+    static Metrics metrics;
+    return metrics;
+}
+
+std::uint64_t
+Metrics::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+void
+Metrics::opened(int fd)
+{
+//    GNASH_REPORT_FUNCTION;
+    add(_accepted.value, 1);
+    if ((fd < 0) || (fd >= MAX_CONNECTIONS)) {
+	return;
+    }
+    // A descriptor is only reused once it has been closed, so only
+    // the thread that accepted it can be touching this slot now.
+    connection_t &conn = _connections[fd];
+    conn.protocol.store(0, std::memory_order_relaxed);
+    conn.start.store(now(), std::memory_order_relaxed);
+    conn.bytes_in.store(0, std::memory_order_relaxed);
+    conn.bytes_out.store(0, std::memory_order_relaxed);
+    conn.messages.store(0, std::memory_order_relaxed);
+    conn.queue_depth.store(0, std::memory_order_relaxed);
+    conn.open.store(true, std::memory_order_release);
+}
+
+void
+Metrics::closed(int fd)
+{
+//    GNASH_REPORT_FUNCTION;
+    connection_t *conn = connection(fd);
+    if (conn) {
+	add(_closed.value, 1);
+	conn->open.store(false, std::memory_order_release);
+    }
+}
+
+void
+Metrics::setProtocol(int fd, int protocol)
+{
+    connection_t *conn = connection(fd);
+    if (conn) {
+	conn->protocol.store(protocol, std::memory_order_relaxed);
+    }
+}
+
+void
+Metrics::received(int fd, size_t bytes)
+{
+    add(_bytes_in.value, bytes);
+    connection_t *conn = connection(fd);
+    if (conn) {
+	add(conn->bytes_in, bytes);
+    }
+}
+
+void
+Metrics::sent(int fd, size_t bytes)
+{
+    add(_bytes_out.value, bytes);
+    connection_t *conn = connection(fd);
+    if (conn) {
+	add(conn->bytes_out, bytes);
+    }
+}
+
+void
+Metrics::httpRequest(int method)
+{
+    if ((method < 0) || (method >= HTTP_METHODS)) {
+	method = 0;
+    }
+    add(_http_requests[method], 1);
+}
+
+void
+Metrics::rtmpMessage(int fd, int type)
+{
+    if ((type < 0) || (type >= RTMP_TYPES)) {
+	type = 0;
+    }
+    add(_rtmp_messages[type], 1);
+    connection_t *conn = connection(fd);
+    if (conn) {
+	add(conn->messages, 1);
+    }
+}
+
+void
+Metrics::queueDepth(int fd, size_t depth)
+{
+    connection_t *conn = connection(fd);
+    if (conn) {
+	conn->queue_depth.store(depth, std::memory_order_relaxed);
+    }
+}
+
+void
+Metrics::cacheLookup(cache_e cache, bool hit)
+{
+    if ((cache < 0) || (cache >= CACHE_TYPES)) {
+	return;
+    }
+    add(_cache_lookups[cache], 1);
+    if (hit) {
+	add(_cache_hits[cache], 1);
+    }
+}
+
+int
+Metrics::addThread(const char *name)
+{
+//    GNASH_REPORT_FUNCTION;
+    for (int i = 0; i < MAX_THREADS; i++) {
+	bool used = false;
+	if (_threads[i].used.compare_exchange_strong(used, true)) {
+	    thread_t &thread = _threads[i];
+	    std::strncpy(thread.name, name, sizeof(thread.name) - 1);
+	    thread.name[sizeof(thread.name) - 1] = 0;
+	    thread.cpu.store(0, std::memory_order_relaxed);
+	    thread.lag_max.store(0, std::memory_order_relaxed);
+	    thread.ready.store(true, std::memory_order_release);
+	    return i;
+	}
+    }
+    return -1;
+}
+
+void
+Metrics::removeThread(int id)
+{
+//    GNASH_REPORT_FUNCTION;
+    if ((id < 0) || (id >= MAX_THREADS)) {
+	return;
+    }
+    _threads[id].ready.store(false, std::memory_order_release);
+    _threads[id].used.store(false, std::memory_order_release);
+}
+
+void
+Metrics::sampleThread(int id)
+{
+    if ((id < 0) || (id >= MAX_THREADS)) {
+	return;
+    }
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+	_threads[id].cpu.store(static_cast<std::uint64_t>(ts.tv_sec) * 1000000
+			       + ts.tv_nsec / 1000, std::memory_order_relaxed);
+    }
+}
+
+void
+Metrics::loopLag(int id, std::uint64_t usec)
+{
+    _loop_lag.add(usec);
+    if ((id < 0) || (id >= MAX_THREADS)) {
+	return;
+    }
+    std::atomic<std::uint64_t> &max = _threads[id].lag_max;
+    std::uint64_t old = max.load(std::memory_order_relaxed);
+    while ((usec > old)
+	   && !max.compare_exchange_weak(old, usec, std::memory_order_relaxed)) {
+    }
+}
+
+std::string
+Metrics::format() const
+{
+//    GNASH_REPORT_FUNCTION;
+    std::ostringstream os;
+
+    os << "# TYPE cygnal_uptime_seconds gauge\n";
+    os << "cygnal_uptime_seconds " << (now() - _start) / 1e6 << "\n";
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+	os << "# TYPE cygnal_cpu_seconds_total counter\n";
+	os << "cygnal_cpu_seconds_total{mode=\"user\"} "
+	   << usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 << "\n";
+	os << "cygnal_cpu_seconds_total{mode=\"system\"} "
+	   << usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6 << "\n";
+    }
+
+    os << "# TYPE cygnal_connections_total counter\n";
+    os << "cygnal_connections_total{state=\"accepted\"} "
+       << _accepted.value.load(std::memory_order_relaxed) << "\n";
+    os << "cygnal_connections_total{state=\"closed\"} "
+       << _closed.value.load(std::memory_order_relaxed) << "\n";
+
+    os << "# TYPE cygnal_bytes_total counter\n";
+    os << "cygnal_bytes_total{direction=\"in\"} "
+       << _bytes_in.value.load(std::memory_order_relaxed) << "\n";
+    os << "cygnal_bytes_total{direction=\"out\"} "
+       << _bytes_out.value.load(std::memory_order_relaxed) << "\n";
+
+    os << "# TYPE cygnal_http_requests_total counter\n";
+    for (int i = 0; i < HTTP_METHODS; i++) {
+	std::uint64_t count = _http_requests[i].load(std::memory_order_relaxed);
+	if (count) {
+	    os << "cygnal_http_requests_total{method=\""
+	       << lookup(method_names, i) << "\"} " << count << "\n";
+	}
+    }
+
+    os << "# TYPE cygnal_rtmp_messages_total counter\n";
+    for (int i = 0; i < RTMP_TYPES; i++) {
+	std::uint64_t count = _rtmp_messages[i].load(std::memory_order_relaxed);
+	if (count) {
+	    const char *name = rtmpTypeName(i);
+	    os << "cygnal_rtmp_messages_total{type=\"";
+	    if (name) {
+		os << name;
+	    } else {
+		os << i;
+	    }
+	    os << "\"} " << count << "\n";
+	}
+    }
+
+    os << "# TYPE cygnal_cache_lookups_total counter\n";
+    os << "# TYPE cygnal_cache_hits_total counter\n";
+    os << "# TYPE cygnal_cache_hit_ratio gauge\n";
+    for (int i = 0; i < CACHE_TYPES; i++) {
+	std::uint64_t lookups = _cache_lookups[i].load(std::memory_order_relaxed);
+	std::uint64_t hits = _cache_hits[i].load(std::memory_order_relaxed);
+	os << "cygnal_cache_lookups_total{cache=\"" << cache_names[i] << "\"} "
+	   << lookups << "\n";
+	os << "cygnal_cache_hits_total{cache=\"" << cache_names[i] << "\"} "
+	   << hits << "\n";
+	os << "cygnal_cache_hit_ratio{cache=\"" << cache_names[i] << "\"} "
+	   << (lookups ? static_cast<double>(hits) / lookups : 0.0) << "\n";
+    }
+
+    formatHistogram(os, "cygnal_rtmp_handshake_seconds", _handshake);
+    formatHistogram(os, "cygnal_event_loop_lag_seconds", _loop_lag);
+
+    os << "# TYPE cygnal_thread_cpu_seconds_total counter\n";
+    os << "# TYPE cygnal_thread_lag_max_seconds gauge\n";
+    for (int i = 0; i < MAX_THREADS; i++) {
+	const thread_t &thread = _threads[i];
+	if (!thread.ready.load(std::memory_order_acquire)) {
+	    continue;
+	}
+	os << "cygnal_thread_cpu_seconds_total{thread=\"" << i
+	   << "\",name=\"" << thread.name << "\"} "
+	   << thread.cpu.load(std::memory_order_relaxed) / 1e6 << "\n";
+	os << "cygnal_thread_lag_max_seconds{thread=\"" << i
+	   << "\",name=\"" << thread.name << "\"} "
+	   << thread.lag_max.load(std::memory_order_relaxed) / 1e6 << "\n";
+    }
+
+    // Each open connection, labelled by descriptor and protocol.
+    const char *conn_metrics[] = {
+	"cygnal_connection_bytes_in", "cygnal_connection_bytes_out",
+	"cygnal_connection_messages", "cygnal_connection_queue_depth",
+	"cygnal_connection_age_seconds"
+    };
+    const char *conn_types[] = { "counter", "counter", "counter", "gauge",
+				 "gauge" };
+    const std::uint64_t when = now();
+    for (size_t m = 0; m < sizeof(conn_metrics) / sizeof(conn_metrics[0]); m++) {
+	os << "# TYPE " << conn_metrics[m] << " " << conn_types[m] << "\n";
+	for (int fd = 0; fd < MAX_CONNECTIONS; fd++) {
+	    const connection_t &conn = _connections[fd];
+	    if (!conn.open.load(std::memory_order_acquire)) {
+		continue;
+	    }
+	    os << conn_metrics[m] << "{fd=\"" << fd << "\",protocol=\""
+	       << lookup(protocol_names,
+			 conn.protocol.load(std::memory_order_relaxed))
+	       << "\"} ";
+	    switch (m) {
+	      case 0:
+		  os << conn.bytes_in.load(std::memory_order_relaxed);
+		  break;
+	      case 1:
+		  os << conn.bytes_out.load(std::memory_order_relaxed);
+		  break;
+	      case 2:
+		  os << conn.messages.load(std::memory_order_relaxed);
+		  break;
+	      case 3:
+		  os << conn.queue_depth.load(std::memory_order_relaxed);
+		  break;
+	      default:
+		  os << (when - conn.start.load(std::memory_order_relaxed)) / 1e6;
+		  break;
+	    }
+	    os << "\n";
+	}
+    }
+
+    return os.str();
+}
+
+} // end of gnash namespace
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: t
+// End:
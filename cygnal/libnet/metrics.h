@@ -0,0 +1,216 @@
+//
+//   Copyright (C) 2008, 2009, 2010, 2011, 2012 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#ifndef GNASH_LIBNET_METRICS_H
+#define GNASH_LIBNET_METRICS_H
+
+#include <atomic>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "dsodefs.h" //For DSOEXPORT.
+
+namespace gnash
+{
+
+/// \class Metrics
+///	Live performance counters for the whole server, and for each
+///	connection. These are updated on every read and write, so
+///	every counter is a relaxed atomic that costs one locked add,
+///	and nothing on the hot path ever takes a mutex. Connections
+///	are looked up by their file descriptor in a fixed table, and
+///	the counters shared by all threads have a cache line each.
+///
+///	The counters are only gathered together by format(), which
+///	produces the plain text format used by Prometheus and most
+///	other scrapers. Cygnal serves this as /metrics to local
+///	clients, and from the admin STATUS command.
+class DSOEXPORT Metrics
+{
+public:
+    /// The most connections that are tracked one by one. Descriptors
+    /// past this are only counted in the totals.
+    static const int MAX_CONNECTIONS = 1024;
+    /// The most threads that can report their CPU time.
+    static const int MAX_THREADS = 64;
+    /// RTMP message types are counted by the type byte.
+    static const int RTMP_TYPES = 32;
+    /// HTTP requests are counted by HTTP::http_method_e.
+    static const int HTTP_METHODS = 16;
+
+    typedef enum {
+	CACHE_PATH,
+	CACHE_RESPONSE,
+	CACHE_FILE,
+	CACHE_TYPES
+    } cache_e;
+
+    /// \class Metrics::Histogram
+    ///		A latency histogram with a bucket for each power of two
+    ///		microseconds, from 1us to about 8 seconds. Adding a
+    ///		sample is three atomic adds.
+    class DSOEXPORT Histogram
+    {
+    public:
+	static const int BUCKETS = 24;
+
+	Histogram();
+
+	void add(std::uint64_t usec);
+
+	/// \brief Get the number of samples in one bucket. The last
+	///		bucket is everything too large for the others.
+	std::uint64_t bucket(int index) const
+	    { return _buckets[index].load(std::memory_order_relaxed); }
+	/// \brief Get the upper limit of a bucket in microseconds.
+	static std::uint64_t limit(int index)
+	    { return static_cast<std::uint64_t>(1) << index; }
+	std::uint64_t count() const
+	    { return _count.load(std::memory_order_relaxed); }
+	std::uint64_t sum() const
+	    { return _sum.load(std::memory_order_relaxed); }
+
+    private:
+	std::atomic<std::uint64_t> _buckets[BUCKETS + 1];
+	std::atomic<std::uint64_t> _count;
+	std::atomic<std::uint64_t> _sum;
+    };
+
+    /// \brief Return the single instance used by the whole server.
+    static Metrics &getDefaultInstance();
+
+    /// \brief Get a monotonic time in microseconds, for timing
+    ///		things that will be passed to the histograms.
+    static std::uint64_t now();
+
+    /// \brief Start tracking a newly accepted connection.
+    void opened(int fd);
+    /// \brief Stop tracking a connection that has been closed.
+    void closed(int fd);
+    /// \brief Set the protocol used by a connection.
+    ///
+    /// @param protocol A Network::protocols_supported_e value.
+    void setProtocol(int fd, int protocol);
+
+    void received(int fd, size_t bytes);
+    void sent(int fd, size_t bytes);
+
+    /// \brief Count an HTTP request.
+    ///
+    /// @param method A HTTP::http_method_e value.
+    void httpRequest(int method);
+
+    /// \brief Count an RTMP message.
+    ///
+    /// @param type The RTMP::content_types_e from the header.
+    void rtmpMessage(int fd, int type);
+
+    /// \brief Record how many RTMP chunks are waiting to be processed
+    ///		for a connection.
+    void queueDepth(int fd, size_t depth);
+
+    /// \brief Record how long an RTMP handshake took.
+    void handshake(std::uint64_t usec)
+	{ _handshake.add(usec); }
+
+    void cacheLookup(cache_e cache, bool hit);
+
+    /// \brief Claim a slot to report the CPU time of this thread.
+    ///
+    /// @param name A short name for the kind of thread.
+    ///
+    /// @return The slot, or -1 if there are too many threads already.
+    int addThread(const char *name);
+    void removeThread(int id);
+
+    /// \brief Record the CPU time used so far by the calling thread,
+    ///		which must be the one that claimed the slot.
+    void sampleThread(int id);
+
+    /// \brief Record how long one pass of an event loop took, which is
+    ///		how long a client could wait before being served.
+    void loopLag(int id, std::uint64_t usec);
+
+    /// \brief Format all the counters as text for a scraper.
+    std::string format() const;
+
+private:
+    Metrics();
+
+    /// A counter on its own cache line, so threads counting different
+    /// things don't slow each other down.
+    struct alignas(64) counter_t {
+	std::atomic<std::uint64_t> value;
+    };
+
+    struct alignas(64) connection_t {
+	std::atomic<bool>	   open;
+	std::atomic<int>	   protocol;
+	std::atomic<std::uint64_t> start;
+	std::atomic<std::uint64_t> bytes_in;
+	std::atomic<std::uint64_t> bytes_out;
+	std::atomic<std::uint64_t> messages;
+	std::atomic<std::uint64_t> queue_depth;
+    };
+
+    struct alignas(64) thread_t {
+	/// Set when the slot is claimed.
+	std::atomic<bool>	   used;
+	/// Set once the name has been stored, so format() can read it.
+	std::atomic<bool>	   ready;
+	char			   name[32];
+	std::atomic<std::uint64_t> cpu;
+	std::atomic<std::uint64_t> lag_max;
+    };
+
+    static void add(std::atomic<std::uint64_t> &counter, std::uint64_t n)
+	{ counter.fetch_add(n, std::memory_order_relaxed); }
+
+    connection_t *connection(int fd) {
+	if ((fd < 0) || (fd >= MAX_CONNECTIONS)
+	    || !_connections[fd].open.load(std::memory_order_relaxed)) {
+	    return 0;
+	}
+	return &_connections[fd];
+    }
+
+    std::uint64_t		_start;
+    counter_t			_bytes_in;
+    counter_t			_bytes_out;
+    counter_t			_accepted;
+    counter_t			_closed;
+    std::atomic<std::uint64_t>	_http_requests[HTTP_METHODS];
+    std::atomic<std::uint64_t>	_rtmp_messages[RTMP_TYPES];
+    std::atomic<std::uint64_t>	_cache_lookups[CACHE_TYPES];
+    std::atomic<std::uint64_t>	_cache_hits[CACHE_TYPES];
+    Histogram			_handshake;
+    Histogram			_loop_lag;
+    connection_t		_connections[MAX_CONNECTIONS];
+    thread_t			_threads[MAX_THREADS];
+};
+
+} // end of gnash namespace
+
+// end of GNASH_LIBNET_METRICS_H
+#endif
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: t
+// End:
@@ -66,6 +66,7 @@
 #endif
 
 #include "buffer.h"
+#include "metrics.h"
 #include "GnashException.h"
 
 #ifndef MAXHOSTNAMELEN
@@ -101,7 +102,8 @@ Network::Network()
 	_port(0),
 	_connected(false),
 	_debug(true),
-	_timeout(0)
+	_timeout(0),
+	_reuseport(false)
 {
 //    GNASH_REPORT_FUNCTION;
 #if defined(HAVE_WINSOCK_H) && !defined(__OS2__)
@@ -238,6 +240,21 @@ Network::createServer(std::string hostname, short port)
         freeaddrinfo(ans);          // free the response data
         return -1;
     }
+
+    if (_reuseport) {
+#ifdef SO_REUSEPORT
+        if (setsockopt(_listenfd, SOL_SOCKET, SO_REUSEPORT,
+                       (char *)&on, sizeof(on)) < 0) {
+            log_error(_("setsockopt SO_REUSEPORT failed: %s"), strerror(errno));
+            freeaddrinfo(ans);          // free the response data
+            return -1;
+        }
+#else
+        log_error(_("SO_REUSEPORT isn't supported on this system"));
+        freeaddrinfo(ans);          // free the response data
+        return -1;
+#endif
+    }
     
     retries = 0;
     while (retries < 5) {
@@ -407,6 +424,8 @@ Network::newConnection(bool block, int fd)
 	log_debug(_("Accepting TCP/IP connection on fd #%d for port %d"), _sockfd, _port);
     }
 
+    Metrics::getDefaultInstance().opened(_sockfd);
+
     return _sockfd;
 }
 
@@ -756,6 +775,8 @@ Network::closeNet(int sockfd)
         return true;
     }
 
+    Metrics::getDefaultInstance().closed(sockfd);
+
     while (retries < 3) {
         if (sockfd) {
             // Shutdown the socket connection
@@ -1030,6 +1051,7 @@ Network::readNet(int fd, byte_t *buffer, int nbytes, int timeout)
 	if (_debug) {
 	    log_debug (_("read %d bytes from fd #%d from port %d"), ret, fd, _port);
 	}
+	Metrics::getDefaultInstance().received(fd, ret);
 #if 0
 	if (ret) {
 	    log_debug (_("%s: Read packet data from fd #%d (%d bytes): \n%s"),
@@ -1196,6 +1218,7 @@ Network::writeNet(int fd, const byte_t *buffer, int nbytes, int timeout)
         }
         if (ret > 0) {
             bufptr += ret;
+	    Metrics::getDefaultInstance().sent(fd, ret);
             if (ret != nbytes) {
 		if (_debug) {
 		    log_debug (_("wrote %d bytes to fd #%d, expected %d"),
@@ -1541,6 +1564,7 @@ Network::operator = (Network &net)
     _connected = net.connected();
     _debug = net.netDebug();
     _timeout = net.getTimeout();
+    _reuseport = net.getReusePort();
     return *this;
 }
 
@@ -295,6 +295,13 @@ public:
     void setTimeout(int x) { _timeout = x; }
     int getTimeout() const { return _timeout; }
 
+    /// \brief Let several servers listen on the same port. The kernel
+    ///		then spreads new connections between them, so each can
+    ///		accept and handle its own. This has to be set before
+    ///		calling createServer().
+    void setReusePort(bool x) { _reuseport = x; }
+    bool getReusePort() const { return _reuseport; }
+
     Network &operator = (Network &net);
 
     // The pollfd are an array of data structures used by the poll()
@@ -346,6 +353,7 @@ public:
     bool        _connected;
     bool        _debug;
     int         _timeout;
+    bool        _reuseport;
     size_t	_bytes_loaded;
     /// \var Handler::_handlers
     ///		Keep a list of all active network connections
@@ -42,6 +42,7 @@
 #include "log.h"
 #include "URL.h"
 #include "amf.h"
+#include "AMFStream.h"
 #include "rtmp.h"
 #include "rtmp_server.h"
 #include "network.h"
@@ -53,6 +54,8 @@
 #include "crc.h"
 #include "cache.h"
 #include "diskstream.h"
+#include "metrics.h"
+#include "shard.h"
 #ifdef HAVE_SYS_TIME_H
 # include <sys/time.h>
 #endif 
@@ -65,9 +68,6 @@ namespace cygnal
 // Get access to the global config data for Cygnal
 static CRcInitFile& crcfile = CRcInitFile::getDefaultInstance();
 
-// Get access to the global Cygnal cache
-static Cache& cache = Cache::getDefaultInstance();
-
 extern map<int, Handler *> handlers;
 
 RTMPServer::RTMPServer() 
@@ -96,6 +96,7 @@ RTMPServer::processClientHandShake(int fd)
     GNASH_REPORT_FUNCTION;
 
     log_network("Processing RTMP Handshake for fd #%d", fd);
+    const std::uint64_t handshake_start = Metrics::now();
     
 #ifdef USE_STATISTICS
     struct timespec start;
@@ -276,6 +277,8 @@ RTMPServer::processClientHandShake(int fd)
 	return tcurl;		// nc is empty
     }
 
+    Metrics::getDefaultInstance().handshake(Metrics::now() - handshake_start);
+
     return tcurl;
 }
 
@@ -454,30 +457,25 @@ RTMPServer::packetRead(cygnal::Buffer &buf)
     decodeHeader(ptr);
     ptr += headersize;
 
-    std::uint8_t* tooFar = ptr+300+sizeof(int); // FIXME:
-    
-    AMF amf_obj;
-    std::shared_ptr<cygnal::Element> el1 = amf_obj.extractAMF(ptr, tooFar);
-    ptr += amf_obj.totalsize();
-    std::shared_ptr<cygnal::Element> el2 = amf_obj.extractAMF(ptr, tooFar);
-
-    int size = 0;
-    std::shared_ptr<cygnal::Element> el;
-    while ( size < static_cast<std::uint16_t>(_header.bodysize) - 24 ) {
-	if (ptr) {
-	    el = amf_obj.extractProperty(ptr, tooFar);
-	    if (el != nullptr) {
-		size += amf_obj.totalsize();
-		ptr += amf_obj.totalsize();
-//		_properties[el->getName()] = el;
-	    } else {
+    // Walk over the AMF values at the start of the body. Nothing is
+    // kept from them, so they're skipped by the streaming reader rather
+    // than built into Elements.
+    gnash::amf::StreamReader rd(ptr, buf.end());
+    gnash::amf::StreamHandler skip;
+    try {
+	rd.skip();
+	rd.skip();
+	const std::uint8_t *start = rd.pos();
+	while ((rd.pos() - start) < static_cast<std::uint16_t>(_header.bodysize) - 24) {
+	    if (rd.eof() || !rd.readProperty(skip)) {
 		break;
 	    }
-//		log_network("Bodysize is: %d size is: %d for %s", _total_size, size, el->getName());
-	} else {
-	    break;
+//	    log_network("Bodysize is: %d size is: %d", _total_size, rd.pos() - start);
 	}
+    } catch (const gnash::amf::AMFException &e) {
+	log_network("Stopped reading AMF values in the RTMP body: %s", e.what());
     }
+    ptr = const_cast<std::uint8_t *>(rd.pos());
     
 # if 0
     Element el;
@@ -1240,7 +1238,7 @@ RTMPServer::sendFile(int fd, const std::string &filespec)
 {
     GNASH_REPORT_FUNCTION;
     // See if the file is in the cache and already opened.
-    std::shared_ptr<DiskStream> filestream(cache.findFile(filespec));
+    std::shared_ptr<DiskStream> filestream(Shard::cache().findFile(filespec));
     if (filestream) {
 	cerr << "FIXME: found file in cache!" << endl;
     } else {
@@ -1257,7 +1255,7 @@ RTMPServer::sendFile(int fd, const std::string &filespec)
 	    if (filestream->getFileType() == DiskStream::FILETYPE_NONE) {
 		return false;
 	    } else {
-		cache.addPath(filespec, filestream->getFilespec());
+		Shard::cache().addPath(filespec, filestream->getFilespec());
 	    }
 	}
     }
@@ -1342,6 +1340,45 @@ RTMPServer::sendToClient(std::vector<int> &fds, std::uint8_t *data,
     return ret;
 }
 
+// Send a message to the RTMP clients of an application, except the
+// one it came from.
+static void
+sendToClients(Handler *hand, int from, int channel,
+	      RTMP::content_types_e type, std::uint8_t *data, size_t size)
+{
+    std::vector<int> &clients = hand->getClients();
+    for (size_t i = 0; i < clients.size(); i++) {
+	int fd = clients[i];
+	if ((fd == from) || (hand->getProtocol(fd) != Network::RTMP)) {
+	    continue;
+	}
+	std::shared_ptr<RTMPServer> rtmp = hand->getRTMPHandler(fd);
+	if (rtmp && !rtmp->sendMsg(fd, channel, RTMP::HEADER_12, size, type,
+				   RTMPMsg::FROM_SERVER, data, size)) {
+	    log_error(_("Couldn't relay RTMP type %d to fd #%d"), type, fd);
+	}
+    }
+}
+
+// Send a message from one client to the others connected to the same
+// application, both on this shard and all the others.
+static void
+relay(Handler *hand, int from, const std::string &key,
+      Shard::message_e kind, const RTMP::rtmp_head_t &head,
+      std::uint8_t *data)
+{
+    sendToClients(hand, from, head.channel, head.type, data, head.bodysize);
+
+    Shard::message_t msg;
+    msg.type = kind;
+    msg.key = key;
+    msg.rtmp_type = head.type;
+    msg.channel = head.channel;
+    msg.data.reset(new cygnal::Buffer(head.bodysize));
+    msg.data->copy(data, head.bodysize);
+    Shard::current()->broadcast(msg);
+}
+
 // This is the thread for all incoming RTMP connections
 bool
 rtmp_handler(Network::thread_params_t *args)
@@ -1422,6 +1459,11 @@ rtmp_handler(Network::thread_params_t *args)
 		    // FIXME: send _error result
 		    return false;
 		}
+		size_t depth = 0;
+		for (size_t i=0; i<que->size(); i++) {
+		    depth += que->at(i)->size();
+		}
+		Metrics::getDefaultInstance().queueDepth(args->netfd, depth);
 		std::shared_ptr<RTMP::rtmp_head_t> qhead;
 		for (size_t i=0; i<que->size(); i++) {
 		    std::shared_ptr<cygnal::Buffer> bufptr = que->at(i)->pop();
@@ -1432,6 +1474,7 @@ rtmp_handler(Network::thread_params_t *args)
 			if (!qhead) {
 			    return false;
 			}
+			Metrics::getDefaultInstance().rtmpMessage(args->netfd, qhead->type);
  			// log_network("Message for channel #%d", qhead->channel);
 			tmpptr = bufptr->reference() + qhead->head_size;
 			if (qhead->channel == RTMP_SYSTEM_CHANNEL) {
@@ -1499,12 +1542,27 @@ rtmp_handler(Network::thread_params_t *args)
 			  log_unimpl(_("Set Bandwidth"));
 			  break;
 		      case RTMP::ROUTE:
+			  body = rtmp->decodeMsgBody(tmpptr, qhead->bodysize);
+			  break;
 		      case RTMP::AUDIO_DATA:
 		      case RTMP::VIDEO_DATA:
+			  // Live audio and video goes to everyone else
+			  // connected to the application.
+			  if (Shard::current()) {
+			      relay(hand, args->netfd, args->filespec,
+				    Shard::LIVE_STREAM, *qhead, tmpptr);
+			  }
+			  break;
 		      case RTMP::SHARED_OBJ:
 			  body = rtmp->decodeMsgBody(tmpptr, qhead->bodysize);
-			  log_network("SharedObject name is \"%s\"",
-				      body->getMethodName());
+			  if (body) {
+			      log_network("SharedObject name is \"%s\"",
+					  body->getMethodName());
+			  }
+			  if (Shard::current()) {
+			      relay(hand, args->netfd, args->filespec,
+				    Shard::SHARED_OBJECT, *qhead, tmpptr);
+			  }
 			  break;
 		      case RTMP::AMF3_NOTIFY:
 			  log_unimpl(_("RTMP type %d"), qhead->type);
@@ -1712,11 +1770,23 @@ rtmp_handler(Network::thread_params_t *args)
 	    // initialize = true;
 	    return false;
 	}
-    } while (!done);
+	// A shard polls all its connections, so it only takes one
+	// message from this one at a time.
+    } while (!done && !Shard::current());
     
     return true;
 }
 
+void
+rtmp_deliver(Handler *hand, const Shard::message_t &msg)
+{
+//    GNASH_REPORT_FUNCTION;
+
+    sendToClients(hand, -1, msg.channel,
+		  static_cast<RTMP::content_types_e>(msg.rtmp_type),
+		  msg.data->reference(), msg.data->allocated());
+}
+
 } // end of gnash namespace
 
 // local Variables:
@@ -32,6 +32,7 @@
 #include "buffer.h"
 #include "diskstream.h"
 #include "rtmp_msg.h"
+#include "shard.h"
 #include "dsodefs.h"
 
 namespace cygnal
@@ -151,6 +152,10 @@ private:
 // This is the thread for all incoming RTMP connections
 bool DSOEXPORT rtmp_handler(gnash::Network::thread_params_t *args);
 
+// Send a message from another shard to the clients of the application
+// on this one.
+void DSOEXPORT rtmp_deliver(Handler *hand, const Shard::message_t &msg);
+
 } // end of gnash namespace
 // end of _RTMP_SERVER_H_
 #endif
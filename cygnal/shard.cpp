@@ -0,0 +1,245 @@
+// shard.cpp:  Shared nothing server shards for Cygnal, for Gnash.
+//
+//   Copyright (C) 2008, 2009, 2010, 2011, 2012 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "GnashException.h"
+#include "handler.h"
+#include "shard.h"
+
+using namespace gnash;
+using namespace std;
+
+namespace cygnal
+{
+
+namespace {
+
+// All the shards, which are created before any of them start and never
+// change after that, so they can be read without a lock.
+std::vector<std::unique_ptr<Shard> > shards;
+
+// The shard the calling thread belongs to.
+thread_local Shard *current_shard = 0;
+
+} // anonymous namespace
+
+Shard::Shard(size_t index, size_t count)
+    : _index(index),
+      _next(0)
+{
+//    GNASH_REPORT_FUNCTION;
+    if (pipe(_wakeup) < 0) {
+	throw GnashException(string("Can't create the pipe for shard: ")
+			     + strerror(errno));
+    }
+    // Neither end may block, a full pipe already means there is
+    // something to wake up for.
+    fcntl(_wakeup[0], F_SETFL, O_NONBLOCK);
+    fcntl(_wakeup[1], F_SETFL, O_NONBLOCK);
+
+    _inbox.resize(count);
+    for (size_t i = 0; i < count; i++) {
+	if (i != index) {
+	    _inbox[i].reset(new SPSCQueue<message_t>(INBOX_SIZE));
+	}
+    }
+}
+
+Shard::~Shard()
+{
+//    GNASH_REPORT_FUNCTION;
+    ::close(_wakeup[0]);
+    ::close(_wakeup[1]);
+}
+
+void
+Shard::create(size_t count)
+{
+//    GNASH_REPORT_FUNCTION;
+    shards.clear();
+    for (size_t i = 0; i < count; i++) {
+	shards.push_back(std::unique_ptr<Shard>(new Shard(i, count)));
+    }
+}
+
+size_t
+Shard::count()
+{
+    return shards.size();
+}
+
+Shard *
+Shard::get(size_t index)
+{
+    return (index < shards.size()) ? shards[index].get() : 0;
+}
+
+Shard *
+Shard::current()
+{
+    return current_shard;
+}
+
+void
+Shard::enter()
+{
+    current_shard = this;
+}
+
+Cache &
+Shard::cache()
+{
+    if (current_shard) {
+	return current_shard->_cache;
+    }
+    return Cache::getDefaultInstance();
+}
+
+std::shared_ptr<Handler>
+Shard::findHandler(const std::string &key)
+{
+//    GNASH_REPORT_FUNCTION;
+    std::map<std::string, std::shared_ptr<Handler> >::iterator it;
+    it = _handlers.find(key);
+    if (it != _handlers.end()) {
+	return it->second;
+    }
+    return std::shared_ptr<Handler>();
+}
+
+void
+Shard::addHandler(const std::string &key, std::shared_ptr<Handler> hand)
+{
+//    GNASH_REPORT_FUNCTION;
+    _handlers[key] = hand;
+}
+
+void
+Shard::removeHandler(const std::string &key)
+{
+//    GNASH_REPORT_FUNCTION;
+    _handlers.erase(key);
+}
+
+size_t
+Shard::broadcast(const message_t &msg)
+{
+//    GNASH_REPORT_FUNCTION;
+    size_t sent = 0;
+    for (size_t i = 0; i < shards.size(); i++) {
+	if (i == _index) {
+	    continue;
+	}
+	Shard *shard = shards[i].get();
+	if (!shard->_inbox[_index]->push(msg)) {
+	    log_error(_("Shard #%d dropped a message for shard #%d, its queue is full"),
+		      _index, i);
+	    continue;
+	}
+	shard->wake();
+	sent++;
+    }
+
+    return sent;
+}
+
+void
+Shard::wake()
+{
+    // Only the wakeup matters, so a full pipe is fine.
+    char byte = 0;
+    if (::write(_wakeup[1], &byte, 1) < 0) {
+	if (errno != EAGAIN) {
+	    log_error(_("Couldn't wake up shard #%d: %s"), _index, strerror(errno));
+	}
+    }
+}
+
+void
+Shard::handOff(const connection_t &conn)
+{
+//    GNASH_REPORT_FUNCTION;
+    {
+	std::lock_guard<std::mutex> lock(_connections_mutex);
+	_connections.push_back(conn);
+    }
+    wake();
+}
+
+bool
+Shard::takeConnection(connection_t &conn)
+{
+//    GNASH_REPORT_FUNCTION;
+    // receive() has emptied the pipe, so a connection handed off
+    // after this leaves a byte in it to wake us up for it.
+    std::lock_guard<std::mutex> lock(_connections_mutex);
+    if (_connections.empty()) {
+	return false;
+    }
+    conn = _connections.front();
+    _connections.pop_front();
+    return true;
+}
+
+bool
+Shard::pop(message_t &msg)
+{
+    for (size_t n = 0; n < _inbox.size(); n++) {
+	size_t i = _next;
+	_next = (_next + 1) % _inbox.size();
+	if (_inbox[i] && _inbox[i]->pop(msg)) {
+	    return true;
+	}
+    }
+    return false;
+}
+
+bool
+Shard::receive(message_t &msg)
+{
+//    GNASH_REPORT_FUNCTION;
+    if (pop(msg)) {
+	return true;
+    }
+
+    // Empty the pipe, and then look again, so a message queued while
+    // doing this either gets found now, or leaves a byte in the pipe
+    // to wake us up for it.
+    char bytes[64];
+    while (::read(_wakeup[0], bytes, sizeof(bytes)) > 0) {
+    }
+
+    return pop(msg);
+}
+
+} // end of cygnal namespace
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: t
+// End:
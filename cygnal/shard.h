@@ -0,0 +1,190 @@
+//
+//   Copyright (C) 2008, 2009, 2010, 2011, 2012 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#ifndef __SHARD_H__
+#define __SHARD_H__ 1
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+#include "buffer.h"
+#include "cache.h"
+#include "lfqueue.h"
+#include "dsodefs.h" //For DSOEXPORT.
+
+namespace cygnal
+{
+
+class Handler;
+class RTMPServer;
+
+/// \class cygnal::Shard
+///	A shard is one thread that listens on the same ports as all
+///	the others, with SO_REUSEPORT, so the kernel spreads the new
+///	connections between them. Each shard owns the connections it
+///	accepts, along with its own Handlers and cache, so nothing
+///	is locked between shards. The only thing
+///	they share is what they send each other as messages, which is
+///	how shared object updates and live streams reach the clients
+///	connected to the other shards.
+///
+///	Each shard has a queue for every other shard, so every queue
+///	has one producer and one consumer, and needs no lock.
+///
+///	The RTMP handshake waits for the client, so it isn't done in
+///	the shard's own thread. Connections are handed back to the
+///	shard once their handshake is done.
+class DSOEXPORT Shard
+{
+public:
+    /// The type of a message sent between shards.
+    typedef enum {
+	SHARED_OBJECT,		// an update to a shared object
+	LIVE_STREAM		// audio or video from a published stream
+    } message_e;
+
+    /// \struct Shard::message_t
+    ///		A message for the clients of one application on the
+    ///		other shards.
+    struct message_t {
+	message_t() : type(LIVE_STREAM), rtmp_type(0), channel(0) { }
+	message_e	type;
+	/// The key of the Handler for the application.
+	std::string	key;
+	/// The RTMP::content_types_e to send it to the clients as.
+	std::uint8_t	rtmp_type;
+	int		channel;
+	std::shared_ptr<cygnal::Buffer> data;
+    };
+
+    /// \struct Shard::connection_t
+    ///		An RTMP connection accepted by the shard, whose
+    ///		handshake is done.
+    struct connection_t {
+	connection_t() : fd(-1), port(0) { }
+	int		fd;
+	short		port;
+	std::shared_ptr<RTMPServer> rtmp;
+	/// The tcUrl the client connected to.
+	std::string	tcurl;
+    };
+
+    /// The most messages from one shard to another that can be
+    /// waiting. Any more are dropped, as a slow shard shouldn't be
+    /// able to stall the others.
+    static const size_t INBOX_SIZE = 1024;
+
+    ~Shard();
+
+    /// \brief Create all the shards. This has to be done before any
+    ///		of them are started.
+    static void create(size_t count);
+    static size_t count();
+    static Shard *get(size_t index);
+
+    /// \brief Get the shard the calling thread belongs to.
+    ///
+    /// @return The shard, or 0 when not sharding.
+    static Shard *current();
+
+    /// \brief Make the calling thread part of this shard.
+    void enter();
+
+    /// \brief Get the cache for the calling thread, which is its
+    ///		shard's own cache, or the global one when not sharding.
+    static gnash::Cache &cache();
+
+    size_t getIndex() const { return _index; }
+
+    std::shared_ptr<Handler> findHandler(const std::string &key);
+    void addHandler(const std::string &key, std::shared_ptr<Handler> hand);
+    void removeHandler(const std::string &key);
+
+    /// \brief Send a message to every other shard. This may only be
+    ///		called by the thread running this shard.
+    ///
+    /// @return The number of shards the message was sent to.
+    size_t broadcast(const message_t &msg);
+
+    /// \brief Take the next message sent by another shard. This may
+    ///		only be called by the thread running this shard.
+    ///
+    /// @return false if there aren't any messages waiting.
+    bool receive(message_t &msg);
+
+    /// \brief Hand a connection back to this shard once its
+    ///		handshake is done. This may be called by any thread.
+    void handOff(const connection_t &conn);
+
+    /// \brief Take the next connection handed back to this shard.
+    ///		This may only be called by the thread running this
+    ///		shard, after receive() has returned false.
+    ///
+    /// @return false if there aren't any connections waiting.
+    bool takeConnection(connection_t &conn);
+
+    /// \brief Get the file descriptor to poll for, which is readable
+    ///		when there are messages or connections waiting.
+    int getWakeupFd() const { return _wakeup[0]; }
+
+private:
+    Shard(size_t index, size_t count);
+
+    bool pop(message_t &msg);
+
+    /// Make the wakeup pipe readable.
+    void wake();
+
+    /// \var Shard::_index
+    ///		The position of this shard, which is also the queue it
+    ///		writes to on every other shard.
+    size_t	_index;
+    gnash::Cache _cache;
+    std::map<std::string, std::shared_ptr<Handler> > _handlers;
+    /// \var Shard::_inbox
+    ///		The messages from each of the other shards, indexed by
+    ///		the sending shard.
+    std::vector<std::unique_ptr<gnash::SPSCQueue<message_t> > > _inbox;
+    /// \var Shard::_next
+    ///		The next queue to look at, so a busy shard can't
+    ///		starve the others.
+    size_t	_next;
+    /// \var Shard::_connections
+    ///		The connections handed back to this shard. Any thread
+    ///		may add one, so unlike the inboxes this is locked.
+    std::deque<connection_t> _connections;
+    std::mutex	_connections_mutex;
+    /// \var Shard::_wakeup
+    ///		A pipe written to after each message or connection is
+    ///		queued, so the shard wakes up from poll().
+    int		_wakeup[2];
+};
+
+} // end of cygnal namespace
+
+#endif // end of __SHARD_H__
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: t
+// End:
@@ -0,0 +1,318 @@
+//
+//   Copyright (C) 2005, 2006, 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+
+#ifdef HAVE_DEJAGNU_H
+#include "dejagnu.h"
+#else
+#include "check.h"
+#endif
+
+#include "log.h"
+#include "buffer.h"
+#include "network.h"
+#include "shard.h"
+
+using namespace std;
+using namespace gnash;
+using namespace cygnal;
+
+TestState runtest;
+
+static void test_messages();
+static void test_full();
+static void test_fairness();
+static void test_handoff();
+static void test_distribution();
+
+// Whether there is something to read on a file descriptor, waiting at
+// most the given number of milliseconds.
+static bool
+readable(int fd, int timeout)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return (poll(&pfd, 1, timeout) > 0) && (pfd.revents & POLLIN);
+}
+
+int
+main (int /*argc*/, char** /*argv*/) {
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    Shard::create(3);
+    if ((Shard::count() == 3) && Shard::get(2) && !Shard::get(3)) {
+        runtest.pass("Shard::create()");
+    } else {
+        runtest.fail("Shard::create()");
+    }
+
+    if (!Shard::current()) {
+        runtest.pass("Shard::current() when not sharding");
+    } else {
+        runtest.fail("Shard::current() when not sharding");
+    }
+
+    test_messages();
+    test_full();
+    test_fairness();
+    test_handoff();
+    test_distribution();
+
+    // Each thread is in its own shard.
+    Shard::get(1)->enter();
+    Shard *other = 0;
+    std::thread t([&other]() { Shard::get(2)->enter(); other = Shard::current(); });
+    t.join();
+    if ((Shard::current() == Shard::get(1)) && (other == Shard::get(2))) {
+        runtest.pass("Shard::enter()");
+    } else {
+        runtest.fail("Shard::enter()");
+    }
+}
+
+// A message sent by one shard reaches all the others, and only them.
+static void
+test_messages()
+{
+    Shard *from = Shard::get(0);
+    Shard::message_t msg;
+    msg.type = Shard::SHARED_OBJECT;
+    msg.key = "localhost/oflaDemo";
+    msg.rtmp_type = 19;
+    msg.channel = 3;
+    msg.data.reset(new Buffer(10));
+    *msg.data += "hello";
+
+    if (from->broadcast(msg) == 2) {
+        runtest.pass("Shard::broadcast()");
+    } else {
+        runtest.fail("Shard::broadcast()");
+    }
+
+    bool woken = true;
+    bool received = true;
+    for (size_t i = 1; i < 3; i++) {
+        Shard *to = Shard::get(i);
+        woken = woken && readable(to->getWakeupFd(), 0);
+        Shard::message_t got;
+        received = received && to->receive(got)
+            && (got.type == Shard::SHARED_OBJECT) && (got.key == msg.key)
+            && (got.rtmp_type == 19)
+            && (got.channel == 3) && (got.data == msg.data)
+            && !to->receive(got) && !readable(to->getWakeupFd(), 0);
+    }
+    if (woken) {
+        runtest.pass("Shard::getWakeupFd() with messages waiting");
+    } else {
+        runtest.fail("Shard::getWakeupFd() with messages waiting");
+    }
+    if (received) {
+        runtest.pass("Shard::receive()");
+    } else {
+        runtest.fail("Shard::receive()");
+    }
+
+    Shard::message_t got;
+    if (!from->receive(got)) {
+        runtest.pass("Shard::broadcast() doesn't send to itself");
+    } else {
+        runtest.fail("Shard::broadcast() doesn't send to itself");
+    }
+}
+
+// A shard that doesn't keep up loses messages, rather than stalling the
+// one sending them.
+static void
+test_full()
+{
+    Shard *from = Shard::get(0);
+    Shard::message_t msg;
+    for (size_t i = 0; i < Shard::INBOX_SIZE; i++) {
+        from->broadcast(msg);
+    }
+    if (from->broadcast(msg) == 0) {
+        runtest.pass("Shard::broadcast() to full queues");
+    } else {
+        runtest.fail("Shard::broadcast() to full queues");
+    }
+
+    size_t received = 0;
+    while (Shard::get(1)->receive(msg)) {
+        received++;
+    }
+    while (Shard::get(2)->receive(msg)) {
+    }
+    if (received == Shard::INBOX_SIZE) {
+        runtest.pass("Shard::receive() from a full queue");
+    } else {
+        runtest.fail("Shard::receive() from a full queue");
+    }
+}
+
+// The messages of a busy shard don't hold up those of the others.
+static void
+test_fairness()
+{
+    Shard *to = Shard::get(0);
+    for (size_t from = 1; from < 3; from++) {
+        Shard::message_t msg;
+        msg.key = std::to_string(from);
+        for (int i = 0; i < 3; i++) {
+            Shard::get(from)->broadcast(msg);
+        }
+    }
+    std::string order;
+    Shard::message_t msg;
+    while (to->receive(msg)) {
+        order += msg.key;
+    }
+    if ((order == "121212") || (order == "212121")) {
+        runtest.pass("Shard::receive() takes turns between shards");
+    } else {
+        runtest.fail("Shard::receive() takes turns between shards: " + order);
+    }
+
+    // Leave nothing behind for the other tests.
+    Shard *other = Shard::get(1);
+    while (other->receive(msg)) {
+    }
+    other = Shard::get(2);
+    while (other->receive(msg)) {
+    }
+}
+
+// A connection handed back by another thread wakes the shard up.
+static void
+test_handoff()
+{
+    Shard *shard = Shard::get(1);
+    std::thread handshake([shard]() {
+        Shard::connection_t conn;
+        conn.fd = 42;
+        conn.port = 1935;
+        conn.tcurl = "rtmp://localhost/oflaDemo";
+        shard->handOff(conn);
+    });
+
+    const bool woken = readable(shard->getWakeupFd(), 5000);
+    handshake.join();
+    if (woken) {
+        runtest.pass("Shard::handOff() wakes the shard");
+    } else {
+        runtest.fail("Shard::handOff() wakes the shard");
+    }
+
+    Shard::message_t msg;
+    Shard::connection_t conn;
+    if (!shard->receive(msg) && shard->takeConnection(conn)
+        && (conn.fd == 42) && (conn.port == 1935)
+        && (conn.tcurl == "rtmp://localhost/oflaDemo")
+        && !shard->takeConnection(conn)) {
+        runtest.pass("Shard::takeConnection()");
+    } else {
+        runtest.fail("Shard::takeConnection()");
+    }
+}
+
+// Servers on the same port with SO_REUSEPORT each get some of the
+// connections.
+static void
+test_distribution()
+{
+    const short port = 20000 + getpid() % 10000;
+    Network net1, net2;
+    net1.setReusePort(true);
+    net2.setReusePort(true);
+    const int fd1 = net1.createServer("127.0.0.1", port);
+    const int fd2 = net2.createServer("127.0.0.1", port);
+    if ((fd1 <= 0) || (fd2 <= 0)) {
+        runtest.unresolved("Can't listen twice on the same port");
+        return;
+    }
+
+    // The servers only queue a few connections, so they are accepted as
+    // they come in, or the next connect waits for a free slot.
+    const int connections = 32;
+    std::vector<int> clients;
+    int accepted1 = 0;
+    int accepted2 = 0;
+    for (int i = 0; i < connections; i++) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                      sizeof(addr)) < 0) {
+            ::close(fd);
+            continue;
+        }
+        clients.push_back(fd);
+        while (readable(fd1, 0) || readable(fd2, 0)) {
+            if (readable(fd1, 0)) {
+                ::close(::accept(fd1, 0, 0));
+                accepted1++;
+            }
+            if (readable(fd2, 0)) {
+                ::close(::accept(fd2, 0, 0));
+                accepted2++;
+            }
+        }
+    }
+    for (size_t i = 0; i < clients.size(); i++) {
+        ::close(clients[i]);
+    }
+
+    if ((clients.size() == static_cast<size_t>(connections))
+        && (accepted1 + accepted2 == connections)) {
+        runtest.pass("All connections accepted with SO_REUSEPORT");
+    } else {
+        runtest.fail("All connections accepted with SO_REUSEPORT");
+    }
+    if ((accepted1 > 0) && (accepted2 > 0)) {
+        runtest.pass("Connections spread between servers with SO_REUSEPORT");
+    } else {
+        runtest.fail("Connections spread between servers with SO_REUSEPORT");
+    }
+}
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
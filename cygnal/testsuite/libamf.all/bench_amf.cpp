@@ -0,0 +1,178 @@
+//
+//   Copyright (C) 2008, 2009, 2010, 2011, 2012 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+// Compare encoding and decoding an RTMP connect message through the
+// Element tree with the streaming reader and writer. This isn't run as
+// part of the testsuite, run it by hand with an optional message count.
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+
+#include "log.h"
+#include "AMF.h"
+#include "AMFStream.h"
+#include "SimpleBuffer.h"
+#include "buffer.h"
+#include "element.h"
+#include "amf.h"
+
+using namespace gnash;
+using namespace std;
+
+namespace {
+
+void
+report(const char *name, size_t count, std::chrono::steady_clock::duration d)
+{
+    const double secs = std::chrono::duration<double>(d).count();
+    cout << setw(32) << left << name << setw(10) << right
+         << fixed << setprecision(3) << secs * 1000 << " ms  "
+         << setw(12) << static_cast<size_t>(count / secs) << " msgs/sec"
+         << endl;
+}
+
+// Count what was read, so the work can't be optimized away.
+class Counter : public amf::StreamHandler
+{
+public:
+    Counter() : values(0) {}
+    virtual void number(double) { ++values; }
+    virtual void boolean(bool) { ++values; }
+    virtual void string(const amf::StringRef&) { ++values; }
+    virtual void null() { ++values; }
+    size_t values;
+};
+
+template<typename Buf>
+void
+writeConnect(amf::StreamWriter<Buf>& w)
+{
+    w.string("connect").number(1).startObject()
+        .property("app").string("oflaDemo")
+        .property("flashVer").string("LNX 10,0,22,87")
+        .property("swfUrl").string("http://localhost/test.swf")
+        .property("tcUrl").string("rtmp://localhost/oflaDemo")
+        .property("fpad").boolean(false)
+        .property("capabilities").number(15)
+        .property("audioCodecs").number(3191)
+        .property("videoCodecs").number(252)
+        .property("videoFunction").number(1)
+        .property("pageUrl").string("http://localhost/index.html")
+        .endObject();
+}
+
+std::shared_ptr<cygnal::Element>
+makeConnect()
+{
+    std::shared_ptr<cygnal::Element> top(new cygnal::Element);
+    top->makeObject();
+    std::shared_ptr<cygnal::Element> el;
+#define PROP(call) el.reset(new cygnal::Element); el->call; top->addProperty(el)
+    PROP(makeString("app", "oflaDemo"));
+    PROP(makeString("flashVer", "LNX 10,0,22,87"));
+    PROP(makeString("swfUrl", "http://localhost/test.swf"));
+    PROP(makeString("tcUrl", "rtmp://localhost/oflaDemo"));
+    PROP(makeBoolean("fpad", false));
+    PROP(makeNumber("capabilities", 15));
+    PROP(makeNumber("audioCodecs", 3191));
+    PROP(makeNumber("videoCodecs", 252));
+    PROP(makeNumber("videoFunction", 1));
+    PROP(makeString("pageUrl", "http://localhost/index.html"));
+#undef PROP
+    return top;
+}
+
+} // anonymous namespace
+
+int
+main(int argc, char *argv[])
+{
+    size_t count = 200000;
+    if (argc > 1) {
+        count = std::strtoul(argv[1], 0, 10);
+    }
+
+    cout << "Encoding and decoding " << count << " connect messages" << endl;
+
+    size_t sink = 0;
+    std::chrono::steady_clock::time_point start;
+
+    // Encoding.
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        std::shared_ptr<cygnal::Element> top = makeConnect();
+        std::shared_ptr<cygnal::Buffer> name =
+            cygnal::AMF::encodeString("connect");
+        std::shared_ptr<cygnal::Buffer> num = cygnal::AMF::encodeNumber(1);
+        std::shared_ptr<cygnal::Buffer> obj = cygnal::AMF::encodeObject(*top);
+        sink += name->allocated() + num->allocated() + obj->allocated();
+    }
+    report("Element encode", count, std::chrono::steady_clock::now() - start);
+
+    SimpleBuffer buf;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        buf.resize(0);
+        amf::StreamWriter<SimpleBuffer> w(buf);
+        writeConnect(w);
+        sink += buf.size();
+    }
+    report("StreamWriter encode", count,
+           std::chrono::steady_clock::now() - start);
+
+    // Decoding the same bytes.
+    cygnal::Buffer cbuf(buf.size());
+    cbuf.copy(buf.data(), buf.size());
+    cygnal::AMF amf;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        std::uint8_t *ptr = cbuf.reference();
+        for (int j = 0; j < 3; ++j) {
+            std::shared_ptr<cygnal::Element> el =
+                amf.extractAMF(ptr, cbuf.end());
+            ptr += amf.totalsize();
+            sink += el->getDataSize();
+        }
+    }
+    report("Element decode", count, std::chrono::steady_clock::now() - start);
+
+    Counter counter;
+    amf::StreamReader rd(buf.data(), buf.data() + buf.size());
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        rd.reset(buf.data(), buf.data() + buf.size());
+        while (rd(counter)) {}
+    }
+    report("StreamReader decode", count,
+           std::chrono::steady_clock::now() - start);
+
+    // Keep the results live.
+    return (sink + counter.values) == 0;
+}
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
@@ -0,0 +1,284 @@
+//
+//   Copyright (C) 2008, 2009, 2010, 2011, 2012 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdint>
+#include <memory>
+
+#ifdef HAVE_DEJAGNU_H
+#include "dejagnu.h"
+#else
+#include "check.h"
+#endif
+
+#include "log.h"
+#include "AMF.h"
+#include "AMFStream.h"
+#include "SimpleBuffer.h"
+#include "buffer.h"
+#include "element.h"
+#include "amf.h"
+
+using namespace gnash;
+using namespace std;
+
+TestState runtest;
+
+namespace {
+
+// Record every event as text, so a whole message can be compared at once.
+class Recorder : public amf::StreamHandler
+{
+public:
+    virtual void number(double d) { _s << "n:" << d << " "; }
+    virtual void integer(std::int32_t i) { _s << "i:" << i << " "; }
+    virtual void boolean(bool b) { _s << "b:" << b << " "; }
+    virtual void string(const amf::StringRef& s) { _s << "s:" << s << " "; }
+    virtual void null() { _s << "null "; }
+    virtual void undefined() { _s << "undef "; }
+    virtual void reference(size_t i) { _s << "ref:" << i << " "; }
+    virtual void date(double ms) { _s << "date:" << ms << " "; }
+    virtual void startObject(const amf::StringRef& c) { _s << "{" << c << " "; }
+    virtual void endObject() { _s << "} "; }
+    virtual void startArray(size_t n) { _s << "[" << n << " "; }
+    virtual void startECMAArray(size_t n) { _s << "<" << n << " "; }
+    virtual void endArray() { _s << "] "; }
+    virtual void property(const amf::StringRef& n) { _s << n << "="; }
+    virtual void unsupported(std::uint8_t t) { _s << "?" << int(t) << " "; }
+
+    std::string str() const { return _s.str(); }
+
+private:
+    std::ostringstream _s;
+};
+
+std::string
+readAll(const std::uint8_t* pos, const std::uint8_t* end)
+{
+    Recorder r;
+    amf::StreamReader rd(pos, end);
+    while (rd(r)) {}
+    return r.str();
+}
+
+std::string
+readAll(const SimpleBuffer& buf)
+{
+    return readAll(buf.data(), buf.data() + buf.size());
+}
+
+// Whether reading the bytes throws an amf::AMFException.
+bool
+rejects(const std::uint8_t* data, size_t size)
+{
+    try {
+        readAll(data, data + size);
+    }
+    catch (const amf::AMFException&) {
+        return true;
+    }
+    return false;
+}
+
+void
+test_amf0()
+{
+    SimpleBuffer buf;
+    amf::StreamWriter<SimpleBuffer> w(buf);
+    w.string("connect").number(1).startObject()
+        .property("app").string("vod")
+        .property("fpad").boolean(false)
+        .property("audioCodecs").number(3191)
+        .endObject()
+        .null().undefined().reference(2).date(1000);
+
+    check_equals(readAll(buf),
+        "s:connect n:1 { app=s:vod fpad=b:0 audioCodecs=n:3191 } "
+        "null undef ref:2 date:1000 ");
+
+    buf.resize(0);
+    w.startECMAArray(2).property("a").number(1).property("b").string("x")
+        .endECMAArray()
+        .startStrictArray(3).number(1).number(2).number(3)
+        .startTypedObject("Point").property("x").number(4).endObject();
+    check_equals(readAll(buf),
+        "<2 a=n:1 b=s:x ] [3 n:1 n:2 n:3 ] {Point x=n:4 } ");
+
+    // A long string switches to the 4-byte length type.
+    buf.resize(0);
+    const std::string big(70000, 'x');
+    w.string(big);
+    check_equals(buf.size(), big.size() + 5);
+    check_equals(buf.data()[0], amf::LONG_STRING_AMF0);
+    amf::StreamReader rd(buf.data(), buf.data() + buf.size());
+    Recorder r;
+    check(rd(r));
+    check(rd.eof());
+    check_equals(r.str().size(), big.size() + 3);
+
+    // skip() and readProperty() let a caller walk past what it doesn't
+    // want.
+    buf.resize(0);
+    w.number(5).startObject().property("k").string("v").endObject()
+        .string("last");
+    rd.reset(buf.data(), buf.data() + buf.size());
+    check(rd.skip());
+    check(rd.skip());
+    Recorder last;
+    check(rd(last));
+    check_equals(last.str(), "s:last ");
+    check(!rd.skip());
+}
+
+void
+test_amf3()
+{
+    SimpleBuffer buf;
+    amf::StreamWriter<SimpleBuffer> w(buf);
+    w.integer3(0).integer3(127).integer3(128).integer3(0x3fff)
+        .integer3(0x4000).integer3(0x1fffff).integer3(0x200000)
+        .integer3(-1).integer3(0x0fffffff).integer3(0x10000000)
+        .number3(0.5).string3("abc").boolean3(true).boolean3(false)
+        .null3();
+    check_equals(readAll(buf),
+        "i:0 i:127 i:128 i:16383 i:16384 i:2097151 i:2097152 i:-1 "
+        "i:268435455 n:2.68435e+08 n:0.5 s:abc b:1 b:0 null ");
+
+    // An AMF3 object with sealed and dynamic members, a string reference
+    // and a trait reference.
+    const std::uint8_t obj[] = {
+        amf::AVMPLUS_OBJECT_AMF0, amf::ARRAY_AMF3,
+        0x05,                           // two dense elements
+        0x01,                           // no associative part
+        amf::OBJECT_AMF3,
+        0x1b,                           // inline traits, dynamic, one member
+        0x0b, 'P', 'o', 'i', 'n', 't',  // class name
+        0x03, 'x',                      // sealed member name
+        amf::INTEGER_AMF3, 0x01,        // x = 1
+        0x03, 'y',                      // dynamic member name
+        amf::STRING_AMF3, 0x02,         // y = "x" by reference
+        0x01,                           // end of dynamic members
+        amf::OBJECT_AMF3,
+        0x01,                           // traits reference 0
+        amf::INTEGER_AMF3, 0x02,        // x = 2
+        0x01,
+        amf::OBJECT_AMF3, 0x02          // reference to the first object
+    };
+    check_equals(readAll(obj, obj + sizeof(obj) - 2),
+        "[2 {Point x=i:1 y=s:x } {Point x=i:2 } ] ");
+
+    // Add the trailing object reference as the last array element.
+    std::uint8_t withRef[sizeof(obj)];
+    std::copy(obj, obj + sizeof(obj), withRef);
+    withRef[2] = 0x07;
+    check_equals(readAll(withRef, withRef + sizeof(withRef)),
+        "[3 {Point x=i:1 y=s:x } {Point x=i:2 } ref:1 ] ");
+}
+
+// Element trees encoded by the old AMF class decode to the same values.
+void
+test_element()
+{
+    cygnal::Element top;
+    top.makeObject("app");
+    std::shared_ptr<cygnal::Element> app(new cygnal::Element);
+    app->makeString("app", "oflaDemo");
+    top.addProperty(app);
+    std::shared_ptr<cygnal::Element> caps(new cygnal::Element);
+    caps->makeNumber("capabilities", 15);
+    top.addProperty(caps);
+
+    std::shared_ptr<cygnal::Buffer> enc = cygnal::AMF::encodeObject(top);
+    check_equals(readAll(enc->reference(), enc->reference() + enc->allocated()),
+        "{ app=s:oflaDemo capabilities=n:15 } ");
+
+    // And the writer can append to a cygnal::Buffer.
+    cygnal::Buffer out(4);
+    amf::StreamWriter<cygnal::Buffer> w(out);
+    w.startObject().property("app").string("oflaDemo")
+        .property("capabilities").number(15).endObject();
+    check_equals(out.allocated(), enc->allocated());
+    check(!memcmp(out.reference(), enc->reference(), enc->allocated()));
+
+    cygnal::AMF amf;
+    std::shared_ptr<cygnal::Element> el =
+        amf.extractAMF(out.reference(), out.end());
+    check(el);
+    if (el) {
+        check_equals(el->propertySize(), 2u);
+    }
+}
+
+void
+test_malformed()
+{
+    // Truncated number.
+    const std::uint8_t a[] = { amf::NUMBER_AMF0, 0x40, 0x00 };
+    check(rejects(a, sizeof(a)));
+
+    // String longer than the buffer.
+    const std::uint8_t b[] = { amf::STRING_AMF0, 0x00, 0x10, 'a', 'b' };
+    check(rejects(b, sizeof(b)));
+
+    // Unknown type.
+    const std::uint8_t c[] = { 0x7f };
+    check(rejects(c, sizeof(c)));
+
+    // Object without an end marker.
+    const std::uint8_t d[] = { amf::OBJECT_AMF0, 0x00, 0x01, 'a', amf::NULL_AMF0 };
+    check(rejects(d, sizeof(d)));
+
+    // AMF3 string reference that was never defined.
+    const std::uint8_t e[] = { amf::AVMPLUS_OBJECT_AMF0, amf::STRING_AMF3, 0x04 };
+    check(rejects(e, sizeof(e)));
+
+    // Nesting deep enough to exhaust the stack.
+    std::vector<std::uint8_t> deep(10000, amf::STRICT_ARRAY_AMF0);
+    for (size_t i = 0; i < deep.size(); i += 5) {
+        deep[i + 1] = deep[i + 2] = deep[i + 3] = 0;
+        deep[i + 4] = 1;
+    }
+    check(rejects(&deep[0], deep.size()));
+}
+
+} // anonymous namespace
+
+int
+main(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    test_amf0();
+    test_amf3();
+    test_element();
+    test_malformed();
+
+    return 0;
+}
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
@@ -0,0 +1,192 @@
+//
+//   Copyright (C) 2008, 2009, 2010, 2011, 2012 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+// Measure how many buffers per second can be passed between threads
+// through the packet queues. This isn't run as part of the testsuite,
+// run it by hand with an optional message count.
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+
+#include "log.h"
+#include "buffer.h"
+#include "cque.h"
+#include "lfqueue.h"
+
+using namespace gnash;
+using namespace std;
+
+namespace {
+
+typedef std::shared_ptr<cygnal::Buffer> buf_t;
+
+// The old implementation, a deque with a lock taken on every access.
+class LockedQueue {
+public:
+    bool push(const buf_t &buf) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _que.push_back(buf);
+        return true;
+    }
+    buf_t pop() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        buf_t buf;
+        if (_que.size()) {
+            buf = _que.front();
+            _que.pop_front();
+        }
+        return buf;
+    }
+private:
+    std::deque<buf_t> _que;
+    std::mutex _mutex;
+};
+
+void
+report(const char *name, size_t count, std::chrono::steady_clock::duration d)
+{
+    const double secs = std::chrono::duration<double>(d).count();
+    cout << setw(32) << left << name << setw(10) << right
+         << fixed << setprecision(3) << secs * 1000 << " ms  "
+         << setw(12) << static_cast<size_t>(count / secs) << " msgs/sec"
+         << endl;
+}
+
+// Run producers and consumers against a queue offering push() and pop(),
+// where pop() returns an empty pointer when there's nothing to take.
+// Each producer cycles through its own buffers, so the threads don't
+// all fight over one reference count.
+template <typename Q>
+void
+run(const char *name, Q &que, size_t producers, size_t consumers,
+    size_t count, const std::vector<std::vector<buf_t> > &bufs)
+{
+    const size_t each = count / producers;
+    const size_t total = each * producers;
+    std::atomic<size_t> received(0);
+
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < consumers; ++i) {
+        threads.push_back(std::thread([&que, &received, total] {
+            while (received.load(std::memory_order_relaxed) < total) {
+                if (que.pop()) {
+                    received.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    for (size_t i = 0; i < producers; ++i) {
+        const std::vector<buf_t> &mine = bufs[i];
+        threads.push_back(std::thread([&que, &mine, each] {
+            for (size_t j = 0; j < each; ++j) {
+                que.push(mine[j % mine.size()]);
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    report(name, total, std::chrono::steady_clock::now() - start);
+}
+
+// Adapt the raw rings to the same interface, spinning when full.
+template <typename R>
+class Ring {
+public:
+    explicit Ring(size_t size) : _ring(size) { }
+    bool push(const buf_t &buf) {
+        while (!_ring.push(buf)) {
+            std::this_thread::yield();
+        }
+        return true;
+    }
+    buf_t pop() {
+        buf_t buf;
+        _ring.pop(buf);
+        return buf;
+    }
+private:
+    R _ring;
+};
+
+} // anonymous namespace
+
+int
+main(int argc, char *argv[])
+{
+    size_t count = 1000000;
+    if (argc > 1) {
+        count = std::strtoul(argv[1], 0, 10);
+    }
+    std::vector<std::vector<buf_t> > bufs(4);
+    for (size_t i = 0; i < bufs.size(); ++i) {
+        for (size_t j = 0; j < 256; ++j) {
+            bufs[i].push_back(buf_t(new cygnal::Buffer(64)));
+        }
+    }
+
+    cout << "Passing " << count << " buffers between threads" << endl;
+
+    {
+        LockedQueue que;
+        run("mutex deque, 1P/1C", que, 1, 1, count, bufs);
+    }
+    {
+        Ring<SPSCQueue<buf_t> > que(1024);
+        run("SPSCQueue, 1P/1C", que, 1, 1, count, bufs);
+    }
+    {
+        CQue que("bench", CQue::SPSC, 1024);
+        run("CQue(SPSC), 1P/1C", que, 1, 1, count, bufs);
+    }
+    {
+        LockedQueue que;
+        run("mutex deque, 4P/4C", que, 4, 4, count, bufs);
+    }
+    {
+        Ring<MPMCQueue<buf_t> > que(1024);
+        run("MPMCQueue, 4P/4C", que, 4, 4, count, bufs);
+    }
+    {
+        CQue que("bench", CQue::MPMC, 1024);
+        run("CQue(MPMC), 4P/4C", que, 4, 4, count, bufs);
+    }
+
+    return 0;
+}
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
@@ -37,6 +37,7 @@
 #include <cstring>
 #include <vector>
 #include <cstdint>
+#include <thread>
 
 #ifdef HAVE_DEJAGNU_H
 #include "dejagnu.h"
@@ -168,5 +169,126 @@ main (int /*argc*/, char** /*argv*/) {
 
 //     que.pop();
 
+     // Push more buffers than fit in the ring, so the rest spill into
+     // the overflow que, and make sure they still come out in order.
+     CQue small("small", CQue::SPSC, 4);
+     std::vector<std::shared_ptr<cygnal::Buffer> > bufs;
+     for (i=0; i<10; i++) {
+         bufs.push_back(std::shared_ptr<cygnal::Buffer>(new Buffer(8)));
+         small.push(bufs.back());
+     }
+     if (small.size() == 10) {
+         runtest.pass("CQue::push(overflow)");
+     } else {
+         runtest.fail("CQue::push(overflow)");
+     }
+     bool ordered = true;
+     for (i=0; i<10; i++) {
+         if (small.pop() != bufs[i]) {
+             ordered = false;
+         }
+     }
+     if (ordered && (small.size() == 0) && !small.pop()) {
+         runtest.pass("CQue::pop(overflow)");
+     } else {
+         runtest.fail("CQue::pop(overflow)");
+     }
+
+     // Random access moves the ring into the overflow que, which must
+     // not change the order either.
+     for (i=0; i<3; i++) {
+         small.push(bufs[i]);
+     }
+     if ((small[1] == bufs[1]) && (small.pop() == bufs[0])
+         && (small.pop() == bufs[1]) && (small.pop() == bufs[2])) {
+         runtest.pass("CQue::operator[]");
+     } else {
+         runtest.fail("CQue::operator[]");
+     }
+
+     // One producer and one consumer thread, with the consumer sleeping
+     // on the que when it runs dry.
+     const size_t count = 100000;
+     CQue shared("shared", CQue::SPSC, 64);
+     std::thread producer([&shared, &bufs, count] {
+         for (size_t j=0; j<count; j++) {
+             shared.push(bufs[j % bufs.size()]);
+             shared.notify();
+         }
+     });
+     size_t received = 0;
+     ordered = true;
+     while (received < count) {
+         std::shared_ptr<cygnal::Buffer> got = shared.pop();
+         if (!got) {
+             shared.wait();
+             continue;
+         }
+         if (got != bufs[received % bufs.size()]) {
+             ordered = false;
+         }
+         received++;
+     }
+     producer.join();
+     if (ordered && (shared.size() == 0)) {
+         runtest.pass("CQue threaded push/pop");
+     } else {
+         runtest.fail("CQue threaded push/pop");
+     }
+
+     // The same, with the consumer moving the ring into the overflow que
+     // while the producer is pushing, which must not let a newer buffer
+     // overtake the ones it moved.
+     CQue spilling("spilling", CQue::SPSC, 64);
+     std::thread spiller([&spilling, &bufs, count] {
+         for (size_t j=0; j<count; j++) {
+             spilling.push(bufs[j % bufs.size()]);
+             spilling.notify();
+         }
+     });
+     received = 0;
+     ordered = true;
+     while (received < count) {
+         if (received % 64 == 0) {
+             spilling[0];
+         }
+         std::shared_ptr<cygnal::Buffer> got = spilling.pop();
+         if (!got) {
+             spilling.wait();
+             continue;
+         }
+         if (got != bufs[received % bufs.size()]) {
+             ordered = false;
+         }
+         received++;
+     }
+     spiller.join();
+     if (ordered && (spilling.size() == 0)) {
+         runtest.pass("CQue threaded push/pop with spills");
+     } else {
+         runtest.fail("CQue threaded push/pop with spills");
+     }
+
+     // Peeking at an MPMC que goes through the overflow que, and must
+     // leave the order alone.
+     CQue many("many", CQue::MPMC, 4);
+     for (i=0; i<3; i++) {
+         many.push(bufs[i]);
+     }
+     std::shared_ptr<cygnal::Buffer> head = many.peek();
+     for (i=3; i<6; i++) {
+         many.push(bufs[i]);
+     }
+     ordered = (head == bufs[0]) && (many.size() == 6);
+     for (i=0; i<6; i++) {
+         if (many.pop() != bufs[i]) {
+             ordered = false;
+         }
+     }
+     if (ordered && !many.peek() && !many.pop()) {
+         runtest.pass("CQue::peek(MPMC)");
+     } else {
+         runtest.fail("CQue::peek(MPMC)");
+     }
 }
 
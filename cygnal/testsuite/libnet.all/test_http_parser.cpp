@@ -0,0 +1,303 @@
+//
+//   Copyright (C) 2008, 2009, 2010, 2011, 2012 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+#ifdef HAVE_DEJAGNU_H
+#include "dejagnu.h"
+#else
+#include "check.h"
+#endif
+
+#include "log.h"
+#include "http_parser.h"
+
+using namespace std;
+using namespace gnash;
+
+TestState runtest;
+
+namespace {
+
+void
+result(bool ok, const char *name)
+{
+    if (ok) {
+        runtest.pass(name);
+    } else {
+        runtest.fail(name);
+    }
+}
+
+const std::uint8_t *
+bytes(const string &str)
+{
+    return reinterpret_cast<const std::uint8_t *>(str.data());
+}
+
+HTTPParser::parse_status_e
+parseAll(HTTPParser &parser, const string &str)
+{
+    parser.reset();
+    return parser.parse(bytes(str), str.size());
+}
+
+void
+test_request()
+{
+    HTTPParser parser;
+    const string req = "GET /vids/test.flv?start=10 HTTP/1.1\r\n"
+        "Host: localhost:4080\r\n"
+        "User-Agent:Gnash\r\n"
+        "Accept-Language:   en-US, en  \r\n"
+        "\r\n";
+
+    result((parseAll(parser, req) == HTTPParser::COMPLETE)
+           && parser.getMethod().equals("GET")
+           && (parser.getPath().str() == "/vids/test.flv")
+           && (parser.getQuery().str() == "start=10")
+           && (parser.getMajorVersion() == 1)
+           && (parser.getMinorVersion() == 1)
+           && (parser.getMessageSize() == req.size()),
+           "HTTPParser::parse(request line)");
+
+    result((parser.getFieldCount() == 3)
+           && (parser.getField("host").str() == "localhost:4080")
+           && (parser.getField("USER-AGENT").str() == "Gnash")
+           && (parser.getField("Accept-Language").str() == "en-US, en")
+           && parser.getField("Content-Length").empty(),
+           "HTTPParser::getField()");
+
+    // Feed the request a byte at a time, as a slow network would.
+    parser.reset();
+    bool incremental = true;
+    for (size_t i = 1; i < req.size(); i++) {
+        if (parser.parse(bytes(req), i) != HTTPParser::NEED_MORE) {
+            incremental = false;
+        }
+    }
+    result(incremental
+           && (parser.parse(bytes(req), req.size()) == HTTPParser::COMPLETE)
+           && (parser.getPath().str() == "/vids/test.flv"),
+           "HTTPParser::parse(incremental)");
+
+    // Blank lines before a request are ignored.
+    result((parseAll(parser, "\r\nHEAD / HTTP/1.0\r\n\r\n") == HTTPParser::COMPLETE)
+           && parser.getMethod().equals("HEAD")
+           && (parser.getPath().str() == "/")
+           && parser.getQuery().empty(),
+           "HTTPParser::parse(leading CRLF)");
+}
+
+void
+test_pipeline()
+{
+    HTTPParser parser;
+    const string one = "GET /one.swf HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    const string two = "POST /echo/gateway HTTP/1.1\r\n"
+        "Content-Type: application/x-amf\r\n"
+        "Content-Length: 5\r\n\r\nhello";
+    const string three = "GET /three.xml HTTP/1.1\r\nConnection: close\r\n\r\n";
+    string data = one + two + three;
+
+    // Each request is parsed from where the last one ended.
+    size_t offset = 0;
+    string paths;
+    int count = 0;
+    while (offset < data.size()) {
+        parser.reset();
+        if (parser.parse(bytes(data) + offset, data.size() - offset)
+            != HTTPParser::COMPLETE) {
+            break;
+        }
+        paths += parser.getPath().str();
+        offset += parser.getMessageSize();
+        count++;
+    }
+    result((count == 3) && (offset == data.size())
+           && (paths == "/one.swf/echo/gateway/three.xml"),
+           "HTTPParser pipelined requests");
+
+    parseAll(parser, one + two);
+    parser.reset();
+    result((parser.parse(bytes(two), two.size() - 1) == HTTPParser::NEED_MORE),
+           "HTTPParser::parse(partial body)");
+    result((parser.parse(bytes(two), two.size()) == HTTPParser::COMPLETE)
+           && (parser.getContentLength() == 5)
+           && (parser.getBodyParts() == 1)
+           && (parser.getBodyPart(0).str() == "hello"),
+           "HTTPParser::parse(Content-Length body)");
+}
+
+void
+test_chunked()
+{
+    HTTPParser parser;
+    const string req = "POST /upload HTTP/1.1\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n"
+        "5\r\nhello\r\n"
+        "7;name=value\r\n, world\r\n"
+        "0\r\n"
+        "X-Trailer: ignored\r\n"
+        "\r\n"
+        "GET /next HTTP/1.1\r\n\r\n";
+    const size_t first = req.find("GET /next");
+
+    result((parseAll(parser, req) == HTTPParser::COMPLETE)
+           && parser.isChunked()
+           && (parser.getContentLength() == 12)
+           && (parser.getBodyParts() == 2)
+           && (parser.getBodyPart(0).str() == "hello")
+           && (parser.getBodyPart(1).str() == ", world")
+           && (parser.getMessageSize() == first),
+           "HTTPParser::parse(chunked body)");
+
+    parser.reset();
+    bool incremental = true;
+    for (size_t i = 1; i < first; i++) {
+        if (parser.parse(bytes(req), i) != HTTPParser::NEED_MORE) {
+            incremental = false;
+        }
+    }
+    result(incremental
+           && (parser.parse(bytes(req), first) == HTTPParser::COMPLETE)
+           && (parser.getContentLength() == 12),
+           "HTTPParser::parse(incremental chunked body)");
+
+    result(parseAll(parser, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                    "5\r\nhelloXX0\r\n\r\n") == HTTPParser::BAD_REQUEST,
+           "HTTPParser::parse(bad chunk)");
+    result(parseAll(parser, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                    "zz\r\n") == HTTPParser::BAD_REQUEST,
+           "HTTPParser::parse(bad chunk size)");
+}
+
+void
+test_keepalive()
+{
+    // The parser points into what it parsed, so that has to be kept.
+    HTTPParser parser;
+    const string v11 = "GET / HTTP/1.1\r\n\r\n";
+    parseAll(parser, v11);
+    result(parser.keepAlive(), "HTTPParser::keepAlive(1.1)");
+    const string v11close = "GET / HTTP/1.1\r\nConnection: TE, Close\r\n\r\n";
+    parseAll(parser, v11close);
+    result(!parser.keepAlive(), "HTTPParser::keepAlive(1.1 close)");
+    const string v10 = "GET / HTTP/1.0\r\n\r\n";
+    parseAll(parser, v10);
+    result(!parser.keepAlive(), "HTTPParser::keepAlive(1.0)");
+    const string v10keep = "GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n";
+    parseAll(parser, v10keep);
+    result(parser.keepAlive(), "HTTPParser::keepAlive(1.0 keep-alive)");
+}
+
+void
+test_errors()
+{
+    HTTPParser parser;
+    result(parseAll(parser, "GET /\r\n\r\n") == HTTPParser::BAD_REQUEST,
+           "HTTPParser::parse(no version)");
+    result(parseAll(parser, "GET / HTTP/1.1\r\nHost localhost\r\n\r\n")
+           == HTTPParser::BAD_REQUEST,
+           "HTTPParser::parse(no colon)");
+    result(parseAll(parser, "GET / HTTP/1.1\r\nHost: a\r\n  folded\r\n\r\n")
+           == HTTPParser::BAD_REQUEST,
+           "HTTPParser::parse(folded field)");
+    result(parseAll(parser, "POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n")
+           == HTTPParser::BAD_REQUEST,
+           "HTTPParser::parse(bad Content-Length)");
+
+    string big = "GET / HTTP/1.1\r\nX-Big: ";
+    big.append(HTTPParser::MAX_HEADER_SIZE, 'x');
+    result(parseAll(parser, big) == HTTPParser::TOO_LARGE,
+           "HTTPParser::parse(header too large)");
+
+    string many = "GET / HTTP/1.1\r\n";
+    for (size_t i = 0; i <= HTTPParser::MAX_FIELDS; i++) {
+        many += "X: y\r\n";
+    }
+    many += "\r\n";
+    result(parseAll(parser, many) == HTTPParser::TOO_LARGE,
+           "HTTPParser::parse(too many fields)");
+}
+
+bool
+range(const char *value, size_t filesize, HTTPParser::range_status_e status,
+      size_t first = 0, size_t last = 0)
+{
+    HTTPParser::token_t token(value, strlen(value));
+    size_t a = 0, b = 0;
+    if (HTTPParser::parseRange(token, filesize, a, b) != status) {
+        return false;
+    }
+    return (status != HTTPParser::RANGE_OK) || ((a == first) && (b == last));
+}
+
+void
+test_range()
+{
+    result(range("bytes=0-99", 1000, HTTPParser::RANGE_OK, 0, 99),
+           "HTTPParser::parseRange(first-last)");
+    result(range("bytes=500-", 1000, HTTPParser::RANGE_OK, 500, 999),
+           "HTTPParser::parseRange(first-)");
+    result(range("bytes=900-2000", 1000, HTTPParser::RANGE_OK, 900, 999),
+           "HTTPParser::parseRange(last past the end)");
+    result(range("bytes=-100", 1000, HTTPParser::RANGE_OK, 900, 999),
+           "HTTPParser::parseRange(suffix)");
+    result(range("bytes=-5000", 1000, HTTPParser::RANGE_OK, 0, 999),
+           "HTTPParser::parseRange(suffix bigger than file)");
+    result(range("bytes=1000-", 1000, HTTPParser::RANGE_UNSATISFIABLE)
+           && range("bytes=-0", 1000, HTTPParser::RANGE_UNSATISFIABLE),
+           "HTTPParser::parseRange(unsatisfiable)");
+    result(range("bytes=0-1,5-6", 1000, HTTPParser::RANGE_NONE)
+           && range("bytes=5-1", 1000, HTTPParser::RANGE_NONE)
+           && range("lines=0-1", 1000, HTTPParser::RANGE_NONE)
+           && range("", 1000, HTTPParser::RANGE_NONE)
+           && range("bytes=   ", 1000, HTTPParser::RANGE_NONE),
+           "HTTPParser::parseRange(ignored)");
+}
+
+} // anonymous namespace
+
+int
+main(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    test_request();
+    test_pipeline();
+    test_chunked();
+    test_keepalive();
+    test_errors();
+    test_range();
+
+    return 0;
+}
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
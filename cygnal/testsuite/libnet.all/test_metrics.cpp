@@ -0,0 +1,218 @@
+//
+//   Copyright (C) 2008, 2009, 2010, 2011, 2012 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef HAVE_DEJAGNU_H
+#include "dejagnu.h"
+#else
+#include "check.h"
+#endif
+
+#include "log.h"
+#include "metrics.h"
+
+using namespace std;
+using namespace gnash;
+
+TestState runtest;
+
+namespace {
+
+void
+result(bool ok, const char *name)
+{
+    if (ok) {
+        runtest.pass(name);
+    } else {
+        runtest.fail(name);
+    }
+}
+
+bool
+contains(const string &text, const string &line)
+{
+    return text.find(line + "\n") != string::npos;
+}
+
+void
+test_histogram()
+{
+    Metrics::Histogram hist;
+    hist.add(0);
+    hist.add(1);
+    hist.add(2);
+    hist.add(3);
+    hist.add(1000);
+    hist.add(1ULL << 40);
+
+    result((hist.bucket(0) == 2) && (hist.bucket(1) == 1)
+           && (hist.bucket(2) == 1) && (hist.bucket(10) == 1)
+           && (hist.bucket(Metrics::Histogram::BUCKETS) == 1),
+           "Metrics::Histogram::add()");
+    result((hist.count() == 6) && (hist.sum() == 1006 + (1ULL << 40)),
+           "Metrics::Histogram count and sum");
+}
+
+void
+test_connections()
+{
+    Metrics &metrics = Metrics::getDefaultInstance();
+
+    metrics.opened(7);
+    metrics.setProtocol(7, 3);
+    metrics.received(7, 100);
+    metrics.sent(7, 250);
+    metrics.rtmpMessage(7, 0x14);
+    metrics.rtmpMessage(7, 0x09);
+    metrics.queueDepth(7, 4);
+    // Descriptors out of range still count in the totals.
+    metrics.received(-1, 10);
+    metrics.received(Metrics::MAX_CONNECTIONS, 10);
+
+    string text = metrics.format();
+    result(contains(text, "cygnal_connection_bytes_in{fd=\"7\",protocol=\"rtmp\"} 100")
+           && contains(text, "cygnal_connection_bytes_out{fd=\"7\",protocol=\"rtmp\"} 250")
+           && contains(text, "cygnal_connection_messages{fd=\"7\",protocol=\"rtmp\"} 2")
+           && contains(text, "cygnal_connection_queue_depth{fd=\"7\",protocol=\"rtmp\"} 4"),
+           "Metrics per connection counters");
+    result(contains(text, "cygnal_bytes_total{direction=\"in\"} 120")
+           && contains(text, "cygnal_bytes_total{direction=\"out\"} 250")
+           && contains(text, "cygnal_rtmp_messages_total{type=\"invoke\"} 1")
+           && contains(text, "cygnal_rtmp_messages_total{type=\"video\"} 1"),
+           "Metrics totals");
+
+    metrics.closed(7);
+    metrics.received(7, 5);
+    text = metrics.format();
+    result((text.find("fd=\"7\"") == string::npos)
+           && contains(text, "cygnal_connections_total{state=\"closed\"} 1")
+           && contains(text, "cygnal_bytes_total{direction=\"in\"} 125"),
+           "Metrics::closed()");
+
+    // A reused descriptor starts again from zero.
+    metrics.opened(7);
+    text = metrics.format();
+    result(contains(text, "cygnal_connection_bytes_in{fd=\"7\",protocol=\"none\"} 0")
+           && contains(text, "cygnal_connections_total{state=\"accepted\"} 2"),
+           "Metrics::opened(reused fd)");
+    metrics.closed(7);
+}
+
+void
+test_requests()
+{
+    Metrics &metrics = Metrics::getDefaultInstance();
+
+    metrics.httpRequest(2);
+    metrics.httpRequest(2);
+    metrics.httpRequest(4);
+    metrics.cacheLookup(Metrics::CACHE_FILE, true);
+    metrics.cacheLookup(Metrics::CACHE_FILE, true);
+    metrics.cacheLookup(Metrics::CACHE_FILE, true);
+    metrics.cacheLookup(Metrics::CACHE_FILE, false);
+    metrics.handshake(1500);
+
+    string text = metrics.format();
+    result(contains(text, "cygnal_http_requests_total{method=\"get\"} 2")
+           && contains(text, "cygnal_http_requests_total{method=\"post\"} 1"),
+           "Metrics::httpRequest()");
+    result(contains(text, "cygnal_cache_lookups_total{cache=\"file\"} 4")
+           && contains(text, "cygnal_cache_hits_total{cache=\"file\"} 3")
+           && contains(text, "cygnal_cache_hit_ratio{cache=\"file\"} 0.75")
+           && contains(text, "cygnal_cache_hit_ratio{cache=\"path\"} 0"),
+           "Metrics::cacheLookup()");
+    result(contains(text, "cygnal_rtmp_handshake_seconds_bucket{le=\"0.001024\"} 0")
+           && contains(text, "cygnal_rtmp_handshake_seconds_bucket{le=\"0.002048\"} 1")
+           && contains(text, "cygnal_rtmp_handshake_seconds_bucket{le=\"+Inf\"} 1")
+           && contains(text, "cygnal_rtmp_handshake_seconds_count 1"),
+           "Metrics::handshake()");
+}
+
+void
+test_threads()
+{
+    Metrics &metrics = Metrics::getDefaultInstance();
+
+    int id = metrics.addThread("test");
+    metrics.loopLag(id, 300);
+    metrics.loopLag(id, 100);
+    // Burn a little CPU so there is something to report.
+    volatile double x = 0;
+    for (int i = 0; i < 1000000; i++) {
+        x = x + i;
+    }
+    metrics.sampleThread(id);
+
+    string text = metrics.format();
+    string label = "{thread=\"" + to_string(id) + "\",name=\"test\"} ";
+    result((id >= 0)
+           && contains(text, "cygnal_thread_lag_max_seconds" + label + "0.0003")
+           && (text.find("cygnal_thread_cpu_seconds_total" + label) != string::npos)
+           && contains(text, "cygnal_event_loop_lag_seconds_count 2"),
+           "Metrics::addThread()");
+
+    metrics.removeThread(id);
+    text = metrics.format();
+    result(text.find("name=\"test\"") == string::npos,
+           "Metrics::removeThread()");
+
+    // Counters updated from many threads at once don't lose counts.
+    vector<thread> threads;
+    for (int i = 0; i < 8; i++) {
+        threads.push_back(thread([&metrics] {
+            for (int j = 0; j < 10000; j++) {
+                metrics.httpRequest(3);
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    result(contains(metrics.format(),
+                    "cygnal_http_requests_total{method=\"head\"} 80000"),
+           "Metrics concurrent updates");
+}
+
+} // anonymous namespace
+
+int
+main(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    test_histogram();
+    test_connections();
+    test_requests();
+    test_threads();
+
+    return 0;
+}
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
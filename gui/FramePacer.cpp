@@ -0,0 +1,156 @@
+// FramePacer.cpp: decide which frames to draw, and how well
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "FramePacer.h"
+
+#include <algorithm>
+
+namespace gnash {
+
+namespace {
+
+/// The most frames skipped in a row.
+const size_t maxSkippedInRow = 3;
+
+/// How many frames of history the running averages have, roughly.
+const double averageFrames = 8;
+
+/// The number of frames between quality decisions.
+const size_t windowFrames = 48;
+
+/// The quality is lowered when more than this part of a window's frames
+/// were skipped.
+const double lowerSkipped = 0.25;
+
+/// The quality is raised when no frame of a window was skipped and the
+/// most expensive one took less than this part of a frame's time.
+const double raiseCost = 0.5;
+
+void
+average(double& avg, double value)
+{
+    avg += (value - avg) / averageFrames;
+}
+
+}
+
+FramePacer::FramePacer()
+    :
+    _interval(1000000 / 12),
+    _last(0),
+    _advanceCost(0),
+    _renderCost(0),
+    _skippedInRow(0),
+    _frames(0),
+    _windowSkipped(0),
+    _windowCost(0),
+    _steps(0)
+{
+}
+
+void
+FramePacer::setFrameRate(double fps)
+{
+    // Malformed SWFs can have a rate of 0.
+    if (fps <= 0) fps = 12;
+    _interval = 1000000 / fps;
+}
+
+bool
+FramePacer::advanced(std::uint64_t now, std::uint64_t cost)
+{
+    average(_advanceCost, cost);
+
+    // A frame that comes more than half a frame after it was due is
+    // already late. Stalls of more than a few frames, such as after
+    // the movie was paused, are forgotten rather than caught up on.
+    const std::uint64_t since = _last ? now - _last : _interval;
+    _last = now;
+    const bool behind = since > _interval + _interval / 2 &&
+        since < _interval * 4;
+
+    // Drawing the frame would make the next one late too.
+    const bool slow = _advanceCost + _renderCost > _interval;
+
+    ++_frames;
+
+    if ((behind || slow) && _skippedInRow < maxSkippedInRow) {
+        ++_skippedInRow;
+        ++_windowSkipped;
+        ++_stats.skipped;
+        return false;
+    }
+
+    _skippedInRow = 0;
+    return true;
+}
+
+bool
+FramePacer::rendered(std::uint64_t cost, Quality wanted)
+{
+    average(_renderCost, cost);
+    _windowCost = std::max(_windowCost, _advanceCost + cost);
+    return adapt(wanted);
+}
+
+Quality
+FramePacer::quality(Quality wanted) const
+{
+    return static_cast<Quality>(
+            std::max<int>(QUALITY_LOW, wanted - _steps));
+}
+
+bool
+FramePacer::adapt(Quality wanted)
+{
+    if (_frames < windowFrames) return false;
+
+    bool changed = false;
+
+    if (_windowSkipped > _frames * lowerSkipped) {
+        if (quality(wanted) > QUALITY_LOW) {
+            ++_steps;
+            ++_stats.lowered;
+            changed = true;
+        }
+    }
+    else if (!_windowSkipped && _windowCost < _interval * raiseCost) {
+        if (_steps) {
+            --_steps;
+            ++_stats.raised;
+            changed = true;
+        }
+    }
+
+    // The averages of the old quality don't tell anything about the
+    // new one.
+    if (changed) _renderCost = 0;
+
+    _frames = 0;
+    _windowSkipped = 0;
+    _windowCost = 0;
+    return changed;
+}
+
+} // namespace gnash
+
+// Local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
@@ -0,0 +1,139 @@
+// FramePacer.h: decide which frames to draw, and how well
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef GNASH_FRAMEPACER_H
+#define GNASH_FRAMEPACER_H
+
+#include <cstdint>
+#include <cstddef>
+
+#include "GnashEnums.h"
+
+namespace gnash {
+
+/// Keeps the player up with the movie's frame rate on slow machines.
+//
+/// The timeline must advance at the frame rate for the movie to stay in
+/// time with its sound, but drawing every frame may not fit in a frame's
+/// time. The FramePacer is told how long each advance and each drawing
+/// took, and decides
+///
+/// - whether a frame is drawn. A frame that is already late, or that
+///   can't be advanced and drawn in the time of one frame, is not drawn,
+///   though never more than a few in a row so that the picture still
+///   moves.
+/// - the quality frames are drawn at. When many frames are skipped for
+///   a while, the quality is lowered by a step, which costs bitmap
+///   smoothing and then, in renderers that have it, antialiasing. When
+///   drawing is cheap again, it is raised, but never above the quality
+///   the movie asked for.
+///
+/// All times are in microseconds.
+class FramePacer
+{
+public:
+
+    /// What the FramePacer decided so far.
+    struct Stats
+    {
+        Stats()
+            :
+            skipped(0),
+            lowered(0),
+            raised(0)
+        {}
+
+        /// The number of frames not drawn.
+        size_t skipped;
+
+        /// How often the quality was lowered.
+        size_t lowered;
+
+        /// How often the quality was raised.
+        size_t raised;
+    };
+
+    FramePacer();
+
+    /// Set the frame rate to keep up with, in frames per second.
+    void setFrameRate(double fps);
+
+    /// Report a frame advance of the timeline.
+    //
+    /// @param now      The time the advance finished.
+    /// @param cost     How long the advance took.
+    /// @return         Whether the frame should be drawn.
+    bool advanced(std::uint64_t now, std::uint64_t cost);
+
+    /// Report drawing a frame.
+    //
+    /// @param cost     How long the drawing took.
+    /// @param wanted   The quality the movie asked for.
+    /// @return         true if the quality to draw at changed, in which
+    ///                 case the whole stage should be drawn again.
+    bool rendered(std::uint64_t cost, Quality wanted);
+
+    /// The quality to draw at.
+    //
+    /// @param wanted   The quality the movie asked for.
+    Quality quality(Quality wanted) const;
+
+    const Stats& stats() const {
+        return _stats;
+    }
+
+private:
+
+    /// Decide whether to change the quality, once per window of frames.
+    bool adapt(Quality wanted);
+
+    /// The time of one frame.
+    std::uint64_t _interval;
+
+    /// When the last frame was advanced, 0 before the first one.
+    std::uint64_t _last;
+
+    /// Running averages of advancing and drawing a frame.
+    double _advanceCost;
+    double _renderCost;
+
+    /// The frames not drawn since the last one that was.
+    size_t _skippedInRow;
+
+    /// The frames advanced and skipped in the current window.
+    size_t _frames;
+    size_t _windowSkipped;
+
+    /// The largest frame cost in the current window.
+    double _windowCost;
+
+    /// How many steps below the wanted quality frames are drawn at.
+    int _steps;
+
+    Stats _stats;
+};
+
+} // namespace gnash
+
+#endif
+
+// Local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
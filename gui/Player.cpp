@@ -25,6 +25,7 @@
 #include "Player.h"
 
 #include <iostream>
+#include <fstream>
 #include <sstream>
 #include <boost/lexical_cast.hpp>
 #include <boost/variant/static_visitor.hpp>
@@ -306,6 +307,8 @@ Player::init_gui()
 
     _gui->setAudioDump(_audioDump);
     _gui->setMaxAdvances(_maxAdvances);
+    _gui->setRenderThread(RcInitFile::getDefaultInstance().useRenderThread());
+    _gui->setFramePacing(RcInitFile::getDefaultInstance().useFramePacing());
 
 #ifdef GNASH_FPS_DEBUG
     if (_fpsDebugTime) {
@@ -503,6 +506,8 @@ Player::run(int argc, char* argv[], const std::string& infile,
       // (bringing down the MovieLoader) before we clear the MovieLibrary
 
     movie_root root(_gui->getClock(), *_runResources);
+
+    if (!_profileFile.empty()) root.getVM().startProfiling();
     
     _callbacksHandler.reset(new CallbacksHandler(*_gui, *this)); 
     
@@ -665,6 +670,14 @@ Player::run(int argc, char* argv[], const std::string& infile,
 
     log_debug("Main loop ended, cleaning up");
 
+    if (const Profiler* profiler = root.getVM().profiler()) {
+        std::ofstream out(_profileFile.c_str());
+        if (out) profiler->writeStacks(out);
+        else log_error(_("Can't write the ActionScript profile to %s"),
+                _profileFile);
+        profiler->writeReport(std::cout);
+    }
+
     }
 
     // Clean up the MovieLibrary so left-over SWFMovieDefinitions
@@ -682,6 +695,10 @@ Player::CallbacksHandler::exit()
 boost::any
 Player::CallbacksHandler::call(const HostInterface::Message& e)
 {
+    // Most of these change the window, so the frame being drawn
+    // must be finished first.
+    _gui.finishRendering();
+
     MessageHandler v(_gui);
     try {
         return boost::apply_visitor(v, e);
@@ -748,6 +765,8 @@ Player::CallbacksHandler::notify(const std::string& command,
     // (Or do we want to allow disabling all external communication?) 
     if (rcfile.ignoreFSCommand()) return;
 
+    _gui.finishRendering();
+
     StringNoCaseEqual noCaseCompare;
 
     // There are six defined FsCommands handled by the standalone player:
@@ -210,6 +210,13 @@ public:
         _screenshotQuality = quality;
     }
 
+    /// Profile the ActionScript run, writing its call stacks to a file.
+    //
+    /// The time of each function and opcode is printed on exit.
+    void setProfileFile(const std::string& file) {
+        _profileFile = file;
+    }
+
 private:
 
     /// Whether to ue HW video decoding support, no value means disabled.
@@ -379,6 +386,11 @@ private:
     /// By default 100.
     int _screenshotQuality;
 
+    /// The file to write the collapsed stacks of the ActionScript run to.
+    //
+    /// If empty, it isn't profiled.
+    std::string _profileFile;
+
     /// The identifier for the media handler.
     //
     /// If empty, a default is used.
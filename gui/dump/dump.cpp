@@ -118,6 +118,9 @@ DumpGui::init(int argc, char **argv[])
         log_error(_("Ignoring request to display in X11 window"));
     }
 
+    // Every frame must be drawn to be dumped.
+    setFramePacing(false);
+
     optind = 0;
     opterr = 0;
     int c;
@@ -197,10 +200,8 @@ DumpGui::run()
 
     log_debug("DumpGui entering main loop with interval of %d ms", _interval);
 
-    // heart-beat interval, in milliseconds
-    // TODO: extract this value from the swf's FPS
-    //       by default and allow overriding it
-    //
+    // heart-beat interval, in milliseconds, until the movie says when
+    // its next frame or timer is due.
     unsigned int clockAdvance = _interval;
 
     const bool doDisplay = _fileStream.is_open();
@@ -215,6 +216,7 @@ DumpGui::run()
 
         // advance movie now
         advanceMovie(doDisplay);
+        clockAdvance = timeToNextAdvance();
 
         if (_started) {
 
@@ -225,6 +227,7 @@ DumpGui::run()
             size_t elapsed = _clock.elapsed();
             if (!_framecount || 
                     (elapsed - _lastVideoFrameDump) >= _fileOutputAdvance) {
+                flushFrame();
                 writeFrame();
             }
 
@@ -379,30 +379,16 @@ FBGui::run()
 #endif
 
     VirtualClock& timer = getClock();
-    int delay = 0;
     
     // let the GUI recompute the x/y scale factors to best fit the whole screen
     resize_view(_validbounds.width(), _validbounds.height());
 
-    float fps = getFPS();
-    
-    // FIXME: this value is arbitrary, and will make any movie with
-    // less than 12 frames eat up more of the cpu. It should probably
-    // be a much lower value, like 2.
-    if (fps > 12) {
-        delay = static_cast<int>(100000/fps);
-    } else {
-        // 10ms per heart beat
-        delay = 1000;
-    }
-    // log_debug(_("Movie Frame Rate is %d, adjusting delay to %dms"), fps,
-    //           _interval * delay);
-    
     // This loops endlessly at the frame rate
     while (!terminate_request) {  
-        // wait the "heartbeat" inteval. _interval is in milliseconds,
-        // but gnashSleep() wants nanoseconds, so adjust by 1000.
-        gnashSleep(_interval * delay);
+        // wait until the next frame or timer of the movie is due, or
+        // the "heartbeat" interval. That is in milliseconds, but
+        // gnashSleep() wants microseconds, so adjust by 1000.
+        gnashSleep(timeToNextAdvance() * 1000);
         // TODO: Do we need to check the real time slept or is it OK when we woke
         // up early because of some Linux signal sent to our process (and thus
         // "advance" faster than the "heartbeat" interval)? - Udo
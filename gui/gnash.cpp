@@ -270,10 +270,6 @@ setupSoundAndRendering(gnash::Player& p, int i)
 po::options_description
 getDebuggingOptions(gnash::Player& p)
 {
-#ifndef GNASH_FPS_DEBUG
-    UNUSED(p);
-#endif
-
     using gnash::Player;
     using gnash::LogFile;
     using gnash::RcInitFile;
@@ -311,6 +307,11 @@ getDebuggingOptions(gnash::Player& p)
         _("Print FPS every num seconds"))
 #endif 
 
+    ("profile-actions", po::value<std::string>()
+        ->notifier(std::bind(&Player::setProfileFile, &p, std::placeholders::_1)),
+        _("Write the call stacks of the ActionScript run to the given file "
+          "for a flame graph, and print the time of each function on exit"))
+
     ;
 
     return desc;
@@ -599,13 +599,32 @@ GtkGui::startAdvanceTimer()
 {
     stopAdvanceTimer();
     
-    _advanceSourceTimer = g_timeout_add_full(G_PRIORITY_LOW, _interval,
-            (GSourceFunc)advance_movie, this, nullptr);
+    // The timer is set again after each advance, for when the movie
+    // next has something to do.
+    _advanceSourceTimer = g_timeout_add_full(G_PRIORITY_LOW,
+            timeToNextAdvance(), advanceTimeout, this, nullptr);
 
     log_debug(_("Advance interval timer set to %d ms (~ %d FPS)"),
             _interval, _interval ? 1000/_interval : 1000);
 }
 
+/*private static*/
+gboolean
+GtkGui::advanceTimeout(gpointer data)
+{
+    GtkGui* gui = static_cast<GtkGui*>(data);
+    const guint source = gui->_advanceSourceTimer;
+
+    gui->advanceMovie();
+
+    // Unless advancing stopped the timer or set it again.
+    if (gui->_advanceSourceTimer == source) {
+        gui->_advanceSourceTimer = g_timeout_add_full(G_PRIORITY_LOW,
+                gui->timeToNextAdvance(), advanceTimeout, gui, nullptr);
+    }
+    return FALSE;
+}
+
 /*private*/
 void
 GtkGui::stopAdvanceTimer()
@@ -165,6 +165,9 @@ private:
     void startAdvanceTimer();
 
     void stopAdvanceTimer();
+
+    /// Advance the movie and set the timer again for the next advance.
+    static gboolean advanceTimeout(gpointer data);
 };
 
 } // namespace gnash
@@ -26,9 +26,11 @@
 
 #include <vector>
 #include <algorithm> 
+#include <chrono>
 
 #include "MovieClip.h"
 #include "Renderer.h"
+#include "Renderer_pipelined.h"
 #include "sound_handler.h"
 #include "movie_root.h"
 #include "VM.h"
@@ -41,6 +43,7 @@
 
 #ifdef GNASH_FPS_DEBUG
 #include "ClockTime.h"
+#include <iostream>
 #include <boost/format.hpp>
 #endif
 
@@ -73,6 +76,36 @@
 
 namespace gnash {
 
+namespace {
+
+/// Microseconds since some fixed time, for the FramePacer.
+std::uint64_t
+microseconds()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef GNASH_FPS_DEBUG
+const char*
+qualityName(Quality q)
+{
+    switch (q) {
+        case QUALITY_LOW:
+            return "low";
+        case QUALITY_MEDIUM:
+            return "medium";
+        case QUALITY_HIGH:
+            return "high";
+        case QUALITY_BEST:
+            return "best";
+    }
+    return "unknown";
+}
+#endif
+
+}
+
 struct Gui::Display
 {
     Display(Gui& g, movie_root& r) : _g(g), _r(r) {}
@@ -115,6 +148,9 @@ Gui::Gui(RunResources& r) :
     ,_stopped(false)
     ,_started(false)
     ,_showUpdatedRegions(false)
+    ,_useRenderThread(false)
+    ,_framePending(false)
+    ,_framePacing(false)
 
     // NOTE: it's important that _systemClock is constructed
     //       before and destroyed after _virtualClock !
@@ -159,6 +195,9 @@ Gui::Gui(unsigned long xid, float scale, bool loop, RunResources& r)
     ,_stopped(false)
     ,_started(false)
     ,_showUpdatedRegions(false)
+    ,_useRenderThread(false)
+    ,_framePending(false)
+    ,_framePacing(false)
 
     // NOTE: it's important that _systemClock is constructed
     //       before and destroyed after _virtualClock !
@@ -175,6 +214,11 @@ Gui::Gui(unsigned long xid, float scale, bool loop, RunResources& r)
 
 Gui::~Gui()
 {
+    if (_pipeline) {
+        _pipeline->finish();
+        _runResources.setRenderer(_renderer);
+    }
+
     if ( _movieDef.get() ) {
         log_debug("~Gui - _movieDef refcount: %d", _movieDef->get_ref_count());
     }
@@ -412,6 +456,7 @@ Gui::updateStageMatrix()
     
     // TODO: have a generic set_matrix ?
     if (_renderer.get()) {
+        finishRendering();
         _renderer->set_scale(_xscale, _yscale);
         _renderer->set_translation(_xoffset, _yoffset);
     } else {
@@ -687,11 +732,15 @@ Gui::notify_key_event(gnash::key::code k, int modifier, bool pressed)
 }
 
 bool
-Gui::display(movie_root* m)
+Gui::display(movie_root* m, bool pipeline)
 {
     assert(m == _stage); // why taking this arg ??
 
     assert(_started);
+
+    // Show the previous frame before its invalidated regions are
+    // replaced by this one's.
+    flushFrame();
     
     InvalidatedRanges changed_ranges;
     bool redraw_flag;
@@ -795,7 +844,8 @@ Gui::display(movie_root* m)
         // show invalidated region using a red rectangle
         // (Flash debug style)
         IF_DEBUG_REGION_UPDATES (
-            if (_renderer.get() && !changed_ranges.isWorld()) {
+            Renderer* renderer = _pipeline ? _pipeline.get() : _renderer.get();
+            if (renderer && !changed_ranges.isWorld()) {
                 for (size_t rno = 0; rno < changed_ranges.size(); rno++) {
                     const geometry::Range2d<int>& bounds = 
                         changed_ranges.getRange(rno);
@@ -812,7 +862,7 @@ Gui::display(movie_root* m)
                         point(xmin, ymax)
                     };
                     
-                    _renderer->draw_poly(box, rgba(0,0,0,0), rgba(255,0,0,255),
+                    renderer->draw_poly(box, rgba(0,0,0,0), rgba(255,0,0,255),
                                          SWFMatrix(), false);
                     
                 }
@@ -820,12 +870,33 @@ Gui::display(movie_root* m)
         );
         
         // show frame on screen
-        renderBuffer();	
+        if (_pipeline) {
+            _framePending = true;
+            if (!pipeline) flushFrame();
+        }
+        else renderBuffer();
     };
     
     return true;
 }
 
+void
+Gui::flushFrame()
+{
+    if (!_framePending) return;
+    _framePending = false;
+
+    _pipeline->render();
+    _pipeline->finish();
+    renderBuffer();
+}
+
+void
+Gui::finishRendering()
+{
+    if (_pipeline) _pipeline->finish();
+}
+
 void
 Gui::play()
 {
@@ -904,9 +975,24 @@ Gui::start()
         return;
     }
 
+    if (_useRenderThread && _renderer.get() && !_pipeline) {
+        // Drawing on another thread only works for renderers that don't
+        // need a context tied to the GUI thread.
+        if (_renderer->description() == "AGG") {
+            _pipeline.reset(new Renderer_pipelined(_renderer));
+            _runResources.setRenderer(_pipeline);
+        }
+        else {
+            log_error(_("The %s renderer can't draw on a separate thread"),
+                    _renderer->description());
+        }
+    }
+
     // Initializes the stage with a Movie and the passed flash vars.
     _stage->init(_movieDef.get(), _flashVars);
 
+    _pacer.setFrameRate(getFPS());
+
     bool background = true; // ??
     _stage->set_background_alpha(background ? 1.0f : 0.05f);
 
@@ -949,6 +1035,11 @@ Gui::advanceMovie(bool doDisplay)
     // consequentially displayed. Useful for debugging.
     //#define REVIEW_ALL_FRAMES 1
     
+    // Draw the last frame on the render thread while advancing.
+    if (_pipeline) _pipeline->render();
+
+    const std::uint64_t start = microseconds();
+
 #ifndef REVIEW_ALL_FRAMES
     // Advance movie by one frame
     const bool advanced = m->advance();
@@ -970,8 +1061,31 @@ Gui::advanceMovie(bool doDisplay)
     }
 #endif
     
-    if (doDisplay && visible()) {
-        display(m);
+    // Frames that are late aren't drawn, but the timeline still
+    // advances, so the movie stays in time with its sound.
+    bool draw = true;
+    if (_framePacing && advanced) {
+        const std::uint64_t now = microseconds();
+        draw = _pacer.advanced(now, now - start);
+#ifdef GNASH_FPS_DEBUG
+        if (!draw) ++frames_dropped;
+#endif
+    }
+
+    if (doDisplay && visible() && draw) {
+        if (_framePacing) {
+            const Quality wanted = m->getQuality();
+            Renderer* renderer = m->runResources().renderer();
+            if (renderer) renderer->setQuality(_pacer.quality(wanted));
+
+            const std::uint64_t drawStart = microseconds();
+            display(m, true);
+            if (_pacer.rendered(microseconds() - drawStart, wanted)) {
+                // Everything must be drawn again at the new quality.
+                _redraw_flag = true;
+            }
+        }
+        else display(m, true);
     }
     
     if (!loops()) {
@@ -984,6 +1098,7 @@ Gui::advanceMovie(bool doDisplay)
     }
     
     if (_screenShotter.get() && _renderer.get()) {
+        flushFrame();
         _screenShotter->screenShot(*_renderer, _advances, doDisplay ? nullptr : &dis);
     }
     
@@ -1000,6 +1115,22 @@ Gui::advanceMovie(bool doDisplay)
 	return advanced;
 }
 
+unsigned int
+Gui::timeToNextAdvance() const
+{
+    if (!_started || isStopped() || !_stage) return _interval;
+
+    const int next = std::min(_stage->timeToNextFrame(),
+            _stage->timeToNextTimer());
+
+    // Whatever is late wasn't done by the last advance, as when frames
+    // follow a streaming sound, so wait for the 10ms heart-beat
+    // movie_root expects instead of calling it again at once.
+    if (next <= 0) return std::min(_interval, 10u);
+
+    return std::min<unsigned int>(next, _interval);
+}
+
 void
 Gui::setScreenShotter(std::unique_ptr<ScreenShotter> ss)
 {
@@ -1228,6 +1359,16 @@ Gui::fpsCounterTick()
                                fps_rate_min % avg % fps_rate_max %
                                fps_counter_total % secs_total %
                                frames_dropped << std::endl;
+
+    if (_framePacing) {
+        const FramePacer::Stats& st = _pacer.stats();
+        std::cerr << boost::format("Frame pacing: drawing at %s quality "
+                                   "(movie wants %s), lowered %u and "
+                                   "raised %u times") %
+                                   qualityName(_pacer.quality(getQuality())) %
+                                   qualityName(getQuality()) % st.lowered %
+                                   st.raised << std::endl;
+    }
       
     fps_counter = 0;
     fps_timer = current_timer;
@@ -36,6 +36,7 @@
 #include "SystemClock.h"
 #include "GnashEnums.h" 
 #include "movie_root.h"
+#include "FramePacer.h"
 
 #ifdef USE_SWFTREE
 #include "tree.hh" // for tree
@@ -69,6 +70,7 @@ namespace gnash {
     class movie_root;
     class movie_definition;
     class Renderer;
+    class Renderer_pipelined;
     class SWFRect;
 }
 namespace boost {
@@ -274,6 +276,14 @@ public:
         return true;
     }
 
+    /// Return the number of milliseconds to wait before the next heart-beat.
+    //
+    /// This is until the next frame or interval timer of the movie is due,
+    /// but no longer than the interval specified in the call to
+    /// setInterval(), so that anything else the movie polls for still is,
+    /// and at least 10ms if something is late.
+    unsigned int timeToNextAdvance() const;
+
     /// Force immediate redraw
     ///
     void refreshView();
@@ -354,6 +364,24 @@ public:
     void showUpdatedRegions(bool x) { _showUpdatedRegions = x; }
     bool showUpdatedRegions() const { return _showUpdatedRegions; }
 
+    /// Draw each frame on a separate thread while the next is advanced.
+    //
+    /// This takes effect when the movie starts, and only if the renderer
+    /// draws to memory.
+    void setRenderThread(bool x) { _useRenderThread = x; }
+
+    /// Skip drawing late frames, and lower the quality to keep up.
+    //
+    /// See FramePacer. Frames the movie advances are then not all
+    /// drawn, so this must be off for anything that needs every frame.
+    void setFramePacing(bool x) { _framePacing = x; }
+
+    /// Wait for the frame being drawn on the render thread, if any.
+    //
+    /// Call this before changing anything the renderer uses, such as
+    /// the size of the window.
+    void finishRendering();
+
     /// Instruct the core to restart the movie and
     /// set state to play(). This does not change pause
     /// state.
@@ -533,6 +561,12 @@ protected:
 
     /// Determines whether the Gui is visible (not obscured).
     virtual bool visible() { return true; }
+
+    /// Draw and show the frame left on the render thread, if any.
+    //
+    /// GUIs that read the rendered frame back must call this first.
+    void flushFrame();
+
 private:
 
     struct Display;
@@ -551,7 +585,12 @@ private:
     /// Window pixel Y offset of stage origin
     std::int32_t _yoffset;
 
-    bool display(movie_root* m);
+    /// Render the changed parts of the stage.
+    //
+    /// @param pipeline If drawing on the render thread, leave the frame
+    ///                 to be drawn while the next one is advanced, instead
+    ///                 of drawing and showing it now.
+    bool display(movie_root* m, bool pipeline = false);
     
 #ifdef GNASH_FPS_DEBUG
     unsigned int fps_counter;
@@ -599,6 +638,21 @@ private:
     /// If true, updated regions (invalidated ranges) are visibly outlined.
     bool _showUpdatedRegions;
 
+    /// Whether to draw frames on a separate thread.
+    bool _useRenderThread;
+
+    /// Records the frames and draws them on its own thread, when
+    /// _useRenderThread is set.
+    std::shared_ptr<Renderer_pipelined> _pipeline;
+
+    /// Whether a recorded frame hasn't been shown yet.
+    bool _framePending;
+
+    /// Whether _pacer decides which frames are drawn and how well.
+    bool _framePacing;
+
+    FramePacer _pacer;
+
     SystemClock _systemClock;
     InterruptableVirtualClock _virtualClock;
     
@@ -125,7 +125,9 @@ SDLGui::run()
         }
 
         advanceMovie();
-        movie_time += _interval;        // Time next frame should be displayed
+
+        // Time the next frame or timer of the movie is due
+        movie_time = SDL_GetTicks() + timeToNextAdvance();
     }
     return false;
 }
@@ -0,0 +1,545 @@
+// AMFStream.cpp    Streaming AMF0/AMF3 reader and writer.
+//
+//   Copyright (C) 2005, 2006, 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "AMFStream.h"
+
+#include <cstring>
+
+#include "log.h"
+
+// Define this macro to make AMF parsing verbose
+//#define GNASH_DEBUG_AMF_DESERIALIZE 1
+
+namespace gnash {
+namespace amf {
+
+namespace {
+
+/// Nesting deeper than this is taken to be a malicious message, rather
+/// than recursing until the stack runs out.
+const unsigned MAX_DEPTH = 256;
+
+/// A handler that ignores everything, for skipping values.
+StreamHandler nullHandler;
+
+}
+
+StreamReader::StreamReader(const std::uint8_t* pos, const std::uint8_t* end)
+    :
+    _pos(pos),
+    _end(end),
+    _objects(0)
+{
+}
+
+void
+StreamReader::reset(const std::uint8_t* pos, const std::uint8_t* end)
+{
+    _pos = pos;
+    _end = end;
+    _strings.clear();
+    _traits.clear();
+    _members.clear();
+    _objects = 0;
+}
+
+bool
+StreamReader::operator()(StreamHandler& h)
+{
+    if (eof()) return false;
+    readAMF0(h, 0);
+    return true;
+}
+
+bool
+StreamReader::skip()
+{
+    return (*this)(nullHandler);
+}
+
+bool
+StreamReader::readProperty(StreamHandler& h)
+{
+    const StringRef name = readPlainString();
+    if (name.empty()) {
+        need(1);
+        if (*_pos == OBJECT_END_AMF0) {
+            ++_pos;
+            return false;
+        }
+    }
+    h.property(name);
+    readAMF0(h, 0);
+    return true;
+}
+
+StringRef
+StreamReader::readPlainString()
+{
+    const std::uint16_t size = readShort();
+    return readBytes(size);
+}
+
+void
+StreamReader::need(size_t bytes) const
+{
+    if (static_cast<size_t>(_end - _pos) < bytes) {
+        throw AMFException(_("Read past end of buffer"));
+    }
+}
+
+std::uint8_t
+StreamReader::readByte()
+{
+    need(1);
+    return *_pos++;
+}
+
+std::uint16_t
+StreamReader::readShort()
+{
+    need(2);
+    const std::uint16_t s = readNetworkShort(_pos);
+    _pos += 2;
+    return s;
+}
+
+std::uint32_t
+StreamReader::readLong()
+{
+    need(4);
+    const std::uint32_t l = readNetworkLong(_pos);
+    _pos += 4;
+    return l;
+}
+
+double
+StreamReader::readDouble()
+{
+    need(8);
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i) {
+        bits = (bits << 8) | _pos[i];
+    }
+    _pos += 8;
+    double d;
+    std::memcpy(&d, &bits, 8);
+    return d;
+}
+
+StringRef
+StreamReader::readBytes(size_t size)
+{
+    need(size);
+    const StringRef s(reinterpret_cast<const char*>(_pos), size);
+    _pos += size;
+    return s;
+}
+
+void
+StreamReader::readAMF0Properties(StreamHandler& h, unsigned depth)
+{
+    for (;;) {
+        const StringRef name = readPlainString();
+        if (name.empty()) {
+            need(1);
+            if (*_pos == OBJECT_END_AMF0) {
+                ++_pos;
+                return;
+            }
+        }
+        h.property(name);
+        readAMF0(h, depth + 1);
+    }
+}
+
+void
+StreamReader::readAMF0(StreamHandler& h, unsigned depth)
+{
+    if (depth > MAX_DEPTH) {
+        throw AMFException(_("AMF values nested too deeply"));
+    }
+
+    const std::uint8_t type = readByte();
+
+#ifdef GNASH_DEBUG_AMF_DESERIALIZE
+    log_debug("amf0 stream read type %d", static_cast<int>(type));
+#endif
+
+    switch (type) {
+
+        case NUMBER_AMF0:
+            h.number(readDouble());
+            return;
+
+        case BOOLEAN_AMF0:
+            h.boolean(readByte());
+            return;
+
+        case STRING_AMF0:
+            h.string(readPlainString());
+            return;
+
+        case LONG_STRING_AMF0:
+            h.string(readBytes(readLong()));
+            return;
+
+        case XML_OBJECT_AMF0:
+            h.xml(readBytes(readLong()));
+            return;
+
+        case NULL_AMF0:
+            h.null();
+            return;
+
+        case UNDEFINED_AMF0:
+            h.undefined();
+            return;
+
+        case REFERENCE_AMF0:
+            h.reference(readShort());
+            return;
+
+        case DATE_AMF0:
+        {
+            const double d = readDouble();
+            // The timezone is always ignored.
+            readShort();
+            h.date(d);
+            return;
+        }
+
+        case OBJECT_AMF0:
+            ++_objects;
+            h.startObject(StringRef());
+            readAMF0Properties(h, depth);
+            h.endObject();
+            return;
+
+        case TYPED_OBJECT_AMF0:
+        {
+            ++_objects;
+            const StringRef className = readPlainString();
+            h.startObject(className);
+            readAMF0Properties(h, depth);
+            h.endObject();
+            return;
+        }
+
+        case ECMA_ARRAY_AMF0:
+            ++_objects;
+            h.startECMAArray(readLong());
+            readAMF0Properties(h, depth);
+            h.endArray();
+            return;
+
+        case STRICT_ARRAY_AMF0:
+        {
+            ++_objects;
+            const std::uint32_t length = readLong();
+            // Every element takes at least a byte, so don't trust a
+            // length the buffer can't possibly hold.
+            need(length);
+            h.startArray(length);
+            for (std::uint32_t i = 0; i < length; ++i) {
+                readAMF0(h, depth + 1);
+            }
+            h.endArray();
+            return;
+        }
+
+        case AVMPLUS_OBJECT_AMF0:
+            readAMF3(h, depth);
+            return;
+
+        case UNSUPPORTED_AMF0:
+        case MOVIECLIP_AMF0:
+        case RECORD_SET_AMF0:
+            h.unsupported(type);
+            return;
+
+        default:
+            throw AMFException(_("Unknown AMF0 type"));
+    }
+}
+
+std::uint32_t
+StreamReader::readU29()
+{
+    std::uint32_t v = 0;
+    for (int i = 0; i < 3; ++i) {
+        const std::uint8_t b = readByte();
+        v = (v << 7) | (b & 0x7f);
+        if (!(b & 0x80)) return v;
+    }
+    // The fourth byte contributes all 8 bits.
+    return (v << 8) | readByte();
+}
+
+StringRef
+StreamReader::readString3()
+{
+    const std::uint32_t u = readU29();
+    if (!(u & 1)) {
+        const size_t index = u >> 1;
+        if (index >= _strings.size()) {
+            throw AMFException(_("Invalid AMF3 string reference"));
+        }
+        return _strings[index];
+    }
+    const StringRef s = readBytes(u >> 1);
+    // The empty string is never sent as a reference.
+    if (!s.empty()) _strings.push_back(s);
+    return s;
+}
+
+void
+StreamReader::readAMF3(StreamHandler& h, unsigned depth)
+{
+    if (depth > MAX_DEPTH) {
+        throw AMFException(_("AMF values nested too deeply"));
+    }
+
+    const std::uint8_t type = readByte();
+
+#ifdef GNASH_DEBUG_AMF_DESERIALIZE
+    log_debug("amf3 stream read type %d", static_cast<int>(type));
+#endif
+
+    switch (type) {
+
+        case UNDEFINED_AMF3:
+            h.undefined();
+            return;
+
+        case NULL_AMF3:
+            h.null();
+            return;
+
+        case FALSE_AMF3:
+            h.boolean(false);
+            return;
+
+        case TRUE_AMF3:
+            h.boolean(true);
+            return;
+
+        case INTEGER_AMF3:
+        {
+            // Sign extend the 29 bit value.
+            const std::uint32_t u = readU29();
+            h.integer(static_cast<std::int32_t>(u << 3) >> 3);
+            return;
+        }
+
+        case DOUBLE_AMF3:
+            h.number(readDouble());
+            return;
+
+        case STRING_AMF3:
+            h.string(readString3());
+            return;
+
+        case XML_DOC_AMF3:
+        case XML_AMF3:
+        case DATE_AMF3:
+        case BYTE_ARRAY_AMF3:
+        {
+            const std::uint32_t u = readU29();
+            if (!(u & 1)) {
+                h.reference(u >> 1);
+                return;
+            }
+            ++_objects;
+            if (type == DATE_AMF3) {
+                h.date(readDouble());
+                return;
+            }
+            const StringRef data = readBytes(u >> 1);
+            if (type == BYTE_ARRAY_AMF3) {
+                h.byteArray(reinterpret_cast<const std::uint8_t*>(data.data),
+                        data.size);
+            }
+            else {
+                h.xml(data);
+            }
+            return;
+        }
+
+        case ARRAY_AMF3:
+            readArray3(h, depth);
+            return;
+
+        case OBJECT_AMF3:
+            readObject3(h, depth);
+            return;
+
+        case VECTOR_INT_AMF3:
+        case VECTOR_UINT_AMF3:
+        case VECTOR_DOUBLE_AMF3:
+        {
+            const std::uint32_t u = readU29();
+            if (!(u & 1)) {
+                h.reference(u >> 1);
+                return;
+            }
+            ++_objects;
+            const size_t length = u >> 1;
+            readByte(); // fixed flag
+            const size_t size = (type == VECTOR_DOUBLE_AMF3) ? 8 : 4;
+            need(length * size);
+            h.startArray(length);
+            for (size_t i = 0; i < length; ++i) {
+                if (type == VECTOR_DOUBLE_AMF3) {
+                    h.number(readDouble());
+                }
+                else if (type == VECTOR_INT_AMF3) {
+                    h.integer(static_cast<std::int32_t>(readLong()));
+                }
+                else {
+                    h.number(readLong());
+                }
+            }
+            h.endArray();
+            return;
+        }
+
+        case VECTOR_OBJECT_AMF3:
+        {
+            const std::uint32_t u = readU29();
+            if (!(u & 1)) {
+                h.reference(u >> 1);
+                return;
+            }
+            ++_objects;
+            const size_t length = u >> 1;
+            readByte(); // fixed flag
+            readString3(); // element type name
+            need(length);
+            h.startArray(length);
+            for (size_t i = 0; i < length; ++i) {
+                readAMF3(h, depth + 1);
+            }
+            h.endArray();
+            return;
+        }
+
+        default:
+            // Dictionaries are keyed by objects, which a handler can't
+            // represent, so they are treated like unknown types.
+            throw AMFException(_("Unsupported AMF3 type"));
+    }
+}
+
+void
+StreamReader::readArray3(StreamHandler& h, unsigned depth)
+{
+    const std::uint32_t u = readU29();
+    if (!(u & 1)) {
+        h.reference(u >> 1);
+        return;
+    }
+    ++_objects;
+    const size_t length = u >> 1;
+
+    // An associative part comes first, ending with an empty name. If
+    // there is one this is reported as an ECMA array.
+    StringRef name = readString3();
+    if (!name.empty()) {
+        h.startECMAArray(length);
+        do {
+            h.property(name);
+            readAMF3(h, depth + 1);
+            name = readString3();
+        } while (!name.empty());
+    }
+    else {
+        need(length);
+        h.startArray(length);
+    }
+
+    for (size_t i = 0; i < length; ++i) {
+        readAMF3(h, depth + 1);
+    }
+    h.endArray();
+}
+
+void
+StreamReader::readObject3(StreamHandler& h, unsigned depth)
+{
+    const std::uint32_t u = readU29();
+    if (!(u & 1)) {
+        h.reference(u >> 1);
+        return;
+    }
+    ++_objects;
+
+    size_t index;
+    if (!(u & 2)) {
+        // A reference to traits we've already read.
+        index = u >> 2;
+        if (index >= _traits.size()) {
+            throw AMFException(_("Invalid AMF3 traits reference"));
+        }
+    }
+    else {
+        Traits t;
+        t.externalizable = u & 4;
+        t.dynamic = u & 8;
+        t.memberCount = u >> 4;
+        t.className = readString3();
+        t.firstMember = _members.size();
+        for (size_t i = 0; i < t.memberCount; ++i) {
+            _members.push_back(readString3());
+        }
+        index = _traits.size();
+        _traits.push_back(t);
+    }
+
+    // Copy, as reading members can add more traits.
+    const Traits t = _traits[index];
+
+    if (t.externalizable) {
+        // The format is up to the class, so there is no way to read it.
+        throw AMFException(_("Can't read externalizable AMF3 object"));
+    }
+
+    h.startObject(t.className);
+    for (size_t i = 0; i < t.memberCount; ++i) {
+        h.property(_members[t.firstMember + i]);
+        readAMF3(h, depth + 1);
+    }
+    if (t.dynamic) {
+        for (;;) {
+            const StringRef name = readString3();
+            if (name.empty()) break;
+            h.property(name);
+            readAMF3(h, depth + 1);
+        }
+    }
+    h.endObject();
+}
+
+} // namespace amf
+} // namespace gnash
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
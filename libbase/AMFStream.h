@@ -0,0 +1,513 @@
+// AMFStream.h    Streaming AMF0/AMF3 reader and writer.
+//
+//   Copyright (C) 2005, 2006, 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+// This file provides an event based AMF reader, which reports each value
+// to a handler as it is parsed instead of building a tree of objects, and
+// a writer that encodes values straight into a buffer. Neither allocates
+// memory for primitive values or strings, which are passed around as
+// references into the buffer being read.
+//
+// Like AMF.h it can be used without reliance on libcore, and is shared
+// by the player and by Cygnal.
+
+#ifndef GNASH_AMFSTREAM_H
+#define GNASH_AMFSTREAM_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstring>
+#include <cstdint>
+
+#include "dsodefs.h"
+#include "AMF.h"
+#include "SimpleBuffer.h"
+
+namespace gnash {
+namespace amf {
+
+/// AMF3 type markers, used after an AVMPLUS_OBJECT_AMF0 marker.
+enum AMF3Type {
+    UNDEFINED_AMF3     = 0x00,
+    NULL_AMF3          = 0x01,
+    FALSE_AMF3         = 0x02,
+    TRUE_AMF3          = 0x03,
+    INTEGER_AMF3       = 0x04,
+    DOUBLE_AMF3        = 0x05,
+    STRING_AMF3        = 0x06,
+    XML_DOC_AMF3       = 0x07,
+    DATE_AMF3          = 0x08,
+    ARRAY_AMF3         = 0x09,
+    OBJECT_AMF3        = 0x0a,
+    XML_AMF3           = 0x0b,
+    BYTE_ARRAY_AMF3    = 0x0c,
+    VECTOR_INT_AMF3    = 0x0d,
+    VECTOR_UINT_AMF3   = 0x0e,
+    VECTOR_DOUBLE_AMF3 = 0x0f,
+    VECTOR_OBJECT_AMF3 = 0x10,
+    DICTIONARY_AMF3    = 0x11
+};
+
+/// A string inside an AMF buffer.
+//
+/// This points into the buffer being read, so it is only valid for as
+/// long as that buffer is.
+struct StringRef
+{
+    StringRef() : data(nullptr), size(0) {}
+
+    StringRef(const char* d, size_t s) : data(d), size(s) {}
+
+    /// Copy the string. This is the only place that allocates.
+    std::string str() const {
+        return size ? std::string(data, size) : std::string();
+    }
+
+    bool empty() const { return !size; }
+
+    bool operator==(const char* s) const {
+        return std::strlen(s) == size && !std::memcmp(data, s, size);
+    }
+
+    bool operator!=(const char* s) const { return !(*this == s); }
+
+    bool operator==(const std::string& s) const {
+        return s.size() == size && !s.compare(0, size, data, size);
+    }
+
+    const char* data;
+    size_t size;
+};
+
+inline std::ostream&
+operator<<(std::ostream& o, const StringRef& s)
+{
+    return o.write(s.data, s.size);
+}
+
+/// Receives the values found by a StreamReader.
+//
+/// The default implementation of every method ignores the value, so
+/// handlers only need to override what they are interested in.
+/// Containers are reported as a start event, followed by their members
+/// and a matching end event. Object and ECMA array members are preceded
+/// by a call to property() with the member name.
+class DSOEXPORT StreamHandler
+{
+public:
+    virtual ~StreamHandler() {}
+
+    virtual void number(double /*d*/) {}
+
+    /// An AMF3 integer. By default this is reported as a number.
+    virtual void integer(std::int32_t i) { number(i); }
+
+    virtual void boolean(bool /*b*/) {}
+
+    virtual void string(const StringRef& /*s*/) {}
+
+    virtual void null() {}
+
+    virtual void undefined() {}
+
+    /// A reference to a previously read object, array or date.
+    virtual void reference(size_t /*index*/) {}
+
+    /// A date, in milliseconds since the epoch.
+    virtual void date(double /*ms*/) {}
+
+    virtual void xml(const StringRef& /*s*/) {}
+
+    virtual void byteArray(const std::uint8_t* /*data*/, size_t /*size*/) {}
+
+    /// The start of an object. The class name is empty for anonymous
+    /// objects.
+    virtual void startObject(const StringRef& /*className*/) {}
+
+    virtual void endObject() {}
+
+    /// The start of a strict (dense) array of the given length.
+    virtual void startArray(size_t /*length*/) {}
+
+    /// The start of an ECMA (associative) array. The length is only a
+    /// hint.
+    virtual void startECMAArray(size_t /*length*/) {}
+
+    virtual void endArray() {}
+
+    /// The name of the next object or ECMA array member.
+    virtual void property(const StringRef& /*name*/) {}
+
+    /// A value the reader knows how to skip, but not how to report.
+    virtual void unsupported(std::uint8_t /*type*/) {}
+};
+
+/// Read AMF0 values, and AMF3 values embedded in them, from a buffer.
+//
+/// Each call to operator() parses one complete value, reporting it and
+/// anything nested in it to the handler. The reader keeps the AMF3
+/// reference tables, which point into the buffer, and reuses their
+/// storage after reset(), so a long lived reader doesn't allocate once
+/// it has seen the largest message.
+///
+/// Malformed input throws an AMFException.
+class DSOEXPORT StreamReader
+{
+public:
+
+    StreamReader(const std::uint8_t* pos, const std::uint8_t* end);
+
+    /// Start reading a new message, forgetting any references.
+    void reset(const std::uint8_t* pos, const std::uint8_t* end);
+
+    /// Read one value.
+    //
+    /// @return false if there is nothing left to read.
+    bool operator()(StreamHandler& h);
+
+    /// Skip one value.
+    //
+    /// @return false if there is nothing left to read.
+    bool skip();
+
+    /// Read an AMF0 object property, which is a name without a type
+    /// byte followed by a value.
+    //
+    /// @return false if the object end marker was read instead.
+    bool readProperty(StreamHandler& h);
+
+    /// Read an AMF0 string without a type byte, such as a property name.
+    StringRef readPlainString();
+
+    /// The next unread byte.
+    const std::uint8_t* pos() const { return _pos; }
+
+    bool eof() const { return _pos >= _end; }
+
+private:
+
+    /// The traits of an AMF3 object class.
+    struct Traits {
+        StringRef className;
+        bool dynamic;
+        bool externalizable;
+        size_t firstMember;
+        size_t memberCount;
+    };
+
+    void need(size_t bytes) const;
+
+    std::uint8_t readByte();
+    std::uint16_t readShort();
+    std::uint32_t readLong();
+    double readDouble();
+    StringRef readBytes(size_t size);
+
+    void readAMF0(StreamHandler& h, unsigned depth);
+    void readAMF0Properties(StreamHandler& h, unsigned depth);
+
+    void readAMF3(StreamHandler& h, unsigned depth);
+    std::uint32_t readU29();
+    StringRef readString3();
+    void readObject3(StreamHandler& h, unsigned depth);
+    void readArray3(StreamHandler& h, unsigned depth);
+
+    const std::uint8_t* _pos;
+    const std::uint8_t* _end;
+
+    /// AMF3 strings seen so far, which later strings may refer to.
+    std::vector<StringRef> _strings;
+
+    /// AMF3 class traits seen so far.
+    std::vector<Traits> _traits;
+
+    /// Sealed member names of all traits in _traits.
+    std::vector<StringRef> _members;
+
+    /// Number of objects seen, for AMF0 and AMF3 references.
+    size_t _objects;
+};
+
+/// Append raw bytes to a SimpleBuffer.
+//
+/// StreamWriter finds the function to use for its buffer type by
+/// argument dependent lookup, so other buffer classes can be supported
+/// by defining an overload in their namespace.
+inline void
+appendBytes(SimpleBuffer& buf, const void* data, size_t size)
+{
+    buf.append(data, size);
+}
+
+/// Encode AMF values straight into a buffer.
+//
+/// This writes AMF0, and AMF3 values prefixed with the AVMPLUS_OBJECT_AMF0
+/// marker. Objects are written as a call to startObject(), pairs of
+/// property() and a value, and endObject().
+template<typename Buf>
+class StreamWriter
+{
+public:
+
+    explicit StreamWriter(Buf& buf) : _buf(buf) {}
+
+    StreamWriter& number(double d) {
+        putByte(NUMBER_AMF0);
+        putDouble(d);
+        return *this;
+    }
+
+    StreamWriter& boolean(bool b) {
+        putByte(BOOLEAN_AMF0);
+        putByte(b ? 1 : 0);
+        return *this;
+    }
+
+    /// Write a string, using the long string type when needed.
+    StreamWriter& string(const char* s, size_t size) {
+        if (size < 65536) {
+            putByte(STRING_AMF0);
+            putShort(size);
+        }
+        else {
+            putByte(LONG_STRING_AMF0);
+            putLong(size);
+        }
+        put(s, size);
+        return *this;
+    }
+
+    StreamWriter& string(const char* s) {
+        return string(s, std::strlen(s));
+    }
+
+    StreamWriter& string(const std::string& s) {
+        return string(s.data(), s.size());
+    }
+
+    StreamWriter& string(const StringRef& s) {
+        return string(s.data, s.size);
+    }
+
+    StreamWriter& null() {
+        putByte(NULL_AMF0);
+        return *this;
+    }
+
+    StreamWriter& undefined() {
+        putByte(UNDEFINED_AMF0);
+        return *this;
+    }
+
+    StreamWriter& reference(std::uint16_t index) {
+        putByte(REFERENCE_AMF0);
+        putShort(index);
+        return *this;
+    }
+
+    /// Write a date in milliseconds since the epoch, as UTC.
+    StreamWriter& date(double ms) {
+        putByte(DATE_AMF0);
+        putDouble(ms);
+        putShort(0);
+        return *this;
+    }
+
+    StreamWriter& startObject() {
+        putByte(OBJECT_AMF0);
+        return *this;
+    }
+
+    StreamWriter& startTypedObject(const std::string& className) {
+        putByte(TYPED_OBJECT_AMF0);
+        plainString(className.data(), className.size());
+        return *this;
+    }
+
+    /// Write a member name, which must be followed by its value.
+    StreamWriter& property(const char* name, size_t size) {
+        plainString(name, size);
+        return *this;
+    }
+
+    StreamWriter& property(const char* name) {
+        return property(name, std::strlen(name));
+    }
+
+    StreamWriter& property(const std::string& name) {
+        return property(name.data(), name.size());
+    }
+
+    StreamWriter& endObject() {
+        putShort(0);
+        putByte(OBJECT_END_AMF0);
+        return *this;
+    }
+
+    StreamWriter& startECMAArray(std::uint32_t length) {
+        putByte(ECMA_ARRAY_AMF0);
+        putLong(length);
+        return *this;
+    }
+
+    StreamWriter& endECMAArray() {
+        return endObject();
+    }
+
+    /// Start a strict array, which must be followed by length values.
+    StreamWriter& startStrictArray(std::uint32_t length) {
+        putByte(STRICT_ARRAY_AMF0);
+        putLong(length);
+        return *this;
+    }
+
+    /// @name AMF3 values
+    ///
+    /// Each of these writes one AMF3 value, including the marker that
+    /// switches an AMF0 stream to AMF3 for it. Strings are always
+    /// written inline rather than as references.
+    /// @{
+
+    StreamWriter& integer3(std::int32_t i) {
+        // Only 29 bits fit, anything else has to be a double.
+        if (i < -0x10000000 || i > 0x0fffffff) {
+            return number3(i);
+        }
+        putByte(AVMPLUS_OBJECT_AMF0);
+        putByte(INTEGER_AMF3);
+        putU29(static_cast<std::uint32_t>(i) & 0x1fffffff);
+        return *this;
+    }
+
+    StreamWriter& number3(double d) {
+        putByte(AVMPLUS_OBJECT_AMF0);
+        putByte(DOUBLE_AMF3);
+        putDouble(d);
+        return *this;
+    }
+
+    StreamWriter& string3(const char* s, size_t size) {
+        putByte(AVMPLUS_OBJECT_AMF0);
+        putByte(STRING_AMF3);
+        putU29((size << 1) | 1);
+        put(s, size);
+        return *this;
+    }
+
+    StreamWriter& string3(const std::string& s) {
+        return string3(s.data(), s.size());
+    }
+
+    StreamWriter& boolean3(bool b) {
+        putByte(AVMPLUS_OBJECT_AMF0);
+        putByte(b ? TRUE_AMF3 : FALSE_AMF3);
+        return *this;
+    }
+
+    StreamWriter& null3() {
+        putByte(AVMPLUS_OBJECT_AMF0);
+        putByte(NULL_AMF3);
+        return *this;
+    }
+
+    /// @}
+
+    /// Write a string without a type byte, with a 2-byte length.
+    StreamWriter& plainString(const char* s, size_t size) {
+        putShort(size);
+        put(s, size);
+        return *this;
+    }
+
+    Buf& buffer() { return _buf; }
+
+private:
+
+    void put(const void* data, size_t size) {
+        if (size) appendBytes(_buf, data, size);
+    }
+
+    void putByte(std::uint8_t b) {
+        put(&b, 1);
+    }
+
+    void putShort(std::uint16_t s) {
+        const std::uint8_t b[2] = {
+            static_cast<std::uint8_t>(s >> 8),
+            static_cast<std::uint8_t>(s)
+        };
+        put(b, 2);
+    }
+
+    void putLong(std::uint32_t l) {
+        const std::uint8_t b[4] = {
+            static_cast<std::uint8_t>(l >> 24),
+            static_cast<std::uint8_t>(l >> 16),
+            static_cast<std::uint8_t>(l >> 8),
+            static_cast<std::uint8_t>(l)
+        };
+        put(b, 4);
+    }
+
+    void putDouble(double d) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &d, 8);
+        std::uint8_t b[8];
+        for (int i = 7; i >= 0; --i) {
+            b[i] = static_cast<std::uint8_t>(bits);
+            bits >>= 8;
+        }
+        put(b, 8);
+    }
+
+    void putU29(std::uint32_t v) {
+        std::uint8_t b[4];
+        size_t n;
+        if (v < 0x80) {
+            b[0] = v;
+            n = 1;
+        }
+        else if (v < 0x4000) {
+            b[0] = (v >> 7) | 0x80;
+            b[1] = v & 0x7f;
+            n = 2;
+        }
+        else if (v < 0x200000) {
+            b[0] = (v >> 14) | 0x80;
+            b[1] = ((v >> 7) & 0x7f) | 0x80;
+            b[2] = v & 0x7f;
+            n = 3;
+        }
+        else {
+            b[0] = (v >> 22) | 0x80;
+            b[1] = ((v >> 15) & 0x7f) | 0x80;
+            b[2] = ((v >> 8) & 0x7f) | 0x80;
+            b[3] = v & 0xff;
+            n = 4;
+        }
+        put(b, n);
+    }
+
+    Buf& _buf;
+};
+
+} // namespace amf
+} // namespace gnash
+
+#endif
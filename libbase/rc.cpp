@@ -121,7 +121,10 @@ RcInitFile::RcInitFile()
     _ignoreShowMenu(true),
     _scriptsTimeout(15),
     _scriptsRecursionLimit(256),
-    _lockScriptLimits(false)
+    _lockScriptLimits(false),
+    _renderThread(false),
+    _bitmapCacheLimit(32),
+    _framePacing(false)
 {
     expandPath(_solsandbox);
     loadFiles();
@@ -620,6 +623,15 @@ RcInitFile::parseFile(const std::string& filespec)
 			||
                  extractSetting(_lockScriptLimits, "lockScriptLimits", variable,
                            value)
+            ||
+                 extractSetting(_renderThread, "renderThread", variable,
+                           value)
+            ||
+                 extractNumber(_bitmapCacheLimit, "bitmapCacheLimit",
+                         variable, value)
+            ||
+                 extractSetting(_framePacing, "framePacing", variable,
+                           value)
             ||
                  cerr << boost::format(_("Warning: unrecognized directive "
                              "\"%s\" in rcfile %s line %d")) 
@@ -785,6 +797,9 @@ RcInitFile::updateFile(const std::string& filespec)
     cmd << "scriptsTimeout " << _scriptsTimeout << endl <<
     cmd << "scriptsRecursionLimit " << _scriptsRecursionLimit << endl <<
     cmd << "lockScriptLimits " << _lockScriptLimits << endl <<
+    cmd << "renderThread " << _renderThread << endl <<
+    cmd << "bitmapCacheLimit " << _bitmapCacheLimit << endl <<
+    cmd << "framePacing " << _framePacing << endl <<
    
     // Strings.
 
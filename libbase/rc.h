@@ -358,6 +358,18 @@ public:
 
     bool lockScriptLimits() const { return _lockScriptLimits; }
 
+    void useRenderThread(bool x) { _renderThread = x; }
+
+    bool useRenderThread() const { return _renderThread; }
+
+    int getBitmapCacheLimit() const { return _bitmapCacheLimit; }
+
+    void setBitmapCacheLimit(int x) { _bitmapCacheLimit = x; }
+
+    void useFramePacing(bool x) { _framePacing = x; }
+
+    bool useFramePacing() const { return _framePacing; }
+
     void dump();    
 
 protected:
@@ -624,6 +636,18 @@ protected:
 
     /// Whether to ignore SWF ScriptLimits tags 
     bool _lockScriptLimits;
+
+    /// Whether frames are drawn on their own thread, while the
+    /// next frame is advanced.
+    bool _renderThread;
+
+    /// The memory that the bitmaps of cacheAsBitmap DisplayObjects
+    /// may use, in megabytes.
+    std::uint32_t _bitmapCacheLimit;
+
+    /// Whether late frames are skipped and the quality lowered to keep
+    /// up with the frame rate.
+    bool _framePacing;
 };
 
 // End of gnash namespace 
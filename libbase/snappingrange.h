@@ -493,40 +493,70 @@ public:
     }
     
     /// Combines known ranges. Previously merged ranges may have come close
-    /// to other ranges. Algorithm could be optimized. 
+    /// to other ranges.
+    //
+    /// The ranges are sorted by their left edge, so that each range is only
+    /// tested against those starting close enough to its right edge to
+    /// snap to it. For many small ranges this is much less than testing
+    /// every pair.
     void combineRanges() const {
     
         // makes no sense in single mode
         if (_singleMode) return;
     
-        bool restart = true;
-        
         _combineCounter = 0;
-        
-        while (restart) {
-        
-            int rcount = _ranges.size();
 
-            restart=false;
-        
-            for (int i=0; i<rcount; i++) {
-            
-                for (int j=i+1; j<rcount; j++) {
-                
-                    if (snaptest(_ranges[i], _ranges[j], _snapFactor)) {
-                        // merge i + j
-                        _ranges[i].expandTo(_ranges[j]);
-                        
-                        _ranges.erase(_ranges.begin() + j);
-                        
-                        restart=true; // restart from beginning
-                        break;
-                        
-                    } 
-                } 
-                
-                if (restart) break;
-            } 
+        // A WORLD range is always alone, so it is never looked at here.
+        bool merged = true;
+        while (merged && _ranges.size() > 1) {
+
+            merged = false;
+
+            std::sort(_ranges.begin(), _ranges.end(),
+                    [](const RangeType& a, const RangeType& b) {
+                        return a.getMinX() < b.getMinX();
+                    });
+
+            double widest = 0;
+            for (const RangeType& r : _ranges) {
+                widest = std::max<double>(widest, r.width());
+            }
+
+            const size_type count = _ranges.size();
+            std::vector<bool> gone(count);
+
+            for (size_type i = 0; i != count; ++i) {
+
+                if (gone[i]) continue;
+
+                RangeType& r = _ranges[i];
+                double reach = snapReach(r, widest);
+
+                for (size_type j = i + 1; j != count; ++j) {
+
+                    if (_ranges[j].getMinX() > reach) break;
+                    if (gone[j] || !snaptest(r, _ranges[j], _snapFactor)) {
+                        continue;
+                    }
+
+                    // Ranges already passed may snap to the merged one,
+                    // so there is another pass.
+                    r.expandTo(_ranges[j]);
+                    gone[j] = true;
+                    merged = true;
+
+                    widest = std::max<double>(widest, r.width());
+                    reach = snapReach(r, widest);
+                }
+            }
+
+            if (merged) {
+                size_type kept = 0;
+                for (size_type i = 0; i != count; ++i) {
+                    if (!gone[i]) _ranges[kept++] = _ranges[i];
+                }
+                _ranges.resize(kept);
+            }
         } 
         
         // limit number of ranges
@@ -578,6 +608,19 @@ public:
 private:
 
     
+    /// The left edge beyond which no range can snap to the given one, if
+    /// none is wider than the given width.
+    //
+    /// Snapping to a range whose left edge is some distance past the right
+    /// edge of this one makes the merged range at least that much wider
+    /// than both together, which the snap factor only allows for ranges
+    /// that are close enough. Two units are added for integer ranges,
+    /// whose area includes their edges.
+    double snapReach(const RangeType& r, double widest) const {
+        return r.getMaxX() + (_snapFactor - 1.0) * (r.width() + widest + 2)
+            + 1;
+    }
+
     /// Calls combineRanges() once in a while, but not always. Avoids too many
     /// combineRanges() checks, which could slow down everything.
     void combineRangesLazy() const {
@@ -0,0 +1,290 @@
+// BitmapCache.cpp: bitmaps of cacheAsBitmap DisplayObjects
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "BitmapCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "CachedBitmap.h"
+#include "DisplayObject.h"
+#include "FillStyle.h"
+#include "Filters.h"
+#include "Geometry.h"
+#include "GnashImage.h"
+#include "GnashNumeric.h"
+#include "Renderer.h"
+#include "SWFRect.h"
+#include "Transform.h"
+
+namespace gnash {
+
+namespace {
+
+/// The biggest bitmap drawn for a DisplayObject, in pixels.
+//
+/// This is the same as the biggest BitmapData.
+const size_t maxBitmapSize = 2880;
+
+}
+
+BitmapCachePool::BitmapCachePool(size_t limit)
+    :
+    _limit(limit)
+{
+}
+
+void
+BitmapCachePool::setLimit(size_t limit)
+{
+    _limit = limit;
+    while (_stats.bytes > _limit) {
+        assert(!_caches.empty());
+        _caches.back()->drop();
+        ++_stats.evicted;
+    }
+}
+
+bool
+BitmapCachePool::reserve(size_t bytes, BitmapCache& cache)
+{
+    if (bytes > _limit) return false;
+
+    while (_stats.bytes + bytes > _limit) {
+        assert(!_caches.empty());
+        _caches.back()->drop();
+        ++_stats.evicted;
+    }
+
+    _caches.push_front(&cache);
+    cache._used = _caches.begin();
+    _stats.bytes += bytes;
+    ++_stats.surfaces;
+    return true;
+}
+
+void
+BitmapCachePool::used(BitmapCache& cache)
+{
+    _caches.splice(_caches.begin(), _caches, cache._used);
+}
+
+void
+BitmapCachePool::release(BitmapCache& cache)
+{
+    _caches.erase(cache._used);
+    _stats.bytes -= cache._bytes;
+    --_stats.surfaces;
+}
+
+BitmapCache::BitmapCache(std::shared_ptr<BitmapCachePool> pool)
+    :
+    _pool(std::move(pool)),
+    _bytes(0),
+    _renderer(nullptr),
+    _incapable(nullptr),
+    _scale(0),
+    _x(0),
+    _y(0),
+    _dirty(true)
+{
+    assert(_pool);
+}
+
+BitmapCache::~BitmapCache()
+{
+    drop();
+}
+
+bool
+BitmapCache::prepare(DisplayObject& obj, Renderer& renderer,
+        const Transform& xform)
+{
+    if (&renderer == _incapable) return false;
+
+    // The bitmap has to have as many pixels as the stage has on the
+    // screen to look the same as the vectors.
+    const geometry::Range2d<int> unit = renderer.world_to_pixel(
+            SWFRect(0, 0, pixelsToTwips(1000), pixelsToTwips(1000)));
+    if (!unit.isFinite()) return false;
+
+    const double scale = unit.width() / 1000.0;
+    if (scale <= 0) return false;
+
+    // Only moving the DisplayObject can be done with the same bitmap.
+    const SWFMatrix& world = xform.matrix;
+    const bool same = _bytes && !_dirty && &renderer == _renderer &&
+        scale == _scale &&
+        world.a() == _matrix.a() && world.b() == _matrix.b() &&
+        world.c() == _matrix.c() && world.d() == _matrix.d();
+
+    if (same) {
+        ++_pool->_stats.hits;
+    }
+    else {
+        if (!redraw(obj, renderer, world, scale)) return false;
+        ++_pool->_stats.redraws;
+    }
+
+    _pool->used(*this);
+    return true;
+}
+
+void
+BitmapCache::display(Renderer& renderer, const Transform& xform) const
+{
+    assert(_bytes);
+
+    const SWFMatrix& world = xform.matrix;
+
+    SWFMatrix place;
+    place.set_scale(1 / _scale, 1 / _scale);
+    place.set_translation(_x + world.tx() - _matrix.tx(),
+            _y + world.ty() - _matrix.ty());
+
+    _shape.display(renderer, Transform(place, xform.colorTransform));
+}
+
+bool
+BitmapCache::redraw(DisplayObject& obj, Renderer& renderer,
+        const SWFMatrix& world, double scale)
+{
+    SWFRect bounds = obj.getBounds();
+    if (bounds.is_null()) {
+        drop();
+        return false;
+    }
+
+    // From the DisplayObject to device pixels, in twips.
+    SWFMatrix device;
+    device.set_scale(scale, scale);
+    device.concatenate(world);
+    device.transform(bounds);
+
+    // A pixel around the edges leaves room for antialiasing, and the
+    // filters need room for what they draw outside the contents.
+    const Filters* filters = obj.filters().get();
+    const int margin = 1 + (filters ?
+            std::ceil(filtersMargin(*filters) * scale) : 0);
+
+    const int x0 = std::floor(twipsToPixels(bounds.get_x_min())) - margin;
+    const int y0 = std::floor(twipsToPixels(bounds.get_y_min())) - margin;
+    const int x1 = std::ceil(twipsToPixels(bounds.get_x_max())) + margin;
+    const int y1 = std::ceil(twipsToPixels(bounds.get_y_max())) + margin;
+
+    const size_t width = x1 - x0;
+    const size_t height = y1 - y0;
+
+    if (width > maxBitmapSize || height > maxBitmapSize) {
+        ++_pool->_stats.refused;
+        drop();
+        return false;
+    }
+
+    // A bitmap of the same size keeps its place in the pool, but the
+    // contents always go into a new one. Renderers may have copied the
+    // old one, such as into a texture, or still be drawing with it.
+    const size_t bytes = width * height * 4;
+    if (bytes != _bytes || &renderer != _renderer) {
+        drop();
+        if (!_pool->reserve(bytes, *this)) {
+            ++_pool->_stats.refused;
+            return false;
+        }
+        _bytes = bytes;
+    }
+
+    std::unique_ptr<image::GnashImage> im(
+            new image::ImageRGBA(width, height));
+    std::fill(im->begin(), im->end(), 0);
+
+    device.set_translation(device.tx() - pixelsToTwips(x0),
+            device.ty() - pixelsToTwips(y0));
+
+    {
+        Renderer::Internal in(renderer, *im);
+        Renderer* internal = in.renderer();
+        if (!internal) {
+            _incapable = &renderer;
+            drop();
+            return false;
+        }
+        obj.drawContents(*internal, Transform(device));
+
+        if (filters) {
+            for (const auto& f : *filters) f->apply(*im, scale);
+        }
+    }
+
+    _bitmap = renderer.createCachedBitmap(std::move(im));
+    if (!_bitmap) {
+        _incapable = &renderer;
+        drop();
+        return false;
+    }
+
+    const std::int32_t w = pixelsToTwips(width);
+    const std::int32_t h = pixelsToTwips(height);
+
+    SWFMatrix mat;
+    mat.set_scale(1.0 / 20, 1.0 / 20);
+    const FillStyle fill = BitmapFill(BitmapFill::CLIPPED, _bitmap.get(),
+            mat, BitmapFill::SMOOTHING_UNSPECIFIED);
+
+    _shape.clear();
+    const size_t fillLeft = _shape.addFillStyle(fill);
+
+    Path bmpath(w, h, fillLeft, 0, 0);
+    bmpath.drawLineTo(w, 0);
+    bmpath.drawLineTo(0, 0);
+    bmpath.drawLineTo(0, h);
+    bmpath.drawLineTo(w, h);
+
+    _shape.add_path(bmpath);
+    _shape.setBounds(SWFRect(0, 0, w, h));
+    _shape.finalize();
+
+    _renderer = &renderer;
+    _matrix = world;
+    _scale = scale;
+    _x = pixelsToTwips(x0 / scale);
+    _y = pixelsToTwips(y0 / scale);
+    _dirty = false;
+    return true;
+}
+
+void
+BitmapCache::drop()
+{
+    if (_bytes) {
+        _pool->release(*this);
+        _bytes = 0;
+    }
+    _bitmap.reset();
+    _shape.clear();
+    _dirty = true;
+}
+
+} // namespace gnash
+
+// Local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
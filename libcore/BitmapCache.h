@@ -0,0 +1,224 @@
+// BitmapCache.h: bitmaps of cacheAsBitmap DisplayObjects
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#ifndef GNASH_BITMAPCACHE_H
+#define GNASH_BITMAPCACHE_H
+
+#include <list>
+#include <memory>
+#include <boost/noncopyable.hpp>
+#include <boost/intrusive_ptr.hpp>
+
+#include "DynamicShape.h"
+#include "SWFMatrix.h"
+
+namespace gnash {
+    class BitmapCache;
+    class CachedBitmap;
+    class DisplayObject;
+    class Renderer;
+    class Transform;
+}
+
+namespace gnash {
+
+/// The memory used by the BitmapCaches of a movie.
+//
+/// All the bitmaps together may only use a limited amount of memory.
+/// When a new one doesn't fit, the ones that were drawn least recently are
+/// dropped, and they are drawn again the next time their DisplayObject is
+/// displayed.
+class BitmapCachePool : boost::noncopyable
+{
+public:
+
+    /// How the caches are doing.
+    struct Stats
+    {
+        Stats()
+            :
+            surfaces(0),
+            bytes(0),
+            hits(0),
+            redraws(0),
+            refused(0),
+            evicted(0)
+        {}
+
+        /// The number of bitmaps held.
+        size_t surfaces;
+
+        /// The memory the bitmaps use.
+        size_t bytes;
+
+        /// How often a bitmap was displayed without drawing it.
+        size_t hits;
+
+        /// How often a bitmap was drawn.
+        size_t redraws;
+
+        /// How often a bitmap was too big to keep.
+        size_t refused;
+
+        /// How many bitmaps were dropped to make room for others.
+        size_t evicted;
+    };
+
+    /// Create a pool.
+    //
+    /// @param limit    The most memory the bitmaps may use, in bytes.
+    explicit BitmapCachePool(size_t limit);
+
+    void setLimit(size_t limit);
+
+    size_t limit() const {
+        return _limit;
+    }
+
+    const Stats& stats() const {
+        return _stats;
+    }
+
+private:
+
+    friend class BitmapCache;
+
+    typedef std::list<BitmapCache*> Caches;
+
+    /// Make room for a bitmap.
+    //
+    /// @param bytes    The size of the bitmap.
+    /// @param cache    The cache that wants it, which must not hold a
+    ///                 bitmap.
+    /// @return         false if the bitmap can't fit.
+    bool reserve(size_t bytes, BitmapCache& cache);
+
+    /// Mark the bitmap of a cache as the most recently used one.
+    void used(BitmapCache& cache);
+
+    /// Give back the memory of a cache's bitmap.
+    void release(BitmapCache& cache);
+
+    /// The caches holding a bitmap, the most recently used first.
+    Caches _caches;
+
+    size_t _limit;
+
+    Stats _stats;
+};
+
+/// A bitmap of a DisplayObject, and all its children.
+//
+/// The DisplayObject is drawn into the bitmap using the renderer's
+/// internal rendering, in the device pixels of the stage. The bitmap is
+/// displayed instead of the DisplayObject for as long as its contents
+/// don't change, and it isn't scaled, rotated or skewed. Moving the
+/// DisplayObject, or any of its parents, doesn't need a new bitmap, nor
+/// does changing its color transform, which is applied to the bitmap.
+///
+/// The DisplayObject's filters are applied to the bitmap when it is
+/// drawn, so they are only worked out again when it changes.
+class BitmapCache : boost::noncopyable
+{
+public:
+
+    explicit BitmapCache(std::shared_ptr<BitmapCachePool> pool);
+
+    ~BitmapCache();
+
+    /// Draw the bitmap again the next time it's displayed.
+    void invalidate() {
+        _dirty = true;
+    }
+
+    /// Make sure the bitmap can be displayed with a transform.
+    //
+    /// The bitmap is drawn if it's out of date.
+    ///
+    /// @param obj      The DisplayObject the bitmap is of. Its contents
+    ///                 are drawn with DisplayObject::drawContents().
+    /// @param renderer The renderer to display it with.
+    /// @param xform    The DisplayObject's world transform.
+    /// @return         false if the bitmap can't be used, and the
+    ///                 DisplayObject must be drawn as usual. This happens
+    ///                 when the renderer can't draw to bitmaps, or the
+    ///                 bitmap would be too big.
+    bool prepare(DisplayObject& obj, Renderer& renderer,
+            const Transform& xform);
+
+    /// Display the bitmap.
+    //
+    /// This may only be called after prepare() succeeded for the same
+    /// renderer and transform.
+    void display(Renderer& renderer, const Transform& xform) const;
+
+private:
+
+    friend class BitmapCachePool;
+
+    /// Draw the DisplayObject into a new bitmap.
+    bool redraw(DisplayObject& obj, Renderer& renderer,
+            const SWFMatrix& world, double scale);
+
+    /// Drop the bitmap.
+    void drop();
+
+    const std::shared_ptr<BitmapCachePool> _pool;
+
+    /// A rectangle filled with the bitmap, in device pixels.
+    DynamicShape _shape;
+
+    /// The size of the bitmap in bytes, 0 if there isn't one.
+    size_t _bytes;
+
+    /// The bitmap the shape is filled with.
+    boost::intrusive_ptr<CachedBitmap> _bitmap;
+
+    /// The renderer the bitmap belongs to.
+    const Renderer* _renderer;
+
+    /// A renderer found not to support drawing to bitmaps.
+    const Renderer* _incapable;
+
+    /// The world matrix the bitmap was drawn with.
+    SWFMatrix _matrix;
+
+    /// The device pixels per stage pixel the bitmap was drawn with.
+    double _scale;
+
+    /// Where the bitmap's top left corner was on the stage, in twips.
+    std::int32_t _x;
+    std::int32_t _y;
+
+    /// Whether the contents changed since the bitmap was drawn.
+    bool _dirty;
+
+    /// This cache's place in the pool, if it holds a bitmap.
+    BitmapCachePool::Caches::iterator _used;
+};
+
+} // namespace gnash
+
+#endif
+
+// Local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
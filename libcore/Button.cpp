@@ -47,6 +47,7 @@
 #include "sound_definition.h"
 #include "Transform.h"
 #include "sound_handler.h"
+#include "flash/filters/BitmapFilter_as.h"
 
 /** \page buttons Buttons and mouse behaviour
 
@@ -359,10 +360,26 @@ Button::handleFocus()
 void
 Button::display(Renderer& renderer, const Transform& base)
 {
-    const DisplayObject::MaskRenderer mr(renderer, *this);
-
     const Transform xform = base * transform();
 
+    if (displayCached(renderer, xform)) {
+        DisplayObjects actChars;
+        getActiveCharacters(actChars);
+        for (auto& actChar : actChars) {
+            actChar->omit_display();
+        }
+    }
+    else {
+        const DisplayObject::MaskRenderer mr(renderer, *this);
+        drawContents(renderer, xform);
+    }
+
+    clear_invalidated();
+}
+
+void
+Button::drawContents(Renderer& renderer, const Transform& xform)
+{
     DisplayObjects actChars;
     getActiveCharacters(actChars);
 
@@ -372,8 +389,6 @@ Button::display(Renderer& renderer, const Transform& base)
     for (auto& actChar : actChars) {
         actChar->display(renderer, xform);
     }
-
-    clear_invalidated();
 }
 
 
@@ -723,6 +738,7 @@ Button::set_current_state(MouseState new_state)
 
     // Remember current state
     _mouseState = new_state;
+    invalidateCache();
      
 }
 
@@ -741,6 +757,8 @@ Button::add_invalidated_bounds(InvalidatedRanges& ranges, bool force)
             std::bind(&DisplayObject::add_invalidated_bounds, std::placeholders::_1,
                 std::ref(ranges), force || invalidated())
     );
+
+    addFilterBounds(ranges);
 }
 
 SWFRect
@@ -764,6 +782,27 @@ Button::getBounds() const
     return allBounds;
 }
 
+SWFRect
+Button::computeHitBounds() const
+{
+    SWFRect bounds;
+
+    typedef std::vector<const DisplayObject*> Chars;
+    Chars actChars;
+    getActiveCharacters(actChars);
+    for (Chars::const_iterator i = actChars.begin(), e = actChars.end();
+            i != e; ++i) {
+        bounds.expand_to_rect((*i)->hitBounds());
+    }
+
+    for (DisplayObjects::const_iterator i = _hitCharacters.begin(),
+            e = _hitCharacters.end(); i != e; ++i) {
+        bounds.expand_to_rect((*i)->hitBounds());
+    }
+
+    return bounds;
+}
+
 bool
 Button::pointInShape(std::int32_t x, std::int32_t y) const
 {
@@ -993,8 +1032,12 @@ as_value
 button_cacheAsBitmap(const fn_call& fn)
 {
     Button* obj = ensure<IsDisplayObject<Button> >(fn);
-    LOG_ONCE(log_unimpl(_("Button.cacheAsBitmap")));
-    UNUSED(obj);
+
+    if (!fn.nargs) {
+        return as_value(obj->cacheAsBitmap());
+    }
+
+    obj->setCacheAsBitmap(toBool(fn.arg(0), getVM(fn)));
     return as_value();
 }
 
@@ -1002,8 +1045,13 @@ as_value
 button_filters(const fn_call& fn)
 {
     Button* obj = ensure<IsDisplayObject<Button> >(fn);
-    LOG_ONCE(log_unimpl(_("Button.filters")));
-    UNUSED(obj);
+
+    if (!fn.nargs) {
+        // Getter: copies, so changing them needs the setter.
+        return as_value(fromFilters(obj->filters().get(), fn.env()));
+    }
+
+    obj->setFilters(toFilters(fn.arg(0), getVM(fn)));
     return as_value();
 }
 
@@ -88,6 +88,9 @@ public:
 
     /// Render this Button.
     virtual void display(Renderer& renderer, const Transform& xform);
+
+    /// Draw the characters of the current state, without the mask.
+    virtual void drawContents(Renderer& renderer, const Transform& xform);
     
     void set_current_state(MouseState new_state);
 
@@ -143,6 +146,9 @@ protected:
     ///
     void markOwnResources() const;
 
+    /// The hit bounds of the state and hit DisplayObjects.
+    virtual SWFRect computeHitBounds() const;
+
 private:
 
     /// Returns all DisplayObjects that are active based on the current state.
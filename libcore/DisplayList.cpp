@@ -26,6 +26,7 @@
 #include <stack>
 #include <cassert>
 #include <functional>
+#include <limits>
 #include <boost/format.hpp>
 
 #include "log.h"
@@ -54,20 +55,20 @@ namespace {
     /// 65535 (-16384).
     DisplayList::iterator dlistTagsEffectiveZoneEnd(
             DisplayList::container_type& c);
+
+    /// Return the first element whose depth is not less than the given
+    /// depth, which is where a DisplayObject at that depth belongs.
+    DisplayList::iterator lowerBound(DisplayList::container_type& c,
+            int depth);
+
+    DisplayList::const_iterator lowerBound(
+            const DisplayList::container_type& c, int depth);
 	
 }
 
 /// Anonymous namespace for generic algorithm functors.
 namespace {
 
-struct DepthEquals : std::binary_function<const DisplayObject*, int, bool>
-{
-    bool operator()(const DisplayObject* item, int depth) const {
-        if (!item) return false;
-        return item->get_depth() == depth;
-    }
-};
-
 struct DepthLessThan : std::binary_function<const DisplayObject*, int, bool>
 {
     bool operator()(const DisplayObject* item, int depth) const {
@@ -76,11 +77,12 @@ struct DepthLessThan : std::binary_function<const DisplayObject*, int, bool>
     }
 };
 
-struct DepthGreaterThan : std::binary_function<const DisplayObject*, int, bool>
+/// For std::upper_bound.
+struct DepthBelow : std::binary_function<int, const DisplayObject*, bool>
 {
-    bool operator()(const DisplayObject* item, int depth) const {
+    bool operator()(int depth, const DisplayObject* item) const {
         if (!item) return false;
-        return item->get_depth() > depth;
+        return depth < item->get_depth();
     }
 };
 
@@ -111,6 +113,13 @@ private:
     const ObjectURI& _name;
 };
 
+/// Lists shorter than this are searched for names.
+const size_t minIndexedSize = 8;
+
+/// How many times a list that hasn't changed is searched for names
+/// before they are indexed.
+const size_t indexAfterLookups = 4;
+
 } // anonymous namespace
 
 int
@@ -118,15 +127,9 @@ DisplayList::getNextHighestDepth() const
 {
     testInvariant();
 
-    int nexthighestdepth=0;
-    for (DisplayObject* ch : _charsByDepth) {
-
-        const int chdepth = ch->get_depth();
-        if (chdepth >= nexthighestdepth) {
-            nexthighestdepth = chdepth+1;
-        }
-    }
-    return nexthighestdepth;
+    // The list is sorted, so the last DisplayObject is the highest.
+    if (_charsByDepth.empty()) return 0;
+    return std::max(0, _charsByDepth.back()->get_depth() + 1);
 }
 
 DisplayObject*
@@ -134,16 +137,18 @@ DisplayList::getDisplayObjectAtDepth(int depth) const
 {
     testInvariant();
 
-    for (DisplayObject* ch : _charsByDepth) {
+    for (const_iterator it = lowerBound(_charsByDepth, depth),
+            e = _charsByDepth.end(); it != e; ++it) {
+
+        DisplayObject* ch = *it;
+
+        // non-existent (chars are ordered by depth)
+        if (ch->get_depth() != depth) return nullptr;
 
         // Should not be there!
         if (ch->isDestroyed()) continue;
 
-        // found
-        if (ch->get_depth() == depth) return ch;
-
-        // non-existent (chars are ordered by depth)
-        if (ch->get_depth() > depth) return nullptr;
+        return ch;
     }
 
     return nullptr;
@@ -157,15 +162,53 @@ DisplayList::getDisplayObjectByName(string_table& st, const ObjectURI& uri,
 {
     testInvariant();
 
-    const container_type::const_iterator e = _charsByDepth.end();
+    // Scripts using target paths look for the same names again and again,
+    // so a list searched a few times without changing is indexed.
+    if (!_namesIndexed || _namesCaseless != caseless) {
+        if (_charsByDepth.size() < minIndexedSize ||
+                ++_nameLookups < indexAfterLookups) {
 
-    container_type::const_iterator it =
-        std::find_if(_charsByDepth.begin(), e, NameEquals(st, uri, caseless));
+            const container_type::const_iterator e = _charsByDepth.end();
 
-    if (it == e) return nullptr;
-    
-    return *it;
+            container_type::const_iterator it = std::find_if(
+                    _charsByDepth.begin(), e, NameEquals(st, uri, caseless));
 
+            if (it == e) return nullptr;
+            
+            return *it;
+        }
+        indexNames(st, caseless);
+    }
+
+    const string_table::key key = caseless ? uri.noCase(st) : getName(uri);
+
+    NameIndex::const_iterator it = _names.find(key);
+    if (it == _names.end()) return nullptr;
+
+    // Another DisplayObject with the name may be found now that this one
+    // is destroyed (see NameEquals).
+    if (it->second->isDestroyed()) {
+        indexNames(st, caseless);
+        it = _names.find(key);
+        if (it == _names.end()) return nullptr;
+    }
+
+    return it->second;
+}
+
+void
+DisplayList::indexNames(string_table& st, bool caseless) const
+{
+    _names.clear();
+    for (DisplayObject* ch : _charsByDepth) {
+        if (ch->isDestroyed()) continue;
+        const ObjectURI& name = ch->get_name();
+        // The first DisplayObject with a name is the one found.
+        _names.insert(std::make_pair(caseless ? name.noCase(st) :
+                    getName(name), ch));
+    }
+    _namesIndexed = true;
+    _namesCaseless = caseless;
 }
 
 void
@@ -175,10 +218,7 @@ DisplayList::placeDisplayObject(DisplayObject* ch, int depth)
     ch->set_invalidated();
     ch->set_depth(depth);
 
-    container_type::iterator it =
-        std::find_if( _charsByDepth.begin(), _charsByDepth.end(),
-                std::bind(std::not2(DepthLessThan()), std::placeholders::_1,
-                     depth));
+    container_type::iterator it = lowerBound(_charsByDepth, depth);
 
     if (it == _charsByDepth.end() || (*it)->get_depth() != depth) {
         // add the new char
@@ -205,6 +245,8 @@ DisplayList::placeDisplayObject(DisplayObject* ch, int depth)
         ch->extend_invalidated_bounds(old_ranges);                
     }
 
+    nameChanged();
+
     testInvariant();
 }
 
@@ -213,16 +255,15 @@ DisplayList::add(DisplayObject* ch, bool replace)
 {
     const int depth = ch->get_depth();
 
-    container_type::iterator it =
-        std::find_if(_charsByDepth.begin(), _charsByDepth.end(),
-                std::bind(std::not2(DepthLessThan()), std::placeholders::_1,
-                     depth));
+    container_type::iterator it = lowerBound(_charsByDepth, depth);
 
     if (it == _charsByDepth.end() || (*it)->get_depth() != depth) {
         _charsByDepth.insert(it, ch);
     }
     else if (replace) *it = ch;
 
+    nameChanged();
+
     testInvariant();
 }
 
@@ -238,9 +279,7 @@ DisplayList::replaceDisplayObject(DisplayObject* ch, int depth,
     ch->set_invalidated();
     ch->set_depth(depth);
 
-    container_type::iterator it =
-        std::find_if(_charsByDepth.begin(), _charsByDepth.end(),
-            std::bind(std::not2(DepthLessThan()), std::placeholders::_1, depth));
+    container_type::iterator it = lowerBound(_charsByDepth, depth);
 
     if (it == _charsByDepth.end() || (*it)->get_depth() != depth) {
         _charsByDepth.insert(it, ch);
@@ -284,6 +323,8 @@ DisplayList::replaceDisplayObject(DisplayObject* ch, int depth,
 
     }
 
+    nameChanged();
+
     testInvariant();
 }
     
@@ -338,12 +379,9 @@ DisplayList::removeDisplayObject(int depth)
 
     // TODO: would it be legal to call removeDisplayObject with a depth
     //             in the "removed" zone ?
-    // TODO: optimize to take by-depth order into account
-    container_type::iterator it = 
-        std::find_if( _charsByDepth.begin(), _charsByDepth.end(),
-            std::bind(DepthEquals(), std::placeholders::_1, depth));
+    container_type::iterator it = lowerBound(_charsByDepth, depth);
 
-    if (it != _charsByDepth.end()) {
+    if (it != _charsByDepth.end() && (*it)->get_depth() == depth) {
         // Make a copy (before erasing)
         DisplayObject* oldCh = *it;
 
@@ -363,6 +401,8 @@ DisplayList::removeDisplayObject(int depth)
 
     assert(size >= _charsByDepth.size());
 
+    nameChanged();
+
     testInvariant();
 
 }
@@ -389,15 +429,16 @@ DisplayList::swapDepths(DisplayObject* ch1, int newdepth)
 
     assert(srcdepth != newdepth);
 
-    // TODO: optimize this scan by taking ch1 depth into account ?
-    container_type::iterator it1 =
-        std::find(_charsByDepth.begin(), _charsByDepth.end(), ch1);
+    // Only DisplayObjects at the same depth need to be looked at.
+    container_type::iterator it1 = lowerBound(_charsByDepth, srcdepth);
+    while (it1 != _charsByDepth.end() && *it1 != ch1 &&
+            (*it1)->get_depth() == srcdepth) {
+        ++it1;
+    }
+    if (it1 != _charsByDepth.end() && *it1 != ch1) it1 = _charsByDepth.end();
 
     // upper bound ...
-    container_type::iterator it2 =
-        std::find_if(_charsByDepth.begin(), _charsByDepth.end(),
-            std::bind(std::not2(DepthLessThan()), std::placeholders::_1,
-                newdepth));
+    container_type::iterator it2 = lowerBound(_charsByDepth, newdepth);
 
     if (it1 == _charsByDepth.end()) {
         log_error(_("First argument to DisplayList::swapDepth() "
@@ -422,11 +463,10 @@ DisplayList::swapDepths(DisplayObject* ch1, int newdepth)
     }
     else {
         // No DisplayObject found at the given depth
-        // Move the DisplayObject to the new position
-        // NOTE: insert *before* erasing, in case the list is
-        //             the only referer of the ref-counted DisplayObject
-        _charsByDepth.insert(it2, ch1);
-        _charsByDepth.erase(it1);
+        // Move the DisplayObject to the new position, shifting the
+        // ones in between.
+        if (it1 < it2) std::rotate(it1, it1 + 1, it2);
+        else std::rotate(it2, it1, it1 + 1);
     }
 
     // don't change depth before the iter_swap case above, as
@@ -441,6 +481,8 @@ DisplayList::swapDepths(DisplayObject* ch1, int newdepth)
     // See displaylist_depths_test6.swf for more info.
     ch1->transformedByScript();
 
+    nameChanged();
+
     testInvariant();
 }
 void
@@ -454,13 +496,10 @@ DisplayList::insertDisplayObject(DisplayObject* obj, int index)
     obj->set_depth(index);
 
     // Find the first index greater than or equal to the required index
-    container_type::iterator it =
-        std::find_if(_charsByDepth.begin(), _charsByDepth.end(),
-            std::bind(std::not2(DepthLessThan()), std::placeholders::_1,
-                index));
+    container_type::iterator it = lowerBound(_charsByDepth, index);
         
     // Insert the DisplayObject before that position
-    _charsByDepth.insert(it, obj);
+    it = _charsByDepth.insert(it, obj) + 1;
 
     // Shift depths upwards until no depths are duplicated. No DisplayObjects
     // are removed!
@@ -469,6 +508,8 @@ DisplayList::insertDisplayObject(DisplayObject* obj, int index)
         ++index, ++it;
     }
 
+    nameChanged();
+
     testInvariant();
 }
 
@@ -484,8 +525,11 @@ DisplayList::unload()
     // the first unload handler is encountered, subsequent children should
     // not be destroyed or removed from the display list. This affects
     // children without an unload handler.
-    for (iterator it = beginNonRemoved(_charsByDepth),
-            itEnd = _charsByDepth.end(); it != itEnd; ) {
+    //
+    // The children that stay are moved down over the ones that are
+    // removed, and the rest is erased at the end.
+    iterator kept = beginNonRemoved(_charsByDepth);
+    for (iterator it = kept, itEnd = _charsByDepth.end(); it != itEnd; ++it) {
         // make a copy
         DisplayObject* di = *it;
 
@@ -495,16 +539,16 @@ DisplayList::unload()
         // Destroy those with a handler anyway?
         if (di->unload()) {
             unloadHandler = true;
-            ++it;
+            *kept++ = di;
             continue;
         }
 
-        if (!unloadHandler) {
-            di->destroy();
-            it = _charsByDepth.erase(it);
-        }
-        else ++it;
+        if (!unloadHandler) di->destroy();
+        else *kept++ = di;
     }
+    _charsByDepth.erase(kept, _charsByDepth.end());
+
+    nameChanged();
 
     testInvariant();
 
@@ -517,21 +561,24 @@ DisplayList::destroy()
 {
     testInvariant();
 
-    for (iterator it = _charsByDepth.begin(), itEnd = _charsByDepth.end();
-            it != itEnd; ) {
+    iterator kept = _charsByDepth.begin();
+    for (iterator it = kept, itEnd = _charsByDepth.end(); it != itEnd; ++it) {
 
         // make a copy
         DisplayObject* di = *it;
 
         // skip if already unloaded
         if ( di->isDestroyed() ) {
-            ++it;
+            *kept++ = di;
             continue;
         }
 
         di->destroy();
-        it = _charsByDepth.erase(it); 
     }
+    _charsByDepth.erase(kept, _charsByDepth.end());
+
+    nameChanged();
+
     testInvariant();
 }
 
@@ -728,106 +775,121 @@ DisplayList::add_invalidated_bounds(InvalidatedRanges& ranges, bool force)
     }
 }
 
+std::pair<int, int>
+DisplayList::maskedDepths() const
+{
+    std::pair<int, int> depths(std::numeric_limits<int>::max(),
+            std::numeric_limits<int>::min());
+
+    for (const DisplayObject* ch : _charsByDepth) {
+        if (!ch->isMaskLayer()) continue;
+        depths.first = std::min(depths.first, ch->get_depth());
+        depths.second = std::max(depths.second, ch->get_clip_depth());
+    }
+    return depths;
+}
+
 void
 DisplayList::mergeDisplayList(DisplayList& newList, DisplayObject& o)
 {
     testInvariant();
 
+    container_type& newChars = newList._charsByDepth;
+
     iterator itOld = beginNonRemoved(_charsByDepth);
-    iterator itNew = beginNonRemoved(newList._charsByDepth);
+    iterator itNew = beginNonRemoved(newChars);
 
     iterator itOldEnd = dlistTagsEffectiveZoneEnd(_charsByDepth);
-    iterator itNewEnd = dlistTagsEffectiveZoneEnd(newList._charsByDepth);
+    iterator itNewEnd = dlistTagsEffectiveZoneEnd(newChars);
+
+    // The merged list is built separately, as inserting and erasing in
+    // the middle of a vector would move everything after it each time.
+    // The DisplayObjects already in the removed zone stay where they are.
+    container_type merged(_charsByDepth.begin(), itOld);
+    merged.reserve(_charsByDepth.size() + newChars.size());
+
+    // Old DisplayObjects that were unloaded but must stay around for
+    // their unload handlers. They go into the removed zone once the
+    // merged list is complete.
+    container_type removed;
+
+    // Unload and destroy, or keep for later, an old DisplayObject.
+    auto removeOld = [&removed](DisplayObject* chOld) {
+        if (chOld->unload()) removed.push_back(chOld);
+        else chOld->destroy();
+    };
 
     // step1. 
     // starting scanning both lists.
-    while (itOld != itOldEnd) {
+    while (itOld != itOldEnd && itNew != itNewEnd) {
 
-        iterator itOldBackup = itOld;
-        
-        DisplayObject* chOld = *itOldBackup;
+        DisplayObject* chOld = *itOld;
         const int depthOld = chOld->get_depth();
 
-        while (itNew != itNewEnd) {
-            iterator itNewBackup = itNew;
-            
-            DisplayObject* chNew = *itNewBackup;
-            const int depthNew = chNew->get_depth();
-            
-            // depth in old list is occupied, and empty in new list.
-            if (depthOld < depthNew) {
+        DisplayObject*& chNew = *itNew;
+        const int depthNew = chNew->get_depth();
 
-                ++itOld;
-                // unload the DisplayObject if it's in static zone(-16384,0)
-                if (depthOld < 0) {
-                    o.set_invalidated();
-                    _charsByDepth.erase(itOldBackup);
+        // depth in old list is occupied, and empty in new list.
+        if (depthOld < depthNew) {
+            ++itOld;
+            // unload the DisplayObject if it's in static zone(-16384,0)
+            if (depthOld < 0) {
+                o.set_invalidated();
+                removeOld(chOld);
+            }
+            else merged.push_back(chOld);
+            continue;
+        }
 
-                     if (chOld->unload()) reinsertRemovedCharacter(chOld);
-                     else chOld->destroy();
-                }
+        // depth is occupied in both lists
+        if (depthOld == depthNew) {
+            ++itOld;
+            ++itNew;
+
+            const bool is_ratio_compatible = 
+                (chOld->get_ratio() == chNew->get_ratio());
 
-                break;
+            if (!is_ratio_compatible || chOld->isDynamic() ||
+                    !isReferenceable(*chOld)) {
+                // replace the DisplayObject in old list with
+                // corresponding DisplayObject in new list
+                o.set_invalidated();
+                merged.push_back(chNew);
+
+                // unload the old DisplayObject
+                removeOld(chOld);
             }
-            // depth is occupied in both lists
-            
-            if (depthOld == depthNew) {
-                ++itOld;
-                ++itNew;
-                
-                const bool is_ratio_compatible = 
-                    (chOld->get_ratio() == chNew->get_ratio());
-
-                if (!is_ratio_compatible || chOld->isDynamic() ||
-                        !isReferenceable(*chOld)) {
-                    // replace the DisplayObject in old list with
-                    // corresponding DisplayObject in new list
-                    o.set_invalidated();
-                    _charsByDepth.insert(itOldBackup, *itNewBackup);
-                    _charsByDepth.erase(itOldBackup);
-                    
-                    // unload the old DisplayObject
-                    if (chOld->unload()) reinsertRemovedCharacter(chOld); 
-                    else chOld->destroy();
-                }
-                else {
-                    newList._charsByDepth.erase(itNewBackup);
-
-                    // replace the transformation SWFMatrix if the old
-                    // DisplayObject accepts static transformation.
-                    if (chOld->get_accept_anim_moves()) {
-                        chOld->setMatrix(getMatrix(*chNew), true); 
-                        chOld->setCxForm(getCxForm(*chNew));
-                    }
-                    chNew->unload();
-                    chNew->destroy();
+            else {
+                merged.push_back(chOld);
+
+                // replace the transformation SWFMatrix if the old
+                // DisplayObject accepts static transformation.
+                if (chOld->get_accept_anim_moves()) {
+                    chOld->setMatrix(getMatrix(*chNew), true); 
+                    chOld->setCxForm(getCxForm(*chNew));
                 }
+                chNew->unload();
+                chNew->destroy();
 
-                break;
+                // It's gone from the new list.
+                chNew = nullptr;
             }
-
-            // depth in old list is empty, but occupied in new list.
-            ++itNew;
-            // add the new DisplayObject to the old list.
-            o.set_invalidated();
-            _charsByDepth.insert(itOldBackup, *itNewBackup);
+            continue;
         }
 
-        // break if finish scanning the new list
-        if (itNew == itNewEnd) break;
+        // depth in old list is empty, but occupied in new list.
+        ++itNew;
+        // add the new DisplayObject to the old list.
+        o.set_invalidated();
+        merged.push_back(chNew);
     }
 
     // step2(only required if scanning of new list finished earlier in step1).
     // continue to scan the static zone of the old list.
     // unload remaining DisplayObjects directly.
-    while ((itOld != itOldEnd) && ((*itOld)->get_depth() < 0)) {
-
-        DisplayObject* chOld = *itOld;
+    for (; itOld != itOldEnd && (*itOld)->get_depth() < 0; ++itOld) {
         o.set_invalidated();
-        itOld = _charsByDepth.erase(itOld);
-
-        if (chOld->unload()) reinsertRemovedCharacter(chOld);
-        else chOld->destroy();
+        removeOld(*itOld);
     }
 
     // step3(only required if scanning of old list finished earlier in step1).
@@ -835,38 +897,35 @@ DisplayList::mergeDisplayList(DisplayList& newList, DisplayObject& o)
     // add remaining DisplayObjects directly.
     if (itNew != itNewEnd) {
         o.set_invalidated();
-        _charsByDepth.insert(itOld, itNew, itNewEnd);
+        merged.insert(merged.end(), itNew, itNewEnd);
     }
+    merged.insert(merged.end(), itOld, _charsByDepth.end());
 
     // step4.
     // Copy all unloaded DisplayObjects from the new display list to the
     // old display list, and clear the new display list
-    for (itNew = newList._charsByDepth.begin(); itNew != itNewEnd; ++itNew) {
+    for (itNew = newChars.begin(); itNew != itNewEnd; ++itNew) {
 
         DisplayObject* chNew = *itNew;
-        const int depthNew = chNew->get_depth();
+        if (!chNew || !chNew->unloaded()) continue;
 
-        if (chNew->unloaded()) {
-            iterator it =
-                std::find_if(_charsByDepth.begin(), _charsByDepth.end(),
-                    std::bind(std::not2(DepthLessThan()), std::placeholders::_1,
-                        depthNew));
-            
-            o.set_invalidated();
-            _charsByDepth.insert(it, *itNew);
-        }
+        o.set_invalidated();
+        merged.insert(lowerBound(merged, chNew->get_depth()), chNew);
     }
 
+    _charsByDepth.swap(merged);
+
+    for (DisplayObject* ch : removed) reinsertRemovedCharacter(ch);
+
     // clear the new display list after merge
     // ASSERT:
     //     - Any element in newList._charsByDepth is either marked as unloaded
     //    or found in this list
 #if GNASH_PARANOIA_LEVEL > 1
-    for (iterator i = newList._charsByDepth.begin(),
-            e = newList._charsByDepth.end(); i != e; ++i) {
+    for (iterator i = newChars.begin(), e = newChars.end(); i != e; ++i) {
 
         DisplayObject* ch = *i;
-        if (!ch->unloaded()) {
+        if (ch && !ch->unloaded()) {
 
             iterator found =
                 std::find(_charsByDepth.begin(), _charsByDepth.end(), ch);
@@ -884,7 +943,10 @@ DisplayList::mergeDisplayList(DisplayList& newList, DisplayObject& o)
         }
     }
 #endif
-    newList._charsByDepth.clear();
+    newChars.clear();
+
+    nameChanged();
+    newList.nameChanged();
 
     testInvariant();
 }
@@ -902,13 +964,9 @@ DisplayList::reinsertRemovedCharacter(DisplayObject* ch)
     int newDepth = DisplayObject::removedDepthOffset - oldDepth;
     ch->set_depth(newDepth);
 
-    // TODO: optimize this by searching from the end(lowest depth).
-    container_type::iterator it =
-        std::find_if(_charsByDepth.begin(), _charsByDepth.end(),
-                std::bind(std::not2(DepthLessThan()), std::placeholders::_1,
-                    newDepth));
+    _charsByDepth.insert(lowerBound(_charsByDepth, newDepth), ch);
 
-    _charsByDepth.insert(it, ch);
+    nameChanged();
 
     testInvariant();
 }
@@ -918,7 +976,11 @@ DisplayList::removeUnloaded()
 {
     testInvariant();
 
-    _charsByDepth.remove_if(std::mem_fn(&DisplayObject::unloaded));
+    _charsByDepth.erase(std::remove_if(_charsByDepth.begin(),
+                _charsByDepth.end(), std::mem_fn(&DisplayObject::unloaded)),
+            _charsByDepth.end());
+
+    nameChanged();
 
     testInvariant();
 }
@@ -941,9 +1003,7 @@ beginNonRemoved(DisplayList::container_type& c)
     const int depth = 1 + DisplayObject::removedDepthOffset -
         DisplayObject::staticDepthOffset;
     
-    return std::find_if(c.begin(), c.end(),
-            std::bind(std::not2(DepthLessThan()), std::placeholders::_1,
-                depth));
+    return lowerBound(c, depth);
 }
 
 #if GNASH_PARANOIA_LEVEL > 1 && !defined(NDEBUG)
@@ -954,18 +1014,27 @@ beginNonRemoved(const DisplayList::container_type& c)
     const int depth = 1 + DisplayObject::removedDepthOffset -
         DisplayObject::staticDepthOffset;
 
-    return std::find_if(c.begin(), c.end(), 
-            std::bind(std::not2(DepthLessThan()), std::placeholders::_1,
-                depth));
+    return lowerBound(c, depth);
 }
 #endif
 
 DisplayList::iterator
 dlistTagsEffectiveZoneEnd(DisplayList::container_type& c)
 {
-    return std::find_if(c.begin(), c.end(), 
-            std::bind(DepthGreaterThan(), std::placeholders::_1,
-                0xffff + DisplayObject::staticDepthOffset));
+    return std::upper_bound(c.begin(), c.end(),
+            0xffff + DisplayObject::staticDepthOffset, DepthBelow());
+}
+
+DisplayList::iterator
+lowerBound(DisplayList::container_type& c, int depth)
+{
+    return std::lower_bound(c.begin(), c.end(), depth, DepthLessThan());
+}
+
+DisplayList::const_iterator
+lowerBound(const DisplayList::container_type& c, int depth)
+{
+    return std::lower_bound(c.begin(), c.end(), depth, DepthLessThan());
 }
 
 } // anonymous namespace
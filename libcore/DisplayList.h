@@ -20,7 +20,9 @@
 #ifndef GNASH_DLIST_H
 #define GNASH_DLIST_H
 
-#include <list>
+#include <vector>
+#include <map>
+#include <utility>
 #include <iosfwd>
 #if GNASH_PARANOIA_LEVEL > 1 && !defined(NDEBUG)
 #include "DisplayObject.h"
@@ -30,6 +32,7 @@
 #endif
 
 #include "snappingrange.h"
+#include "string_table.h"
 #include "dsodefs.h" // for DSOTEXPORT
 
 
@@ -61,18 +64,29 @@ namespace gnash {
 /// tags instructing when to add or remove DisplayObjects
 /// from the stage.
 ///
+/// The DisplayObjects are kept in a vector sorted by depth, so finding
+/// the one at a depth is a binary search, and displaying them walks
+/// contiguous memory. Nothing may change the list while it is being
+/// visited.
+///
 class DisplayList
 {
 
 public:
 
-	typedef std::list<DisplayObject*> container_type;
+	typedef std::vector<DisplayObject*> container_type;
 	typedef container_type::iterator iterator;
 	typedef container_type::const_iterator const_iterator;
 	typedef container_type::reverse_iterator reverse_iterator;
 	typedef container_type::const_reverse_iterator const_reverse_iterator;
 
-    DisplayList() {}
+    DisplayList()
+        :
+        _namesIndexed(false),
+        _namesCaseless(false),
+        _nameLookups(0)
+    {}
+
     ~DisplayList() {}
 
     /// Output operator
@@ -224,6 +238,9 @@ public:
 
 	/// If there are multiples, returns the *first* match only!
 	//
+	/// Once the list has been searched a few times without changing, the
+	/// names are indexed.
+	///
 	/// @param st
 	///     The string_table to use for finding
 	///     lowercase equivalent of names if
@@ -236,6 +253,14 @@ public:
 	DSOTEXPORT DisplayObject* getDisplayObjectByName(string_table& st,
             const ObjectURI& uri, bool caseless) const;
 
+    /// Drop the index of names, as when a DisplayObject in the list is
+    /// renamed.
+    void nameChanged() {
+        _names.clear();
+        _namesIndexed = false;
+        _nameLookups = 0;
+    }
+
 	/// \brief 
 	/// Visit each DisplayObject in the list in reverse depth
 	/// order (higher depth first).
@@ -269,6 +294,14 @@ public:
     /// Like DisplayObject_instance::add_invalidated_bounds() this method calls the
     /// method with the same name of all childs.	
 	void add_invalidated_bounds(InvalidatedRanges& ranges, bool force);	
+
+    /// The depths that mask layers in the list may clip.
+    //
+    /// @return     The lowest depth of a mask layer and the highest depth
+    ///             any mask layer clips. DisplayObjects above the first
+    ///             and up to the second may be masked. The first is
+    ///             greater than the second if there are no mask layers.
+    std::pair<int, int> maskedDepths() const;
 	
 	/// Return number of elements in the list
 	size_t size() const { 
@@ -345,7 +378,22 @@ private:
     /// occupied
 	void reinsertRemovedCharacter(DisplayObject* ch);
 
+    /// Index the first DisplayObject with each name.
+    void indexNames(string_table& st, bool caseless) const;
+
 	container_type _charsByDepth;
+
+    /// The first DisplayObject with each name, caseless or not.
+    //
+    /// This is dropped whenever the list changes.
+    typedef std::map<string_table::key, DisplayObject*> NameIndex;
+    mutable NameIndex _names;
+
+    mutable bool _namesIndexed;
+    mutable bool _namesCaseless;
+
+    /// Searches for names since the list last changed.
+    mutable size_t _nameLookups;
 };
 
 template <class V>
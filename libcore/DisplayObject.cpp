@@ -43,6 +43,7 @@
 #include "Global_as.h"
 #include "Renderer.h"
 #include "GnashAlgorithm.h"
+#include "BitmapCache.h"
 #ifdef USE_SWFTREE
 # include "tree.hh"
 #endif
@@ -109,13 +110,20 @@ DisplayObject::DisplayObject(movie_root& mr, as_object* object,
     _unloaded(false),
     _destroyed(false),
     _invalidated(true),
-    _child_invalidated(true)
+    _child_invalidated(true),
+    _cacheAsBitmap(false),
+    _hitBoundsVersion(0),
+    _invalidatedVersion(0)
 {
     assert(m_old_invalidated_ranges.isNull());
 
     // This informs the core that the object is a DisplayObject.
     if (_object) _object->setDisplayObject(this);
 }
+
+DisplayObject::~DisplayObject()
+{
+}
     
 void
 DisplayObject::getLoadedMovie(Movie* extern_movie)
@@ -164,11 +172,10 @@ DisplayObject::pathElement(const ObjectURI& uri)
 
     string_table::key key = getName(uri);
 
-    string_table& st = stage().getVM().getStringTable();
+    if (key == NSV::PROP_DOT_DOT) return getObject(parent());
+    if (key == NSV::PROP_DOT) return obj;
 
-    // TODO: put ".." and "." in namedStrings
-    if (key == st.find("..")) return getObject(parent());
-    if (key == st.find(".")) return obj;
+    string_table& st = stage().getVM().getStringTable();
     
     // The check is case-insensitive for SWF6 and below.
     // TODO: cache ObjectURI(NSV::PROP_THIS) [as many others...]
@@ -179,6 +186,16 @@ DisplayObject::pathElement(const ObjectURI& uri)
     return nullptr;
 }
 
+void
+DisplayObject::set_name(const ObjectURI& uri)
+{
+    _name = uri;
+
+    // The parent may have found its DisplayObjects by their old names.
+    MovieClip* mc = _parent ? _parent->to_movie() : nullptr;
+    if (mc) mc->childRenamed();
+}
+
 void 
 DisplayObject::set_invalidated()
 {
@@ -192,6 +209,18 @@ DisplayObject::set_invalidated(const char* debug_file, int debug_line)
     // the parent must re-draw itself, it just means that one of it's childs
     // needs to be re-drawn.
     if ( _parent ) _parent->set_child_invalidated(); 
+
+    // Anything that changes what is drawn can change what a hit test
+    // finds, so all hit bounds have to be worked out again.
+    _stage.displayChanged();
+
+    // The stage only looks at the DisplayObjects reported since the last
+    // frame for the invalidated bounds. New DisplayObjects start
+    // invalidated, so they are reported even if the flag is set.
+    if (!_invalidated || _invalidatedVersion != _stage.invalidatedVersion()) {
+        _invalidatedVersion = _stage.invalidatedVersion();
+        _stage.addInvalidated(*this);
+    }
   
     // Ok, at this point the instance will change it's
     // visual aspect after the
@@ -222,6 +251,12 @@ DisplayObject::set_invalidated(const char* debug_file, int debug_line)
     }
 }
 
+bool
+DisplayObject::invalidatedReported() const
+{
+    return _invalidated && _invalidatedVersion == _stage.invalidatedVersion();
+}
+
 void
 DisplayObject::add_invalidated_bounds(InvalidatedRanges& ranges, bool force)
 {
@@ -689,6 +724,115 @@ DisplayObject::destroy()
 
     assert(!_destroyed);
     _destroyed = true;
+
+    // The bitmap can't be displayed again.
+    _bitmapCache.reset();
+}
+
+void
+DisplayObject::setCacheAsBitmap(bool cache)
+{
+    if (isDestroyed() || cache == _cacheAsBitmap) return;
+
+    _cacheAsBitmap = cache;
+    updateBitmapCache();
+}
+
+void
+DisplayObject::setFilters(std::shared_ptr<const Filters> filters)
+{
+    if (isDestroyed()) return;
+
+    if (filters && filters->empty()) filters.reset();
+    if (filters == _filters) return;
+
+    // This adds the area of the old filters to the invalidated bounds.
+    set_invalidated();
+    _filters = std::move(filters);
+    invalidateCache();
+    updateBitmapCache();
+}
+
+void
+DisplayObject::updateBitmapCache()
+{
+    const bool cache = _cacheAsBitmap || _filters;
+    if (cache == cacheAsBitmap()) return;
+
+    set_invalidated();
+    if (cache) _bitmapCache.reset(new BitmapCache(stage().bitmapCachePool()));
+    else _bitmapCache.reset();
+}
+
+void
+DisplayObject::addFilterBounds(InvalidatedRanges& ranges) const
+{
+    if (!_filters) return;
+
+    SWFRect bounds = getBounds();
+    if (bounds.is_null()) return;
+    getWorldMatrix(*this).transform(bounds);
+
+    // The bitmap has an extra pixel around the filters, and they are
+    // rounded out to whole device pixels.
+    const std::int32_t margin = pixelsToTwips(filtersMargin(*_filters) + 2);
+    ranges.add(SWFRect(bounds.get_x_min() - margin,
+                bounds.get_y_min() - margin, bounds.get_x_max() + margin,
+                bounds.get_y_max() + margin).getRange());
+}
+
+void
+DisplayObject::invalidateCache()
+{
+    if (_bitmapCache) _bitmapCache->invalidate();
+}
+
+bool
+DisplayObject::displayCached(Renderer& renderer, const Transform& xform)
+{
+    if (!_bitmapCache) return false;
+
+    // Masks are drawn as the shapes they cover, so they can't use a
+    // bitmap, whether they are masks themselves or part of one.
+    for (const DisplayObject* ch = this; ch; ch = ch->parent()) {
+        if (ch->isMaskLayer() || ch->isDynamicMask()) return false;
+    }
+
+    if (childInvalidated()) _bitmapCache->invalidate();
+
+    if (!_bitmapCache->prepare(*this, renderer, xform)) return false;
+
+    const MaskRenderer mr(renderer, *this);
+    _bitmapCache->display(renderer, xform);
+    return true;
+}
+
+const SWFRect&
+DisplayObject::hitBounds() const
+{
+    const size_t version = stage().displayVersion();
+    if (_hitBoundsVersion != version) {
+        _hitBounds = computeHitBounds();
+        _hitBoundsVersion = version;
+    }
+    return _hitBounds;
+}
+
+SWFRect
+DisplayObject::computeHitBounds() const
+{
+    const SWFRect bounds = getBounds();
+    if (bounds.is_null()) return bounds;
+
+    SWFRect world = bounds;
+    getWorldMatrix(*this).transform(world);
+
+    // pointInBounds() leaves _root's transform out.
+    SWFRect unrooted = bounds;
+    getWorldMatrix(*this, false).transform(unrooted);
+    world.expand_to_rect(unrooted);
+
+    return world;
 }
 
 void
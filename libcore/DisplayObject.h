@@ -26,6 +26,7 @@
 
 #include <vector>
 #include <map>
+#include <memory>
 #include <string>
 #include <cassert>
 #include <cstdint> // For C99 int types
@@ -39,6 +40,7 @@
 #include "SWFRect.h"
 #include "SWFMatrix.h"
 #include "SWFCxForm.h"
+#include "Filters.h"
 #include "dsodefs.h" 
 #include "snappingrange.h"
 #ifdef USE_SWFTREE
@@ -65,6 +67,7 @@ namespace gnash {
     class as_environment;
     class DisplayObject;
     class KeyVisitor;
+    class BitmapCache;
     namespace SWF {
         class TextRecord;
     }
@@ -181,7 +184,7 @@ public:
     /// @param parent   The parent of the new DisplayObject. This may be null.
     DisplayObject(movie_root& mr, as_object* object, DisplayObject* parent);
 
-    virtual ~DisplayObject() {}
+    virtual ~DisplayObject();
 
     /// The lowest placeable and accessible depth for a DisplayObject.
     /// Macromedia Flash help says: depth starts at -16383 (0x3FFF)
@@ -425,9 +428,7 @@ public:
     void setMask(DisplayObject* mask);
 
     /// Set DisplayObject name, initializing the original target member
-    void set_name(const ObjectURI& uri) {
-        _name = uri;
-    }
+    void set_name(const ObjectURI& uri);
 
     const ObjectURI& get_name() const { return _name; }
 
@@ -467,6 +468,14 @@ public:
     /// All DisplayObjects must have a display() function.
 	virtual void display(Renderer& renderer, const Transform& xform) = 0;
 
+    /// Draw what the DisplayObject shows, without its mask.
+    //
+    /// This is used to draw the bitmap of a DisplayObject with
+    /// cacheAsBitmap set, so only DisplayObjects that can be cached need
+    /// to implement it. The default draws nothing.
+    virtual void drawContents(Renderer& /*renderer*/,
+            const Transform& /*xform*/) {}
+
     /// Search for StaticText objects
     //
     /// If this is a StaticText object and contains SWF::TextRecords, these
@@ -493,6 +502,14 @@ public:
         return bounds.point_test(x, y);
     }
 
+    /// The world space rectangle outside of which no hit test can succeed
+    //
+    /// This includes children, so a point outside it can't hit any of
+    /// them either, and they don't need to be looked at. The rectangle is
+    /// kept until movie_root::displayChanged() is called, which
+    /// set_invalidated() does.
+    const SWFRect& hitBounds() const;
+
     /// Return true if the given point falls in this DisplayObject's shape
     //
     /// @param x        Point x coordinate in world space
@@ -658,6 +675,12 @@ public:
         return _invalidated;
     }
 
+    /// Return whether the stage was told this DisplayObject was invalidated
+    //
+    /// DisplayObjects that are still invalidated from before the stage
+    /// was last displayed may not have been reported again.
+    bool invalidatedReported() const;
+
     /// Return whether this DisplayObject has and invalidated child or not
     bool childInvalidated() const {
         return _child_invalidated;
@@ -895,6 +918,42 @@ public:
         _blendMode = bm;
     }
 
+    /// Whether the DisplayObject is displayed from a bitmap of itself.
+    //
+    /// This is also the case when it has filters, which are applied to
+    /// the bitmap.
+    bool cacheAsBitmap() const {
+        return _bitmapCache.get();
+    }
+
+    /// Set whether the DisplayObject is displayed from a bitmap of itself.
+    //
+    /// Only DisplayObjects that call displayCached() in their display()
+    /// function use the bitmap.
+    void setCacheAsBitmap(bool cache);
+
+    /// The filters applied to the DisplayObject, or null if there are none.
+    const std::shared_ptr<const Filters>& filters() const {
+        return _filters;
+    }
+
+    /// Add the area the filters draw in to an InvalidatedRanges.
+    //
+    /// Filters can draw beyond the bounds of the DisplayObject, so
+    /// DisplayObjects that can have them call this when adding their own
+    /// bounds. Nothing is added if there are no filters.
+    void addFilterBounds(InvalidatedRanges& ranges) const;
+
+    /// Set the filters applied to the DisplayObject.
+    //
+    /// The filters are applied to a bitmap of the DisplayObject, so they
+    /// only have an effect on DisplayObjects that can be cached. The
+    /// filters are shared, so they must not be changed afterwards.
+    ///
+    /// @param filters  The filters, or null or an empty list to remove
+    ///                 them.
+    void setFilters(std::shared_ptr<const Filters> filters);
+
     // action_buffer is externally owned
     typedef std::vector<const action_buffer*> BufferList;
     typedef std::map<event_id, BufferList> Events;
@@ -977,6 +1036,27 @@ protected:
 
     virtual bool unloadChildren() { return false; }
 
+    /// Display this DisplayObject from its bitmap, if cacheAsBitmap is set.
+    //
+    /// The bitmap is drawn with drawContents() when it is out of date.
+    /// This also renders the DisplayObject's mask.
+    ///
+    /// @return     false if the DisplayObject must be drawn as usual,
+    ///             which is always the case for masks.
+    bool displayCached(Renderer& renderer, const Transform& xform);
+
+    /// Draw the bitmap again when cacheAsBitmap is set.
+    //
+    /// Changes to children are noticed anyway, so this is only needed
+    /// when what this DisplayObject draws itself changes.
+    void invalidateCache();
+
+    /// Work out the rectangle returned by hitBounds().
+    //
+    /// The default is the world bounds. DisplayObjects with children must
+    /// include the hit bounds of the children.
+    virtual SWFRect computeHitBounds() const;
+
     /// Get the movie_root to which this DisplayObject belongs.
     movie_root& stage() const {
         return _stage;
@@ -1033,6 +1113,9 @@ private:
     /// Register a DisplayObject masked by this instance
     void setMaskee(DisplayObject* maskee);
 
+    /// Make or drop the bitmap, as cacheAsBitmap and the filters need.
+    void updateBitmapCache();
+
     /// The as_object to which this DisplayObject is attached.
     as_object* _object;
 
@@ -1111,6 +1194,26 @@ private:
     /// can be set at the same time. 
     bool _child_invalidated;
 
+    /// The bitmap this DisplayObject is displayed from, when cacheAsBitmap
+    /// is set.
+    std::unique_ptr<BitmapCache> _bitmapCache;
+
+    /// Whether cacheAsBitmap was set, rather than only being needed for
+    /// the filters.
+    bool _cacheAsBitmap;
+
+    /// The filters, or null if there are none.
+    std::shared_ptr<const Filters> _filters;
+
+    /// The last result of computeHitBounds().
+    mutable SWFRect _hitBounds;
+
+    /// The movie_root::displayVersion() _hitBounds is valid for.
+    mutable size_t _hitBoundsVersion;
+
+    /// The movie_root::invalidatedVersion() this DisplayObject was last
+    /// reported invalidated in.
+    size_t _invalidatedVersion;
 
 };
 
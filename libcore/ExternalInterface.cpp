@@ -65,18 +65,26 @@ private:
 
 }
 
-/// Convert an AS object to an XML string.
 std::string
-ExternalInterface::_objectToXML(as_object *obj)
+ExternalInterface::toXML(const as_value &val)
+{
+    std::ostringstream ss;
+    ExternalInterface ei;
+    ei._toXML(ss, val);
+    return ss.str();
+}
+
+/// Write an AS object as XML.
+void
+ExternalInterface::_objectToXML(std::ostream &ss, as_object *obj)
 {
     // GNASH_REPORT_FUNCTION;
 
     if ( ! _visited.insert(obj).second ) { 
-        return "<circular/>";
+        ss << "<circular/>";
+        return;
     }
     
-    std::stringstream ss;
-
     ss << "<object>";
 
     if (obj) {
@@ -92,24 +100,20 @@ ExternalInterface::_objectToXML(as_object *obj)
             as_value val = getMember(*obj, *i); 
             const std::string& id = i->toString(st);
             ss << "<property id=\"" << id << "\">";
-            ss << _toXML(val);
+            _toXML(ss, val);
             ss << "</property>";
         }
     }
 
     ss << "</object>";
-    
-    return ss.str();
 }
 
-/// Convert an AS object to an XML string.
-std::string
-ExternalInterface::_toXML(const as_value &val)
+/// Write an AS value as XML.
+void
+ExternalInterface::_toXML(std::ostream &ss, const as_value &val)
 {
     // GNASH_REPORT_FUNCTION;
     
-    std::stringstream ss;
-    
     if (val.is_string()) {
         ss << "<string>" << val.to_string() << "</string>";
     } else if (val.is_number()) {
@@ -130,12 +134,10 @@ ExternalInterface::_toXML(const as_value &val)
         ss << "<function>" << val.to_string() << "</function>";
     } else if (val.is_object()) {
         as_object *obj = val.get_object();
-        ss << _objectToXML(obj);
+        _objectToXML(ss, obj);
     } else {
         log_error(_("Can't convert unknown type %d"), val.to_string());
     }
-
-    return ss.str();
 }
 
 std::unique_ptr<ExternalInterface::invoke_t>
@@ -301,15 +303,22 @@ ExternalInterface::parseArguments(const std::string &xml)
 std::string
 ExternalInterface::makeInvoke (const std::string &method,
                                const std::vector<as_value> &args)
+{
+    return makeInvoke(method, args.data(), args.data() + args.size());
+}
+
+std::string
+ExternalInterface::makeInvoke (const std::string &method,
+                               const as_value *first, const as_value *last)
 {
     std::stringstream ss;
-    std::vector<as_value>::const_iterator it;
 
     ss << "<invoke name=\"" << method << "\" returntype=\"xml\">";
     ss << "<arguments>";
-    for (it=args.begin(); it != args.end(); ++it) {
+    for (const as_value *it = first; it != last; ++it) {
         // Should we avoid re-serializing the same object ?
-        ss << toXML(*it);
+        ExternalInterface ei;
+        ei._toXML(ss, *it);
     }
     
     ss << "</arguments>";
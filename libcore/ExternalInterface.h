@@ -23,6 +23,7 @@
 
 #include <memory>
 #include <string>
+#include <iosfwd>
 #include <vector>
 #include <set>
 
@@ -48,10 +49,7 @@ struct DSOEXPORT ExternalInterface
     };
 
     /// Convert an AS object to an XML string.
-    static std::string toXML(const as_value &obj) {
-        ExternalInterface ei;
-        return ei._toXML(obj);
-    }
+    static std::string toXML(const as_value &obj);
     
     static as_value parseXML(const std::string &xml);
     static std::vector<as_value> parseArguments(const std::string &xml);
@@ -65,6 +63,11 @@ struct DSOEXPORT ExternalInterface
     // Create an Invoke message for the standalone Gnash
     DSOEXPORT static std::string makeInvoke (const std::string &method,
               		                     const std::vector<as_value> &args);
+    /// Create an Invoke message from a range of arguments, so that they
+    /// needn't be copied into a vector first.
+    DSOEXPORT static std::string makeInvoke (const std::string &method,
+                                             const as_value *first,
+                                             const as_value *last);
     
     static std::string makeString (const std::string &str) {
         return "<string>" + str + "</string>";
@@ -75,8 +78,10 @@ struct DSOEXPORT ExternalInterface
 
 private:
 
-    DSOEXPORT std::string _toXML(const as_value &obj);
-    DSOEXPORT std::string _objectToXML(as_object* obj);
+    /// Write an AS value as XML where it's needed, so the XML of an
+    /// object's members isn't copied into the XML of the object.
+    DSOEXPORT void _toXML(std::ostream &o, const as_value &obj);
+    DSOEXPORT void _objectToXML(std::ostream &o, as_object* obj);
     DSOEXPORT std::string _arrayToXML(as_object *obj);
 
     std::set<as_object*> _visited;
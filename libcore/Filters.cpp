@@ -0,0 +1,879 @@
+// Filters.cpp: apply display filters to bitmaps
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "Filters.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "GnashImage.h"
+#include "GnashNumeric.h"
+
+// All the filters work on RGBA images with premultiplied alpha, which is
+// what the renderers draw into. The blurs, color matrices and convolutions
+// use SSE2 where the compiler targets it, and plain loops otherwise. Both
+// give the same results.
+
+namespace gnash {
+
+namespace {
+
+/// One byte for each pixel of an image, such as its alpha channel.
+typedef std::vector<std::uint8_t> Plane;
+
+/// Where an effect is drawn, compared to the pixels of the object.
+enum Region
+{
+    INSIDE,
+    OUTSIDE,
+    EVERYWHERE
+};
+
+#ifdef __SSE2__
+/// Whether to use SSE2, which only the tests turn off.
+bool sse2 = true;
+#endif
+
+/// The largest blur radius, in device pixels.
+const int maxRadius = 255;
+
+/// Multiply two values from 0 to 255, giving a value from 0 to 255.
+inline std::uint8_t
+mul255(unsigned a, unsigned b)
+{
+    const unsigned t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+/// The radius of the box for a blur of some stage pixels.
+//
+/// Boxes are 2 * radius + 1 device pixels wide, and a radius of 0 means
+/// no blur.
+int
+boxRadius(float blur, double scale)
+{
+    const double size = blur * scale;
+    if (!(size >= 2)) return 0;
+    return std::min<double>(size / 2, maxRadius);
+}
+
+/// The average of a box of values.
+inline std::uint8_t
+average(std::int32_t sum, float scale)
+{
+    return std::lrint(sum * scale);
+}
+
+#ifdef __SSE2__
+
+/// Load a 4 byte pixel into 32 bit lanes.
+inline __m128i
+loadPixel(const std::uint8_t* p)
+{
+    std::int32_t v;
+    std::memcpy(&v, p, 4);
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_unpacklo_epi16(
+            _mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero), zero);
+}
+
+/// Store 32 bit lanes as a 4 byte pixel, saturating.
+inline void
+storePixel(std::uint8_t* p, __m128i v)
+{
+    v = _mm_packs_epi32(v, v);
+    v = _mm_packus_epi16(v, v);
+    const std::int32_t out = _mm_cvtsi128_si32(v);
+    std::memcpy(p, &out, 4);
+}
+
+/// Blur a row of 4 byte pixels, all channels at once.
+void
+blurRow4(std::uint8_t* row, const std::uint8_t* line, size_t width,
+        size_t radius, float scale)
+{
+    const __m128 mul = _mm_set1_ps(scale);
+    __m128i sum = _mm_setzero_si128();
+
+    for (size_t x = 0; x < width && x <= radius; ++x) {
+        sum = _mm_add_epi32(sum, loadPixel(line + x * 4));
+    }
+
+    for (size_t x = 0; x < width; ++x) {
+        storePixel(row + x * 4,
+                _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(sum), mul)));
+        const size_t in = x + radius + 1;
+        if (in < width) sum = _mm_add_epi32(sum, loadPixel(line + in * 4));
+        if (x >= radius) {
+            sum = _mm_sub_epi32(sum, loadPixel(line + (x - radius) * 4));
+        }
+    }
+}
+
+#endif
+
+/// Blur the rows of an image with a box, treating pixels outside as 0.
+//
+/// @param channels     The number of bytes in a pixel.
+void
+blurRows(std::uint8_t* data, size_t width, size_t height, size_t stride,
+        size_t channels, size_t radius)
+{
+    const float scale = 1.0f / (2 * radius + 1);
+    Plane line(width * channels);
+
+    for (size_t y = 0; y < height; ++y) {
+        std::uint8_t* row = data + y * stride;
+        std::copy(row, row + line.size(), line.begin());
+
+#ifdef __SSE2__
+        if (sse2 && channels == 4) {
+            blurRow4(row, line.data(), width, radius, scale);
+            continue;
+        }
+#endif
+
+        for (size_t c = 0; c < channels; ++c) {
+            std::int32_t sum = 0;
+            for (size_t x = 0; x < width && x <= radius; ++x) {
+                sum += line[x * channels + c];
+            }
+            for (size_t x = 0; x < width; ++x) {
+                row[x * channels + c] = average(sum, scale);
+                const size_t in = x + radius + 1;
+                if (in < width) sum += line[in * channels + c];
+                if (x >= radius) sum -= line[(x - radius) * channels + c];
+            }
+        }
+    }
+}
+
+/// Add, or subtract, a row of bytes to the column sums.
+void
+accumulate(std::int32_t* sums, const std::uint8_t* row, size_t bytes,
+        bool add)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; sse2 && i + 16 <= bytes; i += 16) {
+        const __m128i v =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        const __m128i lo = _mm_unpacklo_epi8(v, zero);
+        const __m128i hi = _mm_unpackhi_epi8(v, zero);
+        const __m128i parts[4] = {
+            _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+            _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)
+        };
+        __m128i* s = reinterpret_cast<__m128i*>(sums + i);
+        for (size_t j = 0; j < 4; ++j) {
+            const __m128i old = _mm_loadu_si128(s + j);
+            _mm_storeu_si128(s + j, add ? _mm_add_epi32(old, parts[j]) :
+                    _mm_sub_epi32(old, parts[j]));
+        }
+    }
+#endif
+    for (; i < bytes; ++i) {
+        if (add) sums[i] += row[i];
+        else sums[i] -= row[i];
+    }
+}
+
+/// Write the averages of the column sums to a row.
+void
+averageRow(std::uint8_t* row, const std::int32_t* sums, size_t bytes,
+        float scale)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128 mul = _mm_set1_ps(scale);
+    for (; sse2 && i + 16 <= bytes; i += 16) {
+        const __m128i* s = reinterpret_cast<const __m128i*>(sums + i);
+        __m128i v[4];
+        for (size_t j = 0; j < 4; ++j) {
+            v[j] = _mm_cvtps_epi32(_mm_mul_ps(
+                        _mm_cvtepi32_ps(_mm_loadu_si128(s + j)), mul));
+        }
+        const __m128i out = _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]),
+                _mm_packs_epi32(v[2], v[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), out);
+    }
+#endif
+    for (; i < bytes; ++i) {
+        row[i] = average(sums[i], scale);
+    }
+}
+
+/// Blur the columns of an image with a box, treating pixels outside as 0.
+//
+/// Every byte of a row is blurred with the bytes at the same place in the
+/// rows above and below, so this works for any pixel format. The rows are
+/// worked through in order, which is kinder to the cache than going down
+/// each column.
+void
+blurColumns(std::uint8_t* data, size_t bytes, size_t height, size_t stride,
+        size_t radius)
+{
+    const float scale = 1.0f / (2 * radius + 1);
+    std::vector<std::int32_t> sums(bytes);
+
+    // The rows that leave the box after they have been overwritten.
+    const size_t kept = radius + 1;
+    Plane saved(kept * bytes);
+
+    for (size_t y = 0; y < height && y <= radius; ++y) {
+        accumulate(sums.data(), data + y * stride, bytes, true);
+    }
+
+    for (size_t y = 0; y < height; ++y) {
+        std::uint8_t* row = data + y * stride;
+        std::copy(row, row + bytes, saved.begin() + (y % kept) * bytes);
+        averageRow(row, sums.data(), bytes, scale);
+
+        const size_t in = y + radius + 1;
+        if (in < height) accumulate(sums.data(), data + in * stride, bytes,
+                true);
+        if (y >= radius) {
+            accumulate(sums.data(), &saved[((y - radius) % kept) * bytes],
+                    bytes, false);
+        }
+    }
+}
+
+/// Blur an image with a number of passes of a box.
+//
+/// Three passes are close to a gaussian blur.
+void
+boxBlur(std::uint8_t* data, size_t width, size_t height, size_t stride,
+        size_t channels, int rx, int ry, int passes)
+{
+    for (int i = 0; i < passes; ++i) {
+        if (rx) blurRows(data, width, height, stride, channels, rx);
+        if (ry) blurColumns(data, width * channels, height, stride, ry);
+    }
+}
+
+/// The offset of an effect at an angle, in device pixels.
+void
+offset(float angle, float distance, double scale, int& dx, int& dy)
+{
+    const double a = angle * PI / 180;
+    dx = std::lrint(std::cos(a) * distance * scale);
+    dy = std::lrint(std::sin(a) * distance * scale);
+}
+
+/// The alpha channel of an image, moved and blurred.
+//
+/// @param invert   Use 255 - alpha, for effects inside the object.
+Plane
+alphaPlane(const image::GnashImage& im, int dx, int dy, bool invert,
+        int rx, int ry, int passes)
+{
+    const std::int64_t width = im.width();
+    const std::int64_t height = im.height();
+    const std::uint8_t flip = invert ? 0xff : 0;
+
+    Plane plane(width * height, flip);
+
+    for (std::int64_t y = 0; y < height; ++y) {
+        const std::int64_t sy = y - dy;
+        if (sy < 0 || sy >= height) continue;
+        const std::uint8_t* src = scanline(im, sy);
+        std::uint8_t* dst = &plane[y * width];
+        for (std::int64_t x = 0; x < width; ++x) {
+            const std::int64_t sx = x - dx;
+            if (sx < 0 || sx >= width) continue;
+            dst[x] = src[sx * 4 + 3] ^ flip;
+        }
+    }
+
+    boxBlur(plane.data(), width, height, width, 1, rx, ry, passes);
+    return plane;
+}
+
+/// Apply a strength to a value from 0 to 255.
+inline unsigned
+strengthen(unsigned v, float strength)
+{
+    return std::min<float>(v * strength, 255);
+}
+
+/// An effect of one color, as premultiplied RGBA pixels.
+Plane
+colorEffect(const Plane& plane, std::uint32_t color, std::uint8_t alpha,
+        float strength)
+{
+    const std::uint8_t r = color >> 16, g = color >> 8, b = color;
+    Plane effect(plane.size() * 4);
+    for (size_t i = 0; i < plane.size(); ++i) {
+        const std::uint8_t a = mul255(strengthen(plane[i], strength), alpha);
+        std::uint8_t* e = &effect[i * 4];
+        e[0] = mul255(r, a);
+        e[1] = mul255(g, a);
+        e[2] = mul255(b, a);
+        e[3] = a;
+    }
+    return effect;
+}
+
+/// The premultiplied colors of a gradient at 256 places.
+Plane
+gradientRamp(const std::vector<std::uint32_t>& colors,
+        const std::vector<std::uint8_t>& alphas,
+        const std::vector<std::uint8_t>& ratios)
+{
+    const size_t stops = std::min(colors.size(),
+            std::min(alphas.size(), ratios.size()));
+
+    Plane ramp(256 * 4);
+    if (!stops) return ramp;
+
+    for (size_t i = 0; i < 256; ++i) {
+        size_t next = 0;
+        while (next < stops && ratios[next] < i) ++next;
+
+        std::uint32_t color;
+        unsigned alpha;
+        if (next == 0 || next == stops) {
+            const size_t s = next ? stops - 1 : 0;
+            color = colors[s];
+            alpha = alphas[s];
+        }
+        else {
+            const size_t prev = next - 1;
+            const unsigned span = ratios[next] - ratios[prev];
+            const unsigned f = span ? (i - ratios[prev]) * 255 / span : 255;
+            color = 0;
+            for (int shift = 0; shift < 24; shift += 8) {
+                const unsigned c0 = (colors[prev] >> shift) & 0xff;
+                const unsigned c1 = (colors[next] >> shift) & 0xff;
+                color |= ((c0 * (255 - f) + c1 * f) / 255) << shift;
+            }
+            alpha = (alphas[prev] * (255 - f) + alphas[next] * f) / 255;
+        }
+
+        std::uint8_t* e = &ramp[i * 4];
+        e[0] = mul255(color >> 16 & 0xff, alpha);
+        e[1] = mul255(color >> 8 & 0xff, alpha);
+        e[2] = mul255(color & 0xff, alpha);
+        e[3] = alpha;
+    }
+    return ramp;
+}
+
+/// Draw an effect onto an image.
+//
+/// @param effect       The effect, as premultiplied RGBA pixels.
+/// @param region       Whether the effect is inside or outside the
+///                     object, or both.
+/// @param knockout     Only draw the effect, where it would be visible.
+/// @param hideObject   Only draw the effect, even where the object would
+///                     cover it.
+void
+composite(image::GnashImage& im, const Plane& effect, Region region,
+        bool knockout, bool hideObject)
+{
+    const size_t width = im.width();
+    for (size_t y = 0; y < im.height(); ++y) {
+        std::uint8_t* s = scanline(im, y);
+        const std::uint8_t* e = &effect[y * width * 4];
+        for (size_t x = 0; x < width; ++x, s += 4, e += 4) {
+            const std::uint8_t sa = s[3];
+            const std::uint8_t ea = e[3];
+            for (size_t c = 0; c < 4; ++c) {
+                switch (region) {
+                    case INSIDE:
+                    {
+                        const std::uint8_t v = mul255(e[c], sa);
+                        s[c] = (knockout || hideObject) ? v :
+                            v + mul255(s[c], 255 - ea);
+                        break;
+                    }
+                    case OUTSIDE:
+                    {
+                        const std::uint8_t v = mul255(e[c], 255 - sa);
+                        if (hideObject) s[c] = e[c];
+                        else if (knockout) s[c] = v;
+                        else s[c] += v;
+                        break;
+                    }
+                    case EVERYWHERE:
+                        s[c] = (knockout || hideObject) ? e[c] :
+                            e[c] + mul255(s[c], 255 - ea);
+                        break;
+                }
+            }
+        }
+    }
+}
+
+/// The difference between the alpha on the light side of a pixel and on
+/// the dark side, from -255 (all dark) to 255 (all light).
+class Bevel
+{
+public:
+    Bevel(const image::GnashImage& im, float angle, float distance,
+            float blurX, float blurY, int passes, float strength,
+            double scale)
+        :
+        _width(im.width()),
+        _height(im.height()),
+        _strength(strength)
+    {
+        offset(angle, distance, scale, _dx, _dy);
+        _alpha = alphaPlane(im, 0, 0, false, boxRadius(blurX, scale),
+                boxRadius(blurY, scale), passes);
+    }
+
+    int operator()(size_t x, size_t y) const {
+        const int v = at(x + _dx, y + _dy) - at(x - _dx, y - _dy);
+        return std::max<float>(-255, std::min<float>(v * _strength, 255));
+    }
+
+private:
+
+    int at(std::int64_t x, std::int64_t y) const {
+        if (x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+        return _alpha[y * _width + x];
+    }
+
+    const std::int64_t _width;
+    const std::int64_t _height;
+    const float _strength;
+    int _dx;
+    int _dy;
+    Plane _alpha;
+};
+
+/// The region of a bevel or gradient glow type.
+//
+/// These are the same for all the filters that have them.
+Region
+region(int type)
+{
+    switch (type) {
+        case BevelFilter::INNER_BEVEL:
+            return INSIDE;
+        case BevelFilter::OUTER_BEVEL:
+            return OUTSIDE;
+        default:
+            return EVERYWHERE;
+    }
+}
+
+/// Convert an RGBA image to floats without premultiplied alpha.
+std::vector<float>
+unpremultiplied(const image::GnashImage& im)
+{
+    const size_t width = im.width();
+    std::vector<float> out(width * im.height() * 4);
+    float* o = out.data();
+    for (size_t y = 0; y < im.height(); ++y) {
+        const std::uint8_t* p = scanline(im, y);
+        for (size_t x = 0; x < width; ++x, p += 4, o += 4) {
+            const float f = p[3] ? 255.0f / p[3] : 0;
+            o[0] = p[0] * f;
+            o[1] = p[1] * f;
+            o[2] = p[2] * f;
+            o[3] = p[3];
+        }
+    }
+    return out;
+}
+
+/// Store a pixel from floats, clamping it and premultiplying the alpha.
+inline void
+storePremultiplied(std::uint8_t* p, const float* v)
+{
+    const float a = std::max(0.0f, std::min(v[3], 255.0f));
+    const float f = a / 255;
+    for (size_t c = 0; c < 3; ++c) {
+        p[c] = std::lrint(std::max(0.0f, std::min(v[c], 255.0f)) * f);
+    }
+    p[3] = std::lrint(a);
+}
+
+} // anonymous namespace
+
+bool
+useFiltersSSE2(bool use)
+{
+#ifdef __SSE2__
+    sse2 = use;
+    return true;
+#else
+    UNUSED(use);
+    return false;
+#endif
+}
+
+double
+filtersMargin(const Filters& filters)
+{
+    double margin = 0;
+    for (const auto& f : filters) margin += f->margin();
+    return margin;
+}
+
+std::unique_ptr<BitmapFilter>
+BlurFilter::clone() const
+{
+    return std::unique_ptr<BitmapFilter>(new BlurFilter(*this));
+}
+
+double
+BlurFilter::margin() const
+{
+    return std::max(m_blurX, m_blurY) / 2 * m_quality;
+}
+
+void
+BlurFilter::apply(image::GnashImage& im, double scale) const
+{
+    assert(im.type() == image::TYPE_RGBA);
+    boxBlur(im.begin(), im.width(), im.height(), im.stride(), 4,
+            boxRadius(m_blurX, scale), boxRadius(m_blurY, scale), m_quality);
+}
+
+std::unique_ptr<BitmapFilter>
+DropShadowFilter::clone() const
+{
+    return std::unique_ptr<BitmapFilter>(new DropShadowFilter(*this));
+}
+
+double
+DropShadowFilter::margin() const
+{
+    return std::max(m_blurX, m_blurY) / 2 * m_quality + m_distance;
+}
+
+void
+DropShadowFilter::apply(image::GnashImage& im, double scale) const
+{
+    assert(im.type() == image::TYPE_RGBA);
+    int dx, dy;
+    offset(m_angle, m_distance, scale, dx, dy);
+    const Plane shadow = alphaPlane(im, dx, dy, m_inner,
+            boxRadius(m_blurX, scale), boxRadius(m_blurY, scale), m_quality);
+    composite(im, colorEffect(shadow, m_color, m_alpha, m_strength),
+            m_inner ? INSIDE : OUTSIDE, m_knockout, m_hideObject);
+}
+
+std::unique_ptr<BitmapFilter>
+GlowFilter::clone() const
+{
+    return std::unique_ptr<BitmapFilter>(new GlowFilter(*this));
+}
+
+double
+GlowFilter::margin() const
+{
+    return std::max(m_blurX, m_blurY) / 2 * m_quality;
+}
+
+void
+GlowFilter::apply(image::GnashImage& im, double scale) const
+{
+    assert(im.type() == image::TYPE_RGBA);
+    const Plane glow = alphaPlane(im, 0, 0, m_inner,
+            boxRadius(m_blurX, scale), boxRadius(m_blurY, scale), m_quality);
+    composite(im, colorEffect(glow, m_color, m_alpha, m_strength),
+            m_inner ? INSIDE : OUTSIDE, m_knockout, false);
+}
+
+std::unique_ptr<BitmapFilter>
+BevelFilter::clone() const
+{
+    return std::unique_ptr<BitmapFilter>(new BevelFilter(*this));
+}
+
+double
+BevelFilter::margin() const
+{
+    return std::max(m_blurX, m_blurY) / 2 * m_quality + m_distance;
+}
+
+void
+BevelFilter::apply(image::GnashImage& im, double scale) const
+{
+    assert(im.type() == image::TYPE_RGBA);
+    const Bevel bevel(im, m_angle, m_distance, m_blurX, m_blurY, m_quality,
+            m_strength, scale);
+
+    const size_t width = im.width();
+    Plane effect(width * im.height() * 4);
+    for (size_t y = 0; y < im.height(); ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            const int v = bevel(x, y);
+            const std::uint32_t color = v > 0 ? m_highlightColor :
+                m_shadowColor;
+            const std::uint8_t a = mul255(std::abs(v),
+                    v > 0 ? m_highlightAlpha : m_shadowAlpha);
+            std::uint8_t* e = &effect[(y * width + x) * 4];
+            e[0] = mul255(color >> 16 & 0xff, a);
+            e[1] = mul255(color >> 8 & 0xff, a);
+            e[2] = mul255(color & 0xff, a);
+            e[3] = a;
+        }
+    }
+    composite(im, effect, region(m_type), m_knockout, false);
+}
+
+std::unique_ptr<BitmapFilter>
+GradientGlowFilter::clone() const
+{
+    return std::unique_ptr<BitmapFilter>(new GradientGlowFilter(*this));
+}
+
+double
+GradientGlowFilter::margin() const
+{
+    return std::max(m_blurX, m_blurY) / 2 * m_quality + m_distance;
+}
+
+void
+GradientGlowFilter::apply(image::GnashImage& im, double scale) const
+{
+    assert(im.type() == image::TYPE_RGBA);
+    const Plane ramp = gradientRamp(m_colors, m_alphas, m_ratios);
+
+    int dx, dy;
+    offset(m_angle, m_distance, scale, dx, dy);
+    const int rx = boxRadius(m_blurX, scale);
+    const int ry = boxRadius(m_blurY, scale);
+
+    // A full glow is an inner glow and an outer one.
+    const Region regions[] = { INSIDE, OUTSIDE };
+    for (const Region r : regions) {
+        if (m_type != FULL_GLOW && region(m_type) != r) continue;
+
+        const Plane glow = alphaPlane(im, dx, dy, r == INSIDE, rx, ry,
+                m_quality);
+        Plane effect(glow.size() * 4);
+        for (size_t i = 0; i < glow.size(); ++i) {
+            const std::uint8_t* c = &ramp[strengthen(glow[i], m_strength) * 4];
+            std::copy(c, c + 4, effect.begin() + i * 4);
+        }
+        composite(im, effect, r, m_knockout, false);
+    }
+}
+
+std::unique_ptr<BitmapFilter>
+GradientBevelFilter::clone() const
+{
+    return std::unique_ptr<BitmapFilter>(new GradientBevelFilter(*this));
+}
+
+double
+GradientBevelFilter::margin() const
+{
+    return std::max(m_blurX, m_blurY) / 2 * m_quality + m_distance;
+}
+
+void
+GradientBevelFilter::apply(image::GnashImage& im, double scale) const
+{
+    assert(im.type() == image::TYPE_RGBA);
+    const Plane ramp = gradientRamp(m_colors, m_alphas, m_ratios);
+    const Bevel bevel(im, m_angle, m_distance, m_blurX, m_blurY, m_quality,
+            m_strength, scale);
+
+    // The highlight is at the start of the gradient, the shadow at the
+    // end, and the middle is where there is no bevel.
+    const size_t width = im.width();
+    Plane effect(width * im.height() * 4);
+    for (size_t y = 0; y < im.height(); ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            const int v = bevel(x, y);
+            const int pos = std::max(0, std::min(128 - v * 128 / 255, 255));
+            const std::uint8_t* c = &ramp[pos * 4];
+            std::copy(c, c + 4, effect.begin() + (y * width + x) * 4);
+        }
+    }
+    composite(im, effect, region(m_type), m_knockout, false);
+}
+
+std::unique_ptr<BitmapFilter>
+ColorMatrixFilter::clone() const
+{
+    return std::unique_ptr<BitmapFilter>(new ColorMatrixFilter(*this));
+}
+
+void
+ColorMatrixFilter::apply(image::GnashImage& im, double /*scale*/) const
+{
+    assert(im.type() == image::TYPE_RGBA);
+    if (m_matrix.size() != 20) return;
+
+    const std::vector<float>& m = m_matrix;
+    const size_t width = im.width();
+
+#ifdef __SSE2__
+    // Each column of the matrix gives what a channel adds to the four
+    // results.
+    const __m128 cols[5] = {
+        _mm_setr_ps(m[0], m[5], m[10], m[15]),
+        _mm_setr_ps(m[1], m[6], m[11], m[16]),
+        _mm_setr_ps(m[2], m[7], m[12], m[17]),
+        _mm_setr_ps(m[3], m[8], m[13], m[18]),
+        _mm_setr_ps(m[4], m[9], m[14], m[19])
+    };
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 max = _mm_set1_ps(255);
+    const __m128 rgb = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    const __m128 alphaOne = _mm_setr_ps(0, 0, 0, 1);
+#endif
+
+    for (size_t y = 0; y < im.height(); ++y) {
+        std::uint8_t* p = scanline(im, y);
+        for (size_t x = 0; x < width; ++x, p += 4) {
+            const float f = p[3] ? 255.0f / p[3] : 0;
+            const float in[4] = { p[0] * f, p[1] * f, p[2] * f,
+                static_cast<float>(p[3]) };
+
+#ifdef __SSE2__
+            if (sse2) {
+                __m128 out = cols[4];
+                for (size_t c = 0; c < 4; ++c) {
+                    out = _mm_add_ps(out,
+                            _mm_mul_ps(cols[c], _mm_set1_ps(in[c])));
+                }
+                out = _mm_min_ps(_mm_max_ps(out, zero), max);
+
+                // Premultiply the colors, leaving the alpha.
+                const __m128 a =
+                    _mm_shuffle_ps(out, out, _MM_SHUFFLE(3, 3, 3, 3));
+                const __m128 mul = _mm_or_ps(
+                        _mm_and_ps(_mm_div_ps(a, max), rgb), alphaOne);
+                storePixel(p, _mm_cvtps_epi32(_mm_mul_ps(out, mul)));
+                continue;
+            }
+#endif
+            float out[4];
+            for (size_t r = 0; r < 4; ++r) {
+                out[r] = m[r * 5 + 4];
+                for (size_t c = 0; c < 4; ++c) out[r] += m[r * 5 + c] * in[c];
+            }
+            storePremultiplied(p, out);
+        }
+    }
+}
+
+std::unique_ptr<BitmapFilter>
+ConvolutionFilter::clone() const
+{
+    return std::unique_ptr<BitmapFilter>(new ConvolutionFilter(*this));
+}
+
+double
+ConvolutionFilter::margin() const
+{
+    return 0;
+}
+
+void
+ConvolutionFilter::apply(image::GnashImage& im, double /*scale*/) const
+{
+    assert(im.type() == image::TYPE_RGBA);
+
+    const size_t mx = _matrixX;
+    const size_t my = _matrixY;
+    if (!mx || !my || _matrix.size() < mx * my) return;
+
+    const std::int64_t width = im.width();
+    const std::int64_t height = im.height();
+    const std::vector<float> src = unpremultiplied(im);
+
+    // Surround the image with the pixels the matrix reaches outside it,
+    // so the loop below needs no checks. These are the edge pixels when
+    // clamping, and the filter's color otherwise.
+    const std::int64_t left = mx / 2;
+    const std::int64_t top = my / 2;
+    const std::int64_t pw = width + mx - 1;
+    const std::int64_t ph = height + my - 1;
+    const float color[4] = {
+        static_cast<float>(_color >> 16 & 0xff),
+        static_cast<float>(_color >> 8 & 0xff),
+        static_cast<float>(_color & 0xff),
+        static_cast<float>(_alpha)
+    };
+
+    std::vector<float> padded(pw * ph * 4);
+    for (std::int64_t y = 0; y < ph; ++y) {
+        for (std::int64_t x = 0; x < pw; ++x) {
+            std::int64_t sx = x - left;
+            std::int64_t sy = y - top;
+            const bool outside = sx < 0 || sy < 0 || sx >= width ||
+                sy >= height;
+            const float* from = color;
+            if (!outside || _clamp) {
+                sx = std::max<std::int64_t>(0, std::min(sx, width - 1));
+                sy = std::max<std::int64_t>(0, std::min(sy, height - 1));
+                from = &src[(sy * width + sx) * 4];
+            }
+            std::copy(from, from + 4, padded.begin() + (y * pw + x) * 4);
+        }
+    }
+
+    const float divisor = _divisor ? _divisor : 1;
+
+    for (std::int64_t y = 0; y < height; ++y) {
+        std::uint8_t* p = scanline(im, y);
+        for (std::int64_t x = 0; x < width; ++x, p += 4) {
+            float out[4];
+            std::fill(out, out + 4, 0.0f);
+            for (size_t ky = 0; ky < my; ++ky) {
+                const float* row = &padded[((y + ky) * pw + x) * 4];
+                const float* k = &_matrix[ky * mx];
+#ifdef __SSE2__
+                if (sse2) {
+                    __m128 acc = _mm_loadu_ps(out);
+                    for (size_t kx = 0; kx < mx; ++kx) {
+                        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(k[kx]),
+                                    _mm_loadu_ps(row + kx * 4)));
+                    }
+                    _mm_storeu_ps(out, acc);
+                    continue;
+                }
+#endif
+                for (size_t kx = 0; kx < mx; ++kx) {
+                    for (size_t c = 0; c < 4; ++c) {
+                        out[c] += k[kx] * row[kx * 4 + c];
+                    }
+                }
+            }
+            for (size_t c = 0; c < 4; ++c) out[c] = out[c] / divisor + _bias;
+            if (_preserveAlpha) out[3] = src[(y * width + x) * 4 + 3];
+            storePremultiplied(p, out);
+        }
+    }
+}
+
+} // namespace gnash
+
+// Local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
@@ -21,16 +21,42 @@
 #define GNASH_FILTERS_H
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 #include <utility>
 
 namespace gnash {
     class SWFStream;
+    class BitmapFilter;
+    namespace image {
+        class GnashImage;
+    }
 }
 
 namespace gnash {
 
+/// The filters of a DisplayObject, applied in order.
+typedef std::vector<std::unique_ptr<BitmapFilter> > Filters;
+
+/// Whether the filters use SSE2, where the compiler targets it.
+//
+/// They always do unless this is turned off, which is so that tests can
+/// check that the plain loops give the same results.
+///
+/// @return     Whether the filters can use SSE2.
+bool useFiltersSSE2(bool use);
+
+/// How far a list of filters reaches beyond what they are applied to.
+//
+/// @return     The sum of the filters' margins, in stage pixels.
+double filtersMargin(const Filters& filters);
+
 // The common base class for AS display filters.
+//
+// Filters are applied to bitmaps with premultiplied alpha, in device
+// pixels. Their sizes and distances are in stage pixels, so they are
+// scaled by the number of device pixels per stage pixel. See Filters.cpp
+// for the implementations.
 class BitmapFilter
 {
 public:
@@ -39,6 +65,23 @@ public:
     }
     BitmapFilter() {}
     virtual ~BitmapFilter() {}
+
+    /// Make a copy of the filter.
+    virtual std::unique_ptr<BitmapFilter> clone() const = 0;
+
+    /// How far the filter reaches beyond what it is applied to.
+    //
+    /// @return     The distance in stage pixels. The bitmap passed to
+    ///             apply() must have this much room around its contents.
+    virtual double margin() const {
+        return 0;
+    }
+
+    /// Apply the filter to an RGBA image.
+    //
+    /// @param im       The image, with premultiplied alpha.
+    /// @param scale    The number of device pixels per stage pixel.
+    virtual void apply(image::GnashImage& im, double scale) const = 0;
 };
 
 // A bevel effect filter.
@@ -57,6 +100,10 @@ public:
 
     virtual ~BevelFilter() {}
 
+    virtual std::unique_ptr<BitmapFilter> clone() const;
+    virtual double margin() const;
+    virtual void apply(image::GnashImage& im, double scale) const;
+
     BevelFilter()
         : 
         m_distance(0.0f),
@@ -84,7 +131,7 @@ public:
     {}
 
     float m_distance; // Distance of the filter in pixels.
-    float m_angle; // Angle of the filter.
+    float m_angle; // Angle of the filter, in degrees.
     std::uint32_t m_highlightColor; // Color of the highlight.
     std::uint8_t m_highlightAlpha; // Alpha of the highlight.
     std::uint32_t m_shadowColor; // RGB color.
@@ -106,6 +153,10 @@ public:
 
     virtual ~BlurFilter() {}
 
+    virtual std::unique_ptr<BitmapFilter> clone() const;
+    virtual double margin() const;
+    virtual void apply(image::GnashImage& im, double scale) const;
+
     BlurFilter() : 
         m_blurX(0.0f), m_blurY(0.0f), m_quality(0)
     {}
@@ -128,6 +179,9 @@ public:
 
     virtual ~ColorMatrixFilter() {}
 
+    virtual std::unique_ptr<BitmapFilter> clone() const;
+    virtual void apply(image::GnashImage& im, double scale) const;
+
     ColorMatrixFilter() : 
         m_matrix()
     {}
@@ -150,6 +204,10 @@ public:
 
     virtual ~ConvolutionFilter() {}
 
+    virtual std::unique_ptr<BitmapFilter> clone() const;
+    virtual double margin() const;
+    virtual void apply(image::GnashImage& im, double scale) const;
+
     ConvolutionFilter()
         :
         _matrixX(),
@@ -200,6 +258,10 @@ public:
 
     virtual ~DropShadowFilter() {}
 
+    virtual std::unique_ptr<BitmapFilter> clone() const;
+    virtual double margin() const;
+    virtual void apply(image::GnashImage& im, double scale) const;
+
     DropShadowFilter() : 
         m_distance(0.0f), m_angle(0.0f), m_color(0), m_alpha(0),
         m_blurX(0.0f), m_blurY(0.0f),  m_strength(0.0f), m_quality(0),
@@ -216,9 +278,9 @@ public:
     {}
 
     float m_distance; // Distance of the filter in pixels.
-    float m_angle; // Angle of the filter.
+    float m_angle; // Angle of the filter, in degrees.
     std::uint32_t m_color; // RGB color.
-    std::uint8_t m_alpha; // Alpha strength, as a percentage(?)
+    std::uint8_t m_alpha; // Alpha of the color, from 0 to 255.
     float m_blurX; // horizontal blur
     float m_blurY; // vertical blur
     float m_strength; // How strong is the filter.
@@ -238,6 +300,10 @@ public:
 
     virtual ~GlowFilter() {}
 
+    virtual std::unique_ptr<BitmapFilter> clone() const;
+    virtual double margin() const;
+    virtual void apply(image::GnashImage& im, double scale) const;
+
     GlowFilter() : 
         m_color(0), m_alpha(0),
         m_blurX(0.0f), m_blurY(0.0f),  m_strength(0.0f), m_quality(0),
@@ -253,7 +319,7 @@ public:
     {}
 
     std::uint32_t m_color; // RGB color.
-    std::uint8_t m_alpha; // Alpha strength, as a percentage(?)
+    std::uint8_t m_alpha; // Alpha of the color, from 0 to 255.
     float m_blurX; // horizontal blur
     float m_blurY; // vertical blur
     float m_strength; // How strong is the filter.
@@ -279,6 +345,10 @@ public:
 
     virtual ~GradientBevelFilter() {}
 
+    virtual std::unique_ptr<BitmapFilter> clone() const;
+    virtual double margin() const;
+    virtual void apply(image::GnashImage& im, double scale) const;
+
     GradientBevelFilter() : 
         m_distance(0.0f), m_angle(0.0f), m_colors(), m_alphas(), m_ratios(),
         m_blurX(0.0f), m_blurY(0.0f),  m_strength(0.0f), m_quality(0),
@@ -298,7 +368,7 @@ public:
     {}
 
     float m_distance; // Distance of the filter in pixels.
-    float m_angle; // Angle of the filter.
+    float m_angle; // Angle of the filter, in degrees.
     std::vector<std::uint32_t> m_colors; // Colors of the gradients.
     std::vector<std::uint8_t> m_alphas; // Alphas of the gradients.
     std::vector<std::uint8_t> m_ratios; // Ratios of the gradients.
@@ -326,6 +396,10 @@ public:
 
     virtual ~GradientGlowFilter() {}
 
+    virtual std::unique_ptr<BitmapFilter> clone() const;
+    virtual double margin() const;
+    virtual void apply(image::GnashImage& im, double scale) const;
+
     GradientGlowFilter() : 
         m_distance(0.0f), m_angle(0.0f), m_colors(), m_alphas(), m_ratios(),
         m_blurX(0.0f), m_blurY(0.0f),  m_strength(0.0f), m_quality(0),
@@ -344,7 +418,7 @@ public:
     {}
 
     float m_distance; // Distance of the filter in pixels.
-    float m_angle; // Angle of the filter.
+    float m_angle; // Angle of the filter, in degrees.
     std::vector<std::uint32_t> m_colors; // Colors of the gradients.
     std::vector<std::uint8_t> m_alphas; // Alphas of the gradients.
     std::vector<std::uint8_t> m_ratios; // Ratios of the gradients.
@@ -77,6 +77,7 @@ Function::call(const fn_call& fn)
     // Set up local stack frame, for parameters and locals.
     FrameGuard guard(getVM(fn), *this);
     CallFrame& cf = guard.callFrame();
+    ProfileGuard profile(vm.profiler(), *this);
 
     DisplayObject* target = _env.target();
     DisplayObject* orig_target = _env.get_original_target();
@@ -53,6 +53,7 @@ Function2::call(const fn_call& fn)
 	// Set up local stack frame, for parameters and locals.
 	FrameGuard guard(getVM(fn), *this);
     CallFrame& cf = guard.callFrame();
+    ProfileGuard profile(vm.profiler(), *this);
 
 	DisplayObject* target = _env.target();
 	DisplayObject* orig_target = _env.get_original_target();
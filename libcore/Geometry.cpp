@@ -119,8 +119,207 @@ int curve_x_crossings(const T x0, const T y0, const T x1, const T y1,
     return count;
 }
 
+/// Whether a point is on the stroke of a path.
+//
+/// @param bounds   The bounds of the path's points, to give up early for
+///                 points far from the path, or null.
+bool
+strokeTest(const Path& pth, const std::vector<LineStyle>& lineStyles,
+        const point& pt, const SWFMatrix& wm, const SWFRect* bounds)
+{
+    if (pth.m_line == 0) return false;
+
+    assert(lineStyles.size() >= pth.m_line);
+    const LineStyle& ls = lineStyles[pth.m_line-1];
+    double thickness = ls.getThickness();
+    if (! thickness )
+    {
+        thickness = 20; // at least ONE PIXEL thick.
+    }
+    else if ((!ls.scaleThicknessVertically()) &&
+            (!ls.scaleThicknessHorizontally()) )
+    {
+        // TODO: pass the SWFMatrix to withinSquareDistance instead ?
+        double xScale = wm.get_x_scale();
+        double yScale = wm.get_y_scale();
+        thickness *= std::max(xScale, yScale);
+    }
+    else if (ls.scaleThicknessVertically() != 
+            ls.scaleThicknessHorizontally())
+    {
+        LOG_ONCE(log_unimpl(_("Collision detection for "
+                              "unidirectionally scaled strokes")));
+    }
+
+    double dist = thickness / 2.0;
+
+    if (bounds) {
+        if (bounds->is_null()) return false;
+        if (pt.x < bounds->get_x_min() - dist ||
+                pt.x > bounds->get_x_max() + dist ||
+                pt.y < bounds->get_y_min() - dist ||
+                pt.y > bounds->get_y_max() + dist) {
+            return false;
+        }
+    }
+
+    double sqdist = dist * dist;
+    return pth.withinSquareDistance(pt, sqdist);
+}
+
+/// Count the crossings of an edge with the ray left of a point.
+//
+/// See pointTest() for how the counter works.
+void
+countCrossings(const Path& pth, float pen_x, float pen_y, const Edge& edg,
+        std::int32_t x, std::int32_t y, int& counter)
+{
+    float cross1 = 0.0, cross2 = 0.0;
+    int dir1 = 0, dir2 = 0; // +1 = downward, -1 = upward
+    int crosscount = 0;
+
+    if (edg.straight())
+    {
+        // ignore horizontal lines
+        // TODO: better check for small difference?
+        if (edg.ap.y == pen_y)  
+        {
+            return;
+        }
+        // does this line cross the Y coordinate?
+        if ( ((pen_y <= y) && (edg.ap.y >= y))
+            || ((pen_y >= y) && (edg.ap.y <= y)) )
+        {
+
+            // calculate X crossing
+            cross1 = pen_x + (edg.ap.x - pen_x) *
+                (y - pen_y) / (edg.ap.y - pen_y);
+
+            if (pen_y > edg.ap.y)
+                dir1 = -1;  // upward
+            else
+                dir1 = +1;  // downward
+
+            crosscount = 1;
+        }
+        else
+        {
+            // no crossing found
+            crosscount = 0;
+        }
+    }
+    else {
+        // ==> curve case
+        crosscount = 
+            curve_x_crossings<float>(pen_x, pen_y, edg.ap.x, edg.ap.y,
+                edg.cp.x, edg.cp.y, y, cross1, cross2);
+        dir1 = pen_y > y ? -1 : +1;
+        dir2 = dir1 * (-1); // second crossing always in opposite dir.
+    } // curve
+
+    // ==> we have now:
+    //  - one (cross1) or two (cross1, cross2) ray crossings (X
+    //    coordinate)
+    //  - dir1/dir2 tells the direction of the crossing
+    //    (+1 = downward, -1 = upward)
+    //  - crosscount tells the number of crossings
+
+    // need at least one crossing
+    if (crosscount == 0)
+    {
+        return;
+    }
+
+    // check first crossing
+    if (cross1 <= x)
+    {
+        if (pth.m_fill0 > 0) counter += dir1;
+        if (pth.m_fill1 > 0) counter -= dir1;
+    }
+
+    // check optional second crossing (only possible with curves)
+    if ( (crosscount > 1) && (cross2 <= x) )
+    {
+        if (pth.m_fill0 > 0) counter += dir2;
+        if (pth.m_fill1 > 0) counter -= dir2;
+    }
+}
+
+/// The most bands made for one set of paths.
+const size_t maxBands = 1024;
+
+/// How many edges there should be for each band.
+const size_t edgesPerBand = 8;
+
 } // anonymous namespace
 
+EdgeBands::EdgeBands(const std::vector<Path>& paths)
+    :
+    _top(0),
+    _bandHeight(1)
+{
+    size_t nedges = 0;
+    SWFRect all;
+
+    _pathBounds.resize(paths.size());
+    for (size_t pno = 0; pno < paths.size(); ++pno) {
+        const Path& pth = paths[pno];
+        if (pth.empty()) continue;
+
+        SWFRect& bounds = _pathBounds[pno];
+        bounds.expand_to_point(pth.ap.x, pth.ap.y);
+        for (const Edge& edg : pth.m_edges) {
+            bounds.expand_to_point(edg.ap.x, edg.ap.y);
+            bounds.expand_to_point(edg.cp.x, edg.cp.y);
+        }
+        all.expand_to_rect(bounds);
+        nedges += pth.m_edges.size();
+    }
+
+    if (all.is_null()) return;
+
+    const size_t nbands = std::max<size_t>(1,
+            std::min(maxBands, nedges / edgesPerBand));
+    const std::int64_t height =
+        std::int64_t(all.get_y_max()) - all.get_y_min() + 1;
+
+    _top = all.get_y_min();
+    _bandHeight = (height + nbands - 1) / nbands;
+    _bands.resize((height + _bandHeight - 1) / _bandHeight);
+
+    for (size_t pno = 0; pno < paths.size(); ++pno) {
+        const Path& pth = paths[pno];
+        if (pth.empty()) continue;
+
+        std::int32_t pen_y = pth.ap.y;
+        for (size_t eno = 0; eno < pth.m_edges.size(); ++eno) {
+            const Edge& edg = pth.m_edges[eno];
+
+            // A curve stays within its control point.
+            std::int32_t top = std::min(pen_y, edg.ap.y);
+            std::int32_t bottom = std::max(pen_y, edg.ap.y);
+            if (!edg.straight()) {
+                top = std::min(top, edg.cp.y);
+                bottom = std::max(bottom, edg.cp.y);
+            }
+            pen_y = edg.ap.y;
+
+            for (size_t b = band(top), e = band(bottom); b <= e; ++b) {
+                _bands[b].push_back(EdgeRef(pno, eno));
+            }
+        }
+    }
+}
+
+const std::vector<EdgeBands::EdgeRef>&
+EdgeBands::edges(std::int32_t y) const
+{
+    if (_bands.empty() || y < _top) return _none;
+    const size_t b = band(y);
+    if (b >= _bands.size()) return _none;
+    return _bands[b];
+}
+
 bool
 pointTest(const std::vector<Path>& paths,
         const std::vector<LineStyle>& lineStyles, std::int32_t x,
@@ -164,35 +363,7 @@ pointTest(const std::vector<Path>& paths,
         if (pth.empty()) continue;
 
         // If the path has a line style, check for strokes there
-        if (pth.m_line != 0 )
-        {
-            assert(lineStyles.size() >= pth.m_line);
-            const LineStyle& ls = lineStyles[pth.m_line-1];
-            double thickness = ls.getThickness();
-            if (! thickness )
-            {
-                thickness = 20; // at least ONE PIXEL thick.
-            }
-            else if ((!ls.scaleThicknessVertically()) &&
-                    (!ls.scaleThicknessHorizontally()) )
-            {
-                // TODO: pass the SWFMatrix to withinSquareDistance instead ?
-                double xScale = wm.get_x_scale();
-                double yScale = wm.get_y_scale();
-                thickness *= std::max(xScale, yScale);
-            }
-            else if (ls.scaleThicknessVertically() != 
-                    ls.scaleThicknessHorizontally())
-            {
-                LOG_ONCE(log_unimpl(_("Collision detection for "
-                                      "unidirectionally scaled strokes")));
-            }
-
-            double dist = thickness / 2.0;
-            double sqdist = dist * dist;
-            if (pth.withinSquareDistance(pt, sqdist))
-                return true;
-        }
+        if (strokeTest(pth, lineStyles, pt, wm, nullptr)) return true;
 
         // browse all edges of the path
         for (unsigned eno=0; eno<nedges; eno++)
@@ -203,78 +374,43 @@ pointTest(const std::vector<Path>& paths,
             next_pen_x = edg.ap.x;
             next_pen_y = edg.ap.y;
 
-            float cross1 = 0.0, cross2 = 0.0;
-            int dir1 = 0, dir2 = 0; // +1 = downward, -1 = upward
-            int crosscount = 0;
-
-            if (edg.straight())
-            {
-                // ignore horizontal lines
-                // TODO: better check for small difference?
-                if (edg.ap.y == pen_y)  
-                {
-                    continue;
-                }
-                // does this line cross the Y coordinate?
-                if ( ((pen_y <= y) && (edg.ap.y >= y))
-                    || ((pen_y >= y) && (edg.ap.y <= y)) )
-                {
-
-                    // calculate X crossing
-                    cross1 = pen_x + (edg.ap.x - pen_x) *
-                        (y - pen_y) / (edg.ap.y - pen_y);
-
-                    if (pen_y > edg.ap.y)
-                        dir1 = -1;  // upward
-                    else
-                        dir1 = +1;  // downward
-
-                    crosscount = 1;
-                }
-                else
-                {
-                    // no crossing found
-                    crosscount = 0;
-                }
-            }
-            else {
-                // ==> curve case
-                crosscount = 
-                    curve_x_crossings<float>(pen_x, pen_y, edg.ap.x, edg.ap.y,
-                        edg.cp.x, edg.cp.y, y, cross1, cross2);
-                dir1 = pen_y > y ? -1 : +1;
-                dir2 = dir1 * (-1); // second crossing always in opposite dir.
-            } // curve
-
-            // ==> we have now:
-            //  - one (cross1) or two (cross1, cross2) ray crossings (X
-            //    coordinate)
-            //  - dir1/dir2 tells the direction of the crossing
-            //    (+1 = downward, -1 = upward)
-            //  - crosscount tells the number of crossings
-
-            // need at least one crossing
-            if (crosscount == 0)
-            {
-                continue;
-            }
+            countCrossings(pth, pen_x, pen_y, edg, x, y, counter);
+        }// for edge
+    } // for path
 
-            // check first crossing
-            if (cross1 <= x)
-            {
-                if (pth.m_fill0 > 0) counter += dir1;
-                if (pth.m_fill1 > 0) counter -= dir1;
-            }
+    return ( (even_odd && (counter % 2) != 0) ||
+             (!even_odd && (counter != 0)) );
+}
 
-            // check optional second crossing (only possible with curves)
-            if ( (crosscount > 1) && (cross2 <= x) )
-            {
-                if (pth.m_fill0 > 0) counter += dir2;
-                if (pth.m_fill1 > 0) counter -= dir2;
-            }
+bool
+pointTest(const std::vector<Path>& paths,
+        const std::vector<LineStyle>& lineStyles, std::int32_t x,
+        std::int32_t y, const SWFMatrix& wm, const EdgeBands& bands)
+{
+    // This is the same test as above, with the edges that can't cross
+    // the ray left out. Every edge adds to the counter on its own, so
+    // the order they are looked at doesn't matter.
+    point pt(x, y);
 
-        }// for edge
-    } // for path
+    bool even_odd = true;  
+
+    for (size_t pno = 0; pno < paths.size(); ++pno) {
+        const Path& pth = paths[pno];
+        if (pth.empty()) continue;
+        if (strokeTest(pth, lineStyles, pt, wm, &bands.pathBounds(pno))) {
+            return true;
+        }
+    }
+
+    int counter = 0;
+
+    const std::vector<EdgeBands::EdgeRef>& edges = bands.edges(y);
+    for (const EdgeBands::EdgeRef& ref : edges) {
+        const Path& pth = paths[ref.first];
+        const point& pen = ref.second ? pth.m_edges[ref.second - 1].ap : pth.ap;
+        countCrossings(pth, pen.x, pen.y, pth.m_edges[ref.second], x, y,
+                counter);
+    }
 
     return ( (even_odd && (counter % 2) != 0) ||
              (!even_odd && (counter != 0)) );
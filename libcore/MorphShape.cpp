@@ -31,8 +31,7 @@ MorphShape::MorphShape(movie_root& mr, as_object* object,
         const SWF::DefineMorphShapeTag* def, DisplayObject* parent)
     :
     DisplayObject(mr, object, parent),
-    _def(def),
-    _shape(_def->shape1())
+    _def(def)
 {
 }
 
@@ -53,9 +52,10 @@ MorphShape::pointInShape(std::int32_t x, std::int32_t y) const
     //       in DrawingApiTest (kind of a fill-leakage making
     //       the collision detection find you inside a self-crossing
     //       shape).
-    if (!_shape.getBounds().point_test(lp.x, lp.y)) return false;
+    const SWF::ShapeRecord& sh = shape();
+    if (!sh.getBounds().point_test(lp.x, lp.y)) return false;
 
-    return _shape.pointTest(lp.x, lp.y, wm);
+    return sh.pointTest(lp.x, lp.y, wm);
 }
 
 void  
@@ -65,21 +65,15 @@ MorphShape::display(Renderer& renderer, const Transform& base)
 
     const Transform xform = base * transform();
 
-    _def->display(renderer, _shape, xform); 
+    _def->display(renderer, *_morphed, xform);
     clear_invalidated();
 }
 
-inline double
-MorphShape::currentRatio() const
-{
-    return get_ratio() / 65535.0;
-}
-
 SWFRect
 MorphShape::getBounds() const
 {
     // TODO: optimize this more.
-    SWFRect bounds = _shape.getBounds();
+    SWFRect bounds = shape().getBounds();
     bounds.expand_to_rect(_def->shape2().getBounds());
     return bounds;
 }
@@ -87,7 +81,7 @@ MorphShape::getBounds() const
 void
 MorphShape::morph()
 {
-    _shape.setLerp(_def->shape1(), _def->shape2(), currentRatio());
+    _morphed = _def->shape(get_ratio());
 }
 
 
@@ -60,18 +60,18 @@ public:
     virtual bool pointInShape(std::int32_t  x, std::int32_t  y) const;
  
     const SWF::ShapeRecord& shape() const {
-        return _shape;
+        return _morphed ? _morphed->shape() : _def->shape1();
     }
 
 private:
     
     void morph();
 
-    double currentRatio() const;
-
     const boost::intrusive_ptr<const SWF::DefineMorphShapeTag> _def;
 	
-    SWF::ShapeRecord _shape;
+    /// The shape at the current ratio, null until it's first displayed,
+    /// when the shape is shape1.
+    boost::intrusive_ptr<const SWF::MorphedShape> _morphed;
 
 };
 
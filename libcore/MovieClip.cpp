@@ -175,8 +175,12 @@ public:
             return;
         }
 
+        // Nothing outside the hit bounds can be hit, so the shapes
+        // don't need looking at.
+        const bool inBounds = ch->hitBounds().point_test(_wp.x, _wp.y);
+
         if (ch->isMaskLayer()) {
-            if (!ch->pointInShape(_wp.x, _wp.y)) {
+            if (!inBounds || !ch->pointInShape(_wp.x, _wp.y)) {
 #ifdef DEBUG_MOUSE_ENTITY_FINDING
                 log_debug("Character %s at depth %d is a mask not hitting "
                         "the query point %g,%g and masking up to "
@@ -194,7 +198,7 @@ public:
             }
             return;
         }
-        if (!ch->visible()) return;
+        if (!ch->visible() || !inBounds) return;
 
         _candidates.push_back(ch);
     }
@@ -299,6 +303,8 @@ public:
 
     bool operator()(const DisplayObject* ch) {
 
+        if (!ch->hitBounds().point_test(_x, _y)) return true;
+
         if (ch->pointInVisibleShape(_x, _y)) {
             _found = true;
             return false;
@@ -369,6 +375,21 @@ private:
     SWFRect& _bounds;
 };
 
+/// Expand a rectangle to the hit bounds of all DisplayObjects, even
+/// unloaded ones.
+class HitBoundsFinder
+{
+public:
+    explicit HitBoundsFinder(SWFRect& b) : _bounds(b) {}
+
+    void operator()(const DisplayObject* ch) {
+        _bounds.expand_to_rect(ch->hitBounds());
+    }
+
+private:
+    SWFRect& _bounds;
+};
+
 struct ReachableMarker
 {
     void operator()(DisplayObject *ch) const {
@@ -1014,7 +1035,22 @@ MovieClip::restoreDisplayList(size_t tgtFrame)
     assert(tgtFrame <= _currentFrame);
 
     DisplayList tmplist;
-    for (size_t f = 0; f < tgtFrame; ++f) {
+    size_t f = 0;
+
+    // Start from the nearest checkpoint, which places what the frames
+    // before it left.
+    if (_def && !isDestroyed()) {
+        const TimelineCheckpoints::Tags* tags;
+        f = _def->timelineCheckpoints().find(*_def, tgtFrame, tags);
+        if (f) {
+            _currentFrame = f - 1;
+            for (const SWF::ControlTag* tag : *tags) {
+                tag->executeState(this, tmplist);
+            }
+        }
+    }
+
+    for (; f < tgtFrame; ++f) {
         _currentFrame = f;
         executeFrameTags(f, tmplist, SWF::ControlTag::TAG_DLIST);
     }
@@ -1195,7 +1231,12 @@ void
 MovieClip::draw(Renderer& renderer, const Transform& xform)
 {
     const DisplayObject::MaskRenderer mr(renderer, *this);
+    drawContents(renderer, xform);
+}
 
+void
+MovieClip::drawContents(Renderer& renderer, const Transform& xform)
+{
     _drawable.finalize();
     _drawable.display(renderer, xform);
     _displayList.display(renderer, xform);
@@ -1212,7 +1253,12 @@ MovieClip::display(Renderer& renderer, const Transform& base)
     
     // Draw everything with our own transform.
     const Transform xform = base * transform();
-    draw(renderer, xform);
+
+    // The children aren't displayed when the bitmap is, but they have
+    // been drawn as far as invalidation is concerned.
+    if (displayCached(renderer, xform)) _displayList.omit_display();
+    else draw(renderer, xform);
+
     clear_invalidated();
 }
 
@@ -1269,6 +1315,10 @@ MovieClip::add_display_object(const SWF::PlaceObject2Tag* tag,
         ch->setBlendMode(static_cast<DisplayObject::BlendMode>(bm));
     }
 
+    if (tag->hasBitmapCaching()) ch->setCacheAsBitmap(true);
+
+    if (tag->hasFilters()) ch->setFilters(tag->getFilters());
+
     // Attach event handlers (if any).
     const SWF::PlaceObject2Tag::EventHandlers& event_handlers =
         tag->getEventHandlers();
@@ -1299,6 +1349,13 @@ MovieClip::move_display_object(const SWF::PlaceObject2Tag* tag, DisplayList& dli
         tag->hasCxform() ? &tag->getCxform() : nullptr,
         tag->hasMatrix() ? &tag->getMatrix() : nullptr,
         tag->hasRatio() ? &ratio : nullptr);
+
+    if (tag->hasFilters()) {
+        DisplayObject* ch = dlist.getDisplayObjectAtDepth(tag->getDepth());
+        if (ch && ch->get_accept_anim_moves()) {
+            ch->setFilters(tag->getFilters());
+        }
+    }
 }
 
 void
@@ -1357,6 +1414,9 @@ MovieClip::replace_display_object(const SWF::PlaceObject2Tag* tag,
     if (tag->hasMatrix()) {
         ch->setMatrix(tag->getMatrix(), true); 
     }
+    if (tag->hasFilters()) {
+        ch->setFilters(tag->getFilters());
+    }
 
     // use SWFMatrix from the old DisplayObject if tag doesn't provide one.
     dlist.replaceDisplayObject(ch, tag->getDepth(), 
@@ -1662,6 +1722,9 @@ MovieClip::add_invalidated_bounds(InvalidatedRanges& ranges, bool force)
             _drawable.getBounds());
 
     ranges.add(bounds.getRange());
+
+    // The filters are drawn again when anything inside changes.
+    addFilterBounds(ranges);
 }
 
 
@@ -1984,6 +2047,17 @@ MovieClip::getBounds() const
     return bounds;
 }
 
+SWFRect
+MovieClip::computeHitBounds() const
+{
+    SWFRect bounds = _drawable.getBounds();
+    if (!bounds.is_null()) getWorldMatrix(*this).transform(bounds);
+
+    HitBoundsFinder f(bounds);
+    _displayList.visitAll(f);
+    return bounds;
+}
+
 bool
 MovieClip::isEnabled() const
 {
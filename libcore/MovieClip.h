@@ -277,6 +277,9 @@ public:
     /// transform.
     void draw(Renderer& renderer, const Transform& xform);
 
+    /// Draw the drawing API shapes and the DisplayList, without the mask.
+    virtual void drawContents(Renderer& renderer, const Transform& xform);
+
     void omit_display();
 
     /// Swap depth of the given DisplayObjects in the DisplayList
@@ -465,6 +468,11 @@ public:
     /// @return         The object if found, otherwise 0.
     DisplayObject* getDisplayListObject(const ObjectURI& uri);
 
+    /// Called when a DisplayObject of this MovieClip is renamed.
+    void childRenamed() {
+        _displayList.nameChanged();
+    }
+
     /// Overridden to look in DisplayList for a match
     as_object* pathElement(const ObjectURI& uri);
 
@@ -563,6 +571,7 @@ public:
     /// Direct access to the Graphics object for drawing.
     DynamicShape& graphics() {
         set_invalidated();
+        invalidateCache();
         return _drawable;
     }
 
@@ -629,6 +638,9 @@ protected:
     /// - Relative root of this instance (_swf)
     ///
     virtual void markOwnResources() const;
+
+    /// The world bounds of the drawable and the hit bounds of all children.
+    virtual SWFRect computeHitBounds() const;
     
     // Used by BitmapMovie.
     void placeDisplayObject(DisplayObject* ch, int depth) {       
@@ -691,7 +703,8 @@ private:
     /// - Execute all displaylist tags from first to one-before target frame,
     ///   appropriately setting _currentFrame as it goes, finally execute
     ///   both displaylist and action
-    ///   tags for target frame.
+    ///   tags for target frame. The tags before the nearest
+    ///   TimelineCheckpoints checkpoint are replaced by the checkpoint's.
     ///
     /// Callers of this methods are:
     /// - goto_frame (for jump-backs)
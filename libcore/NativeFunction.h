@@ -20,6 +20,7 @@
 #define GNASH_NATIVE_FUNCTION_H
 
 #include "as_function.h" // for inheritance
+#include "fn_call.h"
 
 #include <cassert>
 
@@ -62,6 +63,7 @@ public:
 	virtual as_value call(const fn_call& fn)
 	{
 		assert(_func);
+		ProfileGuard profile(getVM(fn).profiler(), _func);
 		return _func(fn);
 	}
 
@@ -70,6 +70,25 @@ iterator_find(const PropertyList::container& p, const ObjectURI& uri, VM& vm)
             p.get<PropertyList::NoCase>().find(uri));
 }
 
+/// The array index a property name is the decimal form of, or -1 if it
+/// isn't one.
+//
+/// Only the names that VM::getIndexKey() makes count, so "01" or "1.0"
+/// aren't indices.
+inline int
+elementIndex(const std::string& name)
+{
+    if (name.empty() || name.size() > 9) return -1;
+    if (name[0] == '0' && name.size() > 1) return -1;
+
+    int i = 0;
+    for (const char c : name) {
+        if (c < '0' || c > '9') return -1;
+        i = i * 10 + (c - '0');
+    }
+    return i;
+}
+
 }
     
 PropertyList::PropertyList(as_object& obj)
@@ -86,6 +105,7 @@ PropertyList::PropertyList(as_object& obj)
                 )
             )
         ),
+    _indexElements(false),
     _owner(obj)
 {
 }
@@ -100,7 +120,7 @@ PropertyList::setValue(const ObjectURI& uri, const as_value& val,
 		// create a new member
 		Property a(uri, val, flagsIfMissing);
 		// Non slot properties are negative ordering in insertion order
-		_props.push_back(a);
+		insert(a);
 #ifdef GNASH_DEBUG_PROPERTY
         ObjectURI::Logger l(getStringTable(_owner));
         log_debug("Simple AS property %s inserted with flags %s",
@@ -164,7 +184,7 @@ PropertyList::delProperty(const ObjectURI& uri)
 		return std::make_pair(true, false);
 	}
 
-	_props.erase(found);
+	erase(found);
 	return std::make_pair(true, true);
 }
 
@@ -217,7 +237,7 @@ PropertyList::addGetterSetter(const ObjectURI& uri, as_function& getter,
 	}
 	else {
 		a.setCache(cacheVal);
-		_props.push_back(a);
+		insert(a);
 #ifdef GNASH_DEBUG_PROPERTY
         ObjectURI::Logger l(getStringTable(_owner));
         log_debug("AS GetterSetter %s inserted with flags %s", l(uri),
@@ -250,7 +270,7 @@ PropertyList::addGetterSetter(const ObjectURI& uri, as_c_function_ptr getter,
 	}
 	else
 	{
-		_props.push_back(a);
+		insert(a);
 #ifdef GNASH_DEBUG_PROPERTY
 		string_table& st = getStringTable(_owner);
 		log_debug("Native GetterSetter %s in namespace %s inserted with "
@@ -277,7 +297,7 @@ PropertyList::addDestructiveGetter(const ObjectURI& uri, as_function& getter,
 	// destructive getter doesn't need a setter
 	Property a(uri, &getter, nullptr, flagsIfMissing, true);
 
-	_props.push_back(a);
+	insert(a);
 
 #ifdef GNASH_DEBUG_PROPERTY
     ObjectURI::Logger l(getStringTable(_owner));
@@ -297,7 +317,7 @@ PropertyList::addDestructiveGetter(const ObjectURI& uri,
 
 	// destructive getter doesn't need a setter
 	Property a(uri, getter, nullptr, flagsIfMissing, true);
-	_props.push_back(a);
+	insert(a);
 
 #ifdef GNASH_DEBUG_PROPERTY
     ObjectURI::Logger l(getStringTable(_owner));
@@ -311,6 +331,59 @@ void
 PropertyList::clear()
 {
 	_props.clear();
+    _elements.clear();
+}
+
+void
+PropertyList::indexElements(bool index)
+{
+    _indexElements = index;
+    _elements.clear();
+    if (!index) return;
+
+    for (const auto& prop : _props) {
+        indexElement(const_cast<Property&>(prop));
+    }
+}
+
+void
+PropertyList::insert(const Property& p)
+{
+    const std::pair<iterator, bool> r = _props.push_back(p);
+    if (r.second && _indexElements) {
+        indexElement(const_cast<Property&>(*r.first));
+    }
+}
+
+void
+PropertyList::erase(iterator it)
+{
+    if (_indexElements) {
+        const int i = elementIndex(
+                getStringTable(_owner).value(getName(it->uri())));
+        if (i >= 0 && getElement(i) == &*it) {
+            _elements[i] = nullptr;
+            while (!_elements.empty() && !_elements.back()) {
+                _elements.pop_back();
+            }
+        }
+    }
+    _props.erase(it);
+}
+
+void
+PropertyList::indexElement(Property& p)
+{
+    const int i = elementIndex(getStringTable(_owner).value(getName(p.uri())));
+    if (i < 0) return;
+
+    // An element far beyond the others would leave the index mostly
+    // empty. It is found by name instead.
+    const size_t n = i;
+    if (n >= 2 * _props.size() + 16) return;
+
+    if (n >= _elements.size()) _elements.resize(n + 1);
+    _elements[n] = &p;
 }
 
 } // namespace gnash
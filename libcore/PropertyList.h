@@ -21,6 +21,7 @@
 
 #include <set> 
 #include <string> // for use within map 
+#include <vector>
 #include <cassert> // for inlines
 #include <utility> // for std::pair
 #include <cstdint>
@@ -277,6 +278,28 @@ public:
     /// Remove all entries in the container
     void clear();
 
+    /// Keep the properties named by array indices in an index of their own.
+    //
+    /// Arrays are mostly read and written by index, and the index finds
+    /// an element without looking its name up. The properties themselves
+    /// stay in the list, so enumeration, flags and getter-setters work
+    /// as for any other property.
+    //
+    /// @param index    Whether to keep the index. When it is turned on,
+    ///                 the properties already in the list are indexed.
+    void indexElements(bool index);
+
+    /// Get the property named by an array index from the element index.
+    //
+    /// Very sparse elements are not indexed, so a property that isn't
+    /// found here must still be looked up by name.
+    //
+    /// @param i    The array index.
+    /// @return     The property named i, or 0 if it isn't in the index.
+    Property* getElement(size_t i) const {
+        return i < _elements.size() ? _elements[i] : nullptr;
+    }
+
     /// Return number of properties in this list
     size_t size() const {
         return _props.size();
@@ -299,8 +322,25 @@ public:
 
 private:
 
+    /// Add a property, indexing it if it is an element.
+    void insert(const Property& p);
+
+    /// Remove a property, and drop it from the element index.
+    void erase(iterator it);
+
+    /// Add a property to the element index, if it is named by an index
+    /// that isn't too far beyond the others.
+    void indexElement(Property& p);
+
     container _props;
 
+    /// The properties named by array indices, by index, or 0 for the
+    /// indices that have none or aren't indexed.
+    std::vector<Property*> _elements;
+
+    /// Whether _elements is kept.
+    bool _indexElements;
+
     as_object& _owner;
 
 };
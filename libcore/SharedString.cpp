@@ -0,0 +1,135 @@
+// SharedString.cpp: immutable strings sharing their characters
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "SharedString.h"
+
+#include <ostream>
+
+#include "utf8.h"
+
+namespace gnash {
+
+struct SharedString::Buffer
+{
+    explicit Buffer(std::string s)
+        :
+        chars(std::move(s)),
+        wideSize(0),
+        wideVersion(0)
+    {}
+
+    std::string chars;
+
+    /// The last decoded characters, of the first wideSize chars.
+    std::shared_ptr<const std::wstring> wide;
+    size_t wideSize;
+    int wideVersion;
+};
+
+SharedString::SharedString(std::string str)
+    :
+    _size(str.size())
+{
+    if (_size) _buf = std::make_shared<Buffer>(std::move(str));
+}
+
+SharedString::SharedString(const char* str)
+    :
+    SharedString(std::string(str))
+{
+}
+
+std::string
+SharedString::str() const
+{
+    if (!_size) return std::string();
+    return _buf->chars.substr(0, _size);
+}
+
+SharedString::const_iterator
+SharedString::begin() const
+{
+    static const std::string empty;
+    return _size ? _buf->chars.begin() : empty.begin();
+}
+
+SharedString::const_iterator
+SharedString::end() const
+{
+    return begin() + _size;
+}
+
+void
+SharedString::append(const std::string& str)
+{
+    if (str.empty()) return;
+
+    if (!_size) {
+        *this = SharedString(str);
+        return;
+    }
+
+    if (_size == _buf->chars.size()) {
+        _buf->chars += str;
+    }
+    else {
+        std::string chars;
+        chars.reserve(_size + str.size());
+        chars.append(_buf->chars, 0, _size);
+        chars += str;
+        _buf = std::make_shared<Buffer>(std::move(chars));
+    }
+    _size += str.size();
+}
+
+std::shared_ptr<const std::wstring>
+SharedString::wide(int version) const
+{
+    if (!_size) return std::make_shared<const std::wstring>();
+
+    Buffer& buf = *_buf;
+    if (!buf.wide || buf.wideSize != _size || buf.wideVersion != version) {
+        buf.wide = std::make_shared<const std::wstring>(
+                utf8::decodeCanonicalString(str(), version));
+        buf.wideSize = _size;
+        buf.wideVersion = version;
+    }
+    return buf.wide;
+}
+
+bool
+operator==(const SharedString& a, const SharedString& b)
+{
+    if (a._size != b._size) return false;
+    if (!a._size || a._buf == b._buf) return true;
+    return !a._buf->chars.compare(0, a._size, b._buf->chars, 0, b._size);
+}
+
+std::ostream&
+operator<<(std::ostream& o, const SharedString& s)
+{
+    return o << s.str();
+}
+
+} // namespace gnash
+
+// Local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
@@ -0,0 +1,119 @@
+// SharedString.h: immutable strings sharing their characters
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#ifndef GNASH_SHAREDSTRING_H
+#define GNASH_SHAREDSTRING_H
+
+#include <string>
+#include <memory>
+#include <iosfwd>
+
+#include "dsodefs.h"
+
+namespace gnash {
+
+/// A string whose characters are shared by all its copies.
+//
+/// This is how as_value stores ActionScript Strings, so that copying a
+/// value doesn't copy its characters.
+///
+/// A SharedString is the first size() characters of a buffer. Appending
+/// to a string that is the whole of its buffer adds to the buffer, which
+/// leaves the characters of the other strings of that buffer as they
+/// were, since they are no longer than it. The buffer can move while it
+/// grows, though, so where they are kept changes. So a script that builds a string by concatenating
+/// to it in a loop only copies each part once. Appending to any other
+/// string copies it first.
+///
+/// The characters decoded by utf8::decodeCanonicalString() are kept for
+/// the String methods that work with them.
+class DSOEXPORT SharedString
+{
+public:
+
+    /// Construct an empty string.
+    SharedString()
+        :
+        _size(0)
+    {}
+
+    SharedString(std::string str);
+
+    SharedString(const char* str);
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return !_size;
+    }
+
+    /// A copy of the characters.
+    std::string str() const;
+
+    typedef std::string::const_iterator const_iterator;
+
+    /// The characters, where they are kept.
+    //
+    /// They are invalidated by appending to this string or to any other
+    /// that shares its buffer, such as a copy in another as_value, and by
+    /// destroying this string. So they mustn't be kept across anything
+    /// that can run ActionScript.
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /// Append a string.
+    void append(const std::string& str);
+
+    /// The characters as utf8::decodeCanonicalString() decodes them.
+    //
+    /// They are kept until the characters are decoded for another version
+    /// or length, which leaves those returned before as they were.
+    std::shared_ptr<const std::wstring> wide(int version) const;
+
+    friend DSOEXPORT bool operator==(const SharedString& a,
+            const SharedString& b);
+
+private:
+
+    struct Buffer;
+
+    std::shared_ptr<Buffer> _buf;
+
+    size_t _size;
+};
+
+inline bool
+operator!=(const SharedString& a, const SharedString& b)
+{
+    return !(a == b);
+}
+
+DSOEXPORT std::ostream& operator<<(std::ostream& o, const SharedString& s);
+
+} // namespace gnash
+
+#endif
+
+// Local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
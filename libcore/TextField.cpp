@@ -37,6 +37,7 @@
 #include <utility>
 #include <map>
 #include <functional>
+#include <tuple>
 
 #include "utf8.h"
 #include "log.h"
@@ -73,6 +74,105 @@
 
 namespace gnash {
 
+struct TextField::LayoutFormat
+{
+    explicit LayoutFormat(const TextField& tf)
+        :
+        font(tf._font.get()),
+        embedFonts(tf._embedFonts),
+        password(tf._password),
+        wordWrap(tf._wordWrap),
+        autoSize(tf._autoSize),
+        alignment(tf._alignment),
+        fontHeight(tf._fontHeight),
+        color(tf._textColor),
+        underlined(tf._underlined),
+        bullet(tf._bullet),
+        leftMargin(tf._leftMargin),
+        rightMargin(tf._rightMargin),
+        indent(tf._indent),
+        blockIndent(tf._blockIndent),
+        tabStops(tf._tabStops),
+        url(tf._url),
+        target(tf._target),
+        width(tf._bounds.width()),
+        height(tf._bounds.height())
+    {}
+
+    bool operator==(const LayoutFormat& o) const {
+        return std::tie(font, embedFonts, password, wordWrap, autoSize,
+                alignment, fontHeight, color, underlined, bullet,
+                leftMargin, rightMargin, indent, blockIndent, tabStops,
+                url, target, width, height) ==
+            std::tie(o.font, o.embedFonts, o.password, o.wordWrap,
+                o.autoSize, o.alignment, o.fontHeight, o.color,
+                o.underlined, o.bullet, o.leftMargin, o.rightMargin,
+                o.indent, o.blockIndent, o.tabStops, o.url, o.target,
+                o.width, o.height);
+    }
+
+    const Font* font;
+    bool embedFonts;
+    bool password;
+    bool wordWrap;
+    AutoSize autoSize;
+    TextAlignment alignment;
+    std::uint16_t fontHeight;
+    rgba color;
+    bool underlined;
+    bool bullet;
+    std::uint16_t leftMargin;
+    std::uint16_t rightMargin;
+    std::uint16_t indent;
+    std::uint16_t blockIndent;
+    std::vector<int> tabStops;
+    std::string url;
+    std::string target;
+    std::int32_t width;
+    std::int32_t height;
+};
+
+struct TextField::LayoutEnd
+{
+    LayoutEnd(const TextField& tf, const SWF::TextRecord& last)
+        :
+        textLength(tf._text.size()),
+        rec(last)
+    {}
+
+    /// The length of the text laid out.
+    const size_t textLength;
+
+    /// The arguments handleChar() goes on with. The last record is
+    /// as it was before it was aligned.
+    SWF::TextRecord rec;
+    std::int32_t x;
+    std::int32_t y;
+    int lastCode;
+    int lastSpaceGlyph;
+    LineStarts::value_type lastLineStartRecord;
+};
+
+struct TextField::ParagraphStart
+{
+    /// Where the paragraph starts in the text.
+    size_t text;
+
+    /// The sizes of _textRecords, _recordStarts and _line_starts.
+    size_t records;
+    size_t recordStarts;
+    size_t lineStarts;
+
+    size_t glyphCount;
+    size_t maxScroll;
+
+    /// The arguments handleChar() goes on with.
+    SWF::TextRecord rec;
+    std::int32_t x;
+    std::int32_t y;
+    int lastCode;
+};
+
 TextField::TextField(as_object* object, DisplayObject* parent,
         const SWF::DefineEditTextTag& def)
     :
@@ -275,11 +375,10 @@ TextField::cursorRecord()
 {
     if (_textRecords.empty()) return 0;
 
-    size_t i = 0;
+    const size_t records = std::min(_textRecords.size(), _recordStarts.size());
+    const size_t i = std::upper_bound(_recordStarts.begin(),
+            _recordStarts.begin() + records, m_cursor) - _recordStarts.begin();
 
-    while (i < _textRecords.size() && m_cursor >= _recordStarts[i]) {
-        ++i;
-    }
     // TODO: it seems like this could return (size_t) -1, but there's no
     // evidence this is allowed or handled.
     return i - 1;
@@ -349,16 +448,28 @@ TextField::display(Renderer& renderer, const Transform& base)
 
     //offset the lines
     int yoffset = (getFontHeight() + fontLeading) + PADDING_TWIPS;
-    size_t recordline;
-    for (size_t i = 0; i < _textRecords.size(); ++i) {
-        recordline = 0;
-        //find the line the record is on
-        while (recordline < _line_starts.size() && 
-                _line_starts[recordline] <= _recordStarts[i]) {
-            ++recordline;
-        }
-        //offset the line
+    const size_t records = std::min(_textRecords.size(), _recordStarts.size());
+
+    // Only the records of the lines from _scroll down to the bottom of the
+    // bounds can be shown, so don't look at the others.
+    const size_t endLine = _scroll + _bounds.height() / yoffset + 1;
+    const size_t first = _scroll < _line_starts.size() ?
+        std::lower_bound(_recordStarts.begin(), _recordStarts.begin() + records,
+                _line_starts[_scroll]) - _recordStarts.begin() : records;
+    const size_t last = endLine < _line_starts.size() ?
+        std::lower_bound(_recordStarts.begin() + first,
+                _recordStarts.begin() + records,
+                _line_starts[endLine]) - _recordStarts.begin() : records;
+
+    // Offset a record to the line it is on.
+    auto placeRecord = [&](size_t i) {
+        const size_t recordline = std::upper_bound(_line_starts.begin(),
+                _line_starts.end(), _recordStarts[i]) - _line_starts.begin();
         _textRecords[i].setYOffset((recordline-_scroll)*yoffset);
+    };
+
+    for (size_t i = first; i < last; ++i) {
+        placeRecord(i);
         //add the lines we want to the display record
         if (_textRecords[i].yOffset() > 0 &&
             _textRecords[i].yOffset() < _bounds.height()) {
@@ -369,7 +480,14 @@ TextField::display(Renderer& renderer, const Transform& base)
     SWF::TextRecord::displayRecords(renderer, xform, _displayRecords,
             _embedFonts);
 
-    if (m_has_focus && !isReadOnly()) show_cursor(renderer, xform.matrix);
+    if (m_has_focus && !isReadOnly()) {
+        // The cursor can be on a line that isn't shown.
+        const size_t cursor = cursorRecord();
+        if (cursor < records && (cursor < first || cursor >= last)) {
+            placeRecord(cursor);
+        }
+        show_cursor(renderer, xform.matrix);
+    }
     
     clear_invalidated();
 }
@@ -496,6 +614,15 @@ TextField::replaceSelection(const std::string& replace)
 
     _text.replace(start, end - start, wstr);
     _selection = std::make_pair(start + replaceLength, start + replaceLength);
+
+    // The text isn't laid out again here, so when it is, it must be from
+    // a paragraph before the replaced part.
+    _layoutEnd.reset();
+    _paragraphStarts.erase(std::upper_bound(_paragraphStarts.begin(),
+                _paragraphStarts.end(), start,
+                [](size_t pos, const ParagraphStart& p) {
+                    return pos < p.text;
+                }), _paragraphStarts.end());
 }
 
 void
@@ -747,7 +874,7 @@ TextField::mouseEvent(const event_id& ev)
 			
 			SWF::TextRecord rec;
 			
-			for (auto& record: _textRecords) {
+			for (auto& record: _displayRecords) {
 				if 	((x_mouse >  record.xOffset()) && 
 					(x_mouse < record.xOffset()+record.recordWidth()) &&
 					(y_mouse > record.yOffset()-record.textHeight()) &&
@@ -802,12 +929,19 @@ TextField::updateText(const std::wstring& wstr)
 
     set_invalidated();
 
+    const size_t laidOut = _text.size();
+    const size_t common = std::min(laidOut, wstr.size());
+    const size_t changed = std::mismatch(_text.begin(),
+            _text.begin() + common, wstr.begin()).first - _text.begin();
+    const bool appended = wstr.size() > laidOut && changed == laidOut;
+
     _text = wstr;
 
     _selection.first = std::min(_selection.first, _text.size());
     _selection.second = std::min(_selection.second, _text.size());
 
-    format_text();
+    if (appended && format_appended_text(laidOut)) return;
+    if (!format_changed_text(changed)) format_text();
 }
 
 void
@@ -817,8 +951,8 @@ TextField::updateHtmlText(const std::wstring& wstr)
 
     set_invalidated();
 
+    // Only _text is laid out, so updateText() formats if needed.
     _htmlText = wstr;
-    format_text();
 }
 
 void
@@ -1010,9 +1144,157 @@ TextField::insertTab(SWF::TextRecord& rec, std::int32_t& x, float scale)
     }
 }
 
+void
+TextField::saveLayoutEnd(size_t from, std::int32_t x, std::int32_t y,
+        const SWF::TextRecord& rec, int last_code, int last_space_glyph,
+        LineStarts::value_type last_line_start_record)
+{
+    _layoutEnd.reset();
+
+    if (!_layoutFormat) return;
+
+    // handleChar() stops at a NUL, and the rest of the text isn't shown.
+    if (_text.find(L'\0', from) != std::wstring::npos) return;
+
+    // A truncated line skips everything up to the next newline, which
+    // handleChar() only does after adding a glyph.
+    if (!doWordWrap() &&
+            x >= _bounds.width() - getRightMargin() - PADDING_TWIPS) {
+        return;
+    }
+
+    assert(last_line_start_record == _textRecords.size());
+
+    _layoutEnd.reset(new LayoutEnd(*this, rec));
+    _layoutEnd->x = x;
+    _layoutEnd->y = y;
+    _layoutEnd->lastCode = last_code;
+    _layoutEnd->lastSpaceGlyph = last_space_glyph;
+    _layoutEnd->lastLineStartRecord = last_line_start_record;
+}
+
+bool
+TextField::format_appended_text(size_t from)
+{
+    if (!_layoutEnd || _layoutEnd->textLength != from ||
+            !(*_layoutFormat == LayoutFormat(*this))) {
+        return false;
+    }
+
+    stage().displayChanged();
+
+    // Lay the last line out again, as it was before it was aligned.
+    assert(_textRecords.size() == _layoutEnd->lastLineStartRecord + 1);
+    _textRecords.pop_back();
+
+    SWF::TextRecord rec = _layoutEnd->rec;
+    std::int32_t x = _layoutEnd->x;
+    std::int32_t y = _layoutEnd->y;
+    int last_code = _layoutEnd->lastCode;
+    int last_space_glyph = _layoutEnd->lastSpaceGlyph;
+    size_t last_line_start_record = _layoutEnd->lastLineStartRecord;
+
+    std::wstring::const_iterator it = _text.begin() + from;
+    const std::wstring::const_iterator e = _text.end();
+
+    handleChar(it, e, x, y, rec, last_code, last_space_glyph,
+            last_line_start_record);
+
+    saveLayoutEnd(from, x, y, rec, last_code, last_space_glyph,
+            last_line_start_record);
+
+    _textRecords.push_back(rec);
+    align_line(getTextAlignment(), last_line_start_record, x);
+
+    scrollLines();
+
+    set_invalidated();
+    return true;
+}
+
+void
+TextField::saveParagraphStart(size_t text, std::int32_t x, std::int32_t y,
+        const SWF::TextRecord& rec, int last_code)
+{
+    ParagraphStart p;
+    p.text = text;
+    p.records = _textRecords.size();
+    p.recordStarts = _recordStarts.size();
+    p.lineStarts = _line_starts.size();
+    p.glyphCount = _glyphcount;
+    p.maxScroll = _maxScroll;
+    p.rec = rec;
+    p.x = x;
+    p.y = y;
+    p.lastCode = last_code;
+    _paragraphStarts.push_back(p);
+}
+
+bool
+TextField::format_changed_text(size_t from)
+{
+    if (!_layoutFormat || !(*_layoutFormat == LayoutFormat(*this))) {
+        return false;
+    }
+
+    // The last paragraph that starts before the change. Its lines, and
+    // those of the paragraphs before it, are laid out as before.
+    std::vector<ParagraphStart>::iterator p =
+        std::upper_bound(_paragraphStarts.begin(), _paragraphStarts.end(),
+                from, [](size_t pos, const ParagraphStart& start) {
+                    return pos < start.text;
+                });
+    if (p == _paragraphStarts.begin()) return false;
+    --p;
+
+    stage().displayChanged();
+
+    const size_t text = p->text;
+    _textRecords.erase(_textRecords.begin() + p->records, _textRecords.end());
+    _recordStarts.erase(_recordStarts.begin() + p->recordStarts,
+            _recordStarts.end());
+    _line_starts.erase(_line_starts.begin() + p->lineStarts,
+            _line_starts.end());
+    _glyphcount = p->glyphCount;
+    _maxScroll = p->maxScroll;
+
+    SWF::TextRecord rec = p->rec;
+    std::int32_t x = p->x;
+    std::int32_t y = p->y;
+    int last_code = p->lastCode;
+    int last_space_glyph = -1;
+    size_t last_line_start_record = _textRecords.size();
+
+    // The paragraphs after this one are found again as they are laid out.
+    _paragraphStarts.erase(p + 1, _paragraphStarts.end());
+
+    std::wstring::const_iterator it = _text.begin() + text;
+    const std::wstring::const_iterator e = _text.end();
+
+    handleChar(it, e, x, y, rec, last_code, last_space_glyph,
+            last_line_start_record);
+
+    saveLayoutEnd(text, x, y, rec, last_code, last_space_glyph,
+            last_line_start_record);
+
+    _textRecords.push_back(rec);
+    align_line(getTextAlignment(), last_line_start_record, x);
+
+    scrollLines();
+
+    set_invalidated();
+    return true;
+}
+
 void
 TextField::format_text()
 {
+    // Autosizing can change the bounds.
+    stage().displayChanged();
+
+    _layoutFormat.reset();
+    _layoutEnd.reset();
+    _paragraphStarts.clear();
     _textRecords.clear();
     _line_starts.clear();
     _recordStarts.clear();
@@ -1112,6 +1394,14 @@ TextField::format_text()
     size_t last_line_start_record = 0;
 
     _line_starts.push_back(0);
+
+    // HTML tags can leave records of a line before the last record, and
+    // change the formatting as they go. Autosizing moves the bounds
+    // around the whole text. Otherwise the layout can be picked up again
+    // where a paragraph starts, or where it stopped.
+    if (!doHtml() && (_autoSize == AUTOSIZE_NONE || doWordWrap())) {
+        _layoutFormat.reset(new LayoutFormat(*this));
+    }
     
     // String iterators are very sensitive to 
     // potential changes to the string (to allow for copy-on-write).
@@ -1147,6 +1437,9 @@ TextField::format_text()
         }
     }
 
+    saveLayoutEnd(0, x, y, rec, last_code, last_space_glyph,
+            last_line_start_record);
+
     // Add the last line to our output.
     _textRecords.push_back(rec);
 	
@@ -1179,9 +1472,8 @@ TextField::scrollLines()
         }
 
         // which line is the cursor on?
-        while (line < manylines && _line_starts[line] <= m_cursor) {
-            ++line;
-        }
+        line = std::upper_bound(_line_starts.begin(), _line_starts.end(),
+                m_cursor) - _line_starts.begin();
 
         if (manylines - _scroll <= _linesindisplay) {
             // This is for if we delete a line
@@ -1201,14 +1493,25 @@ TextField::scrollLines()
     }
 }
 
+void
+TextField::setScroll(size_t scroll)
+{
+    _scroll = scroll;
+
+    // Scrolling doesn't change the layout, so with nothing appended this
+    // only scrolls, unless the text must be laid out again anyway.
+    if (!format_appended_text(_text.size()) &&
+            !format_changed_text(_text.size())) {
+        format_text();
+    }
+}
+
 void
 TextField::newLine(std::int32_t& x, std::int32_t& y,
 				   SWF::TextRecord& rec, int& last_space_glyph,
 				LineStarts::value_type& last_line_start_record, float div)
 {
     // newline.
-    LineStarts::iterator linestartit = _line_starts.begin();
-    LineStarts::const_iterator linestartend = _line_starts.end();
     
     // TODO: work out how leading affects things.
     const float leading = 0;
@@ -1241,16 +1544,11 @@ TextField::newLine(std::int32_t& x, std::int32_t& y,
     last_space_glyph = -1;
     last_line_start_record = _textRecords.size();
                          
-    linestartit = _line_starts.begin();
-    linestartend = _line_starts.end();
     //Fit a line_start in the correct place
     const size_t currentPos = _glyphcount;
 
-    while (linestartit < linestartend && *linestartit < currentPos)
-    {
-        ++linestartit;
-    }
-    _line_starts.insert(linestartit, currentPos);
+    _line_starts.insert(std::lower_bound(_line_starts.begin(),
+                _line_starts.end(), currentPos), currentPos);
 
     // BULLET CASE:
                 
@@ -1294,9 +1592,6 @@ TextField::handleChar(std::wstring::const_iterator& it,
         std::int32_t& y, SWF::TextRecord& rec, int& last_code,
         int& last_space_glyph, LineStarts::value_type& last_line_start_record)
 {
-    LineStarts::iterator linestartit = _line_starts.begin();
-    LineStarts::const_iterator linestartend = _line_starts.end();
-    
     float scale = _fontHeight /
         static_cast<float>(_font->unitsPerEM(_embedFonts)); 
     float fontDescent = _font->descent(_embedFonts) * scale; 
@@ -1357,6 +1652,10 @@ TextField::handleChar(std::wstring::const_iterator& it,
             case 10:
             {
                 newLine(x,y,rec,last_space_glyph,last_line_start_record,1.0);
+                if (_layoutFormat) {
+                    saveParagraphStart(it - _text.begin(), x, y, rec,
+                            last_code);
+                }
                 break;
             }
             case '<':
@@ -1809,8 +2108,6 @@ TextField::handleChar(std::wstring::const_iterator& it,
                 assert(!_textRecords.empty());
                 SWF::TextRecord& last_line = _textRecords.back();
                 
-                linestartit = _line_starts.begin();
-                linestartend = _line_starts.end();
                 if (last_space_glyph == -1)
                 {
                     // Pull the previous glyph down onto the
@@ -1824,12 +2121,9 @@ TextField::handleChar(std::wstring::const_iterator& it,
                         //record the new line start
                         //
                         const size_t currentPos = _glyphcount;
-                        while (linestartit != linestartend &&
-                                *linestartit + 1 <= currentPos)
-                        {
-                            ++linestartit;
-                        }
-                        _line_starts.insert(linestartit, currentPos);
+                        _line_starts.insert(std::lower_bound(
+                                    _line_starts.begin(), _line_starts.end(),
+                                    currentPos), currentPos);
                         _recordStarts.push_back(currentPos);
                     }
                 } else {
@@ -1853,12 +2147,9 @@ TextField::handleChar(std::wstring::const_iterator& it,
                     const size_t linestartpos = _glyphcount -
                             rec.glyphs().size();
 
-                    while (linestartit < linestartend &&
-                            *linestartit < linestartpos)
-                    {
-                        ++linestartit;
-                    }
-                    _line_starts.insert(linestartit, linestartpos);
+                    _line_starts.insert(std::lower_bound(
+                                _line_starts.begin(), _line_starts.end(),
+                                linestartpos), linestartpos);
                     _recordStarts.push_back(linestartpos);
                 }
 
@@ -2511,6 +2802,7 @@ void
 TextField::setWidth(double newwidth)
 {
 	const SWFRect& bounds = getBounds();
+    stage().displayChanged();
     _bounds.set_to_rect(bounds.get_x_min(),
             bounds.get_y_min(),
             bounds.get_x_min() + newwidth,
@@ -2521,6 +2813,7 @@ void
 TextField::setHeight(double newheight)
 {
 	const SWFRect& bounds = getBounds();
+    stage().displayChanged();
     _bounds.set_to_rect(bounds.get_x_min(),
             bounds.get_y_min(),
             bounds.get_x_max(),
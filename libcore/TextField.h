@@ -21,6 +21,7 @@
 
 #include <boost/intrusive_ptr.hpp>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -60,6 +61,8 @@ public:
     
     typedef std::vector<size_t> LineStarts;
 
+    typedef std::vector<SWF::TextRecord> TextRecords;
+
     /// Text alignment values
 	enum TextAlignment
 	{
@@ -557,10 +560,7 @@ public:
 	void setTarget(std::string target);
 	void setRestrict(const std::string& restrict);
 	void setDisplay(TextFormatDisplay display);
-	void setScroll(size_t scroll) {
-		_scroll = scroll;
-		format_text();
-	}
+	void setScroll(size_t scroll);
 	void setMaxScroll(size_t maxScroll) {
 		_maxScroll = maxScroll;
 		format_text();
@@ -588,6 +588,16 @@ public:
 		return m_text_bounding_box;
 	}
 
+	/// The records of glyphs the text is laid out in.
+	const TextRecords& getTextRecords() const {
+		return _textRecords;
+	}
+
+	/// Where each line starts, counted in glyphs.
+	const LineStarts& getLineStarts() const {
+		return _line_starts;
+	}
+
 	/// Set our text to the given string.
 	//
 	/// This function will also update any registered variable
@@ -631,6 +641,28 @@ private:
 	/// Convert the DisplayObjects in _text into a series of
 	/// text_glyph_records to be rendered.
 	void format_text();
+
+	/// Lay out only the text appended to _text since it was last laid out.
+	//
+	/// Log windows and chats add a line at a time to long texts, which
+	/// format_text() would lay out from the start every time.
+	///
+	/// @param from     The length of the text that was laid out.
+	/// @return         false if the layout can't go on from where it
+	///                 stopped, and format_text() must be called.
+	bool format_appended_text(size_t from);
+
+	/// Lay out the text again from the paragraph it changed in.
+	//
+	/// Editing a line, or replacing the text with one that differs only
+	/// near its end, leaves the paragraphs before the change as they
+	/// were.
+	///
+	/// @param from     Where the text first differs from the text that
+	///                 was laid out.
+	/// @return         false if there is no paragraph to go on from, and
+	///                 format_text() must be called.
+	bool format_changed_text(size_t from);
 	
 	/// Move viewable lines based on m_cursor
 	void scrollLines();
@@ -697,6 +729,27 @@ private:
 	///
 	VariableRef parseTextVariableRef(const std::string& variableName) const;
 
+	/// What the layout depends on, apart from the text.
+	struct LayoutFormat;
+
+	/// Where format_text() stopped, so appended text can be laid out from
+	/// there. See format_appended_text().
+	struct LayoutEnd;
+
+	/// The state of the layout at the start of a paragraph, so a change
+	/// after it can be laid out from there. See format_changed_text().
+	struct ParagraphStart;
+
+	/// Remember the layout at the start of a paragraph.
+	void saveParagraphStart(size_t text, std::int32_t x, std::int32_t y,
+            const SWF::TextRecord& rec, int last_code);
+
+	/// Remember where the layout stopped, if appended text can be laid out
+	/// from there.
+	void saveLayoutEnd(size_t from, std::int32_t x, std::int32_t y,
+            const SWF::TextRecord& rec, int last_code, int last_space_glyph,
+            LineStarts::value_type last_line_start_record);
+
 	/// Called in display(), sets the cursor using m_cursor and _textRecords
 	//
 	/// @param renderer
@@ -723,7 +776,6 @@ private:
 	/// bounds of dynamic text, as laid out
 	SWFRect m_text_bounding_box;
 
-	typedef std::vector<SWF::TextRecord> TextRecords;
 	TextRecords _textRecords;
 
 	std::vector<size_t> _recordStarts;
@@ -738,6 +790,18 @@ private:
 	std::vector<int> _tabStops;
 	LineStarts _line_starts;
 
+	/// The formatting the text was laid out with.
+	//
+	/// Null if the text must be laid out from the start, as it is for
+	/// HTML or when autosizing moves the bounds.
+	std::unique_ptr<LayoutFormat> _layoutFormat;
+
+	/// Null if the text must be laid out from the start.
+	std::unique_ptr<LayoutEnd> _layoutEnd;
+
+	/// The paragraphs laid out, in the order of the text.
+	std::vector<ParagraphStart> _paragraphStarts;
+
 	/// The text variable name
 	//
 	/// This is stored here, and not just in the definition,
@@ -0,0 +1,190 @@
+// TimelineCheckpoints.cpp: DisplayList state of a timeline every few frames
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "TimelineCheckpoints.h"
+
+#include <algorithm>
+
+#include "movie_definition.h"
+#include "ControlTag.h"
+#include "PlaceObject2Tag.h"
+#include "RemoveObjectTag.h"
+#include "SetBackgroundColorTag.h"
+#include "ScriptLimitsTag.h"
+
+namespace gnash {
+
+namespace {
+
+const SWF::PlaceObject2Tag*
+moveTag(const SWF::ControlTag* tag)
+{
+    const SWF::PlaceObject2Tag* place =
+        dynamic_cast<const SWF::PlaceObject2Tag*>(tag);
+    if (!place || place->getPlaceType() != SWF::PlaceObject2Tag::MOVE) {
+        return nullptr;
+    }
+    return place;
+}
+
+/// Whether a MOVE tag changes everything an earlier one did.
+bool
+covers(const SWF::PlaceObject2Tag& later, const SWF::PlaceObject2Tag& earlier)
+{
+    return (later.hasMatrix() || !earlier.hasMatrix()) &&
+        (later.hasCxform() || !earlier.hasCxform()) &&
+        (later.hasRatio() || !earlier.hasRatio()) &&
+        (later.hasFilters() || !earlier.hasFilters());
+}
+
+}
+
+TimelineCheckpoints::TimelineCheckpoints(size_t interval, size_t maxTags)
+    :
+    _interval(interval),
+    _maxTags(maxTags),
+    _size(0),
+    _frame(0),
+    _full(false),
+    _background(nullptr),
+    _scriptLimits(nullptr)
+{
+}
+
+size_t
+TimelineCheckpoints::find(const movie_definition& def, size_t frame,
+        const Tags*& tags)
+{
+    while (!_full && _frame < frame) {
+        execute(def);
+        if (_frame % _interval == 0) save();
+    }
+
+    const size_t checkpoint = std::min(frame / _interval, _checkpoints.size());
+    if (!checkpoint) return 0;
+
+    tags = &_checkpoints[checkpoint - 1];
+    return checkpoint * _interval;
+}
+
+void
+TimelineCheckpoints::execute(const movie_definition& def)
+{
+    const movie_definition::PlayList* playlist = def.getPlaylist(_frame++);
+    if (!playlist) return;
+
+    for (const auto& item : *playlist) {
+
+        const SWF::ControlTag* tag = item.get();
+
+        const SWF::PlaceObject2Tag* place =
+            dynamic_cast<const SWF::PlaceObject2Tag*>(tag);
+
+        if (place) {
+            const int depth = place->getDepth();
+            std::map<int, Tags>::iterator it = _depths.find(depth);
+
+            switch (place->getPlaceType()) {
+
+                case SWF::PlaceObject2Tag::PLACE:
+                    // Nothing is placed at a depth that is taken, nor
+                    // unknown characters.
+                    if (it == _depths.end() &&
+                            def.getDefinitionTag(place->getID())) {
+                        _depths[depth].push_back(tag);
+                    }
+                    break;
+
+                case SWF::PlaceObject2Tag::MOVE:
+                {
+                    if (it == _depths.end()) break;
+
+                    // The moves since the DisplayObject was placed or
+                    // replaced each set some of its properties, so those
+                    // whose properties this one all sets again aren't
+                    // needed any more.
+                    Tags& tags = it->second;
+                    Tags::iterator moves = tags.end();
+                    while (moves - 1 != tags.begin() && moveTag(*(moves - 1))) {
+                        --moves;
+                    }
+                    tags.erase(std::remove_if(moves, tags.end(),
+                                [place](const SWF::ControlTag* t) {
+                                    return covers(*place, *moveTag(t));
+                                }), tags.end());
+                    tags.push_back(tag);
+                    break;
+                }
+
+                case SWF::PlaceObject2Tag::REPLACE:
+                    if (it != _depths.end() &&
+                            def.getDefinitionTag(place->getID())) {
+                        it->second.push_back(tag);
+                    }
+                    break;
+
+                case SWF::PlaceObject2Tag::REMOVE:
+                    if (it != _depths.end()) _depths.erase(it);
+                    break;
+            }
+            continue;
+        }
+
+        const SWF::RemoveObjectTag* remove =
+            dynamic_cast<const SWF::RemoveObjectTag*>(tag);
+
+        if (remove) {
+            _depths.erase(remove->getDepth());
+        }
+        else if (dynamic_cast<const SWF::SetBackgroundColorTag*>(tag)) {
+            _background = tag;
+        }
+        else if (dynamic_cast<const SWF::ScriptLimitsTag*>(tag)) {
+            _scriptLimits = tag;
+        }
+    }
+}
+
+void
+TimelineCheckpoints::save()
+{
+    Tags tags;
+    if (_background) tags.push_back(_background);
+    if (_scriptLimits) tags.push_back(_scriptLimits);
+    for (const auto& depth : _depths) {
+        tags.insert(tags.end(), depth.second.begin(), depth.second.end());
+    }
+
+    if (_size + tags.size() > _maxTags) {
+        _full = true;
+        _depths.clear();
+        return;
+    }
+
+    _size += tags.size();
+    _checkpoints.push_back(Tags());
+    _checkpoints.back().swap(tags);
+}
+
+} // namespace gnash
+
+// Local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
@@ -0,0 +1,120 @@
+// TimelineCheckpoints.h: DisplayList state of a timeline every few frames
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#ifndef GNASH_TIMELINECHECKPOINTS_H
+#define GNASH_TIMELINECHECKPOINTS_H
+
+#include <map>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+#include "dsodefs.h"
+
+namespace gnash {
+    class movie_definition;
+    namespace SWF {
+        class ControlTag;
+    }
+}
+
+namespace gnash {
+
+/// The DisplayList state of a timeline every few frames.
+//
+/// Going back to an earlier frame rebuilds the DisplayList by executing
+/// the DisplayList tags of the frames before it. A checkpoint holds the
+/// tags that make the same DisplayList as all the frames before it did,
+/// which are only those of the DisplayObjects still there, so that the
+/// rest of the frames are executed from the nearest checkpoint instead of
+/// the first frame.
+///
+/// The checkpoints of a definition are shared by all its MovieClips. They
+/// are made from the tags alone, the first time a frame is restored.
+class DSOEXPORT TimelineCheckpoints : boost::noncopyable
+{
+public:
+
+    typedef std::vector<const SWF::ControlTag*> Tags;
+
+    /// @param interval     The number of frames between checkpoints.
+    /// @param maxTags      The most tags all checkpoints together may
+    ///                     hold. No more checkpoints are made after that.
+    TimelineCheckpoints(size_t interval = 32, size_t maxTags = 1 << 18);
+
+    /// Find the last checkpoint at or before a frame.
+    //
+    /// Checkpoints up to the frame are made first if they weren't yet.
+    ///
+    /// @param def      The definition whose timeline this is. Its frames
+    ///                 before `frame' must have been loaded.
+    /// @param frame    The 0-based frame to restore.
+    /// @param tags     Set to the tags to execute for the checkpoint.
+    /// @return         The frame whose tags are to be executed after
+    ///                 those of the checkpoint, or 0 if there is no
+    ///                 checkpoint before the frame.
+    size_t find(const movie_definition& def, size_t frame, const Tags*& tags);
+
+    /// The number of tags held by all checkpoints.
+    size_t size() const {
+        return _size;
+    }
+
+private:
+
+    /// Add the tags of the next frame to the current state.
+    void execute(const movie_definition& def);
+
+    /// Save the current state as the checkpoint of the next frame.
+    void save();
+
+    const size_t _interval;
+
+    const size_t _maxTags;
+
+    /// The checkpoints of the frames _interval, 2 * _interval ...
+    std::vector<Tags> _checkpoints;
+
+    size_t _size;
+
+    /// The next frame whose tags are added to the current state.
+    size_t _frame;
+
+    /// Whether no more checkpoints are made.
+    bool _full;
+
+    /// The current state: the tags that made each depth what it is.
+    std::map<int, Tags> _depths;
+
+    /// The last SetBackgroundColor and ScriptLimits tags.
+    //
+    /// The other tags that aren't DisplayList tags only need to be
+    /// executed once, which they were when the frames were first played.
+    const SWF::ControlTag* _background;
+    const SWF::ControlTag* _scriptLimits;
+};
+
+} // namespace gnash
+
+#endif
+
+// Local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
@@ -112,88 +112,49 @@ as_environment::as_environment(VM& vm)
 {
 }
 
-as_object*
-findObject(const as_environment& ctx, const std::string& path,
-        const as_environment::ScopeStack* scope)
+TargetPath
+parseTargetPath(VM& vm, const std::string& path)
 {
-    if (path.empty()) {
-        return getObject(ctx.target());
-    }
-    
-    VM& vm = ctx.getVM();
+    assert(!path.empty());
+
     string_table& st = vm.getStringTable();
-    const int swfVersion = vm.getSWFVersion();
-    ObjectURI globalURI(NSV::PROP_uGLOBAL);
 
-    bool firstElementParsed = false;
+    TargetPath target;
     bool dot_allowed = true;
 
-    // This points to the current object being used for lookup.
-    as_object* env; 
     const char* p = path.c_str();
 
     // Check if it's an absolute path
     if (*p == '/') {
-
-        MovieClip* root = nullptr;
-        if (ctx.target()) root = ctx.target()->getAsRoot();
-        else {
-            if (ctx.get_original_target()) {
-                root = ctx.get_original_target()->getAsRoot();
-            }
-            return nullptr;
-        }
-
-        // If the path is just "/" return the root.
-        if (!*(++p)) return getObject(root);
-
-        // Otherwise we start at the root for lookup.
-        env = getObject(root);
-        firstElementParsed = true;
+        target.absolute = true;
         dot_allowed = false;
-
-    }
-    else {
-        env = getObject(ctx.target());
+        ++p;
     }
-    
-    assert (*p);
-
-    std::string subpart;
 
     while (1) {
 
         // Skip past all colons (why?)
         while (*p == ':') ++p;
 
-        if (!*p) {
-            // No more components to scan, so return the currently found
-            // object.
-            return env;
-        }
+        // No more components to scan
+        if (!*p) break;
 
         // Search for the next '/', ':' or '.'.
         const char* next_slash = next_slash_or_dot(p);
-        subpart = p;
 
         // Check whether p was pointing to one of those characters already.
         if (next_slash == p) {
-            IF_VERBOSE_ASCODING_ERRORS(
-                log_aserror(_("invalid path '%s' (p=next_slash=%s)"),
-                path, next_slash);
-            );
-            return nullptr;
+            target.error = TargetPath::MISSING_NAME;
+            target.rest = next_slash;
+            break;
         }
 
         if (next_slash) {
             if (*next_slash == '.') {
 
                 if (!dot_allowed) {
-                    IF_VERBOSE_ASCODING_ERRORS(
-                        log_aserror(_("invalid path '%s' (dot not allowed "
-                                "after having seen a slash)"), path);
-                    );
-                    return nullptr;
+                    target.error = TargetPath::DOT_NOT_ALLOWED;
+                    break;
                 }
                 // No dot allowed after a double-dot.
                 if (next_slash[1] == '.') dot_allowed = false;
@@ -201,20 +162,69 @@ findObject(const as_environment& ctx, const std::string& path,
             else if (*next_slash == '/') {
                 dot_allowed = false;
             }
-
-            // Cut off the slash and everything after it.
-            subpart.resize(next_slash - p);
         }
-        
+
+        // Cut off the slash and everything after it.
+        const std::string subpart = next_slash ?
+            std::string(p, next_slash - p) : std::string(p);
+
         assert(subpart[0] != ':');
 
-        // No more components to scan
-        if (subpart.empty()) break;
+        // Caseless lookups of the name need this, so it's done only once.
+        target.elements.push_back(getURI(vm, subpart));
+        target.elements.back().noCase(st);
 
-        const ObjectURI subpartURI(getURI(vm, subpart));
+        if (!next_slash) break;
+        
+        p = next_slash + 1;
+    }
+    return target;
+}
 
-        if (!firstElementParsed) {
-            as_object* element(nullptr);
+as_object*
+findObject(const as_environment& ctx, const std::string& path,
+        const as_environment::ScopeStack* scope)
+{
+    if (path.empty()) {
+        return getObject(ctx.target());
+    }
+    
+    VM& vm = ctx.getVM();
+    string_table& st = vm.getStringTable();
+    const int swfVersion = vm.getSWFVersion();
+    ObjectURI globalURI(NSV::PROP_uGLOBAL);
+
+    // Held while the objects are looked up, as that may run scripts
+    // that parse other paths.
+    const std::shared_ptr<const TargetPath> target(vm.getTargetPath(path));
+    TargetPath::Elements::const_iterator element = target->elements.begin();
+    const TargetPath::Elements::const_iterator end = target->elements.end();
+
+    // This points to the current object being used for lookup.
+    as_object* env; 
+
+    if (target->absolute) {
+
+        MovieClip* root = nullptr;
+        if (ctx.target()) root = ctx.target()->getAsRoot();
+        else {
+            if (ctx.get_original_target()) {
+                root = ctx.get_original_target()->getAsRoot();
+            }
+            return nullptr;
+        }
+
+        // We start at the root for lookup.
+        env = getObject(root);
+    }
+    else {
+        env = getObject(ctx.target());
+
+        // The first element is looked up in the scope too.
+        if (element != end) {
+
+            const ObjectURI& subpartURI = *element++;
+            as_object* found(nullptr);
 
             do {
                 // Try scope stack
@@ -222,17 +232,16 @@ findObject(const as_environment& ctx, const std::string& path,
                     for (size_t i = scope->size(); i > 0; --i) {
                         as_object* obj = (*scope)[i-1];
                         
-                        element = getElement(obj, subpartURI);
-                        if (element) break;
+                        found = getElement(obj, subpartURI);
+                        if (found) break;
                     }
-                    if (element) break;
+                    if (found) break;
                 }
 
                 // Try current target  (if any)
-                assert(env == getObject(ctx.target()));
                 if (env) {
-                    element = getElement(env, subpartURI);
-                    if (element) break;
+                    found = getElement(env, subpartURI);
+                    if (found) break;
                 }
 
                 // Looking for _global ?
@@ -242,33 +251,45 @@ findObject(const as_environment& ctx, const std::string& path,
                 if (swfVersion > 5) {
                     const ObjectURI::CaseEquals ce(st, nocase);
                     if (ce(subpartURI, globalURI)) {
-                        element = global;
+                        found = global;
                         break;
                     }
                 }
 
                 // Look for globals.
-                element = getElement(global, subpartURI);
+                found = getElement(global, subpartURI);
 
             } while (0);
 
-            if (!element) return nullptr;
+            if (!found) return nullptr;
 
-            env = element;
-            firstElementParsed = true;
+            env = found;
         }
-        else {
+    }
 
-            assert(env);
-            as_object* element = getElement(env, subpartURI);
-            if (!element) return nullptr;
-            env = element;
-        }
+    for (; element != end; ++element) {
+        assert(env);
+        env = getElement(env, *element);
+        if (!env) return nullptr;
+    }
 
-        if (!next_slash) break;
-        
-        p = next_slash + 1;
+    switch (target->error) {
+        case TargetPath::VALID:
+            break;
+        case TargetPath::MISSING_NAME:
+            IF_VERBOSE_ASCODING_ERRORS(
+                log_aserror(_("invalid path '%s' (p=next_slash=%s)"),
+                    path, target->rest);
+            );
+            return nullptr;
+        case TargetPath::DOT_NOT_ALLOWED:
+            IF_VERBOSE_ASCODING_ERRORS(
+                log_aserror(_("invalid path '%s' (dot not allowed "
+                        "after having seen a slash)"), path);
+            );
+            return nullptr;
     }
+
     return env;
 }
 
@@ -26,6 +26,7 @@
 #include "dsodefs.h" // for DSOTEXPORT
 #include "as_value.h" 
 #include "SafeStack.h"
+#include "ObjectURI.h"
 
 // Forward declarations
 namespace gnash {
@@ -196,6 +197,48 @@ bool delVariable(const as_environment& ctx, const std::string& varname,
 DSOEXPORT bool parsePath(const std::string& var_path, std::string& path,
         std::string& var);
 
+/// A target path split into the names of the objects on it.
+//
+/// The VM keeps the paths findObject() has parsed, as scripts use the
+/// same ones again and again.
+struct TargetPath
+{
+    TargetPath()
+        :
+        absolute(false),
+        error(VALID)
+    {}
+
+    /// Why a path is invalid after its elements.
+    enum Error
+    {
+        VALID,
+
+        /// A separator where a name should be.
+        MISSING_NAME,
+
+        /// A dot after a slash or a double dot.
+        DOT_NOT_ALLOWED
+    };
+
+    /// Whether the path starts from the root, with a slash.
+    bool absolute;
+
+    /// The names of the objects, in the order they are looked up.
+    typedef std::vector<ObjectURI> Elements;
+    Elements elements;
+
+    Error error;
+
+    /// The rest of an invalid path, from where it is invalid.
+    std::string rest;
+};
+
+/// Split a non-empty target path into the names of the objects on it.
+//
+/// Supports both /slash/syntax and dot.syntax
+TargetPath parseTargetPath(VM& vm, const std::string& path);
+
 /// Find the object referenced by the given path.
 //
 /// This is exposed to allow AS-scoped lookup from C++.
@@ -440,6 +440,29 @@ as_object::get_member(const ObjectURI& uri, as_value* val)
     }
 }
 
+bool
+as_object::get_element(size_t i, as_value* val)
+{
+    assert(val);
+
+    // An own element that is visible is found first, as get_member()
+    // would. Anything else is looked up by name.
+    Property* prop = _array ? _members.getElement(i) : nullptr;
+    if (!prop || !visible(*prop, getSWFVersion(*this))) {
+        return get_member(getVM(*this).getIndexKey(i), val);
+    }
+
+    try {
+        *val = prop->getValue(*this);
+        return true;
+    }
+    catch (const ActionTypeError& exc) {
+        IF_VERBOSE_ASCODING_ERRORS(
+            log_aserror(_("Caught exception: %s"), exc.what());
+            );
+        return false;
+    }
+}
 
 as_object*
 as_object::get_super(const ObjectURI& fname)
@@ -664,6 +687,30 @@ as_object::set_member(const ObjectURI& uri, const as_value& val, bool ifFound)
     return false;
 }
 
+bool
+as_object::set_element(size_t i, const as_value& val)
+{
+    return set_element(i, val, _array ? arrayLength(*this) : 0);
+}
+
+bool
+as_object::set_element(size_t i, const as_value& val, size_t length)
+{
+    // Setting an array element that is already there needs nothing but
+    // the new value, unless the element is special or something watches
+    // it. The length only changes for elements beyond it.
+    Property* prop = _array && i < length && !_trigs.get() &&
+        !displayObject() ? _members.getElement(i) : nullptr;
+
+    if (!prop || readOnly(*prop) || prop->isGetterSetter()) {
+        return set_member(getVM(*this).getIndexKey(i), val);
+    }
+
+    prop->setValue(*this, val);
+    prop->clearVisible(getSWFVersion(*this));
+    return true;
+}
+
 
 void
 as_object::init_member(const std::string& key1, const as_value& val, int flags)
@@ -928,6 +975,14 @@ as_object::getOwnProperty(const ObjectURI& uri)
     return _members.getProperty(uri);
 }
 
+Property*
+as_object::getOwnElement(size_t i)
+{
+    Property* prop = _members.getElement(i);
+    if (prop) return prop;
+    return _members.getProperty(getVM(*this).getIndexKey(i));
+}
+
 as_object*
 as_object::get_prototype() const
 {
@@ -228,6 +228,27 @@ public:
     virtual bool set_member(const ObjectURI& uri, const as_value& val,
         bool ifFound = false);
 
+    /// Set an element of this object by its index.
+    //
+    /// This does what set_member() does with the index's name, but
+    /// elements of arrays that are already there are set without looking
+    /// up the name.
+    //
+    /// @param i        The index of the element.
+    /// @param val      Value to assign to the element.
+    /// @return         As for set_member().
+    bool set_element(size_t i, const as_value& val);
+
+    /// Set an element of this object by its index, given its length.
+    //
+    /// This is for setting many elements, without reading the length of
+    /// the array for each one.
+    //
+    /// @param length   The length of this array, as arrayLength() returns
+    ///                 it. It's still right after setting elements below
+    ///                 it, and only makes elements set above it slower.
+    bool set_element(size_t i, const as_value& val, size_t length);
+
     /// Initialize a member value by string
     //
     /// This is just a wrapper around the other init_member method
@@ -426,6 +447,16 @@ public:
     /// @return         true if the named property was found, false otherwise.
     virtual bool get_member(const ObjectURI& uri, as_value* val);
 
+    /// Get an element of this object by its index.
+    //
+    /// This does what get_member() does with the index's name, but
+    /// elements of arrays are found without looking up the name.
+    //
+    /// @param i        The index of the element.
+    /// @param val      Variable to assign an existing value to.
+    /// @return         true if the element was found, false otherwise.
+    bool get_element(size_t i, as_value* val);
+
     /// Get the super object of this object.
     ///
     /// The super should be __proto__ if this is a prototype object
@@ -458,6 +489,15 @@ public:
     ///                 contain the named property.
     Property* getOwnProperty(const ObjectURI& uri);
 
+    /// Get this object's own element by its index, if it exists.
+    //
+    /// This function does *not* recurse in this object's prototype.
+    //
+    /// @param i        The index of the element.
+    /// @return         A Property pointer, or NULL if this object doesn't
+    ///                 contain the element.
+    Property* getOwnElement(size_t i);
+
     /// Set member flags (probably used by ASSetPropFlags)
     //
     /// @param name     Name of the property. Must be all lowercase
@@ -602,7 +642,7 @@ public:
     /// is assigned. There are tests verifying this behaviour in
     /// actionscript.all and the swfdec testsuite.
     void setRelay(Relay* p) {
-        if (p) _array = false;
+        if (p) setArray(false);
         if (_relay) _relay->clean();
         _relay.reset(p);
     }
@@ -629,6 +669,7 @@ public:
     /// Set whether this object should be treated as an array.
     void setArray(bool array = true) {
         _array = array;
+        _members.indexElements(array);
     }
 
     /// Return the DisplayObject associated with this object.
@@ -780,6 +821,22 @@ getOwnProperty(as_object& o, const ObjectURI& uri)
     return p ? p->getValue(o) : as_value();
 }
 
+/// Get an own element of an object.
+//
+/// This is a wrapper round as_object::getOwnElement that returns undefined if
+/// the element is not found.
+//
+/// @param o        The object whose own element is required.
+/// @param i        The index of the element.
+/// @return         Value of the element (possibly undefined),
+///                 or undefined if not found.
+inline as_value
+getOwnElement(as_object& o, size_t i)
+{
+    Property* p = o.getOwnElement(i);
+    return p ? p->getValue(o) : as_value();
+}
+
 /// Function objects for visiting properties.
 class IsVisible
 {
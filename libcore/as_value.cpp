@@ -198,6 +198,50 @@ parseDecimalNumber(std::string::const_iterator start,
     return boost::lexical_cast<double>(std::string(start, last));
 }
 
+/// Parse a hexadecimal or octal number, as parseNonDecimalInt() does.
+bool
+parseNonDecimalInt(std::string::const_iterator start,
+        std::string::const_iterator last, double& d, bool whole)
+{
+    const std::string::size_type slen = last - start;
+
+    // "0#" would still be octal, but has the same value as a decimal.
+    if (slen < 3) return false;
+
+    bool negative = false;
+
+    if (start[0] == '0' && (start[1] == 'x' || start[1] == 'X')) {
+        // The only legitimate place for a '-' is after 0x. If it's a
+        // '+' we don't care, as it won't disturb the conversion.
+        std::string::const_iterator digits = start + 2;
+        if (*digits == '-') {
+            negative = true;
+            ++digits;
+        }
+        d = parsePositiveInt(std::string(digits, last), BASE_HEX, whole);
+        if (negative) d = -d;
+        return true;
+    }
+    else if ((start[0] == '0' ||
+                ((start[0] == '-' || start[0] == '+') && start[1] == '0')) &&
+            std::find_if(start + 1, last, [](char c) {
+                    return c < '0' || c > '7';
+                }) == last) {
+
+        std::string::const_iterator digits = start;
+        if (*digits == '-') {
+            negative = true;
+            ++digits;
+        }
+        d = parsePositiveInt(std::string(digits, last), BASE_OCT, whole);
+        if (negative) d = -d;
+        return true;
+    }
+
+    return false;
+
+}
+
 } // anonymous namespace
 
 // Conversion to const std::string&.
@@ -207,7 +251,7 @@ as_value::to_string(int version) const
     switch (_type)
     {
         case STRING:
-            return getStr();
+            return getStr().str();
         case DISPLAYOBJECT:
         {
             const CharacterProxy& sp = getCharacterProxy();
@@ -227,14 +271,14 @@ as_value::to_string(int version) const
         {
             as_object* obj = getObj();
             String_as* s;
-            if (isNativeType(obj, s)) return s->value();
+            if (isNativeType(obj, s)) return s->value().str();
 
             try {
                 as_value ret = to_primitive(STRING);
                 // This additional is_string test is NOT compliant with ECMA-262
                 // specification, but seems required for compatibility with the
                 // reference player.
-                if (ret.is_string()) return ret.getStr();
+                if (ret.is_string()) return ret.getStr().str();
             }
             catch (const ActionTypeError& e) {}
            
@@ -248,6 +292,17 @@ as_value::to_string(int version) const
     
 }
 
+SharedString
+as_value::to_shared_string(int version) const
+{
+    if (_type == STRING) return getStr();
+
+    String_as* s;
+    if (_type == OBJECT && isNativeType(getObj(), s)) return s->value();
+
+    return to_string(version);
+}
+
 as_value::AsType
 as_value::defaultPrimitive(int version) const
 {
@@ -321,7 +376,7 @@ as_value::to_number(const int version) const
     switch (_type) {
         case STRING:
         {
-            const std::string& s = getStr();
+            const SharedString& s = getStr();
             if ( s.empty() ) {
                 return version >= 5 ? NaN : 0.0;
             }
@@ -332,30 +387,36 @@ as_value::to_number(const int version) const
                 // DisplayObjects is returned, including exponent, positive
                 // and negative signs and whitespace before.
                 double d = 0;
-                std::istringstream is(s);
+                std::istringstream is(s.str());
                 is >> d;
                 return d;
             }
 
+            // Nothing below runs ActionScript, so the characters can be
+            // parsed where they are.
             try {
 
                 if (version > 5) {
                     double d;
                     // Will throw if invalid.
-                    if (parseNonDecimalInt(s, d)) return d;
+                    if (parseNonDecimalInt(s.begin(), s.end(), d, true)) {
+                        return d;
+                    }
                 }
 
                 // @@ Moock says the rule here is: if the
                 // string is a valid float literal, then it
                 // gets converted; otherwise it is set to NaN.
                 // Valid for SWF5 and above.
-                const std::string::size_type pos =
-                    s.find_first_not_of(" \r\n\t");
+                const SharedString::const_iterator pos =
+                    std::find_if(s.begin(), s.end(), [](char c) {
+                        return c != ' ' && c != '\r' && c != '\n' && c != '\t';
+                    });
 
-                if (pos == std::string::npos) return NaN;
+                if (pos == s.end()) return NaN;
                 
                 // Will throw a boost::bad_lexical_cast if it fails.
-                return parseDecimalNumber(s.begin() + pos, s.end());
+                return parseDecimalNumber(pos, s.end());
  
             }
             catch (const boost::bad_lexical_cast&) {
@@ -732,7 +793,14 @@ void
 as_value::set_string(const std::string& str)
 {
     _type = STRING;
-    _value = str;
+    _value = SharedString(str);
+}
+
+void
+as_value::append_string(const std::string& str)
+{
+    assert(_type == STRING);
+    boost::get<SharedString>(_value).append(str);
 }
 
 void
@@ -772,7 +840,7 @@ as_value::writeAMF0(amf::Writer& w) const
             return w.writeObject(getObj());
 
         case STRING:
-            return w.writeString(getStr());
+            return w.writeString(getStr().str());
 
         case NUMBER:
             return w.writeNumber(getNum());
@@ -792,40 +860,7 @@ as_value::writeAMF0(amf::Writer& w) const
 bool
 parseNonDecimalInt(const std::string& s, double& d, bool whole)
 {
-    const std::string::size_type slen = s.length();
-
-    // "0#" would still be octal, but has the same value as a decimal.
-    if (slen < 3) return false;
-
-    bool negative = false;
-
-    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
-        // The only legitimate place for a '-' is after 0x. If it's a
-        // '+' we don't care, as it won't disturb the conversion.
-        std::string::size_type start = 2;
-        if (s[2] == '-') {
-            negative = true;
-            ++start;
-        }
-        d = parsePositiveInt(s.substr(start), BASE_HEX, whole);
-        if (negative) d = -d;
-        return true;
-    }
-    else if ((s[0] == '0' || ((s[0] == '-' || s[0] == '+') && s[1] == '0')) &&
-            s.find_first_not_of("01234567", 1) == std::string::npos) {
-
-        std::string::size_type start = 0;
-        if (s[0] == '-') {
-            negative = true;
-            ++start;
-        }
-        d = parsePositiveInt(s.substr(start), BASE_OCT, whole);
-        if (negative) d = -d;
-        return true;
-    }
-
-    return false;
-
+    return parseNonDecimalInt(s.begin(), s.end(), d, whole);
 }
 
 std::string
@@ -1057,7 +1092,7 @@ operator<<(std::ostream& o, const as_value& v)
                                                        << "]";
         }
         case as_value::STRING:
-            return o << "[string:" + v.getStr() + "]";
+            return o << "[string:" + v.getStr().str() + "]";
         case as_value::NUMBER:
             return o << "[number:" << v.getNum() << "]";
         case as_value::DISPLAYOBJECT:
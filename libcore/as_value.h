@@ -28,6 +28,7 @@
 
 #include "dsodefs.h" // for DSOTEXPORT
 #include "CharacterProxy.h"
+#include "SharedString.h"
 #include "GnashNumeric.h" // for isNaN
 
 
@@ -145,11 +146,19 @@ public:
     DSOEXPORT as_value(const char* str)
         :
         _type(STRING),
-        _value(std::string(str))
+        _value(SharedString(str))
     {}
 
     /// Construct a primitive String value 
     DSOEXPORT as_value(std::string str)
+        :
+        _type(STRING),
+        _value(SharedString(std::move(str)))
+    {}
+
+    /// Construct a primitive String value sharing the characters of
+    /// another.
+    DSOEXPORT as_value(SharedString str)
         :
         _type(STRING),
         _value(std::move(str))
@@ -234,6 +243,12 @@ public:
     //
     /// TODO: drop the default argument.
     DSOTEXPORT std::string to_string(int version = 7) const;
+
+    /// Get a SharedString representation for this value.
+    //
+    /// This is what to_string() returns, but Strings and String objects
+    /// aren't copied.
+    SharedString to_shared_string(int version) const;
     
     /// Get a number representation for this value
     //
@@ -317,6 +332,12 @@ public:
     
     /// Set to a primitive string.
     void set_string(const std::string& str);
+
+    /// Append to a primitive string.
+    //
+    /// The value must be a String. Appending to a String that was made
+    /// by appending to another doesn't copy it; see SharedString.
+    void append_string(const std::string& str);
     
     /// Set to a primitive number.
     void set_double(double val);
@@ -423,7 +444,7 @@ private:
                            bool,
                            as_object*,
                            CharacterProxy,
-                           std::string>
+                           SharedString>
     AsValueType;
     
     /// Use the relevant equality function, not operator==
@@ -476,9 +497,9 @@ private:
     /// Get the boolean variant member.
     //
     /// The caller must check that this value is a String.
-    const std::string& getStr() const {
+    const SharedString& getStr() const {
         assert(_type == STRING);
-        return boost::get<std::string>(_value);
+        return boost::get<SharedString>(_value);
     }
     
 };
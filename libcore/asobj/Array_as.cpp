@@ -25,8 +25,12 @@
 #include <cmath>
 #include <functional>
 #include <iterator>
+#include <limits>
+#include <cstdint>
+#include <system_error>
+#include <thread>
+#include <vector>
 #include <boost/algorithm/string/case_conv.hpp>
-#include <boost/lexical_cast.hpp>
 
 #include "as_value.h"
 #include "log.h"
@@ -65,8 +69,6 @@ namespace {
 
     struct indexed_as_value;
 
-    typedef std::function<bool(const as_value&, const as_value&)> as_cmp_fn;
-
     void attachArrayInterface(as_object& proto);
     void attachArrayStatics(as_object& proto);
 
@@ -249,79 +251,12 @@ void mergeSort(IterType begin, IterType end, ComparatorType compare)
 
 } // namespace mergesort
 
-template <typename IterType, typename ComparatorType>
-void
-SafeSort(IterType begin, IterType end, ComparatorType compare)
-{
-    std::sort(begin, end, compare);
-}
-
 class as_value_custom;
 
 template <typename IterType>
 void
 SafeSort(IterType begin, IterType end, const as_value_custom& compare);
 
-/// \brief
-/// Attempt to sort the array using given values comparator, avc.
-/// If two or more elements in the array are equal, as determined
-/// by the equality comparator ave, then the array is not sorted
-/// and 0 is returned. Otherwise the array is sorted and returned.
-///
-/// @param avc
-///	boolean functor or function comparing two as_value& objects
-///     used to determine sort-order
-///
-/// @param ave
-///	boolean functor or function comparing two as_value& objects
-///     used to determine equality
-///
-template <class AVCMP, class AVEQ>
-bool sort(as_object& o, AVCMP avc, AVEQ ave)
-{
-    // IMPORTANT NOTE
-    //
-    // As for ISO/IEC 14882:2003 - 23.2.2.4.29 
-    // the sort algorithm relies on the assumption
-    // that the comparator function implements
-    // a Strict Weak Ordering operator:
-    // http://www.sgi.com/tech/stl/StrictWeakOrdering.html
-    //
-    // Invalid comparator can lead to undefined behaviour,
-    // including invalid memory access and infinite loops.
-    //
-    // Pragmatically, it seems that std::list::sort is
-    // more robust in this reguard, so we'll sort a list
-    // instead of the queue. We want to sort a copy anyway
-    // to avoid the comparator changing the original container.
-
-    typedef std::list<as_value> SortContainer;
-
-    SortContainer v;
-    PushToContainer<SortContainer> pv(v);
-    foreachArray(o, pv);
-
-    const size_t size = v.size(); 
-
-    v.sort(avc);
-
-    if (std::adjacent_find(v.begin(), v.end(), ave) != v.end()) return false;
-
-    VM& vm = getVM(o);
-
-    SortContainer::const_iterator it = v.begin();
-
-    for (size_t i = 0; i < size; ++i) {
-        if (i >= v.size()) {
-            break;
-        }
-        o.set_member(arrayKey(vm, i), *it);
-        ++it;
-    }
-    return true;
-}
-
-
 template <class AVCMP>
 void
 sort(as_object& o, AVCMP avc) 
@@ -337,51 +272,18 @@ sort(as_object& o, AVCMP avc)
 
     v.sort(avc);
 
-    VM& vm = getVM(o);
-
     SortContainer::const_iterator it = v.begin();
 
+    const size_t length = arrayLength(o);
     for (size_t i = 0; i < size; ++i) {
         if (it == v.end()) {
             break;
         }
-        o.set_member(arrayKey(vm, i), *it);
+        o.set_element(i, *it, length);
         ++it;
     }
 }
 
-/// \brief
-/// Return a new array containing sorted index of this array.
-/// If two or more elements in the array are equal, as determined
-/// by the equality comparator ave, then 0 is returned instead.
-///
-/// @param avc
-///	boolean functor or function comparing two as_value& objects
-///     used to determine sort-order
-///
-/// @param ave
-///	boolean functor or function comparing two as_value& objects
-///     used to determine equality
-///
-template <class AVCMP, class AVEQ>
-as_value sortIndexed(as_object& array, AVCMP avc, AVEQ ave)
-{
-    std::vector<indexed_as_value> v;
-
-    getIndexedElements(array, v);
-
-    SafeSort(v.begin(), v.end(), avc);
-
-    if (std::adjacent_find(v.begin(), v.end(), ave) != v.end()) {
-        return as_value(0.0);
-    }
-
-    as_object* o = getGlobal(array).createArray();
-    pushIndices(*o, v);
-    return o;
-}
-
-
 /// \brief
 /// Return a new array containing sorted index of this array
 ///
@@ -401,276 +303,284 @@ sortIndexed(as_object& array, AVCMP avc)
 }
 
 
-// simple as_value strict-weak-ordering comparison functors:
-// string comparison, ascending (default sort method)
-struct as_value_lt
+/// Sort a range stably, splitting large ones between threads.
+//
+/// The comparator must not touch the VM, as it may run on any of them.
+template<typename Iter, typename Compare>
+void
+parallelStableSort(Iter begin, Iter end, Compare comp, unsigned threads)
 {
-    as_value_lt(const fn_call& fn) : _fn(fn) {}
+    // Below this, starting a thread costs more than it saves.
+    const std::ptrdiff_t minSize = 16384;
 
-    int str_cmp(const as_value& a, const as_value& b) const 
-    {
-        std::string s = a.to_string(getSWFVersion(_fn));
-        return s.compare(b.to_string(getSWFVersion(_fn)));
+    const std::ptrdiff_t size = end - begin;
+    if (threads < 2 || size < 2 * minSize) {
+        std::stable_sort(begin, end, comp);
+        return;
     }
 
-    int str_nocase_cmp(const as_value& a, const as_value& b) const
-    {
-        using namespace boost::algorithm;
-
-        std::string c = to_upper_copy(a.to_string(getSWFVersion(_fn)));
-        std::string d = to_upper_copy(b.to_string(getSWFVersion(_fn)));
-        return c.compare(d);
+    const Iter middle = begin + size / 2;
+    std::thread first;
+    try {
+        first = std::thread([=] {
+            parallelStableSort(begin, middle, comp, threads / 2);
+        });
     }
-
-    bool as_value_numLT(const as_value& a, const as_value& b) const
-    {
-        if (a.is_undefined()) return false;
-        if (b.is_undefined()) return true;
-        if (a.is_null()) return false;
-        if (b.is_null()) return true;
-        const double aval = toNumber(a, getVM(_fn));
-        const double bval = toNumber(b, getVM(_fn));
-        if (isNaN(aval)) return false;
-        if (isNaN(bval)) return true;
-        return aval < bval;
+    catch (const std::system_error&) {
+        std::stable_sort(begin, end, comp);
+        return;
     }
+    parallelStableSort(middle, end, comp, threads - threads / 2);
+    first.join();
 
-    bool as_value_numGT(const as_value& a, const as_value& b) const
-    {
-        if (b.is_undefined()) return false;
-        if (a.is_undefined()) return true;
-        if (b.is_null()) return false;
-        if (a.is_null()) return true;
-        const double aval = toNumber(a, getVM(_fn));
-        const double bval = toNumber(b, getVM(_fn));
-        if (isNaN(bval)) return false;
-        if (isNaN(aval)) return true;
-        return aval > bval;
-    }
+    std::inplace_merge(begin, middle, end, comp);
+}
 
-    inline bool as_value_numEQ(const as_value& a, const as_value& b) const
-    {
-        if (a.is_undefined() && b.is_undefined()) return true;
-        if (a.is_null() && b.is_null()) return true;
-        double aval = toNumber(a, getVM(_fn));
-        double bval = toNumber(b, getVM(_fn));
-        if (isNaN(aval) && isNaN(bval)) return true;
-        return aval == bval;
-    }
+/// What an element is sorted by, converted once before sorting.
+struct SortKey
+{
+    SortKey()
+        :
+        num(0),
+        isString(false),
+        isUndefined(false),
+        isNull(false)
+    {}
 
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        return str_cmp(a, b) < 0;
-    }
-private:
-    const fn_call& _fn;
-};
+    /// The string to compare, in upper case for a case-insensitive sort.
+    std::string str;
 
-// string comparison, descending
-struct as_value_gt : public as_value_lt 
-{
-    as_value_gt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const {
-        return str_cmp(a, b) > 0;
-    }
+    /// The number to compare in a numeric sort, if neither is a string.
+    double num;
+
+    bool isString;
+    bool isUndefined;
+    bool isNull;
 };
 
-// string equality
-struct as_value_eq : public as_value_lt
+/// Sorts an Array in one of the built-in orders.
+//
+/// The built-in orders compare strings and numbers converted from the
+/// elements, or from properties of them for sortOn(). These are
+/// converted once for each element before sorting, rather than for
+/// each comparison, and then sorted without calling back into the VM.
+class KeySort
 {
-    as_value_eq(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
+public:
+
+    /// Sort by the elements themselves.
+    KeySort(as_object& array, std::uint8_t flags, const fn_call& fn)
+        :
+        _byElement(true),
+        _flags(1, knownFlags(flags))
     {
-        return str_cmp(a, b) == 0;
+        PushToContainer<std::vector<as_value> > pv(_values);
+        foreachArray(array, pv);
+        extractKeys(fn, [](const as_value& v) { return v; });
     }
-};
 
-// case-insensitive string comparison, ascending
-struct as_value_nocase_lt : public as_value_lt
-{
-    as_value_nocase_lt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
+    /// Sort by a property of each element, each in its own order.
+    KeySort(as_object& array, const std::vector<ObjectURI>& props,
+            const std::vector<std::uint8_t>& flags, const fn_call& fn)
+        :
+        _byElement(false)
     {
-        return str_nocase_cmp(a, b) < 0;
+        assert(props.size() == flags.size());
+
+        for (std::uint8_t f : flags) _flags.push_back(knownFlags(f));
+
+        PushToContainer<std::vector<as_value> > pv(_values);
+        foreachArray(array, pv);
+
+        VM& vm = getVM(fn);
+
+        // Properties of values that aren't objects can't be compared.
+        std::vector<as_object*> objects;
+        objects.reserve(_values.size());
+        _isObject.reserve(_values.size());
+        for (const as_value& v : _values) {
+            objects.push_back(toObject(v, vm));
+            _isObject.push_back(objects.back() != nullptr);
+        }
+
+        size_t field = 0;
+        for (const ObjectURI& prop : props) {
+            size_t i = 0;
+            extractKeys(fn, [&](const as_value&) {
+                as_object* o = objects[i++];
+                return o ? getOwnProperty(*o, prop) : as_value();
+            }, field++);
+        }
     }
-};
 
-// case-insensitive string comparison, descending
-struct as_value_nocase_gt : public as_value_lt
-{
-    as_value_nocase_gt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        return str_nocase_cmp(a, b) > 0;
+    /// Sort the elements, unless unique is true and two are equal.
+    //
+    /// @return     false if the elements weren't sorted.
+    bool sort(bool unique) {
+
+        _order.resize(_values.size());
+        for (size_t i = 0; i < _order.size(); ++i) _order[i] = i;
+
+        parallelStableSort(_order.begin(), _order.end(),
+                [this](size_t a, size_t b) { return less(a, b); },
+                std::thread::hardware_concurrency());
+
+        if (!unique) return true;
+        return std::adjacent_find(_order.begin(), _order.end(),
+                [this](size_t a, size_t b) { return equal(a, b); }) ==
+            _order.end();
     }
-};
 
-// case-insensitive string equality
-struct as_value_nocase_eq : public as_value_lt
-{
-    as_value_nocase_eq(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        return str_nocase_cmp(a, b) == 0;
+    /// Put the sorted elements in the array.
+    void store(as_object& array) const {
+        const size_t length = arrayLength(array);
+        for (size_t i = 0; i < _order.size(); ++i) {
+            array.set_element(i, _values[_order[i]], length);
+        }
     }
-};
 
-// numeric comparison, ascending
-struct as_value_num_lt : public as_value_lt
-{
-    as_value_num_lt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        if (a.is_string() || b.is_string()) return str_cmp(a, b) < 0;
-        return as_value_numLT(a, b);
+    /// Make an array of the indices of the elements in sorted order.
+    as_object* indices(as_object& array) const {
+        as_object* o = getGlobal(array).createArray();
+        for (size_t i : _order) {
+            callMethod(o, NSV::PROP_PUSH, static_cast<double>(i));
+        }
+        return o;
     }
-};
 
-// numeric comparison, descending
-struct as_value_num_gt : public as_value_lt
-{
-    as_value_num_gt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        if (a.is_string() || b.is_string()) return str_cmp(a, b) > 0;
-        return as_value_numGT(a, b);
+private:
+
+    /// Flags with any not understood are the default order.
+    static std::uint8_t knownFlags(std::uint8_t flags) {
+        const std::uint8_t known =
+            SORT_CASE_INSENSITIVE | SORT_DESCENDING | SORT_NUMERIC;
+        if (!(flags & ~known)) return flags;
+        log_unimpl(_("Unhandled sort flags: %d (0x%X)"), +flags, +flags);
+        return 0;
     }
-};
 
-// numeric equality
-struct as_value_num_eq : public as_value_lt
-{
-    as_value_num_eq(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        if (a.is_string() || b.is_string()) return str_cmp(a, b) == 0;
-        return as_value_numEQ(a, b);
+    /// Convert the values sorted by for a field of each element.
+    template<typename Get>
+    void extractKeys(const fn_call& fn, Get get, size_t field = 0) {
+
+        const size_t fields = _flags.size();
+        const std::uint8_t flags = _flags[field];
+        const int version = getSWFVersion(fn);
+        VM& vm = getVM(fn);
+
+        _keys.resize(_values.size() * fields);
+
+        std::vector<as_value> values;
+        values.reserve(_values.size());
+        bool strings = false;
+        for (const as_value& v : _values) {
+            values.push_back(get(v));
+            strings = strings || values.back().is_string();
+        }
+
+        // A numeric sort compares strings if either value is one, so
+        // only then are numbers converted to strings.
+        const bool numeric = flags & SORT_NUMERIC;
+        const bool needStrings = !numeric || strings;
+
+        for (size_t i = 0; i < values.size(); ++i) {
+            const as_value& v = values[i];
+            SortKey& k = _keys[i * fields + field];
+            k.isString = v.is_string();
+            k.isUndefined = v.is_undefined();
+            k.isNull = v.is_null();
+            if (needStrings) {
+                k.str = v.to_string(version);
+                if (flags & SORT_CASE_INSENSITIVE) {
+                    boost::algorithm::to_upper(k.str);
+                }
+            }
+            if (numeric && !k.isString) k.num = toNumber(v, vm);
+        }
     }
-};
 
-// case-insensitive numeric comparison, ascending
-struct as_value_num_nocase_lt : public as_value_lt
-{
-    as_value_num_nocase_lt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        if (a.is_string() || b.is_string()) return str_nocase_cmp(a, b) < 0;
-        return as_value_numLT(a, b);
+    /// Compare keys, in ascending order.
+    static int compare(const SortKey& a, const SortKey& b,
+            std::uint8_t flags) {
+        if (!(flags & SORT_NUMERIC) || a.isString || b.isString) {
+            return a.str.compare(b.str);
+        }
+
+        // Numbers come first, then NaN, null and undefined.
+        const int ra = rank(a);
+        const int rb = rank(b);
+        if (ra != rb) return ra < rb ? -1 : 1;
+        if (ra) return 0;
+        if (a.num < b.num) return -1;
+        return b.num < a.num ? 1 : 0;
     }
-};
 
-// case-insensitive numeric comparison, descending
-struct as_value_num_nocase_gt : public as_value_lt
-{
-    as_value_num_nocase_gt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        if (a.is_string() || b.is_string()) return str_nocase_cmp(a, b) > 0;
-        return as_value_numGT(a, b);
+    static int rank(const SortKey& k) {
+        if (k.isUndefined) return 3;
+        if (k.isNull) return 2;
+        return isNaN(k.num) ? 1 : 0;
     }
-};
 
-// case-insensitive numeric equality
-struct as_value_num_nocase_eq : public as_value_lt
-{
-    as_value_num_nocase_eq(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator() (const as_value& a, const as_value& b) const
-    {
-        if (a.is_string() || b.is_string()) return str_nocase_cmp(a, b) == 0;
-        return as_value_numEQ(a, b);
+    /// Whether the keys are equal for a unique sort.
+    static bool equalKeys(const SortKey& a, const SortKey& b,
+            std::uint8_t flags) {
+        if (!(flags & SORT_NUMERIC) || a.isString || b.isString) {
+            return a.str == b.str;
+        }
+        if (a.isUndefined && b.isUndefined) return true;
+        if (a.isNull && b.isNull) return true;
+        if (isNaN(a.num) && isNaN(b.num)) return true;
+        return a.num == b.num;
     }
-};
 
-// Return basic as_value comparison functor for corresponding sort flag
-// Note:
-// SORT_UNIQUE and SORT_RETURN_INDEX must first be stripped from the flag
-as_cmp_fn
-get_basic_cmp(std::uint8_t flags, const fn_call& fn)
-{
-    as_cmp_fn f;
+    bool less(size_t a, size_t b) const {
+        if (!_byElement && !(_isObject[a] && _isObject[b])) return false;
 
-    // SORT_UNIQUE and SORT_RETURN_INDEX must be stripped by caller
-    assert(flags^SORT_UNIQUE);
-    assert(flags^SORT_RETURN_INDEX);
+        const size_t fields = _flags.size();
+        if (!fields) return false;
 
-    switch ( flags )
-    {
-        case 0: // default string comparison
-            f = as_value_lt(fn);
-            return f;
-
-        case SORT_DESCENDING:
-            f = as_value_gt(fn);
-            return f;
-
-        case SORT_CASE_INSENSITIVE: 
-            f = as_value_nocase_lt(fn);
-            return f;
-
-        case SORT_CASE_INSENSITIVE | 
-                SORT_DESCENDING:
-            f = as_value_nocase_gt(fn);
-            return f;
-
-        case SORT_NUMERIC: 
-            f = as_value_num_lt(fn);
-            return f;
-
-        case SORT_NUMERIC | SORT_DESCENDING:
-            f = as_value_num_gt(fn);
-            return f;
-
-        case SORT_CASE_INSENSITIVE | 
-                SORT_NUMERIC:
-            f = as_value_num_nocase_lt(fn);
-            return f;
-
-        case SORT_CASE_INSENSITIVE | 
-                SORT_NUMERIC |
-                SORT_DESCENDING:
-            f = as_value_num_nocase_gt(fn);
-            return f;
-
-        default:
-            log_unimpl(_("Unhandled sort flags: %d (0x%X)"), +flags, +flags);
-            f = as_value_lt(fn);
-            return f;
+        const SortKey* ka = &_keys[a * fields];
+        const SortKey* kb = &_keys[b * fields];
+
+        for (size_t i = 0; i < fields; ++i) {
+            const int c = compare(ka[i], kb[i], _flags[i]);
+            if (c) return (_flags[i] & SORT_DESCENDING) ? c > 0 : c < 0;
+        }
+        return false;
     }
-}
 
-// Return basic as_value equality functor for corresponding sort flag
-// Note:
-// SORT_UNIQUE and SORT_RETURN_INDEX must first be stripped from the flag
-as_cmp_fn
-get_basic_eq(std::uint8_t flags, const fn_call& fn)
-{
-    as_cmp_fn f;
-    flags &= ~(SORT_DESCENDING);
+    bool equal(size_t a, size_t b) const {
+        if (!_byElement && !(_isObject[a] && _isObject[b])) return false;
 
-    switch (flags)
-    {
-        case 0: // default string comparison
-            f = as_value_eq(fn);
-            return f;
-
-        case SORT_CASE_INSENSITIVE: 
-            f = as_value_nocase_eq(fn);
-            return f;
-
-        case SORT_NUMERIC: 
-            f = as_value_num_eq(fn);
-            return f;
-
-        case SORT_CASE_INSENSITIVE | 
-                SORT_NUMERIC:
-            f = as_value_num_nocase_eq(fn);
-            return f;
-
-        default:
-            f = as_value_eq(fn);
-            return f;
+        const size_t fields = _flags.size();
+        if (!fields) return false;
+
+        const SortKey* ka = &_keys[a * fields];
+        const SortKey* kb = &_keys[b * fields];
+
+        for (size_t i = 0; i < fields; ++i) {
+            if (!equalKeys(ka[i], kb[i], _flags[i])) return false;
+        }
+        return true;
     }
-}
+
+    const bool _byElement;
+
+    /// The elements, in their original order.
+    std::vector<as_value> _values;
+
+    /// Whether each element is an object, when sorting by properties.
+    std::vector<bool> _isObject;
+
+    /// The order of each field.
+    std::vector<std::uint8_t> _flags;
+
+    /// The keys of each field of each element.
+    std::vector<SortKey> _keys;
+
+    /// The indices of the elements in sorted order.
+    std::vector<size_t> _order;
+};
 
 // Custom (ActionScript) comparator 
 class as_value_custom
@@ -703,128 +613,6 @@ public:
     }
 };
 
-// Comparator for sorting on a single array property
-class as_value_prop
-{
-public:
-    
-    // Note: cmpfn must implement a strict weak ordering
-    as_value_prop(ObjectURI name, as_cmp_fn cmpfn, const as_object& o)
-        :
-        _comp(std::move(cmpfn)),
-        _prop(std::move(name)),
-        _obj(o)
-    {
-    }
-
-    bool operator()(const as_value& a, const as_value& b) const {
-
-        // why do we cast ao/bo to objects here ?
-        as_object* ao = toObject(a, getVM(_obj));
-        as_object* bo = toObject(b, getVM(_obj));
-
-        assert(ao);
-        assert(bo);
-        
-        const as_value& av = getOwnProperty(*ao, _prop);
-        const as_value& bv = getOwnProperty(*bo, _prop);
-
-        return _comp(av, bv);
-    }
-private:
-    as_cmp_fn _comp;
-    ObjectURI _prop;
-    const as_object& _obj;
-};
-
-// Comparator for sorting on multiple array properties
-class as_value_multiprop
-{
-public:
-    typedef std::vector<as_cmp_fn> Comps;
-    Comps& _cmps;
-
-    typedef std::vector<ObjectURI> Props;
-    Props& _prps;
-    
-    const as_object& _obj;
-
-    // Note: all as_cmp_fns in *cmps must implement strict weak ordering
-    as_value_multiprop(std::vector<ObjectURI>& prps, 
-        std::vector<as_cmp_fn>& cmps, const as_object& o)
-        :
-        _cmps(cmps),
-        _prps(prps),
-        _obj(o)
-    {
-    }
-
-    bool operator() (const as_value& a, const as_value& b)
-    {
-        if (_cmps.empty()) return false;
-
-        std::vector<as_cmp_fn>::iterator cmp = _cmps.begin();
-
-        // why do we cast ao/bo to objects here ?
-        as_object* ao = toObject(a, getVM(_obj));
-        as_object* bo = toObject(b, getVM(_obj));
-
-        // TODO: this may not be correct, but it is better than accessing
-        // null pointers.
-        if (!ao || !bo) return false;
-        
-        for (Props::iterator pit = _prps.begin(), pend = _prps.end();
-                pit != pend; ++pit, ++cmp) {
-            
-            const as_value& av = getOwnProperty(*ao, *pit);
-            const as_value& bv = getOwnProperty(*bo, *pit);
-
-            if ((*cmp)(av, bv)) return true;
-            if ((*cmp)(bv, av)) return false;
-            // Note: for loop finishes only if a == b for
-            // each requested comparison
-            // (since *cmp(av,bv) == *cmp(bv,av) == false)
-        }
-        
-        return false;
-    }
-};
-
-class as_value_multiprop_eq : public as_value_multiprop
-{
-public:
-    as_value_multiprop_eq(std::vector<ObjectURI>& prps, 
-        std::vector<as_cmp_fn>& cmps, const as_object& o)
-        :
-        as_value_multiprop(prps, cmps, o),
-        _obj(o)
-    {
-    }
-
-    bool operator()(const as_value& a, const as_value& b) const {
-        if (_cmps.empty()) return false;
-
-        Comps::const_iterator cmp = _cmps.begin();
-
-        // why do we cast ao/bo to objects here ?
-        as_object* ao = toObject(a, getVM(_obj));
-        as_object* bo = toObject(b, getVM(_obj));
-
-        for (Props::iterator pit = _prps.begin(), pend = _prps.end();
-                pit != pend; ++pit, ++cmp)
-        {
-            const as_value& av = getOwnProperty(*ao, *pit);
-            const as_value& bv = getOwnProperty(*bo, *pit);
-
-            if (!(*cmp)(av, bv)) return false;
-        }
-        
-        return true;
-    }
-private:
-    const as_object& _obj;
-};
-
 // Convenience function to strip SORT_UNIQUE and SORT_RETURN_INDEX from sort
 // flag. Presence of flags recorded in douniq and doindex.
 inline std::uint8_t
@@ -930,10 +718,11 @@ checkArrayLength(as_object& array, const ObjectURI& uri, const as_value& val)
 
     const int index = isIndex(uri.toString(getStringTable(array)));
 
-    // if we were sent a valid array index
+    // if we were sent a valid array index. The array only grows, so
+    // there is nothing to delete.
     if (index >= 0) {
         if (static_cast<size_t>(index) >= arrayLength(array)) {
-            setArrayLength(array, index + 1);
+            array.set_member(NSV::PROP_LENGTH, index + 1);
         }
     }
 }
@@ -994,8 +783,7 @@ array_class_init(as_object& where, const ObjectURI& uri)
 ObjectURI
 arrayKey(VM& vm, size_t i)
 {
-    // TODO: tell getURI that the string is already lowercase!
-    return getURI(vm, std::to_string(i), true);
+    return vm.getIndexKey(i);
 }
 
 namespace {
@@ -1071,35 +859,34 @@ array_splice(const fn_call& fn)
     Global_as& gl = getGlobal(fn);
     as_object* ret = gl.createArray();
 
-    // Copy the original array values for reinsertion. It's not possible
-    // to do a simple copy in-place without overwriting values that still
-    // need to be shifted. The algorithm could certainly be improved though.
+    // Copy the original array values from the start offset for
+    // reinsertion. It's not possible to do a simple copy in-place without
+    // overwriting values that still need to be shifted.
     typedef std::vector<as_value> TempContainer;
     TempContainer v;
     PushToContainer<TempContainer> pv(v);
-    foreachArray(*array, pv);
+    foreachArray(*array, start, size, pv);
 
     const size_t newelements = fn.nargs > 2 ? fn.nargs - 2 : 0;
     
     // Push removed elements to the new array.
     ObjectURI propPush = getURI(getVM(fn), NSV::PROP_PUSH);
     for (size_t i = 0; i < remove; ++i) {
-        const ObjectURI& key = getKey(fn, start + i);
-        callMethod(ret, propPush, getOwnProperty(*array, key));
+        callMethod(ret, propPush, getOwnElement(*array, start + i));
     }
 
     // Shift elements in 'this' array by simple assignment, not delete
-    // and readd.
-    for (size_t i = 0; i < static_cast<size_t>(size - remove); ++i) {
-        const bool started = (i >= static_cast<size_t>(start));
-        const size_t index = started ? i + remove : i;
-        const size_t target = started ? i + newelements : i;
-        array->set_member(getKey(fn, target), v[index]);
+    // and readd. The elements before the start offset stay where they
+    // are, and so do the ones after it if as many are inserted as removed.
+    if (remove != newelements) {
+        for (size_t i = start; i < static_cast<size_t>(size - remove); ++i) {
+            array->set_element(i + newelements, v[i + remove - start], size);
+        }
     }
 
     // Insert the replacement elements in the gap we left.
     for (size_t i = 0; i < newelements; ++i) {
-        array->set_member(getKey(fn, start + i), fn.arg(i + 2));
+        array->set_element(start + i, fn.arg(i + 2), size);
     }
     
     // This one is correct!
@@ -1115,7 +902,9 @@ array_sort(const fn_call& fn)
     as_object* array = ensure<ValidThis>(fn);
     
     if (!fn.nargs) {
-        sort(*array, as_value_lt(fn));
+        KeySort keys(*array, 0, fn);
+        keys.sort(false);
+        keys.store(*array);
         return as_value(array);
     }
     
@@ -1165,15 +954,11 @@ array_sort(const fn_call& fn)
 
     bool do_unique, do_index;
     flags = flag_preprocess(flags, &do_unique, &do_index);
-    as_cmp_fn comp = get_basic_cmp(flags, fn);
 
-    if (do_unique) {
-        as_cmp_fn eq = get_basic_eq(flags, fn);
-        if (do_index) return sortIndexed(*array, comp, eq);
-        return sort(*array, comp, eq) ? as_value(array) : as_value(0.0);
-    }
-    if (do_index) return sortIndexed(*array, comp);
-    sort(*array, comp);
+    KeySort keys(*array, flags, fn);
+    if (!keys.sort(do_unique)) return as_value(0.0);
+    if (do_index) return keys.indices(*array);
+    keys.store(*array);
     return as_value(array);
 }
 
@@ -1193,30 +978,18 @@ array_sortOn(const fn_call& fn)
     // cases: sortOn("prop) and sortOn("prop", Array.FLAG)
     if (fn.arg(0).is_string()) 
     {
-        ObjectURI propField =
-            getURI(vm, fn.arg(0).to_string(version));
+        const std::vector<ObjectURI> prp(1,
+                getURI(vm, fn.arg(0).to_string(version)));
 
         if (fn.nargs > 1 && fn.arg(1).is_number()) {
             flags = static_cast<std::uint8_t>(toNumber(fn.arg(1), getVM(fn)));
             flags = flag_preprocess(flags, &do_unique, &do_index);
         }
 
-        as_value_prop avc(propField, get_basic_cmp(flags, fn),
-                getGlobal(fn));
-
-        if (do_unique) {
-            as_value_prop ave(propField, get_basic_eq(flags, fn), 
-                    getGlobal(fn));
-            if (do_index)
-                return sortIndexed(*array, avc, ave);
-            return sort(*array, avc, ave) ? as_value(array) : as_value(0.0);
-        }
-        
-        if (do_index) {
-            return sortIndexed(*array, avc);
-        }
-
-        sort(*array, avc);
+        KeySort keys(*array, prp, std::vector<std::uint8_t>(1, flags), fn);
+        if (!keys.sort(do_unique)) return as_value(0.0);
+        if (do_index) return keys.indices(*array);
+        keys.store(*array);
         return as_value(array);
     }
 
@@ -1230,75 +1003,39 @@ array_sortOn(const fn_call& fn)
         GetKeys gk(prp, vm, version);
         foreachArray(*props, gk);
         
-        std::vector<as_cmp_fn> cmp;
-        std::vector<as_cmp_fn> eq;
-        
         // Will be the same as arrayLength(*props);
         const size_t optnum = prp.size();
-        
+
         // case: sortOn(["prop1", "prop2"])
-        if (fn.nargs == 1) {
-            // assign each cmp function to the standard cmp fn
-            as_cmp_fn c = get_basic_cmp(0, fn);
-            cmp.assign(optnum, c);
-        }
+        std::vector<std::uint8_t> flgs(optnum, 0);
+
         // case: sortOn(["prop1", "prop2"], [Array.FLAG1, Array.FLAG2])
-        else if (fn.arg(1).is_object()) {
+        if (fn.nargs > 1 && fn.arg(1).is_object()) {
 
             as_object* farray = toObject(fn.arg(1), getVM(fn));
 
             // Only an array will do for this case.
             if (farray->array() && arrayLength(*farray) == optnum) {
-
-                std::vector<std::uint8_t> flgs;
+                flgs.clear();
                 GetMultiFlags mf(flgs, fn);
                 foreachArray(*farray, mf);
                 do_unique = mf.unique();
                 do_index = mf.index();
-                
-                std::vector<std::uint8_t>::const_iterator it =
-                    flgs.begin();
-
-                while (it != flgs.end()) {
-                    cmp.push_back(get_basic_cmp(*it++, fn));
-                }
-
-                if (do_unique) {
-                    it = flgs.begin();
-                    while (it != flgs.end())
-                        eq.push_back(get_basic_eq(*it++, fn));
-                }
-            }
-            else {
-                as_cmp_fn c = get_basic_cmp(0, fn);
-                cmp.assign(optnum, c);
             }
         }
         // case: sortOn(["prop1", "prop2"], Array.FLAG)
-        else {
+        else if (fn.nargs > 1) {
             std::uint8_t flags =
                 static_cast<std::uint8_t>(toInt(fn.arg(1), getVM(fn)));
             flags = flag_preprocess(flags, &do_unique, &do_index);
-            as_cmp_fn c = get_basic_cmp(flags, fn);
-
-            cmp.assign(optnum, c);
-            
-            if (do_unique) {
-                as_cmp_fn e = get_basic_eq(flags, fn);
-                eq.assign(optnum, e);
-            }
+            flgs.assign(optnum, flags);
         }
-        as_value_multiprop avc(prp, cmp, getGlobal(fn));
 
-        if (do_unique) {
-            as_value_multiprop_eq ave(prp, eq, getGlobal(fn));
-            if (do_index) return sortIndexed(*array, avc, ave);
-            return sort(*array, avc, ave) ? as_value(array) : as_value(0.0);
-        }
-        if (do_index) return sortIndexed(*array, avc);
-        sort(*array, avc);
+        KeySort keys(*array, prp, flgs, fn);
+        if (!keys.sort(do_unique)) return as_value(0.0);
+        if (do_index) return keys.indices(*array);
+        keys.store(*array);
         return as_value(array);
-
     }
 
     IF_VERBOSE_ASCODING_ERRORS(
@@ -1321,7 +1058,7 @@ array_push(const fn_call& fn)
     const size_t size = arrayLength(*array);
 
     for (size_t i = 0; i < shift; ++i) {
-        array->set_member(getKey(fn, size + i), fn.arg(i));
+        array->set_element(size + i, fn.arg(i), size);
     }
  
     return as_value(size + shift);
@@ -1341,15 +1078,15 @@ array_unshift(const fn_call& fn)
     const size_t size = arrayLength(*array);
 
     for (size_t i = size + shift - 1; i >= shift ; --i) {
-        const ObjectURI nextkey = getKey(fn, i - shift);
         const ObjectURI currentkey = getKey(fn, i);
         array->delProperty(currentkey);
-        array->set_member(currentkey, getOwnProperty(*array, nextkey));
+        array->set_member(currentkey, getOwnElement(*array, i - shift));
     }
 
+    const size_t length = arrayLength(*array);
     for (size_t i = shift; i > 0; --i) {
         const size_t index = i - 1;
-        array->set_member(getKey(fn, index), fn.arg(index));
+        array->set_element(index, fn.arg(index), length);
     }
  
     setArrayLength(*array, size + shift);
@@ -1367,9 +1104,8 @@ array_pop(const fn_call& fn)
     const size_t size = arrayLength(*array);
     if (size < 1) return as_value();
 
-    const ObjectURI ind = getKey(fn, size - 1);
-    as_value ret = getOwnProperty(*array, ind);
-    array->delProperty(ind);
+    as_value ret = getOwnElement(*array, size - 1);
+    array->delProperty(getKey(fn, size - 1));
     
     setArrayLength(*array, size - 1);
 
@@ -1386,13 +1122,12 @@ array_shift(const fn_call& fn)
     // An array with no elements has nothing to return.
     if (size < 1) return as_value();
 
-    as_value ret = getOwnProperty(*array, getKey(fn, 0));
+    as_value ret = getOwnElement(*array, 0);
 
     for (size_t i = 0; i < static_cast<size_t>(size - 1); ++i) {
-        const ObjectURI nextkey = getKey(fn, i + 1);
         const ObjectURI currentkey = getKey(fn, i);
         array->delProperty(currentkey);
-        array->set_member(currentkey, getOwnProperty(*array, nextkey));
+        array->set_member(currentkey, getOwnElement(*array, i + 1));
     }
     
     setArrayLength(*array, size - 1);
@@ -1413,8 +1148,8 @@ array_reverse(const fn_call& fn)
     for (size_t i = 0; i < static_cast<size_t>(size) / 2; ++i) {
         const ObjectURI bottomkey = getKey(fn, i);
         const ObjectURI topkey = getKey(fn, size - i - 1);
-        const as_value top = getOwnProperty(*array, topkey);
-        const as_value bottom = getOwnProperty(*array, bottomkey);
+        const as_value top = getOwnElement(*array, size - i - 1);
+        const as_value bottom = getOwnElement(*array, i);
         array->delProperty(topkey);
         array->delProperty(bottomkey);
         array->set_member(bottomkey, top);
@@ -1554,13 +1289,11 @@ join(as_object* array, const std::string& separator)
 
     std::string s;
 
-    VM& vm = getVM(*array);
     const int version = getSWFVersion(*array);
 
     for (size_t i = 0; i < size; ++i) {
         if (i) s += separator;
-        const std::string& index = std::to_string(i);
-        const as_value& el = getOwnProperty(*array, getURI(vm, index));
+        const as_value& el = getOwnElement(*array, i);
         s += el.to_string(version);
     }
     return as_value(s);
@@ -1591,10 +1324,8 @@ void foreachArray(as_object& array, int start, int end, T& pred)
     assert(end >= start);
     assert(size >= end);
 
-    VM& vm = getVM(array);
-
     for (size_t i = start; i < static_cast<size_t>(end); ++i) {
-        pred(getOwnProperty(array, arrayKey(vm, i)));
+        pred(getOwnElement(array, i));
     }
 }
 
@@ -1641,12 +1372,25 @@ setArrayLength(as_object& array, const int size)
 int
 isIndex(const std::string& nameString)
 {
-    try {
-        return boost::lexical_cast<int>(nameString);
-    }
-    catch (boost::bad_lexical_cast& e) {
-        return -1;
+    // This is called for every member set on an Array, so it doesn't
+    // throw and catch an exception for every name that isn't a number.
+    std::string::const_iterator it = nameString.begin();
+    const std::string::const_iterator end = nameString.end();
+
+    const bool negative = (it != end && *it == '-');
+    if (it != end && (*it == '-' || *it == '+')) ++it;
+    if (it == end) return -1;
+
+    std::int64_t index = 0;
+    for (; it != end; ++it) {
+        if (*it < '0' || *it > '9') return -1;
+        index = index * 10 + (*it - '0');
+        if (index > std::numeric_limits<int>::max()) return -1;
     }
+
+    // "-0" is still 0, other negative numbers aren't indices.
+    if (negative && index) return -1;
+    return index;
 }
 
 } // anonymous namespace
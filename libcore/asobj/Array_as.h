@@ -80,10 +80,8 @@ void foreachArray(as_object& array, T& pred)
     size_t size = arrayLength(array);
     if (!size) return;
 
-    VM& vm = getVM(array);
-
     for (size_t i = 0; i < static_cast<size_t>(size); ++i) {
-        pred(getOwnProperty(array, arrayKey(vm, i)));
+        pred(getOwnElement(array, i));
     }
 }
 
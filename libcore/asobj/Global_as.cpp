@@ -236,12 +236,11 @@ Global_as::registerClasses()
 {
     registerNatives(*this);
 
+    // Every function and object needs these, so they aren't declared
+    // lazily with the other classes.
     function_class_init(*this, NSV::CLASS_FUNCTION);
     initObjectClass(_objectProto, *this, NSV::CLASS_OBJECT); 
 
-    string_class_init(*this, NSV::CLASS_STRING); 
-    array_class_init(*this, NSV::CLASS_ARRAY); 
-
     // No idea why, but it seems there's a NULL _global.o 
     // defined at player startup...
     // Probably due to the AS-based initialization 
@@ -344,6 +343,8 @@ avm1Classes()
     // considered to be in the 'Global' namespace (AVM1 has no namespaces)
     // An ObjectURI constructed without a namespace is in the global namespace.
     static const ClassHierarchy::NativeClasses s = {
+        N(string_class_init, NSV::CLASS_STRING, 1),
+        N(array_class_init, NSV::CLASS_ARRAY, 1),
         N(system_class_init, NSV::CLASS_SYSTEM, 1),
         N(stage_class_init, NSV::CLASS_STAGE, 1),
         N(movieclip_class_init, NSV::CLASS_MOVIE_CLIP, 3),
@@ -222,6 +222,8 @@ callMethod(fn_call::Args& args, as_object* obj, const ObjectURI& uri)
     as_value func;
     if (!obj->get_member(uri, &func)) return as_value();
 
+    if (Profiler* p = getVM(*obj).profiler()) p->calling(uri);
+
     return invoke(func, as_environment(getVM(*obj)), obj, args);
 }
 
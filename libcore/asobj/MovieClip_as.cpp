@@ -43,6 +43,7 @@
 #include "Renderer.h"
 #include "RunResources.h"
 #include "ASConversions.h"
+#include "flash/filters/BitmapFilter_as.h"
 
 namespace gnash {
 
@@ -359,8 +360,12 @@ as_value
 movieclip_cacheAsBitmap(const fn_call& fn)
 {
     MovieClip* movieclip = ensure<IsDisplayObject<MovieClip> >(fn);
-    UNUSED(movieclip);
-    LOG_ONCE( log_unimpl(_("MovieClip.cacheAsBitmap()")) );
+
+    if (!fn.nargs) {
+        return as_value(movieclip->cacheAsBitmap());
+    }
+
+    movieclip->setCacheAsBitmap(toBool(fn.arg(0), getVM(fn)));
     return as_value();
 }
 
@@ -369,19 +374,14 @@ as_value
 movieclip_filters(const fn_call& fn)
 {
     MovieClip* movieclip = ensure<IsDisplayObject<MovieClip> >(fn);
-    
-    UNUSED(movieclip);
-
-    LOG_ONCE(log_unimpl(_("MovieClip.filters()")));
 
     if (!fn.nargs) {
-        // Getter
-        Global_as& gl = getGlobal(fn);
-        as_object* array = gl.createArray();
-        return as_value(array);
+        // Getter: copies, so changing them needs the setter.
+        return as_value(fromFilters(movieclip->filters().get(), fn.env()));
     }
 
     // Setter
+    movieclip->setFilters(toFilters(fn.arg(0), getVM(fn)));
     return as_value();
 }
 
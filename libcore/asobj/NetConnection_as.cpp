@@ -45,6 +45,7 @@
 #include "Global_as.h"
 #include "AMFConverter.h"
 #include "AMF.h"
+#include "AMFStream.h"
 #include "as_function.h"
 #include "RunResources.h"
 #include "IOChannel.h"
@@ -1291,15 +1292,18 @@ RTMPConnection::handleInvoke(const std::uint8_t* payload,
     }
 
     ++payload;
-    std::string method = amf::readString(payload, end);
+
+    // The method name is only copied if it turns out to be a call to
+    // an ActionScript method.
+    amf::StreamReader sr(payload, end);
+    const amf::StringRef method = sr.readPlainString();
+    payload = sr.pos();
 
     log_debug("Invoke: read method string %s", method);
-    if (*payload != amf::NUMBER_AMF0) return;
+    if (payload == end || *payload != amf::NUMBER_AMF0) return;
     ++payload;
 
     log_debug("Server invoking <%s>", method);
-    
-    const ObjectURI methodname = getURI(getVM(_nc.owner()), method);
 
     // _result means it's the answer to a remote method call initiated
     // by us.
@@ -1380,6 +1384,7 @@ RTMPConnection::handleInvoke(const std::uint8_t* payload,
     }
     
     // Call method on the NetConnection object.    
+    const ObjectURI methodname = getURI(getVM(_nc.owner()), method.str());
     callMethod(&_nc.owner(), methodname, arg);
     
 }
@@ -1388,10 +1393,8 @@ void
 replyBWCheck(rtmp::RTMP& r, double txn)
 {
     SimpleBuffer buf;
-    amf::write(buf, "_result");
-    amf::write(buf, txn);
-    buf.appendByte(amf::NULL_AMF0);
-    amf::write(buf, 0.0);
+    amf::StreamWriter<SimpleBuffer> w(buf);
+    w.string("_result").number(txn).null().number(0.0);
     r.call(buf);
 }
 
@@ -69,11 +69,11 @@ namespace {
             const std::string& function);
 
     inline int getStringVersioned(const fn_call& fn, const as_value& arg,
-            std::string& str);
+            SharedString& str);
 
 }
 
-String_as::String_as(std::string s)
+String_as::String_as(SharedString s)
     :
     _string(std::move(s))
 {
@@ -154,11 +154,11 @@ string_concat(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
 
-    std::string str;
+    SharedString str;
     const int version = getStringVersioned(fn, val, str);
 
     for (size_t i = 0; i < fn.nargs; i++) {
-        str += fn.arg(i).to_string(version);
+        str.append(fn.arg(i).to_string(version));
     }
 
     return as_value(str);
@@ -171,10 +171,11 @@ string_slice(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    SharedString str;
     const int version = getStringVersioned(fn, val, str);
 
-    std::wstring wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const std::wstring> chars = str.wide(version);
+    const std::wstring& wstr = *chars;
 
     if (!checkArgs(fn, 1, 2, "String.slice()")) return as_value();
 
@@ -226,10 +227,11 @@ string_split(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    SharedString str;
     const int version = getStringVersioned(fn, val, str);
     
-    std::wstring wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const std::wstring> chars = str.wide(version);
+    const std::wstring& wstr = *chars;
 
     Global_as& gl = getGlobal(fn);
     as_object* array = gl.createArray();
@@ -341,9 +343,10 @@ string_lastIndexOf(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    SharedString str;
     const int version = getStringVersioned(fn, val, str);
-    const std::wstring& wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const std::wstring> chars = str.wide(version);
+    const std::wstring& wstr = *chars;
 
     if (!checkArgs(fn, 1, 2, "String.lastIndexOf()")) return as_value(-1);
 
@@ -379,10 +382,11 @@ string_substr(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    SharedString str;
     const int version = getStringVersioned(fn, val, str);
 
-    std::wstring wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const std::wstring> chars = str.wide(version);
+    const std::wstring& wstr = *chars;
 
     if (!checkArgs(fn, 1, 2, "String.substr()")) return as_value(str);
     
@@ -417,10 +421,11 @@ string_substring(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    SharedString str;
     const int version = getStringVersioned(fn, val, str);
 
-    const std::wstring& wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const std::wstring> chars = str.wide(version);
+    const std::wstring& wstr = *chars;
 
     if (!checkArgs(fn, 1, 2, "String.substring()")) return as_value(str);
 
@@ -471,12 +476,13 @@ string_indexOf(const fn_call& fn)
  
     /// Do not return before this, because the toString method should always
     /// be called. (TODO: test).   
-    std::string str;
+    SharedString str;
     const int version = getStringVersioned(fn, val, str);
 
     if (!checkArgs(fn, 1, 2, "String.indexOf")) return as_value(-1);
 
-    const std::wstring& wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const std::wstring> chars = str.wide(version);
+    const std::wstring& wstr = *chars;
 
     const as_value& tfarg = fn.arg(0); // to find arg
     const std::wstring& toFind =
@@ -559,10 +565,11 @@ string_charCodeAt(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    SharedString str;
     const int version = getStringVersioned(fn, val, str);
 
-    const std::wstring& wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const std::wstring> chars = str.wide(version);
+    const std::wstring& wstr = *chars;
 
     if (fn.nargs == 0) {
         IF_VERBOSE_ASCODING_ERRORS(
@@ -595,7 +602,7 @@ string_charAt(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    SharedString str;
     const int version = getStringVersioned(fn, val, str);
 
     if (!checkArgs(fn, 1, 1, "String.charAt()")) return as_value("");
@@ -603,9 +610,16 @@ string_charAt(const fn_call& fn)
     // to_int() makes this safe from overflows.
     const size_t index = static_cast<size_t>(toInt(fn.arg(0), getVM(fn)));
 
+    if (version > 5) {
+        const std::shared_ptr<const std::wstring> chars = str.wide(version);
+        if (index >= chars->size()) return as_value("");
+        return as_value(utf8::encodeUnicodeCharacter((*chars)[index]));
+    }
+
     size_t currentIndex = 0;
 
-    std::string::const_iterator it = str.begin(), e = str.end();
+    const std::string chars = str.str();
+    std::string::const_iterator it = chars.begin(), e = chars.end();
 
     while (std::uint32_t code = utf8::decodeNextUnicodeCharacter(it, e))
     {
@@ -629,10 +643,10 @@ string_toUpperCase(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
 
-    std::string str;
+    SharedString str;
     const int version = getStringVersioned(fn, val, str);
 
-    std::wstring wstr = utf8::decodeCanonicalString(str, version);
+    std::wstring wstr = *str.wide(version);
 
 #if !defined(__HAIKU__) && !defined(__amigaos4__) && !defined(__ANDROID__)
     static const std::locale swfLocale((std::locale()), new SWFCtype());
@@ -655,10 +669,10 @@ string_toLowerCase(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    SharedString str;
     const int version = getStringVersioned(fn, val, str);
 
-    std::wstring wstr = utf8::decodeCanonicalString(str, version);
+    std::wstring wstr = *str.wide(version);
 
 #if !defined(__HAIKU__) && !defined(__amigaos4__) && !defined(__ANDROID__)
     static const std::locale swfLocale((std::locale()), new SWFCtype());
@@ -721,10 +735,10 @@ string_ctor(const fn_call& fn)
 {
     const int version = getSWFVersion(fn);
 
-    std::string str;
+    SharedString str;
 
     if (fn.nargs) {
-        str = fn.arg(0).to_string(version);
+        str = fn.arg(0).to_shared_string(version);
     }
 
     if (!fn.isInstantiation())
@@ -735,14 +749,14 @@ string_ctor(const fn_call& fn)
     as_object* obj = fn.this_ptr;
 
     obj->setRelay(new String_as(str));
-    std::wstring wstr = utf8::decodeCanonicalString(str, getSWFVersion(fn));
-    obj->init_member(NSV::PROP_LENGTH, wstr.size(), as_object::DefaultFlags);
+    obj->init_member(NSV::PROP_LENGTH, str.wide(version)->size(),
+            as_object::DefaultFlags);
 
     return as_value();
 }
     
 inline int
-getStringVersioned(const fn_call& fn, const as_value& val, std::string& str)
+getStringVersioned(const fn_call& fn, const as_value& val, SharedString& str)
 {
 
     /// version to use is the one of the SWF containing caller code.
@@ -759,7 +773,7 @@ getStringVersioned(const fn_call& fn, const as_value& val, std::string& str)
     const int version = fn.callerDef ? fn.callerDef->get_version() :
         getSWFVersion(fn);
     
-    str = val.to_string(version);
+    str = val.to_shared_string(version);
 
     return version;
 
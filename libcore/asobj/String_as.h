@@ -23,6 +23,7 @@
 
 #include <string>
 #include "Relay.h"
+#include "SharedString.h"
 
 namespace gnash {
 
@@ -35,14 +36,14 @@ class String_as : public Relay
 
 public:
 
-    explicit String_as(std::string s);
+    explicit String_as(SharedString s);
 
-    const std::string& value() {
+    const SharedString& value() {
         return _string;
     }
 
 private:
-    std::string _string;
+    SharedString _string;
 };
 
 /// Initialize the global String class
@@ -24,8 +24,10 @@
 #include <sstream>
 #include <vector>
 #include <algorithm>
+#include <limits>
 
 #include "XML_as.h"
+#include "XMLParser.h"
 #include "VM.h"
 #include "log.h"
 #include "fn_call.h"
@@ -43,8 +45,6 @@ namespace gnash {
 namespace {
     typedef std::pair<std::string, std::string> StringPair;
     typedef std::vector<StringPair> StringPairs;
-    void enumerateAttributes(const XMLNode_as& node,
-            StringPairs& attributes);
     bool prefixMatches(const StringPairs::value_type& val,
             const std::string& prefix);
     bool namespaceMatches(
@@ -81,8 +81,9 @@ XMLNode_as::XMLNode_as(Global_as& gl)
     _global(gl),
     _object(nullptr),
     _parent(nullptr),
-    _attributes(new as_object(gl)),
+    _attributes(nullptr),
     _childNodes(nullptr),
+    _parsedNode(0),
     _type(Element)
 {
 }
@@ -92,14 +93,16 @@ XMLNode_as::XMLNode_as(const XMLNode_as& tpl, bool deep)
     _global(tpl._global),
     _object(nullptr),
     _parent(nullptr),
-    _attributes(new as_object(_global)),
+    _attributes(nullptr),
     _childNodes(nullptr),
+    _parsedNode(0),
     _name(tpl._name),
     _value(tpl._value),
     _type(tpl._type)
 {
     // only clone children if in deep mode
     if (deep) {
+        tpl.makeChildren();
         const Children& from=tpl._children;
         for (const auto& child : from) {
             XMLNode_as* copy = new XMLNode_as(*child, deep);
@@ -109,6 +112,25 @@ XMLNode_as::XMLNode_as(const XMLNode_as& tpl, bool deep)
     }
 }
 
+XMLNode_as::XMLNode_as(Global_as& gl,
+        std::shared_ptr<const XMLParser> parsed, std::uint32_t node)
+    :
+    _global(gl),
+    _object(nullptr),
+    _parent(nullptr),
+    _attributes(nullptr),
+    _childNodes(nullptr),
+    _parsedNode(node)
+{
+    const XMLParser::Node& n = parsed->node(node);
+    _name = parsed->text(n.name);
+    _value = parsed->text(n.value);
+    _type = n.type;
+    _namespaceURI = parsed->text(n.namespaceURI);
+    if (n.attributeCount) _parsedAttributes = parsed;
+    if (n.firstChild) _parsedChildren = std::move(parsed);
+}
+
 XMLNode_as::~XMLNode_as()
 {
     // In practice it is quite likely that the child will be garbage-collected
@@ -174,6 +196,7 @@ XMLNode_as::updateChildNodes()
 as_object*
 XMLNode_as::childNodes()
 {
+    makeChildren();
     if (!_childNodes) {
         _childNodes = _global.createArray();
         updateChildNodes();
@@ -184,12 +207,14 @@ XMLNode_as::childNodes()
 bool
 XMLNode_as::hasChildNodes() const
 {
+    makeChildren();
     return !_children.empty();
 }
 
 XMLNode_as*
 XMLNode_as::firstChild() const
 {
+    makeChildren();
     if (_children.empty()) return nullptr;
     return _children.front();
 }
@@ -204,6 +229,7 @@ XMLNode_as::cloneNode(bool deep) const
 XMLNode_as*
 XMLNode_as::lastChild() const
 {
+    makeChildren();
 	if (_children.empty()) {
         return nullptr;
 	}
@@ -213,6 +239,7 @@ XMLNode_as::lastChild() const
 void
 XMLNode_as::removeChild(XMLNode_as* node)
 {
+    makeChildren();
     node->setParent(nullptr);
     _children.remove(node);
     updateChildNodes();
@@ -222,6 +249,7 @@ void
 XMLNode_as::appendChild(XMLNode_as* node)
 {
     assert(node);
+    makeChildren();
     node->setParent(this);
     _children.push_back(node);
     updateChildNodes();
@@ -245,6 +273,7 @@ void
 XMLNode_as::insertBefore(XMLNode_as* newnode, XMLNode_as* pos)
 {
     assert(_object);
+    makeChildren();
 
 	// find iterator for positional parameter
     Children::iterator it = std::find(_children.begin(), _children.end(), pos);
@@ -309,15 +338,64 @@ XMLNode_as::toString(std::ostream& xmlout, bool encode) const
     stringify(*this, xmlout, encode);
 }
 
+as_object*
+XMLNode_as::getAttributes() const
+{
+    if (_attributes) return _attributes;
+
+    _attributes = new as_object(_global);
+    if (!_parsedAttributes) return _attributes;
+
+    std::shared_ptr<const XMLParser> parsed;
+    parsed.swap(_parsedAttributes);
+
+    VM& vm = getVM(_global);
+    const XMLParser::Node& n = parsed->node(_parsedNode);
+    for (std::uint32_t i = 0; i < n.attributeCount; ++i) {
+        const XMLParser::Attribute& a = parsed->attribute(n.attributes + i);
+        _attributes->set_member(getURI(vm, parsed->text(a.name)),
+                parsed->text(a.value));
+    }
+    return _attributes;
+}
+
 void
-XMLNode_as::setAttribute(const std::string& name, const std::string& value)
+XMLNode_as::enumerateAttributes(StringPairs& pairs) const
 {
-    if (_attributes) {
-        VM& vm = getVM(_global);
-        _attributes->set_member(getURI(vm, name), value);
+    pairs.clear();
+
+    // Attributes still in the parsed document are listed in the order
+    // they would be set, and the object's properties print last first.
+    if (!_attributes) {
+        if (!_parsedAttributes) return;
+        const XMLParser& parsed = *_parsedAttributes;
+        const XMLParser::Node& n = parsed.node(_parsedNode);
+        for (std::uint32_t i = n.attributeCount; i > 0; --i) {
+            const XMLParser::Attribute& a =
+                parsed.attribute(n.attributes + i - 1);
+            pairs.push_back(std::make_pair(parsed.text(a.name),
+                        parsed.text(a.value)));
+        }
+        return;
+    }
+
+    string_table& st = getStringTable(*_attributes);
+    SortedPropertyList attrs = enumerateProperties(*_attributes);
+    for (SortedPropertyList::const_reverse_iterator i = attrs.rbegin(), 
+            e = attrs.rend(); i != e; ++i) {
+        // TODO: second argument should take version.
+        pairs.push_back(
+            std::make_pair(i->first.toString(st), i->second.to_string()));
     }
 }
 
+void
+XMLNode_as::setAttribute(const std::string& name, const std::string& value)
+{
+    VM& vm = getVM(_global);
+    getAttributes()->set_member(getURI(vm, name), value);
+}
+
 bool
 XMLNode_as::getPrefixForNamespace(const std::string& ns, std::string& prefix)
     const
@@ -327,7 +405,7 @@ XMLNode_as::getPrefixForNamespace(const std::string& ns, std::string& prefix)
     StringPairs attrs;
     
     while (node) {
-        enumerateAttributes(*node, attrs);
+        node->enumerateAttributes(attrs);
         if (!attrs.empty())
         {
             it = std::find_if(attrs.begin(), attrs.end(), 
@@ -366,7 +444,7 @@ XMLNode_as::getNamespaceForPrefix(const std::string& prefix, std::string& ns)
     
     while (node) {
 
-        enumerateAttributes(*node, attrs);
+        node->enumerateAttributes(attrs);
 
         if (!attrs.empty()) {
 
@@ -400,9 +478,72 @@ XMLNode_as::extractPrefix(std::string& prefix) const
     return true;
 }
 
+void
+XMLNode_as::setParsed(std::shared_ptr<const XMLParser> parsed)
+{
+    assert(_children.empty());
+    _parsedNode = 0;
+    if (parsed->node(0).firstChild) _parsedChildren = std::move(parsed);
+}
+
+void
+XMLNode_as::makeChildren() const
+{
+    if (!_parsedChildren) return;
+
+    std::shared_ptr<const XMLParser> parsed;
+    parsed.swap(_parsedChildren);
+
+    XMLNode_as* self = const_cast<XMLNode_as*>(this);
+    for (std::uint32_t i = parsed->node(_parsedNode).firstChild; i;
+            i = parsed->node(i).nextSibling) {
+        XMLNode_as* child = new XMLNode_as(_global, parsed, i);
+        child->setParent(self);
+        _children.push_back(child);
+    }
+}
+
+void
+XMLNode_as::makeParsed(const std::vector<std::uint32_t>& indices,
+        std::vector<XMLNode_as*>& nodes)
+{
+    std::vector<std::uint32_t>::const_iterator it = indices.begin();
+    makeParsed(it, indices.end(), std::numeric_limits<std::uint32_t>::max(),
+            nodes);
+}
+
+void
+XMLNode_as::makeParsed(std::vector<std::uint32_t>::const_iterator& it,
+        const std::vector<std::uint32_t>::const_iterator end,
+        std::uint32_t bound, std::vector<XMLNode_as*>& nodes)
+{
+    makeChildren();
+
+    // The nodes under a child are the ones parsed after it and before its
+    // next sibling.
+    for (Children::const_iterator i = _children.begin(), e = _children.end();
+            i != e && it != end && *it < bound; ++i) {
+
+        XMLNode_as* child = *i;
+        const Children::const_iterator next = std::next(i);
+        const std::uint32_t childBound =
+            next == e ? bound : (*next)->_parsedNode;
+
+        if (*it == child->_parsedNode) {
+            nodes.push_back(child);
+            ++it;
+        }
+        if (it != end && *it < childBound) {
+            child->makeParsed(it, end, childBound, nodes);
+        }
+    }
+}
+
 void
 XMLNode_as::clearChildren()
 {
+    _parsedChildren.reset();
+
     for (XMLNode_as* node : _children) {
 
         node->setParent(nullptr);
@@ -438,7 +579,7 @@ XMLNode_as::stringify(const XMLNode_as& xml, std::ostream& xmlout, bool encode)
 
         // Process the attributes, if any
         StringPairs attrs;
-        enumerateAttributes(xml, attrs);
+        xml.enumerateAttributes(attrs);
         if (!attrs.empty()) {
 
             for (auto& attr : attrs) { 
@@ -448,6 +589,7 @@ XMLNode_as::stringify(const XMLNode_as& xml, std::ostream& xmlout, bool encode)
         }
 
         // If the node has no content, just close the tag now
+        xml.makeChildren();
         if (nodeValue.empty() && xml._children.empty()) {
             xmlout << " />";
             return;
@@ -474,6 +616,7 @@ XMLNode_as::stringify(const XMLNode_as& xml, std::ostream& xmlout, bool encode)
     }
 
     // Childs, after node as_value.
+    xml.makeChildren();
     for (XMLNode_as* child : xml._children) {
 
         child->toString(xmlout, encode);
@@ -1028,25 +1171,6 @@ xmlnode_childNodes(const fn_call& fn)
 }
 
 
-void
-enumerateAttributes(const XMLNode_as& node, StringPairs& pairs)
-{
-    pairs.clear();
-
-    as_object* obj = node.getAttributes();
-    if (obj) {
-        string_table& st = getStringTable(*obj);
-        SortedPropertyList attrs = enumerateProperties(*obj);
-        for (SortedPropertyList::const_reverse_iterator i = attrs.rbegin(), 
-                e = attrs.rend(); i != e; ++i) {
-            // TODO: second argument should take version.
-            pairs.push_back(
-                std::make_pair(i->first.toString(st), i->second.to_string()));
-        }
-    }
-
-}
-
 /// Return true if this attribute is a namespace specifier and the
 /// namespace matches.
 bool
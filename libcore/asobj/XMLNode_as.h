@@ -22,6 +22,9 @@
 
 #include <list>
 #include <string>
+#include <memory>
+#include <vector>
+#include <cstdint>
 #include <cassert>
 
 #include "Relay.h"
@@ -30,6 +33,7 @@ namespace gnash {
     class as_object;
     class Global_as;
     struct ObjectURI;
+    class XMLParser;
 }
 
 namespace gnash {
@@ -50,6 +54,8 @@ namespace gnash {
 /// 5. When an XMLNode is destroyed, any children without an associated object
 ///    are also deleted. Children with an associated object will be destroyed
 ///    when the GC destroys the object.
+/// 6. The children and attributes of a parsed node are only made from the
+///    parsed document when they are first needed.
 class XMLNode_as : public Relay
 {
 public:
@@ -73,7 +79,10 @@ public:
 
     virtual ~XMLNode_as();
 
-    size_t length() const { return _children.size(); }
+    size_t length() const {
+        makeChildren();
+        return _children.size();
+    }
 
     const std::string& nodeName() const { return _name; }
 
@@ -190,7 +199,15 @@ public:
     virtual void toString(std::ostream& str, bool encode = false) const;
 
     /// Return the attributes object associated with this node.
-    as_object* getAttributes() const { return _attributes; }
+    //
+    /// The object is made when it is first needed.
+    as_object* getAttributes() const;
+
+    /// Get the names and values of the attributes, in the order they print.
+    //
+    /// This doesn't make the attributes object if it isn't made yet.
+    void enumerateAttributes(
+            std::vector<std::pair<std::string, std::string> >& pairs) const;
 
     /// Set a named attribute to a value.
     //
@@ -231,6 +248,18 @@ protected:
     /// the GC will remove them on the next run.
     void clearChildren();
 
+    /// Make this node's children from a parsed document when needed.
+    //
+    /// @param parsed   The document, whose first node is this one.
+    void setParsed(std::shared_ptr<const XMLParser> parsed);
+
+    /// Make parsed nodes now, and the nodes above them.
+    //
+    /// @param indices  The nodes under this one, in the order parsed.
+    /// @param nodes    The nodes made are added to this.
+    void makeParsed(const std::vector<std::uint32_t>& indices,
+            std::vector<XMLNode_as*>& nodes);
+
 private:
 
     /// Set the parent XMLNode_as of this node.
@@ -248,16 +277,42 @@ private:
     /// A non-trivial copy-constructor for cloning nodes.
     XMLNode_as(const XMLNode_as &node, bool deep);
 
-    Children _children;
+    /// A node of a parsed document.
+    XMLNode_as(Global_as& gl, std::shared_ptr<const XMLParser> parsed,
+            std::uint32_t node);
+
+    /// Make the children of the parsed node, if they are not made yet.
+    void makeChildren() const;
+
+    /// Make the parsed nodes from the children on, up to the node before
+    /// bound.
+    void makeParsed(std::vector<std::uint32_t>::const_iterator& it,
+            std::vector<std::uint32_t>::const_iterator end,
+            std::uint32_t bound, std::vector<XMLNode_as*>& nodes);
+
+    /// Made from _parsedChildren when first needed.
+    mutable Children _children;
 
     as_object* _object;
 
     XMLNode_as* _parent;
 
-    as_object* _attributes;
+    /// Made, with any attributes in _parsedAttributes, when first needed.
+    mutable as_object* _attributes;
 
     as_object* _childNodes;
 
+    /// The document this node was parsed from, while its children are
+    /// still to be made from it.
+    mutable std::shared_ptr<const XMLParser> _parsedChildren;
+
+    /// The document this node was parsed from, while its attributes are
+    /// still to be made from it.
+    mutable std::shared_ptr<const XMLParser> _parsedAttributes;
+
+    /// This node in the parsed document.
+    std::uint32_t _parsedNode;
+
     std::string _name;
 
     std::string _value;
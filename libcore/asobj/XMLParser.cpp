@@ -0,0 +1,514 @@
+// XMLParser.cpp:  Parse XML as it arrives, for Gnash.
+//
+//   Copyright (C) 2009, 2010, 2011, 2012 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#include "XMLParser.h"
+
+#include <algorithm>
+#include <string>
+#include <boost/algorithm/string/compare.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include "StringPredicates.h"
+
+namespace gnash {
+
+namespace {
+
+    typedef std::string::const_iterator xml_iterator;
+
+    bool textAfterWhitespace(xml_iterator& it, xml_iterator end);
+    bool textMatch(xml_iterator& it, xml_iterator end,
+            const std::string& match, bool advance = true);
+}
+
+XMLParser::XMLParser(bool ignoreWhite)
+    :
+    _ignoreWhite(ignoreWhite),
+    _parsed(0),
+    _finished(false),
+    _status(XML_as::XML_OK),
+    _open(1, Open(0, 0))
+{
+    // The document.
+    _nodes.push_back(Node());
+    Node& document = _nodes.back();
+    document.type = XMLNode_as::Element;
+    document.firstChild = 0;
+    document.nextSibling = 0;
+    document.attributes = 0;
+    document.attributeCount = 0;
+}
+
+void
+XMLParser::parse(const char* data, size_t size)
+{
+    if (_finished) return;
+    _input.append(data, size);
+    parseInput();
+}
+
+void
+XMLParser::finish()
+{
+    if (_finished) return;
+    _finished = true;
+    parseInput();
+
+    std::string().swap(_input);
+    std::vector<Open>().swap(_open);
+    _tagAttributes.clear();
+}
+
+void
+XMLParser::parseInput()
+{
+    const xml_iterator begin = _input.begin();
+    const xml_iterator end = _input.end();
+    xml_iterator it = begin + _parsed;
+
+    while (it != end && _status == XML_as::XML_OK) {
+        xml_iterator next = it;
+        if (!parseNext(next, end)) break;
+        it = next;
+    }
+    _parsed = it - begin;
+
+    // If everything parsed correctly, check that we've got back to the
+    // document. If not, there is a missing closing tag.
+    if (_finished && _status == XML_as::XML_OK && _open.size() > 1) {
+        _status = XML_as::XML_MISSING_CLOSE_TAG;
+    }
+}
+
+bool
+XMLParser::parseNext(xml_iterator& it, const xml_iterator end)
+{
+    if (*it != '<') return parseText(it, end);
+
+    // Wait for enough to know what sort of tag this is; "<![CDATA[" is
+    // the longest.
+    if (!_finished && end - it < 9) return false;
+
+    ++it;
+    if (textMatch(it, end, "!DOCTYPE", false)) {
+        // We should not advance past the DOCTYPE label, as
+        // the case is preserved.
+        return parseDocTypeDecl(it, end);
+    }
+    if (textMatch(it, end, "?xml", false)) {
+        // We should not advance past the xml label, as
+        // the case is preserved.
+        return parseXMLDecl(it, end);
+    }
+    if (textMatch(it, end, "!--")) return parseComment(it, end);
+    if (textMatch(it, end, "![CDATA[")) return parseCData(it, end);
+    return parseTag(it, end);
+}
+
+bool
+XMLParser::unterminated(XML_as::ParseStatus status)
+{
+    if (!_finished) return false;
+    _status = status;
+    return true;
+}
+
+// The iterator should be pointing to the first char after the '<'
+bool
+XMLParser::parseTag(xml_iterator& it, const xml_iterator end)
+{
+    const bool closing = (*it == '/');
+    if (closing) ++it;
+
+    // These are for terminating the tag name, not (necessarily) the tag.
+    const std::string terminators("\r\n\t >");
+
+    xml_iterator endName = std::find_first_of(it, end, terminators.begin(),
+            terminators.end());
+
+    // Check that one of the terminators was found; otherwise it's malformed.
+    if (endName == end) return unterminated(XML_as::XML_UNTERMINATED_ELEMENT);
+
+    // Knock off the "/>" of a self-closing tag.
+    if (std::equal(endName - 1, endName + 1, "/>")) {
+        // This can leave endName before it, e.g when a self-closing tag is
+        // empty ("</>").
+        --endName;
+    }
+
+    // If the tag is empty, the XML counts as malformed.
+    if (it >= endName) {
+        _status = XML_as::XML_UNTERMINATED_ELEMENT;
+        return true;
+    }
+
+    const boost::iterator_range<xml_iterator> tagName(it, endName);
+
+    if (!closing) {
+
+        // Skip to the end of any whitespace after the tag name
+        it = endName;
+
+        if (!textAfterWhitespace(it, end)) {
+            return unterminated(XML_as::XML_UNTERMINATED_ELEMENT);
+        }
+
+        // Parse any attributes in an opening tag only, stopping at "/>" or
+        // '>'
+        _tagAttributes.clear();
+        std::string ns;
+        while (*it != '>') {
+            if (end - it > 1 && std::equal(it, it + 2, "/>")) break;
+
+            // This advances the iterator
+            if (!parseAttribute(ns, it, end)) return false;
+            if (_status != XML_as::XML_OK) return true;
+
+            // Skip any whitespace. If we reach the end of the string,
+            // it's malformed.
+            if (!textAfterWhitespace(it, end)) {
+                return unterminated(XML_as::XML_UNTERMINATED_ELEMENT);
+            }
+        }
+
+        const Index node = addNode(XMLNode_as::Element,
+                addText(tagName.begin(), tagName.end(), false), Text());
+        _nodes[node].namespaceURI = addText(ns.begin(), ns.end(), false);
+
+        // Attributes are added in reverse order, and, as they are unique
+        // ignoring case, have the order of a map ignoring case.
+        std::sort(_tagAttributes.begin(), _tagAttributes.end(),
+                [](const std::pair<std::string, std::string>& a,
+                    const std::pair<std::string, std::string>& b) {
+                    return StringNoCaseLessThan()(b.first, a.first);
+                });
+
+        for (const auto& attr : _tagAttributes) {
+            Attribute a;
+            a.name = addText(attr.first.begin(), attr.first.end(), false);
+            a.value = addText(attr.second.begin(), attr.second.end(), false);
+            _attributes.push_back(a);
+            if (attr.first == "id") _ids.push_back(Id(node, a.value));
+        }
+        _nodes[node].attributeCount = _tagAttributes.size();
+
+        if (*it == '/') ++it;
+        else _open.push_back(Open(node, 0));
+
+        if (*it == '>') ++it;
+
+        return true;
+    }
+
+    // If we reach here, this is a closing tag.
+
+    it = std::find(endName, end, '>');
+
+    if (it == end) return unterminated(XML_as::XML_UNTERMINATED_ELEMENT);
+    ++it;
+
+    const auto nameOf = [this](const Open& o) {
+        const Text& t = _nodes[o.first].name;
+        return boost::make_iterator_range(_strings.begin() + t.start,
+                _strings.begin() + t.start + t.size);
+    };
+
+    if (_open.size() > 1 && boost::iequals(nameOf(_open.back()), tagName)) {
+        _open.pop_back();
+        return true;
+    }
+
+    // Malformed. Search for the parent node.
+    const bool open = std::any_of(_open.begin(), _open.end(),
+            [&nameOf, &tagName](const Open& o) {
+                return boost::iequals(nameOf(o), tagName);
+            });
+
+    // If there's a parent, the open tag is orphaned. If not, the close
+    // tag is orphaned.
+    _status = open ? XML_as::XML_MISSING_CLOSE_TAG :
+        XML_as::XML_MISSING_OPEN_TAG;
+    return true;
+}
+
+bool
+XMLParser::parseAttribute(std::string& ns, xml_iterator& it,
+        const xml_iterator end)
+{
+    const std::string terminators("\r\t\n >=");
+
+    xml_iterator ourend = std::find_first_of(it, end,
+            terminators.begin(), terminators.end());
+
+    if (ourend == end) return unterminated(XML_as::XML_UNTERMINATED_ELEMENT);
+
+    if (ourend == it) {
+        _status = XML_as::XML_UNTERMINATED_ELEMENT;
+        return true;
+    }
+    std::string name(it, ourend);
+
+    // Point iterator to the character after the name.
+    it = ourend;
+
+    // Skip any whitespace before the '='. If we reach the end of the string
+    // or don't find an '=', it's a parser error.
+    if (!textAfterWhitespace(it, end)) {
+        return unterminated(XML_as::XML_UNTERMINATED_ELEMENT);
+    }
+    if (*it != '=') {
+        _status = XML_as::XML_UNTERMINATED_ELEMENT;
+        return true;
+    }
+
+    // Point to the character after the '='
+    ++it;
+
+    // Skip any whitespace. If we reach the end of the string, or don't find
+    // a " or ', it's a parser error.
+    if (!textAfterWhitespace(it, end)) {
+        return unterminated(XML_as::XML_UNTERMINATED_ELEMENT);
+    }
+    if (*it != '"' && *it != '\'') {
+        _status = XML_as::XML_UNTERMINATED_ELEMENT;
+        return true;
+    }
+
+    // Find the end of the attribute, looking for the opening character,
+    // as long as it's not escaped.
+    ourend = it;
+    do {
+        ++ourend;
+        ourend = std::find(ourend, end, *it);
+    } while (ourend != end && *(ourend - 1) == '\\');
+
+    if (ourend == end) {
+        return unterminated(XML_as::XML_UNTERMINATED_ATTRIBUTE);
+    }
+    ++it;
+
+    std::string value(it, ourend);
+
+    // Replace entities in the value.
+    if (value.find('&') != std::string::npos) unescapeXML(value);
+
+    // Advance past the last attribute character
+    it = ourend + 1;
+
+    // Handle namespace. This is set once only for each node, and is also
+    // pushed to the attributes list once.
+    StringNoCaseEqual noCaseCompare;
+    if (noCaseCompare(name, "xmlns") || noCaseCompare(name, "xmlns:")) {
+        if (!ns.empty()) return true;
+        ns = value;
+    }
+
+    // Values are not inserted twice, which is expected behaviour.
+    for (const auto& attr : _tagAttributes) {
+        if (noCaseCompare(attr.first, name)) return true;
+    }
+    _tagAttributes.push_back(std::make_pair(name, value));
+    return true;
+}
+
+/// Parse and set the docTypeDecl. This is stored without any validation and
+/// with the same case as in the parsed XML.
+bool
+XMLParser::parseDocTypeDecl(xml_iterator& it, const xml_iterator end)
+{
+    xml_iterator ourend;
+    xml_iterator current = it;
+
+    std::string::size_type count = 1;
+
+    // Look for angle brackets in the doctype declaration.
+    while (count) {
+
+        // Find the next closing bracket after the current position.
+        ourend = std::find(current, end, '>');
+        if (ourend == end) {
+            return unterminated(XML_as::XML_UNTERMINATED_DOCTYPE_DECL);
+        }
+        --count;
+
+        // Count any opening brackets in between.
+        count += std::count(current, ourend, '<');
+        current = ourend;
+        ++current;
+    }
+
+    _docTypeDecl = '<' + std::string(it, ourend) + '>';
+    it = ourend + 1;
+    return true;
+}
+
+bool
+XMLParser::parseXMLDecl(xml_iterator& it, const xml_iterator end)
+{
+    const std::string terminator("?>");
+    const xml_iterator ourend = std::search(it, end, terminator.begin(),
+            terminator.end());
+
+    if (ourend == end) {
+        return unterminated(XML_as::XML_UNTERMINATED_XML_DECL);
+    }
+
+    // This is appended to any xmlDecl already there.
+    _xmlDecl += '<' + std::string(it, ourend) + "?>";
+    it = ourend + terminator.size();
+    return true;
+}
+
+bool
+XMLParser::parseText(xml_iterator& it, const xml_iterator end)
+{
+    const xml_iterator ourend = std::find(it, end, '<');
+
+    // The text may go on in what is still to come.
+    if (ourend == end && !_finished) return false;
+
+    const xml_iterator text = it;
+    it = ourend;
+
+    xml_iterator content = text;
+    if (_ignoreWhite && !textAfterWhitespace(content, ourend)) return true;
+
+    addNode(XMLNode_as::Text, Text(), addText(text, ourend, true));
+    return true;
+}
+
+bool
+XMLParser::parseComment(xml_iterator& it, const xml_iterator end)
+{
+    const std::string terminator("-->");
+    const xml_iterator ourend = std::search(it, end, terminator.begin(),
+            terminator.end());
+
+    if (ourend == end) return unterminated(XML_as::XML_UNTERMINATED_COMMENT);
+
+    // Comments are discarded at least up to SWF8
+    it = ourend + terminator.size();
+    return true;
+}
+
+bool
+XMLParser::parseCData(xml_iterator& it, const xml_iterator end)
+{
+    const std::string terminator("]]>");
+    const xml_iterator ourend = std::search(it, end, terminator.begin(),
+            terminator.end());
+
+    if (ourend == end) return unterminated(XML_as::XML_UNTERMINATED_CDATA);
+
+    addNode(XMLNode_as::Text, Text(), addText(it, ourend, false));
+    it = ourend + terminator.size();
+    return true;
+}
+
+XMLParser::Text
+XMLParser::addText(const xml_iterator begin, const xml_iterator end,
+        bool unescape)
+{
+    Text t;
+    t.start = _strings.size();
+
+    // All the entities start with '&'.
+    if (unescape && std::find(begin, end, '&') != end) {
+        std::string text(begin, end);
+        unescapeXML(text);
+        _strings += text;
+    }
+    else _strings.append(begin, end);
+
+    t.size = _strings.size() - t.start;
+    return t;
+}
+
+XMLParser::Index
+XMLParser::addNode(XMLNode_as::NodeType type, Text name, Text value)
+{
+    const Index index = _nodes.size();
+
+    Node n;
+    n.type = type;
+    n.firstChild = 0;
+    n.nextSibling = 0;
+    n.attributes = _attributes.size();
+    n.attributeCount = 0;
+    n.name = name;
+    n.value = value;
+    _nodes.push_back(n);
+
+    Open& parent = _open.back();
+    if (parent.second) _nodes[parent.second].nextSibling = index;
+    else _nodes[parent.first].firstChild = index;
+    parent.second = index;
+
+    return index;
+}
+
+namespace {
+
+/// Case insensitive match of a string, returning false if there too few
+/// characters left or if there is no match. If there is a match, and advance
+/// is not false, the iterator points to the character after the match.
+bool
+textMatch(xml_iterator& it, const xml_iterator end,
+        const std::string& match, bool advance)
+{
+    const std::string::size_type len = match.length();
+
+    if (static_cast<size_t>(end - it) < len) return false;
+
+    if (!std::equal(it, it + len, match.begin(), boost::is_iequal())) {
+        return false;
+    }
+    if (advance) it += len;
+    return true;
+}
+
+/// Advance past whitespace
+//
+/// @return true if there is text after the whitespace, false if we
+///         reach the end of the string.
+bool
+textAfterWhitespace(xml_iterator& it, const xml_iterator end)
+{
+    for (; it != end; ++it) {
+        switch (*it) {
+            case '\r':
+            case '\t':
+            case '\n':
+            case ' ':
+                break;
+            default:
+                return true;
+        }
+    }
+    return false;
+}
+
+} // anonymous namespace
+} // gnash namespace
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: t
+// End:
@@ -0,0 +1,219 @@
+// XMLParser.h:  Parse XML as it arrives, for Gnash.
+//
+//   Copyright (C) 2009, 2010, 2011, 2012 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#ifndef GNASH_ASOBJ_XMLPARSER_H
+#define GNASH_ASOBJ_XMLPARSER_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+#include "XML_as.h"
+
+namespace gnash {
+
+/// Parses an XML document, as it arrives, into a compact tree.
+//
+/// The tree is only a few vectors, and the XMLNode_as of each node is
+/// made from it when ActionScript first needs the node. The parser
+/// doesn't use the VM, so the document can be parsed as it loads.
+///
+/// Parsing stops at the first error, keeping the nodes parsed before it,
+/// as XML.parseXML does.
+class XMLParser : boost::noncopyable
+{
+public:
+
+    typedef std::uint32_t Index;
+
+    /// A name or value, in the strings of the tree.
+    struct Text
+    {
+        Text() : start(0), size(0) {}
+        Index start;
+        Index size;
+    };
+
+    /// A node of the tree.
+    //
+    /// The nodes are in the order they were parsed, each before its
+    /// children, so that the first is the document and 0 is no node.
+    struct Node
+    {
+        XMLNode_as::NodeType type;
+        Index firstChild;
+        Index nextSibling;
+
+        /// The first of the node's attributes.
+        Index attributes;
+        Index attributeCount;
+
+        Text name;
+        Text value;
+        Text namespaceURI;
+    };
+
+    /// An attribute, in the order the node's attributes are set.
+    struct Attribute
+    {
+        Text name;
+        Text value;
+    };
+
+    /// An element with an id, and its id.
+    typedef std::pair<Index, Text> Id;
+
+    explicit XMLParser(bool ignoreWhite);
+
+    /// Parse more of the document.
+    //
+    /// Anything at the end that isn't complete is left for the next
+    /// call, or for finish().
+    void parse(const char* data, size_t size);
+
+    /// Parse the rest of the document.
+    //
+    /// Anything not yet complete is an error now. Nothing more is
+    /// parsed after this, and the input is no longer kept.
+    void finish();
+
+    bool finished() const {
+        return _finished;
+    }
+
+    bool ignoreWhite() const {
+        return _ignoreWhite;
+    }
+
+    /// The document so far, until it's finished.
+    const std::string& input() const {
+        return _input;
+    }
+
+    XML_as::ParseStatus status() const {
+        return _status;
+    }
+
+    const std::string& xmlDecl() const {
+        return _xmlDecl;
+    }
+
+    const std::string& docTypeDecl() const {
+        return _docTypeDecl;
+    }
+
+    const Node& node(Index i) const {
+        return _nodes[i];
+    }
+
+    const Attribute& attribute(Index i) const {
+        return _attributes[i];
+    }
+
+    std::string text(const Text& t) const {
+        return _strings.substr(t.start, t.size);
+    }
+
+    /// The elements with an id attribute, in the order they were parsed.
+    const std::vector<Id>& ids() const {
+        return _ids;
+    }
+
+private:
+
+    typedef std::string::const_iterator xml_iterator;
+
+    /// A node still open, and its last child.
+    typedef std::pair<Index, Index> Open;
+
+    /// Parse as much of the input as is complete.
+    void parseInput();
+
+    /// Parse the tag or text at it.
+    //
+    /// The parse functions return false to wait for more input. Otherwise
+    /// they advance it past what they parsed, or set an error status.
+    bool parseNext(xml_iterator& it, xml_iterator end);
+
+    bool parseTag(xml_iterator& it, xml_iterator end);
+
+    bool parseAttribute(std::string& ns, xml_iterator& it, xml_iterator end);
+
+    bool parseDocTypeDecl(xml_iterator& it, xml_iterator end);
+
+    bool parseXMLDecl(xml_iterator& it, xml_iterator end);
+
+    bool parseText(xml_iterator& it, xml_iterator end);
+
+    bool parseComment(xml_iterator& it, xml_iterator end);
+
+    bool parseCData(xml_iterator& it, xml_iterator end);
+
+    /// The input ended before something did.
+    //
+    /// This is an error once there is no more input.
+    ///
+    /// @return false to wait for more input, or true if there is no more.
+    bool unterminated(XML_as::ParseStatus status);
+
+    /// Add to the strings of the tree, replacing entities if asked.
+    Text addText(xml_iterator begin, xml_iterator end, bool unescape);
+
+    /// Add a node to the node open last.
+    Index addNode(XMLNode_as::NodeType type, Text name, Text value);
+
+    const bool _ignoreWhite;
+
+    std::string _input;
+
+    /// How much of the input has been parsed.
+    size_t _parsed;
+
+    bool _finished;
+
+    XML_as::ParseStatus _status;
+
+    std::string _xmlDecl;
+
+    std::string _docTypeDecl;
+
+    std::vector<Node> _nodes;
+
+    std::vector<Attribute> _attributes;
+
+    std::string _strings;
+
+    std::vector<Id> _ids;
+
+    std::vector<Open> _open;
+
+    /// The attributes of the tag being parsed.
+    std::vector<std::pair<std::string, std::string> > _tagAttributes;
+};
+
+} // namespace gnash
+
+#endif
+
+// local Variables:
+// mode: C++
+// indent-tabs-mode: t
+// End:
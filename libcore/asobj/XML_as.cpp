@@ -19,11 +19,12 @@
 
 #include "XMLNode_as.h"
 
+#include <map>
 #include <string>
-#include <sstream>
 #include <vector>
-#include <algorithm>
-#include <boost/algorithm/string/compare.hpp>
+#include <memory>
+#include <cstdint>
+#include <cassert>
 #include <boost/algorithm/string/replace.hpp>
 
 #include "log.h"
@@ -32,10 +33,10 @@
 #include "Global_as.h"
 #include "LoadableObject.h"
 #include "XML_as.h"
+#include "XMLParser.h"
 #include "NativeFunction.h"
 #include "VM.h"
 #include "namedStrings.h"
-#include "StringPredicates.h"
 #include "Object.h"
 
 namespace gnash {
@@ -56,14 +57,6 @@ namespace {
     as_value xml_status(const fn_call& fn);
     as_value xml_ignoreWhite(const fn_call& fn);
 
-    typedef XML_as::xml_iterator xml_iterator;
-
-    bool textAfterWhitespace(xml_iterator& it, xml_iterator end);
-    bool textMatch(xml_iterator& it, xml_iterator end,
-            const std::string& match, bool advance = true);
-    bool parseNodeWithTerminator( xml_iterator& it, xml_iterator end,
-            const std::string& terminator, std::string& content);
-
     void setIdMap(as_object& xml, XMLNode_as& childNode,
             const std::string& val);
 	
@@ -138,321 +131,6 @@ XML_as::toString(std::ostream& o, bool encode) const
     }
 }
 
-void
-XML_as::parseAttribute(XMLNode_as* node, xml_iterator& it,
-        const xml_iterator end, Attributes& attributes)
-{
-    const std::string terminators("\r\t\n >=");
-
-    xml_iterator ourend = std::find_first_of(it, end,
-            terminators.begin(), terminators.end());
-
-    if (ourend == end) {
-        _status = XML_UNTERMINATED_ELEMENT;
-        return;
-    }
-    std::string name(it, ourend);
-    
-    if (name.empty()) {
-        _status = XML_UNTERMINATED_ELEMENT;
-        return;
-    }
-
-    // Point iterator to the DisplayObject after the name.
-    it = ourend;
-
-    // Skip any whitespace before the '='. If we reach the end of the string
-    // or don't find an '=', it's a parser error.
-    if (!textAfterWhitespace(it, end) || *it != '=') {
-        _status = XML_UNTERMINATED_ELEMENT;
-        return;
-    }
-
-    // Point to the DisplayObject after the '='
-    ++it;
-
-    // Skip any whitespace. If we reach the end of the string, or don't find
-    // a " or ', it's a parser error.
-    if (!textAfterWhitespace(it, end) || (*it != '"' && *it != '\'')) {
-        _status = XML_UNTERMINATED_ELEMENT;
-        return;
-    }
-
-    // Find the end of the attribute, looking for the opening DisplayObject,
-    // as long as it's not escaped. We begin one after the present position,
-    // which should be the opening DisplayObject. We want to remember what the
-    // iterator is pointing to for a while, so don't advance it.
-    ourend = it;
-    do {
-        ++ourend;
-        ourend = std::find(ourend, end, *it);
-    } while (ourend != end && *(ourend - 1) == '\\');
-
-    if (ourend == end) {
-        _status = XML_UNTERMINATED_ATTRIBUTE;
-        return;
-    }
-    ++it;
-
-    std::string value(it, ourend);
-
-    // Replace entities in the value.
-    unescapeXML(value);
-
-    // We've already checked that ourend != end, so we can advance at 
-    // least once.
-    it = ourend;
-    // Advance past the last attribute DisplayObject
-    ++it;
-
-    // Handle namespace. This is set once only for each node, and is also
-    // pushed to the attributes list once.
-    StringNoCaseEqual noCaseCompare;
-    if (noCaseCompare(name, "xmlns") || noCaseCompare(name, "xmlns:")) {
-        if (!node->getNamespaceURI().empty()) return;
-        node->setNamespaceURI(value);
-    }
-
-    // This ensures values are not inserted twice, which is expected
-    // behaviour
-    attributes.insert(std::make_pair(name, value));
-
-}
-
-/// Parse and set the docTypeDecl. This is stored without any validation and
-/// with the same case as in the parsed XML.
-void
-XML_as::parseDocTypeDecl(xml_iterator& it, const xml_iterator end)
-{
-
-    xml_iterator ourend;
-    xml_iterator current = it; 
-
-    std::string::size_type count = 1;
-
-    // Look for angle brackets in the doctype declaration.
-    while (count) {
-
-        // Find the next closing bracket after the current position.
-        ourend = std::find(current, end, '>');
-        if (ourend == end) {
-            _status = XML_UNTERMINATED_DOCTYPE_DECL;
-            return;
-        }
-        --count;
-
-        // Count any opening brackets in between.
-        count += std::count(current, ourend, '<');
-        current = ourend;
-        ++current;
-    }
-
-    const std::string content(it, ourend);
-    std::ostringstream os;
-    os << '<' << content << '>';
-    _docTypeDecl = os.str();
-    it = ourend + 1;
-}
-
-void
-XML_as::parseXMLDecl(xml_iterator& it, const xml_iterator end)
-{
-    std::string content;
-    if (!parseNodeWithTerminator(it, end, "?>", content)) {
-        _status = XML_UNTERMINATED_XML_DECL;
-        return;
-    }
-
-    std::ostringstream os;
-    os << "<" << content << "?>";
-
-    // This is appended to any xmlDecl already there.
-    _xmlDecl += os.str();
-}
-
-// The iterator should be pointing to the first char after the '<'
-void
-XML_as::parseTag(XMLNode_as*& node, xml_iterator& it,
-        const xml_iterator end)
-{
-    bool closing = (*it == '/');
-    if (closing) ++it;
-
-    // These are for terminating the tag name, not (necessarily) the tag.
-    const std::string terminators("\r\n\t >");
-
-    xml_iterator endName = std::find_first_of(it, end, terminators.begin(),
-            terminators.end());
-
-    // Check that one of the terminators was found; otherwise it's malformed.
-    if (endName == end) {
-        _status = XML_UNTERMINATED_ELEMENT;
-        return;
-    }
-
-    // Knock off the "/>" of a self-closing tag.
-    if (std::equal(endName - 1, endName + 1, "/>")) {
-        // This can leave endName before it, e.g when a self-closing tag is
-        // empty ("</>"). This must be checked before trying to construct
-        // a string!
-        --endName;
-    }
-    
-    // If the tag is empty, the XML counts as malformed. 
-    if (it >= endName) {
-        _status = XML_UNTERMINATED_ELEMENT;
-        return;
-    }
-
-    std::string tagName(it, endName);
-
-    if (!closing) {
-
-        // Skip to the end of any whitespace after the tag name
-        it = endName;
-
-        if (!textAfterWhitespace(it, end)) {
-            _status = XML_UNTERMINATED_ELEMENT;
-           return;
-        }
-
-        XMLNode_as* childNode = new XMLNode_as(_global);
-        childNode->nodeNameSet(tagName);
-        childNode->nodeTypeSet(Element);
-
-        // Parse any attributes in an opening tag only, stopping at "/>" or
-        // '>'
-        // Attributes are added in reverse order and without any duplicates.
-        Attributes attributes;
-        while (it != end && *it != '>' && _status == XML_OK)
-        {
-            if (end - it > 1 && std::equal(it, it + 2, "/>")) break;
-
-            // This advances the iterator
-            parseAttribute(childNode, it, end, attributes);
-
-            // Skip any whitespace. If we reach the end of the string,
-            // it's malformed.
-            if (!textAfterWhitespace(it, end)) {
-                _status = XML_UNTERMINATED_ELEMENT;
-                return;
-            }
-        }
-        
-        // Do nothing more if there was an error in attributes parsing.
-        if (_status != XML_OK) {
-            delete childNode;
-            return;
-        }
-
-        // testsuite/swfdec/xml-id-map.as tests that the node is appended
-        // first.
-        node->appendChild(childNode);
-
-        for (Attributes::const_reverse_iterator i = attributes.rbegin(),
-                e = attributes.rend(); i != e; ++i) {
-            childNode->setAttribute(i->first, i->second);
-            if (i->first == "id") setIdMap(*object(), *childNode, i->second);
-        }
-
-        if (*it == '/') ++it;
-        else node = childNode;
-
-        if (*it == '>') ++it;
-
-        return;
-    }
-
-    // If we reach here, this is a closing tag.
-
-    it = std::find(endName, end, '>');
-
-    if (it == end) {
-       _status = XML_UNTERMINATED_ELEMENT;
-       return;
-    }
-    ++it;
-
-    StringNoCaseEqual noCaseCompare;
-
-    if (node->getParent() && noCaseCompare(node->nodeName(), tagName)) {
-        node = node->getParent();
-    }
-    else {
-        // Malformed. Search for the parent node.
-        XMLNode_as* s = node;
-        while (s && !noCaseCompare(s->nodeName(), tagName)) {
-            //log_debug("parent: %s, this: %s", s->nodeName(), tagName);
-            s = s->getParent();
-        }
-        if (s) {
-            // If there's a parent, the open tag is orphaned.
-            _status = XML_MISSING_CLOSE_TAG;
-        }
-        else {
-            // If no parent, the close tag is orphaned.
-            _status = XML_MISSING_OPEN_TAG;
-        }
-    }
-
-}
-
-void
-XML_as::parseText(XMLNode_as* node, xml_iterator& it,
-        const xml_iterator end, bool iw)
-{
-    xml_iterator ourend = std::find(it, end, '<');
-    std::string content(it, ourend);
-    
-    it = ourend;
-
-    if (iw && 
-        content.find_first_not_of("\t\r\n ") == std::string::npos) return;
-
-    XMLNode_as* childNode = new XMLNode_as(_global);
-
-    childNode->nodeTypeSet(XMLNode_as::Text);
-
-    // Replace any entitites.
-    unescapeXML(content);
-
-    childNode->nodeValueSet(content);
-    node->appendChild(childNode);
-
-}
-
-void
-XML_as::parseComment(XMLNode_as* /*node*/, xml_iterator& it,
-        const xml_iterator end)
-{
-
-    std::string content;
-
-    if (!parseNodeWithTerminator(it, end, "-->", content)) {
-        _status = XML_UNTERMINATED_COMMENT;
-        return;
-    }
-    // Comments are discarded at least up to SWF8
-}
-
-void
-XML_as::parseCData(XMLNode_as* node, xml_iterator& it,
-        const xml_iterator end)
-{
-    std::string content;
-
-    if (!parseNodeWithTerminator(it, end, "]]>", content)) {
-        _status = XML_UNTERMINATED_CDATA;
-        return;
-    }
-
-    XMLNode_as* childNode = new XMLNode_as(_global);
-    childNode->nodeValueSet(content);
-    childNode->nodeTypeSet(Text);
-    node->appendChild(childNode);
-}
-
-
 // This parses an XML string into a tree of XMLNodes.
 void
 XML_as::parseXML(const std::string& xml)
@@ -460,47 +138,49 @@ XML_as::parseXML(const std::string& xml)
     // Clear current data
     clear(); 
 
+    std::shared_ptr<XMLParser> parser;
+    parser.swap(_loading);
+
     if (xml.empty()) {
         log_error(_("XML data is empty"));
         return;
     }
 
-    xml_iterator it = xml.begin();
-    const xml_iterator end = xml.end();
-    XMLNode_as* node = this;
+    // A document that has loaded has mostly been parsed already.
+    if (!parser || parser->finished() ||
+            parser->ignoreWhite() != _ignoreWhite || parser->input() != xml) {
+        parser.reset(new XMLParser(_ignoreWhite));
+        parser->parse(xml.data(), xml.size());
+    }
+    parser->finish();
 
-    const bool iw = ignoreWhite();
+    _status = parser->status();
+    _xmlDecl = parser->xmlDecl();
+    _docTypeDecl = parser->docTypeDecl();
+    setParsed(parser);
 
-    while (it != end && _status == XML_OK) {
-        if (*it == '<') {
-            ++it;
-            if (textMatch(it, end, "!DOCTYPE", false)) {
-                // We should not advance past the DOCTYPE label, as
-                // the case is preserved.
-                parseDocTypeDecl(it, end);
-            }
-            else if (textMatch(it, end, "?xml", false)) {
-                // We should not advance past the xml label, as
-                // the case is preserved.
-                parseXMLDecl(it, end);
-            }
-            else if (textMatch(it, end, "!--")) {
-                parseComment(node, it, end);
-            }
-            else if (textMatch(it, end, "![CDATA[")) {
-                parseCData(node, it, end);
-            }
-            else parseTag(node, it, end);
-        }
-        else parseText(node, it, end, iw);
-    }
+    // The nodes with an id are made now, for the idMap.
+    const std::vector<XMLParser::Id>& ids = parser->ids();
+    if (ids.empty()) return;
 
-    // If everything parsed correctly, check that we've got back to the
-    // parent node. If not, there is a missing closing tag.
-    if (_status == XML_OK && node != this) {
-        _status = XML_MISSING_CLOSE_TAG;
+    std::vector<std::uint32_t> indices;
+    indices.reserve(ids.size());
+    for (const XMLParser::Id& id : ids) indices.push_back(id.first);
+
+    std::vector<XMLNode_as*> nodes;
+    makeParsed(indices, nodes);
+    assert(nodes.size() == ids.size());
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+        setIdMap(*object(), *nodes[i], parser->text(ids[i].second));
     }
+}
 
+std::shared_ptr<XMLParser>
+XML_as::parseLoading()
+{
+    _loading.reset(new XMLParser(_ignoreWhite));
+    return _loading;
 }
 
 void
@@ -844,64 +524,6 @@ xml_onData(const fn_call& fn)
     return as_value();
 }
 
-/// Case insensitive match of a string, returning false if there too few
-/// DisplayObjects left or if there is no match. If there is a match, and advance
-/// is not false, the iterator points to the DisplayObject after the match.
-bool
-textMatch(xml_iterator& it, const xml_iterator end,
-        const std::string& match, bool advance)
-{
-    const std::string::size_type len = match.length();
-
-    if (static_cast<size_t>(end - it) < len) return false;
-
-    if (!std::equal(it, it + len, match.begin(), boost::is_iequal())) {
-        return false;
-    }
-    if (advance) it += len;
-    return true;
-}
-
-/// Advance past whitespace
-//
-/// @return true if there is text after the whitespace, false if we 
-///         reach the end of the string.
-bool
-textAfterWhitespace(xml_iterator& it, const xml_iterator end)
-{
-    const std::string whitespace("\r\t\n ");
-    while (it != end && whitespace.find(*it) != std::string::npos) ++it;
-    return (it != end);
-}
-
-/// Parse a complete node up to a specified terminator.
-//
-/// @return     false if we reach the end of the text before finding the
-///             terminator.
-/// @param it   The current position of the iterator. If the return is true,
-///             this points to the first DisplayObject after the terminator 
-///             after return
-/// @param content  If the return is true, this is filled with the content of
-///                 the tag.
-/// @param xml      The complete XML string.
-bool
-parseNodeWithTerminator(xml_iterator& it, const xml_iterator end,
-        const std::string& terminator, std::string& content)
-{
-    xml_iterator ourend = std::search(it, end, terminator.begin(),
-            terminator.end());
-
-    if (ourend == end) {
-        return false;
-    }
-
-    content = std::string(it, ourend);
-    it = ourend + terminator.length();
-
-    return true;
-}
-
-
 void
 setIdMap(as_object& xml, XMLNode_as& childNode, const std::string& val)
 {
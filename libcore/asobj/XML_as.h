@@ -22,9 +22,8 @@
 
 #include "XMLNode_as.h"
 #include "dsodefs.h"
-#include "StringPredicates.h"
 
-#include <map>
+#include <memory>
 #include <string>
 
 
@@ -33,6 +32,7 @@ namespace gnash {
 // Forward declarations
 class fn_call;
 class URL;
+class XMLParser;
 
 /// Implements XML (AS2) and flash.xml.XMLDocument (AS3) class.
 //
@@ -45,8 +45,6 @@ class XML_as : public XMLNode_as
 {
 public:
 
-    typedef std::string::const_iterator xml_iterator;
-
     enum ParseStatus {
             XML_OK = 0,
             XML_UNTERMINATED_CDATA = -2,
@@ -118,8 +116,17 @@ public:
     ///
     /// Calls to this function clear any precedently parsed data.
     ///
+    /// The nodes are only made when they are needed, apart from those
+    /// with an id, which go in the idMap.
     void parseXML(const std::string& xml);
 
+    /// Start parsing a document that is loading.
+    //
+    /// The caller gives the parser the document as it loads. If the next
+    /// call to parseXML is passed the same document, the tree is made from
+    /// what the parser parsed rather than parsing it again.
+    std::shared_ptr<XMLParser> parseLoading();
+
     int status() const {
         return _status;
     }
@@ -148,24 +155,6 @@ public:
 
 private:
 
-    typedef std::map<std::string, std::string, StringNoCaseLessThan> Attributes;
-
-    void parseTag(XMLNode_as*& node, xml_iterator& it, xml_iterator end);
-
-    void parseAttribute(XMLNode_as* node, xml_iterator& it,
-            xml_iterator end, Attributes& attributes);
-
-    void parseDocTypeDecl( xml_iterator& it, xml_iterator end);
-
-    void parseText(XMLNode_as* node, xml_iterator& it, xml_iterator end,
-            bool ignoreWhite);
-
-    void parseXMLDecl(xml_iterator& it, xml_iterator end);
-
-    void parseComment(XMLNode_as* node, xml_iterator& it, xml_iterator end);
-
-    void parseCData(XMLNode_as* node, xml_iterator& it, xml_iterator end);
- 
     /// Clear all properties.
     //
     /// This removes all children, resets doctype and xml decls, and
@@ -187,6 +176,9 @@ private:
     std::string _contentType;
 
     bool _ignoreWhite;
+
+    /// The document being parsed as it loads, if any.
+    std::shared_ptr<XMLParser> _loading;
 };
 
 
@@ -289,9 +289,10 @@ externalinterface_call(const fn_call& fn)
     if (fn.nargs > 1) {
         const as_value& methodName_as = fn.arg(0);
         const std::string methodName = methodName_as.to_string();
-        const std::vector<as_value>& args = fn.getArgs();
+        const fn_call::Args::container_type& args = fn.getArgs();
         log_debug("Calling External method \"%s\"", methodName);
-        std::string result = mr.callExternalJavascript(methodName, args);
+        std::string result = mr.callExternalJavascript(methodName,
+                args.data(), args.data() + args.size());
         if (!result.empty()) {
             val = ExternalInterface::parseXML(result);
             // There was an error trying to Invoke the callback
@@ -135,10 +135,9 @@ bevelfilter_highlightAlpha(const fn_call& fn)
 {
     BevelFilter_as* ptr = ensure<ThisIsNative<BevelFilter_as> >(fn);
     if (fn.nargs == 0) {
-        return as_value(ptr->m_highlightAlpha );
+        return as_value(fromFilterAlpha(ptr->m_highlightAlpha));
     }
-    std::uint8_t sp_highlightAlpha = toNumber(fn.arg(0), getVM(fn));
-    ptr->m_highlightAlpha = sp_highlightAlpha;
+    ptr->m_highlightAlpha = toFilterAlpha(fn.arg(0), getVM(fn));
     return as_value();
 }
 
@@ -159,10 +158,9 @@ bevelfilter_shadowAlpha(const fn_call& fn)
 {
     BevelFilter_as* ptr = ensure<ThisIsNative<BevelFilter_as> >(fn);
     if (fn.nargs == 0) {
-        return as_value(ptr->m_shadowAlpha );
+        return as_value(fromFilterAlpha(ptr->m_shadowAlpha));
     }
-    std::uint8_t sp_shadowAlpha = toNumber(fn.arg(0), getVM(fn));
-    ptr->m_shadowAlpha = sp_shadowAlpha;
+    ptr->m_shadowAlpha = toFilterAlpha(fn.arg(0), getVM(fn));
     return as_value();
 }
 
@@ -18,12 +18,19 @@
 
 #include "BitmapFilter_as.h"
 
+#include <cmath>
+
 #include "namedStrings.h"
 #include "as_object.h"
 #include "VM.h"
 #include "NativeFunction.h"
 #include "Global_as.h"
+#include "Array_as.h"
 #include "Filters.h"
+#include "GnashNumeric.h"
+#include "as_environment.h"
+#include "as_function.h"
+#include "log.h"
 
 namespace gnash {
 
@@ -33,6 +40,9 @@ namespace {
     as_value bitmapfilter_clone(const fn_call& fn);
     as_value getBitmapFilterConstructor(const fn_call& fn);
     void attachBitmapFilterInterface(as_object& o);
+    template<typename T> bool pushFilter(as_object& array,
+            const BitmapFilter& f, const std::string& name,
+            const as_environment& env);
 }
  
 /// This may need a reference to its owner as_object
@@ -102,6 +112,57 @@ registerBitmapClass(as_object& where, Global_as::ASFunction ctor,
 
 }
 
+std::shared_ptr<const Filters>
+toFilters(const as_value& val, VM& vm)
+{
+    if (!val.is_object()) return std::shared_ptr<const Filters>();
+
+    as_object* array = toObject(val, vm);
+    std::shared_ptr<Filters> filters(new Filters);
+
+    const size_t size = arrayLength(*array);
+    for (size_t i = 0; i < size; ++i) {
+        const as_value el = getOwnProperty(*array, arrayKey(vm, i));
+        if (!el.is_object()) continue;
+        const BitmapFilter* f =
+            dynamic_cast<const BitmapFilter*>(toObject(el, vm)->relay());
+        if (f) filters->push_back(f->clone());
+    }
+
+    if (filters->empty()) return std::shared_ptr<const Filters>();
+    return filters;
+}
+
+as_object*
+fromFilters(const Filters* filters, const as_environment& env)
+{
+    as_object* array = getGlobal(env).createArray();
+    if (!filters) return array;
+
+    for (const std::unique_ptr<BitmapFilter>& f : *filters) {
+        pushFilter<BlurFilter>(*array, *f, "BlurFilter", env) ||
+        pushFilter<DropShadowFilter>(*array, *f, "DropShadowFilter", env) ||
+        pushFilter<GlowFilter>(*array, *f, "GlowFilter", env) ||
+        pushFilter<BevelFilter>(*array, *f, "BevelFilter", env) ||
+        pushFilter<GradientGlowFilter>(*array, *f, "GradientGlowFilter",
+                env) ||
+        pushFilter<GradientBevelFilter>(*array, *f, "GradientBevelFilter",
+                env) ||
+        pushFilter<ConvolutionFilter>(*array, *f, "ConvolutionFilter",
+                env) ||
+        pushFilter<ColorMatrixFilter>(*array, *f, "ColorMatrixFilter", env);
+    }
+    return array;
+}
+
+std::uint8_t
+toFilterAlpha(const as_value& val, VM& vm)
+{
+    const double alpha = toNumber(val, vm);
+    if (isNaN(alpha)) return 0;
+    return std::lround(clamp<double>(alpha, 0, 1) * 255);
+}
+
 namespace {
 
 void
@@ -136,6 +197,44 @@ bitmapfilter_new(const fn_call& fn)
     return as_value();
 }
 
+/// Push a copy of a filter of type T onto an array.
+//
+/// The copy is made with the AS class, so it is the same as one made by
+/// a script, and then given the filter's values.
+///
+/// @return     Whether the filter is of type T.
+template<typename T>
+bool
+pushFilter(as_object& array, const BitmapFilter& f, const std::string& name,
+        const as_environment& env)
+{
+    const T* filter = dynamic_cast<const T*>(&f);
+    if (!filter) return false;
+
+    as_object* cl = findObject(env, "flash.filters." + name);
+    as_function* ctor = cl ? cl->to_function() : nullptr;
+    if (!ctor) {
+        IF_VERBOSE_ASCODING_ERRORS(
+            log_aserror(_("Failed to construct flash.filters.%s"), name);
+        );
+        return true;
+    }
+
+    fn_call::Args args;
+    as_object* obj = constructInstance(*ctor, env, args);
+    T* copy = dynamic_cast<T*>(obj->relay());
+    if (!copy) {
+        IF_VERBOSE_ASCODING_ERRORS(
+            log_aserror(_("flash.filters.%s didn't make a filter"), name);
+        );
+        return true;
+    }
+
+    *copy = *filter;
+    callMethod(&array, NSV::PROP_PUSH, obj);
+    return true;
+}
+
 /// TODO: there are no tests for how this works, so it's not implemented.
 as_value
 bitmapfilter_clone(const fn_call& fn)
@@ -20,10 +20,16 @@
 #ifndef GNASH_ASOBJ_BITMAPFILTER_H
 #define GNASH_ASOBJ_BITMAPFILTER_H
 
+#include <memory>
+
 #include "Global_as.h"
+#include "Filters.h"
 
 namespace gnash {
     class as_object;
+    class as_value;
+    class VM;
+    class as_environment;
     struct ObjectURI;
 }
 
@@ -41,6 +47,36 @@ void registerBitmapFilterNative(as_object& global);
 void registerBitmapClass(as_object& where, Global_as::ASFunction ctor,
         Global_as::Properties p, const ObjectURI& uri);
 
+/// Copy the filters in an array of BitmapFilter objects.
+//
+/// This is for the filters property of DisplayObjects. Anything in the
+/// array that isn't a filter is left out, and changing the filters
+/// afterwards doesn't change the copies.
+///
+/// @param val  The array.
+/// @return     The filters, or null if there are none.
+std::shared_ptr<const Filters> toFilters(const as_value& val, VM& vm);
+
+/// Copy filters into an array of BitmapFilter objects.
+//
+/// This is for the filters property of DisplayObjects, so changing the
+/// objects doesn't change the filters.
+///
+/// @param filters  The filters, or null if there are none.
+/// @param env      Where to find the filter classes.
+/// @return         The array.
+as_object* fromFilters(const Filters* filters, const as_environment& env);
+
+/// Convert an AS alpha, from 0 to 1, to a filter's, from 0 to 255.
+std::uint8_t toFilterAlpha(const as_value& val, VM& vm);
+
+/// Convert a filter's alpha, from 0 to 255, to an AS one, from 0 to 1.
+inline double
+fromFilterAlpha(std::uint8_t alpha)
+{
+    return alpha / 255.0;
+}
+
 } // end of gnash namespace
 
 #endif
@@ -40,7 +40,8 @@ namespace {
 class BlurFilter_as : public Relay, public BlurFilter
 {
 public:
-    BlurFilter_as() {}
+    /// The defaults are those of the Flash player.
+    BlurFilter_as() : BlurFilter(4, 4, 1) {}
 };
 
 void
@@ -101,7 +102,14 @@ as_value
 blurfilter_new(const fn_call& fn)
 {
     as_object* obj = ensure<ValidThis>(fn);
-    obj->setRelay(new BlurFilter_as);
+    VM& vm = getVM(fn);
+
+    BlurFilter_as* filter = new BlurFilter_as;
+    if (fn.nargs > 0) filter->m_blurX = toNumber(fn.arg(0), vm);
+    if (fn.nargs > 1) filter->m_blurY = toNumber(fn.arg(1), vm);
+    if (fn.nargs > 2) filter->m_quality = toNumber(fn.arg(2), vm);
+
+    obj->setRelay(filter);
     return as_value();
 }
 
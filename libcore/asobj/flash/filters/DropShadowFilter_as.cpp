@@ -50,7 +50,11 @@ namespace {
 class DropShadowFilter_as : public Relay, public DropShadowFilter
 {
 public:
-    DropShadowFilter_as() {}
+    /// The defaults are those of the Flash player.
+    DropShadowFilter_as()
+        :
+        DropShadowFilter(4, 45, 0, 255, 4, 4, 1, 1, false, false, false)
+    {}
 };
 
 /// The prototype of flash.filters.DropShadowFilter is a new BitmapFilter.
@@ -122,10 +126,9 @@ dropshadowfilter_alpha(const fn_call& fn)
 {
     DropShadowFilter_as* ptr = ensure<ThisIsNative<DropShadowFilter_as> >(fn);
     if (fn.nargs == 0) {
-        return as_value(ptr->m_alpha);
+        return as_value(fromFilterAlpha(ptr->m_alpha));
     }
-    double sp_alpha = toNumber(fn.arg(0), getVM(fn));
-    ptr->m_alpha = sp_alpha;
+    ptr->m_alpha = toFilterAlpha(fn.arg(0), getVM(fn));
     return as_value();
 }
 
@@ -230,7 +233,22 @@ as_value
 dropshadowfilter_new(const fn_call& fn)
 {
     as_object* obj = ensure<ValidThis>(fn);
-    obj->setRelay(new DropShadowFilter_as);
+    VM& vm = getVM(fn);
+
+    DropShadowFilter_as* filter = new DropShadowFilter_as;
+    if (fn.nargs > 0) filter->m_distance = toNumber(fn.arg(0), vm);
+    if (fn.nargs > 1) filter->m_angle = toNumber(fn.arg(1), vm);
+    if (fn.nargs > 2) filter->m_color = toNumber(fn.arg(2), vm);
+    if (fn.nargs > 3) filter->m_alpha = toFilterAlpha(fn.arg(3), vm);
+    if (fn.nargs > 4) filter->m_blurX = toNumber(fn.arg(4), vm);
+    if (fn.nargs > 5) filter->m_blurY = toNumber(fn.arg(5), vm);
+    if (fn.nargs > 6) filter->m_strength = toNumber(fn.arg(6), vm);
+    if (fn.nargs > 7) filter->m_quality = toNumber(fn.arg(7), vm);
+    if (fn.nargs > 8) filter->m_inner = toBool(fn.arg(8), vm);
+    if (fn.nargs > 9) filter->m_knockout = toBool(fn.arg(9), vm);
+    if (fn.nargs > 10) filter->m_hideObject = toBool(fn.arg(10), vm);
+
+    obj->setRelay(filter);
     return as_value();
 }
 
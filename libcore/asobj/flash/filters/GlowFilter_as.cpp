@@ -47,7 +47,8 @@ namespace {
 class GlowFilter_as : public Relay, public GlowFilter
 {
 public:
-    GlowFilter_as() {}
+    /// The defaults are those of the Flash player.
+    GlowFilter_as() : GlowFilter(0xff0000, 255, 6, 6, 2, 1, false, false) {}
 };
 
 /// The prototype of flash.filters.GlowFilter is a new BitmapFilter.
@@ -112,10 +113,9 @@ glowfilter_alpha(const fn_call& fn)
 {
     GlowFilter_as* ptr = ensure<ThisIsNative<GlowFilter_as> >(fn);
     if (fn.nargs == 0) {
-        return as_value(ptr->m_alpha );
+        return as_value(fromFilterAlpha(ptr->m_alpha));
     }
-    float sp_alpha = toNumber(fn.arg(0), getVM(fn));
-    ptr->m_alpha = sp_alpha;
+    ptr->m_alpha = toFilterAlpha(fn.arg(0), getVM(fn));
     return as_value();
 }
 
@@ -183,7 +183,19 @@ as_value
 glowfilter_new(const fn_call& fn)
 {
     as_object* obj = ensure<ValidThis>(fn);
-    obj->setRelay(new GlowFilter_as);
+    VM& vm = getVM(fn);
+
+    GlowFilter_as* filter = new GlowFilter_as;
+    if (fn.nargs > 0) filter->m_color = toNumber(fn.arg(0), vm);
+    if (fn.nargs > 1) filter->m_alpha = toFilterAlpha(fn.arg(1), vm);
+    if (fn.nargs > 2) filter->m_blurX = toNumber(fn.arg(2), vm);
+    if (fn.nargs > 3) filter->m_blurY = toNumber(fn.arg(3), vm);
+    if (fn.nargs > 4) filter->m_strength = toNumber(fn.arg(4), vm);
+    if (fn.nargs > 5) filter->m_quality = toNumber(fn.arg(5), vm);
+    if (fn.nargs > 6) filter->m_inner = toBool(fn.arg(6), vm);
+    if (fn.nargs > 7) filter->m_knockout = toBool(fn.arg(7), vm);
+
+    obj->setRelay(filter);
     return as_value();
 }
 
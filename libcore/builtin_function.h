@@ -69,6 +69,7 @@ public:
 	virtual as_value call(const fn_call& fn)
 	{
 		FrameGuard guard(getVM(fn), *this);
+		ProfileGuard profile(getVM(fn).profiler(), _func);
 
 		assert(_func);
 		return _func(fn);
@@ -27,6 +27,8 @@
 #include <bitset>
 #include <cassert>
 #include <functional>
+#include <algorithm>
+#include <limits>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/ptr_container/ptr_deque.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
@@ -57,7 +59,10 @@
 #include "Transform.h"
 #include "StreamProvider.h"
 #include "SystemClock.h"
+#include "BitmapCache.h"
 #include "as_function.h"
+#include "XML_as.h"
+#include "XMLParser.h"
 
 #ifdef USE_SWFTREE
 # include "tree.hh"
@@ -99,6 +104,29 @@ namespace {
 // Utility classes
 namespace {
 
+/// The most DisplayObjects kept track of between two frames.
+//
+/// If more change, the whole stage is scanned for them.
+const size_t maxInvalidatedObjects = 1024;
+
+/// Find out whether DisplayObjects may be masked by a mask layer,
+/// looking at each DisplayList only once.
+class MaskedDepths
+{
+public:
+    bool operator()(const MovieClip& mc, int depth) {
+        Depths::iterator it = _depths.find(&mc);
+        if (it == _depths.end()) {
+            it = _depths.insert(std::make_pair(&mc,
+                        mc.getDisplayList().maskedDepths())).first;
+        }
+        return depth > it->second.first && depth <= it->second.second;
+    }
+private:
+    typedef std::map<const MovieClip*, std::pair<int, int> > Depths;
+    Depths _depths;
+};
+
 /// Execute an ActiveRelay if the object has that type.
 struct ExecuteCallback
 {
@@ -166,7 +194,10 @@ movie_root::movie_root(VirtualClock& clock, const RunResources& runResources)
     _movieAdvancementDelay(83), // ~12 fps by default
     _lastMovieAdvancement(0),
     _unnamedInstance(0),
-    _movieLoader(*this)
+    _movieLoader(*this),
+    _displayVersion(1),
+    _invalidatedOverflow(false),
+    _invalidatedVersion(1)
 {
     // This takes care of informing the renderer (if present) too.
     setQuality(QUALITY_HIGH);
@@ -174,6 +205,9 @@ movie_root::movie_root(VirtualClock& clock, const RunResources& runResources)
     gnash::RcInitFile& rcfile = gnash::RcInitFile::getDefaultInstance();
     _recursionLimit = rcfile.getScriptsRecursionLimit();
     _timeoutLimit = rcfile.getScriptsTimeout();
+
+    _bitmapCachePool.reset(new BitmapCachePool(
+                rcfile.getBitmapCacheLimit() * 1024 * 1024));
 }
 
 void
@@ -191,6 +225,7 @@ movie_root::~movie_root()
 {
     clear(_actionQueue);
     _intervalTimers.clear();
+    _timerQueue.clear();
     _movieLoader.clear();
 
     assert(testInvariant());
@@ -346,6 +381,7 @@ movie_root::setLevel(unsigned int num, Movie* movie)
             //       test sets an interval and then loads something
             //       in _level0. The result is the interval is disabled.
             _intervalTimers.clear();
+            _timerQueue.clear();
 
             // TODO: check what else we should do in these cases 
             //       (like, unregistering all childs etc...)
@@ -537,6 +573,7 @@ movie_root::reset()
 
     // remove all intervals
     _intervalTimers.clear();
+    _timerQueue.clear();
 
     // remove all loadMovie requests
     _movieLoader.clear();
@@ -819,6 +856,10 @@ movie_root::addIntervalTimer(std::unique_ptr<Timer> timer)
 
     assert(_intervalTimers.find(id) == _intervalTimers.end());
 
+    _timerQueue.push_back(std::make_pair(timer->expireTime(), id));
+    std::push_heap(_timerQueue.begin(), _timerQueue.end(),
+            std::greater<TimerQueue::value_type>());
+
     _intervalTimers.insert(std::make_pair(id, std::move(timer)));
 
     return id;
@@ -834,13 +875,15 @@ movie_root::clearIntervalTimer(std::uint32_t x)
 
     // We do not remove the element here because
     // we might have been called during execution
-    // of another timer, thus during a scan of the _intervalTimers
-    // container. If we use erase() here, the iterators in executeTimers
-    // would be invalidated. Rather, executeTimers() would check container
-    // elements for being still active and remove the cleared one in a safe way
-    // at each iteration.
+    // of this or another timer, which executeTimers() holds on to.
+    // Rather, the timer is queued to expire now, and executeTimers()
+    // removes it in a safe way when it finds it cleared.
     it->second->clearInterval();
 
+    _timerQueue.push_back(std::make_pair(0, x));
+    std::push_heap(_timerQueue.begin(), _timerQueue.end(),
+            std::greater<TimerQueue::value_type>());
+
     return true;
 }
 
@@ -994,6 +1037,20 @@ movie_root::timeToNextFrame() const
     return _movieAdvancementDelay - elapsed;
 }
 
+int
+movie_root::timeToNextTimer() const
+{
+    if (_timerQueue.empty()) return std::numeric_limits<int>::max();
+
+    // The first timer may have been removed since it was queued, in which
+    // case this is a bit early.
+    const unsigned long next = _timerQueue.front().first;
+    const unsigned long now = _vm.getTime();
+    if (next < now) return -static_cast<int>(std::min<unsigned long>(
+                now - next, std::numeric_limits<int>::max()));
+    return std::min<unsigned long>(next - now, std::numeric_limits<int>::max());
+}
+
 void
 movie_root::display()
 {
@@ -1003,6 +1060,12 @@ movie_root::display()
 
     clearInvalidated();
 
+    // Displaying clears the invalidated flags, so the next frame's
+    // changes are kept track of from here.
+    _invalidatedObjects.clear();
+    _invalidatedOverflow = false;
+    ++_invalidatedVersion;
+
     // TODO: should we consider the union of all levels bounds ?
     const SWFRect& frame_size = _rootMovie->get_frame_size();
     if ( frame_size.is_null() )
@@ -1362,12 +1425,107 @@ movie_root::add_invalidated_bounds(InvalidatedRanges& ranges, bool force)
         return;
     }
 
+    // Usually the few DisplayObjects that changed are all there is to
+    // look at.
+    if (!force && addInvalidatedObjects(ranges)) return;
+
     for (Levels::reverse_iterator i=_movies.rbegin(), e=_movies.rend(); i!=e;
                         ++i) {
         i->second->add_invalidated_bounds(ranges, force);
     }
 }
 
+bool
+movie_root::addInvalidatedObjects(InvalidatedRanges& ranges) const
+{
+    if (_invalidatedOverflow) return false;
+
+    // This finds what scanning the levels would find, without adding
+    // anything until it is sure that no scan is needed.
+    std::vector<DisplayObject*> changed;
+    std::vector<const DisplayObject*> filtered;
+    MaskedDepths masked;
+
+    for (DisplayObject* ch : _invalidatedObjects) {
+
+        // Removed DisplayObjects added their bounds to their parent's.
+        if (!ch->invalidated() || ch->isDestroyed()) continue;
+
+        // Changes to masks change what they mask, and what is masked only
+        // adds the part inside the mask.
+        if (ch->isMaskLayer()) return false;
+
+        const size_t filters = filtered.size();
+        bool shown = true;
+        const DisplayObject* top = ch;
+
+        for (DisplayObject* p = ch->parent(); p; top = p, p = p->parent()) {
+
+            // An invalidated parent adds everything inside it, but only
+            // the ones reported are sure to be looked at.
+            if (p->invalidated()) {
+                if (!p->invalidatedReported()) return false;
+                shown = false;
+                break;
+            }
+
+            if (!p->visible()) {
+                shown = false;
+                break;
+            }
+
+            if (p->isMaskLayer()) return false;
+
+            MovieClip* mc = p->to_movie();
+            if (mc) {
+                if (invisible(getCxForm(*mc))) {
+                    shown = false;
+                    break;
+                }
+                if (masked(*mc, top->get_depth())) return false;
+            }
+
+            // Filters are drawn again when anything inside changes.
+            if (p->filters()) filtered.push_back(p);
+        }
+
+        bool onStage = false;
+        for (const Levels::value_type& level : _movies) {
+            if (level.second == top) onStage = true;
+        }
+
+        if (!shown || !onStage) {
+            filtered.resize(filters);
+            continue;
+        }
+
+        changed.push_back(ch);
+    }
+
+    for (DisplayObject* ch : changed) {
+        ch->add_invalidated_bounds(ranges, false);
+    }
+    for (const DisplayObject* p : filtered) {
+        p->addFilterBounds(ranges);
+    }
+    return true;
+}
+
+void
+movie_root::addInvalidated(DisplayObject& ch)
+{
+    if (_invalidatedOverflow) return;
+
+    // The DisplayObjects are kept alive until the next display(), so
+    // this also keeps them from piling up if nothing is displayed.
+    if (_invalidatedObjects.size() == maxInvalidatedObjects) {
+        _invalidatedOverflow = true;
+        _invalidatedObjects.clear();
+        return;
+    }
+    _invalidatedObjects.push_back(&ch);
+}
+
 size_t
 movie_root::minPopulatedPriorityQueue() const
 {
@@ -1705,22 +1863,27 @@ movie_root::executeTimers()
 
     // Don't do anything if we have no timers, just return so we don't
     // waste cpu cycles.
-    if (_intervalTimers.empty()) {
+    if (_timerQueue.empty()) {
         return;
     }
 
-    unsigned long now = _vm.getTime();
+    const unsigned long now = _vm.getTime();
 
-    typedef std::multimap<unsigned long, Timer*>
-        ExpiredTimers;
+    const std::greater<TimerQueue::value_type> later;
 
+    // Take the expired timers off the queue, the one that expired first
+    // first, and remove those that were cleared.
+    typedef std::vector<std::pair<std::uint32_t, Timer*>> ExpiredTimers;
     ExpiredTimers expiredTimers;
 
-    for (TimerMap::iterator it = _intervalTimers.begin(),
-            itEnd = _intervalTimers.end(); it != itEnd; ) {
+    while (!_timerQueue.empty() && _timerQueue.front().first <= now) {
+
+        const std::uint32_t id = _timerQueue.front().second;
+        std::pop_heap(_timerQueue.begin(), _timerQueue.end(), later);
+        _timerQueue.pop_back();
 
-        TimerMap::iterator nextIterator = it;
-        ++nextIterator;
+        TimerMap::iterator it = _intervalTimers.find(id);
+        if (it == _intervalTimers.end()) continue;
 
         Timer* timer = it->second.get();
 
@@ -1729,17 +1892,26 @@ movie_root::executeTimers()
             _intervalTimers.erase(it);
         }
         else {
-            unsigned long elapsed;
-            if (timer->expired(now, elapsed)) {
-                expiredTimers.insert(std::make_pair(elapsed, timer));
-            }
+            expiredTimers.push_back(std::make_pair(id, timer));
         }
-
-        it = nextIterator;
     }
 
-    foreachSecond(expiredTimers.begin(), expiredTimers.end(),
-                  &Timer::executeAndReset);
+    for (const ExpiredTimers::value_type& expired : expiredTimers) {
+
+        Timer* timer = expired.second;
+        timer->executeAndReset();
+
+        // A timer that ran once, or was cleared while the expired timers
+        // ran, is done with.
+        if (timer->cleared()) {
+            _intervalTimers.erase(expired.first);
+            continue;
+        }
+
+        _timerQueue.push_back(std::make_pair(timer->expireTime(),
+                    expired.first));
+        std::push_heap(_timerQueue.begin(), _timerQueue.end(), later);
+    }
 
     if (!expiredTimers.empty())
         processActionQueue();
@@ -1794,6 +1966,11 @@ movie_root::markReachableResources() const
 
     if (_currentFocus) _currentFocus->setReachable();
 
+    // Mark DisplayObjects invalidated since the last frame
+    for (const DisplayObject* ch : _invalidatedObjects) {
+        ch->setReachable();
+    }
+
     // Mark DisplayObject being dragged, if any
     if (_dragState) _dragState->markReachableResources();
 
@@ -1820,6 +1997,7 @@ movie_root::getTopmostMouseEntity(std::int32_t x, std::int32_t y) const
     for (Levels::const_reverse_iterator i=_movies.rbegin(), e=_movies.rend();
             i != e; ++i)
     {
+        if (!i->second->hitBounds().point_test(x, y)) continue;
         InteractiveObject* ret = i->second->topmostMouseEntity(x, y);
         if (ret) return ret;
     }
@@ -1889,13 +2067,14 @@ movie_root::addExternalCallback(const std::string& name, as_object* callback,
 /// </pre>
 std::string
 movie_root::callExternalJavascript(const std::string &name, 
-                                   const std::vector<as_value> &fnargs)
+                                   const as_value* first,
+                                   const as_value* last)
 {
     std::string result;
     // If the browser is connected, we send an Invoke message to the
     // browser.
     if (_controlfd >= 0 && _hostfd >= 0) {
-        std::string msg = ExternalInterface::makeInvoke(name, fnargs);
+        std::string msg = ExternalInterface::makeInvoke(name, first, last);
         
         const size_t ret = ExternalInterface::writeBrowser(_hostfd, msg);
         if (ret != msg.size()) {
@@ -2342,6 +2521,16 @@ movie_root::getMovieInfo(InfoTree& tr, InfoTree::iterator it)
     // Stage: scripts state (enabled/disabled)
     localIter = tr.append_child(it, std::make_pair("Scripts",
                 _disableScripts ? " disabled" : "enabled"));
+
+    // Stage: cacheAsBitmap bitmaps.
+    const BitmapCachePool::Stats& cached = _bitmapCachePool->stats();
+    os.str("");
+    os << cached.surfaces << " (" << cached.bytes / 1024 << "kB of " <<
+        _bitmapCachePool->limit() / 1024 << "kB), " << cached.hits <<
+        " hits, " << cached.redraws << " redraws, " << cached.refused <<
+        " refused, " << cached.evicted << " evicted";
+    localIter = tr.append_child(it, std::make_pair("Cached bitmaps",
+                os.str()));
      
     getCharacterTree(tr, it);    
 }
@@ -2450,12 +2639,20 @@ movie_root::LoadCallback::processLoad()
         // set total size only on first read
         if (_buf.empty()) {
             _obj->set_member(NSV::PROP_uBYTES_TOTAL, _stream->size());
+
+            // XML is parsed as it loads, so that parseXML only has to
+            // finish it.
+            XML_as* xml;
+            if (isNativeType(_obj, xml)) _xml = xml->parseLoading();
         }
 
         _buf.append(chunk, actuallyRead);
 
         _obj->set_member(NSV::PROP_uBYTES_LOADED, _buf.size());
 
+        // A BOM can only be stripped once there are four bytes.
+        if (_xml && _buf.size() > 3) parseXML();
+
         log_debug("LoadableObject Loaded %d bytes, reaching %d/%d",
             actuallyRead, _buf.size(), _stream->size());
     }
@@ -2502,6 +2699,25 @@ movie_root::LoadCallback::processLoad()
     return true;
 }
 
+void
+movie_root::LoadCallback::parseXML()
+{
+    // This must parse just what onData is passed, as parseXML only uses
+    // what was parsed if it's passed the same.
+    utf8::TextEncoding encoding;
+    size_t size = _buf.size();
+    const char* text = utf8::stripBOM(
+        reinterpret_cast<const char*>(_buf.data()), size, encoding);
+
+    const char* begin = text + _xml->input().size();
+    const char* end = text + size;
+    const char* parsed = std::find(begin, end, '\0');
+    _xml->parse(begin, parsed - begin);
+
+    // The rest isn't passed on.
+    if (parsed != end) _xml.reset();
+}
+
 void
 movie_root::callInterface(const HostInterface::Message& e) const
 {
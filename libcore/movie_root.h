@@ -75,6 +75,7 @@
 #include <set>
 #include <bitset>
 #include <array>
+#include <memory>
 #include <boost/ptr_container/ptr_deque.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/any.hpp>
@@ -119,6 +120,8 @@ namespace gnash {
     class Button;
     class VM;
     class Movie;
+    class BitmapCachePool;
+    class XMLParser;
 }
 
 namespace gnash {
@@ -161,9 +164,12 @@ public:
         bool processLoad();
         void setReachable() const;
     private:
+        /// Parse XML as it loads, from after any BOM up to any null.
+        void parseXML();
         std::unique_ptr<IOChannel> _stream;
         SimpleBuffer _buf;
         as_object* _obj;
+        std::shared_ptr<XMLParser> _xml;
     };
     typedef std::list<LoadCallback> LoadCallbacks;
 
@@ -371,6 +377,15 @@ public:
     ///
     int timeToNextFrame() const;
 
+    /// \brief
+    /// Return the number of milliseconds before the next interval
+    /// timer expires.
+    //
+    /// Return value can be negative if we're late, and is
+    /// std::numeric_limits<int>::max() if there are no timers.
+    ///
+    int timeToNextTimer() const;
+
     /// Entry point for movie advancement
     //
     /// This function does:
@@ -808,8 +823,14 @@ public:
     std::string callExternalCallback(const std::string &name, 
                                      const std::vector<as_value>& args);
     
+    /// Call a JavaScript method in the web page.
+    //
+    /// @param first    The first of the arguments, which are taken as a
+    ///                 range so that a call's own can be passed as they are.
+    /// @param last     One past the last of the arguments.
     std::string callExternalJavascript(const std::string &name, 
-                                       const std::vector<as_value>& args);
+                                       const as_value* first,
+                                       const as_value* last);
 
     /// Removes a queued constructor from the execution queue
     //
@@ -823,6 +844,37 @@ public:
         return _gc;
     }
 
+    /// The memory for the bitmaps of cacheAsBitmap DisplayObjects.
+    //
+    /// The BitmapCaches share it, so it may outlive the movie_root.
+    const std::shared_ptr<BitmapCachePool>& bitmapCachePool() const {
+        return _bitmapCachePool;
+    }
+
+    /// Note that something that can change the outcome of hit tests changed.
+    //
+    /// DisplayObjects keep their hit bounds until this is called.
+    void displayChanged() {
+        ++_displayVersion;
+    }
+
+    /// The number of times displayChanged() was called, plus one.
+    size_t displayVersion() const {
+        return _displayVersion;
+    }
+
+    /// Note that a DisplayObject was invalidated.
+    //
+    /// add_invalidated_bounds() only looks at the DisplayObjects noted
+    /// since the last display(), unless there were too many of them.
+    /// Each only needs to be noted once for every invalidatedVersion().
+    void addInvalidated(DisplayObject& ch);
+
+    /// Changes every time the stage is displayed.
+    size_t invalidatedVersion() const {
+        return _invalidatedVersion;
+    }
+
     /// Ask the host interface a question.
     //
     /// @param what The question to pose.
@@ -919,6 +971,13 @@ private:
     /// from the display lists
     void cleanupDisplayList();
 
+    /// Add the bounds of the DisplayObjects invalidated since the last
+    /// display().
+    //
+    /// @return     false if nothing was added, because the whole stage
+    ///             must be scanned to find out what changed.
+    bool addInvalidatedObjects(InvalidatedRanges& ranges) const;
+
     /// Advance all non-unloaded live chars
     void advanceLiveChars();
 
@@ -1018,6 +1077,15 @@ private:
 
     TimerMap _intervalTimers;
 
+    /// The expiry time and id of each timer, earliest first.
+    //
+    /// This is a heap, so only the first is really the earliest. Cleared
+    /// timers are added again with time 0, so that executeTimers()
+    /// removes them; their other entry is left until it is reached.
+    typedef std::vector<std::pair<unsigned long, std::uint32_t>> TimerQueue;
+
+    TimerQueue _timerQueue;
+
     size_t _lastTimerId;
 
     /// bit-array for recording the unreleased keys
@@ -1106,6 +1174,20 @@ private:
     };
 
     boost::optional<SoundStream> _timelineSound;
+
+    std::shared_ptr<BitmapCachePool> _bitmapCachePool;
+
+    size_t _displayVersion;
+
+    /// The DisplayObjects invalidated since the last display().
+    std::vector<DisplayObject*> _invalidatedObjects;
+
+    /// Whether too many DisplayObjects were invalidated since the last
+    /// display() to keep them.
+    bool _invalidatedOverflow;
+
+    /// See invalidatedVersion().
+    size_t _invalidatedVersion;
 };
 
 /// Return true if the given string can be interpreted as a _level name
@@ -119,6 +119,8 @@ static const string_table::svt preload_names[] =
     string_table::svt( "onXML", NSV::PROP_ON_XML ),
     string_table::svt( "parseXML", NSV::PROP_PARSE_XML ),
     string_table::svt( "onTimer", NSV::PROP_ON_TIMER ),
+    string_table::svt( ".", NSV::PROP_DOT ),
+    string_table::svt( "..", NSV::PROP_DOT_DOT ),
     string_table::svt( "_parent", NSV::PROP_uPARENT ),
     string_table::svt( "_root", NSV::PROP_uROOT ),
     string_table::svt( "_global", NSV::PROP_uGLOBAL ),
@@ -130,6 +130,8 @@ enum NamedStrings {
         PROP_WIDTH,
         PROP_X,
         PROP_Y,
+        PROP_DOT,
+        PROP_DOT_DOT,
         INTERNAL_HIGHEST_LOWERCASE,
 
         PROP_ADD_LISTENER,
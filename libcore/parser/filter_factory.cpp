@@ -22,9 +22,31 @@
 #include "log.h"
 #include "SWFStream.h"
 #include "Filters.h"
+#include "GnashNumeric.h"
 
 namespace gnash {
 
+namespace {
+
+/// Read the red, green and blue bytes of an RGBA record.
+std::uint32_t
+readRGB(SWFStream& in)
+{
+    const std::uint32_t r = in.read_u8();
+    const std::uint32_t g = in.read_u8();
+    const std::uint32_t b = in.read_u8();
+    return (r << 16) | (g << 8) | b;
+}
+
+/// Read an angle in radians, giving degrees.
+float
+readAngle(SWFStream& in)
+{
+    return in.read_fixed() * 180 / PI;
+}
+
+}
+
 enum filter_types
 {
     DROP_SHADOW = 0,
@@ -113,22 +135,22 @@ bool DropShadowFilter::read(SWFStream& in)
 {
     in.ensureBytes(4 + 8 + 8 + 2 + 1);
 
-    m_color = in.read_u8() << (16 + in.read_u8()) << (8 + in.read_u8());
+    m_color = readRGB(in);
     m_alpha = in.read_u8();
 
     m_blurX = in.read_fixed();
     m_blurY = in.read_fixed();
 
-    m_angle = in.read_fixed();
+    m_angle = readAngle(in);
     m_distance = in.read_fixed();
 
     m_strength = in.read_short_sfixed();
 
     m_inner = in.read_bit(); 
     m_knockout = in.read_bit(); 
-    m_hideObject = in.read_bit(); 
+    m_hideObject = !in.read_bit(); // The flag is set to show the object.
 
-    static_cast<void> (in.read_uint(5)); // Throw these away on purpose.
+    m_quality = static_cast<std::uint8_t> (in.read_uint(5));
 
     IF_VERBOSE_PARSE(
         log_parse(_("   DropShadowFilter: blurX=%f blurY=%f"),
@@ -163,7 +185,7 @@ bool GlowFilter::read(SWFStream& in)
 
     in.ensureBytes(4 + 8 + 2 + 1);
 
-    m_color = in.read_u8() << (16 + in.read_u8()) << (8 + in.read_u8());
+    m_color = readRGB(in);
     m_alpha = in.read_u8();
 
     m_blurX = in.read_fixed();
@@ -173,8 +195,9 @@ bool GlowFilter::read(SWFStream& in)
 
     m_inner = in.read_bit(); 
     m_knockout = in.read_bit(); 
+    in.read_bit(); // composite source, always set.
 
-    static_cast<void> (in.read_uint(6)); // Throw these away.
+    m_quality = static_cast<std::uint8_t> (in.read_uint(5));
 
     IF_VERBOSE_PARSE(
         log_parse(_("   GlowFilter "));
@@ -190,29 +213,29 @@ bool BevelFilter::read(SWFStream& in)
     // TODO: It is possible that the order of these two should be reversed.
     // highlight might come first. Find out for sure and then fix and remove
     // this comment.
-    m_shadowColor = in.read_u8() << (16 + in.read_u8()) << (8 + in.read_u8());
+    m_shadowColor = readRGB(in);
     m_shadowAlpha = in.read_u8();
 
-    m_highlightColor = in.read_u8() << (16 + in.read_u8()) << (8 + in.read_u8());
+    m_highlightColor = readRGB(in);
     m_highlightAlpha = in.read_u8();
 
     m_blurX = in.read_fixed();
     m_blurY = in.read_fixed();
 
-    m_angle = in.read_fixed();
+    m_angle = readAngle(in);
     m_distance = in.read_fixed();
     
     m_strength = in.read_short_sfixed();
 
     bool inner_shadow = in.read_bit(); 
     m_knockout = in.read_bit(); 
-    in.read_bit();  // reserved ?
+    in.read_bit();  // composite source, always set.
     bool on_top = in.read_bit(); 
 
-    // Set the bevel type. top and inner is full, top is outer, inner is inner
-    m_type = on_top ? (inner_shadow ? FULL_BEVEL : OUTER_BEVEL) : INNER_BEVEL;
+    // Set the bevel type. On top is full, otherwise inner or outer.
+    m_type = on_top ? FULL_BEVEL : (inner_shadow ? INNER_BEVEL : OUTER_BEVEL);
     
-    static_cast<void> (in.read_uint(4)); // Throw these away.
+    m_quality = static_cast<std::uint8_t> (in.read_uint(4));
 
     IF_VERBOSE_PARSE(
         log_parse(_("   BevelFilter "));
@@ -235,7 +258,7 @@ bool GradientGlowFilter::read(SWFStream& in)
 
     for (int i = 0; i < count; ++i)
     {
-        m_colors.push_back(in.read_u8() << (16 + in.read_u8()) << (8 + in.read_u8()));
+        m_colors.push_back(readRGB(in));
         m_alphas.push_back(in.read_u8());
     }
 
@@ -247,17 +270,17 @@ bool GradientGlowFilter::read(SWFStream& in)
     m_blurX = in.read_fixed();
     m_blurY = in.read_fixed();
 
-    m_angle = in.read_fixed();
+    m_angle = readAngle(in);
     m_distance = in.read_fixed();
 
     m_strength = in.read_short_sfixed();
 
     bool inner = in.read_bit();
     m_knockout = in.read_bit();
-    in.read_bit(); // reserved ?
+    in.read_bit(); // composite source, always set.
     bool outer = in.read_bit(); 
 
-    m_type = outer ? (inner ? FULL_GLOW : OUTER_GLOW) : INNER_GLOW;
+    m_type = outer ? FULL_GLOW : (inner ? INNER_GLOW : OUTER_GLOW);
 
     m_quality = static_cast<std::uint8_t> (in.read_uint(4));
 
@@ -289,7 +312,7 @@ ConvolutionFilter::read(SWFStream& in)
         _matrix.push_back(in.read_long_float());
     }
 
-    _color = in.read_u8() << (16 + in.read_u8()) << (8 + in.read_u8());
+    _color = readRGB(in);
     _alpha = in.read_u8();
 
     static_cast<void> (in.read_uint(6)); // Throw away.
@@ -345,7 +368,7 @@ bool GradientBevelFilter::read(SWFStream& in)
     m_ratios.reserve(count);
     for (int i = 0; i < count; ++i)
     {
-        m_colors.push_back(in.read_u8() << (16 + in.read_u8()) << (8 + in.read_u8()));
+        m_colors.push_back(readRGB(in));
         m_alphas.push_back(in.read_u8());
     }
 
@@ -357,17 +380,17 @@ bool GradientBevelFilter::read(SWFStream& in)
     m_blurX = in.read_fixed();
     m_blurY = in.read_fixed();
 
-    m_angle = in.read_fixed();
+    m_angle = readAngle(in);
     m_distance = in.read_fixed();
 
     m_strength = in.read_short_sfixed();
 
     bool inner = in.read_bit();
     m_knockout = in.read_bit();
-    in.read_bit(); // reserved ?
+    in.read_bit(); // composite source, always set.
     bool outer = in.read_bit();
 
-    m_type = outer ? (inner ? FULL_BEVEL : OUTER_BEVEL) : INNER_BEVEL;
+    m_type = outer ? FULL_BEVEL : (inner ? INNER_BEVEL : OUTER_BEVEL);
 
     m_quality = static_cast<std::uint8_t> (in.read_uint(4));
 
@@ -59,6 +59,7 @@
 #include <cstdint>
 
 #include "DefinitionTag.h"
+#include "TimelineCheckpoints.h"
 #include "log.h"
 
 // Forward declarations
@@ -161,6 +162,14 @@ public:
 		return nullptr;
 	}
 
+	/// The DisplayList checkpoints of the timeline.
+	//
+	/// They are made as MovieClips of this definition go back to
+	/// earlier frames.
+	TimelineCheckpoints& timelineCheckpoints() const {
+		return _timelineCheckpoints;
+	}
+
 
 	typedef std::pair<int, std::string> ImportSpec;
 	typedef std::vector< ImportSpec > Imports;
@@ -464,6 +473,10 @@ protected:
     {}
 
     virtual ~movie_definition() {}
+
+private:
+
+    mutable TimelineCheckpoints _timelineCheckpoints;
 };
 
 } // namespace gnash
@@ -26,6 +26,7 @@
 #include "DefineMorphShapeTag.h"
 
 #include <cstdint>
+#include <algorithm>
 
 #include "TypesParser.h"
 #include "MorphShape.h"
@@ -42,6 +43,18 @@
 namespace gnash {
 namespace SWF {
 
+namespace {
+
+/// How many edges the cached shapes of a DefineMorphShapeTag may have
+/// together, as a rough bound on their memory.
+const size_t maxCachedEdges = 1 << 16;
+
+/// The least and most shapes cached, whatever their size.
+const size_t minCachedShapes = 2;
+const size_t maxCachedShapes = 64;
+
+}
+
 void
 DefineMorphShapeTag::loader(SWFStream& in, TagType tag, movie_definition& md,
         const RunResources& r)
@@ -60,7 +73,8 @@ DefineMorphShapeTag::loader(SWFStream& in, TagType tag, movie_definition& md,
 DefineMorphShapeTag::DefineMorphShapeTag(SWFStream& in, TagType tag,
         movie_definition& md, const RunResources& r, std::uint16_t id)
     :
-    DefinitionTag(id)
+    DefinitionTag(id),
+    _cacheSize(minCachedShapes)
 {
     read(in, tag, md, r);
 }
@@ -73,10 +87,42 @@ DefineMorphShapeTag::createDisplayObject(Global_as& gl,
 }
 
 void
-DefineMorphShapeTag::display(Renderer& renderer, const ShapeRecord& shape,
+DefineMorphShapeTag::display(Renderer& renderer, const MorphedShape& shape,
         const Transform& xform) const
 {
-    renderer.drawShape(shape, xform);
+    renderer.drawDefinedShape(shape.shape(), xform, shape);
+}
+
+boost::intrusive_ptr<const MorphedShape>
+DefineMorphShapeTag::shape(std::uint16_t ratio) const
+{
+    std::vector<CachedShape>::iterator it = std::find_if(_cache.begin(),
+            _cache.end(), [ratio](const CachedShape& c) {
+                return c.first == ratio;
+            });
+
+    if (it != _cache.end()) {
+        std::rotate(it, it + 1, _cache.end());
+        return _cache.back().second;
+    }
+
+    boost::intrusive_ptr<MorphedShape> morphed;
+
+    if (_cache.size() >= _cacheSize) {
+        // The least recently used shape is tweened again if nothing
+        // else holds it any more, otherwise it's dropped.
+        if (_cache.front().second->get_ref_count() == 1) {
+            morphed = _cache.front().second;
+        }
+        _cache.erase(_cache.begin());
+    }
+
+    if (!morphed) morphed = new MorphedShape(_shape1);
+
+    morphed->_shape.setLerp(_shape1, _shape2, *_edges, ratio / 65535.0);
+    _cache.push_back(CachedShape(ratio, morphed));
+
+    return morphed;
 }
 
 void
@@ -147,6 +193,15 @@ DefineMorphShapeTag::read(SWFStream& in, TagType tag, movie_definition& md,
 
     assert((_shape1.subshapes().size() == _shape2.subshapes().size()) &&
         (_shape2.subshapes().size() <= 1));
+
+    _edges.reset(new MorphEdges(_shape1, _shape2));
+
+    size_t edges = 0;
+    for (const Subshape& s : _shape1.subshapes()) {
+        for (const Path& p : s.paths()) edges += p.size();
+    }
+    _cacheSize = std::min(maxCachedShapes,
+            std::max(minCachedShapes, maxCachedEdges / (edges + 1)));
 }
 
 } // namespace SWF
@@ -23,9 +23,15 @@
 #ifndef GNASH_SWF_MORPH_SHAPE_H
 #define GNASH_SWF_MORPH_SHAPE_H
 
+#include <memory>
+#include <vector>
+#include <utility>
+#include <boost/intrusive_ptr.hpp>
+
 #include "SWF.h"
 #include "ShapeRecord.h"
 #include "DefinitionTag.h"
+#include "ref_counted.h"
 
 // Forward declarations.
 namespace gnash {
@@ -40,6 +46,30 @@ namespace gnash {
 namespace gnash {
 namespace SWF {
 
+/// The shape of a DefineMorphShapeTag at one ratio.
+//
+/// It doesn't change once made, so the MorphShapes at the same ratio
+/// share it, and renderers that draw the frame later may keep it.
+class MorphedShape : public ref_counted
+{
+public:
+
+    const ShapeRecord& shape() const {
+        return _shape;
+    }
+
+private:
+
+    friend class DefineMorphShapeTag;
+
+    explicit MorphedShape(const ShapeRecord& shape)
+        :
+        _shape(shape)
+    {}
+
+    ShapeRecord _shape;
+};
+
 /// DefineMorphShape tag
 //
 class DefineMorphShapeTag : public DefinitionTag
@@ -54,9 +84,16 @@ public:
 	virtual DisplayObject* createDisplayObject(Global_as& gl,
             DisplayObject* parent) const;
 
-    void display(Renderer& renderer, const ShapeRecord& shape,
+    void display(Renderer& renderer, const MorphedShape& shape,
             const Transform& base) const;
 
+    /// The shape at a ratio, from 0 for shape1 to 65535 for shape2.
+    //
+    /// The shapes of the last ratios asked for are cached, so that
+    /// MorphShapes at the same ratio, and tweens that loop, don't tween
+    /// the edges again.
+    boost::intrusive_ptr<const MorphedShape> shape(std::uint16_t ratio) const;
+
     const ShapeRecord& shape1() const { 
         return _shape1;
     }
@@ -95,6 +132,18 @@ private:
     
     SWFRect _bounds;
 
+    /// The edges of the two shapes, paired up for tweening.
+    std::unique_ptr<const MorphEdges> _edges;
+
+    /// The most shapes cached.
+    size_t _cacheSize;
+
+    typedef std::pair<std::uint16_t, boost::intrusive_ptr<MorphedShape> >
+        CachedShape;
+
+    /// The cached shapes, the most recently used last.
+    mutable std::vector<CachedShape> _cache;
+
 };
 
 } // namespace SWF
@@ -88,7 +88,7 @@ DefineShapeTag::DefineShapeTag(SWFStream& in, TagType tag,
 void
 DefineShapeTag::display(Renderer& renderer, const Transform& xform) const
 {
-    renderer.drawShape(_shape, xform);
+    renderer.drawDefinedShape(_shape, xform, *this);
 }
 
 } // namespace SWF
@@ -387,10 +387,9 @@ PlaceObject2Tag::readPlaceObject3(SWFStream& in)
     }
 
     if (hasFilters()) {
-        Filters v; // TODO: Attach the filters to the display object.
-        filter_factory::read(in, true, &v);
-	    // at time of writing no renderer supports bitmap filters
-	    LOG_ONCE( log_unimpl("Bitmap filters") );
+        std::shared_ptr<Filters> v(new Filters);
+        filter_factory::read(in, true, v.get());
+        if (!v->empty()) _filters = v;
     }
 
     if (hasBlendMode()) {
@@ -410,10 +409,8 @@ PlaceObject2Tag::readPlaceObject3(SWFStream& in)
         // with both PlaceActions and bitmap caching, and the reserved bytes
         // of the PlaceActions (see readPlaceActions) are not 0 if this byte
         // isn't read.
-        // TODO: set object property
         in.ensureBytes(1);
         bitmask = in.read_u8();
-	    LOG_ONCE(log_unimpl("Bitmap caching"));
         UNUSED(bitmask);
     }
 
@@ -20,12 +20,14 @@
 #define GNASH_SWF_PLACEOBJECT2TAG_H
 
 #include <string>
+#include <memory>
 #include <boost/ptr_container/ptr_vector.hpp>
 
 #include "DisplayListTag.h" // for inheritance
 #include "SWF.h" // for TagType definition
 #include "SWFMatrix.h" // for composition
 #include "SWFCxForm.h" // for composition 
+#include "Filters.h" // for composition
 
 // Forward declarations
 namespace gnash {
@@ -89,6 +91,15 @@ public:
     typedef boost::ptr_vector<action_buffer> ActionBuffers;
     typedef boost::ptr_vector<swf_event> EventHandlers;
 
+    /// NOTE: getPlaceType() is dependent on the enum values.
+    enum PlaceType
+    {
+        REMOVE  = 0, 
+        MOVE    = 1,
+        PLACE   = 2,
+        REPLACE = 3
+    };
+
     PlaceObject2Tag(const movie_definition& def);
 
     ~PlaceObject2Tag();
@@ -140,6 +151,14 @@ public:
         return m_has_flags3 & HAS_FILTERS_MASK;
     }
 
+    /// Get the filters, or null if there are none.
+    //
+    /// The filters are shared by all the DisplayObjects placed with
+    /// this tag.
+    const std::shared_ptr<const Filters>& getFilters() const {
+        return _filters;
+    }
+
     /// Get an associated blend mode.
     //
     /// This is stored as a uint8_t to allow for future expansion of
@@ -173,14 +192,7 @@ private:
     
     std::uint8_t _blendMode;
 
-    /// NOTE: getPlaceType() is dependent on the enum values.
-    enum PlaceType
-    {
-        REMOVE  = 0, 
-        MOVE    = 1,
-        PLACE   = 2,
-        REPLACE = 3
-    };
+    std::shared_ptr<const Filters> _filters;
 
     enum has_flags2_mask_e
     {
@@ -20,6 +20,11 @@
 #include "ShapeRecord.h"
 
 #include <vector>
+#include <cassert>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "TypesParser.h"
 #include "utility.h"
@@ -45,6 +50,9 @@ namespace {
 // Functors for path and style manipulation.
 namespace {
 
+/// Shapes with fewer edges than this are hit tested edge by edge.
+const size_t minBandedEdges = 64;
+
 template<typename T>
 class Lerp
 {
@@ -90,6 +98,41 @@ ShapeRecord::clear()
 {
     _bounds.set_null();
     _subshapes.clear();
+    _edgeBands.reset();
+}
+
+bool
+ShapeRecord::pointTest(std::int32_t x, std::int32_t y,
+        const SWFMatrix& wm) const
+{
+    if (!_edgeBands) {
+        size_t edges = 0;
+        for (const Subshape& subshape : _subshapes) {
+            for (const Path& p : subshape.paths()) {
+                edges += p.size();
+            }
+        }
+        if (edges >= minBandedEdges) {
+            std::shared_ptr<std::vector<geometry::EdgeBands> > bands(
+                    new std::vector<geometry::EdgeBands>);
+            bands->reserve(_subshapes.size());
+            for (const Subshape& subshape : _subshapes) {
+                bands->push_back(geometry::EdgeBands(subshape.paths()));
+            }
+            _edgeBands = bands;
+        }
+    }
+
+    for (size_t i = 0; i < _subshapes.size(); ++i) {
+        const Subshape& subshape = _subshapes[i];
+        const bool hit = _edgeBands ?
+            geometry::pointTest(subshape.paths(), subshape.lineStyles(),
+                    x, y, wm, (*_edgeBands)[i]) :
+            geometry::pointTest(subshape.paths(), subshape.lineStyles(),
+                    x, y, wm);
+        if (hit) return true;
+    }
+    return false;
 }
 
 void
@@ -130,12 +173,14 @@ Subshape::computeBounds(int swfVersion) const
 
 void
 ShapeRecord::setLerp(const ShapeRecord& aa, const ShapeRecord& bb,
-        const double ratio)
+        const MorphEdges& edges, const double ratio)
 {
     if (_subshapes.empty()) {
        return;
     }
 
+    _edgeBands.reset();
+
     // Update current bounds.
     _bounds.set_lerp(aa.getBounds(), bb.getBounds(), ratio);
     const Subshape& a = aa.subshapes().front();
@@ -155,40 +200,51 @@ ShapeRecord::setLerp(const ShapeRecord& aa, const ShapeRecord& bb,
     std::for_each(_subshapes.front().lineStyles().begin(), _subshapes.front().lineStyles().end(),
             Lerp<LineStyles>(ls1, ls2, ratio));
 
+    // shape
+    edges.lerp(_subshapes.front().paths(), ratio);
+}
+
+MorphEdges::MorphEdges(const ShapeRecord& aa, const ShapeRecord& bb)
+{
+    if (aa.subshapes().empty() || bb.subshapes().empty()) return;
+
     // This is used for cases in which number
     // of paths in start shape and end shape are not
     // the same.
     const Path empty_path;
     const Edge empty_edge;
 
-    // shape
-    const Paths& paths1 = a.paths();
-    const Paths& paths2 = b.paths();
-    for (size_t i = 0, k = 0, n = 0; i < _subshapes.front().paths().size(); i++) {
-        Path& p = _subshapes.front().paths()[i];
-        const Path& p1 = i < paths1.size() ? paths1[i] : empty_path;
-        const Path& p2 = n < paths2.size() ? paths2[n] : empty_path;
+    const Subshape::Paths& paths1 = aa.subshapes().front().paths();
+    const Subshape::Paths& paths2 = bb.subshapes().front().paths();
 
-        const float new_ax = lerp<float>(p1.ap.x, p2.ap.x, ratio);
-        const float new_ay = lerp<float>(p1.ap.y, p2.ap.y, ratio);
+    size_t coords = 0;
+    for (const Path& p : paths1) coords += 2 + p.size() * 4;
+    _start.reserve(coords);
+    _delta.reserve(coords);
+    _rightFills.reserve(paths1.size());
 
-        p.reset(new_ax, new_ay, p1.getLeftFill(),
-                p2.getRightFill(), p1.getLineStyle());
+    // The differences are worked out in float, as the tween is.
+    auto add = [this](float from, float to) {
+        _start.push_back(from);
+        _delta.push_back(to - from);
+    };
 
-        //  edges;
-        const size_t len = p1.size();
-        p.m_edges.resize(len);
+    for (size_t i = 0, k = 0, n = 0; i < paths1.size(); i++) {
+        const Path& p1 = paths1[i];
+        const Path& p2 = n < paths2.size() ? paths2[n] : empty_path;
 
-        for (size_t j=0; j < p.size(); j++) {
-            Edge& e = p[j];
-            const Edge& e1 = j < p1.size() ? p1[j] : empty_edge;
+        _rightFills.push_back(p2.getRightFill());
+        add(p1.ap.x, p2.ap.x);
+        add(p1.ap.y, p2.ap.y);
 
+        for (size_t j = 0; j < p1.size(); j++) {
+            const Edge& e1 = p1[j];
             const Edge& e2 = k < p2.size() ? p2[k] : empty_edge;
 
-            e.cp.x = static_cast<int>(lerp<float>(e1.cp.x, e2.cp.x, ratio));
-            e.cp.y = static_cast<int>(lerp<float>(e1.cp.y, e2.cp.y, ratio));
-            e.ap.x = static_cast<int>(lerp<float>(e1.ap.x, e2.ap.x, ratio));
-            e.ap.y = static_cast<int>(lerp<float>(e1.ap.y, e2.ap.y, ratio));
+            add(e1.cp.x, e2.cp.x);
+            add(e1.cp.y, e2.cp.y);
+            add(e1.ap.x, e2.ap.x);
+            add(e1.ap.y, e2.ap.y);
             ++k;
 
             if (p2.size() <= k) {
@@ -199,6 +255,51 @@ ShapeRecord::setLerp(const ShapeRecord& aa, const ShapeRecord& bb,
     }
 }
 
+void
+MorphEdges::lerp(Subshape::Paths& paths, float ratio) const
+{
+    assert(paths.size() == _rightFills.size());
+
+    const float* start = _start.data();
+    const float* delta = _delta.data();
+
+#ifdef __SSE2__
+    const __m128 r = _mm_set1_ps(ratio);
+#endif
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        Path& p = paths[i];
+
+        p.ap.x = static_cast<int>(delta[0] * ratio + start[0]);
+        p.ap.y = static_cast<int>(delta[1] * ratio + start[1]);
+        p.m_fill1 = _rightFills[i];
+        start += 2;
+        delta += 2;
+
+        for (Edge& e : p.m_edges) {
+#ifdef __SSE2__
+            // The four coordinates of an edge are one vector.
+            const __m128 v = _mm_add_ps(
+                    _mm_mul_ps(_mm_loadu_ps(delta), r), _mm_loadu_ps(start));
+            std::int32_t c[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(c),
+                    _mm_cvttps_epi32(v));
+            e.cp.x = c[0];
+            e.cp.y = c[1];
+            e.ap.x = c[2];
+            e.ap.y = c[3];
+#else
+            e.cp.x = static_cast<int>(delta[0] * ratio + start[0]);
+            e.cp.y = static_cast<int>(delta[1] * ratio + start[1]);
+            e.ap.x = static_cast<int>(delta[2] * ratio + start[2]);
+            e.ap.y = static_cast<int>(delta[3] * ratio + start[3]);
+#endif
+            start += 4;
+            delta += 4;
+        }
+    }
+}
+
 unsigned
 ShapeRecord::readStyleChange(SWFStream& in, size_t num_style_bits, size_t numStyles)
 {
@@ -233,6 +334,8 @@ ShapeRecord::read(SWFStream& in, SWF::TagType tag, movie_definition& m,
                             tag == SWF::DEFINESHAPE4 ||
                             tag == SWF::DEFINESHAPE4_);
 
+    _edgeBands.reset();
+
     Subshape subshape;
     if (!_subshapes.empty()) {
     	// This is a little naughty. In case we're reading DEFINEMORPH, we'll
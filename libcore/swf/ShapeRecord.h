@@ -26,11 +26,15 @@
 #include "SWFRect.h"
 
 #include <vector>
+#include <memory>
 
 
 namespace gnash {
     class movie_definition;
     class RunResources;
+    namespace SWF {
+        class MorphEdges;
+    }
 }
 
 namespace gnash {
@@ -161,6 +165,7 @@ public:
 
     void addSubshape(const Subshape& subshape) {
     	_subshapes.push_back(subshape);
+    	_edgeBands.reset();
     }
 
     const SWFRect& getBounds() const {
@@ -169,9 +174,12 @@ public:
 
     /// Set to the lerp of two ShapeRecords.
     //
-    /// Used in shape morphing.
+    /// Used in shape morphing. This shape must be a copy of the first
+    /// one, or have been set by this before.
+    ///
+    /// @param edges    The edges of a and b, paired up.
     void setLerp(const ShapeRecord& a, const ShapeRecord& b,
-            const double ratio);
+            const MorphEdges& edges, const double ratio);
 
     /// Reset all shape data.
     void clear();
@@ -180,16 +188,13 @@ public:
         _bounds = bounds;
     }
 
+    /// Whether a point is inside the shape, or on one of its strokes.
+    //
+    /// Shapes with many edges sort them into geometry::EdgeBands the first
+    /// time this is called, so later tests only look at the edges near
+    /// the point.
     bool pointTest(std::int32_t x, std::int32_t y,
-                   const SWFMatrix& wm) const {
-        for (const Subshape& subshape : _subshapes) {
-
-            if (geometry::pointTest(subshape.paths(), subshape.lineStyles(), x, y, wm)) {
-        	    return true;
-            }
-        }
-        return false;
-    }
+                   const SWFMatrix& wm) const;
 
 private:
 
@@ -207,6 +212,45 @@ private:
 
     SWFRect _bounds;
     Subshapes _subshapes;
+
+    /// The edge bands of each subshape, made by pointTest() when the
+    /// shape is complex enough. Copies of the shape share them.
+    mutable std::shared_ptr<const std::vector<geometry::EdgeBands> >
+        _edgeBands;
+};
+
+/// The edges of two shapes that are tweened between, paired up.
+//
+/// The coordinates of the anchors and edges of the first shape are kept
+/// in one array, and their distances to the second shape's in another,
+/// in the order of the first shape's paths. Tweening a shape is then one
+/// pass over the arrays, four coordinates at a time, instead of looking
+/// up the pair of each edge every time.
+class MorphEdges
+{
+public:
+
+    /// Pair the edges of two shapes.
+    //
+    /// The edges of each path of the first shape are paired with the
+    /// next ones of the second, in order.
+    MorphEdges(const ShapeRecord& a, const ShapeRecord& b);
+
+    /// Set the paths of the first shape's subshape to a tween.
+    //
+    /// @param paths    A copy of the first shape's paths.
+    /// @param ratio    From 0 for the first shape to 1 for the second.
+    void lerp(Subshape::Paths& paths, float ratio) const;
+
+private:
+
+    /// The right fill of each path, which comes from the second shape.
+    std::vector<unsigned> _rightFills;
+
+    /// The anchor of each path, followed by the control and anchor
+    /// points of its edges.
+    std::vector<float> _start;
+    std::vector<float> _delta;
 };
 
 std::ostream& operator<<(std::ostream& o, const ShapeRecord& sh);
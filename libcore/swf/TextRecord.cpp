@@ -257,7 +257,7 @@ TextRecord::displayRecords(Renderer& renderer, const Transform& xform,
                 ShapeRecord* glyph = fnt->get_glyph(index, embedded);
 
                 // Draw the DisplayObject using the filled outline.
-                if (glyph) renderer.drawGlyph(*glyph, textColor, m);
+                if (glyph) renderer.drawDefinedGlyph(*glyph, textColor, m, *fnt);
             }
             x += ge.advance;
         }
@@ -28,6 +28,9 @@
 #include <vector>
 #include <boost/random.hpp>
 #include <algorithm> 
+#include <limits>
+#include <cstdint>
+#include <cmath>
 
 #include "log.h"
 #include "SWF.h"
@@ -78,6 +81,11 @@ namespace {
     /// @return     null if the value cannot be converted to an object.
     as_object* safeToObject(VM& vm, const as_value& val);
 
+    /// Whether a member name is a number that is an array index.
+    //
+    /// Indices are looked up as elements, without formatting the number.
+    bool isIndexName(VM& vm, const as_value& name, size_t& index);
+
     /// Common code for ActionGetUrl and ActionGetUrl2
     //
     /// @param target         the target window or _level1 to _level10
@@ -1020,9 +1028,11 @@ ActionStringConcat(ActionExec& thread)
     const int version = getSWFVersion(env);
 
     const std::string& op1 = env.top(0).to_string(version);
-    const std::string& op2 = env.top(1).to_string(version);
 
-    env.top(1).set_string(op2 + op1);
+    as_value& op2 = env.top(1);
+    if (!op2.is_string()) op2.set_string(op2.to_string(version));
+
+    op2.append_string(op1);
     env.drop(1);
 }
 
@@ -2249,6 +2259,10 @@ ActionCallFunction(ActionExec& thread)
         args += env.pop();
     } 
 
+    if (Profiler* p = getVM(env).profiler()) {
+        p->calling(getURI(getVM(env), funcname));
+    }
+
     as_value result = invoke(function, env, this_ptr,
                   args, super, &(thread.code.getMovieDefinition()));
 
@@ -2317,6 +2331,10 @@ ActionNew(ActionExec& thread)
         return;
     }
 
+    if (Profiler* p = getVM(env).profiler()) {
+        p->calling(getURI(getVM(env), classname));
+    }
+
     // It is possible for constructors to fail, for instance if a
     // conversion to object calls a built-in constructor that has been
     // deleted. BitmapData also fails to construct anything under
@@ -2591,9 +2609,13 @@ ActionGetMember(ActionExec& thread)
                    target, static_cast<void*>(obj));
     );
 
-    const ObjectURI& k = getURI(getVM(env), member_name.to_string());
+    VM& vm = getVM(env);
+    size_t index;
+    const bool found = isIndexName(vm, member_name, index) ?
+        obj->get_element(index, &env.top(1)) :
+        obj->get_member(getURI(vm, member_name.to_string()), &env.top(1));
 
-    if (!obj->get_member(k, &env.top(1))) {
+    if (!found) {
         IF_VERBOSE_ASCODING_ERRORS(
             log_aserror("Reference to undefined member %s of object %s",
                 member_name, target);
@@ -2615,10 +2637,15 @@ ActionSetMember(ActionExec& thread)
     as_environment& env = thread.env;
 
     as_object* obj = safeToObject(getVM(thread.env), env.top(2));
-    const std::string& member_name = env.top(1).to_string();
     const as_value& member_value = env.top(0);
 
-    if (member_name.empty()) {
+    VM& vm = getVM(env);
+    size_t index;
+    const bool isIndex = isIndexName(vm, env.top(1), index);
+    const std::string& member_name = isIndex ? std::string() :
+        env.top(1).to_string();
+
+    if (!isIndex && member_name.empty()) {
         IF_VERBOSE_ASCODING_ERRORS (
             // Invalid object, can't set.
             log_aserror(_("ActionSetMember: %s.%s=%s: member name "
@@ -2627,12 +2654,13 @@ ActionSetMember(ActionExec& thread)
         );
     }
     else if (obj) {
-        obj->set_member(getURI(getVM(env), member_name), member_value);
+        if (isIndex) obj->set_element(index, member_value);
+        else obj->set_member(getURI(vm, member_name), member_value);
 
         IF_VERBOSE_ACTION (
             log_action(_("-- set_member %s.%s=%s"),
                 env.top(2),
-                member_name,
+                env.top(1),
                 member_value);
         );
     }
@@ -2643,7 +2671,7 @@ ActionSetMember(ActionExec& thread)
         IF_VERBOSE_ASCODING_ERRORS(
             // Invalid object, can't set.
             log_aserror(_("-- set_member %s.%s=%s on invalid object!"),
-                env.top(2), member_name, member_value);
+                env.top(2), env.top(1), member_value);
         );
     }
 
@@ -2806,6 +2834,11 @@ ActionCallMethod(ActionExec& thread)
     fn_call call(this_ptr, env, args);
     call.super = super;
     call.callerDef = &(thread.code.getMovieDefinition());
+
+    if (Profiler* p = getVM(env).profiler()) {
+        if (!noMeth) p->calling(methURI);
+    }
+
     as_value result;
     try {
         result = method_obj->call(call);
@@ -2889,6 +2922,12 @@ ActionNewMethod(ActionExec& thread)
         return;
     }
 
+    if (Profiler* p = getVM(env).profiler()) {
+        if (!method_string.empty()) {
+            p->calling(getURI(getVM(env), method_string));
+        }
+    }
+
     // Construct the object
     // It is possible for constructors to fail, for instance if a
     // conversion to object calls a built-in constructor that has been
@@ -3455,6 +3494,22 @@ safeToObject(VM& vm, const as_value& val)
     }
 }
 
+bool
+isIndexName(VM& vm, const as_value& name, size_t& index)
+{
+    if (!name.is_number()) return false;
+
+    // Other numbers are converted to a string as before.
+    const double d = toNumber(name, vm);
+    if (!(d >= 0 && d <= std::numeric_limits<std::int32_t>::max())) {
+        return false;
+    }
+    if (d != std::floor(d)) return false;
+
+    index = d;
+    return true;
+}
+
 // Utility: construct an object using given constructor.
 // This is used by both ActionNew and ActionNewMethod and
 // hides differences between builtin and actionscript-defined
@@ -138,6 +138,10 @@ ActionExec::operator()()
         
     _originalTarget = env.target();
 
+    // A function's body is timed as the function.
+    ProfileGuard profile(_func ? nullptr : vm.profiler(), code, env);
+    Profiler* profiler = vm.profiler();
+
     _initialStackSize = env.stack_size();
 
 #if DEBUG_STACK
@@ -255,7 +259,9 @@ ActionExec::operator()()
                 break;
             }
 
+            if (profiler) profiler->beginAction(action_id);
             ash.execute(static_cast<SWF::ActionType>(action_id), *this);
+            if (profiler) profiler->endAction();
 
             // Code round here has to do with bugs: #20974, #21069, #20996,
             // but since there is so much disabled code it's not clear exactly
@@ -20,6 +20,7 @@
 #define GNASH_VM_CALL_STACK_H
 
 #include <vector>
+#include <boost/container/small_vector.hpp>
 
 #include "as_value.h"
 
@@ -44,7 +45,9 @@ class CallFrame
 {
 public:
 
-    typedef std::vector<as_value> Registers;
+    /// Most functions use few enough registers to keep them in the
+    /// CallFrame.
+    typedef boost::container::small_vector<as_value, 16> Registers;
 
     /// Construct a CallFrame for a specific UserFunction
     //
@@ -3342,7 +3342,7 @@ Machine::print_scope_stack()
 void
 Machine::get_args(size_t argc, fn_call::Args& args)
 {
-    std::vector<as_value> v(argc);
+    fn_call::Args::container_type v(argc);
 	for (size_t i = argc; i > 0; --i) {
 		v.at(i-1) = pop_stack();
 	}
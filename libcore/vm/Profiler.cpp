@@ -0,0 +1,242 @@
+// Profiler.cpp: time the ActionScript a movie runs
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <ostream>
+#include <sstream>
+#include <boost/format.hpp>
+
+#include "action_buffer.h"
+#include "as_environment.h"
+#include "DisplayObject.h"
+#include "Function.h"
+#include "string_table.h"
+#include "SWF.h"
+
+namespace gnash {
+
+namespace {
+
+/// A name that can go in a collapsed stack.
+std::string
+stackName(std::string name)
+{
+    std::replace(name.begin(), name.end(), ';', ':');
+    std::replace(name.begin(), name.end(), '\n', ' ');
+    return name;
+}
+
+template<typename Duration>
+double
+millis(Duration d)
+{
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+}
+
+Profiler::Profiler(string_table& st)
+    :
+    _stringTable(st),
+    _named(false),
+    _nodes(1, Node(0, 0)),
+    _stack(1, Frame(0)),
+    _untimed(1),
+    _random(2463534242u)
+{
+}
+
+void
+Profiler::enter(const action_buffer& code, const as_environment& env)
+{
+    // A function's code never starts at 0, where a block's does.
+    enter(Key(&code, 0), [&env] {
+        const DisplayObject* target = env.target();
+        return target ? target->getTarget() : std::string("actions");
+    });
+}
+
+void
+Profiler::enter(const Function& func)
+{
+    const action_buffer& code = func.getActionBuffer();
+    enter(Key(&code, func.getStartPC()), [this, &func, &code] {
+        const std::string& url = code.getDefinitionURL();
+        std::ostringstream s;
+        s << (_named ? calledName() : "function") << " ("
+          << url.substr(url.rfind('/') + 1) << ':' << func.getStartPC()
+          << ')';
+        return s.str();
+    });
+}
+
+void
+Profiler::enter(as_c_function_ptr func)
+{
+    enter(Key(reinterpret_cast<const void*>(func), 0), [this] {
+        return _named ? calledName() : std::string("native");
+    });
+}
+
+template<typename Name>
+void
+Profiler::enter(const Key& key, Name name)
+{
+    size_t function;
+    const auto f = _functionIndex.find(key);
+    if (f == _functionIndex.end()) {
+        // Code of the same name is counted together, such as the
+        // blocks of each frame of a clip.
+        const std::string n = stackName(name());
+        function = _functionNames.emplace(n, _functions.size()).first->second;
+        if (function == _functions.size()) _functions.emplace_back(n);
+        _functionIndex.emplace(key, function);
+    }
+    else function = f->second;
+
+    _named = false;
+
+    const size_t parent = _stack.back().node;
+    const std::uint64_t call =
+        (static_cast<std::uint64_t>(parent) << 32) | function;
+
+    size_t node;
+    const auto n = _nodeIndex.find(call);
+    if (n == _nodeIndex.end()) {
+        node = _nodes.size();
+        _nodes.emplace_back(parent, function);
+        _nodeIndex.emplace(call, node);
+    }
+    else node = n->second;
+
+    FunctionStats& s = _functions[function];
+    ++s.calls;
+    ++s.active;
+
+    _stack.emplace_back(node);
+}
+
+void
+Profiler::leave()
+{
+    assert(_stack.size() > 1);
+
+    const Frame& f = _stack.back();
+    const Clock::duration inclusive = Clock::now() - f.start;
+    const Clock::duration exclusive = inclusive - f.children;
+
+    Node& n = _nodes[f.node];
+    n.exclusive += exclusive;
+
+    FunctionStats& s = _functions[n.function];
+    s.exclusive += exclusive;
+    if (!--s.active) s.inclusive += inclusive;
+
+    _stack.pop_back();
+    _stack.back().children += inclusive;
+}
+
+void
+Profiler::writeStacks(std::ostream& o) const
+{
+    // Callers always come before what they call.
+    std::vector<std::string> stacks(_nodes.size());
+
+    for (size_t i = 1; i < _nodes.size(); ++i) {
+        const Node& n = _nodes[i];
+        stacks[i] = n.parent ? stacks[n.parent] + ';' : std::string();
+        stacks[i] += _functions[n.function].name;
+
+        const auto micros =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                    n.exclusive).count();
+        if (micros > 0) o << stacks[i] << ' ' << micros << '\n';
+    }
+}
+
+void
+Profiler::writeReport(std::ostream& o) const
+{
+    boost::format fmt("%12d %14.3f %14.3f  %s\n");
+
+    std::vector<const FunctionStats*> functions;
+    for (const FunctionStats& s : _functions) functions.push_back(&s);
+
+    std::stable_sort(functions.begin(), functions.end(),
+            [](const FunctionStats* a, const FunctionStats* b) {
+                return a->exclusive > b->exclusive;
+            });
+
+    o << "Functions:\n"
+      << boost::format("%12s %14s %14s  %s\n") % "calls" % "inclusive ms" %
+            "exclusive ms" % "name";
+    for (const FunctionStats* s : functions) {
+        o << fmt % s->calls % millis(s->inclusive) % millis(s->exclusive) %
+            s->name;
+    }
+
+    // Only some opcodes were timed, so scale their time by how many ran.
+    std::vector<std::pair<double, size_t>> actions;
+    for (size_t i = 0; i < _actions.size(); ++i) {
+        const Stats& s = _actions[i];
+        if (!s.calls) continue;
+        const double scale = s.timed ? double(s.calls) / s.timed : 0;
+        actions.emplace_back(millis(s.exclusive) * scale, i);
+    }
+    std::sort(actions.rbegin(), actions.rend());
+
+    o << "\nOpcodes (time estimated from 1 in 16):\n"
+      << boost::format("%12s %14s %14s  %s\n") % "count" % "inclusive ms" %
+            "exclusive ms" % "opcode";
+    for (const auto& a : actions) {
+        const Stats& s = _actions[a.second];
+        const double scale = s.timed ? double(s.calls) / s.timed : 0;
+        std::ostringstream name;
+        name << static_cast<SWF::ActionType>(a.second);
+        o << fmt % s.calls % (millis(s.inclusive) * scale) % a.first %
+            name.str();
+    }
+}
+
+std::uint32_t
+Profiler::nextSample()
+{
+    // xorshift, for a period that doesn't keep timing the same opcodes of
+    // a loop. It averages 16.
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return 1 + (_random & 31);
+}
+
+std::string
+Profiler::calledName() const
+{
+    return _calling.toString(_stringTable);
+}
+
+} // namespace gnash
+
+// Local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
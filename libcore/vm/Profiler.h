@@ -0,0 +1,240 @@
+// Profiler.h: time the ActionScript a movie runs
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef GNASH_VM_PROFILER_H
+#define GNASH_VM_PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+#include "ObjectURI.h"
+#include "dsodefs.h"
+
+// Forward declarations
+namespace gnash {
+    class action_buffer;
+    class as_environment;
+    class as_value;
+    class fn_call;
+    class Function;
+    class string_table;
+}
+
+namespace gnash {
+
+/// Times the ActionScript a movie runs.
+//
+/// The VM only has a Profiler when profiling was asked for, so that
+/// otherwise it costs a check for one at each call and opcode.
+///
+/// Each function called and each block of actions run by a timeline or an
+/// event is counted, and timed with and without what it calls. The call
+/// stacks are kept as a tree, so that the time spent in each can be written
+/// out as collapsed stacks for flame graphs.
+///
+/// Functions are named by what the script called them the first time
+/// they ran, or by where they are defined. Blocks of actions are the
+/// roots of the stacks, named by the clip they first ran in. Code of
+/// the same name is counted as one.
+///
+/// Each opcode run is counted, but only one in every sixteen or so is
+/// timed, as reading the clock takes about as long as the simpler ones.
+/// Their times are estimated from those timed.
+class DSOEXPORT Profiler : boost::noncopyable
+{
+public:
+
+    typedef as_value (*as_c_function_ptr)(const fn_call& fn);
+
+    Profiler(string_table& st);
+
+    /// Name the next function entered, by what the script called.
+    void calling(const ObjectURI& name) {
+        _calling = name;
+        _named = true;
+    }
+
+    /// Enter a block of actions run by a timeline or an event.
+    void enter(const action_buffer& code, const as_environment& env);
+
+    /// Enter a function defined in a SWF.
+    void enter(const Function& func);
+
+    /// Enter a function implemented in C++.
+    void enter(as_c_function_ptr func);
+
+    /// Leave the block or function entered last.
+    //
+    /// Blocks and functions must be left in the reverse order they
+    /// were entered.
+    void leave();
+
+    /// Start running an opcode.
+    void beginAction(std::uint8_t action) {
+        _named = false;
+        ++_actions[action].calls;
+        if (--_untimed) return;
+        _untimed = nextSample();
+
+        Frame& f = _stack.back();
+        f.action = action;
+        f.actionChildren = f.children;
+        f.actionStart = Clock::now();
+    }
+
+    /// Finish running the opcode started last.
+    void endAction() {
+        Frame& f = _stack.back();
+        if (f.action < 0) return;
+        const Clock::duration inclusive = Clock::now() - f.actionStart;
+        Stats& s = _actions[f.action];
+        ++s.timed;
+        s.inclusive += inclusive;
+        s.exclusive += inclusive - (f.children - f.actionChildren);
+        f.action = -1;
+    }
+
+    /// Write each call stack and the time spent in it for flame graphs.
+    //
+    /// Each line is the names of the functions in the stack, outermost
+    /// first and separated by ';', then the microseconds spent in the
+    /// last one but not in the functions it called.
+    void writeStacks(std::ostream& o) const;
+
+    /// Write the calls and time of each function and opcode.
+    void writeReport(std::ostream& o) const;
+
+private:
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Stats
+    {
+        Stats() : calls(0), timed(0), inclusive(), exclusive() {}
+
+        /// The calls or opcodes run.
+        std::uint64_t calls;
+
+        /// The opcodes timed.
+        std::uint64_t timed;
+
+        Clock::duration inclusive;
+        Clock::duration exclusive;
+    };
+
+    struct FunctionStats : Stats
+    {
+        explicit FunctionStats(std::string n) : name(std::move(n)), active(0)
+        {}
+
+        std::string name;
+
+        /// The calls in progress, so that recursive calls aren't timed
+        /// twice.
+        size_t active;
+    };
+
+    /// A call stack, which is its caller's stack and a function.
+    struct Node
+    {
+        Node(size_t p, size_t f) : parent(p), function(f), exclusive() {}
+        size_t parent;
+        size_t function;
+        Clock::duration exclusive;
+    };
+
+    struct Frame
+    {
+        explicit Frame(size_t n)
+            :
+            node(n),
+            start(Clock::now()),
+            children(),
+            action(-1)
+        {}
+
+        size_t node;
+        Clock::time_point start;
+
+        /// The time spent in the functions called.
+        Clock::duration children;
+
+        /// The opcode being timed, or -1.
+        int action;
+        Clock::time_point actionStart;
+        Clock::duration actionChildren;
+    };
+
+    /// Identifies a function by its code.
+    typedef std::pair<const void*, size_t> Key;
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& k) const {
+            return std::hash<const void*>()(k.first) ^ k.second;
+        }
+    };
+
+    template<typename Name> void enter(const Key& key, Name name);
+
+    /// The number of opcodes to run before timing another.
+    std::uint32_t nextSample();
+
+    /// The name of the function to be entered, if the script called it.
+    std::string calledName() const;
+
+    string_table& _stringTable;
+
+    ObjectURI _calling;
+    bool _named;
+
+    std::vector<FunctionStats> _functions;
+    std::unordered_map<Key, size_t, KeyHash> _functionIndex;
+    std::unordered_map<std::string, size_t> _functionNames;
+
+    /// The first is the root of all the stacks.
+    std::vector<Node> _nodes;
+
+    /// The stacks by their caller's stack and the function called.
+    std::unordered_map<std::uint64_t, size_t> _nodeIndex;
+
+    /// The blocks and functions entered, on the root of all the stacks.
+    std::vector<Frame> _stack;
+
+    std::array<Stats, 256> _actions;
+
+    std::uint32_t _untimed;
+    std::uint32_t _random;
+};
+
+} // namespace gnash
+
+#endif
+
+// Local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
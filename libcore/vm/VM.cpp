@@ -24,6 +24,7 @@
 
 #include "VM.h"
 
+#include <algorithm>
 #include <ostream>
 #include <memory>
 #include <boost/random.hpp> // for random generator
@@ -43,6 +44,7 @@
 #include "namedStrings.h"
 #include "VirtualClock.h" // for getTime()
 #include "GnashNumeric.h"
+#include "as_environment.h"
 
 namespace {
 gnash::RcInitFile& rcfile = gnash::RcInitFile::getDefaultInstance();
@@ -55,14 +57,23 @@ VM::VM(movie_root& root, VirtualClock& clock)
 	_rootMovie(root),
 	_global(new Global_as(*this)),
 	_swfversion(6),
+	_nativesSorted(true),
 	_clock(clock),
 	_stack(),
     _shLib(new SharedObjectLibrary(*this)),
     _rng(clock.elapsed()),
     _constantPool(nullptr)
 {
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point start = Clock::now();
 	NSV::loadStrings(_stringTable);
+    _startupTimes.emplace_back("strings", Clock::now() - start);
+
+    start = Clock::now();
     _global->registerClasses();
+    _startupTimes.emplace_back("classes", Clock::now() - start);
+
 	_clock.restart();
 }
 
@@ -70,6 +81,50 @@ VM::~VM()
 {
 }
 
+ObjectURI
+VM::getIndexKey(size_t i) const
+{
+    // Enough for most Arrays, and not too much to keep for the others.
+    const size_t maxIndexKeys = 65536;
+
+    // The empty name is never an index, so marks the keys not made yet.
+    if (i < _indexKeys.size() && !_indexKeys[i].empty()) {
+        return _indexKeys[i];
+    }
+
+    // Digits have no case, but the string_table has to look that up.
+    // Doing it once here saves it on every caseless comparison with
+    // the key, and PropertyList makes one for every lookup and insertion.
+    ObjectURI key = getURI(*this, std::to_string(i), true);
+    key.noCase(_stringTable);
+
+    // Only the key asked for is made, so that one large index doesn't
+    // put all the ones below it in the string_table.
+    if (i < maxIndexKeys) {
+        if (i >= _indexKeys.size()) _indexKeys.resize(i + 1);
+        _indexKeys[i] = key;
+    }
+    return key;
+}
+
+std::shared_ptr<const TargetPath>
+VM::getTargetPath(const std::string& path)
+{
+    // Enough for the paths of most movies, and not too many strings to
+    // keep for those that make new ones all the time.
+    const size_t maxTargetPaths = 4096;
+
+    TargetPaths::const_iterator it = _targetPaths.find(path);
+    if (it != _targetPaths.end()) return it->second;
+
+    if (_targetPaths.size() >= maxTargetPaths) _targetPaths.clear();
+
+    std::shared_ptr<const TargetPath> target =
+        std::make_shared<const TargetPath>(parseTargetPath(*this, path));
+    _targetPaths.insert(std::make_pair(path, target));
+    return target;
+}
+
 void
 VM::setSWFVersion(int v) 
 {
@@ -264,22 +319,52 @@ VM::popCallFrame()
     _callStack.pop_back();
 }
 
+Profiler&
+VM::startProfiling()
+{
+    if (!_profiler) _profiler.reset(new Profiler(_stringTable));
+    return *_profiler;
+}
+
 void
 VM::registerNative(Global_as::ASFunction fun, unsigned int x, unsigned int y)
 {
     assert(fun);
-    assert(!_asNativeTable[x][y]);
-    _asNativeTable[x][y] = fun;
+    _natives.emplace_back(static_cast<std::uint64_t>(x) << 32 | y, fun);
+    _nativesSorted = false;
 }
 
 NativeFunction*
 VM::getNative(unsigned int x, unsigned int y) const
 {
-    AsNativeTable::const_iterator row = _asNativeTable.find(x);
-    if (row == _asNativeTable.end()) return nullptr;
-    FuncMap::const_iterator col = row->second.find(y);
-    if (col == row->second.end()) return nullptr;
-    Global_as::ASFunction fun = col->second;
+    const auto byKey = [](const Native& a, const Native& b) {
+        return a.first < b.first;
+    };
+
+    if (!_nativesSorted) {
+        std::sort(_natives.begin(), _natives.end(), byKey);
+        _nativesSorted = true;
+
+#ifndef NDEBUG
+        // Duplicates are only found once the table is sorted, so say
+        // which one it was to find where it was registered.
+        const auto dup = std::adjacent_find(_natives.begin(), _natives.end(),
+                [](const Native& a, const Native& b) {
+                    return a.first == b.first;
+                });
+        if (dup != _natives.end()) {
+            log_error("ASnative(%d, %d) was registered twice",
+                    dup->first >> 32, dup->first & 0xffffffff);
+        }
+        assert(dup == _natives.end());
+#endif
+    }
+
+    const Native key(static_cast<std::uint64_t>(x) << 32 | y, nullptr);
+    const auto it = std::lower_bound(_natives.begin(), _natives.end(), key,
+            byKey);
+    if (it == _natives.end() || it->first != key.first) return nullptr;
+    Global_as::ASFunction fun = it->second;
 
     NativeFunction* f = new NativeFunction(*_global, fun);
     
@@ -377,7 +462,7 @@ newAdd(as_value& op1, const as_value& op2, const VM& vm)
 		// use string semantic
 		const int version = vm.getSWFVersion();
 		convertToString(op1, vm);
-		op1.set_string(op1.to_string(version) + r.to_string(version));
+		op1.append_string(r.to_string(version));
         return;
 	}
 
@@ -492,6 +577,7 @@ convertToNumber(as_value& v, const VM& vm)
 as_value&
 convertToString(as_value& v, const VM& vm)
 {
+    if (v.is_string()) return v;
     v.set_string(v.to_string(vm.getSWFVersion()));
     return v;
 }
@@ -25,9 +25,14 @@
 #endif
 
 #include <map>
+#include <unordered_map>
+#include <vector>
 #include <memory> 
 #include <array>
+#include <chrono>
 #include <cstdint>
+#include <string>
+#include <utility>
 #include <boost/random/mersenne_twister.hpp>  // for mt11213b
 #include <boost/noncopyable.hpp>
 
@@ -38,6 +43,7 @@
 #include "namedStrings.h"
 #include "ObjectURI.h"
 #include "ConstantPool.h"
+#include "Profiler.h"
 #include "dsodefs.h"
 #include "utility.h" // for UNUSED
 
@@ -49,6 +55,7 @@ namespace gnash {
     class NativeFunction;
     class SharedObjectLibrary;
     class as_object;
+    struct TargetPath;
     class VirtualClock;
     class UserFunction;
 }
@@ -73,6 +80,10 @@ class DSOEXPORT VM : boost::noncopyable
 public:
 
 	typedef as_value (*as_c_function_ptr)(const fn_call& fn);
+
+    /// The time each phase of starting the VM took, in the order they ran.
+    typedef std::vector<std::pair<std::string,
+            std::chrono::steady_clock::duration>> StartupTimes;
 	
 	/// Initializes the VM
     //
@@ -116,6 +127,20 @@ public:
 	/// Get a reference to the string table used by the VM.
 	string_table& getStringTable() const { return _stringTable; }
 
+	/// Get the key of an array element.
+	//
+	/// The keys of the lower indices are made only once, so that code
+	/// going through an Array doesn't format and look up the same
+	/// strings again and again.
+	ObjectURI getIndexKey(size_t i) const;
+
+	/// Get a target path split into the names of the objects on it.
+	//
+	/// Each path is parsed only the first time, except that they are all
+	/// forgotten when there are too many, as with scripts making paths
+	/// from numbers.
+	std::shared_ptr<const TargetPath> getTargetPath(const std::string& path);
+
 	/// Get version of the player, in a compatible representation
 	//
 	/// This information will be used for the System.capabilities.version
@@ -174,11 +199,20 @@ public:
 	/// - Class Hierarchy object
 	void markReachableResources() const;
 
+	/// Add a function to the ASnative table
+	//
+	/// The table is only sorted when a native is next looked up, so that
+	/// registering all of them at startup is cheap.
 	void registerNative(as_c_function_ptr fun, unsigned int x, unsigned int y);
 
 	/// Return a native function or null
 	NativeFunction* getNative(unsigned int x, unsigned int y) const;
 
+    /// How long constructing this VM took.
+    const StartupTimes& startupTimes() const {
+        return _startupTimes;
+    }
+
     /// Get value of a register (local or global).
     //
     /// When not in a function context the selected register will be
@@ -248,6 +282,12 @@ public:
 
     const ConstantPool *getConstantPool() const { return _constantPool; }
 
+    /// Start timing the ActionScript run, if it isn't already timed.
+    Profiler& startProfiling();
+
+    /// The Profiler timing the ActionScript run, or null if it isn't.
+    Profiler* profiler() const { return _profiler.get(); }
+
 private:
 
 	/// Stage associated with this VM
@@ -259,13 +299,24 @@ private:
 	/// Target SWF version
 	int _swfversion;
 
-	typedef std::map<unsigned int, as_c_function_ptr> FuncMap;
-	typedef std::map<unsigned int, FuncMap> AsNativeTable;
-	AsNativeTable _asNativeTable;
+	/// A native function by its row and column.
+	typedef std::pair<std::uint64_t, as_c_function_ptr> Native;
+
+	/// The ASnative table, sorted by row and column if _nativesSorted.
+	mutable std::vector<Native> _natives;
+	mutable bool _nativesSorted;
 
 	/// Mutable since it should not affect how the VM runs.
 	mutable string_table _stringTable;
 
+	/// The keys of array indices, by index.
+	mutable std::vector<ObjectURI> _indexKeys;
+
+	/// The target paths parsed, by path.
+	typedef std::unordered_map<std::string,
+            std::shared_ptr<const TargetPath>> TargetPaths;
+	TargetPaths _targetPaths;
+
 	VirtualClock& _clock;
 
 	SafeStack<as_value>	_stack;
@@ -281,6 +332,10 @@ private:
     RNG _rng;
 
     const ConstantPool* _constantPool;
+
+    std::unique_ptr<Profiler> _profiler;
+
+    StartupTimes _startupTimes;
 };
 
 // @param lowerCaseHint if true the caller guarantees
@@ -339,6 +394,27 @@ private:
     CallFrame& _callFrame;
 };
 
+/// Times a block of actions or a function for a Profiler, if there is one.
+class ProfileGuard
+{
+public:
+
+    template<typename... Args>
+    ProfileGuard(Profiler* profiler, const Args&... args)
+        :
+        _profiler(profiler)
+    {
+        if (_profiler) _profiler->enter(args...);
+    }
+
+    ~ProfileGuard() {
+        if (_profiler) _profiler->leave();
+    }
+
+private:
+    Profiler* _profiler;
+};
+
 /////////////////////////////////////////////////////////////////////////////
 ///
 /// VM ops on as_value.
@@ -158,6 +158,7 @@
 namespace gnash {
     class IOChannel;
     class CachedBitmap;
+    class ref_counted;
     class rgba;
     class Transform;
     class SWFMatrix;
@@ -303,6 +304,28 @@ public:
     virtual void drawGlyph(const SWF::ShapeRecord& rec, const rgba& color,
            const SWFMatrix& mat) = 0;
 
+    /// Draw a shape belonging to a character definition.
+    //
+    /// The shape of a definition never changes, and lives as long as the
+    /// definition does, so a renderer that draws the frame later may keep
+    /// a reference to the owner instead of copying the shape. Other
+    /// renderers just draw it.
+    ///
+    /// @param owner    The definition the shape belongs to.
+    virtual void drawDefinedShape(const SWF::ShapeRecord& shape,
+            const Transform& xform, const ref_counted& /*owner*/) {
+        drawShape(shape, xform);
+    }
+
+    /// Draw a glyph belonging to a font. See drawDefinedShape().
+    ///
+    /// @param owner    The font the glyph belongs to.
+    virtual void drawDefinedGlyph(const SWF::ShapeRecord& rec,
+            const rgba& color, const SWFMatrix& mat,
+            const ref_counted& /*owner*/) {
+        drawGlyph(rec, color, mat);
+    }
+
     /// Draw the current rendering buffer to an image file.
     //
     /// Although this can be done at any time during the rendering cycle
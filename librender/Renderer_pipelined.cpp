@@ -0,0 +1,624 @@
+// Renderer_pipelined.cpp: draw recorded frames on a separate thread.
+//
+//   Copyright (C) 2005, 2006, 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "Renderer_pipelined.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
+#include <boost/intrusive_ptr.hpp>
+#include <boost/variant/get.hpp>
+
+#include "log.h"
+#include "ref_counted.h"
+#include "Transform.h"
+#include "GnashImage.h"
+#include "IOChannel.h"
+#include "CachedBitmap.h"
+#include "FillStyle.h"
+#include "swf/ShapeRecord.h"
+
+namespace gnash {
+
+/// One recorded frame.
+//
+/// This is a list of calls to make on the real renderer, with everything
+/// they need. It is only changed while it's being recorded.
+class Renderer_pipelined::Snapshot : boost::noncopyable
+{
+public:
+
+    /// @param r    The renderer that makes the snapshot's bitmaps.
+    explicit Snapshot(Renderer& r) : _renderer(r) {}
+
+    struct Command
+    {
+        enum Type {
+            BEGIN_DISPLAY,
+            END_DISPLAY,
+            SHAPE,
+            GLYPH,
+            LINE,
+            POLY,
+            VIDEO,
+            BEGIN_MASK,
+            END_MASK,
+            DISABLE_MASK
+        };
+
+        explicit Command(Type t)
+            :
+            type(t),
+            shape(nullptr),
+            owner(nullptr),
+            frame(nullptr),
+            flag(false),
+            quality(QUALITY_HIGH),
+            width(0),
+            height(0),
+            x0(0),
+            x1(0),
+            y0(0),
+            y1(0)
+        {}
+
+        Type type;
+        Transform xform;
+        rgba color;
+        rgba outline;
+        const SWF::ShapeRecord* shape;
+
+        /// The definition or font a kept shape belongs to.
+        const ref_counted* owner;
+
+        image::GnashImage* frame;
+        std::vector<point> points;
+        SWFRect bounds;
+        bool flag;
+        Quality quality;
+        int width;
+        int height;
+        float x0, x1, y0, y1;
+    };
+
+    Command& add(Command::Type t) {
+        _commands.push_back(Command(t));
+        return _commands.back();
+    }
+
+    /// Keep a copy of a shape that may change after it's recorded.
+    //
+    /// The bitmaps it is filled with are copied too, as BitmapData and
+    /// the bitmap cache change them, or dispose of them, while the movie
+    /// advances, which is while the snapshot is drawn.
+    const SWF::ShapeRecord* copy(const SWF::ShapeRecord& shape);
+
+    /// Keep a shape's owner alive for as long as the snapshot.
+    const SWF::ShapeRecord* keep(const SWF::ShapeRecord& shape,
+            const ref_counted& owner) {
+        // Glyphs mostly come in runs from the same font.
+        if (_owners.empty() || _owners.back().get() != &owner) {
+            _owners.push_back(&owner);
+        }
+        return &shape;
+    }
+
+    image::GnashImage* copy(const image::GnashImage& frame);
+
+    /// Make all the recorded calls on a renderer.
+    void replay(Renderer& r) const;
+
+private:
+
+    /// A copy of a bitmap, made once however often it is drawn.
+    const CachedBitmap* copy(const CachedBitmap& bitmap);
+
+    Renderer& _renderer;
+
+    std::vector<Command> _commands;
+
+    /// Copied shapes. A deque keeps the addresses used in the commands.
+    std::deque<SWF::ShapeRecord> _shapes;
+
+    std::vector<boost::intrusive_ptr<const ref_counted> > _owners;
+
+    std::vector<std::unique_ptr<image::GnashImage> > _frames;
+
+    /// The copies of the bitmaps, by the bitmaps they were copied from.
+    std::map<boost::intrusive_ptr<const CachedBitmap>,
+        boost::intrusive_ptr<const CachedBitmap> > _bitmaps;
+};
+
+namespace {
+
+std::unique_ptr<image::GnashImage>
+copyImage(const image::GnashImage& from)
+{
+    std::unique_ptr<image::GnashImage> im;
+    switch (from.type()) {
+        case image::TYPE_RGB:
+            im.reset(new image::ImageRGB(from.width(), from.height()));
+            break;
+        case image::TYPE_RGBA:
+            im.reset(new image::ImageRGBA(from.width(), from.height()));
+            break;
+        default:
+            return im;
+    }
+    im->update(from);
+    return im;
+}
+
+}
+
+image::GnashImage*
+Renderer_pipelined::Snapshot::copy(const image::GnashImage& frame)
+{
+    std::unique_ptr<image::GnashImage> im = copyImage(frame);
+    if (!im) return nullptr;
+    _frames.push_back(std::move(im));
+    return _frames.back().get();
+}
+
+const CachedBitmap*
+Renderer_pipelined::Snapshot::copy(const CachedBitmap& bitmap)
+{
+    // A disposed bitmap isn't drawn, and has nothing left to change.
+    if (bitmap.disposed()) return &bitmap;
+
+    boost::intrusive_ptr<const CachedBitmap>& c = _bitmaps[&bitmap];
+    if (!c) {
+        // image() isn't const, as BitmapData changes it through the
+        // same call, but it is only read here.
+        std::unique_ptr<image::GnashImage> im =
+            copyImage(const_cast<CachedBitmap&>(bitmap).image());
+        if (im) c = _renderer.createCachedBitmap(std::move(im));
+    }
+    return c.get();
+}
+
+const SWF::ShapeRecord*
+Renderer_pipelined::Snapshot::copy(const SWF::ShapeRecord& shape)
+{
+    const auto hasBitmap = [](const FillStyle& fs) {
+        const BitmapFill* f = boost::get<BitmapFill>(&fs.fill);
+        return f && f->bitmap();
+    };
+
+    // Most shapes have no bitmaps, and are copied as they are.
+    const SWF::ShapeRecord::Subshapes& subs = shape.subshapes();
+    if (std::none_of(subs.begin(), subs.end(),
+                [&hasBitmap](const SWF::Subshape& sub) {
+                    return std::any_of(sub.fillStyles().begin(),
+                            sub.fillStyles().end(), hasBitmap);
+                })) {
+        _shapes.push_back(shape);
+        return &_shapes.back();
+    }
+
+    SWF::ShapeRecord copied;
+    for (const SWF::Subshape& sub : subs) {
+        SWF::Subshape s(sub);
+        for (FillStyle& fs : s.fillStyles()) {
+            if (!hasBitmap(fs)) continue;
+            const BitmapFill& f = boost::get<BitmapFill>(fs.fill);
+            fs.fill = BitmapFill(f.type(), copy(*f.bitmap()), f.matrix(),
+                    f.smoothingPolicy());
+        }
+        copied.addSubshape(s);
+    }
+    copied.setBounds(shape.getBounds());
+    _shapes.push_back(std::move(copied));
+    return &_shapes.back();
+}
+
+void
+Renderer_pipelined::Snapshot::replay(Renderer& r) const
+{
+    std::unique_ptr<Renderer::External> ex;
+
+    for (const Command& c : _commands) {
+        switch (c.type) {
+            case Command::BEGIN_DISPLAY:
+                r.setQuality(c.quality);
+                ex.reset(new Renderer::External(r, c.color, c.width,
+                            c.height, c.x0, c.x1, c.y0, c.y1));
+                break;
+            case Command::END_DISPLAY:
+                ex.reset();
+                break;
+            case Command::SHAPE:
+                if (c.owner) r.drawDefinedShape(*c.shape, c.xform, *c.owner);
+                else r.drawShape(*c.shape, c.xform);
+                break;
+            case Command::GLYPH:
+                if (c.owner) {
+                    r.drawDefinedGlyph(*c.shape, c.color, c.xform.matrix,
+                            *c.owner);
+                }
+                else r.drawGlyph(*c.shape, c.color, c.xform.matrix);
+                break;
+            case Command::LINE:
+                r.drawLine(c.points, c.color, c.xform.matrix);
+                break;
+            case Command::POLY:
+                r.draw_poly(c.points, c.color, c.outline, c.xform.matrix,
+                        c.flag);
+                break;
+            case Command::VIDEO:
+                r.drawVideoFrame(c.frame, c.xform, &c.bounds, c.flag);
+                break;
+            case Command::BEGIN_MASK:
+                r.begin_submit_mask();
+                break;
+            case Command::END_MASK:
+                r.end_submit_mask();
+                break;
+            case Command::DISABLE_MASK:
+                r.disable_mask();
+                break;
+        }
+    }
+}
+
+Renderer_pipelined::Renderer_pipelined(std::shared_ptr<Renderer> renderer)
+    :
+    _renderer(renderer),
+    _busy(false),
+    _quit(false)
+{
+    assert(_renderer);
+    _thread = std::thread(&Renderer_pipelined::run, this);
+}
+
+Renderer_pipelined::~Renderer_pipelined()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+    }
+    _wake.notify_one();
+    _thread.join();
+}
+
+void
+Renderer_pipelined::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (true) {
+        _wake.wait(lock, [this] { return _busy || _quit; });
+
+        // Any frame still waiting is finished before quitting, as
+        // someone may be waiting for it.
+        if (_busy) {
+            const Snapshot* s = _drawing.get();
+            lock.unlock();
+            try {
+                s->replay(*_renderer);
+            }
+            catch (const std::exception& e) {
+                log_error(_("Error drawing frame: %s"), e.what());
+            }
+            lock.lock();
+            _busy = false;
+            _done.notify_all();
+        }
+
+        if (_quit) return;
+    }
+}
+
+void
+Renderer_pipelined::render()
+{
+    if (!_recording) return;
+
+    // The previous frame is destroyed here, not on the drawing thread.
+    std::unique_ptr<Snapshot> old;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this] { return !_busy; });
+        old = std::move(_drawing);
+        _drawing = std::move(_recording);
+        _busy = true;
+    }
+    _wake.notify_one();
+}
+
+void
+Renderer_pipelined::finish() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return !_busy; });
+}
+
+Renderer_pipelined::Snapshot&
+Renderer_pipelined::recording()
+{
+    if (!_recording) _recording.reset(new Snapshot(*_renderer));
+    return *_recording;
+}
+
+std::string
+Renderer_pipelined::description() const
+{
+    return _renderer->description();
+}
+
+void
+Renderer_pipelined::set_scale(float xscale, float yscale)
+{
+    finish();
+    _renderer->set_scale(xscale, yscale);
+}
+
+void
+Renderer_pipelined::set_translation(float xoff, float yoff)
+{
+    finish();
+    _renderer->set_translation(xoff, yoff);
+}
+
+CachedBitmap*
+Renderer_pipelined::createCachedBitmap(std::unique_ptr<image::GnashImage> im)
+{
+    // This only wraps the image, so it doesn't touch anything the
+    // drawing thread uses.
+    return _renderer->createCachedBitmap(std::move(im));
+}
+
+void
+Renderer_pipelined::drawVideoFrame(image::GnashImage* frame,
+        const Transform& xform, const SWFRect* bounds, bool smooth)
+{
+    // The decoder reuses its frame, so it has to be copied.
+    if (!frame || frame->location() != image::GNASH_IMAGE_CPU) {
+        LOG_ONCE(log_unimpl(_("Drawing video frames held by the GPU "
+                        "on the render thread")));
+        return;
+    }
+    image::GnashImage* copy = recording().copy(*frame);
+    if (!copy) return;
+
+    Snapshot::Command& c = recording().add(Snapshot::Command::VIDEO);
+    c.frame = copy;
+    c.xform = xform;
+    if (bounds) c.bounds = *bounds;
+    c.flag = smooth;
+}
+
+void
+Renderer_pipelined::drawLine(const std::vector<point>& coords,
+        const rgba& color, const SWFMatrix& mat)
+{
+    Snapshot::Command& c = recording().add(Snapshot::Command::LINE);
+    c.points = coords;
+    c.color = color;
+    c.xform.matrix = mat;
+}
+
+void
+Renderer_pipelined::draw_poly(const std::vector<point>& corners,
+        const rgba& fill, const rgba& outline, const SWFMatrix& mat,
+        bool masked)
+{
+    Snapshot::Command& c = recording().add(Snapshot::Command::POLY);
+    c.points = corners;
+    c.color = fill;
+    c.outline = outline;
+    c.xform.matrix = mat;
+    c.flag = masked;
+}
+
+void
+Renderer_pipelined::drawShape(const SWF::ShapeRecord& shape,
+        const Transform& xform)
+{
+    Snapshot& s = recording();
+    const SWF::ShapeRecord* copy = s.copy(shape);
+    Snapshot::Command& c = s.add(Snapshot::Command::SHAPE);
+    c.shape = copy;
+    c.xform = xform;
+}
+
+void
+Renderer_pipelined::drawGlyph(const SWF::ShapeRecord& rec, const rgba& color,
+        const SWFMatrix& mat)
+{
+    Snapshot& s = recording();
+    const SWF::ShapeRecord* copy = s.copy(rec);
+    Snapshot::Command& c = s.add(Snapshot::Command::GLYPH);
+    c.shape = copy;
+    c.color = color;
+    c.xform.matrix = mat;
+}
+
+void
+Renderer_pipelined::drawDefinedShape(const SWF::ShapeRecord& shape,
+        const Transform& xform, const ref_counted& owner)
+{
+    Snapshot& s = recording();
+    const SWF::ShapeRecord* kept = s.keep(shape, owner);
+    Snapshot::Command& c = s.add(Snapshot::Command::SHAPE);
+    c.shape = kept;
+    c.owner = &owner;
+    c.xform = xform;
+}
+
+void
+Renderer_pipelined::drawDefinedGlyph(const SWF::ShapeRecord& rec,
+        const rgba& color, const SWFMatrix& mat, const ref_counted& owner)
+{
+    Snapshot& s = recording();
+    const SWF::ShapeRecord* kept = s.keep(rec, owner);
+    Snapshot::Command& c = s.add(Snapshot::Command::GLYPH);
+    c.shape = kept;
+    c.owner = &owner;
+    c.color = color;
+    c.xform.matrix = mat;
+}
+
+void
+Renderer_pipelined::renderToImage(std::unique_ptr<IOChannel> io,
+        FileType type, int quality) const
+{
+    finish();
+    _renderer->renderToImage(std::move(io), type, quality);
+}
+
+void
+Renderer_pipelined::set_invalidated_regions(const InvalidatedRanges& ranges)
+{
+    finish();
+    _renderer->set_invalidated_regions(ranges);
+}
+
+Renderer::RenderImages::const_iterator
+Renderer_pipelined::getFirstRenderImage() const
+{
+    return _renderer->getFirstRenderImage();
+}
+
+Renderer::RenderImages::const_iterator
+Renderer_pipelined::getLastRenderImage() const
+{
+    return _renderer->getLastRenderImage();
+}
+
+void
+Renderer_pipelined::begin_submit_mask()
+{
+    recording().add(Snapshot::Command::BEGIN_MASK);
+}
+
+void
+Renderer_pipelined::end_submit_mask()
+{
+    recording().add(Snapshot::Command::END_MASK);
+}
+
+void
+Renderer_pipelined::disable_mask()
+{
+    recording().add(Snapshot::Command::DISABLE_MASK);
+}
+
+// The queries below only read the real renderer's settings, which
+// are only changed after waiting for the drawing thread.
+
+geometry::Range2d<int>
+Renderer_pipelined::world_to_pixel(const SWFRect& worldbounds) const
+{
+    return _renderer->world_to_pixel(worldbounds);
+}
+
+point
+Renderer_pipelined::pixel_to_world(int x, int y) const
+{
+    return _renderer->pixel_to_world(x, y);
+}
+
+bool
+Renderer_pipelined::bounds_in_clipping_area(const geometry::Range2d<int>& b)
+    const
+{
+    return _renderer->bounds_in_clipping_area(b);
+}
+
+#ifdef USE_TESTSUITE
+bool
+Renderer_pipelined::getPixel(rgba& color_return, int x, int y) const
+{
+    finish();
+    return _renderer->getPixel(color_return, x, y);
+}
+
+bool
+Renderer_pipelined::getAveragePixel(rgba& color_return, int x, int y,
+        unsigned int radius) const
+{
+    finish();
+    return _renderer->getAveragePixel(color_return, x, y, radius);
+}
+
+bool
+Renderer_pipelined::initTestBuffer(unsigned width, unsigned height)
+{
+    finish();
+    return _renderer->initTestBuffer(width, height);
+}
+
+unsigned int
+Renderer_pipelined::getBitsPerPixel() const
+{
+    return _renderer->getBitsPerPixel();
+}
+#endif
+
+void
+Renderer_pipelined::begin_display(const rgba& background_color,
+        int viewport_width, int viewport_height,
+        float x0, float x1, float y0, float y1)
+{
+    Snapshot::Command& c = recording().add(Snapshot::Command::BEGIN_DISPLAY);
+    c.color = background_color;
+    c.quality = _quality;
+    c.width = viewport_width;
+    c.height = viewport_height;
+    c.x0 = x0;
+    c.x1 = x1;
+    c.y0 = y0;
+    c.y1 = y1;
+}
+
+void
+Renderer_pipelined::end_display()
+{
+    recording().add(Snapshot::Command::END_DISPLAY);
+}
+
+Renderer*
+Renderer_pipelined::startInternalRender(image::GnashImage& buffer)
+{
+    // Internal rendering changes the real renderer's buffer, so it
+    // can't happen while a frame is being drawn. It draws straight
+    // away, with the real renderer.
+    finish();
+    _internal.reset(new Renderer::Internal(*_renderer, buffer));
+    return _internal->renderer();
+}
+
+void
+Renderer_pipelined::endInternalRender()
+{
+    _internal.reset();
+}
+
+} // namespace gnash
+
+// Local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
@@ -0,0 +1,176 @@
+// Renderer_pipelined.h: draw recorded frames on a separate thread.
+//
+//   Copyright (C) 2005, 2006, 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef GNASH_RENDERER_PIPELINED_H
+#define GNASH_RENDERER_PIPELINED_H
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "dsodefs.h"
+#include "Renderer.h"
+
+namespace gnash {
+
+/// A Renderer that records frames and draws them on its own thread.
+//
+/// Displaying a frame through this renderer doesn't draw anything. It
+/// records a snapshot of the frame instead: every shape, glyph, line and
+/// video frame with its transform, and the masks around them. Shapes that
+/// belong to definitions, and the tweened shapes of morphs, are kept by
+/// reference, and anything that the core could change afterwards
+/// (dynamic shapes and the bitmaps they are filled with, video frames) is
+/// copied, so once recorded the snapshot doesn't depend on the DisplayList
+/// any more.
+///
+/// render() hands the recorded frame to the drawing thread, which draws
+/// it with the real renderer while the caller advances the movie. Anything
+/// else that needs the real renderer (resizing, internal rendering for
+/// BitmapData.draw, reading pixels back) first waits for the drawing
+/// thread to finish.
+///
+/// Only renderers that draw to memory can be used, as the real renderer
+/// is used from two threads, although never at the same time.
+class DSOEXPORT Renderer_pipelined : public Renderer
+{
+public:
+
+    /// Create a pipelined renderer drawing with another one.
+    //
+    /// @param renderer     The renderer to draw with. It must not be used
+    ///                     directly while this one exists, except between
+    ///                     finish() and the next render().
+    explicit Renderer_pipelined(std::shared_ptr<Renderer> renderer);
+
+    ~Renderer_pipelined();
+
+    /// Start drawing the frame recorded since the last call.
+    //
+    /// This returns straight away. If an earlier frame is still being
+    /// drawn, it waits for that first, so only one frame is ever in
+    /// flight.
+    void render();
+
+    /// Wait until the frame passed to render() has been drawn.
+    void finish() const;
+
+    std::string description() const;
+
+    void set_scale(float xscale, float yscale);
+    void set_translation(float xoff, float yoff);
+
+    CachedBitmap* createCachedBitmap(std::unique_ptr<image::GnashImage> im);
+
+    void drawVideoFrame(image::GnashImage* frame, const Transform& xform,
+            const SWFRect* bounds, bool smooth);
+    void drawLine(const std::vector<point>& coords, const rgba& color,
+            const SWFMatrix& mat);
+    void draw_poly(const std::vector<point>& corners, const rgba& fill,
+            const rgba& outline, const SWFMatrix& mat, bool masked);
+    void drawShape(const SWF::ShapeRecord& shape, const Transform& xform);
+    void drawGlyph(const SWF::ShapeRecord& rec, const rgba& color,
+            const SWFMatrix& mat);
+    void drawDefinedShape(const SWF::ShapeRecord& shape,
+            const Transform& xform, const ref_counted& owner);
+    void drawDefinedGlyph(const SWF::ShapeRecord& rec, const rgba& color,
+            const SWFMatrix& mat, const ref_counted& owner);
+
+    void renderToImage(std::unique_ptr<IOChannel> io, FileType type,
+            int quality) const;
+
+    void set_invalidated_regions(const InvalidatedRanges& ranges);
+
+    RenderImages::const_iterator getFirstRenderImage() const;
+    RenderImages::const_iterator getLastRenderImage() const;
+
+    void begin_submit_mask();
+    void end_submit_mask();
+    void disable_mask();
+
+    geometry::Range2d<int> world_to_pixel(const SWFRect& worldbounds) const;
+    using Renderer::world_to_pixel;
+    point pixel_to_world(int x, int y) const;
+    using Renderer::pixel_to_world;
+    bool bounds_in_clipping_area(const geometry::Range2d<int>& b) const;
+
+#ifdef USE_TESTSUITE
+    bool getPixel(rgba& color_return, int x, int y) const;
+    bool getAveragePixel(rgba& color_return, int x, int y,
+            unsigned int radius) const;
+    bool initTestBuffer(unsigned width, unsigned height);
+    unsigned int getBitsPerPixel() const;
+#endif
+
+private:
+
+    class Snapshot;
+
+    void begin_display(const rgba& background_color,
+            int viewport_width, int viewport_height,
+            float x0, float x1, float y0, float y1);
+    void end_display();
+
+    Renderer* startInternalRender(image::GnashImage& buffer);
+    void endInternalRender();
+
+    /// The snapshot being recorded, created when it's first needed.
+    Snapshot& recording();
+
+    /// The body of the drawing thread.
+    void run();
+
+    const std::shared_ptr<Renderer> _renderer;
+
+    /// The frame being recorded. Only used by the recording thread.
+    std::unique_ptr<Snapshot> _recording;
+
+    /// The last frame passed to render(). It is kept until the next one
+    /// arrives, so it is destroyed by the recording thread, along with
+    /// the definitions it holds.
+    std::unique_ptr<Snapshot> _drawing;
+
+    /// Set while internal rendering is going on.
+    std::unique_ptr<Renderer::Internal> _internal;
+
+    mutable std::mutex _mutex;
+
+    /// Signalled when there is a frame to draw, or when quitting.
+    std::condition_variable _wake;
+
+    /// Signalled when a frame has been drawn.
+    mutable std::condition_variable _done;
+
+    /// Whether _drawing still has to be drawn.
+    bool _busy;
+
+    bool _quit;
+
+    std::thread _thread;
+};
+
+} // namespace gnash
+
+#endif
+
+// Local Variables:
+// mode: C++
+// indent-tabs-mode: nil
+// End:
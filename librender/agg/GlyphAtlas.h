@@ -0,0 +1,175 @@
+//
+//   Copyright (C) 2005, 2006, 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef GNASH_AGG_GLYPH_ATLAS_H
+#define GNASH_AGG_GLYPH_ATLAS_H
+
+#include <map>
+#include <memory>
+#include <tuple>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <boost/intrusive_ptr.hpp>
+
+#include "ref_counted.h"
+
+namespace gnash {
+    namespace SWF {
+        class ShapeRecord;
+    }
+}
+
+namespace gnash {
+
+/// Small glyphs, rasterised once and blended into the frame from then on.
+//
+/// Text is mostly drawn with a few glyphs at a few sizes, so glyphs that
+/// are small and not rotated are kept as 8-bit coverage bitmaps, packed
+/// in rows into one large buffer. A glyph is looked up by the font glyph
+/// it was drawn from, its scale and where its origin falls inside a pixel,
+/// to a quarter of a pixel. When the buffer is full, it is emptied, and
+/// the glyphs that are still drawn are rasterised again.
+class GlyphAtlas
+{
+public:
+
+    /// A glyph as drawn at one scale and subpixel position.
+    struct Key
+    {
+        bool operator<(const Key& o) const {
+            return std::tie(shape, xscale, yscale, x, y) <
+                std::tie(o.shape, o.xscale, o.yscale, o.x, o.y);
+        }
+
+        /// The glyph's outline in its font. The atlas keeps the font
+        /// alive, so no other outline is found at the same address.
+        const SWF::ShapeRecord* shape;
+
+        /// The scales of the matrix to pixels.
+        std::int32_t xscale;
+        std::int32_t yscale;
+
+        /// Where the origin falls inside a pixel, in quarters of one.
+        int x;
+        int y;
+    };
+
+    /// Where the coverage of a glyph is kept.
+    struct Glyph
+    {
+        /// The top left corner in the buffer.
+        int x;
+        int y;
+
+        int width;
+        int height;
+
+        /// The pixel of the top left corner, relative to the pixel the
+        /// glyph's origin is in.
+        int left;
+        int top;
+
+        /// The font the glyph's outline belongs to.
+        boost::intrusive_ptr<const ref_counted> owner;
+    };
+
+    /// The width and height of the buffer.
+    static const int size = 1024;
+
+    /// The width and height of the largest glyph kept.
+    static const int maxGlyphSize = 64;
+
+    GlyphAtlas()
+        :
+        _buffer(new std::uint8_t[size * size]),
+        _shelfX(0),
+        _shelfY(0),
+        _shelfHeight(0)
+    {
+    }
+
+    const Glyph* find(const Key& key) const {
+        Glyphs::const_iterator it = _glyphs.find(key);
+        return it == _glyphs.end() ? nullptr : &it->second;
+    }
+
+    /// Make space for a glyph, which must then be rasterised into it.
+    //
+    /// @param owner    The font the glyph's outline belongs to, which is
+    ///                 kept until the glyph is dropped.
+    Glyph& add(const Key& key, const ref_counted& owner, int left, int top,
+            int width, int height) {
+
+        assert(width <= maxGlyphSize && height <= maxGlyphSize);
+
+        if (_shelfX + width > size) {
+            _shelfX = 0;
+            _shelfY += _shelfHeight;
+            _shelfHeight = 0;
+        }
+
+        if (_shelfY + height > size) {
+            _glyphs.clear();
+            _shelfX = 0;
+            _shelfY = 0;
+            _shelfHeight = 0;
+        }
+
+        Glyph& g = _glyphs[key];
+        g.x = _shelfX;
+        g.y = _shelfY;
+        g.width = width;
+        g.height = height;
+        g.left = left;
+        g.top = top;
+        g.owner = &owner;
+
+        _shelfX += width;
+        _shelfHeight = std::max(_shelfHeight, height);
+        return g;
+    }
+
+    /// The coverage of a row of a glyph.
+    std::uint8_t* row(const Glyph& g, int y) {
+        return _buffer.get() + (g.y + y) * size + g.x;
+    }
+
+    /// The number of glyphs kept.
+    size_t glyphs() const {
+        return _glyphs.size();
+    }
+
+private:
+
+    typedef std::map<Key, Glyph> Glyphs;
+    Glyphs _glyphs;
+
+    std::unique_ptr<std::uint8_t[]> _buffer;
+
+    /// The next free place in the current row of glyphs.
+    int _shelfX;
+    int _shelfY;
+
+    /// The height of the tallest glyph in the current row.
+    int _shelfHeight;
+};
+
+} // namespace gnash
+
+#endif // GNASH_AGG_GLYPH_ATLAS_H
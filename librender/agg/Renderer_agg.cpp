@@ -115,6 +115,9 @@ AGG resources
 #include <math.h> // We use round()!
 #include <climits>
 #include <functional>
+#include <map>
+#include <tuple>
+#include <memory>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -164,6 +167,7 @@ AGG resources
 #endif
 
 #include "Renderer_agg_bitmap.h"
+#include "GlyphAtlas.h"
 
 // Print a debugging warning when rendering of a whole character
 // is skipped 
@@ -1017,6 +1021,19 @@ public:
 
   void drawGlyph(const SWF::ShapeRecord& shape, const rgba& color,
           const SWFMatrix& mat) 
+  {
+    drawGlyph(shape, color, mat, nullptr);
+  }
+
+  void drawDefinedGlyph(const SWF::ShapeRecord& shape, const rgba& color,
+          const SWFMatrix& mat, const ref_counted& owner)
+  {
+    drawGlyph(shape, color, mat, &owner);
+  }
+
+  /// Draw a glyph, from the GlyphAtlas if it belongs to a font.
+  void drawGlyph(const SWF::ShapeRecord& shape, const rgba& color,
+          const SWFMatrix& mat, const ref_counted* owner)
   {
     if (shape.subshapes().empty()) return;
     assert(shape.subshapes().size() == 1);
@@ -1028,6 +1045,12 @@ public:
     select_clipbounds(shape.getBounds(), mat);
     
     if (_clipbounds_selected.empty()) return; 
+
+    if (owner && !m_drawing_mask && _alphaMasks.empty() &&
+            drawCachedGlyph(shape, color, mat, *owner)) {
+        _clipbounds_selected.clear();
+        return;
+    }
       
     GnashPaths paths;
     apply_matrix_to_path(shape.subshapes().front().paths(), paths, mat);
@@ -1057,6 +1080,133 @@ public:
   }
 
 
+  /// Draw a glyph from the GlyphAtlas, rasterising it there first if needed.
+  //
+  /// The glyph is drawn at the nearest quarter pixel.
+  ///
+  /// @return   false if the glyph is too large or not upright, and must be
+  ///           drawn as a shape.
+  bool drawCachedGlyph(const SWF::ShapeRecord& shape, const rgba& color,
+          const SWFMatrix& mat, const ref_counted& owner)
+  {
+    // The same matrix as apply_matrix_to_path().
+    SWFMatrix m;
+    m.concatenate_scale(20.0, 20.0);
+    m.concatenate(stage_matrix);
+    m.concatenate(mat);
+
+    if (m.b() || m.c() || m.a() <= 0 || m.d() <= 0) return false;
+
+    // The pixel the origin is in, and where in it, in quarter pixels.
+    const double qx = std::floor(m.tx() / 5.0 + 0.5);
+    const double qy = std::floor(m.ty() / 5.0 + 0.5);
+    const int px = std::floor(qx / 4);
+    const int py = std::floor(qy / 4);
+
+    GlyphAtlas::Key key;
+    key.shape = &shape;
+    key.xscale = m.a();
+    key.yscale = m.d();
+    key.x = qx - px * 4;
+    key.y = qy - py * 4;
+
+    const GlyphAtlas::Glyph* g = _glyphAtlas.find(key);
+
+    if (!g) {
+        m.set_translation(key.x * 5, key.y * 5);
+
+        SWFRect bounds;
+        bounds.expand_to_transformed_rect(m, shape.getBounds());
+
+        // Antialiasing can touch the pixels around the bounds.
+        const int left = std::floor(twipsToPixels(bounds.get_x_min())) - 1;
+        const int top = std::floor(twipsToPixels(bounds.get_y_min())) - 1;
+        const int width =
+            std::ceil(twipsToPixels(bounds.get_x_max())) + 2 - left;
+        const int height =
+            std::ceil(twipsToPixels(bounds.get_y_max())) + 2 - top;
+
+        if (width > GlyphAtlas::maxGlyphSize ||
+                height > GlyphAtlas::maxGlyphSize) {
+            return false;
+        }
+
+        m.set_translation(key.x * 5 - pixelsToTwips(left),
+                key.y * 5 - pixelsToTwips(top));
+
+        GlyphAtlas::Glyph& added =
+            _glyphAtlas.add(key, owner, left, top, width, height);
+        rasteriseGlyph(shape, m, added);
+        g = &added;
+    }
+
+    const agg::rgba8 c =
+        agg::rgba8_pre(color.m_r, color.m_g, color.m_b, color.m_a);
+
+    const int x0 = px + g->left;
+    const int y0 = py + g->top;
+
+    for (const geometry::Range2d<int>* clip : _clipbounds_selected) {
+
+        const int xmin = std::max(x0, clip->getMinX());
+        const int xmax = std::min(x0 + g->width - 1, clip->getMaxX());
+        const int ymin = std::max(y0, clip->getMinY());
+        const int ymax = std::min(y0 + g->height - 1, clip->getMaxY());
+
+        for (int y = ymin; xmin <= xmax && y <= ymax; ++y) {
+            m_rbase->blend_solid_hspan(xmin, y, xmax - xmin + 1, c,
+                    _glyphAtlas.row(*g, y - y0) + (xmin - x0));
+        }
+    }
+    return true;
+  }
+
+  /// Rasterise the coverage of a glyph into the GlyphAtlas.
+  //
+  /// @param mat    The matrix to the glyph's place in the atlas, in
+  ///               twentieths of a pixel like apply_matrix_to_path().
+  void rasteriseGlyph(const SWF::ShapeRecord& shape, const SWFMatrix& mat,
+          const GlyphAtlas::Glyph& g)
+  {
+    // Blending full coverage into zero with the premultiplied format
+    // leaves the coverage as it is, which is what the glyph is drawn
+    // with otherwise.
+    typedef agg::pixfmt_gray8_pre pixfmt;
+    agg::rendering_buffer rbuf(_glyphAtlas.row(g, 0), g.width, g.height,
+            GlyphAtlas::size);
+    pixfmt pixf(rbuf);
+    agg::renderer_base<pixfmt> rbase(pixf);
+    rbase.clear(agg::gray8(0));
+
+    GnashPaths paths(shape.subshapes().front().paths());
+    std::for_each(paths.begin(), paths.end(),
+            std::bind(&Path::transform, std::placeholders::_1,
+                std::ref(mat)));
+
+    AggPaths agg_paths;
+    buildPaths(agg_paths, paths);
+
+    typedef agg::rasterizer_compound_aa<agg::rasterizer_sl_clip_int> rasc_type;
+    rasc_type rasc;
+    rasc.filling_rule(agg::fill_non_zero);
+    rasc.clip_box(0, 0, g.width, g.height);
+
+    for (size_t pno = 0, e = paths.size(); pno != e; ++pno) {
+      const Path& path = paths[pno];
+      if (!path.m_fill0 && !path.m_fill1) continue;
+
+      // The mask style handler has only the one style, as for masks.
+      agg::conv_curve<agg::path_storage> curve(agg_paths[pno]);
+      rasc.styles(path.m_fill0 == 0 ? -1 : 0, path.m_fill1 == 0 ? -1 : 0);
+      rasc.add_path(curve);
+    }
+
+    agg::scanline_u8 sl;
+    agg::span_allocator<agg::gray8> alloc;
+    agg_mask_style_handler sh;
+    agg::render_scanlines_compound_layered(rasc, sl, rbase, alloc, sh);
+  }
+
   /// Fills _clipbounds_selected with pointers to _clipbounds members who
   /// intersect with the given character (transformed by mat). This avoids
   /// rendering of characters outside a particular clipping range.
@@ -2019,6 +2169,9 @@ private:  // private variables
     /// Cached fill style list with just one entry used for font rendering
     std::vector<FillStyle> m_single_FillStyles;
 
+    /// Small glyphs already rasterised.
+    GlyphAtlas _glyphAtlas;
+
 
 };
 
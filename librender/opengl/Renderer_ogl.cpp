@@ -24,6 +24,7 @@
 #include "Renderer_ogl.h"
 
 #include <boost/utility.hpp>
+#include <boost/intrusive_ptr.hpp>
 #include <iterator>
 #include <functional>
 #include <list>
@@ -43,6 +44,7 @@
 #include "SWFCxForm.h"
 #include "FillStyle.h"
 #include "Transform.h"
+#include "ref_counted.h"
 
 #if defined(_WIN32) || defined(WIN32)
 #  include <Windows.h>
@@ -432,21 +434,53 @@ std::vector<oglVertex> interpolate(const std::vector<Edge>& edges,
 }
 
 // FIXME: OSX doesn't like void (*)().
+void
+TesselatedPolygon::begin(GLenum type)
+{
+  Primitive p;
+  p.type = type;
+  p.first = _vertices.size() / 3;
+  p.count = 0;
+  _primitives.push_back(p);
+}
+
+void
+TesselatedPolygon::vertex(const GLdouble* v)
+{
+  assert(!_primitives.empty());
+  _vertices.insert(_vertices.end(), v, v + 3);
+  ++_primitives.back().count;
+}
+
+void
+TesselatedPolygon::draw() const
+{
+  if (_vertices.empty()) return;
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(3, GL_DOUBLE, 0 /* tight packing */, &_vertices.front());
+  for (const Primitive& p : _primitives) {
+    glDrawArrays(p.type, p.first, p.count);
+  }
+  glDisableClientState(GL_VERTEX_ARRAY);
+}
+
 Tesselator::Tesselator()
-: _tessobj(gluNewTess())
+: _tessobj(gluNewTess()),
+  _polygon(nullptr)
 {
   gluTessCallback(_tessobj, GLU_TESS_ERROR, 
                   reinterpret_cast<GLUCALLBACKTYPE>(Tesselator::error));
   gluTessCallback(_tessobj, GLU_TESS_COMBINE_DATA,
                   reinterpret_cast<GLUCALLBACKTYPE>(Tesselator::combine));
   
-  gluTessCallback(_tessobj, GLU_TESS_BEGIN,
-                  reinterpret_cast<GLUCALLBACKTYPE>(glBegin));
-  gluTessCallback(_tessobj, GLU_TESS_END,
-                  reinterpret_cast<GLUCALLBACKTYPE>(glEnd));
+  gluTessCallback(_tessobj, GLU_TESS_BEGIN_DATA,
+                  reinterpret_cast<GLUCALLBACKTYPE>(Tesselator::begin));
+  gluTessCallback(_tessobj, GLU_TESS_END_DATA,
+                  reinterpret_cast<GLUCALLBACKTYPE>(Tesselator::end));
                   
-  gluTessCallback(_tessobj, GLU_TESS_VERTEX,
-                  reinterpret_cast<GLUCALLBACKTYPE>(glVertex3dv)); 
+  gluTessCallback(_tessobj, GLU_TESS_VERTEX_DATA,
+                  reinterpret_cast<GLUCALLBACKTYPE>(Tesselator::vertex)); 
   
 #if 0        
   // for testing, draw only the outside of shapes.          
@@ -502,6 +536,14 @@ Tesselator::tesselate()
   _vertices.clear();
 }
 
+void
+Tesselator::tesselate(TesselatedPolygon& polygon)
+{
+  _polygon = &polygon;
+  tesselate();
+  _polygon = nullptr;
+}
+
 void
 Tesselator::rememberVertex(GLdouble* v)
 {
@@ -533,6 +575,33 @@ Tesselator::combine(GLdouble coords [3], void **/*vertex_data[4] */,
   tess->rememberVertex(v);
 }
 
+// static
+void
+Tesselator::begin(GLenum type, void* userdata)
+{
+  Tesselator* tess = static_cast<Tesselator*>(userdata);
+  if (tess->_polygon) tess->_polygon->begin(type);
+  else glBegin(type);
+}
+
+// static
+void
+Tesselator::vertex(void* vertex, void* userdata)
+{
+  Tesselator* tess = static_cast<Tesselator*>(userdata);
+  const GLdouble* v = static_cast<const GLdouble*>(vertex);
+  if (tess->_polygon) tess->_polygon->vertex(v);
+  else glVertex3dv(v);
+}
+
+// static
+void
+Tesselator::end(void* userdata)
+{
+  Tesselator* tess = static_cast<Tesselator*>(userdata);
+  if (!tess->_polygon) glEnd();
+}
+
 bool isEven(const size_t& n)
 {
   return n % 2 == 0;
@@ -1628,6 +1697,64 @@ public:
     //for_each(paths, &path::transform, mat);
   }  
 
+  /// Begin a polygon of the contours the paths make in the Tesselator.
+  void
+  feed_contours(const PathPtrVec& paths, PathPointMap& pathpoints)
+  {
+    std::list<PathPtrVec> contours = get_contours(paths);
+
+    _tesselator.beginPolygon();
+    
+    for (std::list<PathPtrVec>::const_iterator iter = contours.begin(),
+         final = contours.end(); iter != final; ++iter) {      
+      const PathPtrVec& refs = *iter;
+      
+      _tesselator.beginContour();
+                 
+      for (const auto& ref : refs) {
+        const Path& cur_path = *ref;
+        
+        assert(pathpoints.find(&cur_path) != pathpoints.end());
+
+        _tesselator.feed(pathpoints[&cur_path]);
+        
+      }
+      
+      _tesselator.endContour();
+    }
+  }
+
+  /// Tesselate the fill of a glyph.
+  void tesselateGlyph(const SWF::ShapeRecord& rec, TesselatedPolygon& polygon)
+  {
+    PathVec normalized = normalize_paths(rec.subshapes().front().paths());
+    PathPointMap pathpoints = getPathPoints(normalized);
+    PathPtrVec paths = paths_by_style(normalized, 1);
+
+    if (!paths.empty()) {
+      feed_contours(paths, pathpoints);
+      _tesselator.tesselate(polygon);
+    }
+  }
+
+  /// The tesselated fill of a font's glyph, tesselating it the first time.
+  //
+  /// Glyphs are drawn with their outlines untransformed, so one
+  /// tesselation serves every size and place a glyph is drawn at.
+  const TesselatedPolygon& glyph(const SWF::ShapeRecord& rec,
+          const ref_counted& owner)
+  {
+    GlyphCache::const_iterator it = _glyphs.find(&rec);
+    if (it != _glyphs.end()) return it->second.polygon;
+
+    if (_glyphs.size() >= maxGlyphs) _glyphs.clear();
+
+    CachedGlyph& g = _glyphs[&rec];
+    g.owner = &owner;
+    tesselateGlyph(rec, g.polygon);
+    return g.polygon;
+  }
+
   void
   draw_subshape(const PathVec& path_vec,
     const SWFMatrix& mat,
@@ -1645,27 +1772,7 @@ public:
         continue;
       }
       
-      std::list<PathPtrVec> contours = get_contours(paths);
-
-      _tesselator.beginPolygon();
-      
-      for (std::list<PathPtrVec>::const_iterator iter = contours.begin(),
-           final = contours.end(); iter != final; ++iter) {      
-        const PathPtrVec& refs = *iter;
-        
-        _tesselator.beginContour();
-                   
-        for (const auto& ref : refs) {
-          const Path& cur_path = *ref;
-          
-          assert(pathpoints.find(&cur_path) != pathpoints.end());
-
-          _tesselator.feed(pathpoints[&cur_path]);
-          
-        }
-        
-        _tesselator.endContour();
-      }
+      feed_contours(paths, pathpoints);
       
       apply_FillStyle(FillStyles[i], mat, cx);
 
@@ -1753,18 +1860,29 @@ public:
         return;
     }
     if (_drawing_mask) abort();
-    SWFCxForm dummy_cx;
-    std::vector<FillStyle> glyph_fs;
-    
-    FillStyle coloring = FillStyle(SolidFill(c));
-    
-    glyph_fs.push_back(coloring);
-    
-    std::vector<LineStyle> dummy_ls;
     
     oglScopeMatrix scope_mat(mat);
+
+    glColor4ub(c.m_r, c.m_g, c.m_b, c.m_a);
+
+    // Only the glyphs of fonts are known to be the same next time.
+    TesselatedPolygon polygon;
+    tesselateGlyph(rec, polygon);
+    polygon.draw();
+  }
+
+  virtual void drawDefinedGlyph(const SWF::ShapeRecord& rec, const rgba& c,
+         const SWFMatrix& mat, const ref_counted& owner)
+  {
+    if (rec.subshapes().empty()) {
+        return;
+    }
+    if (_drawing_mask) abort();
     
-    draw_subshape(rec.subshapes().front().paths(), mat, dummy_cx, glyph_fs, dummy_ls);
+    oglScopeMatrix scope_mat(mat);
+
+    glColor4ub(c.m_r, c.m_g, c.m_b, c.m_a);
+    glyph(rec, owner).draw();
   }
 
   virtual void set_scale(float xscale, float yscale) {
@@ -1824,6 +1942,23 @@ private:
   std::vector<PathVec> _masks;
   bool _drawing_mask;
   
+  /// A tesselated glyph, and the font its outline belongs to.
+  //
+  /// Keeping the font means no other outline is found at the same
+  /// address while the glyph is cached.
+  struct CachedGlyph
+  {
+    boost::intrusive_ptr<const ref_counted> owner;
+    TesselatedPolygon polygon;
+  };
+
+  /// Tesselated glyphs, by their outlines in their fonts.
+  typedef std::map<const SWF::ShapeRecord*, CachedGlyph> GlyphCache;
+  GlyphCache _glyphs;
+
+  /// The most glyphs kept tesselated.
+  static const size_t maxGlyphs = 4096;
+
   std::vector<std::uint8_t> _render_indices;
   std::vector< std::shared_ptr<GnashTexture> > _render_textures;
   std::list< std::shared_ptr<GnashTexture> > _cached_textures;
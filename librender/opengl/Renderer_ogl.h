@@ -82,6 +82,31 @@ struct oglVertex {
 
 typedef std::map<const Path*, std::vector<oglVertex> > PathPointMap;
 
+/// The primitives a Tesselator made of a polygon, to draw it again.
+class TesselatedPolygon
+{
+public:
+  void begin(GLenum type);
+
+  void vertex(const GLdouble* v);
+
+  /// Draw the polygon in the current color.
+  void draw() const;
+
+private:
+  struct Primitive
+  {
+    GLenum type;
+    GLint first;
+    GLsizei count;
+  };
+
+  std::vector<Primitive> _primitives;
+
+  /// The x, y and z of each vertex.
+  std::vector<GLdouble> _vertices;
+};
+
 class Tesselator
 {
 public:
@@ -93,6 +118,9 @@ public:
   void feed(std::vector<oglVertex>& vertices);
   
   void tesselate();
+
+  /// Tesselate into a TesselatedPolygon instead of drawing.
+  void tesselate(TesselatedPolygon& polygon);
   
   void beginContour();
   void endContour();
@@ -105,11 +133,17 @@ public:
   static void combine(GLdouble coords [3], void *vertex_data[4],
                       GLfloat weight[4], void **outData, void* userdata);
   
+  static void begin(GLenum type, void* userdata);
+  static void vertex(void* vertex, void* userdata);
+  static void end(void* userdata);
 
   
 private:
   std::vector<GLdouble*> _vertices;
   GLUtesselator* _tessobj;
+
+  /// Where the polygon being tesselated goes, or 0 to draw it.
+  TesselatedPolygon* _polygon;
 };
 
 class WholeShape
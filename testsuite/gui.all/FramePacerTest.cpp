@@ -0,0 +1,211 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "FramePacer.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+/// The time of one frame at 25 frames per second.
+const std::uint64_t frame = 40000;
+
+/// Plays frames through a FramePacer, the way the gui does.
+class Player
+{
+public:
+    Player(FramePacer& pacer)
+        :
+        changes(0),
+        _pacer(pacer),
+        _now(1000000)
+    {
+        _pacer.setFrameRate(1000000.0 / frame);
+    }
+
+    /// Advance a frame, and draw it if the pacer says so.
+    //
+    /// @param after    The time since the last frame was advanced.
+    /// @return         Whether the frame was drawn.
+    bool play(std::uint64_t after, std::uint64_t advance,
+            std::uint64_t render, Quality wanted = QUALITY_HIGH) {
+        _now += after;
+        if (!_pacer.advanced(_now, advance)) return false;
+        if (_pacer.rendered(render, wanted)) ++changes;
+        return true;
+    }
+
+    /// Play frames on time, and write down which were drawn.
+    //
+    /// @return a string with 'd' for a frame drawn, '-' for one skipped.
+    std::string run(size_t frames, std::uint64_t advance,
+            std::uint64_t render, Quality wanted = QUALITY_HIGH) {
+        std::string drawn;
+        for (size_t i = 0; i < frames; ++i) {
+            drawn += play(frame, advance, render, wanted) ? 'd' : '-';
+        }
+        return drawn;
+    }
+
+    /// How often drawing reported a change of quality.
+    int changes;
+
+private:
+    FramePacer& _pacer;
+    std::uint64_t _now;
+};
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    // Frames that come on time and are cheap are all drawn.
+    {
+        FramePacer pacer;
+        Player p(pacer);
+        check_equals(p.run(100, 2000, 5000), std::string(100, 'd'));
+        check_equals(pacer.stats().skipped, 0u);
+        check_equals(pacer.quality(QUALITY_HIGH), QUALITY_HIGH);
+    }
+
+    // A frame more than half a frame late isn't drawn, and the next one
+    // on time is.
+    {
+        FramePacer pacer;
+        Player p(pacer);
+        p.run(10, 2000, 5000);
+        check(p.play(frame + frame / 2 - 1000, 2000, 5000));
+        check(!p.play(frame * 2, 2000, 5000));
+        check(p.play(frame, 2000, 5000));
+        check_equals(pacer.stats().skipped, 1u);
+
+        // Nor is one in a row of late frames, but never more than three
+        // together.
+        std::string drawn;
+        for (int i = 0; i < 8; ++i) {
+            drawn += p.play(frame * 2, 2000, 5000) ? 'd' : '-';
+        }
+        check_equals(drawn, "---d---d");
+        check_equals(pacer.stats().skipped, 7u);
+
+        // A stall, such as a pause, is not caught up on.
+        check(p.play(frame * 10, 2000, 5000));
+        check_equals(pacer.stats().skipped, 7u);
+    }
+
+    // Frames that can't be advanced and drawn in a frame's time are
+    // skipped, three at most at a time, once the average shows it.
+    {
+        FramePacer pacer;
+        Player p(pacer);
+        const std::string drawn = p.run(40, 10000, 60000);
+        check_equals(drawn.substr(0, 2), "dd");
+        const std::string last = drawn.substr(drawn.size() - 8);
+        check_equals(std::count(last.begin(), last.end(), 'd'), 2);
+        check(drawn.find("----") == std::string::npos);
+
+        // Once drawing is cheap again, every frame is drawn.
+        p.run(20, 2000, 5000);
+        check_equals(p.run(20, 2000, 5000), std::string(20, 'd'));
+    }
+
+    // Skipping many frames for a while lowers the quality a step at a
+    // time, and each change asks for the stage to be drawn again.
+    {
+        FramePacer pacer;
+        Player p(pacer);
+        p.run(60, 10000, 60000, QUALITY_BEST);
+        check_equals(pacer.stats().lowered, 1u);
+        check_equals(p.changes, 1);
+        check_equals(pacer.quality(QUALITY_BEST), QUALITY_HIGH);
+
+        // It goes down to low, and no further.
+        p.run(500, 10000, 60000, QUALITY_BEST);
+        check_equals(pacer.quality(QUALITY_BEST), QUALITY_LOW);
+        check_equals(pacer.stats().lowered, 3u);
+        check_equals(p.changes, 3);
+
+        // The quality asked for is still the one steps are taken from.
+        check_equals(pacer.quality(QUALITY_HIGH), QUALITY_LOW);
+
+        // Frames that cost a lot but fit aren't skipped, and don't raise
+        // the quality.
+        p.run(200, 10000, 20000, QUALITY_BEST);
+        check_equals(pacer.stats().raised, 0u);
+        check_equals(pacer.quality(QUALITY_BEST), QUALITY_LOW);
+
+        // Cheap ones raise it a step at a time, up to what was asked for,
+        // after a whole window of them.
+        size_t frames = 0;
+        while (!pacer.stats().raised && frames < 200) {
+            p.play(frame, 2000, 5000, QUALITY_BEST);
+            ++frames;
+        }
+        check(frames >= 48);
+        check(frames <= 96);
+        check_equals(pacer.stats().raised, 1u);
+        check_equals(pacer.quality(QUALITY_BEST), QUALITY_MEDIUM);
+        check_equals(p.changes, 4);
+
+        p.run(500, 2000, 5000, QUALITY_BEST);
+        check_equals(pacer.quality(QUALITY_BEST), QUALITY_BEST);
+        check_equals(pacer.stats().raised, 3u);
+        check_equals(p.changes, 6);
+    }
+
+    // A movie asking for low quality is never lowered, or raised above it.
+    {
+        FramePacer pacer;
+        Player p(pacer);
+        p.run(500, 10000, 60000, QUALITY_LOW);
+        check_equals(pacer.stats().lowered, 0u);
+        check_equals(p.changes, 0);
+        p.run(500, 2000, 5000, QUALITY_LOW);
+        check_equals(pacer.stats().raised, 0u);
+        check_equals(pacer.quality(QUALITY_LOW), QUALITY_LOW);
+    }
+
+    // A frame rate of 0 is taken as 12 frames per second.
+    {
+        FramePacer pacer;
+        pacer.setFrameRate(0);
+        check(pacer.advanced(1000000, 1000));
+        check(pacer.advanced(1000000 + 1000000 / 12, 1000));
+        check(!pacer.advanced(1000000 + 3 * 1000000 / 12, 1000));
+    }
+
+    return 0;
+}
@@ -225,6 +225,44 @@ main(int /*argc*/, char** /*argv*/)
 	finSnap4.add(Range2d<int>(40,273, 108,287));
 
 	check(finSnap3.contains(finSnap4));
+
+	//
+	// Test combining many ranges
+	//
+
+	// A row of touching ranges, added out of order, becomes one range.
+	SnappingRanges2d<int> rowSnap;
+	for (int i = 0; i < 40; ++i) {
+		const int x = (i * 7) % 40 * 10;
+		rowSnap.add(Range2d<int>(x, 0, x + 10, 10));
+	}
+	rowSnap.combineRanges();
+	check_equals(rowSnap.size(), 1);
+	check(rowSnap.contains(Range2d<int>(0, 0, 400, 10)));
+
+	// Ranges far apart stay apart, while a range bridging two of them
+	// joins them.
+	SnappingRanges2d<int> gridSnap;
+	for (int i = 0; i < 6; ++i) {
+		for (int j = 0; j < 6; ++j) {
+			gridSnap.add(Range2d<int>(i * 100, j * 100,
+						i * 100 + 10, j * 100 + 10));
+		}
+	}
+	check_equals(gridSnap.size(), 36);
+	gridSnap.add(Range2d<int>(5, 5, 105, 15));
+	gridSnap.combineRanges();
+	check_equals(gridSnap.size(), 35);
+	check(gridSnap.contains(Range2d<int>(0, 0, 110, 15)));
+	check(gridSnap.contains(Range2d<int>(500, 500, 510, 510)));
+	check(!gridSnap.contains(50, 50));
+
+	// Too many ranges become one.
+	gridSnap.setRangeCountLimit(20);
+	gridSnap.combineRanges();
+	check_equals(gridSnap.size(), 1);
+	check(gridSnap.contains(50, 50));
+
 	return 0;
 }
 
@@ -0,0 +1,298 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+// Time an Array used the way ActionScript code uses them: filled and
+// read by index, pushed to, joined and spliced, and filled and read by
+// index in a loop of ActionScript bytecode. This isn't run as part of the
+// testsuite, run it by hand with an optional element count.
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "movie_root.h"
+#include "as_object.h"
+#include "as_value.h"
+#include "Global_as.h"
+#include "Array_as.h"
+#include "namedStrings.h"
+#include "log.h"
+#include "VM.h"
+#include "DummyMovieDefinition.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+#include "SWF.h"
+#include "SWFStream.h"
+#include "action_buffer.h"
+#include "ActionExec.h"
+#include "as_environment.h"
+#include "TimelineMovie.h"
+
+using namespace gnash;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double
+millis(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+            Clock::now() - start).count();
+}
+
+/// Writes SWF action bytecode.
+class ActionWriter : public SWFWriter
+{
+public:
+
+    void push(const char* str) {
+        u8(SWF::ACTION_PUSHDATA);
+        u16(std::strlen(str) + 2);
+        u8(0);
+        while (*str) u8(*str++);
+        u8(0);
+    }
+
+    void push(std::int32_t i) {
+        u8(SWF::ACTION_PUSHDATA);
+        u16(5);
+        u8(7);
+        u32(i);
+    }
+
+    void op(SWF::ActionType a) {
+        u8(a);
+    }
+
+    /// A branch by `offset' bytes from the end of the branch.
+    void branch(SWF::ActionType a, std::int16_t offset) {
+        u8(a);
+        u16(2);
+        u16(offset);
+    }
+
+    void append(const SWFWriter& code) {
+        for (std::uint8_t b : code.data()) u8(b);
+    }
+
+    static const int branchSize = 5;
+};
+
+/// for (i = 0; i < count; ++i) body
+ActionWriter
+loop(const ActionWriter& body, size_t count)
+{
+    ActionWriter cond;
+    cond.push("i");
+    cond.op(SWF::ACTION_GETVARIABLE);
+    cond.push(count);
+    cond.op(SWF::ACTION_NEWLESSTHAN);
+    cond.op(SWF::ACTION_LOGICALNOT);
+
+    ActionWriter step(body);
+    step.push("i");
+    step.push("i");
+    step.op(SWF::ACTION_GETVARIABLE);
+    step.op(SWF::ACTION_INCREMENT);
+    step.op(SWF::ACTION_SETVARIABLE);
+
+    ActionWriter code;
+    code.push("i");
+    code.push(0);
+    code.op(SWF::ACTION_SETVARIABLE);
+    code.append(cond);
+    code.branch(SWF::ACTION_BRANCHIFTRUE,
+            step.data().size() + ActionWriter::branchSize);
+    code.append(step);
+    code.branch(SWF::ACTION_BRANCHALWAYS, -static_cast<int>(
+                cond.data().size() + step.data().size() +
+                2 * ActionWriter::branchSize));
+    code.op(SWF::ACTION_END);
+    return code;
+}
+
+/// Read actions as a DoAction tag is read.
+void
+readActions(const ActionWriter& code, action_buffer& buf)
+{
+    SWFWriter tag;
+    tag.tag(SWF::DOACTION, code);
+
+    std::FILE* f = std::tmpfile();
+    std::fwrite(tag.data().data(), 1, tag.data().size(), f);
+    std::rewind(f);
+
+    std::unique_ptr<IOChannel> in(makeFileChannel(f, true));
+    SWFStream s(in.get());
+    s.open_tag();
+    buf.read(s, s.get_tag_end_position());
+}
+
+/// Run actions with the root movie as their target.
+double
+run(const ActionWriter& code, const movie_definition& md, MovieClip* root)
+{
+    action_buffer buf(md);
+    readActions(code, buf);
+
+    as_environment env(getVM(*getObject(root)));
+    env.set_target(root);
+    env.set_original_target(root);
+
+    Clock::time_point start = Clock::now();
+    ActionExec(buf, env)();
+    return millis(start);
+}
+
+}
+
+int
+main(int argc, char** argv)
+{
+    const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    VM& vm = stage.getVM();
+    Global_as& gl = *vm.getGlobal();
+
+    // a[i] = i, as ActionSetMember sets it.
+    as_object* a = gl.createArray();
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        a->set_element(i, static_cast<double>(i));
+    }
+    const double fill = millis(start);
+
+    // sum += a[i]
+    start = Clock::now();
+    double sum = 0;
+    as_value val;
+    for (size_t i = 0; i < count; ++i) {
+        a->get_element(i, &val);
+        sum += toNumber(val, vm);
+    }
+    const double read = millis(start);
+
+    // a[i] = i again, which sets elements that are there.
+    start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        a->set_element(i, static_cast<double>(count - i));
+    }
+    const double refill = millis(start);
+
+    // b.push(i)
+    as_object* b = gl.createArray();
+    start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        callMethod(b, NSV::PROP_PUSH, static_cast<double>(i));
+    }
+    const double push = millis(start);
+
+    // a.join()
+    start = Clock::now();
+    const std::string joined =
+        callMethod(a, getURI(vm, "join")).to_string();
+    const double join = millis(start);
+
+    // b.splice(i, 1) a few times, each of which moves most elements.
+    const size_t splices = 10;
+    start = Clock::now();
+    for (size_t i = 0; i < splices; ++i) {
+        callMethod(b, NSV::PROP_SPLICE, static_cast<double>(i), 1.0);
+    }
+    const double splice = millis(start);
+
+    // The same in ActionScript:
+    // var c = []; for (i = 0; i < count; ++i) c[i] = i;
+    MovieClip* root = const_cast<Movie*>(&stage.getRootMovie());
+    ActionWriter fillBody;
+    fillBody.push("c");
+    fillBody.op(SWF::ACTION_GETVARIABLE);
+    fillBody.push("i");
+    fillBody.op(SWF::ACTION_GETVARIABLE);
+    fillBody.push("i");
+    fillBody.op(SWF::ACTION_GETVARIABLE);
+    fillBody.op(SWF::ACTION_SETMEMBER);
+
+    ActionWriter asFill;
+    asFill.push("c");
+    asFill.push(0);
+    asFill.op(SWF::ACTION_INITARRAY);
+    asFill.op(SWF::ACTION_SETVARIABLE);
+    asFill.append(loop(fillBody, count));
+    const double scriptFill = run(asFill, *md, root);
+
+    // var s = 0; for (i = 0; i < count; ++i) s += c[i];
+    ActionWriter readBody;
+    readBody.push("s");
+    readBody.push("s");
+    readBody.op(SWF::ACTION_GETVARIABLE);
+    readBody.push("c");
+    readBody.op(SWF::ACTION_GETVARIABLE);
+    readBody.push("i");
+    readBody.op(SWF::ACTION_GETVARIABLE);
+    readBody.op(SWF::ACTION_GETMEMBER);
+    readBody.op(SWF::ACTION_NEWADD);
+    readBody.op(SWF::ACTION_SETVARIABLE);
+
+    ActionWriter asRead;
+    asRead.push("s");
+    asRead.push(0);
+    asRead.op(SWF::ACTION_SETVARIABLE);
+    asRead.append(loop(readBody, count));
+    const double scriptRead = run(asRead, *md, root);
+    const double scriptSum =
+        toNumber(getMember(*getObject(root), getURI(vm, "s")), vm);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << count << " elements (sum " << sum << ", "
+              << joined.size() << " characters joined)\n"
+              << "fill: " << fill << " ms\n"
+              << "read: " << read << " ms\n"
+              << "refill: " << refill << " ms\n"
+              << "push: " << push << " ms\n"
+              << "join: " << join << " ms\n"
+              << "splice: " << splice << " ms (" << splices << " times)\n"
+              << "script fill: " << scriptFill << " ms\n"
+              << "script read: " << scriptRead << " ms (sum "
+              << scriptSum << ")\n";
+
+    return 0;
+}
@@ -0,0 +1,271 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "movie_root.h"
+#include "as_object.h"
+#include "as_function.h"
+#include "as_value.h"
+#include "fn_call.h"
+#include "Global_as.h"
+#include "Array_as.h"
+#include "namedStrings.h"
+#include "VM.h"
+#include "log.h"
+#include "DummyMovieDefinition.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+// Array.CASEINSENSITIVE, DESCENDING, UNIQUESORT, RETURNINDEXEDARRAY
+// and NUMERIC
+const double caseInsensitive = 1;
+const double descending = 2;
+const double uniqueSort = 4;
+const double returnIndexed = 8;
+const double numeric = 16;
+
+as_object*
+makeArray(Global_as& gl, const vector<as_value>& values)
+{
+    VM& vm = getVM(gl);
+    as_object* a = gl.createArray();
+    for (size_t i = 0; i < values.size(); ++i) {
+        a->set_member(arrayKey(vm, i), values[i]);
+    }
+    return a;
+}
+
+string
+join(as_object* a)
+{
+    return callMethod(a, getURI(getVM(*a), "join"), ",").to_string();
+}
+
+as_object*
+record(Global_as& gl, const string& name, double price, double id)
+{
+    VM& vm = getVM(gl);
+    as_object* o = createObject(gl);
+    o->set_member(getURI(vm, "name"), name);
+    o->set_member(getURI(vm, "price"), price);
+    o->set_member(getURI(vm, "id"), id);
+    return o;
+}
+
+/// The ids of records, in the order of the array.
+string
+ids(as_object* a)
+{
+    VM& vm = getVM(*a);
+    string ret;
+    for (size_t i = 0; i < arrayLength(*a); ++i) {
+        as_object* o = toObject(getMember(*a, arrayKey(vm, i)), vm);
+        if (i) ret += ',';
+        ret += getMember(*o, getURI(vm, "id")).to_string();
+    }
+    return ret;
+}
+
+as_value
+ascending(const fn_call& fn)
+{
+    return toNumber(fn.arg(0), getVM(fn)) - toNumber(fn.arg(1), getVM(fn));
+}
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    VM& vm = stage.getVM();
+    Global_as& gl = *vm.getGlobal();
+
+    const ObjectURI sort = getURI(vm, "sort");
+    const ObjectURI sortOn = getURI(vm, "sortOn");
+
+    // Strings are compared by character code, so upper case comes first.
+    as_object* a = makeArray(gl, {"b", "a", "c", "A"});
+    callMethod(a, sort);
+    check_equals(join(a), "A,a,b,c");
+
+    // Equal elements keep their order.
+    a = makeArray(gl, {"b", "a", "c", "A"});
+    callMethod(a, sort, caseInsensitive);
+    check_equals(join(a), "a,A,b,c");
+
+    a = makeArray(gl, {"b", "a", "c", "A"});
+    callMethod(a, sort, caseInsensitive + descending);
+    check_equals(join(a), "c,b,a,A");
+
+    // Numbers are compared as strings unless the sort is numeric.
+    a = makeArray(gl, {10.0, 9.0, 100.0, 1.0});
+    callMethod(a, sort);
+    check_equals(join(a), "1,10,100,9");
+
+    a = makeArray(gl, {10.0, 9.0, 100.0, 1.0});
+    callMethod(a, sort, numeric);
+    check_equals(join(a), "1,9,10,100");
+
+    a = makeArray(gl, {10.0, 9.0, 100.0, 1.0});
+    callMethod(a, sort, numeric + descending);
+    check_equals(join(a), "100,10,9,1");
+
+    // Numbers come before NaN, null and undefined.
+    as_value null;
+    null.set_null();
+    a = makeArray(gl, {3.0, as_value(), null, NaN, 1.0});
+    callMethod(a, sort, numeric);
+    check_equals(join(a), "1,3,NaN,null,undefined");
+
+    a = makeArray(gl, {3.0, as_value(), null, NaN, 1.0});
+    callMethod(a, sort, numeric + descending);
+    check_equals(join(a), "undefined,null,NaN,3,1");
+
+    // A numeric sort compares as strings when either is a string.
+    a = makeArray(gl, {"10", 9.0, 2.0});
+    callMethod(a, sort, numeric);
+    check_equals(join(a), "10,2,9");
+
+    // A uniqueSort sort of equal elements fails and leaves them alone.
+    a = makeArray(gl, {3.0, 1.0, 3.0});
+    const as_value failed = callMethod(a, sort, numeric + uniqueSort);
+    check_equals(toNumber(failed, vm), 0);
+    check_equals(join(a), "3,1,3");
+
+    a = makeArray(gl, {"b", "B", "a"});
+    const as_value nocase = callMethod(a, sort, caseInsensitive + uniqueSort);
+    check_equals(toNumber(nocase, vm), 0);
+
+    a = makeArray(gl, {3.0, 1.0, 2.0});
+    const as_value sorted = callMethod(a, sort, numeric + uniqueSort);
+    const bool same = toObject(sorted, vm) == a;
+    check(same);
+    check_equals(join(a), "1,2,3");
+
+    // An returnIndexed sort doesn't change the array.
+    a = makeArray(gl, {"c", "a", "b"});
+    as_object* index = toObject(callMethod(a, sort, returnIndexed), vm);
+    check(index);
+    check_equals(join(index), "1,2,0");
+    check_equals(join(a), "c,a,b");
+
+    // A comparison function is still called.
+    a = makeArray(gl, {10.0, 9.0, 100.0, 1.0});
+    callMethod(a, sort, gl.createFunction(ascending));
+    check_equals(join(a), "1,9,10,100");
+
+    // sortOn a property.
+    vector<as_value> records = {
+        record(gl, "pear", 3, 0),
+        record(gl, "Apple", 2, 1),
+        record(gl, "apple", 5, 2),
+        record(gl, "fig", 2, 3)
+    };
+
+    a = makeArray(gl, records);
+    callMethod(a, sortOn, "price", numeric);
+    check_equals(ids(a), "1,3,0,2");
+
+    a = makeArray(gl, records);
+    callMethod(a, sortOn, "name");
+    check_equals(ids(a), "1,2,3,0");
+
+    a = makeArray(gl, records);
+    index = toObject(callMethod(a, sortOn, "price", numeric + returnIndexed), vm);
+    check(index);
+    check_equals(join(index), "1,3,0,2");
+    check_equals(ids(a), "0,1,2,3");
+
+    a = makeArray(gl, records);
+    const as_value repeated = callMethod(a, sortOn, "price", numeric + uniqueSort);
+    check_equals(toNumber(repeated, vm), 0);
+    check_equals(ids(a), "0,1,2,3");
+
+    // sortOn several properties, each in its own order.
+    as_object* fields = makeArray(gl, {"name", "price"});
+    as_object* flags = makeArray(gl, {caseInsensitive, numeric + descending});
+    a = makeArray(gl, records);
+    callMethod(a, sortOn, fields, flags);
+    check_equals(ids(a), "2,1,3,0");
+
+    // or the same order.
+    fields = makeArray(gl, {"price", "name"});
+    a = makeArray(gl, records);
+    callMethod(a, sortOn, fields, numeric + descending);
+    check_equals(ids(a), "2,0,3,1");
+
+    // Enough elements to be split between threads, with equal ones.
+    const size_t count = 100000;
+    vector<as_value> many;
+    for (size_t i = 0; i < count; ++i) {
+        many.push_back(record(gl, "", static_cast<double>((i * 7919) % 1000),
+                    static_cast<double>(i)));
+    }
+    a = makeArray(gl, many);
+    callMethod(a, sortOn, "price", numeric);
+
+    bool ordered = true;
+    double lastPrice = -1, lastId = -1;
+    for (size_t i = 0; i < count; ++i) {
+        as_object* o = toObject(getMember(*a, arrayKey(vm, i)), vm);
+        const double price = toNumber(getMember(*o, getURI(vm, "price")), vm);
+        const double id = toNumber(getMember(*o, getURI(vm, "id")), vm);
+        if (price < lastPrice || (price == lastPrice && id < lastId)) {
+            ordered = false;
+        }
+        lastPrice = price;
+        lastId = id;
+    }
+    check(ordered);
+    check_equals(arrayLength(*a), count);
+
+    return 0;
+}
@@ -0,0 +1,310 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "BitmapCache.h"
+#include "CachedBitmap.h"
+#include "DummyMovieDefinition.h"
+#include "DummyCharacter.h"
+#include "FillStyle.h"
+#include "GnashImage.h"
+#include "ManualClock.h"
+#include "MovieClip.h"
+#include "Renderer.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+#include "Transform.h"
+#include "VM.h"
+#include "as_object.h"
+#include "movie_root.h"
+#include "swf/ShapeRecord.h"
+#include "log.h"
+
+#include <iostream>
+#include <memory>
+#include <boost/intrusive_ptr.hpp>
+#include <boost/variant/get.hpp>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+class TestBitmap : public CachedBitmap
+{
+public:
+    explicit TestBitmap(std::unique_ptr<image::GnashImage> im)
+        :
+        _image(std::move(im))
+    {}
+
+    image::GnashImage& image() { return *_image; }
+    void dispose() { _image.reset(); }
+    bool disposed() const { return !_image; }
+
+private:
+    std::unique_ptr<image::GnashImage> _image;
+};
+
+/// A renderer that draws to bitmaps, and writes down what it displays.
+class TestRenderer : public Renderer
+{
+public:
+
+    TestRenderer() : bitmaps(0), shown(nullptr), _internal(false) {}
+
+    std::string description() const { return "test"; }
+
+    CachedBitmap* createCachedBitmap(std::unique_ptr<image::GnashImage> im) {
+        ++bitmaps;
+        return new TestBitmap(std::move(im));
+    }
+
+    void drawShape(const SWF::ShapeRecord& shape, const Transform&) {
+        if (_internal) return;
+        for (const SWF::Subshape& sub : shape.subshapes()) {
+            for (const FillStyle& fs : sub.fillStyles()) {
+                const BitmapFill* f = boost::get<BitmapFill>(&fs.fill);
+                if (f) shown = f->bitmap();
+            }
+        }
+    }
+
+    void drawVideoFrame(image::GnashImage*, const Transform&,
+            const SWFRect*, bool) {}
+    void drawLine(const std::vector<point>&, const rgba&,
+            const SWFMatrix&) {}
+    void draw_poly(const std::vector<point>&, const rgba&, const rgba&,
+            const SWFMatrix&, bool) {}
+    void drawGlyph(const SWF::ShapeRecord&, const rgba&, const SWFMatrix&) {}
+    void begin_submit_mask() {}
+    void end_submit_mask() {}
+    void disable_mask() {}
+
+    /// One device pixel for each stage pixel.
+    geometry::Range2d<int> world_to_pixel(const SWFRect& r) const {
+        return geometry::Range2d<int>(r.get_x_min() / 20, r.get_y_min() / 20,
+                r.get_x_max() / 20, r.get_y_max() / 20);
+    }
+    point pixel_to_world(int, int) const { return point(); }
+    void begin_display(const rgba&, int, int, float, float, float, float) {}
+    void end_display() {}
+
+    Renderer* startInternalRender(image::GnashImage&) {
+        _internal = true;
+        return this;
+    }
+    void endInternalRender() { _internal = false; }
+
+    /// The number of bitmaps made.
+    int bitmaps;
+
+    /// The last bitmap displayed.
+    const CachedBitmap* shown;
+
+private:
+    bool _internal;
+};
+
+/// A square, which counts how often it is drawn.
+class Box : public DummyCharacter
+{
+public:
+    Box(as_object* object, DisplayObject* parent, int size)
+        :
+        DummyCharacter(object, parent),
+        draws(0),
+        _size(size)
+    {}
+
+    void display(Renderer&, const Transform&) {
+        ++draws;
+        clear_invalidated();
+    }
+
+    void drawContents(Renderer&, const Transform&) {
+        ++draws;
+    }
+
+    SWFRect getBounds() const {
+        return SWFRect(0, 0, pixelsToTwips(_size), pixelsToTwips(_size));
+    }
+
+    int draws;
+
+private:
+    const int _size;
+};
+
+/// A Transform moved by some pixels.
+Transform
+moved(int x, int y)
+{
+    SWFMatrix m;
+    m.set_translation(pixelsToTwips(x), pixelsToTwips(y));
+    return Transform(m);
+}
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+    ManualClock clock;
+    movie_root stage(clock, ri);
+    stage.init(md.get(), MovieClip::MovieVariables());
+
+    MovieClip* root = const_cast<Movie*>(&stage.getRootMovie());
+    Global_as& gl = getGlobal(*getObject(root));
+    TestRenderer renderer;
+
+    // A clip displayed from a bitmap, which only draws its children
+    // again when it has to.
+    Box* box = new Box(createObject(gl), root, 10);
+    root->attachCharacter(*box, 1, nullptr);
+    root->setCacheAsBitmap(true);
+    const BitmapCachePool& pool = *stage.bitmapCachePool();
+
+    root->display(renderer, Transform());
+    check_equals(box->draws, 1);
+    check_equals(renderer.bitmaps, 1);
+    check(renderer.shown);
+    check_equals(pool.stats().surfaces, 1u);
+    check_equals(pool.stats().redraws, 1u);
+    // Held, so that no new bitmap is made at the same address.
+    const boost::intrusive_ptr<const CachedBitmap> first(renderer.shown);
+
+    // Moving it displays the same bitmap.
+    root->display(renderer, moved(30, 40));
+    root->display(renderer, moved(-5, 7));
+    check_equals(box->draws, 1);
+    check_equals(renderer.bitmaps, 1);
+    check(renderer.shown == first);
+    check_equals(pool.stats().hits, 2u);
+
+    // Scaling it draws a new one.
+    SWFMatrix scaled;
+    scaled.set_scale(2, 2);
+    root->display(renderer, Transform(scaled));
+    check_equals(box->draws, 2);
+    check_equals(renderer.bitmaps, 2);
+    check(renderer.shown != first);
+    check_equals(pool.stats().surfaces, 1u);
+
+    // So does rotating it, even though the bitmap is the same size. The
+    // renderer might have copied the old one, so the new contents don't
+    // go into it.
+    root->display(renderer, Transform());
+    const boost::intrusive_ptr<const CachedBitmap> upright(renderer.shown);
+    const size_t bytes = pool.stats().bytes;
+    SWFMatrix rotated;
+    rotated.set_rotation(PI / 2);
+    root->display(renderer, Transform(rotated));
+    check_equals(box->draws, 4);
+    check_equals(renderer.bitmaps, 4);
+    check(renderer.shown != upright);
+    check_equals(pool.stats().bytes, bytes);
+    check_equals(pool.stats().surfaces, 1u);
+
+    // Moving a child draws the clip again.
+    root->display(renderer, Transform());
+    const int draws = box->draws;
+    SWFMatrix m;
+    m.set_translation(pixelsToTwips(2), 0);
+    box->setMatrix(m);
+    root->display(renderer, Transform());
+    check_equals(box->draws, draws + 1);
+
+    // So does adding one, and then nothing changes.
+    Box* other = new Box(createObject(gl), root, 10);
+    root->attachCharacter(*other, 2, nullptr);
+    root->display(renderer, Transform());
+    check_equals(box->draws, draws + 2);
+    check_equals(other->draws, 1);
+    root->display(renderer, moved(1, 1));
+    check_equals(box->draws, draws + 2);
+    check_equals(other->draws, 1);
+
+    root->setCacheAsBitmap(false);
+    check_equals(pool.stats().surfaces, 0u);
+    check_equals(pool.stats().bytes, 0u);
+
+    // Caches share the memory of a pool. A 10 pixel box has a pixel
+    // around it, so room for two of them is 2 * 12 * 12 * 4 bytes.
+    std::shared_ptr<BitmapCachePool> small(new BitmapCachePool(1152));
+    Box& a = *new Box(createObject(gl), root, 10);
+    Box& b = *new Box(createObject(gl), root, 10);
+    Box& c = *new Box(createObject(gl), root, 10);
+    BitmapCache ca(small);
+    BitmapCache cb(small);
+    BitmapCache cc(small);
+
+    check(ca.prepare(a, renderer, Transform()));
+    check(cb.prepare(b, renderer, Transform()));
+    check_equals(small->stats().surfaces, 2u);
+    check_equals(small->stats().bytes, 1152u);
+    check_equals(small->stats().evicted, 0u);
+
+    // The bitmap used least recently makes room for a new one.
+    check(ca.prepare(a, renderer, moved(5, 5)));
+    check(cc.prepare(c, renderer, Transform()));
+    check_equals(small->stats().surfaces, 2u);
+    check_equals(small->stats().evicted, 1u);
+    check_equals(a.draws, 1);
+
+    // That one is drawn again when it is next displayed.
+    check(cb.prepare(b, renderer, Transform()));
+    check_equals(b.draws, 2);
+    check_equals(small->stats().evicted, 2u);
+    check(cc.prepare(c, renderer, Transform()));
+    check_equals(c.draws, 1);
+    check(ca.prepare(a, renderer, Transform()));
+    check_equals(a.draws, 2);
+    check_equals(small->stats().evicted, 3u);
+
+    // A bitmap bigger than the pool isn't kept.
+    Box& big = *new Box(createObject(gl), root, 100);
+    BitmapCache cbig(small);
+    check(!cbig.prepare(big, renderer, Transform()));
+    check_equals(small->stats().refused, 1u);
+    check_equals(small->stats().surfaces, 2u);
+
+    // Lowering the limit drops bitmaps until the rest fit.
+    small->setLimit(600);
+    check_equals(small->stats().surfaces, 1u);
+    check_equals(small->stats().bytes, 576u);
+    check_equals(small->stats().evicted, 4u);
+    check(ca.prepare(a, renderer, Transform()));
+    check_equals(a.draws, 2);
+
+    return 0;
+}
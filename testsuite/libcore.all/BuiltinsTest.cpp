@@ -0,0 +1,138 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "movie_root.h"
+#include "as_object.h"
+#include "as_function.h"
+#include "as_value.h"
+#include "fn_call.h"
+#include "Global_as.h"
+#include "NativeFunction.h"
+#include "Property.h"
+#include "VM.h"
+#include "log.h"
+#include "DummyMovieDefinition.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+
+#include <iostream>
+#include <string>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+as_value
+native(const fn_call& /*fn*/)
+{
+    return as_value(1000.0);
+}
+
+/// Whether a property of _global is still waiting to be looked up.
+bool
+declared(Global_as& gl, const ObjectURI& uri)
+{
+    const Property* p = gl.getOwnProperty(uri);
+    return p && p->isGetterSetter();
+}
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    VM& vm = stage.getVM();
+    Global_as& gl = *vm.getGlobal();
+
+    // Each phase of starting is timed.
+    const VM::StartupTimes& times = vm.startupTimes();
+    check_equals(times.size(), 2u);
+    check_equals(times[0].first, "strings");
+    check_equals(times[1].first, "classes");
+
+    // Function and Object are made at once, the other classes only when
+    // they are looked up.
+    check(!declared(gl, NSV::CLASS_FUNCTION));
+    check(!declared(gl, NSV::CLASS_OBJECT));
+    check(declared(gl, NSV::CLASS_STRING));
+    check(declared(gl, NSV::CLASS_ARRAY));
+    check(declared(gl, NSV::CLASS_MATH));
+
+    const as_value str = getMember(gl, NSV::CLASS_STRING);
+    check(str.is_function());
+    check(!declared(gl, NSV::CLASS_STRING));
+    check(declared(gl, NSV::CLASS_ARRAY));
+
+    // The prototype of an Array made from C++ is there once the class is.
+    as_object* array = gl.createArray();
+    check(!declared(gl, NSV::CLASS_ARRAY));
+    const as_value push = getMember(*array, getURI(vm, "push"));
+    check(push.is_function());
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    // Natives can be found whenever they were registered.
+    check(vm.getNative(251, 0));
+    check(vm.getNative(252, 0));
+    check(vm.getNative(100, 4));
+    check(!vm.getNative(251, 999));
+    check(!vm.getNative(1000, 0));
+
+    vm.registerNative(native, 1000, 1);
+    vm.registerNative(native, 1000, 0);
+    check(!vm.getNative(1000, 2));
+
+    as_object* obj = new as_object(gl);
+    obj->init_member("first", vm.getNative(1000, 0));
+    obj->init_member("second", vm.getNative(1000, 1));
+    check_equals(toNumber(callMethod(obj, getURI(vm, "first")), vm), 1000);
+    check_equals(toNumber(callMethod(obj, getURI(vm, "second")), vm), 1000);
+
+    // ASnative reaches the same table.
+    const as_value asnative = getMember(gl, getURI(vm, "ASnative"));
+    check(asnative.is_function());
+    const as_value fromScript =
+        callMethod(&gl, getURI(vm, "ASnative"), 1000.0, 0.0);
+    check(fromScript.is_function());
+
+    return 0;
+}
@@ -0,0 +1,176 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+// Time calls to functions with a few arguments, as scripts make them, and
+// count the memory allocated for each. This isn't run as part of the
+// testsuite, run it by hand with an optional call count.
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "movie_root.h"
+#include "as_object.h"
+#include "as_function.h"
+#include "as_value.h"
+#include "fn_call.h"
+#include "Global_as.h"
+#include "UserFunction.h"
+#include "log.h"
+#include "VM.h"
+#include "DummyMovieDefinition.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+
+namespace {
+
+/// The allocations made.
+size_t allocations = 0;
+
+}
+
+void*
+operator new(std::size_t size)
+{
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+using namespace gnash;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double sum = 0;
+
+as_value
+add(const fn_call& fn)
+{
+    for (size_t i = 0; i < fn.nargs; ++i) sum += fn.arg(i).to_number(8);
+    return as_value();
+}
+
+/// A function with local registers, as a Function2 has.
+class RegisterFunction : public UserFunction
+{
+public:
+
+    RegisterFunction(Global_as& gl) : UserFunction(gl) {}
+
+    virtual std::uint8_t registers() const {
+        return 10;
+    }
+
+    virtual as_value call(const fn_call& fn) {
+        FrameGuard guard(getVM(fn), *this);
+        CallFrame& cf = guard.callFrame();
+        for (size_t i = 0; i < fn.nargs; ++i) {
+            cf.setLocalRegister(i + 1, fn.arg(i));
+        }
+        return as_value();
+    }
+};
+
+void
+time(const std::string& what, size_t calls, as_object* obj,
+        const ObjectURI& uri, size_t nargs)
+{
+    const size_t before = allocations;
+    const Clock::time_point start = Clock::now();
+
+    for (size_t i = 0; i < calls; ++i) {
+        switch (nargs) {
+            case 0:
+                callMethod(obj, uri);
+                break;
+            case 2:
+                callMethod(obj, uri, 1.0, 2.0);
+                break;
+            default:
+                callMethod(obj, uri, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0);
+                break;
+        }
+    }
+
+    const double ms =
+        std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::cout << what << ", " << nargs << " arguments: " << ms << " ms, "
+              << double(allocations - before) / calls
+              << " allocations a call\n";
+}
+
+}
+
+int
+main(int argc, char** argv)
+{
+    const size_t calls = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    VM& vm = stage.getVM();
+    Global_as& gl = *vm.getGlobal();
+    as_object* obj = new as_object(gl);
+    obj->init_member("add", gl.createFunction(add));
+    obj->init_member("registers", new RegisterFunction(gl));
+
+    const ObjectURI addURI = getURI(vm, "add");
+    const ObjectURI registersURI = getURI(vm, "registers");
+
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (size_t nargs : {0, 2, 8}) {
+        time("builtin_function", calls, obj, addURI, nargs);
+    }
+    for (size_t nargs : {0, 2, 8}) {
+        time("function with registers", calls, obj, registersURI, nargs);
+    }
+
+    std::cout << "(" << sum << ")\n";
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+// Time a DisplayList driven like a timeline that places and removes a
+// lot of DisplayObjects every frame. This isn't run as part of the
+// testsuite, run it by hand with an optional DisplayObject count and
+// frame count.
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+#include "DisplayList.h"
+#include "movie_root.h"
+#include "DisplayObject.h"
+#include "log.h"
+#include "VM.h"
+#include "DummyMovieDefinition.h"
+#include "DummyCharacter.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+
+using namespace gnash;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double
+millis(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+            Clock::now() - start).count();
+}
+
+struct CountVisitor
+{
+    CountVisitor() : count(0) {}
+    void operator()(DisplayObject* ch) { count += ch->get_depth() & 1; }
+    size_t count;
+};
+
+}
+
+int
+main(int argc, char** argv)
+{
+    const size_t chars = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500;
+    const size_t frames = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200;
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    MovieClip* root = const_cast<Movie*>(&stage.getRootMovie());
+    Global_as& gl = getGlobal(*getObject(root));
+
+    // Timeline depths start at -16383.
+    const int base = DisplayObject::staticDepthOffset + 1;
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> depths(0, chars * 2 - 1);
+
+    DisplayList dlist;
+
+    double place = 0, lookup = 0, remove = 0, swap = 0, visit = 0;
+    size_t found = 0, visited = 0;
+
+    for (size_t frame = 0; frame < frames; ++frame) {
+
+        // PlaceObject at random depths, replacing what's there.
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < chars; ++i) {
+            DisplayObject* ch = new DummyCharacter(createObject(gl), root);
+            dlist.placeDisplayObject(ch, base + depths(rng));
+        }
+        place += millis(start);
+
+        start = Clock::now();
+        for (size_t i = 0; i < chars; ++i) {
+            found += dlist.getDisplayObjectAtDepth(base + depths(rng)) != 0;
+        }
+        lookup += millis(start);
+
+        start = Clock::now();
+        for (size_t i = 0; i < chars / 4; ++i) {
+            DisplayObject* ch =
+                dlist.getDisplayObjectAtDepth(base + depths(rng));
+            const int depth = base + depths(rng);
+            if (ch && ch->get_depth() != depth) dlist.swapDepths(ch, depth);
+        }
+        swap += millis(start);
+
+        start = Clock::now();
+        CountVisitor counter;
+        dlist.visitAll(counter);
+        visited += counter.count;
+        visit += millis(start);
+
+        // RemoveObject at random depths.
+        start = Clock::now();
+        for (size_t i = 0; i < chars; ++i) {
+            dlist.removeDisplayObject(base + depths(rng));
+        }
+        dlist.removeUnloaded();
+        remove += millis(start);
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+              << chars << " DisplayObjects, " << frames << " frames, "
+              << dlist.size() << " left\n"
+              << "place:  " << place << " ms\n"
+              << "lookup: " << lookup << " ms (" << found << " found)\n"
+              << "swap:   " << swap << " ms\n"
+              << "visit:  " << visit << " ms (" << visited << ")\n"
+              << "remove: " << remove << " ms\n";
+
+    dlist.destroy();
+    return 0;
+}
@@ -37,12 +37,53 @@
 #include <sstream>
 #include <cassert>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 #include "check.h"
 
 using namespace std;
 using namespace gnash;
 
+namespace {
+
+/// A DisplayObject with an onUnload handler, so that it stays around
+/// after being removed.
+class Unloading : public DummyCharacter
+{
+public:
+    Unloading(as_object* object, DisplayObject* parent)
+        :
+        DummyCharacter(object, parent)
+    {}
+
+protected:
+    bool unloadChildren() { return true; }
+};
+
+/// The DisplayObjects in a list, from the lowest depth.
+std::vector<DisplayObject*>
+contents(const DisplayList& dl)
+{
+    std::vector<DisplayObject*> chars;
+    auto add = [&chars](DisplayObject* ch) { chars.push_back(ch); };
+    dl.visitAll(add);
+    return chars;
+}
+
+/// Whether the DisplayObjects in a list are in order of depth.
+bool
+sorted(const DisplayList& dl)
+{
+    const std::vector<DisplayObject*> chars = contents(dl);
+    for (size_t i = 1; i < chars.size(); ++i) {
+        if (chars[i - 1]->get_depth() >= chars[i]->get_depth()) return false;
+    }
+    return true;
+}
+
+}
+
 TRYMAIN(_runtest);
 int
 trymain(int /*argc*/, char** /*argv*/)
@@ -91,7 +132,238 @@ trymain(int /*argc*/, char** /*argv*/)
     
     dlist2.placeDisplayObject(ch2, 1);
     dlist2.placeDisplayObject(ch1, 2);
-    
+
+    // Depth lookup and ordering
+    DisplayList dlist3;
+    check_equals(dlist3.getNextHighestDepth(), 0);
+    check_equals(dlist3.getDisplayObjectAtDepth(1), (DisplayObject*)0);
+
+    DisplayObject* chs[5];
+    for (size_t i = 0; i < 5; ++i) {
+        chs[i] = new DummyCharacter(
+                createObject(getGlobal(*getObject(root))), root);
+    }
+
+    dlist3.placeDisplayObject(chs[0], 10);
+    dlist3.placeDisplayObject(chs[1], 3);
+    dlist3.placeDisplayObject(chs[2], 7);
+    check_equals(dlist3.size(), 3);
+    check_equals(dlist3.getDisplayObjectAtDepth(3), chs[1]);
+    check_equals(dlist3.getDisplayObjectAtDepth(7), chs[2]);
+    check_equals(dlist3.getDisplayObjectAtDepth(10), chs[0]);
+    check_equals(dlist3.getDisplayObjectAtDepth(5), (DisplayObject*)0);
+    check_equals(dlist3.getDisplayObjectAtDepth(11), (DisplayObject*)0);
+    check_equals(dlist3.getNextHighestDepth(), 11);
+
+    // Swapping with an empty depth moves the DisplayObject.
+    dlist3.swapDepths(chs[1], 12);
+    check_equals(chs[1]->get_depth(), 12);
+    check_equals(dlist3.getDisplayObjectAtDepth(3), (DisplayObject*)0);
+    check_equals(dlist3.getDisplayObjectAtDepth(12), chs[1]);
+    check_equals(dlist3.getNextHighestDepth(), 13);
+
+    dlist3.swapDepths(chs[1], 1);
+    check_equals(dlist3.getDisplayObjectAtDepth(1), chs[1]);
+    check_equals(dlist3.getNextHighestDepth(), 11);
+
+    // Swapping with an occupied depth exchanges them.
+    dlist3.swapDepths(chs[1], 10);
+    check_equals(chs[1]->get_depth(), 10);
+    check_equals(chs[0]->get_depth(), 1);
+    check_equals(dlist3.getDisplayObjectAtDepth(10), chs[1]);
+    check_equals(dlist3.getDisplayObjectAtDepth(1), chs[0]);
+
+    // Inserting shifts the DisplayObjects above up to the next gap.
+    dlist3.placeDisplayObject(chs[3], 8);
+    dlist3.insertDisplayObject(chs[4], 7);
+    check_equals(dlist3.getDisplayObjectAtDepth(7), chs[4]);
+    check_equals(dlist3.getDisplayObjectAtDepth(8), chs[2]);
+    check_equals(dlist3.getDisplayObjectAtDepth(9), chs[3]);
+    check_equals(dlist3.getDisplayObjectAtDepth(10), chs[1]);
+    check_equals(dlist3.size(), 5);
+
+    // Removing
+    dlist3.removeDisplayObject(5);
+    check_equals(dlist3.size(), 5);
+    dlist3.removeDisplayObject(8);
+    check_equals(dlist3.size(), 4);
+    check_equals(dlist3.getDisplayObjectAtDepth(8), (DisplayObject*)0);
+    check_equals(dlist3.getDisplayObjectAtDepth(9), chs[3]);
+
+    // Visited from the lowest depth to the highest.
+    std::vector<int> depths;
+    auto depthsOf = [&depths](DisplayObject* ch) {
+        depths.push_back(ch->get_depth());
+    };
+    dlist3.visitAll(depthsOf);
+    check_equals(depths.size(), 4);
+    check(std::is_sorted(depths.begin(), depths.end()));
+    check_equals(depths.front(), 1);
+    check_equals(depths.back(), 10);
+
+    // Names are looked up in the list of a MovieClip, so that renaming
+    // its DisplayObjects tells the list. A list searched again and again
+    // indexes the names, so each name is looked up a few times.
+    VM& vm = getVM(*getObject(root));
+    string_table& st = vm.getStringTable();
+    const DisplayList& rootList = root->getDisplayList();
+    auto byName = [&](const std::string& name, bool nocase) {
+        DisplayObject* found = nullptr;
+        for (size_t i = 0; i < 5; ++i) {
+            found = rootList.getDisplayObjectByName(st, getURI(vm, name),
+                    nocase);
+        }
+        return found;
+    };
+
+    DisplayObject* named[10];
+    for (size_t i = 0; i < 10; ++i) {
+        named[i] = new DummyCharacter(
+                createObject(getGlobal(*getObject(root))), root);
+        named[i]->set_name(getURI(vm, "ch" + std::to_string(i)));
+        root->addDisplayListObject(named[i], i + 1);
+    }
+    check_equals(byName("ch3", false), named[3]);
+    check_equals(byName("CH3", true), named[3]);
+    check_equals(byName("CH3", false), (DisplayObject*)0);
+    check_equals(byName("ch10", false), (DisplayObject*)0);
+
+    named[3]->set_name(getURI(vm, "other"));
+    check_equals(byName("ch3", false), (DisplayObject*)0);
+    check_equals(byName("other", false), named[3]);
+
+    // The DisplayObject at the lowest depth is found.
+    named[7]->set_name(getURI(vm, "ch2"));
+    check_equals(byName("ch2", false), named[2]);
+    root->remove_display_object(3, 0);
+    check_equals(byName("ch2", false), named[7]);
+
+    DisplayObject* lower = new DummyCharacter(
+            createObject(getGlobal(*getObject(root))), root);
+    lower->set_name(getURI(vm, "ch2"));
+    root->addDisplayListObject(lower, 0);
+    check_equals(byName("ch2", false), lower);
+
+    // Merging the list a timeline rebuilt into the one displayed keeps
+    // the DisplayObjects that are still there, and replaces the others.
+    // The timeline's depths are all negative.
+    const int s = DisplayObject::staticDepthOffset;
+    Global_as& gl = getGlobal(*getObject(root));
+    auto dummy = [&gl, root]() -> DisplayObject* {
+        return new DummyCharacter(createObject(gl), root);
+    };
+
+    DisplayList shown;
+    DisplayObject* kept = dummy();
+    DisplayObject* replaced = dummy();
+    DisplayObject* gone = dummy();
+    DisplayObject* dynamic = dummy();
+    dynamic->setDynamic();
+    DisplayObject* after = dummy();
+    DisplayObject* scripted = dummy();
+    DisplayObject* high = dummy();
+    shown.placeDisplayObject(kept, s + 1);
+    shown.placeDisplayObject(replaced, s + 2);
+    shown.placeDisplayObject(gone, s + 4);
+    shown.placeDisplayObject(dynamic, s + 6);
+    shown.placeDisplayObject(after, s + 10);
+    shown.placeDisplayObject(scripted, 5);
+    shown.placeDisplayObject(high, 100000);
+
+    DisplayList rebuilt;
+    DisplayObject* same = dummy();
+    SWFMatrix moved;
+    moved.set_translation(200, 300);
+    same->setMatrix(moved);
+    DisplayObject* otherRatio = dummy();
+    otherRatio->set_ratio(3);
+    DisplayObject* added = dummy();
+    DisplayObject* overDynamic = dummy();
+    rebuilt.placeDisplayObject(same, s + 1);
+    rebuilt.placeDisplayObject(otherRatio, s + 2);
+    rebuilt.placeDisplayObject(added, s + 3);
+    rebuilt.placeDisplayObject(overDynamic, s + 6);
+
+    shown.mergeDisplayList(rebuilt, *root);
+    check_equals(rebuilt.size(), 0);
+    check_equals(shown.size(), 6);
+    check(sorted(shown));
+
+    // The same DisplayObject, moved as the timeline says.
+    check_equals(shown.getDisplayObjectAtDepth(s + 1), kept);
+    check_equals(getMatrix(*kept), moved);
+    check(same->isDestroyed());
+
+    // One of another ratio, or made by a script, is replaced.
+    check_equals(shown.getDisplayObjectAtDepth(s + 2), otherRatio);
+    check(replaced->isDestroyed());
+    check_equals(shown.getDisplayObjectAtDepth(s + 6), overDynamic);
+    check(dynamic->isDestroyed());
+
+    // New ones are added, and ones the timeline dropped are removed,
+    // after the last of the new list too.
+    check_equals(shown.getDisplayObjectAtDepth(s + 3), added);
+    check_equals(shown.getDisplayObjectAtDepth(s + 4), (DisplayObject*)0);
+    check(gone->isDestroyed());
+    check_equals(shown.getDisplayObjectAtDepth(s + 10), (DisplayObject*)0);
+    check(after->isDestroyed());
+
+    // Positive depths belong to scripts, and are left alone.
+    check_equals(shown.getDisplayObjectAtDepth(5), scripted);
+    check_equals(shown.getDisplayObjectAtDepth(100000), high);
+    check(!scripted->unloaded());
+
+    // A list with nothing at the timeline's depths takes all the new ones.
+    DisplayList bare;
+    bare.placeDisplayObject(dummy(), 7);
+    DisplayList timeline;
+    DisplayObject* first = dummy();
+    DisplayObject* second = dummy();
+    timeline.placeDisplayObject(first, s + 1);
+    timeline.placeDisplayObject(second, s + 2);
+    bare.mergeDisplayList(timeline, *root);
+    check_equals(bare.size(), 3);
+    check(sorted(bare));
+    check_equals(bare.getDisplayObjectAtDepth(s + 1), first);
+    check_equals(bare.getDisplayObjectAtDepth(s + 2), second);
+
+    // DisplayObjects with an onUnload handler are removed to the depths
+    // below the timeline's, and stay there when a new one is put where
+    // they were.
+    DisplayList unloading;
+    DisplayObject* dropped = new Unloading(createObject(gl), root);
+    DisplayObject* removedBefore = new Unloading(createObject(gl), root);
+    unloading.placeDisplayObject(dropped, s + 1);
+    unloading.placeDisplayObject(removedBefore, s + 2);
+    unloading.removeDisplayObject(s + 2);
+    check_equals(removedBefore->get_depth(),
+            DisplayObject::removedDepthOffset - (s + 2));
+
+    DisplayList again;
+    DisplayObject* reinserted = dummy();
+    DisplayObject* removedNew = new Unloading(createObject(gl), root);
+    again.placeDisplayObject(reinserted, s + 2);
+    again.placeDisplayObject(removedNew, s + 7);
+    again.removeDisplayObject(s + 7);
+
+    unloading.mergeDisplayList(again, *root);
+    check_equals(unloading.size(), 4);
+    check(sorted(unloading));
+    check_equals(unloading.getDisplayObjectAtDepth(s + 2), reinserted);
+    check_equals(unloading.getDisplayObjectAtDepth(s + 1), (DisplayObject*)0);
+    check(dropped->unloaded());
+    check(!dropped->isDestroyed());
+    check_equals(dropped->get_depth(),
+            DisplayObject::removedDepthOffset - (s + 1));
+    check_equals(removedBefore->get_depth(),
+            DisplayObject::removedDepthOffset - (s + 2));
+    check(!removedBefore->isDestroyed());
+
+    // The removed ones of the new list come along too.
+    const std::vector<DisplayObject*> chars = contents(unloading);
+    check(std::find(chars.begin(), chars.end(), removedNew) != chars.end());
+    check_equals(removedNew->get_depth(),
+            DisplayObject::removedDepthOffset - (s + 7));
+
     return 0;
 }
-
@@ -0,0 +1,344 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "filter_factory.h"
+#include "Filters.h"
+#include "IOChannel.h"
+#include "SWFStream.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+/// Reads the bytes of a filter record.
+class ByteReader : public IOChannel
+{
+public:
+    ByteReader(std::vector<std::uint8_t> bytes)
+        :
+        _bytes(std::move(bytes)),
+        _pos(0)
+    {}
+
+    std::streamsize read(void* dst, std::streamsize bytes) {
+        bytes = std::min<std::streamsize>(bytes, _bytes.size() - _pos);
+        std::copy(_bytes.begin() + _pos, _bytes.begin() + _pos + bytes,
+                static_cast<std::uint8_t*>(dst));
+        _pos += bytes;
+        return bytes;
+    }
+
+    std::streampos tell() const { return _pos; }
+
+    bool seek(std::streampos pos) {
+        if (pos > static_cast<std::streampos>(_bytes.size())) return false;
+        _pos = pos;
+        return true;
+    }
+
+    void go_to_end() { _pos = _bytes.size(); }
+    bool eof() const { return _pos == _bytes.size(); }
+    bool bad() const { return false; }
+    size_t size() const { return _bytes.size(); }
+
+private:
+    std::vector<std::uint8_t> _bytes;
+    size_t _pos;
+};
+
+/// Writes the fields of a filter record as they are in a SWF.
+class Record
+{
+public:
+    Record& u8(std::uint8_t v) {
+        bytes.push_back(v);
+        return *this;
+    }
+
+    Record& u16(std::uint16_t v) {
+        return u8(v & 0xff).u8(v >> 8);
+    }
+
+    Record& u32(std::uint32_t v) {
+        return u16(v & 0xffff).u16(v >> 16);
+    }
+
+    /// A 16.16 fixed point number.
+    Record& fixed(double v) {
+        return u32(static_cast<std::int32_t>(std::lround(v * 65536)));
+    }
+
+    /// An 8.8 fixed point number.
+    Record& fixed8(double v) {
+        return u16(static_cast<std::int16_t>(std::lround(v * 256)));
+    }
+
+    Record& f32(float v) {
+        std::uint32_t u;
+        std::memcpy(&u, &v, 4);
+        return u32(u);
+    }
+
+    Record& rgba(std::uint32_t rgb, std::uint8_t a) {
+        return u8(rgb >> 16).u8(rgb >> 8).u8(rgb).u8(a);
+    }
+
+    std::vector<std::uint8_t> bytes;
+};
+
+/// Read filters from a record.
+int
+readFilters(const Record& r, bool multiple, Filters& filters)
+{
+    ByteReader reader(r.bytes);
+    SWFStream in(&reader);
+    return filter_factory::read(in, multiple, &filters);
+}
+
+template<typename T>
+const T*
+only(const Filters& filters)
+{
+    return filters.size() == 1 ? dynamic_cast<const T*>(filters[0].get()) :
+        nullptr;
+}
+
+bool
+near(double a, double b)
+{
+    return std::abs(a - b) < 0.01;
+}
+
+/// A ConvolutionFilter that shows what was read.
+class TestConvolution : public ConvolutionFilter
+{
+public:
+    using ConvolutionFilter::_matrixX;
+    using ConvolutionFilter::_matrixY;
+    using ConvolutionFilter::_matrix;
+    using ConvolutionFilter::_divisor;
+    using ConvolutionFilter::_bias;
+    using ConvolutionFilter::_preserveAlpha;
+    using ConvolutionFilter::_clamp;
+    using ConvolutionFilter::_color;
+    using ConvolutionFilter::_alpha;
+};
+
+/// A ColorMatrixFilter that shows what was read.
+class TestColorMatrix : public ColorMatrixFilter
+{
+public:
+    using ColorMatrixFilter::m_matrix;
+};
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    // DropShadowFilter: inner and knockout set, composite source clear,
+    // so the object is hidden, and three passes.
+    {
+        Record r;
+        r.u8(0).rgba(0x102030, 0x80).fixed(4).fixed(6).fixed(M_PI / 2)
+            .fixed(5).fixed8(1.5).u8(0xc3);
+        Filters filters;
+        check_equals(readFilters(r, false, filters), 1);
+        const DropShadowFilter* f = only<DropShadowFilter>(filters);
+        check(f);
+        if (f) {
+            check_equals(f->m_color, 0x102030u);
+            check_equals(int(f->m_alpha), 0x80);
+            check_equals(f->m_blurX, 4);
+            check_equals(f->m_blurY, 6);
+            check(near(f->m_angle, 90));
+            check_equals(f->m_distance, 5);
+            check_equals(f->m_strength, 1.5);
+            check(f->m_inner);
+            check(f->m_knockout);
+            check(f->m_hideObject);
+            check_equals(int(f->m_quality), 3);
+        }
+    }
+
+    // The same with only composite source set, and all the passes.
+    {
+        Record r;
+        r.u8(0).rgba(0, 0xff).fixed(1).fixed(1).fixed(0).fixed(0)
+            .fixed8(1).u8(0x3f);
+        Filters filters;
+        readFilters(r, false, filters);
+        const DropShadowFilter* f = only<DropShadowFilter>(filters);
+        check(f && !f->m_inner && !f->m_knockout && !f->m_hideObject &&
+                f->m_quality == 31);
+    }
+
+    // BlurFilter: five bits of passes, then three reserved ones.
+    {
+        Record r;
+        r.u8(1).fixed(2.5).fixed(8).u8(0x17);
+        Filters filters;
+        check_equals(readFilters(r, false, filters), 1);
+        const BlurFilter* f = only<BlurFilter>(filters);
+        check(f);
+        if (f) {
+            check_equals(f->m_blurX, 2.5);
+            check_equals(f->m_blurY, 8);
+            check_equals(int(f->m_quality), 2);
+        }
+    }
+
+    // GlowFilter: inner clear, knockout set.
+    {
+        Record r;
+        r.u8(2).rgba(0xff0000, 0x40).fixed(3).fixed(3).fixed8(2).u8(0x61);
+        Filters filters;
+        readFilters(r, false, filters);
+        const GlowFilter* f = only<GlowFilter>(filters);
+        check(f);
+        if (f) {
+            check_equals(f->m_color, 0xff0000u);
+            check_equals(int(f->m_alpha), 0x40);
+            check_equals(f->m_strength, 2);
+            check(!f->m_inner);
+            check(f->m_knockout);
+            check_equals(int(f->m_quality), 1);
+        }
+    }
+
+    // BevelFilter: the type comes from the inner and on top bits, and
+    // there are four bits of passes.
+    {
+        const std::uint8_t flags[] = { 0x21, 0xa2, 0x33 };
+        const BevelFilter::bevel_type types[] = {
+            BevelFilter::OUTER_BEVEL,
+            BevelFilter::INNER_BEVEL,
+            BevelFilter::FULL_BEVEL
+        };
+        for (size_t i = 0; i < 3; ++i) {
+            Record r;
+            r.u8(3).rgba(0x000000, 0x20).rgba(0xffffff, 0xe0).fixed(4)
+                .fixed(4).fixed(M_PI).fixed(2).fixed8(1).u8(flags[i]);
+            Filters filters;
+            readFilters(r, false, filters);
+            const BevelFilter* f = only<BevelFilter>(filters);
+            check(f);
+            if (!f) continue;
+            check_equals(f->m_type, types[i]);
+            check_equals(int(f->m_quality), int(i + 1));
+            check_equals(f->m_shadowColor, 0u);
+            check_equals(f->m_highlightColor, 0xffffffu);
+            check_equals(int(f->m_highlightAlpha), 0xe0);
+            check(near(f->m_angle, 180));
+        }
+    }
+
+    // GradientGlowFilter: colors and alphas together, then the ratios.
+    {
+        Record r;
+        r.u8(4).u8(2).rgba(0x112233, 0x00).rgba(0x445566, 0xff)
+            .u8(0).u8(255).fixed(5).fixed(5).fixed(0).fixed(1).fixed8(1)
+            .u8(0x84);
+        Filters filters;
+        readFilters(r, false, filters);
+        const GradientGlowFilter* f = only<GradientGlowFilter>(filters);
+        check(f);
+        if (f) {
+            check_equals(f->m_colors.size(), 2u);
+            check_equals(f->m_colors[1], 0x445566u);
+            check_equals(int(f->m_alphas[1]), 0xff);
+            check_equals(int(f->m_ratios[1]), 255);
+            check_equals(f->m_type, GradientGlowFilter::INNER_GLOW);
+            check_equals(int(f->m_quality), 4);
+        }
+    }
+
+    // ConvolutionFilter: six reserved bits, then clamp and preserve alpha.
+    {
+        Record r;
+        r.u8(5).u8(3).u8(1).f32(3).f32(0.5f).f32(1).f32(2).f32(-1)
+            .rgba(0x00ff00, 0x7f).u8(0x02);
+        Filters filters;
+        readFilters(r, false, filters);
+        const ConvolutionFilter* f = only<ConvolutionFilter>(filters);
+        check(f);
+        if (f) {
+            TestConvolution t;
+            static_cast<ConvolutionFilter&>(t) = *f;
+            check_equals(int(t._matrixX), 3);
+            check_equals(int(t._matrixY), 1);
+            check_equals(t._divisor, 3);
+            check_equals(t._bias, 0.5);
+            check_equals(t._matrix.size(), 3u);
+            check_equals(t._matrix[2], -1);
+            check_equals(t._color, 0x00ff00u);
+            check_equals(int(t._alpha), 0x7f);
+            check(t._clamp);
+            check(!t._preserveAlpha);
+        }
+    }
+
+    // ColorMatrixFilter: twenty floats.
+    {
+        Record r;
+        r.u8(6);
+        for (int i = 0; i < 20; ++i) r.f32(i / 4.0f);
+        Filters filters;
+        readFilters(r, false, filters);
+        const ColorMatrixFilter* f = only<ColorMatrixFilter>(filters);
+        check(f);
+        if (f) {
+            TestColorMatrix t;
+            static_cast<ColorMatrixFilter&>(t) = *f;
+            check_equals(t.m_matrix.size(), 20u);
+            check_equals(t.m_matrix[19], 4.75);
+        }
+    }
+
+    // A list of filters, which stops at a type it doesn't know.
+    {
+        Record r;
+        r.u8(3).u8(1).fixed(1).fixed(1).u8(0x08)
+            .u8(1).fixed(2).fixed(2).u8(0x08)
+            .u8(9);
+        Filters filters;
+        check_equals(readFilters(r, true, filters), 2);
+        check_equals(filters.size(), 2u);
+    }
+
+    return 0;
+}
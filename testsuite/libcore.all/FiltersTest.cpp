@@ -0,0 +1,253 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "Filters.h"
+#include "GnashImage.h"
+#include "DummyMovieDefinition.h"
+#include "ManualClock.h"
+#include "MovieClip.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+#include "VM.h"
+#include "as_object.h"
+#include "Array_as.h"
+#include "movie_root.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+/// An image with premultiplied alpha and pixels that vary.
+//
+/// The width is odd, so the kernels that take sixteen bytes at a time
+/// also have some left over.
+std::unique_ptr<image::GnashImage>
+testImage(size_t width = 37, size_t height = 23)
+{
+    std::unique_ptr<image::GnashImage> im(new image::ImageRGBA(width, height));
+    std::uint32_t seed = 12345;
+    for (size_t y = 0; y < height; ++y) {
+        std::uint8_t* p = scanline(*im, y);
+        for (size_t x = 0; x < width; ++x, p += 4) {
+            seed = seed * 1103515245 + 12345;
+            // Some transparent pixels, some opaque, most in between.
+            const std::uint8_t a = (x < 3) ? 0 : (y < 3) ? 255 : seed >> 24;
+            for (size_t c = 0; c < 3; ++c) {
+                seed = seed * 1103515245 + 12345;
+                p[c] = a ? (seed >> 16) % (a + 1) : 0;
+            }
+            p[3] = a;
+        }
+    }
+    return im;
+}
+
+/// Apply a filter to a copy of an image.
+std::vector<std::uint8_t>
+applied(const BitmapFilter& f, const image::GnashImage& im, double scale)
+{
+    std::unique_ptr<image::GnashImage> copy(
+            new image::ImageRGBA(im.width(), im.height()));
+    copy->update(im);
+    f.apply(*copy, scale);
+    return std::vector<std::uint8_t>(copy->begin(), copy->end());
+}
+
+/// Whether a filter gives the same pixels with SSE2 and without.
+bool
+sameWithoutSSE2(const BitmapFilter& f, double scale = 1)
+{
+    std::unique_ptr<image::GnashImage> im = testImage();
+    useFiltersSSE2(true);
+    const std::vector<std::uint8_t> simd = applied(f, *im, scale);
+    useFiltersSSE2(false);
+    const std::vector<std::uint8_t> plain = applied(f, *im, scale);
+    useFiltersSSE2(true);
+    return simd == plain;
+}
+
+/// Whether all the colors of an image are no more than its alpha.
+bool
+premultiplied(const std::vector<std::uint8_t>& pixels)
+{
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        for (size_t c = 0; c < 3; ++c) {
+            if (pixels[i + c] > pixels[i + 3]) return false;
+        }
+    }
+    return true;
+}
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    if (!useFiltersSSE2(true)) {
+        cout << "Filters don't use SSE2 here, only the plain loops are "
+            "tested" << endl;
+    }
+
+    // Blurs, with radii that fit the image and ones that don't, and
+    // blurs of only one direction.
+    check(sameWithoutSSE2(BlurFilter(4, 4, 1)));
+    check(sameWithoutSSE2(BlurFilter(9, 3, 3)));
+    check(sameWithoutSSE2(BlurFilter(100, 60, 2)));
+    check(sameWithoutSSE2(BlurFilter(6, 0, 1)));
+    check(sameWithoutSSE2(BlurFilter(0, 6, 1)));
+    check(sameWithoutSSE2(BlurFilter(4, 4, 2), 2.5));
+
+    // Color matrices, including ones that need clamping.
+    std::vector<float> identity(20, 0);
+    identity[0] = identity[6] = identity[12] = identity[18] = 1;
+    check(sameWithoutSSE2(ColorMatrixFilter(identity)));
+
+    std::vector<float> grey(20, 0);
+    for (size_t r = 0; r < 3; ++r) {
+        grey[r * 5] = 0.3f;
+        grey[r * 5 + 1] = 0.59f;
+        grey[r * 5 + 2] = 0.11f;
+    }
+    grey[18] = 1;
+    check(sameWithoutSSE2(ColorMatrixFilter(grey)));
+
+    std::vector<float> bright(identity);
+    bright[0] = 2.5f;
+    bright[4] = 40;
+    bright[9] = -300;
+    bright[18] = 0.5f;
+    bright[19] = 10;
+    check(sameWithoutSSE2(ColorMatrixFilter(bright)));
+
+    // Convolutions, clamped to the edge and filled with a color.
+    const std::vector<float> sharpen = { 0, -1, 0, -1, 5, -1, 0, -1, 0 };
+    check(sameWithoutSSE2(ConvolutionFilter(3, 3, sharpen, 1, 0, false,
+                    true, 0, 0)));
+    check(sameWithoutSSE2(ConvolutionFilter(3, 3, sharpen, 2, 8, true,
+                    false, 0xff8000, 0x80)));
+    const std::vector<float> box(15, 1);
+    check(sameWithoutSSE2(ConvolutionFilter(5, 3, box, 15, 0, false,
+                    false, 0, 0)));
+
+    // The effects made from the blurred alpha.
+    check(sameWithoutSSE2(DropShadowFilter(4, 45, 0x000000, 0xff, 4, 4, 1,
+                    1, false, false, false)));
+    check(sameWithoutSSE2(GlowFilter(0xff0000, 0xff, 6, 6, 2, 2, true,
+                    false)));
+    check(sameWithoutSSE2(BevelFilter(4, 45, 0xffffff, 0xff, 0x000000,
+                    0xff, 4, 4, 1, 1, BevelFilter::FULL_BEVEL, false)));
+
+    // A blur of no size, or one pass of nothing, leaves the image alone.
+    std::unique_ptr<image::GnashImage> im = testImage();
+    const std::vector<std::uint8_t> original(im->begin(), im->end());
+    check(applied(BlurFilter(0, 0, 1), *im, 1) == original);
+    check(applied(BlurFilter(4, 4, 0), *im, 1) == original);
+    check(applied(ColorMatrixFilter(identity), *im, 1) == original);
+
+    // What the filters make is still premultiplied.
+    check(premultiplied(applied(BlurFilter(9, 3, 3), *im, 1)));
+    check(premultiplied(applied(ColorMatrixFilter(bright), *im, 1)));
+    check(premultiplied(applied(ConvolutionFilter(3, 3, sharpen, 1, 0,
+                        false, true, 0, 0), *im, 1)));
+
+    // An even color stays the same in the middle of a blur.
+    std::unique_ptr<image::GnashImage> flat(new image::ImageRGBA(32, 32));
+    std::fill(flat->begin(), flat->end(), 0x80);
+    const std::vector<std::uint8_t> blurred =
+        applied(BlurFilter(8, 8, 3), *flat, 1);
+    const size_t middle = (16 * 32 + 16) * 4;
+    check_equals(int(blurred[middle]), 0x80);
+    check_equals(int(blurred[middle + 3]), 0x80);
+
+    // The edges fade, as outside the image is transparent.
+    check(blurred[0] < 0x80);
+    check(blurred[3] < 0x80);
+
+    // The filters property gives copies of a MovieClip's filters.
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+    ManualClock clock;
+    movie_root stage(clock, ri);
+    stage.init(md.get(), MovieClip::MovieVariables());
+    MovieClip* root = const_cast<Movie*>(&stage.getRootMovie());
+    VM& vm = stage.getVM();
+
+    std::shared_ptr<Filters> filters(new Filters);
+    filters->emplace_back(new BlurFilter(6, 2, 3));
+    filters->emplace_back(new ColorMatrixFilter(grey));
+    root->setFilters(filters);
+
+    const as_value got = getMember(*getObject(root), getURI(vm, "filters"));
+    as_object* array = toObject(got, vm);
+    check(array);
+    if (array) {
+        check_equals(arrayLength(*array), 2u);
+        as_object* first = toObject(getOwnElement(*array, 0), vm);
+        BlurFilter* blur = first ?
+            dynamic_cast<BlurFilter*>(first->relay()) : nullptr;
+        check(blur);
+        as_object* second = toObject(getOwnElement(*array, 1), vm);
+        check(second && dynamic_cast<ColorMatrixFilter*>(second->relay()));
+
+        if (blur) {
+            check(blur != (*filters)[0].get());
+            check_equals(blur->m_blurX, 6);
+            check_equals(int(blur->m_quality), 3);
+
+            // Changing the copy leaves the filter alone.
+            blur->m_blurX = 20;
+            const BlurFilter* kept =
+                dynamic_cast<const BlurFilter*>((*root->filters())[0].get());
+            check(kept && kept->m_blurX == 6);
+        }
+
+        // Each get gives new copies.
+        const as_value again =
+            getMember(*getObject(root), getURI(vm, "filters"));
+        check(toObject(again, vm) != array);
+    }
+
+    // No filters give an empty array.
+    root->setFilters(std::shared_ptr<const Filters>());
+    const as_value none = getMember(*getObject(root), getURI(vm, "filters"));
+    as_object* empty = toObject(none, vm);
+    check(empty && arrayLength(*empty) == 0);
+
+    return 0;
+}
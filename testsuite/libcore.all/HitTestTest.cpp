@@ -0,0 +1,322 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "Geometry.h"
+#include "LineStyle.h"
+#include "DummyMovieDefinition.h"
+#include "DynamicShape.h"
+#include "FillStyle.h"
+#include "ManualClock.h"
+#include "MovieClip.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+#include "SWFMatrix.h"
+#include "VM.h"
+#include "as_object.h"
+#include "movie_root.h"
+#include "log.h"
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+/// Numbers that are random enough, and the same on every run.
+class Random
+{
+public:
+    explicit Random(std::uint32_t seed) : _seed(seed) {}
+
+    /// A number from lo to hi, both included.
+    std::int32_t operator()(std::int32_t lo, std::int32_t hi) {
+        _seed = _seed * 1103515245 + 12345;
+        return lo + (_seed >> 8) % (hi - lo + 1);
+    }
+
+private:
+    std::uint32_t _seed;
+};
+
+/// Paths of lines and curves, some filled, some stroked, some both.
+//
+/// The points are on a coarse grid now and then, so there are horizontal
+/// edges and edges that end where points are tested.
+std::vector<Path>
+randomPaths(Random& r, size_t lineStyles)
+{
+    std::vector<Path> paths;
+    const int npaths = r(1, 10);
+    for (int i = 0; i < npaths; ++i) {
+        const bool grid = r(0, 1);
+        const std::int32_t step = grid ? 500 : 1;
+        const std::int32_t x0 = r(-8, 8) * 500 / step * step;
+        const std::int32_t y0 = r(-8, 8) * 500 / step * step;
+        Path p(x0 + r(-200, 200) / step * step,
+                y0 + r(-200, 200) / step * step,
+                r(0, 2), r(0, 2), r(0, lineStyles));
+
+        const int nedges = r(1, 30);
+        for (int e = 0; e < nedges; ++e) {
+            const std::int32_t ax = x0 + r(-3000, 3000) / step * step;
+            const std::int32_t ay = y0 + r(-3000, 3000) / step * step;
+            if (r(0, 2)) {
+                p.drawLineTo(ax, ay);
+            }
+            else {
+                p.drawCurveTo(x0 + r(-3000, 3000), y0 + r(-3000, 3000),
+                        ax, ay);
+            }
+        }
+        if (r(0, 1)) p.close();
+        paths.push_back(p);
+    }
+    return paths;
+}
+
+/// A matrix that scales, rotates, skews and moves.
+SWFMatrix
+randomMatrix(Random& r)
+{
+    SWFMatrix m;
+    m.set_scale_rotation(r(-300, 300) / 100.0, r(-300, 300) / 100.0,
+            r(0, 628) / 100.0);
+    m.set_translation(r(-4000, 4000), r(-4000, 4000));
+    return m;
+}
+
+/// Whether the bands give the same answers as testing every edge.
+//
+/// @return the number of points where they differ.
+int
+bandedMismatches(Random& r, int& hits)
+{
+    std::vector<LineStyle> lineStyles;
+    lineStyles.push_back(LineStyle(0, rgba()));
+    lineStyles.push_back(LineStyle(80, rgba()));
+    lineStyles.push_back(LineStyle(40, rgba(), false, false));
+
+    const std::vector<Path> paths = randomPaths(r, lineStyles.size());
+    const geometry::EdgeBands bands(paths);
+    const SWFMatrix wm = randomMatrix(r);
+
+    int mismatches = 0;
+    for (int i = 0; i < 400; ++i) {
+        // Half of the points are on the grid.
+        const std::int32_t x = r(0, 1) ? r(-24, 24) * 500 : r(-12000, 12000);
+        const std::int32_t y = r(0, 1) ? r(-24, 24) * 500 : r(-12000, 12000);
+        const bool all = geometry::pointTest(paths, lineStyles, x, y, wm);
+        const bool banded =
+            geometry::pointTest(paths, lineStyles, x, y, wm, bands);
+        if (all) ++hits;
+        if (all != banded) {
+            std::cout << "pointTest(" << x << ", " << y << ") is " << all
+                << " without bands, " << banded << " with them" << std::endl;
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+/// A clip, and what it draws in its own coordinates.
+struct Drawn
+{
+    MovieClip* clip;
+    DynamicShape* shape;
+};
+
+/// Draw some filled and stroked shapes with the drawing API.
+void
+draw(Random& r, DynamicShape& g)
+{
+    const int shapes = r(0, 3);
+    for (int s = 0; s < shapes; ++s) {
+        if (r(0, 1)) {
+            g.lineStyle(r(0, 3) * 40, rgba(), r(0, 1), r(0, 1));
+        }
+        else {
+            g.resetLineStyle();
+        }
+        const bool filled = r(0, 2);
+        if (filled) g.beginFill(FillStyle(SolidFill(rgba())));
+        g.moveTo(r(-2000, 2000), r(-2000, 2000));
+        const int edges = r(1, 8);
+        for (int e = 0; e < edges; ++e) {
+            if (r(0, 1)) {
+                g.lineTo(r(-2000, 2000), r(-2000, 2000), 8);
+            }
+            else {
+                g.curveTo(r(-2000, 2000), r(-2000, 2000), r(-2000, 2000),
+                        r(-2000, 2000), 8);
+            }
+        }
+        if (filled) g.endFill();
+    }
+}
+
+/// Add a tree of clips with random drawings and transforms.
+void
+addClips(Random& r, Global_as& gl, MovieClip* parent, int levels,
+        std::vector<Drawn>& drawn)
+{
+    const int children = r(1, 3);
+    for (int i = 0; i < children; ++i) {
+        MovieClip* mc = new MovieClip(createObject(gl), nullptr,
+                parent->get_root(), parent);
+        parent->attachCharacter(*mc, i + 1, nullptr);
+        mc->setMatrix(randomMatrix(r));
+        DynamicShape& g = mc->graphics();
+        draw(r, g);
+        drawn.push_back(Drawn{mc, &g});
+        if (levels) addClips(r, gl, mc, levels - 1, drawn);
+    }
+}
+
+/// Whether a clip's own drawing contains a point, found without hit
+/// bounds or the bounds of any other clip.
+bool
+drawingHit(const Drawn& d, std::int32_t x, std::int32_t y)
+{
+    const SWFMatrix wm = getWorldMatrix(*d.clip).invert();
+    point lp(x, y);
+    wm.transform(lp);
+    if (!d.shape->getBounds().point_test(lp.x, lp.y)) return false;
+    return d.shape->pointTestLocal(lp.x, lp.y, wm);
+}
+
+/// Whether a clip and all of the clips it is in have hit bounds
+/// containing a point.
+bool
+inHitBounds(const DisplayObject* ch, std::int32_t x, std::int32_t y)
+{
+    for (; ch; ch = ch->parent()) {
+        if (!ch->hitBounds().point_test(x, y)) return false;
+    }
+    return true;
+}
+
+/// Test points against a tree of clips.
+//
+/// @return the number of points where pruning dropped a hit.
+int
+prunedMisses(Random& r, MovieClip* root, const std::vector<Drawn>& drawn,
+        int& hits)
+{
+    int misses = 0;
+    for (int i = 0; i < 300; ++i) {
+        const std::int32_t x = r(-20000, 20000);
+        const std::int32_t y = r(-20000, 20000);
+
+        bool hit = false;
+        for (const Drawn& d : drawn) {
+            if (!drawingHit(d, x, y)) continue;
+            hit = true;
+            if (!inHitBounds(d.clip, x, y)) {
+                std::cout << "(" << x << ", " << y << ") hits "
+                    << d.clip->getTarget() << " outside its hit bounds"
+                    << std::endl;
+                ++misses;
+            }
+        }
+        if (hit) ++hits;
+        if (hit && !root->pointInVisibleShape(x, y)) {
+            std::cout << "(" << x << ", " << y << ") hits a drawing, "
+                "but not the pruned tree" << std::endl;
+            ++misses;
+        }
+    }
+    return misses;
+}
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    Random r(20121);
+
+    // The edge bands of any paths, big enough for them or not, give
+    // the same answers as testing every edge.
+    int mismatches = 0;
+    int hits = 0;
+    for (int i = 0; i < 200; ++i) {
+        mismatches += bandedMismatches(r, hits);
+    }
+    check_equals(mismatches, 0);
+    // Not all misses, or the test is no test.
+    check(hits > 1000);
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+    ManualClock clock;
+    movie_root stage(clock, ri);
+    stage.init(md.get(), MovieClip::MovieVariables());
+
+    MovieClip* root = const_cast<Movie*>(&stage.getRootMovie());
+    Global_as& gl = getGlobal(*getObject(root));
+
+    // _root's transform is left out of some hit tests, so it is moved
+    // too.
+    std::vector<Drawn> drawn;
+    root->setMatrix(randomMatrix(r));
+    addClips(r, gl, root, 3, drawn);
+
+    // Pruning with the hit bounds never loses a hit.
+    int misses = 0;
+    hits = 0;
+    misses += prunedMisses(r, root, drawn, hits);
+
+    // Nor after clips are moved, and drawn in, once the bounds are
+    // cached.
+    for (int round = 0; round < 5; ++round) {
+        for (const Drawn& d : drawn) {
+            switch (r(0, 3)) {
+                case 0:
+                    d.clip->setMatrix(randomMatrix(r));
+                    break;
+                case 1:
+                    draw(r, d.clip->graphics());
+                    break;
+                default:
+                    break;
+            }
+        }
+        root->setMatrix(randomMatrix(r));
+        misses += prunedMisses(r, root, drawn, hits);
+    }
+    check_equals(misses, 0);
+    check(hits > 100);
+
+    return 0;
+}
@@ -0,0 +1,174 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "movie_root.h"
+#include "DisplayObject.h"
+#include "log.h"
+#include "VM.h"
+#include "DummyMovieDefinition.h"
+#include "DummyCharacter.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+#include "SWFMatrix.h"
+#include "snappingrange.h"
+
+#include <iostream>
+#include <sstream>
+#include <cassert>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+/// A DisplayObject with bounds, which it adds like most do.
+class Box : public DummyCharacter
+{
+public:
+    Box(as_object* object, DisplayObject* parent)
+        :
+        DummyCharacter(object, parent)
+    {
+    }
+
+    virtual SWFRect getBounds() const { return SWFRect(0, 0, 200, 200); }
+
+    void add_invalidated_bounds(InvalidatedRanges& ranges, bool force) {
+        DisplayObject::add_invalidated_bounds(ranges, force);
+    }
+};
+
+typedef geometry::Range2d<std::int32_t> Range;
+
+/// What the GUI does to find out what to draw.
+InvalidatedRanges
+invalidatedBounds(movie_root& stage)
+{
+    InvalidatedRanges ranges;
+    stage.add_invalidated_bounds(ranges, false);
+    ranges.combineRanges();
+    return ranges;
+}
+
+void
+moveTo(DisplayObject& ch, int x, int y)
+{
+    SWFMatrix m;
+    m.set_translation(x, y);
+    ch.setMatrix(m);
+}
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    MovieClip* root = const_cast<Movie*>(&stage.getRootMovie());
+    Global_as& gl = getGlobal(*getObject(root));
+
+    DisplayObject* a = new Box(createObject(gl), root);
+    DisplayObject* b = new Box(createObject(gl), root);
+    root->attachCharacter(*a, 1, nullptr);
+    root->attachCharacter(*b, 2, nullptr);
+    moveTo(*b, 4000, 4000);
+
+    // A new stage is drawn completely.
+    check(invalidatedBounds(stage).isWorld());
+
+    // Without a renderer, display() leaves the DisplayObjects
+    // invalidated, so this is what displaying clears.
+    stage.display();
+    root->clear_invalidated();
+    a->clear_invalidated();
+    b->clear_invalidated();
+
+    check(invalidatedBounds(stage).isNull());
+
+    // Moving adds where it was and where it is now, and nothing else.
+    moveTo(*b, 6000, 4000);
+    InvalidatedRanges ranges = invalidatedBounds(stage);
+    check(ranges.contains(Range(4000, 4000, 4200, 4200)));
+    check(ranges.contains(Range(6000, 4000, 6200, 4200)));
+    check(!ranges.intersects(Range(0, 0, 200, 200)));
+
+    // Changing the parent adds everything inside it.
+    stage.display();
+    b->clear_invalidated();
+    root->set_visible(false);
+    ranges = invalidatedBounds(stage);
+    check(ranges.contains(Range(0, 0, 200, 200)));
+    check(ranges.contains(Range(6000, 4000, 6200, 4200)));
+
+    // The parent is still invalidated after a display() that didn't
+    // draw it, so everything inside it is added as before.
+    root->set_visible(true);
+    stage.display();
+    moveTo(*a, 100, 0);
+    ranges = invalidatedBounds(stage);
+    check(ranges.contains(Range(100, 0, 300, 200)));
+    check(ranges.contains(Range(6000, 4000, 6200, 4200)));
+
+    stage.display();
+    root->clear_invalidated();
+    a->clear_invalidated();
+    b->clear_invalidated();
+
+    // Nothing of a masked DisplayObject outside its mask is added.
+    a->set_clip_depth(5);
+    stage.display();
+    a->clear_invalidated();
+    moveTo(*b, 4000, 4000);
+    check(invalidatedBounds(stage).isNull());
+
+    // Nor of a hidden one.
+    a->set_clip_depth(DisplayObject::noClipDepthValue);
+    b->set_visible(false);
+    stage.display();
+    a->clear_invalidated();
+    b->clear_invalidated();
+    moveTo(*b, 6000, 4000);
+    check(invalidatedBounds(stage).isNull());
+
+    return 0;
+}
+
@@ -0,0 +1,111 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <sstream>
+#include <cassert>
+
+#include "check.h"
+#include "Geometry.h"
+#include "SWFRect.h"
+#include "ShapeRecord.h"
+
+using namespace gnash;
+using namespace gnash::SWF;
+
+int main()
+{
+    // The start shape has two paths, the end shape one with as many
+    // edges as both of them.
+    Subshape s1;
+    Path p1(0, 0, 1, 1, 0);
+    p1.drawLineTo(100, 0);
+    p1.drawCurveTo(120, 40, 100, 100);
+    s1.addPath(p1);
+    Path p2(10, 10, 1, 1, 0);
+    p2.drawLineTo(20, 20);
+    s1.addPath(p2);
+
+    Subshape s2;
+    Path p3(200, 200, 1, 2, 0);
+    p3.drawLineTo(300, 200);
+    p3.drawCurveTo(340, 260, 300, 300);
+    p3.drawLineTo(200, 300);
+    s2.addPath(p3);
+
+    ShapeRecord a;
+    a.addSubshape(s1);
+    a.setBounds(SWFRect(0, 0, 100, 100));
+
+    ShapeRecord b;
+    b.addSubshape(s2);
+    b.setBounds(SWFRect(200, 200, 340, 300));
+
+    const MorphEdges edges(a, b);
+
+    ShapeRecord sh = a;
+    sh.setLerp(a, b, edges, 0.5);
+
+    check_equals(sh.getBounds().get_x_min(), 100);
+    check_equals(sh.getBounds().get_y_min(), 100);
+    check_equals(sh.getBounds().get_x_max(), 220);
+    check_equals(sh.getBounds().get_y_max(), 200);
+
+    const Subshape::Paths& paths = sh.subshapes().front().paths();
+    check_equals(paths.size(), 2);
+
+    check_equals(paths[0].ap, point(100, 100));
+    check_equals(paths[0].size(), 2);
+    check_equals(paths[0][0].ap, point(200, 100));
+    check_equals(paths[0][1].cp, point(230, 150));
+    check_equals(paths[0][1].ap, point(200, 200));
+
+    // The right fill comes from the end shape.
+    check_equals(paths[0].getLeftFill(), 1);
+    check_equals(paths[0].getRightFill(), 2);
+
+    // The second path starts at the end shape's first path, and its edge
+    // is paired with the next one of that path.
+    check_equals(paths[1].ap, point(105, 105));
+    check_equals(paths[1].size(), 1);
+    check_equals(paths[1][0].ap, point(110, 160));
+
+    // Tweening again doesn't depend on the last ratio.
+    sh.setLerp(a, b, edges, 1.0);
+    check_equals(paths[0].ap, point(200, 200));
+    check_equals(paths[0][1].cp, point(340, 260));
+    check_equals(paths[1][0].ap, point(200, 300));
+
+    sh.setLerp(a, b, edges, 0.0);
+    check_equals(paths[0].ap, point(0, 0));
+    check_equals(paths[0][0].ap, point(100, 0));
+    check_equals(paths[0][1].cp, point(120, 40));
+    check_equals(paths[1].ap, point(10, 10));
+    check_equals(paths[1][0].ap, point(20, 20));
+
+    // Coordinates are truncated, as they always were.
+    sh.setLerp(a, b, edges, 0.3);
+    check_equals(paths[1][0].ap, point(74, 104));
+
+    return 0;
+}
+
@@ -0,0 +1,162 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+// Time the target paths of SWF4 and SWF5 scripts, which get and set
+// variables of other clips and tellTarget them by path, in a movie with
+// a lot of clips. This isn't run as part of the testsuite, run it by
+// hand with an optional clip count and lookup count.
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include "movie_root.h"
+#include "MovieClip.h"
+#include "as_environment.h"
+#include "as_object.h"
+#include "as_value.h"
+#include "log.h"
+#include "VM.h"
+#include "DummyMovieDefinition.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+
+using namespace gnash;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double
+millis(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+            Clock::now() - start).count();
+}
+
+MovieClip*
+createClip(MovieClip* parent, const std::string& name, int depth)
+{
+    VM& vm = getVM(*getObject(parent));
+    const as_value clip = callMethod(getObject(parent),
+            getURI(vm, "createEmptyMovieClip"), name, depth);
+    return clip.toDisplayObject()->to_movie();
+}
+
+}
+
+int
+main(int argc, char** argv)
+{
+    const size_t clips = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+    const size_t calls = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    // SWF6, the last version with caseless names, and the first with
+    // createEmptyMovieClip.
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 6));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    MovieClip* root = const_cast<Movie*>(&stage.getRootMovie());
+
+    // clip0 to clipN on the root, each with a menu holding an item.
+    MovieClip* item = nullptr;
+    for (size_t i = 0; i < clips; ++i) {
+        MovieClip* clip = createClip(root, "clip" + std::to_string(i), i);
+        MovieClip* menu = createClip(clip, "menu", 0);
+        item = createClip(menu, "item", 0);
+    }
+    const std::string last = "clip" + std::to_string(clips - 1);
+
+    // Scripts of the last item.
+    as_environment env(stage.getVM());
+    env.set_target(item);
+    env.set_original_target(item);
+    const as_environment::ScopeStack scope;
+
+    setVariable(env, "/" + last + "/menu/item:count", 1.0, scope);
+    setVariable(env, "_root." + last + ".count", 2.0, scope);
+
+    // The paths are made once, as a script's constant pool does.
+    const std::string slash = "/" + last + "/menu/item:count";
+    const std::string dots = "_root." + last + ".menu.item.count";
+    const std::string parent = "_parent._parent.count";
+    const std::string target = "/" + last + "/menu";
+    const std::string set = "/" + last + "/menu:count";
+
+    double sum = 0;
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        sum += getVariable(env, slash, scope).to_number(8);
+    }
+    const double slashes = millis(start);
+
+    start = Clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        sum += getVariable(env, dots, scope).to_number(8);
+    }
+    const double dotted = millis(start);
+
+    start = Clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        sum += getVariable(env, parent, scope).to_number(8);
+    }
+    const double parents = millis(start);
+
+    // tellTarget
+    start = Clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        sum += findTarget(env, target) != nullptr;
+    }
+    const double targets = millis(start);
+
+    start = Clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        setVariable(env, set, static_cast<double>(i), scope);
+    }
+    const double sets = millis(start);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << clips << " clips, " << calls << " lookups each ("
+              << sum << ")\n"
+              << "get " << slash << ": " << slashes << " ms\n"
+              << "get " << dots << ": " << dotted << " ms\n"
+              << "get " << parent << ": " << parents << " ms\n"
+              << "tellTarget " << target << ": " << targets << " ms\n"
+              << "set " << set << ": " << sets << " ms\n";
+
+    return 0;
+}
@@ -0,0 +1,212 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "movie_root.h"
+#include "as_object.h"
+#include "as_function.h"
+#include "as_value.h"
+#include "fn_call.h"
+#include "Global_as.h"
+#include "NativeFunction.h"
+#include "Profiler.h"
+#include "VM.h"
+#include "log.h"
+#include "GnashSleep.h"
+#include "DummyMovieDefinition.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+/// Each millisecond sleep takes at least a millisecond.
+const long sleepMicros = 1000;
+
+as_value
+inner(const fn_call& /*fn*/)
+{
+    gnashSleep(sleepMicros);
+    return as_value();
+}
+
+as_value
+outer(const fn_call& fn)
+{
+    callMethod(fn.this_ptr, getURI(getVM(fn), "inner"));
+    callMethod(fn.this_ptr, getURI(getVM(fn), "inner"));
+    return as_value();
+}
+
+as_value
+recurse(const fn_call& fn)
+{
+    const int n = toInt(fn.arg(0), getVM(fn));
+    if (n > 1) callMethod(fn.this_ptr, getURI(getVM(fn), "recurse"), n - 1);
+    gnashSleep(sleepMicros);
+    return as_value();
+}
+
+/// The microseconds of each stack written.
+map<string, long>
+stacks(const Profiler& profiler)
+{
+    ostringstream out;
+    profiler.writeStacks(out);
+
+    map<string, long> ret;
+    istringstream in(out.str());
+    string line;
+    while (getline(in, line)) {
+        const string::size_type space = line.rfind(' ');
+        ret[line.substr(0, space)] = stol(line.substr(space + 1));
+    }
+    return ret;
+}
+
+struct Row
+{
+    Row() : calls(0), inclusive(0), exclusive(0) {}
+    long calls;
+    double inclusive;
+    double exclusive;
+};
+
+/// The calls and milliseconds of each function reported.
+map<string, Row>
+functions(const Profiler& profiler)
+{
+    ostringstream out;
+    profiler.writeReport(out);
+
+    map<string, Row> ret;
+    istringstream in(out.str());
+    string line;
+    getline(in, line);
+    getline(in, line);
+    while (getline(in, line) && !line.empty()) {
+        istringstream row(line);
+        Row r;
+        row >> r.calls >> r.inclusive >> r.exclusive;
+        string name;
+        row >> ws;
+        getline(row, name);
+        ret[name] = r;
+    }
+    return ret;
+}
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    VM& vm = stage.getVM();
+    check(!vm.profiler());
+
+    // inner is a NativeFunction, the others are builtin_functions.
+    vm.registerNative(inner, 1000, 0);
+    as_object* obj = new as_object(*vm.getGlobal());
+    obj->init_member("inner", vm.getNative(1000, 0));
+    obj->init_member("outer", vm.getGlobal()->createFunction(outer));
+    obj->init_member("recurse", vm.getGlobal()->createFunction(recurse));
+
+    Profiler& profiler = vm.startProfiling();
+    const bool started = vm.profiler() == &profiler;
+    check(started);
+
+    callMethod(obj, getURI(vm, "outer"));
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    callMethod(obj, getURI(vm, "recurse"), 3);
+    const double wall = std::chrono::duration<double, std::milli>(
+            Clock::now() - start).count();
+
+    // The stacks are named by what they were called.
+    const map<string, long> s = stacks(profiler);
+    check_equals(s.count("outer;inner"), 1u);
+    check_equals(s.count("recurse"), 1u);
+    check_equals(s.count("recurse;recurse"), 1u);
+    check_equals(s.count("recurse;recurse;recurse"), 1u);
+    check_equals(s.count("recurse;recurse;recurse;recurse"), 0u);
+
+    // Both calls of inner are in its stack.
+    const long innerMicros = s.find("outer;inner")->second;
+    check(innerMicros >= 2 * sleepMicros);
+    check(s.find("recurse;recurse;recurse")->second >= sleepMicros);
+
+    const map<string, Row> f = functions(profiler);
+    check_equals(f.size(), 3u);
+    check_equals(f.find("outer")->second.calls, 1);
+    check_equals(f.find("inner")->second.calls, 2);
+    check_equals(f.find("recurse")->second.calls, 3);
+
+    // The time in inner is taken from outer's exclusive time. The report
+    // rounds to microseconds, so allow a little for that.
+    const Row& innerRow = f.find("inner")->second;
+    const Row& outerRow = f.find("outer")->second;
+    check(outerRow.inclusive >= 2.0);
+    check(outerRow.exclusive <=
+            outerRow.inclusive - innerRow.inclusive + 0.01);
+
+    // Recursive calls are only timed once.
+    const Row& recurseRow = f.find("recurse")->second;
+    check(recurseRow.inclusive >= 3.0);
+    check(recurseRow.inclusive <= wall);
+    check(recurseRow.exclusive <= recurseRow.inclusive);
+
+    // Starting again keeps what was profiled.
+    Profiler& again = vm.startProfiling();
+    const bool same = &again == &profiler;
+    check(same);
+
+    return 0;
+}
@@ -203,6 +203,41 @@ trymain(int /*argc*/, char** /*argv*/)
 		check_equals(props.size(), 3);
 
 	}
+
+	// Array elements are indexed only when asked for.
+	PropertyList elements(*obj);
+	check ( elements.setValue(getURI(vm, "0"), val) );
+	check (!elements.getElement(0) );
+
+	elements.indexElements(true);
+	check (elements.getElement(0) == elements.getProperty(getURI(vm, "0")) );
+
+	check ( elements.setValue(getURI(vm, "1"), val) );
+	check ( elements.setValue(getURI(vm, "01"), val2) );
+	check ( elements.setValue(getURI(vm, "length"), 2) );
+	check (elements.getElement(1) == elements.getProperty(getURI(vm, "1")) );
+	check_strictly_equals ( elements.getElement(1)->getValue(*obj), val );
+	check (!elements.getElement(2) );
+
+	// An element far beyond the others is only found by name.
+	check ( elements.setValue(getURI(vm, "1000"), val) );
+	check (!elements.getElement(1000) );
+	check (elements.getProperty(getURI(vm, "1000")) );
+
+	// Setting an element keeps it where it was.
+	Property* element = elements.getElement(1);
+	check ( elements.setValue(getURI(vm, "1"), val3) );
+	check (elements.getElement(1) == element );
+	check_strictly_equals ( element->getValue(*obj), val3 );
+
+	// Deleted elements are gone from the index.
+	check (elements.delProperty(getURI(vm, "1")).second );
+	check (!elements.getElement(1) );
+	check (elements.getElement(0) );
+
+	elements.indexElements(false);
+	check (!elements.getElement(0) );
+
 	return 0;
 }
 
@@ -0,0 +1,184 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "Renderer_pipelined.h"
+#include "CachedBitmap.h"
+#include "GnashImage.h"
+#include "FillStyle.h"
+#include "Transform.h"
+#include "swf/ShapeRecord.h"
+#include "log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/variant/get.hpp>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+class TestBitmap : public CachedBitmap
+{
+public:
+    explicit TestBitmap(std::unique_ptr<image::GnashImage> im)
+        :
+        _image(std::move(im))
+    {}
+
+    image::GnashImage& image() { return *_image; }
+    void dispose() { _image.reset(); }
+    bool disposed() const { return !_image; }
+
+private:
+    std::unique_ptr<image::GnashImage> _image;
+};
+
+/// A renderer that takes its time over shapes, and writes down the first
+/// pixel of each bitmap it fills them with.
+class SlowRenderer : public Renderer
+{
+public:
+
+    SlowRenderer() : bitmaps(0) {}
+
+    std::string description() const { return "slow"; }
+
+    CachedBitmap* createCachedBitmap(std::unique_ptr<image::GnashImage> im) {
+        ++bitmaps;
+        return new TestBitmap(std::move(im));
+    }
+
+    void drawShape(const SWF::ShapeRecord& shape, const Transform&) {
+        // Long enough for the movie to go on with the bitmap.
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        for (const SWF::Subshape& sub : shape.subshapes()) {
+            for (const FillStyle& fs : sub.fillStyles()) {
+                const BitmapFill* f = boost::get<BitmapFill>(&fs.fill);
+                if (!f || !f->bitmap()) continue;
+                CachedBitmap& b = const_cast<CachedBitmap&>(*f->bitmap());
+                seen.push_back(b.disposed() ? -1 : *b.image().begin());
+            }
+        }
+    }
+
+    void drawVideoFrame(image::GnashImage*, const Transform&,
+            const SWFRect*, bool) {}
+    void drawLine(const std::vector<point>&, const rgba&,
+            const SWFMatrix&) {}
+    void draw_poly(const std::vector<point>&, const rgba&, const rgba&,
+            const SWFMatrix&, bool) {}
+    void drawGlyph(const SWF::ShapeRecord&, const rgba&, const SWFMatrix&) {}
+    void begin_submit_mask() {}
+    void end_submit_mask() {}
+    void disable_mask() {}
+    geometry::Range2d<int> world_to_pixel(const SWFRect&) const {
+        return geometry::Range2d<int>();
+    }
+    point pixel_to_world(int, int) const { return point(); }
+    void begin_display(const rgba&, int, int, float, float, float, float) {}
+    void end_display() {}
+    Renderer* startInternalRender(image::GnashImage&) { return nullptr; }
+    void endInternalRender() {}
+
+    /// Only read by the test after finish().
+    std::vector<int> seen;
+    int bitmaps;
+};
+
+/// A shape filled twice with a bitmap.
+SWF::ShapeRecord
+bitmapShape(const CachedBitmap* bitmap)
+{
+    SWF::Subshape sub;
+    const BitmapFill fill(BitmapFill::CLIPPED, bitmap, SWFMatrix(),
+            BitmapFill::SMOOTHING_UNSPECIFIED);
+    sub.fillStyles().push_back(FillStyle(fill));
+    sub.fillStyles().push_back(FillStyle(fill));
+
+    SWF::ShapeRecord shape;
+    shape.addSubshape(sub);
+    return shape;
+}
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    std::shared_ptr<SlowRenderer> slow(new SlowRenderer);
+    Renderer_pipelined renderer(slow);
+
+    // A bitmap changed, then disposed of, while the frame it is in is
+    // drawn. The frame is drawn as the bitmap was when it was recorded.
+    {
+        std::unique_ptr<image::GnashImage> im(new image::ImageRGBA(4, 4));
+        std::fill(im->begin(), im->end(), 0x11);
+        boost::intrusive_ptr<CachedBitmap> bitmap(
+                renderer.createCachedBitmap(std::move(im)));
+        check_equals(slow->bitmaps, 1);
+
+        renderer.drawShape(bitmapShape(bitmap.get()), Transform());
+        renderer.render();
+
+        std::fill(bitmap->image().begin(), bitmap->image().end(), 0x22);
+        bitmap->dispose();
+
+        renderer.finish();
+        check_equals(slow->seen.size(), 2u);
+        check(std::count(slow->seen.begin(), slow->seen.end(), 0x11) == 2);
+
+        // It was only copied once for both fills.
+        check_equals(slow->bitmaps, 2);
+    }
+
+    // A bitmap disposed of before it's recorded isn't copied.
+    {
+        slow->seen.clear();
+        std::unique_ptr<image::GnashImage> im(new image::ImageRGBA(4, 4));
+        boost::intrusive_ptr<CachedBitmap> bitmap(
+                renderer.createCachedBitmap(std::move(im)));
+        bitmap->dispose();
+
+        renderer.drawShape(bitmapShape(bitmap.get()), Transform());
+        renderer.render();
+        renderer.finish();
+
+        check_equals(slow->seen.size(), 2u);
+        check(std::count(slow->seen.begin(), slow->seen.end(), -1) == 2);
+        check_equals(slow->bitmaps, 3);
+    }
+
+    return 0;
+}
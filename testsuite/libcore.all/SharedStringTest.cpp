@@ -0,0 +1,101 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "SharedString.h"
+#include "log.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    SharedString empty;
+    check(empty.empty());
+    check_equals(empty.str(), "");
+    check_equals(empty.wide(7)->size(), 0u);
+    check(empty == SharedString(""));
+
+    // Appending to the whole of a string leaves its copies as they were.
+    SharedString a("abc");
+    SharedString b = a;
+    b.append("def");
+    check_equals(a.str(), "abc");
+    check_equals(b.str(), "abcdef");
+    check_equals(a.size(), 3u);
+    check_equals(b.size(), 6u);
+
+    // So does appending to one of them that is now shorter than the
+    // characters it shares.
+    SharedString c = a;
+    c.append("xyz");
+    check_equals(c.str(), "abcxyz");
+    check_equals(b.str(), "abcdef");
+    check_equals(a.str(), "abc");
+
+    b.append("ghi");
+    check_equals(b.str(), "abcdefghi");
+    check_equals(c.str(), "abcxyz");
+
+    // The characters are read where they are, up to the string's size.
+    check_equals(string(a.begin(), a.end()), "abc");
+    check_equals(string(b.begin(), b.end()), "abcdefghi");
+    check(empty.begin() == empty.end());
+
+    SharedString e;
+    e.append("");
+    check(e.empty());
+    e.append("abc");
+    check(e == a);
+    check(e != b);
+    check(SharedString("abcdef") != SharedString("abcxyz"));
+
+    // Strings are decoded for the version asked for.
+    SharedString u("\xc3\xa9t\xc3\xa9");
+    check_equals(u.wide(7)->size(), 3u);
+    check_equals(u.wide(5)->size(), 5u);
+    check((*u.wide(6))[0] == L'\xe9');
+
+    // What was decoded before stays as it was.
+    shared_ptr<const wstring> w = u.wide(7);
+    SharedString v = u;
+    v.append("s");
+    check_equals(v.wide(7)->size(), 4u);
+    check_equals(w->size(), 3u);
+    check_equals(u.wide(7)->size(), 3u);
+
+    std::ostringstream os;
+    os << b;
+    check_equals(os.str(), "abcdefghi");
+
+    return 0;
+}
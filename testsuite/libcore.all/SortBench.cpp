@@ -0,0 +1,170 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+// Time Array.sort() and sortOn() in their built-in orders, over records
+// like those of a catalog. This isn't run as part of the testsuite, run
+// it by hand with an optional record count.
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "movie_root.h"
+#include "as_object.h"
+#include "as_value.h"
+#include "Global_as.h"
+#include "Array_as.h"
+#include "namedStrings.h"
+#include "log.h"
+#include "VM.h"
+#include "DummyMovieDefinition.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+
+using namespace gnash;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double
+millis(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+            Clock::now() - start).count();
+}
+
+struct Record
+{
+    std::string name;
+    double price;
+};
+
+as_object*
+makeArray(Global_as& gl, const std::vector<as_value>& values)
+{
+    VM& vm = getVM(gl);
+    as_object* a = gl.createArray();
+    for (size_t i = 0; i < values.size(); ++i) {
+        a->set_member(arrayKey(vm, i), values[i]);
+    }
+    return a;
+}
+
+}
+
+int
+main(int argc, char** argv)
+{
+    const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    VM& vm = stage.getVM();
+    Global_as& gl = *vm.getGlobal();
+
+    // The same records each run, with some names and prices repeated.
+    std::mt19937 random(1);
+    std::vector<Record> records;
+    for (size_t i = 0; i < count; ++i) {
+        Record r;
+        r.name = (random() % 2 ? "Item " : "item ") +
+            std::to_string(random() % (count / 2 + 1));
+        r.price = (random() % 100000) / 100.0;
+        records.push_back(r);
+    }
+
+    std::vector<as_value> names, prices, objects;
+    for (const Record& r : records) {
+        names.emplace_back(r.name);
+        prices.emplace_back(r.price);
+        as_object* o = createObject(gl);
+        o->set_member(getURI(vm, "name"), r.name);
+        o->set_member(getURI(vm, "price"), r.price);
+        objects.emplace_back(o);
+    }
+
+    const ObjectURI sort = getURI(vm, "sort");
+    const ObjectURI sortOn = getURI(vm, "sortOn");
+
+    // Array.CASEINSENSITIVE, DESCENDING and NUMERIC
+    const double caseless = 1, descending = 2, numeric = 16;
+
+    as_object* a = makeArray(gl, names);
+    Clock::time_point start = Clock::now();
+    callMethod(a, sort);
+    const double strings = millis(start);
+
+    a = makeArray(gl, names);
+    start = Clock::now();
+    callMethod(a, sort, caseless + descending);
+    const double caselessDown = millis(start);
+
+    a = makeArray(gl, prices);
+    start = Clock::now();
+    callMethod(a, sort, numeric);
+    const double numbers = millis(start);
+
+    a = makeArray(gl, objects);
+    start = Clock::now();
+    callMethod(a, sortOn, "price", numeric);
+    const double onPrice = millis(start);
+
+    // sortOn(["name", "price"], [CASEINSENSITIVE, NUMERIC | DESCENDING])
+    as_object* fields = gl.createArray();
+    callMethod(fields, NSV::PROP_PUSH, "name", "price");
+    as_object* flags = gl.createArray();
+    callMethod(flags, NSV::PROP_PUSH, caseless, numeric + descending);
+
+    a = makeArray(gl, objects);
+    start = Clock::now();
+    callMethod(a, sortOn, fields, flags);
+    const double onBoth = millis(start);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << count << " records\n"
+              << "sort(): " << strings << " ms\n"
+              << "sort(CASEINSENSITIVE | DESCENDING): " << caselessDown
+              << " ms\n"
+              << "sort(NUMERIC): " << numbers << " ms\n"
+              << "sortOn(\"price\", NUMERIC): " << onPrice << " ms\n"
+              << "sortOn([\"name\", \"price\"], ...): " << onBoth << " ms\n";
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+// Time a String built by concatenating to it in a loop, as scripts
+// making CSV or HTML do, and then read a character at a time. This
+// isn't run as part of the testsuite, run it by hand with an optional
+// line count.
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include "movie_root.h"
+#include "as_object.h"
+#include "as_value.h"
+#include "Global_as.h"
+#include "log.h"
+#include "VM.h"
+#include "DummyMovieDefinition.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+
+using namespace gnash;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double
+millis(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+            Clock::now() - start).count();
+}
+
+}
+
+int
+main(int argc, char** argv)
+{
+    const size_t lines = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    const size_t calls = 1000;
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    VM& vm = stage.getVM();
+
+    // s = s + i + ",value\n", with the copies ActionNewAdd makes when
+    // getting the variable and setting it again.
+    as_value s("");
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < lines; ++i) {
+        as_value top = s;
+        newAdd(top, static_cast<double>(i), vm);
+        newAdd(top, ",value\n", vm);
+        s = top;
+    }
+    const double concat = millis(start);
+
+    // s.charAt(i), which makes a String object each time as calling a
+    // method of a primitive String does.
+    const ObjectURI charAt = getURI(vm, "charAt");
+    const size_t length = s.to_string().size();
+    start = Clock::now();
+    size_t commas = 0;
+    for (size_t i = 0; i < calls; ++i) {
+        as_object* str = s.to_object(vm);
+        const as_value c = callMethod(str, charAt,
+                static_cast<double>(i * (length / calls)));
+        if (c.to_string() == ",") ++commas;
+    }
+    const double chars = millis(start);
+
+    // s.indexOf("\n", i)
+    const ObjectURI indexOf = getURI(vm, "indexOf");
+    start = Clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        as_object* str = s.to_object(vm);
+        callMethod(str, indexOf, "\n", static_cast<double>(i * 100));
+    }
+    const double find = millis(start);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << lines << " lines, " << length << " characters\n"
+              << "concat: " << concat << " ms\n"
+              << "charAt: " << chars << " ms (" << calls << " times, "
+              << commas << " commas)\n"
+              << "indexOf: " << find << " ms (" << calls << " times)\n";
+
+    return 0;
+}
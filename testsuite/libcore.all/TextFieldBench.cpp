@@ -0,0 +1,127 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+// Time a TextField used like a log window, which has a line appended to
+// its text at a time and is scrolled to the end. This isn't run as part
+// of the testsuite, run it by hand with an optional line count.
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include "TextField.h"
+#include "movie_root.h"
+#include "log.h"
+#include "VM.h"
+#include "DummyMovieDefinition.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+#include "SWFRect.h"
+
+using namespace gnash;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double
+millis(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+            Clock::now() - start).count();
+}
+
+}
+
+int
+main(int argc, char** argv)
+{
+    const size_t lines = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    MovieClip* root = const_cast<Movie*>(&stage.getRootMovie());
+    Global_as& gl = getGlobal(*getObject(root));
+
+    TextField* log = new TextField(createObject(gl), root,
+            SWFRect(0, 0, 8000, 6000));
+    log->setWordWrap(true);
+
+    std::wstring text;
+
+    // Append lines, each longer than the field is wide now and then.
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < lines; ++i) {
+        text += L"line " + std::to_wstring(i) + L": something happened";
+        if (i % 10 == 0) {
+            text += L", and this line is long enough to be wrapped twice"
+                L" in a field that is four hundred pixels wide";
+        }
+        text += L"\n";
+        log->setTextValue(text);
+        log->setScroll(log->getMaxScroll());
+    }
+    const double append = millis(start);
+
+    // Scroll through the whole text.
+    start = Clock::now();
+    for (size_t i = 0; i < lines; i += 10) {
+        log->setScroll(i);
+    }
+    const double scroll = millis(start);
+
+    // Change a line in the middle, which lays out the lines after it.
+    start = Clock::now();
+    text[text.size() / 2] = L'X';
+    log->setTextValue(text);
+    const double edit = millis(start);
+
+    // Change the first line, which lays out everything again.
+    start = Clock::now();
+    text[0] = L'L';
+    log->setTextValue(text);
+    const double reflow = millis(start);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << lines << " lines, " << text.size() << " characters\n"
+              << "append: " << append << " ms\n"
+              << "scroll: " << scroll << " ms (" << lines / 10 << " times)\n"
+              << "edit: " << edit << " ms\n"
+              << "reflow: " << reflow << " ms\n";
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "TextField.h"
+#include "TextRecord.h"
+#include "movie_root.h"
+#include "log.h"
+#include "VM.h"
+#include "DummyMovieDefinition.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+#include "SWFRect.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+/// The layout of a TextField, written out so two can be compared.
+string
+layout(const TextField& tf)
+{
+    ostringstream s;
+    s << "maxScroll " << tf.getMaxScroll() << "\nlines";
+    for (size_t start : tf.getLineStarts()) s << ' ' << start;
+    s << '\n';
+    for (const SWF::TextRecord& rec : tf.getTextRecords()) {
+        s << rec.xOffset() << ',' << rec.yOffset() << ':';
+        for (const SWF::TextRecord::GlyphEntry& ge : rec.glyphs()) {
+            s << ' ' << ge.index << '/' << ge.advance;
+        }
+        s << '\n';
+    }
+    return s.str();
+}
+
+TextField*
+makeField(MovieClip* root)
+{
+    Global_as& gl = getGlobal(*getObject(root));
+    TextField* tf = new TextField(createObject(gl), root,
+            SWFRect(0, 0, 4000, 2000));
+    tf->setWordWrap(true);
+    return tf;
+}
+
+/// How a test sets up both fields before the text is set.
+typedef void (*Setup)(TextField&);
+
+void plain(TextField&) {}
+void bullets(TextField& tf) { tf.setBullet(true); }
+void centered(TextField& tf) { tf.setAlignment(TextField::ALIGN_CENTER); }
+void unwrapped(TextField& tf) { tf.setWordWrap(false); }
+
+/// Set a field's text to each of the texts in turn, and check that it is
+/// laid out each time as a new field with the same text is.
+void
+checkEdits(MovieClip* root, const string& name, Setup setup,
+        const wstring* texts, size_t count)
+{
+    TextField* edited = makeField(root);
+    setup(*edited);
+
+    for (size_t i = 0; i < count; ++i) {
+        edited->setTextValue(texts[i]);
+
+        TextField* fresh = makeField(root);
+        setup(*fresh);
+        fresh->setTextValue(texts[i]);
+
+        const string expected = layout(*fresh);
+        const string got = layout(*edited);
+        if (got == expected) {
+            _runtest.pass(name + " edit " + to_string(i));
+        }
+        else {
+            _runtest.fail(name + " edit " + to_string(i));
+            cout << "expected:\n" << expected << "got:\n" << got;
+        }
+    }
+}
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    MovieClip* root = const_cast<Movie*>(&stage.getRootMovie());
+
+    const wstring first = L"The first paragraph, which is long enough to"
+        L" be wrapped in a field two hundred pixels wide.\n";
+    const wstring second = L"A second one.\n";
+    const wstring third = L"And a third, which also goes on for long"
+        L" enough to take a few lines.";
+
+    // Each text is laid out from the one before.
+    const wstring texts[] = {
+        first + second,
+        // Appended.
+        first + second + third,
+        // A word changed in the middle paragraph.
+        first + L"A changed one.\n" + third,
+        // The middle paragraph gone.
+        first + third,
+        // A new paragraph in the last one.
+        first + L"And a third,\nwhich also goes on for long"
+            L" enough to take a few lines.",
+        // The last character changed.
+        first + L"And a third,\nwhich also goes on for long"
+            L" enough to take a few lines!",
+        // The first character changed.
+        L"t" + first.substr(1) + L"And a third,\nwhich also goes on for"
+            L" long enough to take a few lines!",
+        // Cut back to the first paragraph.
+        L"t" + first.substr(1),
+        // Two empty paragraphs, then one after them.
+        L"t" + first.substr(1) + L"\n\n" + second,
+        L"t" + first.substr(1) + L"\n\n" + third,
+        // Nothing.
+        L"",
+        first + second + third,
+    };
+    const size_t count = sizeof(texts) / sizeof(*texts);
+
+    // The texts must be laid out in more than one line, or nothing is
+    // tested.
+    {
+        TextField* tf = makeField(root);
+        tf->setTextValue(texts[1]);
+        check(tf->getLineStarts().size() > 4);
+    }
+
+    checkEdits(root, "plain", plain, texts, count);
+    checkEdits(root, "bullets", bullets, texts, count);
+    checkEdits(root, "centered", centered, texts, count);
+    checkEdits(root, "unwrapped", unwrapped, texts, count);
+
+    // Scrolling lays nothing out differently.
+    {
+        TextField* tf = makeField(root);
+        tf->setTextValue(texts[1]);
+        const string before = layout(*tf);
+        tf->setScroll(2);
+        tf->setScroll(0);
+        check_equals(layout(*tf), before);
+    }
+
+    return 0;
+}
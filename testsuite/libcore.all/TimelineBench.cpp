@@ -0,0 +1,99 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+// Time going back to earlier frames of a long timeline, as scrubbing
+// through a movie used like a video does. This isn't run as part of the
+// testsuite, run it by hand with an optional frame count and number of
+// DisplayObjects per frame.
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+
+#include "TimelineMovie.h"
+#include "movie_root.h"
+#include "MovieClip.h"
+#include "Movie.h"
+#include "log.h"
+#include "ManualClock.h"
+
+using namespace gnash;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double
+millis(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+            Clock::now() - start).count();
+}
+
+}
+
+int
+main(int argc, char** argv)
+{
+    const size_t frames = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000;
+    const int layers = argc > 2 ? std::strtol(argv[2], nullptr, 10) : 20;
+    const size_t seeks = 100;
+
+    RunResources ri;
+    boost::intrusive_ptr<movie_definition> md =
+        loadMovie(timelineMovie(frames, layers), ri);
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    MovieClip* root = const_cast<Movie*>(&stage.getRootMovie());
+    root->goto_frame(frames - 1);
+
+    // Go back through the whole timeline. The first seek makes the
+    // checkpoints.
+    Clock::time_point start = Clock::now();
+    for (size_t i = 1; i <= seeks; ++i) {
+        root->goto_frame(frames - 1 - i * (frames - 1) / seeks);
+    }
+    const double back = millis(start);
+
+    // Loop back from the end to somewhere in the middle.
+    start = Clock::now();
+    for (size_t i = 0; i < seeks; ++i) {
+        root->goto_frame(frames - 1);
+        root->goto_frame(frames / 2 - i);
+    }
+    const double loop = millis(start);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << frames << " frames, " << layers << " DisplayObjects\n"
+              << "back: " << back << " ms (" << seeks << " times)\n"
+              << "loop: " << loop << " ms (" << seeks << " times)\n"
+              << "checkpoint tags: " << md->timelineCheckpoints().size()
+              << "\n";
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "TimelineMovie.h"
+#include "movie_root.h"
+#include "MovieClip.h"
+#include "Movie.h"
+#include "DisplayObject.h"
+#include "log.h"
+#include "ManualClock.h"
+#include "SWFMatrix.h"
+#include "SWFCxForm.h"
+#include "SWFRect.h"
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+const size_t frames = 300;
+const int layers = 10;
+
+/// What is at each depth the timeline uses.
+struct State
+{
+    vector<bool> placed;
+    vector<SWFMatrix> matrices;
+    vector<SWFCxForm> cxforms;
+    vector<std::int32_t> widths;
+};
+
+State
+state(MovieClip& clip)
+{
+    State s;
+    for (int d = 1; d <= layers + 1; ++d) {
+        DisplayObject* ch = clip.getDisplayList().getDisplayObjectAtDepth(
+                d + DisplayObject::staticDepthOffset);
+        s.placed.push_back(ch);
+        s.matrices.push_back(ch ? getMatrix(*ch) : SWFMatrix());
+        s.cxforms.push_back(ch ? getCxForm(*ch) : SWFCxForm());
+        s.widths.push_back(ch ? ch->getBounds().width() : 0);
+    }
+    return s;
+}
+
+bool
+operator==(const State& a, const State& b)
+{
+    return a.placed == b.placed && a.matrices == b.matrices &&
+        a.cxforms == b.cxforms && a.widths == b.widths;
+}
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    RunResources ri;
+    boost::intrusive_ptr<movie_definition> md =
+        loadMovie(timelineMovie(frames, layers), ri);
+
+    check_equals(md->get_frame_count(), frames);
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    MovieClip* root = const_cast<Movie*>(&stage.getRootMovie());
+
+    // Going back to a frame leaves the same DisplayList as playing the
+    // frames up to it, whether or not there is a checkpoint before it.
+    const size_t targets[] = { 1, 20, 31, 32, 33, 100, 150, 199, 200, 257 };
+    for (size_t target : targets) {
+
+        root->goto_frame(0);
+        root->goto_frame(target);
+        check_equals(root->get_current_frame(), target);
+        const State played = state(*root);
+
+        root->goto_frame(frames - 1);
+        root->goto_frame(target);
+        check_equals(root->get_current_frame(), target);
+
+        const bool same = state(*root) == played;
+        std::ostringstream os;
+        os << "Frame " << target << " restored as played";
+        check_equals_label(os.str(), same, true);
+    }
+
+    // Something is at each depth at the end, and there are checkpoints
+    // of the frames before.
+    const State last = state(*root);
+    check(last.placed[0]);
+    check(md->timelineCheckpoints().size() > 0);
+
+    // Checkpoints aren't made when too many tags would be held, and
+    // frames are then restored from the first one.
+    TimelineCheckpoints small(32, 50);
+    const TimelineCheckpoints::Tags* tags = nullptr;
+    check_equals(small.find(*md, 64, tags), 32u);
+    check(tags);
+    check_equals(small.find(*md, 250, tags), 32u);
+    check(small.size() <= 50);
+
+    TimelineCheckpoints none(32, 0);
+    check_equals(none.find(*md, 250, tags), 0u);
+    check_equals(none.size(), 0u);
+
+    return 0;
+}
@@ -0,0 +1,262 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef GNASH_TESTSUITE_TIMELINEMOVIE_H
+#define GNASH_TESTSUITE_TIMELINEMOVIE_H
+
+// Write the SWF of a movie with a long timeline, in which DisplayObjects
+// are moved every frame and now and then replaced by others.
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <boost/intrusive_ptr.hpp>
+
+#include "MovieFactory.h"
+#include "movie_definition.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+#include "TagLoadersTable.h"
+#include "DefaultTagLoaders.h"
+#include "IOChannel.h"
+#include "tu_file.h"
+#include "URL.h"
+
+namespace gnash {
+
+class SWFWriter
+{
+public:
+
+    SWFWriter() : _bits(0) {}
+
+    void u8(int v) {
+        align();
+        _out.push_back(v & 0xff);
+    }
+
+    void u16(int v) {
+        u8(v);
+        u8(v >> 8);
+    }
+
+    void u32(std::uint32_t v) {
+        u16(v);
+        u16(v >> 16);
+    }
+
+    void bits(std::int32_t v, int n) {
+        for (int i = n - 1; i >= 0; --i) {
+            if (!_bits) _out.push_back(0);
+            if ((v >> i) & 1) _out.back() |= 0x80 >> _bits;
+            _bits = (_bits + 1) % 8;
+        }
+    }
+
+    void align() {
+        _bits = 0;
+    }
+
+    /// The bits needed for signed values from -v to v.
+    static int signedBits(std::int32_t v) {
+        int n = 1;
+        while (v >> (n - 1)) ++n;
+        return n;
+    }
+
+    void rect(int xmin, int xmax, int ymin, int ymax) {
+        const int n = signedBits(std::max(std::max(std::abs(xmin),
+                        std::abs(xmax)), std::max(std::abs(ymin),
+                        std::abs(ymax))));
+        bits(n, 5);
+        bits(xmin, n);
+        bits(xmax, n);
+        bits(ymin, n);
+        bits(ymax, n);
+        align();
+    }
+
+    void matrix(int x, int y) {
+        const int n = signedBits(std::max(std::abs(x), std::abs(y)));
+        bits(0, 1);
+        bits(0, 1);
+        bits(n, 5);
+        bits(x, n);
+        bits(y, n);
+        align();
+    }
+
+    /// A color transform with multiplication terms only.
+    void cxform(int r, int g, int b, int a) {
+        bits(0, 1);
+        bits(1, 1);
+        bits(10, 4);
+        bits(r, 10);
+        bits(g, 10);
+        bits(b, 10);
+        bits(a, 10);
+        align();
+    }
+
+    void tag(int code, const SWFWriter& body) {
+        const size_t len = body._out.size();
+        if (len < 0x3f) u16(code << 6 | len);
+        else {
+            u16(code << 6 | 0x3f);
+            u32(len);
+        }
+        _out.insert(_out.end(), body._out.begin(), body._out.end());
+    }
+
+    const std::vector<std::uint8_t>& data() const {
+        return _out;
+    }
+
+private:
+    std::vector<std::uint8_t> _out;
+    int _bits;
+};
+
+/// A movie with `frames' frames and DisplayObjects at `layers' depths.
+//
+/// Each frame:
+/// - moves the DisplayObjects at most depths.
+/// - changes the color of some of them instead.
+/// - replaces one in 25 by another character.
+/// - places or removes the one at the depth above all others
+///   every 100 frames.
+inline std::string
+timelineMovie(size_t frames, int layers)
+{
+    SWFWriter tags;
+
+    SWFWriter bg;
+    bg.u8(0xff);
+    bg.u8(0xff);
+    bg.u8(0xff);
+    tags.tag(9, bg);
+
+    // Two empty shapes of different sizes.
+    for (int id = 1; id <= 2; ++id) {
+        SWFWriter shape;
+        shape.u16(id);
+        shape.rect(0, id * 200, 0, id * 200);
+        shape.u8(0);
+        shape.u8(0);
+        shape.bits(0, 4);
+        shape.bits(0, 4);
+        shape.bits(0, 6);
+        tags.tag(2, shape);
+    }
+
+    for (size_t f = 0; f < frames; ++f) {
+        for (int d = 1; d <= layers; ++d) {
+            SWFWriter place;
+            if (!f || (f + d) % 25 == 0) {
+                if (f) {
+                    SWFWriter remove;
+                    remove.u16(d);
+                    tags.tag(28, remove);
+                }
+                place.u8(0x06);
+                place.u16(d);
+                place.u16(1 + (f / 25 + d) % 2);
+                place.matrix(d * 100, f % 1000);
+            }
+            else if ((f + d) % 7 == 0) {
+                place.u8(0x09);
+                place.u16(d);
+                place.cxform(256, f % 256, 128, 256);
+            }
+            else {
+                place.u8(0x05);
+                place.u16(d);
+                place.matrix(d * 100 + f % 50, f % 1000);
+            }
+            tags.tag(26, place);
+        }
+
+        if (f % 100 == 0) {
+            SWFWriter top;
+            if (f % 200 == 0) {
+                top.u8(0x06);
+                top.u16(layers + 1);
+                top.u16(1);
+                top.matrix(0, 0);
+                tags.tag(26, top);
+            }
+            else {
+                top.u16(layers + 1);
+                tags.tag(28, top);
+            }
+        }
+
+        tags.tag(1, SWFWriter());
+    }
+    tags.tag(0, SWFWriter());
+
+    SWFWriter header;
+    header.rect(0, 8000, 0, 6000);
+    header.u16(12 << 8);
+    header.u16(frames);
+
+    const size_t length = 8 + header.data().size() + tags.data().size();
+    SWFWriter swf;
+    swf.u8('F');
+    swf.u8('W');
+    swf.u8('S');
+    swf.u8(8);
+    swf.u32(length);
+
+    std::string s(swf.data().begin(), swf.data().end());
+    s.append(header.data().begin(), header.data().end());
+    s.append(tags.data().begin(), tags.data().end());
+    return s;
+}
+
+/// Load a movie from SWF data.
+inline boost::intrusive_ptr<movie_definition>
+loadMovie(const std::string& swf, RunResources& ri)
+{
+    std::shared_ptr<SWF::TagLoadersTable> loaders(
+            std::make_shared<SWF::TagLoadersTable>());
+    addDefaultLoaders(*loaders);
+    ri.setTagLoaders(loaders);
+
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    std::FILE* f = std::tmpfile();
+    std::fwrite(swf.data(), 1, swf.size(), f);
+    std::rewind(f);
+
+    boost::intrusive_ptr<movie_definition> md(MovieFactory::makeMovie(
+                makeFileChannel(f, true), "timeline.swf", ri, false));
+    md->completeLoad();
+    md->ensure_frame_loaded(md->get_frame_count());
+    return md;
+}
+
+} // namespace gnash
+
+#endif
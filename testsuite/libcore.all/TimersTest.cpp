@@ -0,0 +1,140 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "movie_root.h"
+#include "as_object.h"
+#include "as_function.h"
+#include "as_value.h"
+#include "fn_call.h"
+#include "Global_as.h"
+#include "Timers.h"
+#include "VM.h"
+#include "log.h"
+#include "DummyMovieDefinition.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+/// The first argument of each call to tick(), in order.
+std::string ticks;
+
+as_value
+tick(const fn_call& fn)
+{
+    ticks += fn.arg(0).to_string();
+    return as_value();
+}
+
+std::uint32_t
+addTimer(movie_root& stage, as_object* obj, unsigned long ms,
+        const std::string& arg, bool runOnce = false)
+{
+    fn_call::Args args;
+    args += arg;
+    std::unique_ptr<Timer> timer(new Timer(obj, getURI(stage.getVM(), "tick"),
+                ms, args, runOnce));
+    return stage.addIntervalTimer(std::move(timer));
+}
+
+/// Advance the clock and the movie, returning the timers that ran.
+std::string
+advance(movie_root& stage, ManualClock& clock, unsigned long ms)
+{
+    ticks.clear();
+    clock.advance(ms);
+    stage.advance();
+    return ticks;
+}
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    VM& vm = stage.getVM();
+    as_object* obj = new as_object(*vm.getGlobal());
+    obj->init_member("tick", vm.getGlobal()->createFunction(tick));
+
+    check_equals(stage.timeToNextTimer(), std::numeric_limits<int>::max());
+
+    addTimer(stage, obj, 30, "a");
+    addTimer(stage, obj, 10, "b");
+    const std::uint32_t c = addTimer(stage, obj, 20, "c", true);
+    const std::uint32_t d = addTimer(stage, obj, 10, "d");
+    check(stage.clearIntervalTimer(d));
+
+    // The cleared timer is removed the next time timers are run.
+    check(stage.timeToNextTimer() <= 0);
+    check_equals(advance(stage, clock, 5), "");
+    check_equals(stage.timeToNextTimer(), 5);
+    check(!stage.clearIntervalTimer(d));
+
+    check_equals(advance(stage, clock, 5), "b");
+    check_equals(stage.timeToNextTimer(), 10);
+
+    // Timers that expire together run in the order they were added.
+    check_equals(advance(stage, clock, 10), "bc");
+    check(!stage.clearIntervalTimer(c));
+    check_equals(advance(stage, clock, 10), "ab");
+
+    // A timer that is late runs once each advance, and is due again an
+    // interval after it was last due.
+    check_equals(advance(stage, clock, 25), "b");
+    check_equals(stage.timeToNextTimer(), -5);
+    check_equals(advance(stage, clock, 0), "b");
+    check_equals(stage.timeToNextTimer(), 5);
+    check_equals(advance(stage, clock, 5), "ab");
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+// Time parsing a catalog of items as XML, and reading one item of it, as
+// a script does. This isn't run as part of the testsuite, run it by hand
+// with an optional size of the document in megabytes.
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include "movie_root.h"
+#include "as_object.h"
+#include "as_function.h"
+#include "as_value.h"
+#include "as_environment.h"
+#include "fn_call.h"
+#include "Global_as.h"
+#include "log.h"
+#include "VM.h"
+#include "DummyMovieDefinition.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+
+using namespace gnash;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double
+millis(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+            Clock::now() - start).count();
+}
+
+/// Sections of a hundred items each, to about the size asked for.
+std::string
+catalog(size_t bytes)
+{
+    std::string xml = "<?xml version=\"1.0\"?>\n<catalog>\n";
+    for (size_t i = 0; xml.size() < bytes; ++i) {
+        if (i % 100 == 0) {
+            if (i) xml += "</section>\n";
+            xml += "<section n=\"" + std::to_string(i / 100) + "\">\n";
+        }
+        const std::string n = std::to_string(i);
+        xml += "  <item id=\"i" + n + "\" sku=\"SKU-" + n + "\" price=\"" +
+            std::to_string(i % 1000) + ".99\">\n"
+            "    <name>Item " + n + " &amp; accessories</name>\n"
+            "    <description><![CDATA[Everything <b>item " + n +
+            "</b> needs.]]></description>\n"
+            "    <stock warehouse=\"north\">" + std::to_string(i % 37) +
+            "</stock>\n"
+            "  </item>\n";
+    }
+    return xml + "</section>\n</catalog>\n";
+}
+
+as_object*
+member(as_object* o, const std::string& name)
+{
+    VM& vm = getVM(*o);
+    return toObject(getMember(*o, getURI(vm, name)), vm);
+}
+
+}
+
+int
+main(int argc, char** argv)
+{
+    const size_t megabytes =
+        argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10;
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    VM& vm = stage.getVM();
+    Global_as& gl = *vm.getGlobal();
+
+    const std::string text = catalog(megabytes << 20);
+    as_function* ctor = getMember(gl, getURI(vm, "XML")).to_function();
+
+    Clock::time_point start = Clock::now();
+    fn_call::Args args;
+    as_object* xml = constructInstance(*ctor, as_environment(vm), args);
+    xml->set_member(getURI(vm, "ignoreWhite"), true);
+    callMethod(xml, getURI(vm, "parseXML"), text);
+    const double parse = millis(start);
+
+    // An item by its id, and the first item of the first section.
+    start = Clock::now();
+    as_object* item = member(member(xml, "idMap"), "i12345");
+    as_object* first = member(member(member(xml, "firstChild"),
+                "firstChild"), "firstChild");
+    const double read = millis(start);
+
+    start = Clock::now();
+    const std::string out =
+        callMethod(xml, getURI(vm, "toString")).to_string();
+    const double write = millis(start);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << text.size() / 1048576.0 << " MB, status "
+              << getMember(*xml, getURI(vm, "status")).to_string() << "\n"
+              << "parseXML: " << parse << " ms\n"
+              << "read two items: " << read << " ms ("
+              << (item ? "found" : "missing") << ", "
+              << getMember(*member(first, "attributes"),
+                      getURI(vm, "sku")).to_string() << ")\n"
+              << "toString: " << write << " ms (" << out.size()
+              << " bytes)\n";
+
+    return 0;
+}
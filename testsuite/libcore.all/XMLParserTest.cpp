@@ -0,0 +1,337 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "movie_root.h"
+#include "as_object.h"
+#include "as_function.h"
+#include "as_value.h"
+#include "as_environment.h"
+#include "fn_call.h"
+#include "Global_as.h"
+#include "VM.h"
+#include "XML_as.h"
+#include "XMLParser.h"
+#include "tu_file.h"
+#include "IOChannel.h"
+#include "log.h"
+#include "DummyMovieDefinition.h"
+#include "movie_definition.h"
+#include "ManualClock.h"
+#include "RunResources.h"
+#include "StreamProvider.h"
+
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+as_object*
+makeXML(Global_as& gl, const string& text, bool ignoreWhite = false)
+{
+    VM& vm = getVM(gl);
+    as_function* ctor = getMember(gl, getURI(vm, "XML")).to_function();
+    fn_call::Args args;
+    as_object* xml = constructInstance(*ctor, as_environment(vm), args);
+    xml->set_member(getURI(vm, "ignoreWhite"), ignoreWhite);
+    callMethod(xml, getURI(vm, "parseXML"), text);
+    return xml;
+}
+
+as_value
+get(as_object* o, const string& name)
+{
+    return getMember(*o, getURI(getVM(*o), name));
+}
+
+as_object*
+node(as_object* o, const string& name)
+{
+    return toObject(get(o, name), getVM(*o));
+}
+
+string
+str(as_object* o)
+{
+    return callMethod(o, getURI(getVM(*o), "toString")).to_string();
+}
+
+int
+status(as_object* xml)
+{
+    return toInt(get(xml, "status"), getVM(*xml));
+}
+
+/// The status and text of a document parsed as it loads in chunks.
+string
+parsedInChunks(Global_as& gl, const string& text, size_t chunk)
+{
+    VM& vm = getVM(gl);
+    as_object* xml = makeXML(gl, "");
+    XML_as* x;
+    if (!isNativeType(xml, x)) return "not XML";
+
+    std::shared_ptr<XMLParser> parser = x->parseLoading();
+    for (size_t i = 0; i < text.size(); i += chunk) {
+        parser->parse(text.data() + i, min(chunk, text.size() - i));
+    }
+    callMethod(xml, getURI(vm, "parseXML"), text);
+    if (!parser->finished()) return "parsed again";
+
+    return to_string(status(xml)) + ' ' + str(xml);
+}
+
+/// The status and text of a document parsed at once.
+string
+parsed(Global_as& gl, const string& text)
+{
+    as_object* xml = makeXML(gl, text);
+    return to_string(status(xml)) + ' ' + str(xml);
+}
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    RunResources ri;
+    const URL url("");
+    ri.setStreamProvider(
+            std::shared_ptr<StreamProvider>(new StreamProvider(url, url)));
+
+    boost::intrusive_ptr<movie_definition> md(new DummyMovieDefinition(ri, 8));
+
+    ManualClock clock;
+    movie_root stage(clock, ri);
+
+    MovieClip::MovieVariables v;
+    stage.init(md.get(), v);
+
+    VM& vm = stage.getVM();
+    Global_as& gl = *vm.getGlobal();
+
+    // Elements, attributes, text, comments and CDATA.
+    as_object* xml = makeXML(gl, "<a x=\"1\" y='2'><b>one &amp; two</b>"
+            "<c/><!-- gone --><![CDATA[<raw>]]></a>");
+    check_equals(status(xml), 0);
+    check_equals(str(xml),
+            "<a x=\"1\" y=\"2\"><b>one &amp; two</b><c />&lt;raw&gt;</a>");
+
+    as_object* a = node(xml, "firstChild");
+    check_equals(get(a, "nodeName").to_string(), "a");
+    check_equals(toInt(get(node(a, "childNodes"), "length"), vm), 3);
+    check_equals(get(node(a, "attributes"), "y").to_string(), "2");
+
+    as_object* b = node(a, "firstChild");
+    as_object* c = node(b, "nextSibling");
+    check_equals(get(c, "nodeName").to_string(), "c");
+    check_equals(get(node(c, "previousSibling"), "nodeName").to_string(), "b");
+    check_equals(get(node(c, "parentNode"), "nodeName").to_string(), "a");
+    check_equals(get(node(b, "firstChild"), "nodeValue").to_string(),
+            "one & two");
+    check_equals(toInt(get(node(b, "firstChild"), "nodeType"), vm), 3);
+    check_equals(get(node(a, "lastChild"), "nodeValue").to_string(), "<raw>");
+
+    // Attributes are case-insensitively unique, the first kept, and are
+    // written in case-insensitive order.
+    xml = makeXML(gl, "<a B=\"1\" b=\"2\" a=\"3\" c=\"4\"/>");
+    check_equals(str(xml), "<a a=\"3\" B=\"1\" c=\"4\" />");
+    // They print the same once the attributes object is made.
+    node(node(xml, "firstChild"), "attributes");
+    check_equals(str(xml), "<a a=\"3\" B=\"1\" c=\"4\" />");
+
+    // Entities are replaced one after the other.
+    xml = makeXML(gl, "<a v=\"&amp;lt;\">&amp;gt;&nbsp;</a>");
+    a = node(xml, "firstChild");
+    check_equals(get(node(a, "attributes"), "v").to_string(), "<");
+    check_equals(get(node(a, "firstChild"), "nodeValue").to_string(),
+            ">\xc2\xa0");
+
+    // Declarations keep their case.
+    xml = makeXML(gl, "<?XML version=\"1.0\"?><!DocType a [<!ENTITY x>]>"
+            "<a/>");
+    check_equals(get(xml, "xmlDecl").to_string(), "<?XML version=\"1.0\"?>");
+    check_equals(get(xml, "docTypeDecl").to_string(),
+            "<!DocType a [<!ENTITY x>]>");
+    check_equals(str(xml),
+            "<?XML version=\"1.0\"?><!DocType a [<!ENTITY x>]><a />");
+
+    // White space.
+    const string spaced = "<a>\n  <b> x </b>\n</a>";
+    xml = makeXML(gl, spaced);
+    check_equals(str(xml), spaced);
+    xml = makeXML(gl, spaced, true);
+    check_equals(str(xml), "<a><b> x </b></a>");
+
+    // Closing tags are matched case-insensitively.
+    xml = makeXML(gl, "<a><B></b></A>");
+    check_equals(status(xml), 0);
+    check_equals(str(xml), "<a><B /></a>");
+
+    // Namespaces are taken from the first xmlns attribute.
+    xml = makeXML(gl, "<a xmlns=\"urn:one\" xmlns:p=\"urn:two\"><p:b/></a>");
+    a = node(xml, "firstChild");
+    check_equals(get(a, "namespaceURI").to_string(), "urn:one");
+    check_equals(get(node(a, "firstChild"), "prefix").to_string(), "p");
+    check_equals(get(node(a, "firstChild"), "namespaceURI").to_string(),
+            "urn:two");
+
+    // Errors stop parsing, keeping what was parsed.
+    check_equals(status(makeXML(gl, "<a>")), -9);
+    check_equals(status(makeXML(gl, "<a></b>")), -10);
+    check_equals(status(makeXML(gl, "<a><b></a>")), -9);
+    check_equals(status(makeXML(gl, "</a>")), -10);
+    check_equals(status(makeXML(gl, "<a")), -6);
+    check_equals(status(makeXML(gl, "<>")), -6);
+    check_equals(status(makeXML(gl, "<a b=\"1>")), -8);
+    check_equals(status(makeXML(gl, "<a><!-- x")), -5);
+    check_equals(status(makeXML(gl, "<![CDATA[x")), -2);
+    check_equals(status(makeXML(gl, "<?xml x")), -3);
+    check_equals(status(makeXML(gl, "<!DOCTYPE <x>")), -4);
+    xml = makeXML(gl, "<a><b/>text<c x=></c></a>");
+    check_equals(status(xml), -6);
+    check_equals(str(xml), "<a><b />text</a>");
+
+    // Parsing again replaces the tree.
+    callMethod(xml, getURI(vm, "parseXML"), "<z/>");
+    check_equals(status(xml), 0);
+    check_equals(str(xml), "<z />");
+
+    // Elements with an id are in the idMap, in SWF8.
+    xml = makeXML(gl, "<a><b id=\"one\"/><c id=\"two\"><d id=\"three\"/>"
+            "<e id=\"one\"/></c></a>");
+    as_object* idMap = node(xml, "idMap");
+    check_equals(get(node(idMap, "one"), "nodeName").to_string(), "e");
+    check_equals(get(node(idMap, "two"), "nodeName").to_string(), "c");
+    check_equals(get(node(idMap, "three"), "nodeName").to_string(), "d");
+    check_equals(get(node(node(idMap, "three"), "parentNode"),
+                "nodeName").to_string(), "c");
+
+    // The nodes in the idMap are the nodes of the tree.
+    as_object* d = node(node(node(xml, "firstChild"), "lastChild"),
+            "firstChild");
+    check_equals(d, node(idMap, "three"));
+
+    // Deep clones copy names, values and children, but not attributes.
+    xml = makeXML(gl, "<a x=\"1\"><b y=\"2\">t</b></a>");
+    as_object* clone = toObject(callMethod(node(xml, "firstChild"),
+                getURI(vm, "cloneNode"), true), vm);
+    check_equals(str(clone), "<a><b>t</b></a>");
+    check_equals(str(xml), "<a x=\"1\"><b y=\"2\">t</b></a>");
+
+    // Parsed nodes can be moved and changed.
+    xml = makeXML(gl, "<a><b/><c><d/></c></a>");
+    a = node(xml, "firstChild");
+    callMethod(node(a, "firstChild"), getURI(vm, "appendChild"),
+            node(node(a, "lastChild"), "firstChild"));
+    callMethod(node(a, "lastChild"), getURI(vm, "removeNode"));
+    node(a, "attributes")->set_member(getURI(vm, "x"), "y");
+    check_equals(str(xml), "<a x=\"y\"><b><d /></b></a>");
+
+    // A big document.
+    string big = "<list>";
+    for (int i = 0; i < 10000; ++i) {
+        big += "<item id=\"i" + to_string(i) + "\" n=\"" + to_string(i) +
+            "\">name " + to_string(i) + "</item>";
+    }
+    big += "</list>";
+    xml = makeXML(gl, big);
+    check_equals(status(xml), 0);
+    as_object* list = node(xml, "firstChild");
+    check_equals(toInt(get(node(list, "childNodes"), "length"), vm), 10000);
+    check_equals(get(node(node(list, "lastChild"), "attributes"),
+                "n").to_string(), "9999");
+    check_equals(get(node(node(node(xml, "idMap"), "i5000"), "firstChild"),
+                "nodeValue").to_string(), "name 5000");
+    check(str(xml) == big);
+
+    // Documents parsed as they load are the same as those parsed at once,
+    // wherever the chunks end.
+    const string documents[] = {
+        "<?xml version=\"1.0\"?><!DOCTYPE a><a x=\"1\" X='2' y=\"&lt;\">"
+            "one &amp; two<b/><!-- c --><![CDATA[<d>]]><e id=\"f\"></E>"
+            "</a>\n",
+        "text only",
+        "<a><b></a>",
+        "</a>",
+        "<a b=\"1>",
+        "<a><!-- x",
+        "<![CDATA[x",
+        "<a",
+        "<a><b c=></b></a>"
+    };
+    for (const string& d : documents) {
+        const string whole = parsed(gl, d);
+        check_equals(parsedInChunks(gl, d, 1), whole);
+        check_equals(parsedInChunks(gl, d, 5), whole);
+    }
+    check_equals(parsedInChunks(gl, big, 4096), parsed(gl, big));
+
+    // Something else passed to parseXML is parsed.
+    xml = makeXML(gl, "");
+    XML_as* x;
+    isNativeType(xml, x);
+    const string loaded = "<a><b/></a>";
+    std::shared_ptr<XMLParser> parser = x->parseLoading();
+    parser->parse(loaded.data(), loaded.size());
+    callMethod(xml, getURI(vm, "parseXML"), "<c/>");
+    check(!parser->finished());
+    check_equals(str(xml), "<c />");
+
+    // As is the document, if ignoreWhite has changed.
+    parser = x->parseLoading();
+    parser->parse(loaded.data(), loaded.size());
+    xml->set_member(getURI(vm, "ignoreWhite"), true);
+    callMethod(xml, getURI(vm, "parseXML"), loaded);
+    check(!parser->finished());
+    check_equals(str(xml), "<a><b /></a>");
+
+    // Loading a document, with a BOM, in more than one chunk.
+    FILE* file = tmpfile();
+    const string bom = "\xef\xbb\xbf";
+    fwrite(bom.data(), 1, bom.size(), file);
+    fwrite(big.data(), 1, big.size(), file);
+    rewind(file);
+
+    xml = makeXML(gl, "");
+    stage.addLoadableObject(xml, makeFileChannel(file, true));
+    for (int i = 0; i < 100 && get(xml, "loaded").is_undefined(); ++i) {
+        stage.advance();
+    }
+    check_equals(get(xml, "loaded").to_string(), "true");
+    check_equals(status(xml), 0);
+    check(str(xml) == big);
+    check_equals(get(node(node(xml, "idMap"), "i9999"), "nodeName").to_string(),
+            "item");
+
+    return 0;
+}
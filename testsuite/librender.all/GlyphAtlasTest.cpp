@@ -0,0 +1,114 @@
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifdef HAVE_CONFIG_H
+#include "gnashconfig.h"
+#endif
+
+#include "agg/GlyphAtlas.h"
+#include "swf/ShapeRecord.h"
+#include "ref_counted.h"
+#include "log.h"
+
+#include <iostream>
+#include <boost/intrusive_ptr.hpp>
+
+#include "check.h"
+
+using namespace std;
+using namespace gnash;
+
+namespace {
+
+/// Stands in for the font glyphs belong to.
+class TestFont : public ref_counted
+{
+};
+
+GlyphAtlas::Key
+key(const SWF::ShapeRecord& shape, int scale = 20, int x = 0)
+{
+    GlyphAtlas::Key k;
+    k.shape = &shape;
+    k.xscale = scale;
+    k.yscale = scale;
+    k.x = x;
+    k.y = 0;
+    return k;
+}
+
+}
+
+TRYMAIN(_runtest);
+int
+trymain(int /*argc*/, char** /*argv*/)
+{
+    gnash::LogFile& dbglogfile = gnash::LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity();
+
+    boost::intrusive_ptr<TestFont> font(new TestFont);
+    SWF::ShapeRecord a;
+    SWF::ShapeRecord b;
+
+    GlyphAtlas atlas;
+    check(!atlas.find(key(a)));
+
+    GlyphAtlas::Glyph& g = atlas.add(key(a), *font, -1, -2, 10, 12);
+    check_equals(g.x, 0);
+    check_equals(g.y, 0);
+    check_equals(g.left, -1);
+    check_equals(g.top, -2);
+
+    // The same glyph at the same scale and place hits.
+    check(atlas.find(key(a)) == &g);
+
+    // Another glyph misses, even one with the same outline.
+    check(!atlas.find(key(b)));
+
+    // So does the same glyph at another scale or subpixel position.
+    check(!atlas.find(key(a, 40)));
+    check(!atlas.find(key(a, 20, 1)));
+
+    // The atlas keeps the font, so the outline can't go away while the
+    // glyph is found by its address.
+    check_equals(font->get_ref_count(), 2);
+
+    // Glyphs go side by side in a row.
+    GlyphAtlas::Glyph& g2 = atlas.add(key(b), *font, 0, 0, 10, 20);
+    check_equals(g2.x, 10);
+    check_equals(g2.y, 0);
+    check(atlas.find(key(a)) == &g);
+    check_equals(atlas.glyphs(), 2u);
+
+    // Fifteen of the largest glyphs fit beside those two, and fifteen
+    // rows of sixteen below them. The one after that empties the atlas.
+    int added = 0;
+    for (int i = 0; atlas.glyphs() >= 2; ++i, ++added) {
+        atlas.add(key(a, 100 + i), *font, 0, 0, GlyphAtlas::maxGlyphSize,
+                GlyphAtlas::maxGlyphSize);
+    }
+    check_equals(added, 15 + 15 * 16 + 1);
+
+    // When it is full, the atlas empties, and lets go of the fonts.
+    check_equals(atlas.glyphs(), 1u);
+    check(!atlas.find(key(a)));
+    check(!atlas.find(key(b)));
+    check_equals(font->get_ref_count(), 2);
+
+    return 0;
+}
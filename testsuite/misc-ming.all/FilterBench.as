@@ -0,0 +1,86 @@
+//
+// Many filtered clips, for timing the filters.
+// Build with:
+//	makeswf -v 8 -o FilterBench.swf FilterBench.as
+// Run with:
+//	gnash FilterBench.swf
+// Or time it with FilterBenchRunner.
+//
+// Half the clips move every frame, which doesn't change their bitmaps.
+// The other half spin, so their filters are applied again every frame.
+//
+
+// Make the filters visible, as they are for SWF8.
+ASSetPropFlags(_global, "flash", 0, 5248);
+
+drawBlob = function(mc, color) {
+    with (mc) {
+        beginFill(color, 100);
+        moveTo(-20, -15);
+        curveTo(0, -30, 20, -15);
+        lineTo(20, 15);
+        curveTo(0, 30, -20, 15);
+        lineTo(-20, -15);
+        endFill();
+    }
+};
+
+makeFilters = function(n) {
+    switch (n % 6) {
+        case 0:
+            return [ new flash.filters.BlurFilter(8, 8, 3) ];
+        case 1:
+            return [ new flash.filters.DropShadowFilter(6, 45, 0, 0.8, 8, 8,
+                        1, 2) ];
+        case 2:
+            return [ new flash.filters.GlowFilter(0xffcc00, 1, 10, 10, 2, 2) ];
+        case 3:
+            var bevel = new flash.filters.BevelFilter();
+            bevel.distance = 4;
+            bevel.angle = 45;
+            bevel.highlightColor = 0xffffff;
+            bevel.highlightAlpha = 1;
+            bevel.shadowColor = 0;
+            bevel.shadowAlpha = 1;
+            bevel.blurX = 4;
+            bevel.blurY = 4;
+            bevel.strength = 1;
+            bevel.quality = 1;
+            bevel.type = "inner";
+            return [ bevel ];
+        case 4:
+            var grey = new flash.filters.ColorMatrixFilter();
+            grey.matrix = [ 0.3, 0.59, 0.11, 0, 0,
+                            0.3, 0.59, 0.11, 0, 0,
+                            0.3, 0.59, 0.11, 0, 0,
+                            0, 0, 0, 1, 0 ];
+            return [ grey, new flash.filters.BlurFilter(4, 4, 1) ];
+        default:
+            var sharpen = new flash.filters.ConvolutionFilter();
+            sharpen.matrixX = 3;
+            sharpen.matrixY = 3;
+            sharpen.matrix = [ 0, -1, 0, -1, 5, -1, 0, -1, 0 ];
+            sharpen.divisor = 1;
+            return [ sharpen, new flash.filters.GlowFilter(0x00ff00, 0.5,
+                        6, 6, 1, 3) ];
+    }
+};
+
+clips = 64;
+for (i = 0; i < clips; ++i) {
+    mc = createEmptyMovieClip("c" + i, i);
+    drawBlob(mc, 0x224488 + i * 0x030201);
+    mc._x = 40 + (i % 8) * 70;
+    mc._y = 40 + Math.floor(i / 8) * 45;
+    mc.filters = makeFilters(i);
+}
+
+frame = 0;
+onEnterFrame = function() {
+    ++frame;
+    for (var i = 0; i < clips; ++i) {
+        var mc = this["c" + i];
+        if (i % 2) mc._x += (frame % 20 < 10) ? 2 : -2;
+        else mc._rotation += 5;
+    }
+};
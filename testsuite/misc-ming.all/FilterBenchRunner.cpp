@@ -0,0 +1,76 @@
+// FilterBenchRunner.cpp: time the display filters.
+//
+//   Copyright (C) 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+// Play a movie full of filtered clips and report the time per frame,
+// and how often the filtered bitmaps were reused. This isn't run as part
+// of the testsuite, run it by hand with an optional frame count.
+
+#define INPUT_FILENAME "FilterBench.swf"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "MovieTester.h"
+#include "MovieClip.h"
+#include "movie_root.h"
+#include "VM.h"
+#include "BitmapCache.h"
+#include "log.h"
+
+using namespace gnash;
+
+int
+main(int argc, char** argv)
+{
+    const size_t frames = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+
+    const std::string filename =
+        std::string(TGTDIR) + "/" + std::string(INPUT_FILENAME);
+    MovieTester tester(filename);
+
+    LogFile& dbglogfile = LogFile::getDefaultInstance();
+    dbglogfile.setVerbosity(0);
+
+    if (!tester.canTestRendering()) {
+        std::cerr << "No renderer to time the filters with" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // The first frame places the clips.
+    tester.advance();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < frames; ++i) tester.advance();
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    const BitmapCachePool::Stats& stats =
+        tester.vm().getRoot().bitmapCachePool()->stats();
+
+    std::cout << frames << " frames, " << elapsed.count() / frames
+              << " ms per frame" << std::endl
+              << "bitmaps: " << stats.surfaces << " (" << stats.bytes
+              << " bytes), " << stats.hits << " reused, " << stats.redraws
+              << " filtered again, " << stats.refused << " refused"
+              << std::endl;
+
+    return EXIT_SUCCESS;
+}
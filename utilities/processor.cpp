@@ -23,6 +23,9 @@
 
 #include <ios>
 #include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
@@ -124,6 +127,13 @@ static bool s_stop_on_errors = true;
 // How many time do we allow to hit the end ?
 static size_t allowed_end_hits = 1;
 
+// Where to write the collapsed stacks of the ActionScript run, if it
+// is profiled.
+static std::string profile_file;
+
+// Whether to print how long each phase of starting a movie took.
+static bool print_startup = false;
+
 double lastAdvanceTimer;
 
 void
@@ -270,7 +280,7 @@ main(int argc, char *argv[])
         dbglogfile.setVerbosity();
     }
 
-    while ((c = getopt (argc, argv, ":hvapr:gf:d:n")) != -1) {
+    while ((c = getopt (argc, argv, ":hvapr:gf:d:nP:s")) != -1) {
 	switch (c) {
 	  case 'h':
 	      usage (argv[0]);
@@ -308,6 +318,12 @@ main(int argc, char *argv[])
 	  case 'f':
               limit_advances = strtol(optarg, NULL, 0);
 	      break;
+	  case 'P':
+              profile_file = optarg;
+	      break;
+	  case 's':
+              print_startup = true;
+	      break;
 	  case ':':
               fprintf(stderr, "Missing argument for switch ``%c''\n", optopt); 
 	      return EXIT_FAILURE;
@@ -354,6 +370,16 @@ main(int argc, char *argv[])
     r->init_buffer(buf, 1, 1, 1, 1);
 #endif
 
+    // The stacks of each movie are added to the file.
+    if (!profile_file.empty()) {
+        std::ofstream out(profile_file.c_str(), std::ios::trunc);
+        if (!out) {
+            std::cerr << "can't write profile to " << profile_file
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
     // Play through all the movies.
     for (const std::string& file : infiles) {
 
@@ -444,6 +470,9 @@ play_movie(const std::string& filename, const RunResources& runResources)
 
     quitrequested = false;
 
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+
     URL url(filename);
     
     try
@@ -482,6 +511,8 @@ play_movie(const std::string& filename, const RunResources& runResources)
 	    return false;
     }
     
+    const Clock::time_point header = Clock::now();
+
     float fps = md->get_frame_rate();
     long fpsDelay = long(1000000/fps);
     long clockAdvance = fpsDelay/1000;
@@ -501,7 +532,11 @@ play_movie(const std::string& filename, const RunResources& runResources)
     // and their parsing thread alive until static destruction. The parser
     // can then continue to access destroyed resources.
     {
+        const Clock::time_point beforeVM = Clock::now();
         gnash::movie_root m(cl, runResources);
+        const Clock::time_point vm = Clock::now();
+
+        if (!profile_file.empty()) m.getVM().startProfiling();
         
         // Register processor to receive ActionScript events (Mouse, Stage
         // System etc).
@@ -509,10 +544,33 @@ play_movie(const std::string& filename, const RunResources& runResources)
         m.registerFSCommandCallback(&execFsCommand);
 
         md->completeLoad();
+        const Clock::time_point loaded = Clock::now();
 
         MovieClip::MovieVariables v;
         m.init(md.get(), v);
 
+        if (print_startup) {
+            const Clock::time_point firstFrame = Clock::now();
+            const auto ms = [](Clock::duration d) {
+                return std::chrono::duration<double, std::milli>(d).count();
+            };
+            std::cout << "Startup of " << filename << ":\n"
+                      << std::fixed << std::setprecision(3)
+                      << "  header       " << ms(header - start) << " ms\n"
+                      << "  VM           " << ms(vm - beforeVM) << " ms\n";
+            for (const auto& phase : m.getVM().startupTimes()) {
+                std::cout << "    " << std::left << std::setw(11)
+                          << phase.first << std::right << ms(phase.second)
+                          << " ms\n";
+            }
+            std::cout << "  load         " << ms(loaded - vm) << " ms\n"
+                      << "  first frame  " << ms(firstFrame - loaded)
+                      << " ms\n"
+                      << "  total        "
+                      << ms((header - start) + (firstFrame - beforeVM))
+                      << " ms\n";
+        }
+
         log_debug("iteration, timer: %lu, localDelay: %ld",
                 cl.elapsed(), localDelay);
         gnashSleep(localDelay);
@@ -613,6 +671,13 @@ play_movie(const std::string& filename, const RunResources& runResources)
             gnashSleep(localDelay);
         }
 
+        if (const Profiler* profiler = m.getVM().profiler()) {
+            std::ofstream out(profile_file.c_str(), std::ios::app);
+            profiler->writeStacks(out);
+            std::cout << "ActionScript profile of " << filename << ":\n";
+            profiler->writeReport(std::cout);
+        }
+
     }
 
     log_debug("-- Playback completed");
@@ -673,7 +738,12 @@ usage (const char *name)
 	"  -f <frames>  \n"
 	"              Allow the given number of frame advancements.\n"
 	"              Keep advancing untill any other stop condition\n"
-        "              is encountered if set to 0 (default).\n")
+        "              is encountered if set to 0 (default).\n"
+	"  -P <file>   Profile the ActionScript run, writing its call stacks\n"
+	"              to <file> for a flame graph and printing the time\n"
+	"              of each function and opcode.\n"
+	"  -s          Print how long each phase of starting each movie took,\n"
+	"              up to the end of its first frame.\n")
 	);
 }
 